@@ -9,6 +9,8 @@
 
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
+#include <string.h>
 #include <unistd.h>
 
 #include "niova/binary_hist.h"
@@ -25,8 +27,9 @@
 
 #include "raft_net.h"
 
-#define RAFT_ENTRY_NUM_ENTRIES 100
-#define RAFT_ENTRY_PAD_SIZE 6
+#define RAFT_ENTRY_NUM_ENTRIES 100 // sub-entries held by a v1 header
+#define RAFT_ENTRY_V2_NUM_ENTRIES_MAX 65536
+#define RAFT_ENTRY_PAD_SIZE 5
 #define RAFT_ENTRY_MAGIC  0x1a2b3c4dd4c3b2a1
 #define RAFT_HEADER_MAGIC 0xafaeadacabaaa9a8
 
@@ -36,7 +39,29 @@
 
 #define RAFT_ENTRY_SIZE_MIN        65536
 
-#define RAFT_NUM_READ_THREADS 10
+// Max number of data fragments passed to rib_entry_write()
+#define RAFT_ENTRY_WRITE_NIOV_MAX  15
+
+#define RAFT_NUM_READ_THREADS         10
+#define RAFT_NUM_READ_THREADS_DEFAULT 0
+// Startup scan CRC workers, '0' leaves entry data unverified at startup
+#define RAFT_STARTUP_SCAN_CRC_THREADS_MAX 16
+
+// Sync and chkpt threads shared by the groups of a multi-instance host
+#define RAFT_HOST_SYNC_THREADS_MAX  4
+#define RAFT_HOST_CHKPT_THREADS_MAX 2
+
+// Number of log reads which may hold off compaction at one time
+#define RAFT_READ_PIN_SLOTS 64
+
+// Committed entries which may be read ahead of the state machine apply
+#define RAFT_SM_APPLY_PREFETCH_MAX     64
+#define RAFT_SM_APPLY_PREFETCH_DEFAULT 8
+
+// Leader-side cache of recently written raft entries
+#define RAFT_ENTRY_CACHE_NENTRIES      64
+#define RAFT_ENTRY_CACHE_MAX_BYTES     (64ULL * 1024 * 1024)
+#define RAFT_ENTRY_CACHE_MAX_BYTES_MAX (1024ULL * 1024 * 1024)
 #define RAFT_NUM_WRITE_THREADS 1
 #define RAFT_SERVER_WORK_TYPE 2
 
@@ -50,10 +75,18 @@
 #define RAFT_ELECTION_UPPER_TIME_MS 300
 #define RAFT_ELECTION_RANGE_DIVISOR 2.0
 
-// Raft leader wakes up every RAFT_LEADER_WAKEUP_MS
+// Time unit of the leader's timer deadlines
 #define RAFT_LEADER_WAKEUP_MS 2ULL
 #define RAFT_SERVER_COALESCE_TIMEOUT_FACTOR 2 // * RAFT_LEADER_WAKEUP_MS
+
+// Default bound on how long a coalesced write may wait while others are busy
+#define RAFT_SERVER_COALESCE_LATENCY_BUDGET_US_DEFAULT \
+    (RAFT_SERVER_COALESCE_TIMEOUT_FACTOR * RAFT_LEADER_WAKEUP_MS * 1000ULL)
+#define RAFT_SERVER_COALESCE_LATENCY_BUDGET_US_MAX 100000ULL
+// Counts above RAFT_ENTRY_NUM_ENTRIES are written with v2 entry headers
+#define RAFT_SERVER_COALESCE_MAX_ENTRIES_DEFAULT RAFT_ENTRY_NUM_ENTRIES
 #define RAFT_SERVER_HEARTBEAT_ISSUE_FACTOR 10 // * RAFT_LEADER_WAKEUP_MS
+#define RAFT_SERVER_QUORUM_CHECK_FACTOR 10 // * RAFT_LEADER_WAKEUP_MS
 
 // Leader steps down after this many cycles following quorum loss
 #define RAFT_ELECTION_CHECK_QUORUM_FACTOR 10
@@ -79,6 +112,7 @@ typedef int                              raft_server_net_cb_follower_ctx_int_t;
 typedef void                             raft_server_net_cb_follower_ctx_t;
 typedef void                             raft_server_net_cb_leader_t;
 typedef void                             raft_server_net_cb_leader_ctx_t;
+typedef bool                             raft_server_net_cb_leader_ctx_bool_t;
 typedef int64_t                          raft_server_net_cb_leader_ctx_int64_t;
 typedef void                             raft_server_timerfd_cb_ctx_t;
 typedef int                              raft_server_timerfd_cb_ctx_int_t;
@@ -86,6 +120,7 @@ typedef void                             raft_server_leader_mode_t;
 typedef int                              raft_server_leader_mode_int_t;
 typedef int64_t                          raft_server_leader_mode_int64_t;
 typedef void                             raft_server_epoll_remote_sender_t;
+typedef int                              raft_server_epoll_remote_sender_int_t;
 typedef void                             raft_server_epoll_sm_apply_t;
 typedef void                             raft_server_epoll_sm_apply_bool_t;
 typedef int                              raft_server_epoll_sm_apply_int_t;
@@ -111,14 +146,83 @@ enum raft_rpc_msg_type
     RAFT_RPC_MSG_TYPE_APPEND_ENTRIES_REPLY   = 6,
     RAFT_RPC_MSG_TYPE_SYNC_IDX_UPDATE        = 7,
     RAFT_RPC_MSG_TYPE_ANY                    = 8,
+    RAFT_RPC_MSG_TYPE_CHKPT_XFER_REQUEST     = 9,
+    RAFT_RPC_MSG_TYPE_CHKPT_XFER_REPLY       = 10,
+    RAFT_RPC_MSG_TYPE_BATCH                  = 11,
 };
 
+/* Server <-> server wire formats.  Version 0 is the raw raft_rpc_msg.  The
+ * compact version keeps the leading type / version / uuid fields of version
+ * 0 but varint encodes the indexes and terms of the union and carries only
+ * the used entries of raerqm_size_arr.  A sender advertises the highest
+ * version it can decode in rrm_version_max and only sends the compact format
+ * to peers which have advertised it.  Messages sent over TCP use the
+ * version 0 layout.  An AE request whose entries are compressed is marked
+ * with the compress version and is only sent to peers which advertised it,
+ * see struct raft_ae_compress_hdr.  The packed version marks no msgs, it is
+ * advertised by peers which decode AE requests carrying several raft indexes
+ * (raerqm_num_idx > 1).  Peers at the batch version accept datagrams which
+ * carry the msgs of several raft groups, see struct raft_rpc_msg_batch_hdr.
+ * The sub-table version also marks no msgs, its peers accept log entries
+ * with v2 headers, see enum raft_entry_header_version.
+ */
+enum raft_rpc_msg_version
+{
+    RAFT_RPC_MSG_VERSION_0         = 0,
+    RAFT_RPC_MSG_VERSION_COMPACT   = 1,
+    RAFT_RPC_MSG_VERSION_COMPRESS  = 2,
+    RAFT_RPC_MSG_VERSION_PACKED    = 3,
+    RAFT_RPC_MSG_VERSION_BATCH     = 4,
+    RAFT_RPC_MSG_VERSION_SUB_TABLE = 5,
+    RAFT_RPC_MSG_VERSION_MAX       = RAFT_RPC_MSG_VERSION_SUB_TABLE,
+};
+
+/* Codecs for AE request payloads.  Peers at the compress version always
+ * decode LZ4, others may be announced in the TCP handshake.
+ */
+enum raft_ae_compress_type
+{
+    RAFT_AE_COMPRESS_NONE = 0,
+    RAFT_AE_COMPRESS_LZ4  = 1,
+    RAFT_AE_COMPRESS_MAX,
+};
+
+#define RAFT_AE_COMPRESS_MASK(type) (1U << (type))
+#define RAFT_AE_COMPRESS_MASK_SUPPORTED                 \
+    RAFT_AE_COMPRESS_MASK(RAFT_AE_COMPRESS_LZ4)
+
+/* Leads the payload of a compressed AE request.  The request keeps the
+ * version 0 layout but its raerqm_entries_sz is the size of the payload as
+ * sent, this header included, so that TCP receivers size the read as usual.
+ */
+struct raft_ae_compress_hdr
+{
+    uint8_t  rach_type; // raft_ae_compress_type
+    uint8_t  rach__pad[3];
+    uint32_t rach_entries_sz; // size of the entries once decompressed
+};
+
+#define RAFT_RPC_MSG_COMPACT_VARINT64_MAX 10
+#define RAFT_RPC_MSG_COMPACT_VARINT32_MAX 5
+
+// Leading fields shared with version 0:  type, version(s), sender, raft id
+#define RAFT_RPC_MSG_COMPACT_PREFIX_SZ                                \
+    (sizeof(uint32_t) + 2 * sizeof(uint16_t) + 2 * sizeof(uuid_t))
+
+// Worst case is an AE request carrying a full size array
+#define RAFT_RPC_MSG_COMPACT_HDR_MAX                                  \
+    (RAFT_RPC_MSG_COMPACT_PREFIX_SZ + sizeof(uuid_t) +                \
+     7 * RAFT_RPC_MSG_COMPACT_VARINT64_MAX + 2 * sizeof(uint32_t) +   \
+     4 * sizeof(uint8_t) +                                            \
+     (3 + RAFT_ENTRY_NUM_ENTRIES) * RAFT_RPC_MSG_COMPACT_VARINT32_MAX)
+
 enum raft_buf_set_type
 {
     RAFT_BUF_SET_SMALL  = 0,
     RAFT_BUF_SET_LARGE  = 1,
     RAFT_BUF_SET_APPLY  = 2,
-    RAFT_BUF_SET_MAX    = 3,
+    RAFT_BUF_SET_IO     = 3, // registered with the posix io_uring engine
+    RAFT_BUF_SET_MAX    = 4,
 };
 
 enum raft_buf_set_size
@@ -126,6 +230,7 @@ enum raft_buf_set_size
     RAFT_BS_SMALL_SZ = 4096,
     RAFT_BS_LARGE_SZ = 4194304,
     RAFT_BS_APPLY_SZ = 4194304,
+    RAFT_BS_IO_SZ    = 65536, // one posix log block
 };
 
 //Note: Dont use these NBUF macros directly as TCP_MGR_NTHREADS
@@ -134,8 +239,20 @@ enum raft_buf_set_nbuf
 {
     RAFT_BS_SMALL_NBUF = (RAFT_ENTRY_NUM_ENTRIES + TCP_MGR_NTHREADS),
     RAFT_BS_LARGE_NBUF = TCP_MGR_NTHREADS,
-    RAFT_BS_APPLY_NBUF = 2 //These two are used by sink and reply within
-                           //.. raft_server_state_machine_apply
+    RAFT_BS_APPLY_NBUF = 2, //These two are used by sink and reply within
+                            //.. raft_server_state_machine_apply
+    RAFT_BS_IO_NBUF = 32,   // max posix entry writes in flight
+};
+
+/* The buffer sets used by a raft instance.  The groups run by
+ * raft_server_multi_instance_run() share one pool which is sized for
+ * rbp_ngroups.
+ */
+struct raft_buf_pool
+{
+    char             *rbp_source;
+    size_t            rbp_ngroups;
+    struct buffer_set rbp_sets[RAFT_BUF_SET_MAX];
 };
 
 struct raft_vote_request_msg
@@ -153,6 +270,11 @@ struct raft_vote_reply_msg
     uuid_t  rvrpm_current_leader;
 };
 
+/* When raerqm_num_idx > 1, the payload holds the data of index
+ * (prev_log_index + 1), raerqm_first_idx_sz bytes long, followed by each
+ * subsequent index as a raft_entry_header and its data.  raerqm_entries_sz
+ * covers the entire payload.
+ */
 struct raft_append_entries_request_msg
 {
     int64_t  raerqm_leader_term; // current term of the leader
@@ -171,7 +293,8 @@ struct raft_append_entries_request_msg
     uint8_t  raerqm_heartbeat_msg;
     uint8_t  raerqm_leader_change_marker;
     uint8_t  raerqm_entry_out_of_range;
-    uint8_t  raerqm__pad[5];
+    uint8_t  raerqm_num_idx; // number of consecutive indexes carried (0 == 1)
+    uint32_t raerqm_first_idx_sz; // data size of the (prev_log_index + 1)
     char     WORD_ALIGN_MEMBER(raerqm_entries[]); // Must be last
 };
 
@@ -185,7 +308,8 @@ struct raft_append_entries_reply_msg
     uint8_t raerpm_err_non_matching_prev_term;
     uint8_t raerpm_newly_initialized_peer;
     uint8_t raerpm_update_sli;
-    uint8_t raerpm__pad[3];
+    uint8_t raerpm_num_idx; // number of indexes accepted from the request
+    uint8_t raerpm__pad[2];
 };
 
 struct raft_sync_idx_update_msg
@@ -196,11 +320,59 @@ struct raft_sync_idx_update_msg
 
 //#define RAFT_RPC_MSG_TYPE_Version0_SIZE 120
 
+// Peers which have not been upgraded require an exact size match
+#define RAFT_RPC_MSG_VERSION_0_SIZE 536
+
+// Carried by the RAFT_RPC_MSG_TYPE_ANY msg which opens a TCP connection
+struct raft_handshake_msg
+{
+    uint32_t rhm_ae_compress_mask; // codecs the connecting peer decodes
+};
+
+/* Checkpoint transfer, used by bulk recovery.  The recovering peer connects
+ * to the source peer's TCP port and requests the files of its checkpoint in
+ * chunks.  A request with an empty name returns the checkpoint's file list
+ * as an array of raft_chkpt_xfer_file.  Reply payloads follow the
+ * raft_rpc_msg and are covered by rcxrpm_crc.  Replies are sent in request
+ * order.
+ */
+#define RAFT_CHKPT_XFER_NAME_MAX 64
+#define RAFT_CHKPT_XFER_CHUNK_SZ (1024 * 1024)
+#define RAFT_CHKPT_XFER_WINDOW   8 // chunk requests in flight
+
+struct raft_chkpt_xfer_request_msg
+{
+    int64_t  rcxrqm_chkpt_idx;
+    int64_t  rcxrqm_offset;
+    uint64_t rcxrqm_tag; // returned in the reply
+    uint32_t rcxrqm_len;
+    uint8_t  rcxrqm_crc_only; // reply with the CRC of the chunk but no data
+    uint8_t  rcxrqm__pad[3];
+    char     rcxrqm_name[RAFT_CHKPT_XFER_NAME_MAX];
+};
+
+struct raft_chkpt_xfer_reply_msg
+{
+    int64_t  rcxrpm_chkpt_idx;
+    int64_t  rcxrpm_offset;
+    uint64_t rcxrpm_tag;
+    int32_t  rcxrpm_err;
+    uint32_t rcxrpm_len; // bytes read from the file (or list size)
+    crc32_t  rcxrpm_crc;
+    uint32_t rcxrpm_data_sz; // payload size, '0' for crc-only replies
+};
+
+struct raft_chkpt_xfer_file
+{
+    uint64_t rcxf_size;
+    char     rcxf_name[RAFT_CHKPT_XFER_NAME_MAX];
+};
+
 struct raft_rpc_msg
 {
     uint32_t rrm_type;
     uint16_t rrm_version;
-    uint16_t rrm__pad;
+    uint16_t rrm_version_max; // highest version the sender can decode
     uuid_t   rrm_sender_id; // should match the sender
     uuid_t   rrm_raft_id;
     uuid_t   rrm_db_id;     // Id assigned to the backend instance
@@ -211,6 +383,9 @@ struct raft_rpc_msg
         struct raft_append_entries_request_msg rrm_append_entries_request;
         struct raft_append_entries_reply_msg   rrm_append_entries_reply;
         struct raft_sync_idx_update_msg        rrm_sync_index_update;
+        struct raft_handshake_msg              rrm_handshake;
+        struct raft_chkpt_xfer_request_msg     rrm_chkpt_xfer_request;
+        struct raft_chkpt_xfer_reply_msg       rrm_chkpt_xfer_reply;
     };
 /*  char rrm_payload[]; // future use if more msg types (other than
  *      rrm_append_entries_request require payload
@@ -230,6 +405,25 @@ struct raft_recovery_handle
     char            rrh_rate_bytes_per_sec[BW_RATE_LEN + 1];
     struct timespec rrh_start;
     bool            rrh_from_recovery_marker;
+    size_t          rrh_nfiles;
+    size_t          rrh_chunks_xferred;
+    size_t          rrh_chunks_resumed; // verified in place, not resent
+    size_t          rrh_chunk_crc_errors;
+    size_t          rrh_xfer_attempts;
+};
+
+/* Entry header versions.  A v1 header holds the sub-entry sizes in
+ * reh_entry_sz[] which limits an entry to RAFT_ENTRY_NUM_ENTRIES sub-entries.
+ * A v2 entry leaves reh_entry_sz[] and reh_num_entries zeroed and instead
+ * starts its data with a raft_entry_sub_table, the sub-entries follow the
+ * table.  reh_data_size covers the table.  v2 is only used for entries which
+ * exceed the v1 table so that every entry has a single valid encoding.
+ * reh_version was a pad byte, which v1 always zeroed.
+ */
+enum raft_entry_header_version
+{
+    RAFT_ENTRY_HEADER_V1 = 0,
+    RAFT_ENTRY_HEADER_V2 = 2,
 };
 
 struct raft_entry_header
@@ -246,10 +440,70 @@ struct raft_entry_header
     uint32_t         reh_entry_sz[RAFT_ENTRY_NUM_ENTRIES];
     uint64_t         reh_apply_handler_version; // Version of handler to use
     uint8_t          reh_leader_change_marker; // noop
-    uint8_t          reh_num_entries; // number of raft entries
+    uint8_t          reh_num_entries; // number of raft entries (v1 only)
+    uint8_t          reh_version; // raft_entry_header_version
     uint8_t          reh_pad[RAFT_ENTRY_PAD_SIZE];
 };
 
+/* Leads the data of a v2 entry, the table may not be aligned in the buffer.
+ * rest_num_entries uint32_t sub-entry sizes directly follow the count.
+ */
+struct raft_entry_sub_table
+{
+    uint32_t rest_num_entries;
+};
+
+static inline size_t
+raft_entry_sub_table_size(const uint32_t num_entries)
+{
+    return sizeof(struct raft_entry_sub_table) +
+        (sizeof(uint32_t) * num_entries);
+}
+
+// Reads word 'pos' of a v2 sub-entry table which may not be aligned
+static inline uint32_t
+raft_server_entry_sub_table_word(const char *data, const uint32_t pos)
+{
+    uint32_t word;
+    memcpy(&word, data + (sizeof(uint32_t) * pos), sizeof(uint32_t));
+
+    return word;
+}
+
+/**
+ * raft_server_entry_sub_table_check - validates the sub-entry table at the
+ *    front of v2 entry data.  The table must describe more sub-entries than
+ *    a v1 header holds and the sub-entries must exactly fill the data which
+ *    follows the table.  Returns 0 and the number of sub-entries on success.
+ */
+static inline int
+raft_server_entry_sub_table_check(const char *data, const size_t data_size,
+                                  uint32_t *ret_nentries)
+{
+    if (!data || data_size < sizeof(struct raft_entry_sub_table))
+        return -EBADMSG;
+
+    const uint32_t nentries = raft_server_entry_sub_table_word(data, 0);
+
+    if (nentries <= RAFT_ENTRY_NUM_ENTRIES ||
+        nentries > RAFT_ENTRY_V2_NUM_ENTRIES_MAX ||
+        raft_entry_sub_table_size(nentries) > data_size)
+        return -EBADMSG;
+
+    size_t total = raft_entry_sub_table_size(nentries);
+
+    for (uint32_t i = 0; i < nentries; i++)
+        total += raft_server_entry_sub_table_word(data, i + 1);
+
+    if (total != data_size)
+        return -EBADMSG;
+
+    if (ret_nentries)
+        *ret_nentries = nentries;
+
+    return 0;
+}
+
 struct raft_entry
 {
     struct raft_entry_header re_header; // Must directly precede re_data
@@ -263,6 +517,38 @@ raft_server_entry_to_total_size(const struct raft_entry *re)
                     re->re_header.reh_data_size);
 }
 
+/**
+ * raft_server_entry_iov_calc_crc - calculates the same crc as
+ *    raft_server_entry_calc_crc() for an entry whose data is held in the
+ *    supplied iovec fragments.
+ */
+static inline crc32_t
+raft_server_entry_iov_calc_crc(const struct raft_entry_header *rh,
+                               const struct iovec *iov, const size_t niov)
+{
+    NIOVA_ASSERT(rh && (iov || !niov));
+
+    const size_t offset =
+        offsetof(struct raft_entry_header, reh_data_size);
+
+    crc32_t crc = niova_crc((const unsigned char *)rh + offset,
+                            sizeof(struct raft_entry) - offset, 0);
+
+    size_t total = 0;
+
+    for (size_t i = 0; i < niov; i++)
+    {
+        if (iov[i].iov_len)
+            crc = niova_crc((const unsigned char *)iov[i].iov_base,
+                            iov[i].iov_len, crc);
+        total += iov[i].iov_len;
+    }
+
+    NIOVA_ASSERT(total == rh->reh_data_size);
+
+    return crc;
+}
+
 struct raft_log_header
 {
     uint64_t rlh_version;
@@ -305,6 +591,7 @@ enum raft_epoll_handles
     RAFT_EPOLL_HANDLE_EVP_REMOTE_SEND,
     RAFT_EPOLL_HANDLE_EVP_ASYNC_COMMIT_IDX_ADV,
     RAFT_EPOLL_HANDLE_EVP_SM_APPLY,
+    RAFT_EPOLL_HANDLE_EVP_READ_REPLY,
     RAFT_EPOLL_NUM_HANDLES,
     RAFT_EPOLL_HANDLE_EVP_ANY, // purposely out of range
     RAFT_EPOLL_HANDLE_NONE,
@@ -336,7 +623,30 @@ struct raft_follower_info
     int64_t            rfi_prev_idx_term;
     int64_t            rfi_prev_idx_crc;
     struct timespec    rfi_last_ack;
+    struct timespec    rfi_last_ae_send; // last AE which carried entries
     unsigned long long rfi_ae_sends_wait_until;
+    int64_t            rfi_inflight_idx; // highest idx sent but not yet ackd
+    int64_t            rfi_inflight_term;
+    int64_t            rfi_inflight_crc;
+    unsigned int       rfi_inflight_cnt; // number of unackd AE requests
+};
+
+/* The leader's periodic work is scheduled by deadline.  The timerfd is
+ * armed only for the nearest one so an idle leader sleeps until its next
+ * heartbeat or quorum check.
+ */
+enum raft_leader_timer_type
+{
+    RAFT_LEADER_TIMER_HEARTBEAT,
+    RAFT_LEADER_TIMER_QUORUM,
+    RAFT_LEADER_TIMER_CO_WR, // armed only while coalesced writes are pending
+    RAFT_LEADER_TIMER_MAX,
+};
+
+struct raft_leader_timer
+{
+    struct timespec             rlt_deadline;
+    enum raft_leader_timer_type rlt_type;
 };
 
 struct raft_leader_state
@@ -348,19 +658,30 @@ struct raft_leader_state
     struct timespec           rls_leader_accumulated;
 //    int64_t                   rls_quorum_miss_cnt;
     struct raft_follower_info rls_rfi[CTL_SVC_MAX_RAFT_PEERS];
+    struct raft_leader_timer  rls_timers[RAFT_LEADER_TIMER_MAX]; // min-heap
+    unsigned int              rls_ntimers;
+    struct timespec           rls_timerfd_deadline; // zero when unarmed
 };
 
 int
 raft_server_get_leader_ts(struct raft_leader_ts *leader_ts);
 
+int
+raft_server_get_leader_ts_by_id(const uuid_t raft_id,
+                                struct raft_leader_ts *leader_ts);
+
 bool
 raft_server_is_leader(void);
 
+bool
+raft_server_is_leader_by_id(const uuid_t raft_id);
+
 int
 raft_server_enq_direct_raft_req_from_leader(char *req_buf, int64_t data_size);
 
 struct epoll_handle;
 struct raft_instance;
+struct raft_net_host_tcp_listener;
 
 enum raft_follower_reasons
 {
@@ -398,8 +719,13 @@ struct raft_instance_hist_stats
  *    required to implement a niova-raft backend.  Note that function types
  *    which take struct raft_entry or raft_entry_header are to use the
  *    raft-entry contents to address and size the respective requests.
- * @rib_entry_write:  synchronously writes the supplied raft-entry at the
- *    index set in the raft-entry header.
+ * @rib_entry_write:  synchronously writes the raft-entry described by the
+ *    supplied header at the index set in that header.  The entry's data is
+ *    passed as an iovec of fragments, totaling reh_data_size, which the
+ *    backend lays out directly behind the header.  There are at most
+ *    RAFT_ENTRY_WRITE_NIOV_MAX fragments and they are only
+ *    valid for the duration of the call and no contiguous copy of the entry
+ *    is made on the backend's behalf.
  * @rib_entry_header_read:  reads only the header section at the index
  *    specified in the provided raft_entry_header.
  * @rib_entry_read:  reads the entire raft entry at the supplied index.  In
@@ -427,12 +753,40 @@ struct raft_instance_hist_stats
  * @rib_sm_apply_opt:  optional callback used for niova-raft implementations
  *    which require conjoined, atomic, persistent updates of raft metadata and
  *    state machine data.
+ * @rib_entry_scan:  optional, passes the headers of the entries in the
+ *    range [start, end), and their data if requested, to the callback in
+ *    index order.  The scan stops at the first non-zero callback return.
+ *    The pointers given to the callback are only valid for that call.
+ * @rib_chkpt_xfer_read:  optional, serves a checkpoint transfer request from
+ *    a recovering peer.  Fills the reply and places its payload, which may
+ *    not exceed the given size, into the buffer.  This is normally called
+ *    from a bulk lane sender thread, concurrently with the main raft thread,
+ *    so it may only access immutable checkpoint contents.
 
  */
+/*
+ * Read-only view of a raft entry's data obtained from
+ * raft_instance_backend::rib_entry_read_view().  The backend may point
+ * rev_data into its own pinned memory, so the view is only valid until it
+ * has been released.
+ */
+struct raft_entry_view
+{
+    const char       *rev_data;
+    size_t            rev_size;
+    void             *rev_handle; // backend private
+    raft_entry_idx_t  rev_idx;
+    int               rev_pin_slot;
+};
+
+typedef int (*raft_entry_scan_cb_t)(void *, const struct raft_entry_header *,
+                                    const char *);
+
 struct raft_instance_backend
 {
     void    (*rib_entry_write)(struct raft_instance *,
-                               const struct raft_entry *,
+                               const struct raft_entry_header *,
+                               const struct iovec *, size_t,
                                const struct raft_net_sm_write_supplements *);
     int     (*rib_entry_header_read)(struct raft_instance *,
                                      struct raft_entry_header *);
@@ -449,6 +803,18 @@ struct raft_instance_backend
     int     (*rib_backend_recover)(struct raft_instance *);
     void    (*rib_sm_apply_opt)(struct raft_instance *,
                                 const struct raft_net_sm_write_supplements *);
+    int     (*rib_entry_read_view)(struct raft_instance *,
+                                   const struct raft_entry_header *,
+                                   struct raft_entry_view *);
+    void    (*rib_entry_view_release)(struct raft_instance *,
+                                      struct raft_entry_view *);
+    int     (*rib_entry_scan)(struct raft_instance *, const raft_entry_idx_t,
+                              const raft_entry_idx_t, const bool,
+                              raft_entry_scan_cb_t, void *);
+    int     (*rib_chkpt_xfer_read)(struct raft_instance *,
+                                   const struct raft_chkpt_xfer_request_msg *,
+                                   struct raft_chkpt_xfer_reply_msg *,
+                                   char *, size_t);
 };
 
 enum raft_instance_newest_entry_hdr_types
@@ -476,14 +842,26 @@ struct raft_instance_buffer
     bool     ribuf_free;
 };
 
+// Reasons for which the leader issues its pending coalesced writes
+enum raft_co_wr_flush_reason
+{
+    RAFT_CO_WR_FLUSH_IDLE = 0, // write arrived with nothing in flight
+    RAFT_CO_WR_FLUSH_DRAINED,  // in flight writes committed
+    RAFT_CO_WR_FLUSH_BUDGET,   // oldest pending write reached the budget
+    RAFT_CO_WR_FLUSH_FULL,     // entry count or size limit
+    RAFT_CO_WR_FLUSH_MAX,
+    RAFT_CO_WR_FLUSH_NONE = RAFT_CO_WR_FLUSH_MAX,
+};
+
 /*
  * coalesced write information stored on the leader.
  */
 struct raft_instance_co_wr
 {
     uint32_t                              rcwi_nentries;
-    uint32_t                              rcwi_entry_sizes[RAFT_ENTRY_NUM_ENTRIES];
+    uint32_t                             *rcwi_entry_sizes; // follows buffer
     size_t                                rcwi_total_size;
+    struct timespec                       rcwi_first_ts; // oldest pending
     struct raft_net_sm_write_supplements  rcwi_ws;
     char                                  rcwi_buffer[];
 };
@@ -495,22 +873,244 @@ enum raft_server_bulk_msg_type
     RAFT_SERVER_BULK_MSG_MAX = 1,
 };
 
-STAILQ_HEAD(raft_srv_work, ctl_svc_node);
+/*
+ * Client request handed from the net receive context to a worker thread.  The
+ * receive buffer is reused by the net layer once the callback returns, so the
+ * request is copied into rrw_buf.  Once the SM read callback has run, the item
+ * is placed onto ri_read_reply_queue so that the reply is sent from the main
+ * raft thread.  The worker waits for rrw_replied before reusing its buffers.
+ */
+struct raft_read_work
+{
+    STAILQ_ENTRY(raft_read_work)           rrw_lentry;
+    struct sockaddr_in                     rrw_from;
+    struct ctl_svc_node                   *rrw_csn;
+    struct timespec                        rrw_enqueue_time;
+    ssize_t                                rrw_len;
+    struct raft_net_client_request_handle *rrw_rncr;
+    int                                    rrw_sm_rc;
+    bool                                   rrw_replied;
+    char                                   WORD_ALIGN_MEMBER(rrw_buf[]);
+};
+
+STAILQ_HEAD(raft_srv_work, raft_read_work);
 
 struct raft_work_queue
 {
     pthread_mutex_t      rsw_mutex;
     pthread_cond_t       rsw_cond;
+    size_t               rsw_depth;
     struct raft_srv_work rsw_queue;
 };
 
 struct raft_rw_worker_thread
 {
     struct thread_ctl       rrwt_thread_ctl;
-    char                   *rrwt_recv_buff;
+    struct raft_read_work  *rrwt_work;
     char                   *rrwt_reply_buff;
     void                   *rrwt_arg;
-    struct raft_work_queue *rrwt_queue;
+    struct raft_work_queue  rrwt_queue;
+    size_t                  rrwt_max_depth;
+    size_t                  rrwt_nreqs;
+    unsigned long long      rrwt_lat_usec_total;
+    unsigned long long      rrwt_lat_usec_max;
+};
+
+/* Server msgs are divided into two lanes.  Control msgs are small and are
+ * always sent inline over UDP.  AE requests which carry entries form the bulk
+ * lane, those which are too large for UDP are placed on the follower's send
+ * queue so that their TCP transfer does not delay the control lane.  Any
+ * later AE request to that follower follows them through the queue, even if
+ * it would fit into a datagram, so that AE requests arrive in order.
+ */
+enum raft_net_lane
+{
+    RAFT_NET_LANE_CTL  = 0, // votes, heartbeats, AE replies, sync-idx
+    RAFT_NET_LANE_BULK = 1, // AE requests carrying entries
+    RAFT_NET_LANE_MAX  = 2,
+};
+
+struct raft_net_lane_stats
+{
+    size_t             rnls_nmsgs;
+    size_t             rnls_nerrs;
+    size_t             rnls_depth;
+    size_t             rnls_depth_max;
+    size_t             rnls_nlat; // msgs whose send latency was sampled
+    unsigned long long rnls_lat_usec_total;
+    unsigned long long rnls_lat_usec_max;
+};
+
+enum raft_bulk_send_type
+{
+    RAFT_BULK_SEND_MSG,        // rbs_buf holds the msg to be sent
+    RAFT_BULK_SEND_CHKPT_XFER, // rbs_buf holds a chkpt xfer request to serve
+};
+
+struct raft_bulk_send
+{
+    STAILQ_ENTRY(raft_bulk_send) rbs_lentry;
+    struct ctl_svc_node         *rbs_csn; // holds a reference
+    struct timespec              rbs_enqueue_time;
+    size_t                       rbs_len;
+    enum raft_bulk_send_type     rbs_type;
+    enum raft_ae_compress_type   rbs_compress_type; // applied by the sender
+    char                         WORD_ALIGN_MEMBER(rbs_buf[]);
+};
+
+STAILQ_HEAD(raft_bulk_send_queue, raft_bulk_send);
+
+struct raft_bulk_sender;
+
+/* Each follower has its own bounded send queue and sender thread so that a
+ * stalled TCP connection only fills the queue of that follower.  While the
+ * bulk lane is running, the queue's sender thread is the only sender on the
+ * follower's TCP connection.
+ */
+struct raft_peer_send_queue
+{
+    pthread_mutex_t             rpsq_mutex;
+    struct raft_bulk_send_queue rpsq_queue;
+    struct raft_bulk_sender    *rpsq_sender;
+    struct raft_instance       *rpsq_ri;
+    raft_peer_t                 rpsq_peer;
+    bool                        rpsq_running;
+    size_t                      rpsq_depth;
+    size_t                      rpsq_depth_max;
+    size_t                      rpsq_nchkpt_xfer; // chkpt xfers in rpsq_depth
+    size_t                      rpsq_nfull; // sends refused or skipped
+    size_t                      rpsq_entry_bytes; // AE payload, uncompressed
+    size_t                      rpsq_entry_wire_bytes; // AE payload as sent
+};
+
+/* A sender thread services the send queue of a single follower, a blocking
+ * send to one follower does not hold up the others.  rbsr_nqueued counts the
+ * msgs on its queue so that the thread may sleep without taking the queue
+ * lock.
+ */
+struct raft_bulk_sender
+{
+    struct thread_ctl            rbsr_thread_ctl;
+    pthread_mutex_t              rbsr_mutex;
+    pthread_cond_t               rbsr_cond;
+    size_t                       rbsr_nqueued;
+    struct raft_peer_send_queue *rbsr_queue;
+    char                        *rbsr_buf; // compression and chkpt xfer
+    size_t                       rbsr_buf_size;
+    bool                         rbsr_running;
+};
+
+struct raft_bulk_lane
+{
+    pthread_mutex_t             rbl_mutex; // protects the bulk lane stats
+    bool                        rbl_running;
+    size_t                      rbl_nsenders;
+    struct raft_bulk_sender     rbl_senders[CTL_SVC_MAX_RAFT_PEERS];
+    struct raft_peer_send_queue rbl_peer_sendq[CTL_SVC_MAX_RAFT_PEERS];
+};
+
+/*
+ * Ring of the most recently written raft entries, maintained only on the
+ * leader.  The cached range is contiguous, [rec_lowest_idx, rec_highest_idx],
+ * and each entry resides at slot (idx % RAFT_ENTRY_CACHE_NENTRIES).  Entries
+ * are released once they have been applied or when space is required.
+ */
+struct raft_entry_cache
+{
+    pthread_mutex_t     rec_mutex;
+    raft_entry_idx_t    rec_lowest_idx;
+    raft_entry_idx_t    rec_highest_idx;
+    size_t              rec_nbytes;
+    size_t              rec_max_bytes;
+    size_t              rec_hits;
+    size_t              rec_misses;
+    size_t              rec_evictions;
+    struct raft_entry  *rec_ring[RAFT_ENTRY_CACHE_NENTRIES];
+};
+
+/**
+ * raft_sync_group - group-commit state shared between log writers and the
+ *    sync thread.  Writers post their entries to rsg_pending and wake the
+ *    sync thread, which covers every unsynced entry with a single backend
+ *    sync.  A batch is held open for up to rsg_max_batch_delay_us or until
+ *    rsg_max_batch_size entries have been posted.
+ */
+struct raft_sync_group
+{
+    pthread_mutex_t    rsg_mutex;
+    pthread_cond_t     rsg_cond;
+    pthread_mutex_t    rsg_sync_mutex; // serializes raft_server_backend_sync()
+    size_t             rsg_pending; // entries posted since the last batch
+    struct timespec    rsg_first_post_ts; // first entry of the open batch
+    unsigned long long rsg_max_batch_delay_us;
+    size_t             rsg_max_batch_size;
+};
+
+/* A group attached to the host's sync and chkpt threads.  The busy flags keep
+ * the group on one thread of each kind at a time and hold off its detach.
+ */
+struct raft_host_group
+{
+    struct raft_instance *rhg_ri; // NULL while detached
+    bool                  rhg_sync_busy;
+    bool                  rhg_chkpt_busy;
+    struct timespec       rhg_sync_ts;  // end of the last sync pass
+    struct timespec       rhg_chkpt_ts; // end of the last chkpt pass
+};
+
+/* The sync and chkpt threads which serve the groups run by
+ * raft_server_multi_instance_run() in place of per-group threads.
+ */
+struct raft_host_workers
+{
+    pthread_mutex_t         rhw_mutex;
+    pthread_cond_t          rhw_sync_cond;  // entries posted
+    pthread_cond_t          rhw_chkpt_cond; // chkpt requested
+    pthread_cond_t          rhw_idle_cond;  // a busy flag was cleared
+    size_t                  rhw_ngroups;
+    struct raft_host_group *rhw_groups;
+    size_t                  rhw_sync_next;  // where the next scan starts
+    size_t                  rhw_chkpt_next;
+    size_t                  rhw_nsync_threads;
+    size_t                  rhw_nchkpt_threads;
+    struct thread_ctl       rhw_sync_thread_ctl[RAFT_HOST_SYNC_THREADS_MAX];
+    struct thread_ctl       rhw_chkpt_thread_ctl[RAFT_HOST_CHKPT_THREADS_MAX];
+};
+
+enum raft_apply_prefetch_slot_state
+{
+    RAFT_APPLY_PREFETCH_SLOT_EMPTY = 0,
+    RAFT_APPLY_PREFETCH_SLOT_PENDING,  // being read by the prefetch thread
+    RAFT_APPLY_PREFETCH_SLOT_READY,    // awaiting the apply
+};
+
+struct raft_apply_prefetch_slot
+{
+    enum raft_apply_prefetch_slot_state raps_state;
+    raft_entry_idx_t                    raps_idx;
+    int                                 raps_rc;
+    struct raft_entry_header            raps_reh;
+    char                               *raps_buf;
+    size_t                              raps_buf_size;
+};
+
+/**
+ * raft_apply_prefetch - read-ahead state shared between the state machine
+ *    apply and the prefetch thread.  The thread reads committed entries,
+ *    up to rap_limit_idx, into the slot at (idx % rap_depth) while the
+ *    apply context works on lower indexes.  A slot is only refilled after
+ *    the apply has released it so the read-ahead is bounded by rap_depth.
+ */
+struct raft_apply_prefetch
+{
+    pthread_mutex_t                 rap_mutex;
+    pthread_cond_t                  rap_cond;
+    raft_entry_idx_t                rap_next_idx;  // next idx to be read
+    raft_entry_idx_t                rap_limit_idx; // commit idx at last update
+    size_t                          rap_depth;     // running, 0 if disabled
+    size_t                          rap_hits;
+    size_t                          rap_misses;
+    struct raft_apply_prefetch_slot rap_slots[RAFT_SM_APPLY_PREFETCH_MAX];
 };
 
 // Struct to book keep last applied index and sub-indexes
@@ -547,6 +1147,9 @@ struct raft_instance
     bool                            ri_ignore_timerfd;
     bool                            ri_synchronous_writes;
     bool                            ri_coalesced_writes;
+    bool                            ri_posix_io_uring;
+    bool                            ri_posix_o_direct;
+    bool                            ri_rocksdb_single_kv;
     bool                            ri_user_requested_checkpoint;
     bool                            ri_user_requested_reap;
     bool                            ri_auto_checkpoints_enabled;
@@ -554,6 +1157,8 @@ struct raft_instance
     bool                            ri_lreg_registered;
     bool                            ri_incomplete_recovery;
     bool                            ri_successful_recovery;
+    bool                            ri_hosted; // shares the host event loop
+    struct raft_net_host_tcp_listener *ri_host_tcp[RAFT_UDP_LISTEN_MAX];
     enum raft_follower_reasons      ri_follower_reason;
     int                             ri_startup_error;
     int                             ri_timer_fd;
@@ -564,11 +1169,23 @@ struct raft_instance
     raft_chkpt_thread_atomic64_t    ri_checkpoint_last_idx;
     raft_chkpt_thread_atomic64_t    ri_lowest_idx; // set by log reap
     pthread_mutex_t                 ri_compaction_mutex;
-    raft_entry_idx_t                ri_pending_read_idx; // protected by mutex
+    raft_chkpt_thread_atomic64_t    ri_pending_lowest_idx; // set under mutex
+    niova_atomic64_t                ri_read_pins[RAFT_READ_PIN_SLOTS];
     int                             ri_last_chkpt_err;
     unsigned long long              ri_sync_freq_us;
     size_t                          ri_sync_cnt;
     ssize_t                         ri_max_scan_entries;
+    unsigned int                    ri_ae_window;
+    unsigned int                    ri_ae_max_packed_idx;
+    size_t                          ri_udp_mmsg_batch; // tunable
+    uint16_t                        ri_rpc_msg_version_max; // tunable
+    uint16_t                        ri_peer_msg_version[CTL_SVC_MAX_RAFT_PEERS];
+    uint8_t                         ri_ae_compress_type; // tunable
+    size_t                          ri_ae_compress_min_size; // tunable
+    size_t                          ri_bulk_recovery_bw_limit; // tunable
+    uint32_t                        ri_peer_codecs[CTL_SVC_MAX_RAFT_PEERS];
+    char                           *ri_ae_decompress_buf;
+    size_t                          ri_ae_decompress_buf_size;
     size_t                          ri_log_reap_factor;
     size_t                          ri_num_checkpoints;
     const size_t                    ri_max_entry_size;
@@ -590,6 +1207,7 @@ struct raft_instance
     size_t                          ri_evps_in_use;
     struct lreg_node                ri_lreg;
     struct lreg_node                ri_net_lreg;
+    struct lreg_node                ri_net_recovery_lreg;
     struct raft_instance_hist_stats ri_rihs[RAFT_INSTANCE_HIST_MAX];
     struct raft_instance_backend   *ri_backend;
     void                           *ri_backend_arg;
@@ -599,12 +1217,32 @@ struct raft_instance
     struct thread_ctl               ri_sync_thread_ctl;
     struct thread_ctl               ri_chkpt_thread_ctl;
     struct raft_rw_worker_thread    ri_reader_thread_ctl[RAFT_NUM_READ_THREADS];
-    struct raft_work_queue          ri_worker_queue[RAFT_SERVER_BULK_MSG_MAX];
+    size_t                          ri_num_read_threads; // tunable
+    size_t                          ri_num_read_workers; // running
+    struct raft_work_queue          ri_read_reply_queue;
+    bool                            ri_read_reply_queue_open;
+    size_t                          ri_startup_scan_crc_threads; // tunable
+    unsigned long long              ri_startup_usec;
+    unsigned long long              ri_startup_scan_usec;
+    struct thread_ctl               ri_apply_prefetch_thread_ctl;
+    struct raft_apply_prefetch      ri_apply_prefetch;
+    struct raft_bulk_lane           ri_bulk_lane;
+    struct raft_net_lane_stats      ri_lane_stats[RAFT_NET_LANE_MAX];
+    size_t                          ri_bulk_lane_depth; // tunable
+    size_t                          ri_sm_apply_prefetch_depth; // tunable
+    size_t                          ri_sm_apply_batch; // tunable
+    unsigned long long              ri_co_wr_latency_budget_us; // tunable
+    size_t                          ri_co_wr_max_entries; // tunable
+    size_t                          ri_co_wr_flush_cnt[RAFT_CO_WR_FLUSH_MAX];
     struct raft_recovery_handle     ri_recovery_handle;
-    char                           *ri_buf_set_source;
-    struct buffer_set               ri_buf_set[RAFT_BUF_SET_MAX];
+    struct raft_buf_pool            ri_buf_pool;
+    struct raft_buf_pool           *ri_bufs; // ri_buf_pool or the host's
+    struct raft_buf_pool           *ri_host_buf_pool;
+    struct raft_host_workers       *ri_host_workers;
     pthread_mutex_t                 ri_write_mutex;
     uint64_t                        ri_apply_handler_version;
+    struct raft_sync_group          ri_sync_group;
+    struct raft_entry_cache         ri_entry_cache;
     struct raft_instance_co_wr     *ri_coalesced_wr; //must be the last member
 };
 
@@ -621,9 +1259,12 @@ raft_compile_time_checks(void)
      * coalesce write entry.
      */
     COMPILE_TIME_ASSERT(RAFT_ENTRY_NUM_ENTRIES < RAFT_NET_WR_SUPP_MAX);
+    COMPILE_TIME_ASSERT(RAFT_ENTRY_NUM_ENTRIES <= UINT8_MAX); // v1 count
     COMPILE_TIME_ASSERT(RAFT_ELECTION_UPPER_TIME_MS > 0);
     COMPILE_TIME_ASSERT(sizeof(struct raft_entry_header) ==
                         RAFT_ENTRY_HEADER_RESERVE);
+    COMPILE_TIME_ASSERT(sizeof(struct raft_rpc_msg) ==
+                        RAFT_RPC_MSG_VERSION_0_SIZE);
     COMPILE_TIME_ASSERT((RAFT_ELECTION_UPPER_TIME_MS /
                          RAFT_HEARTBEAT_FREQ_PER_ELECTION) >=
                         RAFT_HEARTBEAT__MIN_TIME_MS);
@@ -696,6 +1337,29 @@ do {                                                                \
                     (rm)->rrm_sync_index_update.rsium_synced_log_index, \
                     __uuid_str, ##__VA_ARGS__);                         \
             break;                                                      \
+        case RAFT_RPC_MSG_TYPE_CHKPT_XFER_REQUEST:                      \
+            LOG_MSG(log_level,                                          \
+                    "CHKPT_XFER_REQ ci=%ld %.*s@%ld len=%u tag=%lu %s " \
+                    fmt,                                                \
+                    (rm)->rrm_chkpt_xfer_request.rcxrqm_chkpt_idx,      \
+                    (int)RAFT_CHKPT_XFER_NAME_MAX,                      \
+                    (rm)->rrm_chkpt_xfer_request.rcxrqm_name,           \
+                    (rm)->rrm_chkpt_xfer_request.rcxrqm_offset,         \
+                    (rm)->rrm_chkpt_xfer_request.rcxrqm_len,            \
+                    (rm)->rrm_chkpt_xfer_request.rcxrqm_tag,            \
+                    __uuid_str, ##__VA_ARGS__);                         \
+            break;                                                      \
+        case RAFT_RPC_MSG_TYPE_CHKPT_XFER_REPLY:                        \
+            LOG_MSG(log_level,                                          \
+                    "CHKPT_XFER_REPLY ci=%ld off=%ld len=%u err=%d "    \
+                    "tag=%lu %s "fmt,                                   \
+                    (rm)->rrm_chkpt_xfer_reply.rcxrpm_chkpt_idx,        \
+                    (rm)->rrm_chkpt_xfer_reply.rcxrpm_offset,           \
+                    (rm)->rrm_chkpt_xfer_reply.rcxrpm_len,              \
+                    (rm)->rrm_chkpt_xfer_reply.rcxrpm_err,              \
+                    (rm)->rrm_chkpt_xfer_reply.rcxrpm_tag,              \
+                    __uuid_str, ##__VA_ARGS__);                         \
+            break;                                                      \
         default:                                                        \
             LOG_MSG(log_level, "UNKNOWN "fmt, ##__VA_ARGS__);           \
             break;                                                      \
@@ -917,6 +1581,17 @@ raft_instance_is_follower(const struct raft_instance *ri)
     return ri->ri_state == RAFT_STATE_FOLLOWER ? true : false;
 }
 
+/**
+ * raft_instance_buf_set - returns the instance's buffer set of 'type'.  The
+ *    set may be shared with the other hosted groups.
+ */
+static inline struct buffer_set *
+raft_instance_buf_set(struct raft_instance *ri, enum raft_buf_set_type type)
+{
+    NIOVA_ASSERT(ri && ri->ri_bufs && type < RAFT_BUF_SET_MAX);
+    return &ri->ri_bufs->rbp_sets[type];
+}
+
 static inline bool
 raft_instance_is_booting(const struct raft_instance *ri)
 {
@@ -1173,12 +1848,21 @@ raft_server_entry_init_for_log_header(const struct raft_instance *ri,
                                       const char *data,
                                       uint32_t entry_sizes);
 
+// May be used by backends to write an entry header and its data fragments
+ssize_t
+raft_server_entry_pwritev(const int fd, const struct raft_entry_header *reh,
+                          const struct iovec *iov, const size_t niov,
+                          const off_t offset);
+
 void
 raft_server_backend_use_posix(struct raft_instance *ri);
 
 void
 raft_server_backend_use_rocksdb(struct raft_instance *ri);
 
+void
+raft_server_backend_use_segment(struct raft_instance *ri);
+
 int
 raft_server_instance_run(const char *raft_uuid_str,
                          const char *this_peer_uuid_str,
@@ -1187,6 +1871,26 @@ raft_server_instance_run(const char *raft_uuid_str,
                          enum raft_instance_store_type type,
                          enum raft_instance_options opts, void *arg);
 
+/**
+ * raft_server_group_conf - describes one of the raft groups hosted by
+ *    raft_server_multi_instance_run().  'arg' is passed to the backend in
+ *    the same manner as raft_server_instance_run()'s 'arg'.
+ */
+struct raft_server_group_conf
+{
+    const char *rsgc_raft_uuid_str;
+    const char *rsgc_this_peer_uuid_str;
+    void       *rsgc_arg;
+};
+
+int
+raft_server_multi_instance_run(const struct raft_server_group_conf *groups,
+                               size_t ngroups,
+                               raft_sm_request_handler_t sm_request_handler,
+                               raft_init_cb_t init_peer_handler,
+                               enum raft_instance_store_type type,
+                               enum raft_instance_options opts);
+
 void
 raft_server_backend_setup_last_applied(struct raft_instance *ri,
                                        struct raft_last_applied *rla);
@@ -11,6 +11,7 @@
 #include <arpa/inet.h>
 #include <netinet/in.h>
 #include <netinet/udp.h>
+#include <stddef.h>
 
 #include "niova/common.h"
 #include "niova/epoll_mgr.h"
@@ -26,6 +27,7 @@ struct raft_instance;
 struct epoll_handle;
 struct ctl_svc_node;
 struct sockaddr_in;
+struct raft_rpc_msg;
 
 #define RAFT_INSTANCE_PERSISTENT_APP_SCAN_ENTRIES     100000
 #define RAFT_INSTANCE_PERSISTENT_APP_MIN_SCAN_ENTRIES 500
@@ -41,6 +43,15 @@ struct sockaddr_in;
 #define RAFT_NET_PEER_RECENCY_NO_RECV -1ULL
 #define RAFT_NET_PEER_RECENCY_NO_SEND -2ULL
 
+// Datagrams moved per recvmmsg() / sendmmsg() call, '1' disables batching
+#define RAFT_NET_UDP_MMSG_BATCH_MAX     16
+#define RAFT_NET_UDP_MMSG_BATCH_DEFAULT RAFT_NET_UDP_MMSG_BATCH_MAX
+// Per-slot scratch space, must hold RAFT_RPC_MSG_COMPACT_HDR_MAX bytes
+#define RAFT_NET_UDP_MMSG_SCRATCH_SZ    768
+
+// AE payloads below this size are not worth compressing
+#define RAFT_NET_AE_COMPRESS_MIN_SIZE_DEFAULT 4096
+
 typedef void     raft_net_cb_ctx_t;
 typedef int      raft_net_cb_ctx_int_t;
 typedef bool     raft_net_cb_ctx_bool_t;
@@ -61,10 +72,11 @@ enum raft_event_pipe_types
     RAFT_EVP_REMOTE_SEND,
     RAFT_EVP_ASYNC_COMMIT_IDX_ADV,
     RAFT_EVP_SM_APPLY,
+    RAFT_EVP_READ_REPLY,
     RAFT_EVP_CLIENT,
     RAFT_EVP__ANY,
     RAFT_EVP_SERVER__START = RAFT_EVP_REMOTE_SEND,
-    RAFT_EVP_SERVER__END = RAFT_EVP_SM_APPLY,
+    RAFT_EVP_SERVER__END = RAFT_EVP_READ_REPLY,
 };
 
 enum raft_net_client_request_type
@@ -96,7 +108,16 @@ typedef raft_net_cb_ctx_t
 typedef raft_net_timerfd_cb_ctx_t
 (*raft_net_timer_cb_t)(struct raft_instance *);
 
-// State machine request handler - reads, writes, and commits
+/* State machine request handler - reads, writes, and commits.  Writes and
+ * commits are always issued from the main raft thread.  When read workers are
+ * enabled (see raft_net_set_num_read_threads()), reads are issued from the
+ * worker threads, concurrently with one another and with the apply of newly
+ * committed entries.  In that case the read handler must only access the SM
+ * through interfaces which are safe for concurrent use (ie. rocksdb reads), it
+ * must not access the raft instance, and it must confine its output to the
+ * provided request handle.  The reply is sent by the main raft thread after
+ * the handler returns.
+ */
 typedef raft_net_cb_ctx_int_t
 (*raft_sm_request_handler_t)(struct raft_net_client_request_handle *);
 
@@ -117,6 +138,10 @@ typedef int (*raft_net_shutdown_cb_t)(struct raft_instance *);
 #define RAFT_NET_MAX_RPC_SIZE_ROCKSDB                     \
     (RAFT_NET_ENTRY_SIZE_ROCKSDB - RAFT_NET_ENTRY_RESERVE)
 
+#define RAFT_NET_ENTRY_SIZE_SEGMENT (4096 * 1024)
+#define RAFT_NET_MAX_RPC_SIZE_SEGMENT                     \
+    (RAFT_NET_ENTRY_SIZE_SEGMENT - RAFT_NET_ENTRY_RESERVE)
+
 #define RAFT_NET_MAX_RETRY_MS 30000
 #define RAFT_NET_MIN_RETRY_MS 100
 
@@ -125,6 +150,7 @@ enum raft_instance_store_type
     RAFT_INSTANCE_STORE_POSIX_FLAT_FILE = 0, // keep this as default
     RAFT_INSTANCE_STORE_ROCKSDB,
     RAFT_INSTANCE_STORE_ROCKSDB_PERSISTENT_APP,
+    RAFT_INSTANCE_STORE_POSIX_SEGMENTED, // variable size entries
 };
 
 static inline size_t
@@ -139,6 +165,9 @@ raft_net_max_rpc_size(enum raft_instance_store_type be_type)
     case RAFT_INSTANCE_STORE_ROCKSDB_PERSISTENT_APP:
         return RAFT_NET_MAX_RPC_SIZE_ROCKSDB;
 
+    case RAFT_INSTANCE_STORE_POSIX_SEGMENTED:
+        return RAFT_NET_MAX_RPC_SIZE_SEGMENT;
+
     default:
         break;
     }
@@ -156,6 +185,9 @@ enum raft_instance_options
     RAFT_INSTANCE_OPTIONS_AUTO_CHECKPOINT      = 1 << 2,
     RAFT_INSTANCE_OPTIONS_DISABLE_UDP          = 1 << 3,
     RAFT_INSTANCE_OPTIONS_DISABLE_TCP          = 1 << 4,
+    RAFT_INSTANCE_OPTIONS_POSIX_IO_URING       = 1 << 5,
+    RAFT_INSTANCE_OPTIONS_POSIX_O_DIRECT       = 1 << 6,
+    RAFT_INSTANCE_OPTIONS_ROCKSDB_SINGLE_KV    = 1 << 7,
 };
 
 enum raft_udp_listen_sockets
@@ -167,6 +199,57 @@ enum raft_udp_listen_sockets
     RAFT_UDP_LISTEN_ANY    = RAFT_UDP_LISTEN_MAX,
 };
 
+/**
+ * raft_net_udp_send_batch - UDP messages queued for a single sendmmsg().  The
+ *    message buffers are not copied and must remain valid until the batch
+ *    has been flushed.  Each slot has a scratch buffer which may hold an
+ *    encoded (compact) rpc msg header.
+ */
+struct raft_net_udp_send_batch
+{
+    enum raft_udp_listen_sockets rnusb_sock_src;
+    bool                         rnusb_host_coalesce; // see rpc msg batch
+    size_t                       rnusb_nmsgs;
+    struct ctl_svc_node         *rnusb_csn[RAFT_NET_UDP_MMSG_BATCH_MAX];
+    struct sockaddr_in           rnusb_dest[RAFT_NET_UDP_MMSG_BATCH_MAX];
+    struct iovec                 rnusb_iov[RAFT_NET_UDP_MMSG_BATCH_MAX];
+    char                         rnusb_scratch[RAFT_NET_UDP_MMSG_BATCH_MAX]
+                                              [RAFT_NET_UDP_MMSG_SCRATCH_SZ];
+};
+
+/**
+ * raft_rpc_msg_batch_hdr - leads a datagram which carries the server msgs of
+ *    several raft groups.  The first two members overlay rrm_type and
+ *    rrm_version.  Each msg follows a raft_rpc_msg_batch_ent and starts on an
+ *    8 byte boundary.  Batches are only sent to peers at
+ *    RAFT_RPC_MSG_VERSION_BATCH.
+ */
+struct raft_rpc_msg_batch_hdr
+{
+    uint32_t rrmbh_type;    // RAFT_RPC_MSG_TYPE_BATCH
+    uint16_t rrmbh_version; // RAFT_RPC_MSG_VERSION_BATCH
+    uint16_t rrmbh_nmsgs;
+};
+
+struct raft_rpc_msg_batch_ent
+{
+    uint32_t rrmbe_size;
+    uint32_t rrmbe_pad;
+};
+
+/**
+ * raft_net_udp_send_batch_scratch - returns the scratch buffer of the slot
+ *    which the next raft_net_send_msg_batched() call will occupy.  The batch
+ *    is flushed as soon as it fills so the slot cannot be in use.
+ */
+static inline char *
+raft_net_udp_send_batch_scratch(struct raft_net_udp_send_batch *rnusb)
+{
+    NIOVA_ASSERT(rnusb && rnusb->rnusb_nmsgs < RAFT_NET_UDP_MMSG_BATCH_MAX);
+
+    return rnusb->rnusb_scratch[rnusb->rnusb_nmsgs];
+}
+
 enum raft_client_rpc_msg_type
 {
     RAFT_CLIENT_RPC_MSG_TYPE_INVALID    = 0,
@@ -325,14 +408,57 @@ struct raft_net_wr_supp
     size_t                     rnws_value_size;
 };
 
+/* Write supplement items are kept in a list of segments whose capacity grows
+ * geometrically so that adding an item never copies the existing ones.  Keys
+ * and values are copied into a bump arena owned by the supplements structure
+ * and released in bulk by raft_net_sm_write_supplement_destroy().  Arena
+ * allocations are aligned as malloc() would align them.  Items are located
+ * by index with raft_net_sm_write_supplement_get(), this replaces indexing
+ * the former rnsws_ws array.
+ */
+#define RAFT_NET_WR_SUPP_SEG_MIN_ITEMS   16UL
+#define RAFT_NET_WR_SUPP_SEG_MAX_ITEMS   65536UL
+#define RAFT_NET_WR_SUPP_ARENA_MIN_SIZE  4096UL
+#define RAFT_NET_WR_SUPP_ARENA_MAX_SIZE  (1024UL * 1024UL)
+#define RAFT_NET_WR_SUPP_ARENA_ALIGN     _Alignof(max_align_t)
+
+struct raft_net_wr_supp_seg
+{
+    struct raft_net_wr_supp_seg *rnwss_next;
+    size_t                       rnwss_nitems;
+    size_t                       rnwss_capacity;
+    struct raft_net_wr_supp      rnwss_items[];
+};
+
+struct raft_net_wr_supp_arena_chunk
+{
+    struct raft_net_wr_supp_arena_chunk *rnwsac_next;
+    size_t                               rnwsac_size;
+    size_t                               rnwsac_used;
+    _Alignas(max_align_t) char           rnwsac_data[];
+};
+
 struct raft_net_sm_write_supplements
 {
-    size_t                   rnsws_nitems;
-    struct raft_net_wr_supp *rnsws_ws;
-    crc32_t                  rnsws_kv_crc;
-    bool                     rnsws_kv_crc_enabled;
+    size_t                               rnsws_nitems;
+    struct raft_net_wr_supp_seg         *rnsws_seg_head;
+    struct raft_net_wr_supp_seg         *rnsws_seg_tail;
+    struct raft_net_wr_supp_arena_chunk *rnsws_arena; // allocating chunk first
+    crc32_t                              rnsws_kv_crc;
+    bool                                 rnsws_kv_crc_enabled;
 };
 
+/* Only KVs destined for this column family contribute to the KV CRC chain.
+ * Column family handles are classified once, when registered, and cached in a
+ * small handle-keyed table.
+ */
+#define RAFT_NET_WR_SUPP_KV_CRC_CF_NAME "PMDBTS_CF"
+#define RAFT_NET_WR_SUPP_CF_CACHE_SIZE  64
+
+#define RAFT_NET_SM_WRITE_SUPP_SEG_FOREACH(rnsws, seg)                  \
+    for ((seg) = (rnsws)->rnsws_seg_head; (seg) != NULL;                \
+         (seg) = (seg)->rnwss_next)
+
 struct raft_net_client_request_handle
 {
     enum raft_net_client_request_type     rncr_type;  // may be set by sm cb
@@ -494,6 +620,28 @@ raft_net_compile_time_assert(void)
 struct raft_instance *
 raft_net_get_instance(void);
 
+struct raft_instance *
+raft_net_instance_alloc(void);
+
+void
+raft_net_instance_free(struct raft_instance *ri);
+
+struct raft_instance *
+raft_net_instance_lookup(const uuid_t raft_uuid);
+
+int
+raft_net_instance_lreg_install(struct raft_instance *ri,
+                               struct lreg_node *parent);
+
+int
+raft_net_host_setup(void);
+
+int
+raft_net_host_destroy(void);
+
+int
+raft_net_host_epoll_wait(int timeout_ms);
+
 int
 raft_net_instance_startup(struct raft_instance *ri, bool client_mode);
 
@@ -565,6 +713,23 @@ raft_net_send_msg_to_uuid(struct raft_instance *ri, uuid_t uuid,
                           struct iovec *iov, size_t niovs,
                           const enum raft_udp_listen_sockets sock_src);
 
+int
+raft_net_send_bulk_msg(struct raft_instance *ri, struct ctl_svc_node *csn,
+                       struct iovec *iov, size_t niovs);
+
+void
+raft_net_udp_send_batch_init(struct raft_net_udp_send_batch *rnusb,
+                             const enum raft_udp_listen_sockets sock_src);
+
+int
+raft_net_send_msg_batched(struct raft_instance *ri,
+                          struct raft_net_udp_send_batch *rnusb,
+                          struct ctl_svc_node *csn, struct iovec *iov);
+
+int
+raft_net_udp_send_batch_flush(struct raft_instance *ri,
+                              struct raft_net_udp_send_batch *rnusb);
+
 int
 raft_net_send_client_msg(struct raft_instance *ri,
                          struct raft_client_rpc_msg *rcrm);
@@ -726,6 +891,20 @@ crc32_t
 raft_net_sm_write_supplement_get_kv_crc(
     const struct raft_net_sm_write_supplements *rnsws);
 
+struct raft_net_wr_supp *
+raft_net_sm_write_supplement_get(
+    const struct raft_net_sm_write_supplements *rnsws, size_t idx);
+
+bool
+raft_net_wr_supp_cf_name_is_kv_crc(const char *cf_name,
+                                   const size_t cf_name_len);
+
+int
+raft_net_wr_supp_cf_register(const void *cf_handle, const bool kv_crc);
+
+void
+raft_net_wr_supp_cf_unregister(const void *cf_handle);
+
 // Raft Net User ID API
 static inline void
 raft_net_client_user_id_init(struct raft_net_client_user_id *rncui)
@@ -834,6 +1013,56 @@ raft_net_set_log_reap_factor(struct raft_instance *ri, size_t log_reap_factor);
 void
 raft_net_set_num_checkpoints(struct raft_instance *ri, size_t num_ckpts);
 
+void
+raft_net_set_num_read_threads(struct raft_instance *ri, size_t nthreads);
+
+void
+raft_net_set_startup_scan_crc_threads(struct raft_instance *ri,
+                                      size_t nthreads);
+
+void
+raft_net_set_bulk_recovery_bw_limit(struct raft_instance *ri,
+                                    size_t bytes_per_sec);
+
+void
+raft_net_set_sm_apply_prefetch_depth(struct raft_instance *ri, size_t depth);
+
+void
+raft_net_set_udp_mmsg_batch(struct raft_instance *ri, size_t batch);
+
+void
+raft_net_set_rpc_msg_version_max(struct raft_instance *ri, size_t version);
+
+ssize_t
+raft_net_rpc_msg_compact_encode(const struct raft_rpc_msg *rrm, char *buf,
+                                size_t buf_size);
+
+ssize_t
+raft_net_rpc_msg_compact_decode(const char *buf, size_t buf_size,
+                                struct raft_rpc_msg *rrm, size_t rrm_size);
+
+void
+raft_net_set_ae_compress_type(struct raft_instance *ri, int type);
+
+void
+raft_net_set_ae_compress_min_size(struct raft_instance *ri, size_t size);
+
+ssize_t
+raft_net_ae_entries_compress(const struct raft_rpc_msg *src, int type,
+                             char *buf, size_t buf_size);
+
+ssize_t
+raft_net_ae_entries_decompress(const char *buf, size_t buf_size,
+                               struct raft_rpc_msg *rrm, size_t rrm_size);
+
+int
+raft_net_rpc_msg_batch_add(char *batch, size_t batch_size, size_t *len,
+                           const void *msg, size_t msg_size);
+
+ssize_t
+raft_net_rpc_msg_batch_next(const char *batch, size_t len, size_t *off,
+                            size_t *msg_off);
+
 int
 raft_net_sm_write_supplements_merge(struct raft_net_sm_write_supplements *dest,
                                     struct raft_net_sm_write_supplements *src);
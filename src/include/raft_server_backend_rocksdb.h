@@ -7,6 +7,9 @@
 #ifndef RAFT_SERVER_BACKEND_ROCKSDB_H
 #define RAFT_SERVER_BACKEND_ROCKSDB_H 1
 
+#include <endian.h>
+#include <stdio.h>
+#include <string.h>
 #include <rocksdb/c.h>
 
 #include "raft.h"
@@ -14,10 +17,163 @@
 #define RAFT_ROCKSDB_MAX_CF 32
 #define RAFT_ROCKSDB_MAX_CF_NAME_LEN 4096
 
+#define RAFT_LOG_HEADER_ROCKSDB "a0_hdr."
+#define RAFT_LOG_HEADER_ROCKSDB_STRLEN 7
+#define RAFT_LOG_HEADER_FMT RAFT_LOG_HEADER_ROCKSDB"%s__%s"
+
+#define RAFT_LOG_LASTENTRY_ROCKSDB "z0_last."
+#define RAFT_LOG_LASTENTRY_ROCKSDB_STRLEN 8
+#define RAFT_LOG_LASTENTRY_FMT RAFT_LOG_LASTENTRY_ROCKSDB"%s__%s"
+
+/* Legacy ASCII entry keys:  "e0.<16 decimal digits><e|h>"
+ */
+#define RAFT_HEADER_ENTRY_KEY_FMT "%016zuh"
+#define RAFT_ENTRY_KEY_FMT        "%016zue"
+#define RAFT_ENTRY_KEY_IDX_DIGITS 16
+
+#define RAFT_ENTRY_KEY_PREFIX_ROCKSDB "e0."
+#define RAFT_ENTRY_KEY_PREFIX_ROCKSDB_STRLEN 3
+#define RAFT_ENTRY_KEY_PRINTF RAFT_ENTRY_KEY_PREFIX_ROCKSDB RAFT_ENTRY_KEY_FMT
+
+#define RAFT_ENTRY_HEADER_KEY_PREFIX_ROCKSDB RAFT_ENTRY_KEY_PREFIX_ROCKSDB
+#define RAFT_ENTRY_HEADER_KEY_PREFIX_ROCKSDB_STRLEN \
+    RAFT_ENTRY_KEY_PREFIX_ROCKSDB_STRLEN
+#define RAFT_ENTRY_HEADER_KEY_PRINTF \
+    RAFT_ENTRY_KEY_PREFIX_ROCKSDB RAFT_HEADER_ENTRY_KEY_FMT
+
+#define RAFT_ENTRY_KEY_ASCII_LEN                                        \
+    (RAFT_ENTRY_KEY_PREFIX_ROCKSDB_STRLEN + RAFT_ENTRY_KEY_IDX_DIGITS + 1)
+
+/* Binary entry keys:  "e1" + <8 byte big-endian index> + <e|h>.  Big-endian
+ * encoding keeps the bytewise comparator ordering identical to the numeric
+ * ordering of the index, and the "e1" prefix sorts between the log header
+ * keys and the "z0_last." key just as the ASCII prefix does.
+ */
+#define RAFT_ENTRY_KEY_PREFIX_BIN_ROCKSDB "e1"
+#define RAFT_ENTRY_KEY_PREFIX_BIN_ROCKSDB_STRLEN 2
+#define RAFT_ENTRY_KEY_BIN_LEN                                          \
+    (RAFT_ENTRY_KEY_PREFIX_BIN_ROCKSDB_STRLEN + sizeof(uint64_t) + 1)
+
+#define RAFT_ENTRY_KEY_SUFFIX_ENTRY  'e'
+#define RAFT_ENTRY_KEY_SUFFIX_HEADER 'h'
+
+/* Stored in raft_log_header::rlh_version when the db is created.  Existing
+ * dbs (version 0) continue to use ASCII entry keys.  Version 2 dbs use
+ * binary keys and store each entry as a single KV under its 'e' key, with
+ * the entry header directly preceding the entry data in the value.  There
+ * are no 'h' keys in a version 2 db.
+ */
+enum raft_rocksdb_log_version
+{
+    RAFT_ROCKSDB_LOG_VERSION_ASCII_KEYS  = 0,
+    RAFT_ROCKSDB_LOG_VERSION_BINARY_KEYS = 1,
+    RAFT_ROCKSDB_LOG_VERSION_SINGLE_KV   = 2,
+    RAFT_ROCKSDB_LOG_VERSION_MAX,
+};
+
+/**
+ * raft_rocksdb_entry_key_build - fills 'key' with the entry (or entry header)
+ *    key for 'idx' in the requested format.  Returns the key length or 0 if
+ *    'key_max' is too small.
+ */
+static inline size_t
+raft_rocksdb_entry_key_build(char *key, const size_t key_max,
+                             const raft_entry_idx_t idx, const bool header,
+                             const bool binary)
+{
+    if (!key || idx < 0)
+        return 0;
+
+    if (binary)
+    {
+        if (key_max < RAFT_ENTRY_KEY_BIN_LEN)
+            return 0;
+
+        const uint64_t be_idx = htobe64((uint64_t)idx);
+
+        memcpy(key, RAFT_ENTRY_KEY_PREFIX_BIN_ROCKSDB,
+               RAFT_ENTRY_KEY_PREFIX_BIN_ROCKSDB_STRLEN);
+        memcpy(&key[RAFT_ENTRY_KEY_PREFIX_BIN_ROCKSDB_STRLEN], &be_idx,
+               sizeof(uint64_t));
+
+        key[RAFT_ENTRY_KEY_BIN_LEN - 1] = header ?
+            RAFT_ENTRY_KEY_SUFFIX_HEADER : RAFT_ENTRY_KEY_SUFFIX_ENTRY;
+
+        return RAFT_ENTRY_KEY_BIN_LEN;
+    }
+
+    int rc = snprintf(key, key_max, header ?
+                      RAFT_ENTRY_HEADER_KEY_PRINTF : RAFT_ENTRY_KEY_PRINTF,
+                      (size_t)idx);
+
+    return (rc > 0 && (size_t)rc < key_max) ? (size_t)rc : 0;
+}
+
+/**
+ * raft_rocksdb_entry_key_parse - decodes a key produced by
+ *    raft_rocksdb_entry_key_build().  The key need not be NULL terminated.
+ *    Returns -EBADMSG if the key is not an entry key of the given format.
+ */
+static inline int
+raft_rocksdb_entry_key_parse(const char *key, const size_t key_len,
+                             const bool binary, raft_entry_idx_t *ret_idx,
+                             bool *ret_header)
+{
+    if (!key || !ret_idx)
+        return -EINVAL;
+
+    char suffix;
+    uint64_t idx = 0;
+
+    if (binary)
+    {
+        if (key_len != RAFT_ENTRY_KEY_BIN_LEN ||
+            memcmp(key, RAFT_ENTRY_KEY_PREFIX_BIN_ROCKSDB,
+                   RAFT_ENTRY_KEY_PREFIX_BIN_ROCKSDB_STRLEN))
+            return -EBADMSG;
+
+        memcpy(&idx, &key[RAFT_ENTRY_KEY_PREFIX_BIN_ROCKSDB_STRLEN],
+               sizeof(uint64_t));
+        idx = be64toh(idx);
+    }
+    else
+    {
+        if (key_len != RAFT_ENTRY_KEY_ASCII_LEN ||
+            memcmp(key, RAFT_ENTRY_KEY_PREFIX_ROCKSDB,
+                   RAFT_ENTRY_KEY_PREFIX_ROCKSDB_STRLEN))
+            return -EBADMSG;
+
+        for (size_t i = RAFT_ENTRY_KEY_PREFIX_ROCKSDB_STRLEN;
+             i < key_len - 1; i++)
+        {
+            if (key[i] < '0' || key[i] > '9')
+                return -EBADMSG;
+
+            idx = (idx * 10) + (key[i] - '0');
+        }
+    }
+
+    suffix = key[key_len - 1];
+    if (suffix != RAFT_ENTRY_KEY_SUFFIX_ENTRY &&
+        suffix != RAFT_ENTRY_KEY_SUFFIX_HEADER)
+        return -EBADMSG;
+
+    if (idx > (uint64_t)INT64_MAX)
+        return -ERANGE;
+
+    *ret_idx = (raft_entry_idx_t)idx;
+
+    if (ret_header)
+        *ret_header = suffix == RAFT_ENTRY_KEY_SUFFIX_HEADER ? true : false;
+
+    return 0;
+}
+
 struct raft_server_rocksdb_cf_table
 {
     const char                     *rsrcfe_cf_names[RAFT_ROCKSDB_MAX_CF];
     rocksdb_column_family_handle_t *rsrcfe_cf_handles[RAFT_ROCKSDB_MAX_CF];
+    bool                            rsrcfe_cf_kv_crc[RAFT_ROCKSDB_MAX_CF];
     size_t                          rsrcfe_num_cf;
 };
 
@@ -31,4 +187,8 @@ raft_server_rocksdb_add_cf_name(struct raft_server_rocksdb_cf_table *cft,
 void
 raft_server_rocksdb_release_cf_table(struct raft_server_rocksdb_cf_table *cft);
 
+int
+raft_server_rocksdb_drop_cf(struct raft_instance *ri,
+                            rocksdb_column_family_handle_t *cf_handle);
+
 #endif
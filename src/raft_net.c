@@ -7,11 +7,13 @@
 #include <fcntl.h>
 #include <linux/limits.h>
 #include <regex.h>
+#include <stddef.h>
 #include <sys/stat.h>
 #include <sys/timerfd.h>
 #include <sys/types.h>
 #include <unistd.h>
 #include <string.h>
+#include <lz4.h>
 #include <rocksdb/c.h>
 
 #include "niova/alloc.h"
@@ -44,6 +46,14 @@ enum raft_net_lreg_values
     RAFT_NET_LREG_LOG_REAP_FACTOR,    // uint32
     RAFT_NET_LREG_NUM_CHECKPOINTS,
     RAFT_NET_LREG_AUTO_CHECKPOINT,
+    RAFT_NET_LREG_NUM_READ_THREADS,   // uint64
+    RAFT_NET_LREG_SM_APPLY_PREFETCH_DEPTH, // uint64
+    RAFT_NET_LREG_UDP_MMSG_BATCH,     // uint64
+    RAFT_NET_LREG_RPC_MSG_VERSION_MAX, // uint32
+    RAFT_NET_LREG_AE_COMPRESS,        // string
+    RAFT_NET_LREG_AE_COMPRESS_MIN_SIZE, // uint64
+    RAFT_NET_LREG_STARTUP_SCAN_CRC_THREADS, // uint64
+    RAFT_NET_LREG_BULK_RECOVERY_BW_LIMIT, // uint64
     RAFT_NET_LREG__MAX,
     RAFT_NET_LREG__CLIENT_MAX = RAFT_NET_LREG_IGNORE_TIMER_EVENTS + 1,
 };
@@ -59,13 +69,100 @@ enum raft_net_recovery_lreg_values
     RAFT_NET_RECOVERY_LREG_RATE,
     RAFT_NET_RECOVERY_LREG_INCOMPLETE,
     RAFT_NET_RECOVERY_LREG_START_TIME,
+    RAFT_NET_RECOVERY_LREG_NUM_FILES,
+    RAFT_NET_RECOVERY_LREG_CHUNKS_XFERRED,
+    RAFT_NET_RECOVERY_LREG_CHUNKS_RESUMED,
+    RAFT_NET_RECOVERY_LREG_CHUNK_CRC_ERRORS,
+    RAFT_NET_RECOVERY_LREG_XFER_ATTEMPTS,
     RAFT_NET_RECOVERY_LREG__MAX,
     RAFT_NET_RECOVERY_LREG__NONE = 0,
 };
 
-struct raft_instance raftInstance = {
 //    .ri_store_type = RAFT_INSTANCE_STORE_ROCKSDB,
-    .ri_store_type = RAFT_INSTANCE_STORE_POSIX_FLAT_FILE,
+#define RAFT_NET_INSTANCE_DEFAULTS                                      \
+    .ri_store_type = RAFT_INSTANCE_STORE_POSIX_FLAT_FILE,               \
+    .ri_num_read_threads = RAFT_NUM_READ_THREADS_DEFAULT,               \
+    .ri_sm_apply_prefetch_depth = RAFT_SM_APPLY_PREFETCH_DEFAULT,       \
+    .ri_udp_mmsg_batch = RAFT_NET_UDP_MMSG_BATCH_DEFAULT,               \
+    .ri_rpc_msg_version_max = RAFT_RPC_MSG_VERSION_MAX,                 \
+    .ri_ae_compress_type = RAFT_AE_COMPRESS_NONE,                       \
+    .ri_ae_compress_min_size = RAFT_NET_AE_COMPRESS_MIN_SIZE_DEFAULT
+
+struct raft_instance raftInstance = {
+    RAFT_NET_INSTANCE_DEFAULTS,
+};
+
+static const struct raft_instance raftInstanceDefaults = {
+    RAFT_NET_INSTANCE_DEFAULTS,
+};
+
+#define RAFT_NET_HOST_MAX     256
+#define RAFT_NET_HOST_UDP_MAX 64
+#define RAFT_NET_HOST_TCP_MAX 64
+#define RAFT_NET_HOST_HB_MAX  64
+#define RAFT_NET_HOST_HB_SZ   8192
+
+/* A udp listen socket shared by all hosted instances which listen on the
+ * same address.  Incoming msgs are handed to the instance named by the
+ * msg's raft uuid.
+ */
+struct raft_net_host_udp_listener
+{
+    struct udp_socket_handle     rnhul_ush;
+    struct epoll_handle          rnhul_eph;
+    enum raft_udp_listen_sockets rnhul_type;
+    int                          rnhul_refcnt;
+};
+
+/* A tcp listener shared in the same manner.  Accepted connections are
+ * handed, by the raft uuid in their handshake, to the tcp_mgr of the
+ * instance which serves the raft.
+ */
+struct raft_net_host_tcp_listener
+{
+    struct tcp_mgr_instance      rnhtl_tmi;
+    char                         rnhtl_ipaddr[IPV4_STRLEN];
+    int                          rnhtl_port;
+    enum raft_udp_listen_sockets rnhtl_type;
+    int                          rnhtl_refcnt;
+};
+
+/* The heartbeats which the hosted instances send to one peer address during
+ * a pass of the host's event loop.  These are sent as a single datagram when
+ * the pass completes.
+ */
+struct raft_net_host_hb_batch
+{
+    struct sockaddr_in rnhhb_dest;
+    int                rnhhb_fd;
+    size_t             rnhhb_len;
+    size_t             rnhhb_nmsgs;
+    char               WORD_ALIGN_MEMBER(rnhhb_buf[RAFT_NET_HOST_HB_SZ]);
+};
+
+/* The multi-instance host.  Hosted instances register their timerfds and
+ * tcp sockets with the host's epoll_mgr rather than their own.  The
+ * registry is only modified from the thread which runs the host's event
+ * loop.  Slot 0 is always occupied by the default instance.
+ */
+struct raft_net_host
+{
+    bool                              rnh_active;
+    struct epoll_mgr                  rnh_epm;
+    struct raft_instance             *rnh_instances[RAFT_NET_HOST_MAX];
+    struct raft_net_host_udp_listener rnh_udp_listeners[RAFT_NET_HOST_UDP_MAX];
+    struct raft_net_host_tcp_listener rnh_tcp_listeners[RAFT_NET_HOST_TCP_MAX];
+    struct raft_net_host_hb_batch     rnh_hb_batches[RAFT_NET_HOST_HB_MAX];
+    size_t                            rnh_hb_nbatches;
+};
+
+static struct raft_net_host raftNetHost = {
+    .rnh_instances[0] = &raftInstance,
+};
+
+static const char *raftNetAeCompressTypeNames[RAFT_AE_COMPRESS_MAX] = {
+    [RAFT_AE_COMPRESS_NONE] = "none",
+    [RAFT_AE_COMPRESS_LZ4] = "lz4",
 };
 
 static regex_t raftNetRncuiRegex;
@@ -83,28 +180,166 @@ raft_net_recovery_lreg_multi_facet_cb(enum lreg_node_cb_ops,
 struct raft_instance *
 raft_net_get_instance(void)
 {
-    // Xxx this needs to become more flexible so that more than 1 instance
-    //      may be serviced by a single process
+    // Additional instances are obtained with raft_net_instance_alloc()
     return &raftInstance;
 }
 
+/**
+ * raft_net_instance_alloc - allocate and register an additional raft
+ *    instance which is initialized with the same defaults as the static
+ *    instance.  Returns NULL if the registry is full or on ENOMEM.
+ */
+struct raft_instance *
+raft_net_instance_alloc(void)
+{
+    size_t slot;
+
+    for (slot = 0; slot < RAFT_NET_HOST_MAX; slot++)
+        if (!raftNetHost.rnh_instances[slot])
+            break;
+
+    if (slot == RAFT_NET_HOST_MAX)
+        return NULL;
+
+    struct raft_instance *ri =
+        niova_malloc_can_fail(sizeof(struct raft_instance));
+    if (!ri)
+        return NULL;
+
+    // ri_max_entry_size is const so the defaults may not be assigned
+    memcpy(ri, &raftInstanceDefaults, sizeof(struct raft_instance));
+
+    raftNetHost.rnh_instances[slot] = ri;
+
+    return ri;
+}
+
+void
+raft_net_instance_free(struct raft_instance *ri)
+{
+    if (!ri || ri == &raftInstance)
+        return;
+
+    for (size_t i = 0; i < RAFT_NET_HOST_MAX; i++)
+    {
+        if (raftNetHost.rnh_instances[i] == ri)
+        {
+            raftNetHost.rnh_instances[i] = NULL;
+            niova_free(ri);
+            return;
+        }
+    }
+
+    NIOVA_ASSERT(0); // 'ri' was not obtained from raft_net_instance_alloc()
+}
+
+/**
+ * raft_net_instance_lookup - find the registered instance which serves
+ *    'raft_uuid'.  Instances which have not yet loaded their config are
+ *    skipped.
+ */
+struct raft_instance *
+raft_net_instance_lookup(const uuid_t raft_uuid)
+{
+    for (size_t i = 0; i < RAFT_NET_HOST_MAX; i++)
+    {
+        struct raft_instance *ri = raftNetHost.rnh_instances[i];
+
+        if (ri && ri->ri_csn_raft &&
+            !ctl_svc_node_compare_uuid(ri->ri_csn_raft, raft_uuid))
+            return ri;
+    }
+
+    return NULL;
+}
+
+static struct epoll_mgr *
+raft_net_epoll_mgr(struct raft_instance *ri)
+{
+    return ri->ri_hosted ? &raftNetHost.rnh_epm : &ri->ri_epoll_mgr;
+}
+
+int
+raft_net_host_setup(void)
+{
+    if (raftNetHost.rnh_active)
+        return -EALREADY;
+
+    int rc = epoll_mgr_setup(&raftNetHost.rnh_epm);
+    if (!rc)
+        raftNetHost.rnh_active = true;
+
+    return rc;
+}
+
+int
+raft_net_host_destroy(void)
+{
+    if (!raftNetHost.rnh_active)
+        return -EALREADY;
+
+    for (size_t i = 0; i < RAFT_NET_HOST_UDP_MAX; i++)
+        NIOVA_ASSERT(!raftNetHost.rnh_udp_listeners[i].rnhul_refcnt);
+
+    for (size_t i = 0; i < RAFT_NET_HOST_TCP_MAX; i++)
+        NIOVA_ASSERT(!raftNetHost.rnh_tcp_listeners[i].rnhtl_refcnt);
+
+    raftNetHost.rnh_hb_nbatches = 0;
+
+    raftNetHost.rnh_active = false;
+
+    return epoll_mgr_close(&raftNetHost.rnh_epm);
+}
+
+static void
+raft_net_host_hb_flush(void);
+
+/**
+ * raft_net_host_epoll_wait - run one pass of the host's event loop.  The
+ *    heartbeats which the hosted instances issued during the pass are sent
+ *    once it completes.
+ */
+int
+raft_net_host_epoll_wait(int timeout_ms)
+{
+    if (!raftNetHost.rnh_active)
+        return -ESHUTDOWN;
+
+    int rc = epoll_mgr_wait_and_process_events(&raftNetHost.rnh_epm,
+                                               timeout_ms);
+
+    raft_net_host_hb_flush();
+
+    return rc == -EINTR ? 0 : rc;
+}
+
 static unsigned int
-raft_net_lreg_num_keys(void)
+raft_net_lreg_instance_num_keys(const struct raft_instance *ri)
 {
-    return raft_instance_is_client(raft_net_get_instance()) ?
+    return raft_instance_is_client(ri) ?
         RAFT_NET_LREG__CLIENT_MAX : RAFT_NET_LREG__MAX;
 }
 
 static unsigned int
-raft_net_lreg_recovery_num_keys(void)
+raft_net_lreg_recovery_instance_num_keys(const struct raft_instance *ri)
 {
-    const struct raft_instance *ri = raft_net_get_instance();
-
     return (!raft_instance_is_client(ri) &&
             (ri->ri_needs_bulk_recovery || ri->ri_successful_recovery)) ?
         RAFT_NET_RECOVERY_LREG__MAX : RAFT_NET_RECOVERY_LREG__NONE;
 }
 
+static unsigned int
+raft_net_lreg_num_keys(void)
+{
+    return raft_net_lreg_instance_num_keys(raft_net_get_instance());
+}
+
+static unsigned int
+raft_net_lreg_recovery_num_keys(void)
+{
+    return raft_net_lreg_recovery_instance_num_keys(raft_net_get_instance());
+}
+
 LREG_ROOT_ENTRY_GENERATE_OBJECT(raft_net_info, LREG_USER_TYPE_RAFT_NET,
                                 raft_net_lreg_num_keys(),
                                 raft_net_lreg_multi_facet_cb, NULL,
@@ -344,95 +579,458 @@ raft_net_lreg_set_num_checkpoints(struct raft_instance *ri,
     return 0;
 }
 
-static util_thread_ctx_reg_int_t
-raft_net_recovery_lreg_multi_facet_cb(enum lreg_node_cb_ops op,
-                                      struct lreg_value *lv, void *arg)
+/**
+ * raft_net_set_num_read_threads - sets the number of worker threads which
+ *    service client read requests.  A value of '0', the default, causes reads
+ *    to be processed in the net receive context.  Workers should only be
+ *    enabled for state machines whose read handler meets the requirements
+ *    listed above raft_sm_request_handler_t.  The value is applied at startup.
+ */
+void
+raft_net_set_num_read_threads(struct raft_instance *ri, size_t nthreads)
+{
+    NIOVA_ASSERT(ri);
+
+    ri->ri_num_read_threads = MIN(nthreads, RAFT_NUM_READ_THREADS);
+
+    SIMPLE_LOG_MSG(LL_WARN, "num_read_threads=%zu", ri->ri_num_read_threads);
+}
+
+static int
+raft_net_lreg_set_num_read_threads(struct raft_instance *ri,
+                                   const struct lreg_value *lv)
 {
-    if (arg)
+    if (!ri || !lv || LREG_VALUE_TO_REQ_TYPE_IN(lv) != LREG_VAL_TYPE_STRING)
         return -EINVAL;
 
-    else if (lv->lrv_value_idx_in >= RAFT_NET_RECOVERY_LREG__MAX)
-        return -ERANGE;
+    size_t nthreads = RAFT_NUM_READ_THREADS_DEFAULT;
 
-    struct raft_instance *ri = raft_net_get_instance();
+    if (strncmp(LREG_VALUE_TO_IN_STR(lv), "default", 7))
+    {
+        unsigned long long tmp = 0;
+        int rc =
+            niova_string_to_unsigned_long_long(LREG_VALUE_TO_IN_STR(lv), &tmp);
+
+        if (rc)
+            return rc;
+
+        nthreads = tmp;
+    }
+
+    raft_net_set_num_read_threads(ri, nthreads);
+
+    return 0;
+}
+
+/**
+ * raft_net_set_sm_apply_prefetch_depth - sets the number of committed entries
+ *    which may be read ahead of the state machine apply.  A value of '0'
+ *    disables the prefetch thread.  The value is applied at startup.
+ */
+void
+raft_net_set_sm_apply_prefetch_depth(struct raft_instance *ri, size_t depth)
+{
     NIOVA_ASSERT(ri);
 
-    struct raft_recovery_handle *rrh = &ri->ri_recovery_handle;
-    int rc = 0;
+    ri->ri_sm_apply_prefetch_depth = MIN(depth, RAFT_SM_APPLY_PREFETCH_MAX);
 
-    switch (op)
+    SIMPLE_LOG_MSG(LL_WARN, "sm_apply_prefetch_depth=%zu",
+                   ri->ri_sm_apply_prefetch_depth);
+}
+
+static int
+raft_net_lreg_set_sm_apply_prefetch_depth(struct raft_instance *ri,
+                                          const struct lreg_value *lv)
+{
+    if (!ri || !lv || LREG_VALUE_TO_REQ_TYPE_IN(lv) != LREG_VAL_TYPE_STRING)
+        return -EINVAL;
+
+    size_t depth = RAFT_SM_APPLY_PREFETCH_DEFAULT;
+
+    if (strncmp(LREG_VALUE_TO_IN_STR(lv), "default", 7))
     {
-    case LREG_NODE_CB_OP_READ_VAL:
-        switch (lv->lrv_value_idx_in)
-        {
-        case RAFT_NET_RECOVERY_LREG_PEER_UUID:
-            lreg_value_fill_string_uuid(lv, "src-uuid", rrh->rrh_peer_uuid);
-            break;
-        case RAFT_NET_RECOVERY_LREG_DB_UUID:
-            lreg_value_fill_string_uuid(lv, "db-uuid", rrh->rrh_peer_db_uuid);
-            break;
-        case RAFT_NET_RECOVERY_LREG_CHKPT_IDX:
-            lreg_value_fill_signed(lv, "chkpt-idx", rrh->rrh_peer_chkpt_idx);
-            break;
-        case RAFT_NET_RECOVERY_LREG_CHKPT_SIZE:
-            lreg_value_fill_signed(lv, "chkpt-size", rrh->rrh_chkpt_size);
-            break;
-        case RAFT_NET_RECOVERY_LREG_REMAINING:
-            lreg_value_fill_signed(lv, "total-bytes-to-xfer",
-                                   rrh->rrh_remaining);
-            break;
-        case RAFT_NET_RECOVERY_LREG_COMPLETED:
-            lreg_value_fill_signed(lv, "xfer-completed", rrh->rrh_completed);
-            break;
-        case RAFT_NET_RECOVERY_LREG_INCOMPLETE:
-            lreg_value_fill_bool(lv, "resume-incomplete",
-                                 ri->ri_incomplete_recovery);
-            break;
-        case RAFT_NET_RECOVERY_LREG_START_TIME:
-            lreg_value_fill_string_time(lv, "start-time",
-                                        rrh->rrh_start.tv_sec);
-            break;
-        case RAFT_NET_RECOVERY_LREG_RATE:
-            lreg_value_fill_string(lv, "rate", rrh->rrh_rate_bytes_per_sec);
-            break;
-        default:
-            rc = -EOPNOTSUPP;
-            break;
-        }
-        break;
-    default:
-        rc = -EOPNOTSUPP;
-        break;
+        unsigned long long tmp = 0;
+        int rc =
+            niova_string_to_unsigned_long_long(LREG_VALUE_TO_IN_STR(lv), &tmp);
+
+        if (rc)
+            return rc;
+
+        depth = tmp;
     }
 
-    return rc;
+    raft_net_set_sm_apply_prefetch_depth(ri, depth);
+
+    return 0;
 }
 
-static util_thread_ctx_reg_int_t
-raft_net_lreg_multi_facet_cb(enum lreg_node_cb_ops op, struct lreg_value *lv,
-                             void *arg)
+/**
+ * raft_net_set_udp_mmsg_batch - sets the maximum number of datagrams which
+ *    are received or sent with a single recvmmsg() or sendmmsg() call.  A
+ *    value of '0' or '1' selects one syscall per datagram.
+ */
+void
+raft_net_set_udp_mmsg_batch(struct raft_instance *ri, size_t batch)
+{
+    NIOVA_ASSERT(ri);
+
+    ri->ri_udp_mmsg_batch = MIN(batch, RAFT_NET_UDP_MMSG_BATCH_MAX);
+
+    SIMPLE_LOG_MSG(LL_WARN, "udp_mmsg_batch=%zu", ri->ri_udp_mmsg_batch);
+}
+
+static int
+raft_net_lreg_set_udp_mmsg_batch(struct raft_instance *ri,
+                                 const struct lreg_value *lv)
 {
-    if (arg)
+    if (!ri || !lv || LREG_VALUE_TO_REQ_TYPE_IN(lv) != LREG_VAL_TYPE_STRING)
         return -EINVAL;
 
-    else if (lv->lrv_value_idx_in >= RAFT_NET_LREG__MAX)
-        return -ERANGE;
+    size_t batch = RAFT_NET_UDP_MMSG_BATCH_DEFAULT;
+
+    if (strncmp(LREG_VALUE_TO_IN_STR(lv), "default", 7))
+    {
+        unsigned long long tmp = 0;
+        int rc =
+            niova_string_to_unsigned_long_long(LREG_VALUE_TO_IN_STR(lv), &tmp);
+
+        if (rc)
+            return rc;
+
+        batch = tmp;
+    }
+
+    raft_net_set_udp_mmsg_batch(ri, batch);
+
+    return 0;
+}
 
-    struct raft_instance *ri = raft_net_get_instance();
+/**
+ * raft_net_set_rpc_msg_version_max - sets the highest server rpc msg version
+ *    which this peer advertises and sends.  '0' restricts the peer to the
+ *    version 0 format.
+ */
+void
+raft_net_set_rpc_msg_version_max(struct raft_instance *ri, size_t version)
+{
     NIOVA_ASSERT(ri);
 
-    int rc = 0;
-    bool tmp_bool = false;
+    ri->ri_rpc_msg_version_max = MIN(version, RAFT_RPC_MSG_VERSION_MAX);
 
-    switch (op)
-    {
-    case LREG_NODE_CB_OP_READ_VAL:
-        switch (lv->lrv_value_idx_in)
-        {
-        case RAFT_NET_LREG_IGNORE_TIMER_EVENTS:
-            lreg_value_fill_bool(lv, "ignore_timer_events",
-                                 ri->ri_ignore_timerfd ? true : false);
-            break;
+    SIMPLE_LOG_MSG(LL_WARN, "rpc_msg_version_max=%hu",
+                   ri->ri_rpc_msg_version_max);
+}
+
+static int
+raft_net_lreg_set_rpc_msg_version_max(struct raft_instance *ri,
+                                      const struct lreg_value *lv)
+{
+    if (!ri || !lv || LREG_VALUE_TO_REQ_TYPE_IN(lv) != LREG_VAL_TYPE_STRING)
+        return -EINVAL;
+
+    size_t version = RAFT_RPC_MSG_VERSION_MAX;
+
+    if (strncmp(LREG_VALUE_TO_IN_STR(lv), "default", 7))
+    {
+        unsigned long long tmp = 0;
+        int rc =
+            niova_string_to_unsigned_long_long(LREG_VALUE_TO_IN_STR(lv), &tmp);
+
+        if (rc)
+            return rc;
+
+        version = tmp;
+    }
+
+    raft_net_set_rpc_msg_version_max(ri, version);
+
+    return 0;
+}
+
+/**
+ * raft_net_set_ae_compress_type - selects the codec which the leader applies
+ *    to AE requests sent over TCP.  Followers which do not decode the codec
+ *    receive uncompressed requests.
+ */
+void
+raft_net_set_ae_compress_type(struct raft_instance *ri, int type)
+{
+    NIOVA_ASSERT(ri);
+
+    ri->ri_ae_compress_type =
+        (type > RAFT_AE_COMPRESS_NONE && type < RAFT_AE_COMPRESS_MAX) ?
+        type : RAFT_AE_COMPRESS_NONE;
+
+    SIMPLE_LOG_MSG(LL_WARN, "ae_compress=%s",
+                   raftNetAeCompressTypeNames[ri->ri_ae_compress_type]);
+}
+
+static int
+raft_net_lreg_set_ae_compress_type(struct raft_instance *ri,
+                                   const struct lreg_value *lv)
+{
+    if (!ri || !lv || LREG_VALUE_TO_REQ_TYPE_IN(lv) != LREG_VAL_TYPE_STRING)
+        return -EINVAL;
+
+    if (!strncmp(LREG_VALUE_TO_IN_STR(lv), "default", 7))
+    {
+        raft_net_set_ae_compress_type(ri, RAFT_AE_COMPRESS_NONE);
+        return 0;
+    }
+
+    for (int i = 0; i < RAFT_AE_COMPRESS_MAX; i++)
+    {
+        if (!strcmp(LREG_VALUE_TO_IN_STR(lv), raftNetAeCompressTypeNames[i]))
+        {
+            raft_net_set_ae_compress_type(ri, i);
+            return 0;
+        }
+    }
+
+    return -EINVAL;
+}
+
+/**
+ * raft_net_set_ae_compress_min_size - AE requests whose payload is smaller
+ *    than 'size' bytes are sent uncompressed.
+ */
+void
+raft_net_set_ae_compress_min_size(struct raft_instance *ri, size_t size)
+{
+    NIOVA_ASSERT(ri);
+
+    ri->ri_ae_compress_min_size = size;
+
+    SIMPLE_LOG_MSG(LL_WARN, "ae_compress_min_size=%zu",
+                   ri->ri_ae_compress_min_size);
+}
+
+static int
+raft_net_lreg_set_ae_compress_min_size(struct raft_instance *ri,
+                                       const struct lreg_value *lv)
+{
+    if (!ri || !lv || LREG_VALUE_TO_REQ_TYPE_IN(lv) != LREG_VAL_TYPE_STRING)
+        return -EINVAL;
+
+    size_t size = RAFT_NET_AE_COMPRESS_MIN_SIZE_DEFAULT;
+
+    if (strncmp(LREG_VALUE_TO_IN_STR(lv), "default", 7))
+    {
+        unsigned long long tmp = 0;
+        int rc =
+            niova_string_to_unsigned_long_long(LREG_VALUE_TO_IN_STR(lv), &tmp);
+
+        if (rc)
+            return rc;
+
+        size = tmp;
+    }
+
+    raft_net_set_ae_compress_min_size(ri, size);
+
+    return 0;
+}
+
+/**
+ * raft_net_recovery_lreg_multi_facet_cb - 'arg' is NULL for the root object,
+ *    which serves the default instance, or the hosted instance which owns
+ *    the inlined object.
+ */
+static util_thread_ctx_reg_int_t
+raft_net_recovery_lreg_multi_facet_cb(enum lreg_node_cb_ops op,
+                                      struct lreg_value *lv, void *arg)
+{
+    if (lv->lrv_value_idx_in >= RAFT_NET_RECOVERY_LREG__MAX)
+        return -ERANGE;
+
+    struct raft_instance *ri = arg ? (struct raft_instance *)arg :
+        raft_net_get_instance();
+    NIOVA_ASSERT(ri);
+
+    struct raft_recovery_handle *rrh = &ri->ri_recovery_handle;
+    int rc = 0;
+
+    switch (op)
+    {
+    case LREG_NODE_CB_OP_READ_VAL:
+        switch (lv->lrv_value_idx_in)
+        {
+        case RAFT_NET_RECOVERY_LREG_PEER_UUID:
+            lreg_value_fill_string_uuid(lv, "src-uuid", rrh->rrh_peer_uuid);
+            break;
+        case RAFT_NET_RECOVERY_LREG_DB_UUID:
+            lreg_value_fill_string_uuid(lv, "db-uuid", rrh->rrh_peer_db_uuid);
+            break;
+        case RAFT_NET_RECOVERY_LREG_CHKPT_IDX:
+            lreg_value_fill_signed(lv, "chkpt-idx", rrh->rrh_peer_chkpt_idx);
+            break;
+        case RAFT_NET_RECOVERY_LREG_CHKPT_SIZE:
+            lreg_value_fill_signed(lv, "chkpt-size", rrh->rrh_chkpt_size);
+            break;
+        case RAFT_NET_RECOVERY_LREG_REMAINING:
+            lreg_value_fill_signed(lv, "total-bytes-to-xfer",
+                                   rrh->rrh_remaining);
+            break;
+        case RAFT_NET_RECOVERY_LREG_COMPLETED:
+            lreg_value_fill_signed(lv, "xfer-completed", rrh->rrh_completed);
+            break;
+        case RAFT_NET_RECOVERY_LREG_INCOMPLETE:
+            lreg_value_fill_bool(lv, "resume-incomplete",
+                                 ri->ri_incomplete_recovery);
+            break;
+        case RAFT_NET_RECOVERY_LREG_START_TIME:
+            lreg_value_fill_string_time(lv, "start-time",
+                                        rrh->rrh_start.tv_sec);
+            break;
+        case RAFT_NET_RECOVERY_LREG_RATE:
+            lreg_value_fill_string(lv, "rate", rrh->rrh_rate_bytes_per_sec);
+            break;
+        case RAFT_NET_RECOVERY_LREG_NUM_FILES:
+            lreg_value_fill_unsigned(lv, "num-files", rrh->rrh_nfiles);
+            break;
+        case RAFT_NET_RECOVERY_LREG_CHUNKS_XFERRED:
+            lreg_value_fill_unsigned(lv, "chunks-xferred",
+                                     rrh->rrh_chunks_xferred);
+            break;
+        case RAFT_NET_RECOVERY_LREG_CHUNKS_RESUMED:
+            lreg_value_fill_unsigned(lv, "chunks-resumed",
+                                     rrh->rrh_chunks_resumed);
+            break;
+        case RAFT_NET_RECOVERY_LREG_CHUNK_CRC_ERRORS:
+            lreg_value_fill_unsigned(lv, "chunk-crc-errors",
+                                     rrh->rrh_chunk_crc_errors);
+            break;
+        case RAFT_NET_RECOVERY_LREG_XFER_ATTEMPTS:
+            lreg_value_fill_unsigned(lv, "xfer-attempts",
+                                     rrh->rrh_xfer_attempts);
+            break;
+        default:
+            rc = -EOPNOTSUPP;
+            break;
+        }
+        break;
+    default:
+        rc = -EOPNOTSUPP;
+        break;
+    }
+
+    return rc;
+}
+
+/**
+ * raft_net_set_startup_scan_crc_threads - sets the number of worker threads
+ *    which verify the CRCs of the entries read by the startup log scan.  A
+ *    value of '0' limits the scan to the entry headers.  The value is applied
+ *    at startup.
+ */
+void
+raft_net_set_startup_scan_crc_threads(struct raft_instance *ri,
+                                      size_t nthreads)
+{
+    NIOVA_ASSERT(ri);
+
+    ri->ri_startup_scan_crc_threads =
+        MIN(nthreads, RAFT_STARTUP_SCAN_CRC_THREADS_MAX);
+
+    SIMPLE_LOG_MSG(LL_WARN, "startup_scan_crc_threads=%zu",
+                   ri->ri_startup_scan_crc_threads);
+}
+
+static int
+raft_net_lreg_set_startup_scan_crc_threads(struct raft_instance *ri,
+                                           const struct lreg_value *lv)
+{
+    if (!ri || !lv || LREG_VALUE_TO_REQ_TYPE_IN(lv) != LREG_VAL_TYPE_STRING)
+        return -EINVAL;
+
+    size_t nthreads = 0;
+
+    if (strncmp(LREG_VALUE_TO_IN_STR(lv), "default", 7))
+    {
+        unsigned long long tmp = 0;
+        int rc =
+            niova_string_to_unsigned_long_long(LREG_VALUE_TO_IN_STR(lv), &tmp);
+
+        if (rc)
+            return rc;
+
+        nthreads = tmp;
+    }
+
+    raft_net_set_startup_scan_crc_threads(ri, nthreads);
+
+    return 0;
+}
+
+/**
+ * raft_net_set_bulk_recovery_bw_limit - caps the rate at which checkpoint
+ *    data is received during bulk recovery.  A value of '0' removes the cap.
+ */
+void
+raft_net_set_bulk_recovery_bw_limit(struct raft_instance *ri,
+                                    size_t bytes_per_sec)
+{
+    NIOVA_ASSERT(ri);
+
+    ri->ri_bulk_recovery_bw_limit = bytes_per_sec;
+
+    SIMPLE_LOG_MSG(LL_WARN, "bulk_recovery_bw_limit=%zu",
+                   ri->ri_bulk_recovery_bw_limit);
+}
+
+static int
+raft_net_lreg_set_bulk_recovery_bw_limit(struct raft_instance *ri,
+                                         const struct lreg_value *lv)
+{
+    if (!ri || !lv || LREG_VALUE_TO_REQ_TYPE_IN(lv) != LREG_VAL_TYPE_STRING)
+        return -EINVAL;
+
+    size_t bytes_per_sec = 0;
+
+    if (strncmp(LREG_VALUE_TO_IN_STR(lv), "default", 7))
+    {
+        unsigned long long tmp = 0;
+        int rc =
+            niova_string_to_unsigned_long_long(LREG_VALUE_TO_IN_STR(lv), &tmp);
+
+        if (rc)
+            return rc;
+
+        bytes_per_sec = tmp;
+    }
+
+    raft_net_set_bulk_recovery_bw_limit(ri, bytes_per_sec);
+
+    return 0;
+}
+
+/**
+ * raft_net_lreg_multi_facet_cb - as with the recovery object, a NULL 'arg'
+ *    selects the default instance.
+ */
+static util_thread_ctx_reg_int_t
+raft_net_lreg_multi_facet_cb(enum lreg_node_cb_ops op, struct lreg_value *lv,
+                             void *arg)
+{
+    if (lv->lrv_value_idx_in >= RAFT_NET_LREG__MAX)
+        return -ERANGE;
+
+    struct raft_instance *ri = arg ? (struct raft_instance *)arg :
+        raft_net_get_instance();
+    NIOVA_ASSERT(ri);
+
+    int rc = 0;
+    bool tmp_bool = false;
+
+    switch (op)
+    {
+    case LREG_NODE_CB_OP_READ_VAL:
+        switch (lv->lrv_value_idx_in)
+        {
+        case RAFT_NET_LREG_IGNORE_TIMER_EVENTS:
+            lreg_value_fill_bool(lv, "ignore_timer_events",
+                                 ri->ri_ignore_timerfd ? true : false);
+            break;
         case RAFT_NET_LREG_ELECTION_TIMEOUT_MS:
             lreg_value_fill_unsigned(lv, "election-timeout-ms",
                                      ri->ri_election_timeout_max_ms);
@@ -457,6 +1055,39 @@ raft_net_lreg_multi_facet_cb(enum lreg_node_cb_ops op, struct lreg_value *lv,
             lreg_value_fill_bool(lv, "auto-checkpoint-enabled",
                                  ri->ri_auto_checkpoints_enabled);
             break;
+        case RAFT_NET_LREG_NUM_READ_THREADS:
+            lreg_value_fill_unsigned(lv, "num-read-threads",
+                                     ri->ri_num_read_threads);
+            break;
+        case RAFT_NET_LREG_SM_APPLY_PREFETCH_DEPTH:
+            lreg_value_fill_unsigned(lv, "sm-apply-prefetch-depth",
+                                     ri->ri_sm_apply_prefetch_depth);
+            break;
+        case RAFT_NET_LREG_UDP_MMSG_BATCH:
+            lreg_value_fill_unsigned(lv, "udp-mmsg-batch",
+                                     ri->ri_udp_mmsg_batch);
+            break;
+        case RAFT_NET_LREG_RPC_MSG_VERSION_MAX:
+            lreg_value_fill_unsigned(lv, "rpc-msg-version-max",
+                                     ri->ri_rpc_msg_version_max);
+            break;
+        case RAFT_NET_LREG_AE_COMPRESS:
+            lreg_value_fill_string(
+                lv, "ae-compress",
+                raftNetAeCompressTypeNames[ri->ri_ae_compress_type]);
+            break;
+        case RAFT_NET_LREG_AE_COMPRESS_MIN_SIZE:
+            lreg_value_fill_unsigned(lv, "ae-compress-min-size",
+                                     ri->ri_ae_compress_min_size);
+            break;
+        case RAFT_NET_LREG_STARTUP_SCAN_CRC_THREADS:
+            lreg_value_fill_unsigned(lv, "startup-scan-crc-threads",
+                                     ri->ri_startup_scan_crc_threads);
+            break;
+        case RAFT_NET_LREG_BULK_RECOVERY_BW_LIMIT:
+            lreg_value_fill_unsigned(lv, "bulk-recovery-bw-limit",
+                                     ri->ri_bulk_recovery_bw_limit);
+            break;
         default:
             rc = -ENOENT;
             break;
@@ -498,6 +1129,30 @@ raft_net_lreg_multi_facet_cb(enum lreg_node_cb_ops op, struct lreg_value *lv,
         case RAFT_NET_LREG_NUM_CHECKPOINTS:
             rc = raft_net_lreg_set_num_checkpoints(ri, lv);
             break;
+        case RAFT_NET_LREG_NUM_READ_THREADS:
+            rc = raft_net_lreg_set_num_read_threads(ri, lv);
+            break;
+        case RAFT_NET_LREG_SM_APPLY_PREFETCH_DEPTH:
+            rc = raft_net_lreg_set_sm_apply_prefetch_depth(ri, lv);
+            break;
+        case RAFT_NET_LREG_UDP_MMSG_BATCH:
+            rc = raft_net_lreg_set_udp_mmsg_batch(ri, lv);
+            break;
+        case RAFT_NET_LREG_RPC_MSG_VERSION_MAX:
+            rc = raft_net_lreg_set_rpc_msg_version_max(ri, lv);
+            break;
+        case RAFT_NET_LREG_AE_COMPRESS:
+            rc = raft_net_lreg_set_ae_compress_type(ri, lv);
+            break;
+        case RAFT_NET_LREG_AE_COMPRESS_MIN_SIZE:
+            rc = raft_net_lreg_set_ae_compress_min_size(ri, lv);
+            break;
+        case RAFT_NET_LREG_STARTUP_SCAN_CRC_THREADS:
+            rc = raft_net_lreg_set_startup_scan_crc_threads(ri, lv);
+            break;
+        case RAFT_NET_LREG_BULK_RECOVERY_BW_LIMIT:
+            rc = raft_net_lreg_set_bulk_recovery_bw_limit(ri, lv);
+            break;
         default:
             rc = -EPERM;
             break;
@@ -511,6 +1166,93 @@ raft_net_lreg_multi_facet_cb(enum lreg_node_cb_ops op, struct lreg_value *lv,
     return rc;
 }
 
+static util_thread_ctx_reg_int_t
+raft_net_instance_lreg_cb_common(enum lreg_node_cb_ops op,
+                                 struct lreg_node *lrn, struct lreg_value *lv,
+                                 const bool recovery)
+{
+    struct raft_instance *ri = lrn->lrn_cb_arg;
+    if (!ri)
+        return -EINVAL;
+
+    if (lv)
+        lv->get.lrv_num_keys_out = recovery ?
+            raft_net_lreg_recovery_instance_num_keys(ri) :
+            raft_net_lreg_instance_num_keys(ri);
+
+    switch (op)
+    {
+    case LREG_NODE_CB_OP_GET_NAME:
+        if (!lv)
+            return -EINVAL;
+
+        lreg_value_fill_key_and_type(
+            lv, recovery ? "raft_net_bulk_recovery_info" : "raft_net_info",
+            LREG_VAL_TYPE_OBJECT);
+        break;
+
+    case LREG_NODE_CB_OP_READ_VAL:
+    case LREG_NODE_CB_OP_WRITE_VAL: //fall through
+        if (!lv)
+            return -EINVAL;
+
+        return recovery ? raft_net_recovery_lreg_multi_facet_cb(op, lv, ri) :
+            raft_net_lreg_multi_facet_cb(op, lv, ri);
+
+    case LREG_NODE_CB_OP_INSTALL_NODE:
+    case LREG_NODE_CB_OP_DESTROY_NODE:
+        break;
+
+    default:
+        return -ENOENT;
+    }
+
+    return 0;
+}
+
+static util_thread_ctx_reg_int_t
+raft_net_instance_lreg_cb(enum lreg_node_cb_ops op, struct lreg_node *lrn,
+                          struct lreg_value *lv)
+{
+    return raft_net_instance_lreg_cb_common(op, lrn, lv, false);
+}
+
+static util_thread_ctx_reg_int_t
+raft_net_instance_recovery_lreg_cb(enum lreg_node_cb_ops op,
+                                   struct lreg_node *lrn,
+                                   struct lreg_value *lv)
+{
+    return raft_net_instance_lreg_cb_common(op, lrn, lv, true);
+}
+
+/**
+ * raft_net_instance_lreg_install - install the raft_net objects of 'ri'
+ *    into 'parent' as inlined members.  This is for instances other than
+ *    the default, whose objects are the raft_net root entries.  The members
+ *    are removed along with 'parent'.
+ */
+int
+raft_net_instance_lreg_install(struct raft_instance *ri,
+                               struct lreg_node *parent)
+{
+    if (!ri || !parent || ri == raft_net_get_instance())
+        return -EINVAL;
+
+    lreg_node_init(&ri->ri_net_lreg, LREG_USER_TYPE_RAFT_NET,
+                   raft_net_instance_lreg_cb, (void *)ri,
+                   LREG_INIT_OPT_INLINED_MEMBER);
+
+    lreg_node_init(&ri->ri_net_recovery_lreg,
+                   LREG_USER_TYPE_RAFT_RECOVERY_NET,
+                   raft_net_instance_recovery_lreg_cb, (void *)ri,
+                   (LREG_INIT_OPT_IGNORE_NUM_VAL_ZERO |
+                    LREG_INIT_OPT_INLINED_MEMBER));
+
+    int rc = lreg_node_install(&ri->ri_net_lreg, parent);
+
+    return rc ? rc : lreg_node_install(&ri->ri_net_recovery_lreg, parent);
+}
+
 static bool
 raft_net_tcp_disabled(void)
 {
@@ -518,11 +1260,27 @@ raft_net_tcp_disabled(void)
     return (ev && ev->nev_present);
 }
 
+static int
+raft_net_host_tcp_listener_get(struct raft_instance *ri,
+                               enum raft_udp_listen_sockets type,
+                               const char *ipaddr, int port);
+
+static int
+raft_net_host_tcp_listener_put(struct raft_instance *ri,
+                               enum raft_udp_listen_sockets type);
+
 static int
 raft_net_tcp_sockets_close(struct raft_instance *ri)
 {
     if (raft_instance_is_client(ri))
         return tcp_mgr_sockets_close(&ri->ri_client_tcp_mgr);
+    else if (ri->ri_hosted) // hosted instances only use the host's listeners
+    {
+        int rc = raft_net_host_tcp_listener_put(ri, RAFT_UDP_LISTEN_SERVER);
+        int rc2 = raft_net_host_tcp_listener_put(ri, RAFT_UDP_LISTEN_CLIENT);
+
+        return rc ? rc : rc2;
+    }
     else
     {
         int rc = tcp_mgr_sockets_close(&ri->ri_peer_tcp_mgr);
@@ -532,6 +1290,116 @@ raft_net_tcp_sockets_close(struct raft_instance *ri)
     }
 }
 
+static raft_net_cb_ctx_t
+raft_net_host_udp_cb(const struct epoll_handle *, uint32_t);
+
+/**
+ * raft_net_host_udp_listener_get - attach a hosted instance to the shared
+ *    listener for the address in ri->ri_ush[type].  The listener is created,
+ *    added to the host's epoll set, and bound if no other hosted instance
+ *    uses the address.  The instance's ush receives a copy of the listener's
+ *    handle so that sends from the instance use the shared socket.
+ */
+static int
+raft_net_host_udp_listener_get(struct raft_instance *ri,
+                               enum raft_udp_listen_sockets type)
+{
+    NIOVA_ASSERT(ri && ri->ri_hosted && raftNetHost.rnh_active);
+
+    struct udp_socket_handle *ush = &ri->ri_ush[type];
+    struct raft_net_host_udp_listener *rnhul = NULL;
+
+    for (size_t i = 0; i < RAFT_NET_HOST_UDP_MAX; i++)
+    {
+        struct raft_net_host_udp_listener *tmp =
+            &raftNetHost.rnh_udp_listeners[i];
+
+        if (!tmp->rnhul_refcnt)
+        {
+            if (!rnhul)
+                rnhul = tmp;
+        }
+        else if (tmp->rnhul_type == type &&
+                 tmp->rnhul_ush.ush_port == ush->ush_port &&
+                 !strncmp(tmp->rnhul_ush.ush_ipaddr, ush->ush_ipaddr,
+                          IPV4_STRLEN))
+        {
+            tmp->rnhul_refcnt++;
+            *ush = tmp->rnhul_ush;
+
+            return 0;
+        }
+    }
+
+    if (!rnhul)
+        return -ENOSPC;
+
+    memset(rnhul, 0, sizeof(*rnhul));
+    strncpy(rnhul->rnhul_ush.ush_ipaddr, ush->ush_ipaddr, IPV4_STRLEN);
+    rnhul->rnhul_ush.ush_port = ush->ush_port;
+
+    int rc = udp_socket_setup(&rnhul->rnhul_ush);
+    if (rc)
+        return rc;
+
+    rc = epoll_handle_init(&rnhul->rnhul_eph,
+                           udp_socket_handle_2_sockfd(&rnhul->rnhul_ush),
+                           EPOLLIN, raft_net_host_udp_cb, rnhul, NULL);
+    if (!rc)
+        rc = epoll_handle_add(&raftNetHost.rnh_epm, &rnhul->rnhul_eph);
+
+    if (!rc)
+    {
+        rc = udp_socket_bind(&rnhul->rnhul_ush);
+        if (rc)
+            epoll_handle_del(&raftNetHost.rnh_epm, &rnhul->rnhul_eph);
+    }
+
+    if (rc)
+    {
+        udp_socket_close(&rnhul->rnhul_ush);
+        return rc;
+    }
+
+    rnhul->rnhul_type = type;
+    rnhul->rnhul_refcnt = 1;
+    *ush = rnhul->rnhul_ush;
+
+    return 0;
+}
+
+static int
+raft_net_host_udp_listener_put(struct raft_instance *ri,
+                               enum raft_udp_listen_sockets type)
+{
+    NIOVA_ASSERT(ri && ri->ri_hosted);
+
+    const int fd = udp_socket_handle_2_sockfd(&ri->ri_ush[type]);
+    if (fd < 0)
+        return 0;
+
+    ri->ri_ush[type].ush_socket = -1;
+
+    for (size_t i = 0; i < RAFT_NET_HOST_UDP_MAX; i++)
+    {
+        struct raft_net_host_udp_listener *rnhul =
+            &raftNetHost.rnh_udp_listeners[i];
+
+        if (!rnhul->rnhul_refcnt ||
+            udp_socket_handle_2_sockfd(&rnhul->rnhul_ush) != fd)
+            continue;
+
+        if (--rnhul->rnhul_refcnt)
+            return 0;
+
+        epoll_handle_del(&raftNetHost.rnh_epm, &rnhul->rnhul_eph);
+
+        return udp_socket_close(&rnhul->rnhul_ush);
+    }
+
+    return -ENOENT;
+}
+
 static int
 raft_net_udp_sockets_close(struct raft_instance *ri)
 {
@@ -540,7 +1408,9 @@ raft_net_udp_sockets_close(struct raft_instance *ri)
     for (enum raft_udp_listen_sockets i = RAFT_UDP_LISTEN_MIN;
          i < RAFT_UDP_LISTEN_MAX; i++)
     {
-        int tmp_rc = udp_socket_close(&ri->ri_ush[i]);
+        int tmp_rc = ri->ri_hosted ?
+            raft_net_host_udp_listener_put(ri, i) :
+            udp_socket_close(&ri->ri_ush[i]);
         if (tmp_rc && !rc) // store the first error found.
             rc = tmp_rc;
     }
@@ -572,6 +1442,8 @@ raft_net_tcp_sockets_bind(struct raft_instance *ri)
     // udp sockets are used only by servers.
     if (raft_instance_is_client(ri))
         return -EOPNOTSUPP;
+    else if (ri->ri_hosted) // shared listeners are bound when created
+        return 0;
     else
     {
         int rc = tcp_mgr_sockets_bind(&ri->ri_peer_tcp_mgr);
@@ -588,6 +1460,10 @@ raft_net_udp_sockets_bind(struct raft_instance *ri)
     if (raft_instance_is_client(ri))
         return -EOPNOTSUPP;
 
+    // Shared listeners are bound when they are created
+    if (ri->ri_hosted)
+        return 0;
+
     for (enum raft_udp_listen_sockets i = RAFT_UDP_LISTEN_MIN;
          i < RAFT_UDP_LISTEN_MAX && !rc; i++)
         rc = udp_socket_bind(&ri->ri_ush[i]);
@@ -632,6 +1508,14 @@ raft_net_tcp_sockets_setup(struct raft_instance *ri)
     int rc;
     if (raft_instance_is_client(ri))
         return tcp_mgr_sockets_setup(&ri->ri_client_tcp_mgr, ipaddr, client_port);
+    else if (ri->ri_hosted)
+    {
+        rc = raft_net_host_tcp_listener_get(ri, RAFT_UDP_LISTEN_SERVER, ipaddr,
+                                            peer_port);
+        return rc ? rc
+            : raft_net_host_tcp_listener_get(ri, RAFT_UDP_LISTEN_CLIENT,
+                                             ipaddr, client_port);
+    }
     else
     {
         rc = tcp_mgr_sockets_setup(&ri->ri_peer_tcp_mgr, ipaddr, peer_port);
@@ -686,7 +1570,8 @@ raft_net_udp_sockets_setup(struct raft_instance *ri)
             break;
         }
 
-        rc = udp_socket_setup(&ri->ri_ush[i]);
+        rc = ri->ri_hosted ? raft_net_host_udp_listener_get(ri, i) :
+            udp_socket_setup(&ri->ri_ush[i]);
         if (rc)
             break;
     }
@@ -750,13 +1635,14 @@ raft_net_epoll_cleanup(struct raft_instance *ri)
     for (enum raft_epoll_handles i = 0; i < RAFT_EPOLL_HANDLES_MAX; i++)
     {
         NIOVA_ASSERT(
-            epoll_handle_releases_in_current_thread(&ri->ri_epoll_mgr,
+            epoll_handle_releases_in_current_thread(raft_net_epoll_mgr(ri),
                                                     &ri->ri_epoll_handles[i]));
 
-        epoll_handle_del(&ri->ri_epoll_mgr, &ri->ri_epoll_handles[i]);
+        epoll_handle_del(raft_net_epoll_mgr(ri), &ri->ri_epoll_handles[i]);
     }
 
-    return epoll_mgr_close(&ri->ri_epoll_mgr);
+    // The host's epoll_mgr outlives its instances
+    return ri->ri_hosted ? 0 : epoll_mgr_close(&ri->ri_epoll_mgr);
 }
 
 /**
@@ -788,7 +1674,7 @@ raft_net_epoll_handle_add(struct raft_instance *ri, int fd, epoll_mgr_cb_t cb)
     if (rc)
         return rc;
 
-    rc = epoll_handle_add(&ri->ri_epoll_mgr, eph);
+    rc = epoll_handle_add(raft_net_epoll_mgr(ri), eph);
     if (rc)
         NIOVA_ASSERT(!epoll_handle_is_installed(eph));
 
@@ -808,7 +1694,7 @@ raft_net_epoll_handle_remove_by_fd(struct raft_instance *ri, int fd)
     if (!ri || fd < 0)
 	return -EINVAL;
 
-    if (!epoll_mgr_is_ready(&ri->ri_epoll_mgr))
+    if (!epoll_mgr_is_ready(raft_net_epoll_mgr(ri)))
     {
         raft_net_epoll_ensure_handles_are_removed(ri);
         return -ESHUTDOWN;
@@ -823,10 +1709,10 @@ raft_net_epoll_handle_remove_by_fd(struct raft_instance *ri, int fd)
         if (epoll_handle_is_installed(eph) && eph->eph_fd == fd)
         {
             NIOVA_ASSERT(
-                epoll_handle_releases_in_current_thread(&ri->ri_epoll_mgr,
+                epoll_handle_releases_in_current_thread(raft_net_epoll_mgr(ri),
                                                         eph));
 
-            int tmp_rc = epoll_handle_del(&ri->ri_epoll_mgr, eph);
+            int tmp_rc = epoll_handle_del(raft_net_epoll_mgr(ri), eph);
             if (tmp_rc)
             {
                 SIMPLE_LOG_MSG(LL_WARN, "epoll_handle_del(%p): %s ",
@@ -853,6 +1739,11 @@ raft_epoll_setup_udp(struct raft_instance *ri)
 
     if (raft_instance_is_client(ri))
         return -EINVAL;
+
+    // Shared listeners were added to the host's epoll set at creation
+    if (ri->ri_hosted)
+        return 0;
+
     int rc = 0;
 
     for (enum raft_udp_listen_sockets i = RAFT_UDP_LISTEN_MIN;
@@ -878,16 +1769,24 @@ raft_epoll_setup_net(struct raft_instance *ri)
             return rc;
     }
 
-    if (raft_instance_is_client(ri))
-        return tcp_mgr_epoll_setup(&ri->ri_client_tcp_mgr, &ri->ri_epoll_mgr,
-                                   false);
+    struct epoll_mgr *epm = raft_net_epoll_mgr(ri);
+
+    /* Hosted instances accept connections through the host's listeners,
+     * their own tcp_mgrs only carry the connections.
+     */
+    if (raft_instance_is_client(ri) || ri->ri_hosted)
+    {
+        rc = raft_instance_is_client(ri) ? 0 :
+            tcp_mgr_epoll_setup(&ri->ri_peer_tcp_mgr, epm, false);
+
+        return rc ? rc
+            : tcp_mgr_epoll_setup(&ri->ri_client_tcp_mgr, epm, false);
+    }
     else
     {
-        rc = tcp_mgr_epoll_setup(&ri->ri_peer_tcp_mgr, &ri->ri_epoll_mgr,
-                                 true);
+        rc = tcp_mgr_epoll_setup(&ri->ri_peer_tcp_mgr, epm, true);
         return rc ? rc
-            : tcp_mgr_epoll_setup(&ri->ri_client_tcp_mgr, &ri->ri_epoll_mgr,
-                                  true);
+            : tcp_mgr_epoll_setup(&ri->ri_client_tcp_mgr, epm, true);
     }
 }
 
@@ -1056,7 +1955,10 @@ raft_net_epoll_setup(struct raft_instance *ri)
     if (!ri)
         return -EINVAL;
 
-    int rc = epoll_mgr_setup(&ri->ri_epoll_mgr);
+    if (ri->ri_hosted && !raftNetHost.rnh_active)
+        return -ESHUTDOWN;
+
+    int rc = ri->ri_hosted ? 0 : epoll_mgr_setup(&ri->ri_epoll_mgr);
     if (rc)
         return rc;
 
@@ -1385,7 +2287,12 @@ raft_net_tcp_handshake_fill(struct raft_instance *ri,
 
     handshake->rrm_type = RAFT_RPC_MSG_TYPE_ANY;
     handshake->rrm_version = 0;
-    handshake->rrm__pad = 0;
+    handshake->rrm_version_max = 0; // tcp is always version 0
+
+    // Announce the AE codecs which this peer decodes
+    handshake->rrm_handshake.rhm_ae_compress_mask =
+        ri->ri_rpc_msg_version_max >= RAFT_RPC_MSG_VERSION_COMPRESS ?
+        RAFT_AE_COMPRESS_MASK_SUPPORTED : 0;
 
     uuid_copy(handshake->rrm_sender_id, RAFT_INSTANCE_2_SELF_UUID(ri));
     uuid_copy(handshake->rrm_raft_id, RAFT_INSTANCE_2_RAFT_UUID(ri));
@@ -1401,6 +2308,14 @@ raft_net_csn_setup(struct ctl_svc_node *csn, void *data)
     NIOVA_ASSERT(csn && ctl_svc_node_is_peer(csn));
 
     struct raft_instance *ri = data;
+
+    /* The ctl-svc node set is process wide.  A hosted instance must not
+     * claim the peers of the other raft groups.
+     */
+    if (ri->ri_hosted && csn->csn_type == CTL_SVC_NODE_TYPE_RAFT_PEER &&
+        raft_peer_2_idx(ri, csn->csn_uuid) == RAFT_PEER_ANY)
+        return 0;
+
     bool is_client_cxn = raft_net_is_client_connection(ri, csn);
     struct tcp_mgr_instance *tmi = is_client_cxn ? &ri->ri_client_tcp_mgr
                                                  : &ri->ri_peer_tcp_mgr;
@@ -1478,6 +2393,17 @@ raft_net_tcp_handshake_cb(struct raft_instance *ri,
         }
     }
 
+    /* Record the codecs which the connecting server decodes, these are
+     * consulted when compressing AE requests sent to it.
+     */
+    if (csn_ptr->csn_type == CTL_SVC_NODE_TYPE_RAFT_PEER)
+    {
+        const raft_peer_t idx = raft_peer_2_idx(ri, csn_ptr->csn_uuid);
+        if (idx < CTL_SVC_MAX_RAFT_PEERS)
+            ri->ri_peer_codecs[idx] =
+                handshake->rrm_handshake.rhm_ae_compress_mask;
+    }
+
     *header_size_out = raft_net_connection_header_size(ri, csn_ptr);
     *tmc_out = &csn_ptr->csn_peer.csnp_net_data;
 
@@ -1490,36 +2416,218 @@ raft_net_connection_getput(struct tcp_mgr_connection *tmc,
 {
     NIOVA_ASSERT(tmc);
 
-    struct ctl_svc_node *csn;
-    raft_net_connection_to_csn(tmc, &csn);
+    struct ctl_svc_node *csn;
+    raft_net_connection_to_csn(tmc, &csn);
+
+    if (op == EPH_REF_PUT)
+        ctl_svc_node_put(csn);
+    else
+        ctl_svc_node_get(csn);
+}
+
+static tcp_mgr_ctx_ssize_t
+raft_net_client_msg_bulk_size_cb(struct tcp_mgr_connection *tmc,
+                                 struct raft_client_rpc_msg *msg,
+                                 struct raft_instance *ri)
+{
+    (void)tmc;
+    (void)ri;
+
+    return msg->rcrm_data_size;
+}
+
+static tcp_mgr_ctx_ssize_t
+raft_net_peer_msg_bulk_size_cb(struct tcp_mgr_connection *tmc,
+                               struct raft_rpc_msg *msg,
+                               struct raft_instance *ri)
+{
+    (void)tmc;
+    (void)ri;
+
+    // Compressed entries are sized as sent and restored by the recv handler
+    return msg->rrm_type != RAFT_RPC_MSG_TYPE_APPEND_ENTRIES_REQUEST ? 0
+        : msg->rrm_append_entries_request.raerqm_entries_sz;
+}
+
+/**
+ * raft_net_host_tcp_2_instance - returns the hosted instance which serves
+ *    'raft_id' and which is attached to the shared listener.
+ */
+static struct raft_instance *
+raft_net_host_tcp_2_instance(const struct raft_net_host_tcp_listener *rnhtl,
+                             const uuid_t raft_id)
+{
+    struct raft_instance *ri = raft_net_instance_lookup(raft_id);
+
+    return (ri && ri->ri_hosted && ri->ri_host_tcp[rnhtl->rnhtl_type] == rnhtl)
+        ? ri : NULL;
+}
+
+static tcp_mgr_ctx_int_t
+raft_net_host_tcp_handshake_cb(struct raft_net_host_tcp_listener *rnhtl,
+                               struct tcp_mgr_connection **tmc_out,
+                               size_t *header_size_out, int fd,
+                               struct raft_rpc_msg *handshake, size_t size)
+{
+    NIOVA_ASSERT(rnhtl && handshake && size == sizeof(struct raft_rpc_msg));
+
+    *tmc_out = NULL;
+
+    struct raft_instance *ri =
+        raft_net_host_tcp_2_instance(rnhtl, handshake->rrm_raft_id);
+    if (!ri)
+    {
+        DBG_RAFT_MSG(LL_NOTIFY, handshake, "no hosted raft, fd: %d", fd);
+        return -ENOENT;
+    }
+
+    // The connection is taken over by the tcp_mgr of 'ri'
+    return raft_net_tcp_handshake_cb(ri, tmc_out, header_size_out, fd,
+                                     handshake, size);
+}
+
+static size_t
+raft_net_host_tcp_handshake_fill(struct raft_net_host_tcp_listener *rnhtl,
+                                 struct tcp_mgr_connection *tmc,
+                                 struct raft_rpc_msg *handshake, size_t size)
+{
+    (void)tmc;
+    (void)handshake;
+    (void)size;
+
+    // Outgoing connections are made by the hosted instances' own tcp_mgrs
+    SIMPLE_LOG_MSG(LL_ERROR, "shared listener %s:%d does not connect",
+                   rnhtl->rnhtl_ipaddr, rnhtl->rnhtl_port);
+
+    return 0;
+}
+
+/**
+ * raft_net_host_tcp_recv_cb - msgs are received by the tcp_mgr of the
+ *    instance which took over the connection.  Should one arrive through
+ *    the shared listener it is routed by its raft uuid.
+ */
+static tcp_mgr_ctx_int_t
+raft_net_host_tcp_recv_cb(struct tcp_mgr_connection *tmc, char *buf,
+                          size_t buf_size,
+                          struct raft_net_host_tcp_listener *rnhtl)
+{
+    if (!tmc || !buf || !rnhtl)
+        return -EINVAL;
+
+    const bool server = rnhtl->rnhtl_type == RAFT_UDP_LISTEN_SERVER;
+
+    if (buf_size < (server ? sizeof(struct raft_rpc_msg) :
+                    sizeof(struct raft_client_rpc_msg)))
+        return -EBADMSG;
+
+    struct raft_instance *ri = raft_net_host_tcp_2_instance(
+        rnhtl, server ? ((struct raft_rpc_msg *)buf)->rrm_raft_id :
+        ((struct raft_client_rpc_msg *)buf)->rcrm_raft_id);
+    if (!ri)
+        return -ENOENT;
+
+    return server ? raft_net_peer_tcp_cb(tmc, buf, buf_size, ri) :
+        raft_net_client_tcp_cb(tmc, buf, buf_size, ri);
+}
+
+/**
+ * raft_net_host_tcp_listener_get - the tcp analog of
+ *    raft_net_host_udp_listener_get().  The listener is given its own
+ *    tcp_mgr which is added to the host's epoll set.
+ */
+static int
+raft_net_host_tcp_listener_get(struct raft_instance *ri,
+                               enum raft_udp_listen_sockets type,
+                               const char *ipaddr, int port)
+{
+    NIOVA_ASSERT(ri && ri->ri_hosted && raftNetHost.rnh_active && ipaddr);
+    NIOVA_ASSERT(type < RAFT_UDP_LISTEN_MAX && !ri->ri_host_tcp[type]);
+
+    struct raft_net_host_tcp_listener *rnhtl = NULL;
+
+    for (size_t i = 0; i < RAFT_NET_HOST_TCP_MAX; i++)
+    {
+        struct raft_net_host_tcp_listener *tmp =
+            &raftNetHost.rnh_tcp_listeners[i];
+
+        if (!tmp->rnhtl_refcnt)
+        {
+            if (!rnhtl)
+                rnhtl = tmp;
+        }
+        else if (tmp->rnhtl_type == type && tmp->rnhtl_port == port &&
+                 !strncmp(tmp->rnhtl_ipaddr, ipaddr, IPV4_STRLEN))
+        {
+            tmp->rnhtl_refcnt++;
+            ri->ri_host_tcp[type] = tmp;
+
+            return 0;
+        }
+    }
+
+    if (!rnhtl)
+        return -ENOSPC;
+
+    memset(rnhtl, 0, sizeof(*rnhtl));
+    strncpy(rnhtl->rnhtl_ipaddr, ipaddr, IPV4_STRLEN - 1);
+    rnhtl->rnhtl_port = port;
+    rnhtl->rnhtl_type = type;
+
+    const bool server = type == RAFT_UDP_LISTEN_SERVER;
+
+    int rc = tcp_mgr_setup(
+        &rnhtl->rnhtl_tmi, rnhtl,
+        (epoll_mgr_ref_cb_t)raft_net_connection_getput,
+        (tcp_mgr_recv_cb_t)raft_net_host_tcp_recv_cb,
+        (server ? (tcp_mgr_bulk_size_cb_t)raft_net_peer_msg_bulk_size_cb :
+         (tcp_mgr_bulk_size_cb_t)raft_net_client_msg_bulk_size_cb),
+        (tcp_mgr_handshake_cb_t)raft_net_host_tcp_handshake_cb,
+        (tcp_mgr_handshake_fill_t)raft_net_host_tcp_handshake_fill,
+        sizeof(struct raft_rpc_msg),
+        DEFAULT_BULK_CREDITS,
+        DEFAULT_INCOMING_CREDITS, server ? false : true);
+
+    if (!rc)
+        rc = tcp_mgr_sockets_setup(&rnhtl->rnhtl_tmi, ipaddr, port);
+
+    if (!rc)
+        rc = tcp_mgr_epoll_setup(&rnhtl->rnhtl_tmi, &raftNetHost.rnh_epm,
+                                 true);
+    if (!rc)
+        rc = tcp_mgr_sockets_bind(&rnhtl->rnhtl_tmi);
+
+    if (rc)
+    {
+        SIMPLE_LOG_MSG(LL_WARN, "shared tcp listener %s:%d: %s", ipaddr, port,
+                       strerror(-rc));
+
+        tcp_mgr_sockets_close(&rnhtl->rnhtl_tmi);
+        return rc;
+    }
+
+    rnhtl->rnhtl_refcnt = 1;
+    ri->ri_host_tcp[type] = rnhtl;
 
-    if (op == EPH_REF_PUT)
-        ctl_svc_node_put(csn);
-    else
-        ctl_svc_node_get(csn);
+    return 0;
 }
 
-static tcp_mgr_ctx_ssize_t
-raft_net_client_msg_bulk_size_cb(struct tcp_mgr_connection *tmc,
-                                 struct raft_client_rpc_msg *msg,
-                                 struct raft_instance *ri)
+static int
+raft_net_host_tcp_listener_put(struct raft_instance *ri,
+                               enum raft_udp_listen_sockets type)
 {
-    (void)tmc;
-    (void)ri;
+    NIOVA_ASSERT(ri && ri->ri_hosted && type < RAFT_UDP_LISTEN_MAX);
 
-    return msg->rcrm_data_size;
-}
+    struct raft_net_host_tcp_listener *rnhtl = ri->ri_host_tcp[type];
+    if (!rnhtl)
+        return 0;
 
-static tcp_mgr_ctx_ssize_t
-raft_net_peer_msg_bulk_size_cb(struct tcp_mgr_connection *tmc,
-                               struct raft_rpc_msg *msg,
-                               struct raft_instance *ri)
-{
-    (void)tmc;
-    (void)ri;
+    ri->ri_host_tcp[type] = NULL;
 
-    return msg->rrm_type != RAFT_RPC_MSG_TYPE_APPEND_ENTRIES_REQUEST ? 0
-        : msg->rrm_append_entries_request.raerqm_entries_sz;
+    NIOVA_ASSERT(rnhtl->rnhtl_refcnt > 0);
+
+    return --rnhtl->rnhtl_refcnt ? 0 :
+        tcp_mgr_sockets_close(&rnhtl->rnhtl_tmi);
 }
 
 #if 0
@@ -1839,7 +2947,600 @@ raft_net_send_tcp(struct raft_instance *ri, struct ctl_svc_node *csn,
 
     raft_net_update_last_comm_time(ri, csn->csn_uuid, true);
 
-    return tcp_mgr_send_msg(&csn->csn_peer.csnp_net_data, iov, niovs);
+    return tcp_mgr_send_msg(&csn->csn_peer.csnp_net_data, iov, niovs);
+}
+
+static char *
+raft_net_compact_put_uvarint(char *p, uint64_t val)
+{
+    while (val >= 0x80)
+    {
+        *p++ = (char)(val | 0x80);
+        val >>= 7;
+    }
+    *p++ = (char)val;
+
+    return p;
+}
+
+// Terms and indexes may be -1, zigzag them so that small values stay small
+static char *
+raft_net_compact_put_svarint(char *p, int64_t val)
+{
+    return raft_net_compact_put_uvarint(p, ((uint64_t)val << 1) ^
+                                        (uint64_t)(val >> 63));
+}
+
+static char *
+raft_net_compact_put_bytes(char *p, const void *src, size_t len)
+{
+    memcpy(p, src, len);
+
+    return p + len;
+}
+
+struct raft_net_compact_reader
+{
+    const char *rncr_pos;
+    const char *rncr_end;
+    int         rncr_err;
+};
+
+static uint64_t
+raft_net_compact_get_uvarint(struct raft_net_compact_reader *rd)
+{
+    uint64_t val = 0;
+
+    for (unsigned int shift = 0; shift < 64; shift += 7)
+    {
+        if (rd->rncr_pos >= rd->rncr_end)
+            break;
+
+        const uint8_t byte = *rd->rncr_pos++;
+        val |= (uint64_t)(byte & 0x7f) << shift;
+
+        if (!(byte & 0x80))
+            return val;
+    }
+
+    rd->rncr_err = -EBADMSG;
+    return 0;
+}
+
+static int64_t
+raft_net_compact_get_svarint(struct raft_net_compact_reader *rd)
+{
+    const uint64_t val = raft_net_compact_get_uvarint(rd);
+
+    return (int64_t)(val >> 1) ^ -(int64_t)(val & 1);
+}
+
+static uint32_t
+raft_net_compact_get_u32varint(struct raft_net_compact_reader *rd)
+{
+    const uint64_t val = raft_net_compact_get_uvarint(rd);
+    if (val > UINT32_MAX)
+        rd->rncr_err = -EBADMSG;
+
+    return (uint32_t)val;
+}
+
+static void
+raft_net_compact_get_bytes(struct raft_net_compact_reader *rd, void *dest,
+                           size_t len)
+{
+    if (rd->rncr_err || (size_t)(rd->rncr_end - rd->rncr_pos) < len)
+    {
+        rd->rncr_err = -EBADMSG;
+        return;
+    }
+
+    memcpy(dest, rd->rncr_pos, len);
+    rd->rncr_pos += len;
+}
+
+/**
+ * raft_net_rpc_msg_compact_encode - encodes the header of a server rpc msg
+ *    into 'buf' using the compact format.  The AE request payload
+ *    (raerqm_entries) is not copied, the caller sends it directly behind the
+ *    encoded header.  Returns the encoded header size or -errno.
+ */
+ssize_t
+raft_net_rpc_msg_compact_encode(const struct raft_rpc_msg *rrm, char *buf,
+                                size_t buf_size)
+{
+    if (!rrm || !buf || buf_size < RAFT_RPC_MSG_COMPACT_HDR_MAX)
+        return -EINVAL;
+
+    // Compressed AE requests are only sent over TCP
+    if (rrm->rrm_version == RAFT_RPC_MSG_VERSION_COMPRESS)
+        return -EINVAL;
+
+    const uint16_t version = RAFT_RPC_MSG_VERSION_COMPACT;
+    char *p = buf;
+
+    p = raft_net_compact_put_bytes(p, &rrm->rrm_type, sizeof(uint32_t));
+    p = raft_net_compact_put_bytes(p, &version, sizeof(uint16_t));
+    p = raft_net_compact_put_bytes(p, &rrm->rrm_version_max,
+                                   sizeof(uint16_t));
+    p = raft_net_compact_put_bytes(p, rrm->rrm_sender_id, sizeof(uuid_t));
+    p = raft_net_compact_put_bytes(p, rrm->rrm_raft_id, sizeof(uuid_t));
+
+    switch (rrm->rrm_type)
+    {
+    case RAFT_RPC_MSG_TYPE_PRE_VOTE_REQUEST: // fall through
+    case RAFT_RPC_MSG_TYPE_VOTE_REQUEST:
+    {
+        const struct raft_vote_request_msg *rvrq = &rrm->rrm_vote_request;
+
+        p = raft_net_compact_put_svarint(p, rvrq->rvrqm_proposed_term);
+        p = raft_net_compact_put_svarint(p, rvrq->rvrqm_last_log_term);
+        p = raft_net_compact_put_svarint(p, rvrq->rvrqm_last_log_index);
+        break;
+    }
+    case RAFT_RPC_MSG_TYPE_PRE_VOTE_REPLY: // fall through
+    case RAFT_RPC_MSG_TYPE_VOTE_REPLY:
+    {
+        const struct raft_vote_reply_msg *rvrp = &rrm->rrm_vote_reply;
+
+        *p++ = rvrp->rvrpm_voted_granted;
+        p = raft_net_compact_put_svarint(p, rvrp->rvrpm_term);
+        p = raft_net_compact_put_bytes(p, rvrp->rvrpm_current_leader,
+                                       sizeof(uuid_t));
+        break;
+    }
+    case RAFT_RPC_MSG_TYPE_APPEND_ENTRIES_REQUEST:
+    {
+        const struct raft_append_entries_request_msg *raerq =
+            &rrm->rrm_append_entries_request;
+
+        if (raerq->raerqm_num_entries > RAFT_ENTRY_NUM_ENTRIES)
+            return -EINVAL;
+
+        // The db uuid is needed by followers which enter bulk recovery
+        p = raft_net_compact_put_bytes(p, rrm->rrm_db_id, sizeof(uuid_t));
+        p = raft_net_compact_put_svarint(p, raerq->raerqm_leader_term);
+        p = raft_net_compact_put_svarint(p, raerq->raerqm_log_term);
+        p = raft_net_compact_put_svarint(p, raerq->raerqm_commit_index);
+        p = raft_net_compact_put_svarint(p, raerq->raerqm_lowest_index);
+        p = raft_net_compact_put_svarint(p, raerq->raerqm_chkpt_index);
+        p = raft_net_compact_put_svarint(p, raerq->raerqm_prev_log_term);
+        p = raft_net_compact_put_svarint(p, raerq->raerqm_prev_log_index);
+        p = raft_net_compact_put_bytes(p, &raerq->raerqm_prev_idx_crc,
+                                       sizeof(uint32_t));
+        p = raft_net_compact_put_bytes(p, &raerq->raerqm_this_idx_crc,
+                                       sizeof(uint32_t));
+        *p++ = raerq->raerqm_heartbeat_msg;
+        *p++ = raerq->raerqm_leader_change_marker;
+        *p++ = raerq->raerqm_entry_out_of_range;
+        *p++ = raerq->raerqm_num_idx;
+        p = raft_net_compact_put_uvarint(p, raerq->raerqm_entries_sz);
+        p = raft_net_compact_put_uvarint(p, raerq->raerqm_first_idx_sz);
+        p = raft_net_compact_put_uvarint(p, raerq->raerqm_num_entries);
+
+        // Only the used portion of the size array is sent
+        for (uint32_t i = 0; i < raerq->raerqm_num_entries; i++)
+            p = raft_net_compact_put_uvarint(p, raerq->raerqm_size_arr[i]);
+        break;
+    }
+    case RAFT_RPC_MSG_TYPE_APPEND_ENTRIES_REPLY:
+    {
+        const struct raft_append_entries_reply_msg *raerp =
+            &rrm->rrm_append_entries_reply;
+
+        p = raft_net_compact_put_svarint(p, raerp->raerpm_leader_term);
+        p = raft_net_compact_put_svarint(p, raerp->raerpm_prev_log_index);
+        p = raft_net_compact_put_svarint(p, raerp->raerpm_synced_log_index);
+        *p++ = raerp->raerpm_heartbeat_msg;
+        *p++ = raerp->raerpm_err_stale_term;
+        *p++ = raerp->raerpm_err_non_matching_prev_term;
+        *p++ = raerp->raerpm_newly_initialized_peer;
+        *p++ = raerp->raerpm_update_sli;
+        *p++ = raerp->raerpm_num_idx;
+        break;
+    }
+    case RAFT_RPC_MSG_TYPE_SYNC_IDX_UPDATE:
+    {
+        const struct raft_sync_idx_update_msg *rsiu =
+            &rrm->rrm_sync_index_update;
+
+        p = raft_net_compact_put_svarint(p, rsiu->rsium_synced_log_index);
+        p = raft_net_compact_put_svarint(p, rsiu->rsium_term);
+        break;
+    }
+    default:
+        return -EOPNOTSUPP;
+    }
+
+    NIOVA_ASSERT((size_t)(p - buf) <= RAFT_RPC_MSG_COMPACT_HDR_MAX);
+
+    return p - buf;
+}
+
+/**
+ * raft_net_rpc_msg_compact_decode - decodes a compact server rpc msg,
+ *    including any AE request payload, into its version 0 form.  'rrm' must
+ *    be large enough to hold the msg and its payload.  Fields which are not
+ *    carried by the compact format are zeroed.  Returns the version 0 size of
+ *    the msg or -errno.
+ */
+ssize_t
+raft_net_rpc_msg_compact_decode(const char *buf, size_t buf_size,
+                                struct raft_rpc_msg *rrm, size_t rrm_size)
+{
+    if (!buf || !rrm || rrm_size < sizeof(struct raft_rpc_msg))
+        return -EINVAL;
+
+    struct raft_net_compact_reader rd = {
+        .rncr_pos = buf,
+        .rncr_end = buf + buf_size,
+    };
+
+    memset(rrm, 0, sizeof(struct raft_rpc_msg));
+
+    raft_net_compact_get_bytes(&rd, &rrm->rrm_type, sizeof(uint32_t));
+    raft_net_compact_get_bytes(&rd, &rrm->rrm_version, sizeof(uint16_t));
+    raft_net_compact_get_bytes(&rd, &rrm->rrm_version_max, sizeof(uint16_t));
+    raft_net_compact_get_bytes(&rd, rrm->rrm_sender_id, sizeof(uuid_t));
+    raft_net_compact_get_bytes(&rd, rrm->rrm_raft_id, sizeof(uuid_t));
+
+    if (rd.rncr_err)
+        return rd.rncr_err;
+
+    if (rrm->rrm_version != RAFT_RPC_MSG_VERSION_COMPACT)
+        return -EPROTO;
+
+    size_t payload_sz = 0;
+
+    switch (rrm->rrm_type)
+    {
+    case RAFT_RPC_MSG_TYPE_PRE_VOTE_REQUEST: // fall through
+    case RAFT_RPC_MSG_TYPE_VOTE_REQUEST:
+    {
+        struct raft_vote_request_msg *rvrq = &rrm->rrm_vote_request;
+
+        rvrq->rvrqm_proposed_term = raft_net_compact_get_svarint(&rd);
+        rvrq->rvrqm_last_log_term = raft_net_compact_get_svarint(&rd);
+        rvrq->rvrqm_last_log_index = raft_net_compact_get_svarint(&rd);
+        break;
+    }
+    case RAFT_RPC_MSG_TYPE_PRE_VOTE_REPLY: // fall through
+    case RAFT_RPC_MSG_TYPE_VOTE_REPLY:
+    {
+        struct raft_vote_reply_msg *rvrp = &rrm->rrm_vote_reply;
+
+        raft_net_compact_get_bytes(&rd, &rvrp->rvrpm_voted_granted,
+                                   sizeof(uint8_t));
+        rvrp->rvrpm_term = raft_net_compact_get_svarint(&rd);
+        raft_net_compact_get_bytes(&rd, rvrp->rvrpm_current_leader,
+                                   sizeof(uuid_t));
+        break;
+    }
+    case RAFT_RPC_MSG_TYPE_APPEND_ENTRIES_REQUEST:
+    {
+        struct raft_append_entries_request_msg *raerq =
+            &rrm->rrm_append_entries_request;
+
+        raft_net_compact_get_bytes(&rd, rrm->rrm_db_id, sizeof(uuid_t));
+        raerq->raerqm_leader_term = raft_net_compact_get_svarint(&rd);
+        raerq->raerqm_log_term = raft_net_compact_get_svarint(&rd);
+        raerq->raerqm_commit_index = raft_net_compact_get_svarint(&rd);
+        raerq->raerqm_lowest_index = raft_net_compact_get_svarint(&rd);
+        raerq->raerqm_chkpt_index = raft_net_compact_get_svarint(&rd);
+        raerq->raerqm_prev_log_term = raft_net_compact_get_svarint(&rd);
+        raerq->raerqm_prev_log_index = raft_net_compact_get_svarint(&rd);
+        raft_net_compact_get_bytes(&rd, &raerq->raerqm_prev_idx_crc,
+                                   sizeof(uint32_t));
+        raft_net_compact_get_bytes(&rd, &raerq->raerqm_this_idx_crc,
+                                   sizeof(uint32_t));
+        raft_net_compact_get_bytes(&rd, &raerq->raerqm_heartbeat_msg,
+                                   sizeof(uint8_t));
+        raft_net_compact_get_bytes(&rd, &raerq->raerqm_leader_change_marker,
+                                   sizeof(uint8_t));
+        raft_net_compact_get_bytes(&rd, &raerq->raerqm_entry_out_of_range,
+                                   sizeof(uint8_t));
+        raft_net_compact_get_bytes(&rd, &raerq->raerqm_num_idx,
+                                   sizeof(uint8_t));
+        raerq->raerqm_entries_sz = raft_net_compact_get_u32varint(&rd);
+        raerq->raerqm_first_idx_sz = raft_net_compact_get_u32varint(&rd);
+        raerq->raerqm_num_entries = raft_net_compact_get_u32varint(&rd);
+
+        if (rd.rncr_err || raerq->raerqm_num_entries > RAFT_ENTRY_NUM_ENTRIES)
+            return -EBADMSG;
+
+        for (uint32_t i = 0; i < raerq->raerqm_num_entries; i++)
+            raerq->raerqm_size_arr[i] = raft_net_compact_get_u32varint(&rd);
+
+        payload_sz = raerq->raerqm_entries_sz;
+        break;
+    }
+    case RAFT_RPC_MSG_TYPE_APPEND_ENTRIES_REPLY:
+    {
+        struct raft_append_entries_reply_msg *raerp =
+            &rrm->rrm_append_entries_reply;
+
+        raerp->raerpm_leader_term = raft_net_compact_get_svarint(&rd);
+        raerp->raerpm_prev_log_index = raft_net_compact_get_svarint(&rd);
+        raerp->raerpm_synced_log_index = raft_net_compact_get_svarint(&rd);
+        raft_net_compact_get_bytes(&rd, &raerp->raerpm_heartbeat_msg,
+                                   sizeof(uint8_t));
+        raft_net_compact_get_bytes(&rd, &raerp->raerpm_err_stale_term,
+                                   sizeof(uint8_t));
+        raft_net_compact_get_bytes(&rd,
+                                   &raerp->raerpm_err_non_matching_prev_term,
+                                   sizeof(uint8_t));
+        raft_net_compact_get_bytes(&rd, &raerp->raerpm_newly_initialized_peer,
+                                   sizeof(uint8_t));
+        raft_net_compact_get_bytes(&rd, &raerp->raerpm_update_sli,
+                                   sizeof(uint8_t));
+        raft_net_compact_get_bytes(&rd, &raerp->raerpm_num_idx,
+                                   sizeof(uint8_t));
+        break;
+    }
+    case RAFT_RPC_MSG_TYPE_SYNC_IDX_UPDATE:
+    {
+        struct raft_sync_idx_update_msg *rsiu = &rrm->rrm_sync_index_update;
+
+        rsiu->rsium_synced_log_index = raft_net_compact_get_svarint(&rd);
+        rsiu->rsium_term = raft_net_compact_get_svarint(&rd);
+        break;
+    }
+    default:
+        return -EBADMSG;
+    }
+
+    if (rd.rncr_err)
+        return rd.rncr_err;
+
+    // Everything which remains is the payload, no more and no less
+    if ((size_t)(rd.rncr_end - rd.rncr_pos) != payload_sz)
+        return -EBADMSG;
+
+    if (payload_sz > rrm_size - sizeof(struct raft_rpc_msg))
+        return -E2BIG;
+
+    if (payload_sz)
+        memcpy(rrm->rrm_append_entries_request.raerqm_entries, rd.rncr_pos,
+               payload_sz);
+
+    return sizeof(struct raft_rpc_msg) + payload_sz;
+}
+
+/**
+ * raft_net_ae_entries_compress - copies the AE request 'src' into 'buf' with
+ *    its raerqm_entries compressed by the codec 'type'.  The copy is marked
+ *    with the compress version and its payload leads with a
+ *    raft_ae_compress_hdr, the layout of the raft_rpc_msg is unchanged.
+ *    Returns the size of the compressed msg, -E2BIG if the entries did not
+ *    shrink, or -errno.
+ */
+ssize_t
+raft_net_ae_entries_compress(const struct raft_rpc_msg *src, int type,
+                             char *buf, size_t buf_size)
+{
+    const size_t hdr_sz = sizeof(struct raft_ae_compress_hdr);
+
+    if (!src || !buf || buf_size <= sizeof(struct raft_rpc_msg) + hdr_sz ||
+        src->rrm_type != RAFT_RPC_MSG_TYPE_APPEND_ENTRIES_REQUEST ||
+        src->rrm_version != RAFT_RPC_MSG_VERSION_0)
+        return -EINVAL;
+
+    const struct raft_append_entries_request_msg *raerq =
+        &src->rrm_append_entries_request;
+
+    if (!raerq->raerqm_entries_sz ||
+        raerq->raerqm_entries_sz > LZ4_MAX_INPUT_SIZE)
+        return -EINVAL;
+
+    if (raerq->raerqm_entries_sz <= hdr_sz + 1)
+        return -E2BIG;
+
+    struct raft_rpc_msg *rrm = (struct raft_rpc_msg *)buf;
+    struct raft_ae_compress_hdr *rach =
+        (struct raft_ae_compress_hdr *)rrm->rrm_append_entries_request.
+        raerqm_entries;
+    char *dst = (char *)(rach + 1);
+
+    // The output is bounded so that only a smaller payload is produced
+    const int dst_max = MIN(buf_size - sizeof(struct raft_rpc_msg) - hdr_sz,
+                            raerq->raerqm_entries_sz - hdr_sz - 1);
+    int csz = 0;
+
+    switch (type)
+    {
+    case RAFT_AE_COMPRESS_LZ4:
+        csz = LZ4_compress_default(raerq->raerqm_entries, dst,
+                                   raerq->raerqm_entries_sz, dst_max);
+        break;
+    default:
+        return -EOPNOTSUPP;
+    }
+
+    if (csz <= 0)
+        return -E2BIG;
+
+    memcpy(rrm, src, sizeof(struct raft_rpc_msg));
+
+    memset(rach, 0, hdr_sz);
+    rach->rach_type = type;
+    rach->rach_entries_sz = raerq->raerqm_entries_sz;
+
+    rrm->rrm_version = RAFT_RPC_MSG_VERSION_COMPRESS;
+    rrm->rrm_append_entries_request.raerqm_entries_sz = hdr_sz + csz;
+
+    return sizeof(struct raft_rpc_msg) + hdr_sz + csz;
+}
+
+/**
+ * raft_net_ae_entries_decompress - restores the compressed AE request in
+ *    'buf' into 'rrm', which must be large enough to hold the uncompressed
+ *    entries.  The restored msg is version 0.  Returns the uncompressed size
+ *    of the msg or -errno.
+ */
+ssize_t
+raft_net_ae_entries_decompress(const char *buf, size_t buf_size,
+                               struct raft_rpc_msg *rrm, size_t rrm_size)
+{
+    const size_t hdr_sz = sizeof(struct raft_ae_compress_hdr);
+
+    if (!buf || !rrm || buf_size < sizeof(struct raft_rpc_msg) ||
+        rrm_size < sizeof(struct raft_rpc_msg))
+        return -EINVAL;
+
+    const struct raft_rpc_msg *src = (const struct raft_rpc_msg *)buf;
+    const struct raft_append_entries_request_msg *raerq =
+        &src->rrm_append_entries_request;
+
+    if (src->rrm_type != RAFT_RPC_MSG_TYPE_APPEND_ENTRIES_REQUEST ||
+        src->rrm_version != RAFT_RPC_MSG_VERSION_COMPRESS)
+        return -EINVAL;
+
+    if (buf_size - sizeof(struct raft_rpc_msg) != raerq->raerqm_entries_sz ||
+        raerq->raerqm_entries_sz <= hdr_sz)
+        return -EBADMSG;
+
+    struct raft_ae_compress_hdr rach;
+    memcpy(&rach, raerq->raerqm_entries, hdr_sz);
+
+    if (rach.rach_entries_sz > rrm_size - sizeof(struct raft_rpc_msg))
+        return -E2BIG;
+
+    char *dst = rrm->rrm_append_entries_request.raerqm_entries;
+    int dsz = -1;
+
+    switch (rach.rach_type)
+    {
+    case RAFT_AE_COMPRESS_LZ4:
+        dsz = LZ4_decompress_safe(raerq->raerqm_entries + hdr_sz, dst,
+                                  raerq->raerqm_entries_sz - hdr_sz,
+                                  rach.rach_entries_sz);
+        break;
+    default:
+        return -EOPNOTSUPP;
+    }
+
+    if (dsz < 0 || (uint32_t)dsz != rach.rach_entries_sz)
+        return -EBADMSG;
+
+    memcpy(rrm, src, sizeof(struct raft_rpc_msg));
+
+    rrm->rrm_version = RAFT_RPC_MSG_VERSION_0;
+    rrm->rrm_append_entries_request.raerqm_entries_sz = dsz;
+
+    return sizeof(struct raft_rpc_msg) + dsz;
+}
+
+/**
+ * raft_net_rpc_msg_batch_add - append 'msg' to the batch in 'batch', whose
+ *    current length is '*len'.  The batch header is written by the first
+ *    call, when '*len' is zero.  Returns -ENOSPC if 'msg' does not fit.
+ */
+int
+raft_net_rpc_msg_batch_add(char *batch, size_t batch_size, size_t *len,
+                           const void *msg, size_t msg_size)
+{
+    if (!batch || !len || !msg || !msg_size || msg_size > UINT32_MAX)
+        return -EINVAL;
+
+    struct raft_rpc_msg_batch_hdr *hdr =
+        (struct raft_rpc_msg_batch_hdr *)batch;
+
+    if (!*len)
+    {
+        if (batch_size < sizeof(*hdr))
+            return -ENOSPC;
+
+        hdr->rrmbh_type = RAFT_RPC_MSG_TYPE_BATCH;
+        hdr->rrmbh_version = RAFT_RPC_MSG_VERSION_BATCH;
+        hdr->rrmbh_nmsgs = 0;
+
+        *len = sizeof(*hdr);
+    }
+
+    if (hdr->rrmbh_nmsgs == UINT16_MAX)
+        return -ENOSPC;
+
+    const size_t ent_size = sizeof(struct raft_rpc_msg_batch_ent) +
+        ((msg_size + 7UL) & ~7UL);
+
+    if (ent_size > batch_size - *len)
+        return -ENOSPC;
+
+    struct raft_rpc_msg_batch_ent ent = {.rrmbe_size = msg_size};
+
+    memcpy(&batch[*len], &ent, sizeof(ent));
+    memcpy(&batch[*len + sizeof(ent)], msg, msg_size);
+
+    *len += ent_size;
+    hdr->rrmbh_nmsgs++;
+
+    return 0;
+}
+
+/**
+ * raft_net_rpc_msg_batch_next - returns the size of the msg at '*off' within
+ *    the batch, sets '*msg_off' to the msg's offset and advances '*off' past
+ *    it.  '*off' must be zero on the first call.  Zero is returned once the
+ *    batch has been consumed and -EBADMSG if the batch is malformed.
+ */
+ssize_t
+raft_net_rpc_msg_batch_next(const char *batch, size_t len, size_t *off,
+                            size_t *msg_off)
+{
+    const struct raft_rpc_msg_batch_hdr *hdr =
+        (const struct raft_rpc_msg_batch_hdr *)batch;
+
+    if (!batch || !off || !msg_off || len < sizeof(*hdr) ||
+        hdr->rrmbh_type != RAFT_RPC_MSG_TYPE_BATCH ||
+        hdr->rrmbh_version != RAFT_RPC_MSG_VERSION_BATCH)
+        return -EBADMSG;
+
+    if (!*off)
+        *off = sizeof(*hdr);
+
+    if (*off == len)
+        return 0;
+
+    struct raft_rpc_msg_batch_ent ent;
+
+    if (*off > len || len - *off < sizeof(ent))
+        return -EBADMSG;
+
+    memcpy(&ent, &batch[*off], sizeof(ent));
+
+    const size_t ent_size = sizeof(ent) + ((ent.rrmbe_size + 7UL) & ~7UL);
+
+    if (!ent.rrmbe_size || ent_size > len - *off)
+        return -EBADMSG;
+
+    *msg_off = *off + sizeof(ent);
+    *off += ent_size;
+
+    return ent.rrmbe_size;
+}
+
+/**
+ * raft_net_rpc_msg_batch_check - walks the batch and returns the number of
+ *    msgs it holds, or -EBADMSG if these don't match the header's count or
+ *    the batch is malformed.
+ */
+static ssize_t
+raft_net_rpc_msg_batch_check(const char *batch, size_t len)
+{
+    size_t off = 0;
+    size_t msg_off;
+    ssize_t nmsgs = 0;
+    ssize_t rc;
+
+    while ((rc = raft_net_rpc_msg_batch_next(batch, len, &off, &msg_off)) > 0)
+        nmsgs++;
+
+    if (rc < 0)
+        return rc;
+
+    return nmsgs ==
+        ((const struct raft_rpc_msg_batch_hdr *)batch)->rrmbh_nmsgs ?
+        nmsgs : -EBADMSG;
 }
 
 int
@@ -1887,6 +3588,39 @@ raft_net_send_msg(struct raft_instance *ri, struct ctl_svc_node *csn,
     return 0;
 }
 
+/**
+ * raft_net_send_bulk_msg - sends a server msg over the peer's TCP
+ *    connection.  This is called by the bulk lane sender thread which, while
+ *    it runs, is the only sender on the connection since the tcp_mgr does not
+ *    serialize concurrent sends.  Unlike raft_net_send_msg(), the peer's last
+ *    send time is not updated here.  The caller records it when the msg is
+ *    queued.
+ */
+int
+raft_net_send_bulk_msg(struct raft_instance *ri, struct ctl_svc_node *csn,
+                       struct iovec *iov, size_t niovs)
+{
+    if (!ri || !csn || !iov || !niovs)
+        return -EINVAL;
+
+    const size_t msg_size = niova_io_iovs_total_size_get(iov, niovs);
+
+    if (msg_size > raft_net_max_rpc_size(ri->ri_store_type) ||
+        raft_net_tcp_disabled() || msg_size > tcp_get_max_size())
+        return -E2BIG;
+
+    if (!net_ctl_can_send(&csn->csn_peer.csnp_net_ctl))
+    {
+        DBG_CTL_SVC_NODE(LL_DEBUG, csn, "net_ctl_can_send() is false");
+        return 0;
+    }
+
+    ssize_t size_rc =
+        tcp_mgr_send_msg(&csn->csn_peer.csnp_net_data, iov, niovs);
+
+    return size_rc == (ssize_t)msg_size ? 0 : size_rc;
+}
+
 int
 raft_net_send_msg_to_uuid(struct raft_instance *ri, uuid_t uuid,
                           struct iovec *iov, size_t niovs,
@@ -1906,6 +3640,256 @@ raft_net_send_msg_to_uuid(struct raft_instance *ri, uuid_t uuid,
     return rc;
 }
 
+void
+raft_net_udp_send_batch_init(struct raft_net_udp_send_batch *rnusb,
+                             const enum raft_udp_listen_sockets sock_src)
+{
+    NIOVA_ASSERT(rnusb && sock_src < RAFT_UDP_LISTEN_MAX);
+
+    rnusb->rnusb_sock_src = sock_src;
+    rnusb->rnusb_host_coalesce = false;
+    rnusb->rnusb_nmsgs = 0;
+}
+
+/**
+ * raft_net_udp_send_batch_flush - sends the queued messages with as few
+ *    sendmmsg() calls as possible.  A message which fails is skipped so that
+ *    the remaining peers are still sent to.  Returns the first error, raft
+ *    will retry the failed messages as needed.
+ */
+int
+raft_net_udp_send_batch_flush(struct raft_instance *ri,
+                              struct raft_net_udp_send_batch *rnusb)
+{
+    if (!ri || !rnusb)
+        return -EINVAL;
+
+    const size_t nmsgs = rnusb->rnusb_nmsgs;
+    rnusb->rnusb_nmsgs = 0;
+
+    if (!nmsgs)
+        return 0;
+
+    const int fd =
+        udp_socket_handle_2_sockfd(&ri->ri_ush[rnusb->rnusb_sock_src]);
+
+    struct mmsghdr msgs[RAFT_NET_UDP_MMSG_BATCH_MAX];
+    memset(msgs, 0, sizeof(struct mmsghdr) * nmsgs);
+
+    for (size_t i = 0; i < nmsgs; i++)
+    {
+        msgs[i].msg_hdr.msg_name = &rnusb->rnusb_dest[i];
+        msgs[i].msg_hdr.msg_namelen = sizeof(struct sockaddr_in);
+        msgs[i].msg_hdr.msg_iov = &rnusb->rnusb_iov[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    int rc = 0;
+
+    for (size_t nsent = 0; nsent < nmsgs;)
+    {
+        int n = sendmmsg(fd, &msgs[nsent], nmsgs - nsent, 0);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+                continue;
+
+            if (!rc)
+                rc = -errno;
+
+            DBG_CTL_SVC_NODE(LL_NOTIFY, rnusb->rnusb_csn[nsent],
+                             "sendmmsg(): %s", strerror(errno));
+
+            nsent++; // skip the message which failed
+        }
+        else
+        {
+            nsent += n;
+        }
+    }
+
+    for (size_t i = 0; i < nmsgs; i++)
+    {
+        if (msgs[i].msg_len == rnusb->rnusb_iov[i].iov_len)
+            raft_net_update_last_comm_time(ri, rnusb->rnusb_csn[i]->csn_uuid,
+                                           true);
+        else if (!rc)
+            rc = -EMSGSIZE;
+    }
+
+    return rc;
+}
+
+static bool
+raft_net_peer_decodes_batch(const struct raft_instance *ri,
+                            const struct ctl_svc_node *csn)
+{
+    const raft_peer_t idx = raft_peer_2_idx(ri, csn->csn_uuid);
+
+    return (ri->ri_rpc_msg_version_max >= RAFT_RPC_MSG_VERSION_BATCH &&
+            idx < CTL_SVC_MAX_RAFT_PEERS &&
+            ri->ri_peer_msg_version[idx] >= RAFT_RPC_MSG_VERSION_BATCH) ?
+        true : false;
+}
+
+static void
+raft_net_host_hb_send(struct raft_net_host_hb_batch *rnhhb)
+{
+    const char *buf = rnhhb->rnhhb_buf;
+    size_t len = rnhhb->rnhhb_len;
+
+    // A lone msg is sent without the batch header
+    if (rnhhb->rnhhb_nmsgs == 1)
+    {
+        size_t off = 0;
+        size_t msg_off = 0;
+        ssize_t msg_size =
+            raft_net_rpc_msg_batch_next(buf, len, &off, &msg_off);
+        NIOVA_ASSERT(msg_size > 0);
+
+        buf += msg_off;
+        len = msg_size;
+    }
+
+    ssize_t rc = sendto(rnhhb->rnhhb_fd, buf, len, 0,
+                        (struct sockaddr *)&rnhhb->rnhhb_dest,
+                        sizeof(struct sockaddr_in));
+    if (rc != (ssize_t)len)
+        SIMPLE_LOG_MSG(LL_NOTIFY, "sendto(fd=%d, nmsgs=%zu): %s",
+                       rnhhb->rnhhb_fd, rnhhb->rnhhb_nmsgs,
+                       rc < 0 ? strerror(errno) : "short send");
+
+    rnhhb->rnhhb_len = 0;
+    rnhhb->rnhhb_nmsgs = 0;
+}
+
+static void
+raft_net_host_hb_flush(void)
+{
+    for (size_t i = 0; i < raftNetHost.rnh_hb_nbatches; i++)
+        if (raftNetHost.rnh_hb_batches[i].rnhhb_nmsgs)
+            raft_net_host_hb_send(&raftNetHost.rnh_hb_batches[i]);
+
+    raftNetHost.rnh_hb_nbatches = 0;
+}
+
+/**
+ * raft_net_host_hb_enqueue - copy a hosted instance's heartbeat into the
+ *    host's batch for 'dest'.  Hosted groups align their heartbeat
+ *    deadlines, so the heartbeats of the groups which a process leads leave
+ *    in the same pass of the host's event loop and reach each peer process in
+ *    a single datagram.
+ */
+static int
+raft_net_host_hb_enqueue(struct raft_instance *ri, struct ctl_svc_node *csn,
+                         const struct sockaddr_in *dest,
+                         const struct iovec *iov)
+{
+    const int fd =
+        udp_socket_handle_2_sockfd(&ri->ri_ush[RAFT_UDP_LISTEN_SERVER]);
+    if (fd < 0)
+        return -EBADF;
+
+    struct raft_net_host_hb_batch *rnhhb = NULL;
+
+    for (size_t i = 0; i < raftNetHost.rnh_hb_nbatches && !rnhhb; i++)
+    {
+        struct raft_net_host_hb_batch *tmp = &raftNetHost.rnh_hb_batches[i];
+
+        if (tmp->rnhhb_fd == fd &&
+            tmp->rnhhb_dest.sin_addr.s_addr == dest->sin_addr.s_addr &&
+            tmp->rnhhb_dest.sin_port == dest->sin_port)
+            rnhhb = tmp;
+    }
+
+    if (!rnhhb)
+    {
+        if (raftNetHost.rnh_hb_nbatches == RAFT_NET_HOST_HB_MAX)
+            return -ENOSPC;
+
+        rnhhb = &raftNetHost.rnh_hb_batches[raftNetHost.rnh_hb_nbatches++];
+        rnhhb->rnhhb_dest = *dest;
+        rnhhb->rnhhb_fd = fd;
+        rnhhb->rnhhb_len = 0;
+        rnhhb->rnhhb_nmsgs = 0;
+    }
+
+    const size_t batch_size = MIN(RAFT_NET_HOST_HB_SZ, udp_get_max_size());
+
+    int rc = raft_net_rpc_msg_batch_add(rnhhb->rnhhb_buf, batch_size,
+                                        &rnhhb->rnhhb_len, iov->iov_base,
+                                        iov->iov_len);
+    if (rc == -ENOSPC && rnhhb->rnhhb_nmsgs)
+    {
+        raft_net_host_hb_send(rnhhb);
+        rc = raft_net_rpc_msg_batch_add(rnhhb->rnhhb_buf, batch_size,
+                                        &rnhhb->rnhhb_len, iov->iov_base,
+                                        iov->iov_len);
+    }
+
+    if (rc)
+        return rc;
+
+    rnhhb->rnhhb_nmsgs++;
+    raft_net_update_last_comm_time(ri, csn->csn_uuid, true);
+
+    return 0;
+}
+
+/**
+ * raft_net_send_msg_batched - queues a message onto 'rnusb' if it is to be
+ *    sent to a peer over UDP, the batch is flushed once it is full.  Other
+ *    messages are sent immediately through raft_net_send_msg().  The
+ *    heartbeats of hosted instances ('rnusb_host_coalesce') are instead
+ *    queued onto the host, to be sent along with those of the other groups.
+ */
+int
+raft_net_send_msg_batched(struct raft_instance *ri,
+                          struct raft_net_udp_send_batch *rnusb,
+                          struct ctl_svc_node *csn, struct iovec *iov)
+{
+    if (!ri || !rnusb || !csn || !iov)
+        return -EINVAL;
+
+    const enum raft_udp_listen_sockets sock_src = rnusb->rnusb_sock_src;
+
+    if (ri->ri_udp_mmsg_batch <= 1 || raft_instance_is_client(ri) ||
+        sock_src != RAFT_UDP_LISTEN_SERVER ||
+        iov->iov_len > udp_get_max_size() ||
+        iov->iov_len > raft_net_max_rpc_size(ri->ri_store_type) ||
+        !net_ctl_can_send(&csn->csn_peer.csnp_net_ctl))
+        return raft_net_send_msg(ri, csn, iov, 1, sock_src);
+
+    const size_t idx = rnusb->rnusb_nmsgs;
+
+    int rc = udp_setup_sockaddr_in(ctl_svc_node_peer_2_ipaddr(csn),
+                                   ctl_svc_node_peer_2_port(csn),
+                                   &rnusb->rnusb_dest[idx]);
+    if (rc)
+    {
+        LOG_MSG(LL_NOTIFY, "udp_setup_sockaddr_in(): %s (peer=%s:%hu)",
+                strerror(-rc), ctl_svc_node_peer_2_ipaddr(csn),
+                ctl_svc_node_peer_2_port(csn));
+
+        return rc;
+    }
+
+    if (ri->ri_hosted && rnusb->rnusb_host_coalesce &&
+        raft_net_peer_decodes_batch(ri, csn) &&
+        !raft_net_host_hb_enqueue(ri, csn, &rnusb->rnusb_dest[idx], iov))
+        return 0;
+
+    rnusb->rnusb_csn[idx] = csn;
+    rnusb->rnusb_iov[idx] = *iov;
+    rnusb->rnusb_nmsgs++;
+
+    if (rnusb->rnusb_nmsgs == MIN(ri->ri_udp_mmsg_batch,
+                                  RAFT_NET_UDP_MMSG_BATCH_MAX))
+        raft_net_udp_send_batch_flush(ri, rnusb);
+
+    return 0;
+}
+
 int
 raft_net_send_client_msg(struct raft_instance *ri,
                          struct raft_client_rpc_msg *rcrm)
@@ -2123,140 +4107,384 @@ raft_net_server_target_check(const struct raft_instance *ri,
                              const uuid_t server_uuid,
                              const unsigned long long stale_timeout_ms)
 {
-    return raft_net_server_target_check_by_idx(
-        ri, raft_peer_2_idx(ri, server_uuid), stale_timeout_ms);
-}
+    return raft_net_server_target_check_by_idx(
+        ri, raft_peer_2_idx(ri, server_uuid), stale_timeout_ms);
+}
+
+int
+raft_net_apply_leader_redirect(struct raft_instance *ri,
+                               const uuid_t redirect_target,
+                               const unsigned long long stale_timeout_ms)
+{
+    if (!ri || uuid_is_null(redirect_target))
+        return -EINVAL;
+
+    raft_peer_t leader_idx = raft_peer_2_idx(ri, redirect_target);
+    if (leader_idx == RAFT_PEER_ANY)
+        return -ENOENT;
+
+    // raft_peer_2_idx() should not return an out-of-bounds value.
+    NIOVA_ASSERT(leader_idx < CTL_SVC_MAX_RAFT_PEERS);
+
+    ri->ri_csn_leader = ri->ri_csn_raft_peers[leader_idx];
+
+    int rc = raft_net_server_target_check_by_idx(ri, leader_idx,
+                                                 stale_timeout_ms);
+
+    if (rc == -ETIMEDOUT)
+        timespec_clear(&ri->ri_last_send[leader_idx]); // "unstale" the leader
+
+    DBG_RAFT_INSTANCE(LL_NOTIFY, ri,
+                      "new leader via redirect (idx=%hhu) (rc=%d)",
+                      leader_idx, rc);
+
+    return 0;
+}
+
+void
+raft_net_timerfd_settime(struct raft_instance *ri, unsigned long long msecs)
+{
+    struct itimerspec its = {0};
+
+    msec_2_timespec(&its.it_value, msecs);
+
+    int rc = timerfd_settime(ri->ri_timer_fd, 0, &its, NULL);
+
+    FATAL_IF((rc), "timerfd_settime(): %s", strerror(errno));
+}
+
+raft_net_timerfd_cb_ctx_t
+raft_net_timerfd_cb(const struct epoll_handle *eph, uint32_t events)
+{
+    (void)events;
+    struct raft_instance *ri = eph->eph_arg;
+
+    ssize_t rc = niova_io_fd_drain(ri->ri_timer_fd, NULL);
+    if (rc)
+    {
+        // Something went awry with the timerfd read.
+        DBG_RAFT_INSTANCE(LL_NOTIFY, ri, "niova_io_fd_drain(): %zd", rc);
+        return;
+    }
+
+    if (ri->ri_ignore_timerfd)
+        raft_net_timerfd_settime(ri, 1);
+
+    else if (ri->ri_timer_fd_cb)
+        ri->ri_timer_fd_cb(ri);
+}
+
+static enum raft_udp_listen_sockets
+raft_net_udp_identify_socket(const struct raft_instance *ri, const int fd)
+{
+    for (enum raft_udp_listen_sockets i = RAFT_UDP_LISTEN_MIN;
+         i < RAFT_UDP_LISTEN_MAX; i++)
+        if (udp_socket_handle_2_sockfd(&ri->ri_ush[i]) == fd)
+            return i;
+
+    return RAFT_UDP_LISTEN_ANY;
+}
+
+/**
+ * raft_net_udp_msg_2_instance - find the hosted instance to which a msg
+ *    received on a shared listener is addressed.  The instance must be
+ *    attached to the listener and running.
+ */
+static struct raft_instance *
+raft_net_udp_msg_2_instance(const char *buf, const ssize_t len, const int fd,
+                            const enum raft_udp_listen_sockets sock)
+{
+    const unsigned char *raft_id = NULL;
+
+    if (sock == RAFT_UDP_LISTEN_SERVER &&
+        len >= (ssize_t)(offsetof(struct raft_rpc_msg, rrm_raft_id) +
+                         sizeof(uuid_t)))
+        raft_id = ((const struct raft_rpc_msg *)buf)->rrm_raft_id;
+
+    else if (sock == RAFT_UDP_LISTEN_CLIENT &&
+             len >= (ssize_t)(offsetof(struct raft_client_rpc_msg,
+                                       rcrm_raft_id) + sizeof(uuid_t)))
+        raft_id = ((const struct raft_client_rpc_msg *)buf)->rcrm_raft_id;
+
+    if (!raft_id)
+        return NULL;
+
+    struct raft_instance *ri = raft_net_instance_lookup(raft_id);
+
+    return (ri && ri->ri_hosted && raft_instance_is_running(ri) &&
+            !ri->ri_needs_bulk_recovery &&
+            udp_socket_handle_2_sockfd(&ri->ri_ush[sock]) == fd) ? ri : NULL;
+}
+
+/**
+ * raft_net_udp_msg_dispatch - hand a received msg to the receive callback of
+ *    its instance.  A NULL 'ri' denotes a shared listener, in which case the
+ *    msg is routed by the raft uuid it carries.
+ */
+static void
+raft_net_udp_msg_dispatch(struct raft_instance *ri, const int fd,
+                          const enum raft_udp_listen_sockets sock, char *buf,
+                          const ssize_t len, struct sockaddr_in *from)
+{
+    struct raft_instance *msg_ri = ri ? ri :
+        raft_net_udp_msg_2_instance(buf, len, fd, sock);
+
+    if (!msg_ri)
+    {
+        SIMPLE_LOG_MSG(LL_DEBUG, "fd=%d type=%d len=%zd no-inst", fd, sock,
+                       len);
+        return;
+    }
+
+    switch (sock)
+    {
+    case RAFT_UDP_LISTEN_SERVER:
+        if (msg_ri->ri_server_recv_cb)
+            msg_ri->ri_server_recv_cb(msg_ri, buf, len, from);
+        break;
+    case RAFT_UDP_LISTEN_CLIENT:
+        if (msg_ri->ri_client_recv_cb)
+            msg_ri->ri_client_recv_cb(msg_ri, buf, len, from);
+        break;
+    default:
+        break;
+    }
+}
+
+/**
+ * raft_net_udp_batch_dispatch - dispatch each of the server msgs carried by
+ *    a batch datagram.  The batch is checked as a whole before any of its
+ *    msgs are delivered.
+ */
+static void
+raft_net_udp_batch_dispatch(struct raft_instance *ri, const int fd,
+                            char *batch, const ssize_t len,
+                            struct sockaddr_in *from)
+{
+    ssize_t rc = raft_net_rpc_msg_batch_check(batch, len);
+    if (rc < 0)
+    {
+        SIMPLE_LOG_MSG(LL_NOTIFY, "fd=%d len=%zd bad batch: %s", fd, len,
+                       strerror(-rc));
+        return;
+    }
+
+    size_t off = 0;
+    size_t msg_off;
+
+    while ((rc = raft_net_rpc_msg_batch_next(batch, len, &off, &msg_off)) > 0)
+    {
+        raft_net_udp_msg_dispatch(ri, fd, RAFT_UDP_LISTEN_SERVER,
+                                  &batch[msg_off], rc, from);
+
+        if (ri && (ri->ri_needs_bulk_recovery || raft_instance_is_shutdown(ri)))
+            break;
+    }
+}
+
+/**
+ * raft_net_udp_recv - this is the receive handler for all incoming UDP
+ *    requests and replies.  The program is single threaded so the msg sink
+ *    buffers are allocated statically here.  Up to ri_udp_mmsg_batch
+ *    datagrams are drained with a single recvmmsg() and dispatched in the
+ *    order received.  Operations that can be handled from this callback are:
+ *    client RPC requests, vote requests (if peer is candidate), vote replies
+ *    (if self is candidate).  A NULL 'ri' denotes a shared listener, in which
+ *    case each msg is routed by the raft uuid it carries.
+ */
+static void
+raft_net_udp_recv(struct raft_instance *ri, const int fd,
+                  const enum raft_udp_listen_sockets sock)
+{
+    static char sink_bufs[RAFT_NET_UDP_MMSG_BATCH_MAX][NIOVA_MAX_UDP_SIZE];
+    static struct sockaddr_in from[RAFT_NET_UDP_MMSG_BATCH_MAX];
+    static struct iovec iovs[RAFT_NET_UDP_MMSG_BATCH_MAX];
+    static struct mmsghdr msgs[RAFT_NET_UDP_MMSG_BATCH_MAX];
 
-int
-raft_net_apply_leader_redirect(struct raft_instance *ri,
-                               const uuid_t redirect_target,
-                               const unsigned long long stale_timeout_ms)
-{
-    if (!ri || uuid_is_null(redirect_target))
-        return -EINVAL;
+    // The batch tunable of the default instance applies to shared listeners
+    const size_t batch =
+        ri ? ri->ri_udp_mmsg_batch : raftInstance.ri_udp_mmsg_batch;
 
-    raft_peer_t leader_idx = raft_peer_2_idx(ri, redirect_target);
-    if (leader_idx == RAFT_PEER_ANY)
-        return -ENOENT;
+    const unsigned int vlen = MAX(1, MIN(batch, RAFT_NET_UDP_MMSG_BATCH_MAX));
 
-    // raft_peer_2_idx() should not return an out-of-bounds value.
-    NIOVA_ASSERT(leader_idx < CTL_SVC_MAX_RAFT_PEERS);
+    for (unsigned int i = 0; i < vlen; i++)
+    {
+        iovs[i].iov_base = (void *)sink_bufs[i];
+        iovs[i].iov_len = NIOVA_MAX_UDP_SIZE;
+
+        memset(&msgs[i], 0, sizeof(struct mmsghdr));
+        msgs[i].msg_hdr.msg_name = &from[i];
+        msgs[i].msg_hdr.msg_namelen = sizeof(struct sockaddr_in);
+        msgs[i].msg_hdr.msg_iov = &iovs[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+    }
 
-    ri->ri_csn_leader = ri->ri_csn_raft_peers[leader_idx];
+    /* Clear the fd descriptor before doing any other error checks on the
+     * sender.
+     */
+    int nmsgs = 1;
 
-    int rc = raft_net_server_target_check_by_idx(ri, leader_idx,
-                                                 stale_timeout_ms);
+    if (vlen == 1)
+    {
+        ssize_t recv_bytes = udp_socket_recv_fd(fd, iovs, 1, &from[0], false);
 
-    if (rc == -ETIMEDOUT)
-        timespec_clear(&ri->ri_last_send[leader_idx]); // "unstale" the leader
+        if (recv_bytes < 0) // return from a general recv error
+        {
+            SIMPLE_LOG_MSG(LL_NOTIFY, "udp_socket_recv_fd(fd=%d):  %s",
+                           fd, strerror(-recv_bytes));
+            return;
+        }
 
-    DBG_RAFT_INSTANCE(LL_NOTIFY, ri,
-                      "new leader via redirect (idx=%hhu) (rc=%d)",
-                      leader_idx, rc);
+        msgs[0].msg_len = recv_bytes;
+    }
+    else
+    {
+        nmsgs = recvmmsg(fd, msgs, vlen, MSG_DONTWAIT, NULL);
+        if (nmsgs <= 0) // return from a general recv error
+        {
+            SIMPLE_LOG_MSG(LL_NOTIFY, "recvmmsg(fd=%d):  %s",
+                           fd, strerror(nmsgs ? errno : EAGAIN));
+            return;
+        }
+    }
 
-    return 0;
+    for (int i = 0; i < nmsgs; i++)
+    {
+        const ssize_t recv_bytes = msgs[i].msg_len;
+
+        if (msgs[i].msg_hdr.msg_flags & MSG_TRUNC)
+            continue;
+
+        SIMPLE_LOG_MSG(LL_DEBUG, "fd=%d type=%d rc=%zd (%d/%d)",
+                       fd, sock, recv_bytes, i + 1, nmsgs);
+
+        const struct raft_rpc_msg_batch_hdr *hdr =
+            (const struct raft_rpc_msg_batch_hdr *)sink_bufs[i];
+
+        if (sock == RAFT_UDP_LISTEN_SERVER &&
+            recv_bytes >= (ssize_t)sizeof(*hdr) &&
+            hdr->rrmbh_type == RAFT_RPC_MSG_TYPE_BATCH)
+            raft_net_udp_batch_dispatch(ri, fd, sink_bufs[i], recv_bytes,
+                                        &from[i]);
+        else
+            raft_net_udp_msg_dispatch(ri, fd, sock, sink_bufs[i], recv_bytes,
+                                      &from[i]);
+
+        /* The remaining msgs are dropped if the instance is being torn down.
+         * On a shared listener the other instances' msgs are still
+         * delivered.
+         */
+        if (ri && (ri->ri_needs_bulk_recovery || raft_instance_is_shutdown(ri)))
+            break;
+    }
 }
 
-void
-raft_net_timerfd_settime(struct raft_instance *ri, unsigned long long msecs)
+static raft_net_cb_ctx_t
+raft_net_udp_cb(const struct epoll_handle *eph, uint32_t events)
 {
-    struct itimerspec its = {0};
+    (void)events;
+    SIMPLE_FUNC_ENTRY(LL_TRACE);
 
-    msec_2_timespec(&its.it_value, msecs);
+    NIOVA_ASSERT(eph && eph->eph_arg);
 
-    int rc = timerfd_settime(ri->ri_timer_fd, 0, &its, NULL);
+    struct raft_instance *ri = eph->eph_arg;
 
-    FATAL_IF((rc), "timerfd_settime(): %s", strerror(errno));
+    raft_net_udp_recv(ri, eph->eph_fd,
+                      raft_net_udp_identify_socket(ri, eph->eph_fd));
 }
 
-raft_net_timerfd_cb_ctx_t
-raft_net_timerfd_cb(const struct epoll_handle *eph, uint32_t events)
+static raft_net_cb_ctx_t
+raft_net_host_udp_cb(const struct epoll_handle *eph, uint32_t events)
 {
     (void)events;
-    struct raft_instance *ri = eph->eph_arg;
+    SIMPLE_FUNC_ENTRY(LL_TRACE);
 
-    ssize_t rc = niova_io_fd_drain(ri->ri_timer_fd, NULL);
-    if (rc)
-    {
-        // Something went awry with the timerfd read.
-        DBG_RAFT_INSTANCE(LL_NOTIFY, ri, "niova_io_fd_drain(): %zd", rc);
-        return;
-    }
+    NIOVA_ASSERT(eph && eph->eph_arg);
 
-    if (ri->ri_ignore_timerfd)
-        raft_net_timerfd_settime(ri, 1);
+    const struct raft_net_host_udp_listener *rnhul = eph->eph_arg;
 
-    else if (ri->ri_timer_fd_cb)
-        ri->ri_timer_fd_cb(ri);
+    raft_net_udp_recv(NULL, eph->eph_fd, rnhul->rnhul_type);
 }
 
-static enum raft_udp_listen_sockets
-raft_net_udp_identify_socket(const struct raft_instance *ri, const int fd)
+/**
+ * raft_net_write_supp_seg_add - append a new item segment to 'rnsws'.  Each
+ *   segment doubles the capacity of the previous one so that the number of
+ *   allocations is logarithmic in the number of items and existing items are
+ *   never copied.
+ */
+static struct raft_net_wr_supp_seg *
+raft_net_write_supp_seg_add(struct raft_net_sm_write_supplements *rnsws)
 {
-    for (enum raft_udp_listen_sockets i = RAFT_UDP_LISTEN_MIN;
-         i < RAFT_UDP_LISTEN_MAX; i++)
-        if (udp_socket_handle_2_sockfd(&ri->ri_ush[i]) == fd)
-            return i;
+    const struct raft_net_wr_supp_seg *tail = rnsws->rnsws_seg_tail;
 
-    return RAFT_UDP_LISTEN_ANY;
+    size_t capacity = tail ?
+        MIN((tail->rnwss_capacity * 2), RAFT_NET_WR_SUPP_SEG_MAX_ITEMS) :
+        RAFT_NET_WR_SUPP_SEG_MIN_ITEMS;
+
+    capacity = MIN(capacity, (RAFT_NET_WR_SUPP_MAX - rnsws->rnsws_nitems));
+
+    struct raft_net_wr_supp_seg *seg =
+        niova_malloc(sizeof(struct raft_net_wr_supp_seg) +
+                     (capacity * sizeof(struct raft_net_wr_supp)));
+    if (!seg)
+        return NULL;
+
+    seg->rnwss_next = NULL;
+    seg->rnwss_nitems = 0;
+    seg->rnwss_capacity = capacity;
+
+    if (rnsws->rnsws_seg_tail)
+        rnsws->rnsws_seg_tail->rnwss_next = seg;
+    else
+        rnsws->rnsws_seg_head = seg;
+
+    rnsws->rnsws_seg_tail = seg;
+
+    return seg;
 }
 
 /**
- * raft_net_udp_cb - this is the receive handler for all incoming UDP
- *    requests and replies.  The program is single threaded so the msg sink
- *    buffers are allocated statically here.  Operations that can be handled
- *    from this callback are:  client RPC requests, vote requests (if
- *    peer is candidate), vote replies (if self is candidate).
+ * raft_net_write_supp_arena_alloc - carve 'size' bytes from the supplement
+ *   arena.  A new chunk is placed at the head of the chunk list when the
+ *   current one cannot satisfy the request.  Chunk sizes grow geometrically
+ *   up to RAFT_NET_WR_SUPP_ARENA_MAX_SIZE; larger requests get a chunk of
+ *   their own.  'size' is rounded up to RAFT_NET_WR_SUPP_ARENA_ALIGN.
  */
-static raft_net_cb_ctx_t
-raft_net_udp_cb(const struct epoll_handle *eph, uint32_t events)
+static char *
+raft_net_write_supp_arena_alloc(struct raft_net_sm_write_supplements *rnsws,
+                                const size_t size)
 {
-    (void)events;
-    SIMPLE_FUNC_ENTRY(LL_TRACE);
+    struct raft_net_wr_supp_arena_chunk *chunk = rnsws->rnsws_arena;
 
-    static char sink_buf[NIOVA_MAX_UDP_SIZE];
-    static struct sockaddr_in from;
-    static struct iovec iovs[1] = {
-        [0].iov_base = (void *)sink_buf,
-        [0].iov_len  = NIOVA_MAX_UDP_SIZE,
-    };
+    // Keep every allocation aligned, the chunk data is aligned as well
+    const size_t asize = (size + RAFT_NET_WR_SUPP_ARENA_ALIGN - 1) &
+        ~(RAFT_NET_WR_SUPP_ARENA_ALIGN - 1);
 
-    NIOVA_ASSERT(eph && eph->eph_arg);
+    if (!chunk || (chunk->rnwsac_size - chunk->rnwsac_used) < asize)
+    {
+        size_t chunk_size = chunk ?
+            MIN((chunk->rnwsac_size * 2), RAFT_NET_WR_SUPP_ARENA_MAX_SIZE) :
+            RAFT_NET_WR_SUPP_ARENA_MIN_SIZE;
 
-    struct raft_instance *ri = eph->eph_arg;
-    NIOVA_ASSERT(ri);
+        chunk_size = MAX(chunk_size, asize);
 
-    /* Clear the fd descriptor before doing any other error checks on the
-     * sender.
-     */
-    ssize_t recv_bytes =
-        udp_socket_recv_fd(eph->eph_fd, iovs, 1, &from, false);
+        struct raft_net_wr_supp_arena_chunk *new_chunk =
+            niova_malloc(sizeof(struct raft_net_wr_supp_arena_chunk) +
+                         chunk_size);
+        if (!new_chunk)
+            return NULL;
 
-    if (recv_bytes < 0) // return from a general recv error
-    {
-        DBG_RAFT_INSTANCE(LL_NOTIFY, ri, "udp_socket_recv_fd():  %s",
-                          strerror(-recv_bytes));
-        return;
+        new_chunk->rnwsac_next = chunk;
+        new_chunk->rnwsac_size = chunk_size;
+        new_chunk->rnwsac_used = 0;
+
+        rnsws->rnsws_arena = chunk = new_chunk;
     }
 
-    DBG_RAFT_INSTANCE(LL_DEBUG, ri, "fd=%d type=%d rc=%zd",
-                      eph->eph_fd,
-                      raft_net_udp_identify_socket(ri, eph->eph_fd),
-                      recv_bytes);
+    char *buf = &chunk->rnwsac_data[chunk->rnwsac_used];
+    chunk->rnwsac_used += asize;
 
-    switch (raft_net_udp_identify_socket(ri, eph->eph_fd))
-    {
-    case RAFT_UDP_LISTEN_SERVER:
-        if (ri->ri_server_recv_cb)
-            ri->ri_server_recv_cb(ri, sink_buf, recv_bytes, &from);
-        break;
-    case RAFT_UDP_LISTEN_CLIENT:
-        if (ri->ri_client_recv_cb)
-            ri->ri_client_recv_cb(ri, sink_buf, recv_bytes, &from);
-        break;
-    default:
-        break;
-    }
+    return buf;
 }
 
 /**
@@ -2273,21 +4501,24 @@ raft_net_write_supp_new(struct raft_net_sm_write_supplements *rnsws,
     if (rnsws->rnsws_nitems == RAFT_NET_WR_SUPP_MAX)
         return NULL;
 
-    const size_t idx = rnsws->rnsws_nitems;
+    struct raft_net_wr_supp_seg *seg = rnsws->rnsws_seg_tail;
 
-    int rc = niova_reallocarray(rnsws->rnsws_ws, struct raft_net_wr_supp,
-                                idx + 1UL);
-    if (rc)
-        return NULL;
+    if (!seg || seg->rnwss_nitems == seg->rnwss_capacity)
+    {
+        seg = raft_net_write_supp_seg_add(rnsws);
+        if (!seg)
+            return NULL;
+    }
 
+    struct raft_net_wr_supp *ws = &seg->rnwss_items[seg->rnwss_nitems++];
     rnsws->rnsws_nitems++;
 
     // Initialize pointers to NULL
-    memset(&rnsws->rnsws_ws[idx], 0, sizeof(struct raft_net_wr_supp));
+    memset(ws, 0, sizeof(struct raft_net_wr_supp));
 
-    rnsws->rnsws_ws[idx].rnws_handle = handle;
+    ws->rnws_handle = handle;
 
-    return &rnsws->rnsws_ws[idx];
+    return ws;
 }
 
 static void
@@ -2296,48 +4527,199 @@ raft_net_write_supp_destroy(struct raft_net_wr_supp *ws)
     if (!ws)
         return;
 
-    niova_free(ws->rnws_key);
-    niova_free(ws->rnws_value);
-
+    // Key and value memory belongs to the supplement arena
     if (ws->rnws_comp_cb)
         ws->rnws_comp_cb(ws->rnws_handle);
-    
 }
 
 static int
-raft_net_write_supp_add(struct raft_net_wr_supp *ws,
+raft_net_write_supp_add(struct raft_net_sm_write_supplements *rnsws,
+                        struct raft_net_wr_supp *ws,
                         enum raft_net_wr_supp_op op,
-                        const char *key, const size_t key_size, 
+                        const char *key, const size_t key_size,
                         const char *value, const size_t value_size)
 {
-    if (!ws || !key || !key_size)
+    if (!rnsws || !ws || !key || !key_size)
         return -EINVAL;
 
     NIOVA_ASSERT(op < RAFT_NET_WR_SUPP_OP__MAX);
     ws->rnws_op = op;
 
-    ws->rnws_key = niova_malloc(key_size);
-    if (!ws->rnws_key)
+    // Place the key and value adjacently in a single arena allocation
+    char *buf = raft_net_write_supp_arena_alloc(rnsws, key_size + value_size);
+    if (!buf)
         return -ENOMEM;
 
-    ws->rnws_value = niova_malloc(value_size);
-    if (!ws->rnws_value)
-    {
-        niova_free(ws->rnws_key);
-        return -ENOMEM;
-    }
+    ws->rnws_key = buf;
+    ws->rnws_value = buf + key_size;
 
     memcpy(ws->rnws_key, key, key_size);
-    memcpy(ws->rnws_value, value, value_size);
+    if (value_size)
+        memcpy(ws->rnws_value, value, value_size);
 
     ws->rnws_key_size = key_size;
     ws->rnws_value_size = value_size;
 
-    LOG_MSG(LL_DEBUG, "ws=%p key=%s", ws, key);
+    LOG_MSG(LL_DEBUG, "ws=%p key=%.*s", ws, (int)key_size, key);
 
     return 0;
 }
 
+/* Each cache slot holds a handle with its classification in the low bit so
+ * that lockless readers load both with a single access.  Handles are heap
+ * pointers and therefore at least 2-byte aligned.
+ */
+#define RAFT_NET_WR_SUPP_CF_KV_CRC_BIT 1UL
+
+static uintptr_t raftNetWrSuppCfCache[RAFT_NET_WR_SUPP_CF_CACHE_SIZE];
+static size_t raftNetWrSuppCfEvictIdx;
+
+static pthread_mutex_t raftNetWrSuppCfMutex = PTHREAD_MUTEX_INITIALIZER;
+
+static uintptr_t
+raft_net_wr_supp_cf_slot_handle(const uintptr_t slot)
+{
+    return slot & ~RAFT_NET_WR_SUPP_CF_KV_CRC_BIT;
+}
+
+/**
+ * raft_net_wr_supp_cf_name_is_kv_crc - the name test which the KV CRC chain
+ *    has always used.  Note that strncmp() is bounded by the CF name's length
+ *    so a name which is a prefix of RAFT_NET_WR_SUPP_KV_CRC_CF_NAME matches
+ *    as well.  This must not change since peers must agree on the chain.
+ */
+bool
+raft_net_wr_supp_cf_name_is_kv_crc(const char *cf_name,
+                                   const size_t cf_name_len)
+{
+    return (cf_name && cf_name_len > 0 &&
+            !strncmp(cf_name, RAFT_NET_WR_SUPP_KV_CRC_CF_NAME, cf_name_len)) ?
+        true : false;
+}
+
+/**
+ * raft_net_wr_supp_cf_register - records the KV CRC classification of a
+ *    column family handle.  When the cache is full, a slot is evicted in
+ *    round-robin order, an evicted handle is classified by name again on its
+ *    next use.
+ */
+int
+raft_net_wr_supp_cf_register(const void *cf_handle, const bool kv_crc)
+{
+    if (!cf_handle || ((uintptr_t)cf_handle & RAFT_NET_WR_SUPP_CF_KV_CRC_BIT))
+        return -EINVAL;
+
+    const uintptr_t new_slot =
+        (uintptr_t)cf_handle | (kv_crc ? RAFT_NET_WR_SUPP_CF_KV_CRC_BIT : 0);
+
+    uintptr_t *free_slot = NULL;
+    int rc = 0;
+
+    niova_mutex_lock(&raftNetWrSuppCfMutex);
+
+    for (size_t i = 0; i < RAFT_NET_WR_SUPP_CF_CACHE_SIZE; i++)
+    {
+        const uintptr_t slot = raftNetWrSuppCfCache[i];
+
+        if (raft_net_wr_supp_cf_slot_handle(slot) == (uintptr_t)cf_handle)
+        {
+            free_slot = NULL;
+            rc = slot == new_slot ? -EALREADY : -EEXIST;
+            break;
+        }
+        else if (!slot && !free_slot)
+        {
+            free_slot = &raftNetWrSuppCfCache[i];
+        }
+    }
+
+    if (!rc && !free_slot)
+    {
+        free_slot = &raftNetWrSuppCfCache[raftNetWrSuppCfEvictIdx];
+
+        raftNetWrSuppCfEvictIdx =
+            (raftNetWrSuppCfEvictIdx + 1) % RAFT_NET_WR_SUPP_CF_CACHE_SIZE;
+    }
+
+    if (free_slot)
+        __atomic_store_n(free_slot, new_slot, __ATOMIC_RELEASE);
+
+    niova_mutex_unlock(&raftNetWrSuppCfMutex);
+
+    return rc;
+}
+
+/**
+ * raft_net_wr_supp_cf_unregister - removes the handle from the cache.  This
+ *    must be called before a column family handle is destroyed, or its CF is
+ *    dropped, since the handle's address may be reused by another CF.
+ */
+void
+raft_net_wr_supp_cf_unregister(const void *cf_handle)
+{
+    if (!cf_handle)
+        return;
+
+    niova_mutex_lock(&raftNetWrSuppCfMutex);
+
+    for (size_t i = 0; i < RAFT_NET_WR_SUPP_CF_CACHE_SIZE; i++)
+        if (raft_net_wr_supp_cf_slot_handle(raftNetWrSuppCfCache[i]) ==
+            (uintptr_t)cf_handle)
+            __atomic_store_n(&raftNetWrSuppCfCache[i], 0, __ATOMIC_RELEASE);
+
+    niova_mutex_unlock(&raftNetWrSuppCfMutex);
+}
+
+static bool
+raft_net_wr_supp_cf_lookup(const void *cf_handle, bool *ret_kv_crc)
+{
+    for (size_t i = 0; i < RAFT_NET_WR_SUPP_CF_CACHE_SIZE; i++)
+    {
+        const uintptr_t slot =
+            __atomic_load_n(&raftNetWrSuppCfCache[i], __ATOMIC_ACQUIRE);
+
+        if (raft_net_wr_supp_cf_slot_handle(slot) == (uintptr_t)cf_handle)
+        {
+            *ret_kv_crc = (slot & RAFT_NET_WR_SUPP_CF_KV_CRC_BIT) ?
+                true : false;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * raft_net_wr_supp_cf_is_kv_crc - determines if KVs written to 'cf_handle'
+ *    take part in the KV CRC chain.  Handles are normally classified when the
+ *    backend opens its column families.  Unknown handles fall back to a name
+ *    lookup whose result is cached for subsequent calls.
+ */
+static bool
+raft_net_wr_supp_cf_is_kv_crc(const void *cf_handle)
+{
+    bool kv_crc = false;
+
+    if (raft_net_wr_supp_cf_lookup(cf_handle, &kv_crc))
+        return kv_crc;
+
+    size_t cf_name_len = 0;
+    char *cf_name = rocksdb_column_family_handle_get_name(
+        (rocksdb_column_family_handle_t *)cf_handle, &cf_name_len);
+
+    kv_crc = raft_net_wr_supp_cf_name_is_kv_crc(cf_name, cf_name_len);
+
+    if (cf_name)
+        niova_free(cf_name);
+
+    int rc = raft_net_wr_supp_cf_register(cf_handle, kv_crc);
+    if (rc && rc != -EALREADY)
+        LOG_MSG(LL_NOTIFY, "raft_net_wr_supp_cf_register(%p): %s",
+                cf_handle, strerror(-rc));
+
+    return kv_crc;
+}
+
 static void
 raft_net_sm_write_supplement_crc_update(
     struct raft_net_sm_write_supplements *rnsws,
@@ -2348,38 +4730,40 @@ raft_net_sm_write_supplement_crc_update(
         return;
 
     // Filter: only hash KVs from user CF (PMDBTS_CF), skip internal metadata
-    if (ws->rnws_handle)
-    {
-        size_t cf_name_len = 0;
-        char *cf_name = rocksdb_column_family_handle_get_name(
-            (rocksdb_column_family_handle_t *)ws->rnws_handle, &cf_name_len);
-        
-        bool is_user_cf = (cf_name && cf_name_len > 0 && 
-                          strncmp(cf_name, "PMDBTS_CF", cf_name_len) == 0);
-        
-        if (cf_name)
-            niova_free(cf_name);
-        
-        if (!is_user_cf)
-        {
-            LOG_MSG(LL_TRACE, "KV_CRC_SKIP: key='%.*s' key_sz=%zu val_sz=%zu (not user CF)",
-                    (int)MIN(ws->rnws_key_size, 64), ws->rnws_key ? ws->rnws_key : "(null)",
-                    ws->rnws_key_size, ws->rnws_value_size);
-            return;
-        }
+    if (ws->rnws_handle && !raft_net_wr_supp_cf_is_kv_crc(ws->rnws_handle))
+    {
+        LOG_MSG(LL_TRACE, "KV_CRC_SKIP: key='%.*s' key_sz=%zu val_sz=%zu (not user CF)",
+                (int)MIN(ws->rnws_key_size, 64), ws->rnws_key ? ws->rnws_key : "(null)",
+                ws->rnws_key_size, ws->rnws_value_size);
+        return;
     }
 
     crc32_t old_crc = rnsws->rnsws_kv_crc;
 
-    // Chain the CRC: use previous running checksum as seed for key
-    if (ws->rnws_key && ws->rnws_key_size)
-        rnsws->rnsws_kv_crc = niova_crc((const unsigned char *)ws->rnws_key,
-                                        ws->rnws_key_size, rnsws->rnsws_kv_crc);
-
-    // Continue chaining with value
-    if (ws->rnws_value && ws->rnws_value_size)
-        rnsws->rnsws_kv_crc = niova_crc((const unsigned char *)ws->rnws_value,
-                                        ws->rnws_value_size, rnsws->rnsws_kv_crc);
+    /* Chain the CRC: use previous running checksum as seed for key and then
+     * continue with the value.  The supplement arena places the value
+     * directly behind the key, so the pair is normally hashed in one pass.
+     */
+    if (ws->rnws_key && ws->rnws_key_size && ws->rnws_value_size &&
+        ws->rnws_value == ws->rnws_key + ws->rnws_key_size)
+    {
+        rnsws->rnsws_kv_crc =
+            niova_crc((const unsigned char *)ws->rnws_key,
+                      ws->rnws_key_size + ws->rnws_value_size,
+                      rnsws->rnsws_kv_crc);
+    }
+    else
+    {
+        if (ws->rnws_key && ws->rnws_key_size)
+            rnsws->rnsws_kv_crc =
+                niova_crc((const unsigned char *)ws->rnws_key,
+                          ws->rnws_key_size, rnsws->rnsws_kv_crc);
+
+        if (ws->rnws_value && ws->rnws_value_size)
+            rnsws->rnsws_kv_crc =
+                niova_crc((const unsigned char *)ws->rnws_value,
+                          ws->rnws_value_size, rnsws->rnsws_kv_crc);
+    }
 
     LOG_MSG(LL_TRACE, "KV_CRC_UPDATE: key='%.*s' key_sz=%zu val_sz=%zu old_running=0x%x new_running=0x%x",
             (int)MIN(ws->rnws_key_size, 64), ws->rnws_key ? ws->rnws_key : "(null)",
@@ -2487,30 +4871,55 @@ raft_net_sm_write_supplement_add(struct raft_net_sm_write_supplements *rnsws,
     if (rnws_comp_cb) // Apply the callback if it was specified
         ws->rnws_comp_cb = rnws_comp_cb;
 
-    int rc = raft_net_write_supp_add(ws, op, key, key_size, value, value_size);
+    int rc = raft_net_write_supp_add(rnsws, ws, op, key, key_size, value,
+                                     value_size);
     if (!rc)
+    {
         raft_net_sm_write_supplement_crc_update(rnsws, ws);
+    }
+    else
+    {
+        // Drop the item which was just reserved
+        ws->rnws_comp_cb = NULL;
+        rnsws->rnsws_seg_tail->rnwss_nitems--;
+        rnsws->rnsws_nitems--;
+    }
 
     return rc;
 }
 
-static void
-raft_net_sm_write_supplement_destroy_internal(
-    struct raft_net_sm_write_supplements *rnsws, bool ws_destroy)
+/**
+ * raft_net_sm_write_supplement_get - returns item 'idx' of the supplements
+ *    or NULL if there is no such item.  Items are held in segments rather
+ *    than a single array, this walks the segments whose sizes double.
+ */
+struct raft_net_wr_supp *
+raft_net_sm_write_supplement_get(
+    const struct raft_net_sm_write_supplements *rnsws, size_t idx)
 {
-    if (!rnsws || !rnsws->rnsws_nitems)
-        return;
+    if (!rnsws || idx >= rnsws->rnsws_nitems)
+        return NULL;
 
-    if  (ws_destroy)
+    struct raft_net_wr_supp_seg *seg;
+
+    RAFT_NET_SM_WRITE_SUPP_SEG_FOREACH(rnsws, seg)
     {
-        for (size_t i = 0; i < rnsws->rnsws_nitems; i++)
-            raft_net_write_supp_destroy(&rnsws->rnsws_ws[i]);
+        if (idx < seg->rnwss_nitems)
+            return &seg->rnwss_items[idx];
+
+        idx -= seg->rnwss_nitems;
     }
 
-    niova_free(rnsws->rnsws_ws);
+    return NULL;
+}
 
-    rnsws->rnsws_ws = NULL;
+static void
+raft_net_sm_write_supplement_reset(struct raft_net_sm_write_supplements *rnsws)
+{
     rnsws->rnsws_nitems = 0;
+    rnsws->rnsws_seg_head = NULL;
+    rnsws->rnsws_seg_tail = NULL;
+    rnsws->rnsws_arena = NULL;
     rnsws->rnsws_kv_crc = 0;
     rnsws->rnsws_kv_crc_enabled = false;
 }
@@ -2519,9 +4928,38 @@ void
 raft_net_sm_write_supplement_destroy(
     struct raft_net_sm_write_supplements *rnsws)
 {
-    return raft_net_sm_write_supplement_destroy_internal(rnsws, true);
+    if (!rnsws)
+        return;
+
+    struct raft_net_wr_supp_seg *seg = rnsws->rnsws_seg_head;
+    while (seg)
+    {
+        struct raft_net_wr_supp_seg *next = seg->rnwss_next;
+
+        for (size_t i = 0; i < seg->rnwss_nitems; i++)
+            raft_net_write_supp_destroy(&seg->rnwss_items[i]);
+
+        niova_free(seg);
+        seg = next;
+    }
+
+    struct raft_net_wr_supp_arena_chunk *chunk = rnsws->rnsws_arena;
+    while (chunk)
+    {
+        struct raft_net_wr_supp_arena_chunk *next = chunk->rnwsac_next;
+
+        niova_free(chunk);
+        chunk = next;
+    }
+
+    raft_net_sm_write_supplement_reset(rnsws);
 }
 
+/**
+ * raft_net_sm_write_supplements_merge - moves the items of 'src' onto the end
+ *    of 'dest' by splicing the item segments and arena chunks.  No item, key,
+ *    or value is copied or reallocated.  'src' is left empty.
+ */
 int
 raft_net_sm_write_supplements_merge(struct raft_net_sm_write_supplements *dest,
                                     struct raft_net_sm_write_supplements *src)
@@ -2538,14 +4976,32 @@ raft_net_sm_write_supplements_merge(struct raft_net_sm_write_supplements *dest,
     if (new_total > RAFT_NET_WR_SUPP_MAX)
         return -E2BIG;
 
-    int rc =
-        niova_reallocarray(dest->rnsws_ws, struct raft_net_wr_supp, new_total);
+    if (dest->rnsws_seg_tail)
+        dest->rnsws_seg_tail->rnwss_next = src->rnsws_seg_head;
+    else
+        dest->rnsws_seg_head = src->rnsws_seg_head;
 
-    if (rc)
-        return rc;
+    dest->rnsws_seg_tail = src->rnsws_seg_tail;
+
+    /* Place the src chunks behind dest's allocating chunk so that dest
+     * continues to fill its current chunk.
+     */
+    if (src->rnsws_arena)
+    {
+        struct raft_net_wr_supp_arena_chunk *src_tail = src->rnsws_arena;
+        while (src_tail->rnwsac_next)
+            src_tail = src_tail->rnwsac_next;
 
-    for (size_t i = 0; i < src->rnsws_nitems; i++)
-        dest->rnsws_ws[dest->rnsws_nitems + i] = src->rnsws_ws[i];
+        if (dest->rnsws_arena)
+        {
+            src_tail->rnwsac_next = dest->rnsws_arena->rnwsac_next;
+            dest->rnsws_arena->rnwsac_next = src->rnsws_arena;
+        }
+        else
+        {
+            dest->rnsws_arena = src->rnsws_arena;
+        }
+    }
 
     dest->rnsws_nitems = new_total;
 
@@ -2553,8 +5009,8 @@ raft_net_sm_write_supplements_merge(struct raft_net_sm_write_supplements *dest,
     dest->rnsws_kv_crc = 0;
     dest->rnsws_kv_crc_enabled = false;
 
-    // Release only the src's rnsws_ws array, leaving the merged items intact
-    raft_net_sm_write_supplement_destroy_internal(src, false);
+    // The merged items now belong to dest
+    raft_net_sm_write_supplement_reset(src);
 
     return 0;
 }
@@ -2584,11 +5040,7 @@ void
 raft_net_sm_write_supplement_init(struct raft_net_sm_write_supplements *rnsws)
 {
     if (rnsws)
-    {
-        rnsws->rnsws_nitems = 0;
-        rnsws->rnsws_kv_crc = 0;
-        rnsws->rnsws_kv_crc_enabled = false;
-    }
+        raft_net_sm_write_supplement_reset(rnsws);
 }
 
 void
@@ -9,6 +9,7 @@
 #include <unistd.h>
 #include <fcntl.h>
 #include <sys/timerfd.h>
+#include <time.h>
 #include <linux/limits.h>
 
 #include "niova/alloc.h"
@@ -30,6 +31,14 @@
 #include "raft_net.h"
 
 #define RAFT_SERVER_RECOVERY_ATTEMPTS 100
+#define RAFT_SERVER_HOST_POLL_MSEC 100
+
+// Interval of the hosted groups' chkpt passes, as with the chkpt thread
+#define RAFT_SERVER_HOST_CHKPT_FREQ_US 1000000
+
+// Wait period which bounds the host worker threads' response to a halt
+#define RAFT_SERVER_HOST_WORKER_WAIT_US 100000
+
 LREG_ROOT_ENTRY_GENERATE(raft_root_entry, LREG_USER_TYPE_RAFT);
 
 enum raft_write_entry_opts
@@ -47,6 +56,53 @@ REGISTRY_ENTRY_FILE_GENERATE;
 #define RAFT_SERVER_SYNC_MAX_FREQ_US 100000000
 #define RAFT_SERVER_SYNC_FREQ_US 4000
 
+// Group-commit batching limits for the sync thread
+#define RAFT_SERVER_SYNC_MAX_BATCH_DELAY_US 0
+#define RAFT_SERVER_SYNC_MAX_BATCH_DELAY_US_MAX 100000
+#define RAFT_SERVER_SYNC_MAX_BATCH_SIZE 256
+#define RAFT_SERVER_SYNC_MAX_BATCH_SIZE_MAX 65536
+
+// Number of unacknowledged AE requests which may be in flight per follower
+#define RAFT_SERVER_AE_WINDOW_DEFAULT 1
+#define RAFT_SERVER_AE_WINDOW_MAX 64
+
+// Number of consecutive raft indexes which may be packed into one AE request
+#define RAFT_SERVER_AE_PACKED_IDX_DEFAULT 1
+#define RAFT_SERVER_AE_PACKED_IDX_MAX 32
+
+// Reads are processed inline once the least loaded worker queue is this deep
+#define RAFT_SERVER_READ_QUEUE_MAX_DEPTH 1024
+
+// Wait period which bounds a read worker's response to a halt request
+#define RAFT_SERVER_READ_WORKER_WAIT_US 100000
+
+/* Read pin slot claims spin for a few passes over the slots, then sleep with
+ * a backoff.  Failing to claim a slot within the timeout indicates a pin leak.
+ */
+#define RAFT_SERVER_READ_PIN_SPIN_PASSES 4
+#define RAFT_SERVER_READ_PIN_SLEEP_MAX_US 1000
+#define RAFT_SERVER_READ_PIN_TIMEOUT_US 10000000
+
+// Number of raft indexes which may be applied per SM apply wakeup
+#define RAFT_SERVER_SM_APPLY_BATCH_DEFAULT 16
+#define RAFT_SERVER_SM_APPLY_BATCH_MAX 1024
+
+// Wait period which bounds the apply prefetch thread's response to a halt
+#define RAFT_SERVER_APPLY_PREFETCH_WAIT_US 100000
+
+// Per-worker buffer size for the startup scan's CRC verification
+#define RAFT_SERVER_SCAN_CRC_BUF_SZ (8UL * 1024 * 1024)
+
+// Wait period which bounds a scan CRC worker's response to a halt request
+#define RAFT_SERVER_SCAN_CRC_WAIT_US 100000
+
+// Number of TCP bound AE requests which may be queued for each follower
+#define RAFT_SERVER_BULK_LANE_DEPTH_DEFAULT 8
+#define RAFT_SERVER_BULK_LANE_DEPTH_MAX 64
+
+// Wait period which bounds the send queue threads' response to a halt request
+#define RAFT_SERVER_BULK_LANE_WAIT_US 100000
+
 // This timeout is used for the chkpt which occurs prior to recovery
 #define RAFT_SERVER_DEF_CHKPT_TIMEOUT 300
 static int raftServerChkptTimeoutSec = RAFT_SERVER_DEF_CHKPT_TIMEOUT;
@@ -54,6 +110,7 @@ static bool raftServerDoesChkptBeforeRecovery = true;
 
 typedef void * raft_server_sync_thread_t;
 typedef void raft_server_sync_thread_ctx_t;
+typedef size_t raft_server_sync_thread_ctx_size_t;
 
 typedef void * raft_server_chkpt_thread_t;
 typedef void raft_server_chkpt_thread_ctx_t;
@@ -64,6 +121,14 @@ static unsigned long long raftServerMaxRecoveryLeaderCommMsec = 10000;
 typedef void *raft_server_rw_thread_t;
 typedef void  raft_server_rw_thread_ctx_t;
 
+typedef void *raft_server_apply_prefetch_thread_t;
+
+typedef void *raft_server_bulk_lane_thread_t;
+
+typedef void *raft_server_scan_crc_thread_t;
+
+typedef void *raft_server_hosted_recovery_thread_t;
+
 static const char *
 raft_server_may_accept_client_request_reason(struct raft_instance *ri);
 
@@ -122,6 +187,8 @@ enum raft_instance_lreg_entry_values
     RAFT_LREG_LAST_APPLIED_CCRC,  // int64
     RAFT_LREG_SYNC_FREQ_US,       // uint64
     RAFT_LREG_SYNC_CNT,           // uint64
+    RAFT_LREG_SYNC_MAX_BATCH_DELAY_US, // uint64
+    RAFT_LREG_SYNC_MAX_BATCH_SIZE, // uint64
     RAFT_LREG_QUORUM_CNT,         // int64
     RAFT_LREG_TIME_AS_LEADER,     // float
     RAFT_LREG_HEARTBEAT_MSEC,     // int64
@@ -137,6 +204,27 @@ enum raft_instance_lreg_entry_values
     RAFT_LREG_CHKPT_IDX,          // int64
     RAFT_LREG_COALESCE_ITEMS,     // int64
     RAFT_LREG_COALESCE_SPACE_AVAIL, // int64
+    RAFT_LREG_COALESCE_LATENCY_BUDGET_US, // uint64
+    RAFT_LREG_COALESCE_MAX_ENTRIES,   // uint64
+    RAFT_LREG_COALESCE_FLUSH_IDLE,    // uint64
+    RAFT_LREG_COALESCE_FLUSH_DRAINED, // uint64
+    RAFT_LREG_COALESCE_FLUSH_BUDGET,  // uint64
+    RAFT_LREG_COALESCE_FLUSH_FULL,    // uint64
+    RAFT_LREG_ENTRY_CACHE_MAX_BYTES, // uint64
+    RAFT_LREG_ENTRY_CACHE_BYTES,  // uint64
+    RAFT_LREG_ENTRY_CACHE_HITS,   // uint64
+    RAFT_LREG_ENTRY_CACHE_MISSES, // uint64
+    RAFT_LREG_ENTRY_CACHE_EVICTIONS, // uint64
+    RAFT_LREG_AE_WINDOW,          // uint32
+    RAFT_LREG_AE_MAX_PACKED_IDX,  // uint32
+    RAFT_LREG_SM_APPLY_BATCH,     // uint64
+    RAFT_LREG_SM_APPLY_PREFETCH_HITS,   // uint64
+    RAFT_LREG_SM_APPLY_PREFETCH_MISSES, // uint64
+    RAFT_LREG_READ_WORKER_VSTATS, // varray
+    RAFT_LREG_BULK_LANE_DEPTH,    // uint64
+    RAFT_LREG_LANE_VSTATS,        // varray
+    RAFT_LREG_STARTUP_USEC,       // uint64
+    RAFT_LREG_STARTUP_SCAN_USEC,  // uint64
     RAFT_LREG_HIST_COALESCED_WR_CNT,  // hist object
     RAFT_LREG_HIST_DEV_READ_LAT,  // hist object
     RAFT_LREG_HIST_DEV_WRITE_LAT, // hist object
@@ -158,6 +246,180 @@ raft_instance_lreg_peer_vstats_cb(enum lreg_node_cb_ops op,
                                   struct lreg_node *lrn,
                                   struct lreg_value *lv);
 
+static util_thread_ctx_reg_int_t
+raft_instance_lreg_read_worker_vstats_cb(enum lreg_node_cb_ops op,
+                                         struct lreg_node *lrn,
+                                         struct lreg_value *lv);
+
+static util_thread_ctx_reg_int_t
+raft_instance_lreg_lane_vstats_cb(enum lreg_node_cb_ops op,
+                                  struct lreg_node *lrn,
+                                  struct lreg_value *lv);
+
+static void
+raft_server_entry_cache_set_max_bytes(struct raft_instance *ri,
+                                      const struct lreg_value *lv);
+
+static void
+raft_server_set_ae_window(struct raft_instance *ri,
+                          const struct lreg_value *lv)
+{
+    if (!ri || !lv || LREG_VALUE_TO_REQ_TYPE_IN(lv) != LREG_VAL_TYPE_STRING)
+        return;
+
+    unsigned int ae_window = RAFT_SERVER_AE_WINDOW_DEFAULT;
+    if (strncmp(LREG_VALUE_TO_IN_STR(lv), "default", 7))
+    {
+        int rc = niova_string_to_unsigned_int(LREG_VALUE_TO_IN_STR(lv),
+                                              &ae_window);
+        if (rc)
+            return;
+    }
+
+    if (ae_window < 1)
+        ae_window = 1;
+
+    else if (ae_window > RAFT_SERVER_AE_WINDOW_MAX)
+        ae_window = RAFT_SERVER_AE_WINDOW_MAX;
+
+    ri->ri_ae_window = ae_window;
+}
+
+static void
+raft_server_set_sm_apply_batch(struct raft_instance *ri,
+                               const struct lreg_value *lv)
+{
+    if (!ri || !lv || LREG_VALUE_TO_REQ_TYPE_IN(lv) != LREG_VAL_TYPE_STRING)
+        return;
+
+    unsigned long long batch = RAFT_SERVER_SM_APPLY_BATCH_DEFAULT;
+    if (strncmp(LREG_VALUE_TO_IN_STR(lv), "default", 7))
+    {
+        int rc = niova_string_to_unsigned_long_long(LREG_VALUE_TO_IN_STR(lv),
+                                                    &batch);
+        if (rc)
+            return;
+    }
+
+    if (batch < 1)
+        batch = 1;
+
+    else if (batch > RAFT_SERVER_SM_APPLY_BATCH_MAX)
+        batch = RAFT_SERVER_SM_APPLY_BATCH_MAX;
+
+    ri->ri_sm_apply_batch = batch;
+}
+
+static void
+raft_server_set_co_wr_latency_budget(struct raft_instance *ri,
+                                     const struct lreg_value *lv)
+{
+    if (!ri || !lv || LREG_VALUE_TO_REQ_TYPE_IN(lv) != LREG_VAL_TYPE_STRING)
+        return;
+
+    unsigned long long budget_us =
+        RAFT_SERVER_COALESCE_LATENCY_BUDGET_US_DEFAULT;
+
+    if (strncmp(LREG_VALUE_TO_IN_STR(lv), "default", 7))
+    {
+        int rc = niova_string_to_unsigned_long_long(LREG_VALUE_TO_IN_STR(lv),
+                                                    &budget_us);
+        if (rc)
+            return;
+    }
+
+    if (budget_us < 1)
+        budget_us = 1;
+
+    else if (budget_us > RAFT_SERVER_COALESCE_LATENCY_BUDGET_US_MAX)
+        budget_us = RAFT_SERVER_COALESCE_LATENCY_BUDGET_US_MAX;
+
+    ri->ri_co_wr_latency_budget_us = budget_us;
+}
+
+/**
+ * raft_server_set_co_wr_max_entries - sets the number of client writes which
+ *    may share a raft entry.  Values above RAFT_ENTRY_NUM_ENTRIES cause larger
+ *    batches to be written with v2 entry headers, which peers predating v2
+ *    cannot read, so the default stays within the v1 table.
+ */
+static void
+raft_server_set_co_wr_max_entries(struct raft_instance *ri,
+                                  const struct lreg_value *lv)
+{
+    if (!ri || !lv || LREG_VALUE_TO_REQ_TYPE_IN(lv) != LREG_VAL_TYPE_STRING)
+        return;
+
+    unsigned long long max_entries = RAFT_SERVER_COALESCE_MAX_ENTRIES_DEFAULT;
+
+    if (strncmp(LREG_VALUE_TO_IN_STR(lv), "default", 7))
+    {
+        int rc = niova_string_to_unsigned_long_long(LREG_VALUE_TO_IN_STR(lv),
+                                                    &max_entries);
+        if (rc)
+            return;
+    }
+
+    if (max_entries < 1)
+        max_entries = 1;
+
+    else if (max_entries > RAFT_ENTRY_V2_NUM_ENTRIES_MAX)
+        max_entries = RAFT_ENTRY_V2_NUM_ENTRIES_MAX;
+
+    // A pending batch above a lowered limit is flushed on the next check
+    ri->ri_co_wr_max_entries = max_entries;
+}
+
+static void
+raft_server_set_bulk_lane_depth(struct raft_instance *ri,
+                                const struct lreg_value *lv)
+{
+    if (!ri || !lv || LREG_VALUE_TO_REQ_TYPE_IN(lv) != LREG_VAL_TYPE_STRING)
+        return;
+
+    unsigned long long depth = RAFT_SERVER_BULK_LANE_DEPTH_DEFAULT;
+    if (strncmp(LREG_VALUE_TO_IN_STR(lv), "default", 7))
+    {
+        int rc = niova_string_to_unsigned_long_long(LREG_VALUE_TO_IN_STR(lv),
+                                                    &depth);
+        if (rc)
+            return;
+    }
+
+    if (depth < 1)
+        depth = 1;
+
+    else if (depth > RAFT_SERVER_BULK_LANE_DEPTH_MAX)
+        depth = RAFT_SERVER_BULK_LANE_DEPTH_MAX;
+
+    ri->ri_bulk_lane_depth = depth;
+}
+
+static void
+raft_server_set_ae_max_packed_idx(struct raft_instance *ri,
+                                  const struct lreg_value *lv)
+{
+    if (!ri || !lv || LREG_VALUE_TO_REQ_TYPE_IN(lv) != LREG_VAL_TYPE_STRING)
+        return;
+
+    unsigned int max_packed = RAFT_SERVER_AE_PACKED_IDX_DEFAULT;
+    if (strncmp(LREG_VALUE_TO_IN_STR(lv), "default", 7))
+    {
+        int rc = niova_string_to_unsigned_int(LREG_VALUE_TO_IN_STR(lv),
+                                              &max_packed);
+        if (rc)
+            return;
+    }
+
+    if (max_packed < 1)
+        max_packed = 1;
+
+    else if (max_packed > RAFT_SERVER_AE_PACKED_IDX_MAX)
+        max_packed = RAFT_SERVER_AE_PACKED_IDX_MAX;
+
+    ri->ri_ae_max_packed_idx = max_packed;
+}
+
 static void
 raft_server_set_sync_freq(struct raft_instance *ri,
                           const struct lreg_value *lv)
@@ -185,6 +447,62 @@ raft_server_set_sync_freq(struct raft_instance *ri,
         ri->ri_sync_freq_us = sync_freq;
 }
 
+static void
+raft_server_set_sync_max_batch_delay(struct raft_instance *ri,
+                                     const struct lreg_value *lv)
+{
+    if (!ri || !lv || LREG_VALUE_TO_REQ_TYPE_IN(lv) != LREG_VAL_TYPE_STRING)
+        return;
+
+    unsigned long long delay_us = RAFT_SERVER_SYNC_MAX_BATCH_DELAY_US;
+    if (strncmp(LREG_VALUE_TO_IN_STR(lv), "default", 7))
+    {
+        int rc = niova_string_to_unsigned_long_long(LREG_VALUE_TO_IN_STR(lv),
+                                                    &delay_us);
+        if (rc)
+            return;
+    }
+
+    // A value of '0' syncs as soon as the sync thread is woken
+    if (delay_us > RAFT_SERVER_SYNC_MAX_BATCH_DELAY_US_MAX)
+        delay_us = RAFT_SERVER_SYNC_MAX_BATCH_DELAY_US_MAX;
+
+    struct raft_sync_group *rsg = &ri->ri_sync_group;
+
+    niova_mutex_lock(&rsg->rsg_mutex);
+    rsg->rsg_max_batch_delay_us = delay_us;
+    niova_mutex_unlock(&rsg->rsg_mutex);
+}
+
+static void
+raft_server_set_sync_max_batch_size(struct raft_instance *ri,
+                                    const struct lreg_value *lv)
+{
+    if (!ri || !lv || LREG_VALUE_TO_REQ_TYPE_IN(lv) != LREG_VAL_TYPE_STRING)
+        return;
+
+    unsigned long long batch_size = RAFT_SERVER_SYNC_MAX_BATCH_SIZE;
+    if (strncmp(LREG_VALUE_TO_IN_STR(lv), "default", 7))
+    {
+        int rc = niova_string_to_unsigned_long_long(LREG_VALUE_TO_IN_STR(lv),
+                                                    &batch_size);
+        if (rc)
+            return;
+    }
+
+    if (batch_size < 1)
+        batch_size = 1;
+
+    else if (batch_size > RAFT_SERVER_SYNC_MAX_BATCH_SIZE_MAX)
+        batch_size = RAFT_SERVER_SYNC_MAX_BATCH_SIZE_MAX;
+
+    struct raft_sync_group *rsg = &ri->ri_sync_group;
+
+    niova_mutex_lock(&rsg->rsg_mutex);
+    rsg->rsg_max_batch_size = batch_size;
+    niova_mutex_unlock(&rsg->rsg_mutex);
+}
+
 static util_thread_ctx_reg_int_t
 raft_instance_lreg_multi_facet_cb(enum lreg_node_cb_ops op,
                                   struct raft_instance *ri,
@@ -338,6 +656,15 @@ raft_instance_lreg_multi_facet_cb(enum lreg_node_cb_ops op,
         case RAFT_LREG_SYNC_CNT:
             lreg_value_fill_unsigned(lv, "sync-cnt", ri->ri_sync_cnt);
             break;
+        case RAFT_LREG_SYNC_MAX_BATCH_DELAY_US:
+            lreg_value_fill_unsigned(
+                lv, "sync-max-batch-delay-us",
+                ri->ri_sync_group.rsg_max_batch_delay_us);
+            break;
+        case RAFT_LREG_SYNC_MAX_BATCH_SIZE:
+            lreg_value_fill_unsigned(lv, "sync-max-batch-size",
+                                     ri->ri_sync_group.rsg_max_batch_size);
+            break;
         case RAFT_LREG_COALESCE_ITEMS:
             lreg_value_fill_signed(
                 lv, "coalesce-items-pending",
@@ -351,6 +678,73 @@ raft_instance_lreg_multi_facet_cb(enum lreg_node_cb_ops op,
                 (long long)((RAFT_ENTRY_MAX_DATA_SIZE(ri) -
                              ri->ri_coalesced_wr->rcwi_total_size)) : -1LL);
             break;
+        case RAFT_LREG_COALESCE_LATENCY_BUDGET_US:
+            lreg_value_fill_unsigned(lv, "coalesce-latency-budget-usec",
+                                     ri->ri_co_wr_latency_budget_us);
+            break;
+        case RAFT_LREG_COALESCE_MAX_ENTRIES:
+            lreg_value_fill_unsigned(lv, "coalesce-max-entries",
+                                     ri->ri_co_wr_max_entries);
+            break;
+        case RAFT_LREG_COALESCE_FLUSH_IDLE:
+            lreg_value_fill_unsigned(
+                lv, "coalesce-flush-idle",
+                ri->ri_co_wr_flush_cnt[RAFT_CO_WR_FLUSH_IDLE]);
+            break;
+        case RAFT_LREG_COALESCE_FLUSH_DRAINED:
+            lreg_value_fill_unsigned(
+                lv, "coalesce-flush-drained",
+                ri->ri_co_wr_flush_cnt[RAFT_CO_WR_FLUSH_DRAINED]);
+            break;
+        case RAFT_LREG_COALESCE_FLUSH_BUDGET:
+            lreg_value_fill_unsigned(
+                lv, "coalesce-flush-budget",
+                ri->ri_co_wr_flush_cnt[RAFT_CO_WR_FLUSH_BUDGET]);
+            break;
+        case RAFT_LREG_COALESCE_FLUSH_FULL:
+            lreg_value_fill_unsigned(
+                lv, "coalesce-flush-full",
+                ri->ri_co_wr_flush_cnt[RAFT_CO_WR_FLUSH_FULL]);
+            break;
+        case RAFT_LREG_ENTRY_CACHE_MAX_BYTES:
+            lreg_value_fill_unsigned(lv, "entry-cache-max-bytes",
+                                     ri->ri_entry_cache.rec_max_bytes);
+            break;
+        case RAFT_LREG_ENTRY_CACHE_BYTES:
+            lreg_value_fill_unsigned(lv, "entry-cache-bytes",
+                                     ri->ri_entry_cache.rec_nbytes);
+            break;
+        case RAFT_LREG_ENTRY_CACHE_HITS:
+            lreg_value_fill_unsigned(lv, "entry-cache-hits",
+                                     ri->ri_entry_cache.rec_hits);
+            break;
+        case RAFT_LREG_ENTRY_CACHE_MISSES:
+            lreg_value_fill_unsigned(lv, "entry-cache-misses",
+                                     ri->ri_entry_cache.rec_misses);
+            break;
+        case RAFT_LREG_ENTRY_CACHE_EVICTIONS:
+            lreg_value_fill_unsigned(lv, "entry-cache-evictions",
+                                     ri->ri_entry_cache.rec_evictions);
+            break;
+        case RAFT_LREG_AE_WINDOW:
+            lreg_value_fill_unsigned(lv, "ae-window", ri->ri_ae_window);
+            break;
+        case RAFT_LREG_AE_MAX_PACKED_IDX:
+            lreg_value_fill_unsigned(lv, "ae-max-packed-idx",
+                                     ri->ri_ae_max_packed_idx);
+            break;
+        case RAFT_LREG_SM_APPLY_BATCH:
+            lreg_value_fill_unsigned(lv, "sm-apply-batch",
+                                     ri->ri_sm_apply_batch);
+            break;
+        case RAFT_LREG_SM_APPLY_PREFETCH_HITS:
+            lreg_value_fill_unsigned(lv, "sm-apply-prefetch-hits",
+                                     ri->ri_apply_prefetch.rap_hits);
+            break;
+        case RAFT_LREG_SM_APPLY_PREFETCH_MISSES:
+            lreg_value_fill_unsigned(lv, "sm-apply-prefetch-misses",
+                                     ri->ri_apply_prefetch.rap_misses);
+            break;
         case RAFT_LREG_HIST_COMMIT_LAT:
             lreg_value_fill_histogram(
                 lv, raft_instance_hist_stat_2_name(
@@ -412,6 +806,30 @@ raft_instance_lreg_multi_facet_cb(enum lreg_node_cb_ops op,
                                    raft_num_members_validate_and_get(ri) - 1,
                                    raft_instance_lreg_peer_vstats_cb);
             break;
+        case RAFT_LREG_READ_WORKER_VSTATS:
+            // Niova-core has no dedicated user type for these items
+            lreg_value_fill_varray(lv, "read-worker-stats",
+                                   LREG_USER_TYPE_RAFT_PEER_STATS,
+                                   ri->ri_num_read_workers,
+                                   raft_instance_lreg_read_worker_vstats_cb);
+            break;
+        case RAFT_LREG_BULK_LANE_DEPTH:
+            lreg_value_fill_unsigned(lv, "bulk-lane-depth",
+                                     ri->ri_bulk_lane_depth);
+            break;
+        case RAFT_LREG_STARTUP_USEC:
+            lreg_value_fill_unsigned(lv, "startup-usec", ri->ri_startup_usec);
+            break;
+        case RAFT_LREG_STARTUP_SCAN_USEC:
+            lreg_value_fill_unsigned(lv, "startup-scan-usec",
+                                     ri->ri_startup_scan_usec);
+            break;
+        case RAFT_LREG_LANE_VSTATS:
+            lreg_value_fill_varray(lv, "lane-stats",
+                                   LREG_USER_TYPE_RAFT_PEER_STATS,
+                                   RAFT_NET_LANE_MAX,
+                                   raft_instance_lreg_lane_vstats_cb);
+            break;
         default:
             break;
         }
@@ -424,6 +842,33 @@ raft_instance_lreg_multi_facet_cb(enum lreg_node_cb_ops op,
         case RAFT_LREG_SYNC_FREQ_US:
             raft_server_set_sync_freq(ri, lv);
             break;
+        case RAFT_LREG_SYNC_MAX_BATCH_DELAY_US:
+            raft_server_set_sync_max_batch_delay(ri, lv);
+            break;
+        case RAFT_LREG_SYNC_MAX_BATCH_SIZE:
+            raft_server_set_sync_max_batch_size(ri, lv);
+            break;
+        case RAFT_LREG_ENTRY_CACHE_MAX_BYTES:
+            raft_server_entry_cache_set_max_bytes(ri, lv);
+            break;
+        case RAFT_LREG_AE_WINDOW:
+            raft_server_set_ae_window(ri, lv);
+            break;
+        case RAFT_LREG_AE_MAX_PACKED_IDX:
+            raft_server_set_ae_max_packed_idx(ri, lv);
+            break;
+        case RAFT_LREG_SM_APPLY_BATCH:
+            raft_server_set_sm_apply_batch(ri, lv);
+            break;
+        case RAFT_LREG_COALESCE_LATENCY_BUDGET_US:
+            raft_server_set_co_wr_latency_budget(ri, lv);
+            break;
+        case RAFT_LREG_COALESCE_MAX_ENTRIES:
+            raft_server_set_co_wr_max_entries(ri, lv);
+            break;
+        case RAFT_LREG_BULK_LANE_DEPTH:
+            raft_server_set_bulk_lane_depth(ri, lv);
+            break;
         case RAFT_LREG_CHKPT_IDX:
             ri->ri_user_requested_checkpoint = true;
             break;
@@ -458,6 +903,13 @@ enum raft_peer_stats_items
     RAFT_PEER_STATS_ACKD_LOG_IDX,
     RAFT_PEER_STATS_PREV_LOG_IDX,
     RAFT_PEER_STATS_PREV_LOG_TERM,
+    RAFT_PEER_STATS_INFLIGHT_IDX,
+    RAFT_PEER_STATS_INFLIGHT_CNT,
+    RAFT_PEER_STATS_SENDQ_DEPTH,
+    RAFT_PEER_STATS_SENDQ_DEPTH_MAX,
+    RAFT_PEER_STATS_SENDQ_FULL,
+    RAFT_PEER_STATS_AE_PAYLOAD_BYTES,
+    RAFT_PEER_STATS_AE_PAYLOAD_WIRE_BYTES,
     RAFT_PEER_STATS_MAX,
 };
 
@@ -479,6 +931,26 @@ raft_instance_lreg_peer_stats_multi_facet_handler(
     NIOVA_ASSERT(raft_member_idx_is_valid(ri, peer) &&
                  ri->ri_csn_raft_peers[peer]);
 
+    // Snapshot the send queue stats, they are updated by the sender thread
+    struct raft_peer_send_queue *rpsq =
+        (struct raft_peer_send_queue *)&ri->ri_bulk_lane.rbl_peer_sendq[peer];
+
+    size_t sq_depth = 0, sq_depth_max = 0, sq_nfull = 0;
+    size_t sq_entry_bytes = 0, sq_entry_wire_bytes = 0;
+
+    if (rpsq->rpsq_running)
+    {
+        niova_mutex_lock(&rpsq->rpsq_mutex);
+
+        sq_depth = rpsq->rpsq_depth;
+        sq_depth_max = rpsq->rpsq_depth_max;
+        sq_nfull = rpsq->rpsq_nfull;
+        sq_entry_bytes = rpsq->rpsq_entry_bytes;
+        sq_entry_wire_bytes = rpsq->rpsq_entry_wire_bytes;
+
+        niova_mutex_unlock(&rpsq->rpsq_mutex);
+    }
+
     switch (lv->lrv_value_idx_in)
     {
     case RAFT_PEER_STATS_ITEM_UUID:
@@ -518,6 +990,28 @@ raft_instance_lreg_peer_stats_multi_facet_handler(
     case RAFT_PEER_STATS_ACKD_LOG_IDX:
         lreg_value_fill_signed(lv, "ackd-idx", rfi->rfi_ackd_idx);
         break;
+    case RAFT_PEER_STATS_INFLIGHT_IDX:
+        lreg_value_fill_signed(lv, "inflight-idx", rfi->rfi_inflight_idx);
+        break;
+    case RAFT_PEER_STATS_INFLIGHT_CNT:
+        lreg_value_fill_unsigned(lv, "inflight-cnt", rfi->rfi_inflight_cnt);
+        break;
+    case RAFT_PEER_STATS_SENDQ_DEPTH:
+        lreg_value_fill_unsigned(lv, "send-queue-depth", sq_depth);
+        break;
+    case RAFT_PEER_STATS_SENDQ_DEPTH_MAX:
+        lreg_value_fill_unsigned(lv, "send-queue-depth-max", sq_depth_max);
+        break;
+    case RAFT_PEER_STATS_SENDQ_FULL:
+        lreg_value_fill_unsigned(lv, "send-queue-full", sq_nfull);
+        break;
+    case RAFT_PEER_STATS_AE_PAYLOAD_BYTES:
+        lreg_value_fill_unsigned(lv, "ae-payload-bytes", sq_entry_bytes);
+        break;
+    case RAFT_PEER_STATS_AE_PAYLOAD_WIRE_BYTES:
+        lreg_value_fill_unsigned(lv, "ae-payload-wire-bytes",
+                                 sq_entry_wire_bytes);
+        break;
     default:
         break;
     }
@@ -578,41 +1072,258 @@ raft_instance_lreg_peer_vstats_cb(enum lreg_node_cb_ops op,
     return 0;
 }
 
+enum raft_read_worker_stats_items
+{
+    RAFT_READ_WORKER_STATS_QUEUE_DEPTH,
+    RAFT_READ_WORKER_STATS_QUEUE_DEPTH_MAX,
+    RAFT_READ_WORKER_STATS_NREQS,
+    RAFT_READ_WORKER_STATS_LAT_USEC_AVG,
+    RAFT_READ_WORKER_STATS_LAT_USEC_MAX,
+    RAFT_READ_WORKER_STATS_MAX,
+};
+
+static util_thread_ctx_reg_t
+raft_instance_lreg_read_worker_stats_multi_facet_handler(
+    enum lreg_node_cb_ops op,
+    struct raft_rw_worker_thread *rrwt,
+    struct lreg_value *lv)
+{
+    if (!lv || !rrwt ||
+        lv->lrv_value_idx_in >= RAFT_READ_WORKER_STATS_MAX ||
+        op != LREG_NODE_CB_OP_READ_VAL)
+        return;
+
+    struct raft_work_queue *rwq = &rrwt->rrwt_queue;
+
+    niova_mutex_lock(&rwq->rsw_mutex);
+
+    switch (lv->lrv_value_idx_in)
+    {
+    case RAFT_READ_WORKER_STATS_QUEUE_DEPTH:
+        lreg_value_fill_unsigned(lv, "queue-depth", rwq->rsw_depth);
+        break;
+    case RAFT_READ_WORKER_STATS_QUEUE_DEPTH_MAX:
+        lreg_value_fill_unsigned(lv, "queue-depth-max", rrwt->rrwt_max_depth);
+        break;
+    case RAFT_READ_WORKER_STATS_NREQS:
+        lreg_value_fill_unsigned(lv, "reqs-completed", rrwt->rrwt_nreqs);
+        break;
+    case RAFT_READ_WORKER_STATS_LAT_USEC_AVG:
+        lreg_value_fill_unsigned(lv, "lat-usec-avg",
+                                 (rrwt->rrwt_nreqs ?
+                                  (rrwt->rrwt_lat_usec_total /
+                                   rrwt->rrwt_nreqs) : 0));
+        break;
+    case RAFT_READ_WORKER_STATS_LAT_USEC_MAX:
+        lreg_value_fill_unsigned(lv, "lat-usec-max", rrwt->rrwt_lat_usec_max);
+        break;
+    default:
+        break;
+    }
+
+    niova_mutex_unlock(&rwq->rsw_mutex);
+}
+
 static util_thread_ctx_reg_int_t
-raft_instance_lreg_cb(enum lreg_node_cb_ops op, struct lreg_node *lrn,
-                      struct lreg_value *lv)
+raft_instance_lreg_read_worker_vstats_cb(enum lreg_node_cb_ops op,
+                                         struct lreg_node *lrn,
+                                         struct lreg_value *lv)
 {
     struct raft_instance *ri = lrn->lrn_cb_arg;
     if (!ri)
         return -EINVAL;
 
-    int rc = 0;
+    NIOVA_ASSERT(lrn->lrn_vnode_child);
+
+    if (lv)
+        lv->get.lrv_num_keys_out = RAFT_READ_WORKER_STATS_MAX;
 
     switch (op)
     {
     case LREG_NODE_CB_OP_GET_NAME:
         if (!lv)
             return -EINVAL;
-
-        lv->get.lrv_num_keys_out = (raft_instance_is_leader(ri) ?
-                                    RAFT_LREG_MAX : RAFT_LREG_MAX_FOLLOWER);
-
-        strncpy(lv->lrv_key_string, "raft_instance", LREG_VALUE_STRING_MAX);
+        strncpy(lv->lrv_key_string, "read-worker-stats",
+                LREG_VALUE_STRING_MAX);
         strncpy(LREG_VALUE_TO_OUT_STR(lv), ri->ri_raft_uuid_str,
                 LREG_VALUE_STRING_MAX);
         break;
 
     case LREG_NODE_CB_OP_READ_VAL:
     case LREG_NODE_CB_OP_WRITE_VAL: //fall through
-        rc = lv ? raft_instance_lreg_multi_facet_cb(op, ri, lv) : -EINVAL;
+        if (!lv)
+            return -EINVAL;
+
+        if (lrn->lrn_lvd.lvd_index >= ri->ri_num_read_workers)
+            return -ERANGE;
+
+        raft_instance_lreg_read_worker_stats_multi_facet_handler(
+            op, &ri->ri_reader_thread_ctl[lrn->lrn_lvd.lvd_index], lv);
         break;
 
+    case LREG_NODE_CB_OP_INSTALL_NODE: // fall through
+    case LREG_NODE_CB_OP_DESTROY_NODE: // fall through
     case LREG_NODE_CB_OP_INSTALL_QUEUED_NODE:
         break;
 
-    case LREG_NODE_CB_OP_INSTALL_NODE:
-        if (ri->ri_lreg_registered)
-            return -EALREADY;
+    default:
+        return -ENOENT;
+    }
+
+    return 0;
+}
+
+enum raft_lane_stats_items
+{
+    RAFT_LANE_STATS_NAME,
+    RAFT_LANE_STATS_NMSGS,
+    RAFT_LANE_STATS_NERRS,
+    RAFT_LANE_STATS_QUEUE_DEPTH,
+    RAFT_LANE_STATS_QUEUE_DEPTH_MAX,
+    RAFT_LANE_STATS_LAT_USEC_AVG,
+    RAFT_LANE_STATS_LAT_USEC_MAX,
+    RAFT_LANE_STATS_MAX,
+};
+
+static util_thread_ctx_reg_t
+raft_instance_lreg_lane_stats_multi_facet_handler(
+    enum lreg_node_cb_ops op,
+    struct raft_instance *ri,
+    const enum raft_net_lane lane,
+    struct lreg_value *lv)
+{
+    if (!lv || !ri || lane >= RAFT_NET_LANE_MAX ||
+        lv->lrv_value_idx_in >= RAFT_LANE_STATS_MAX ||
+        op != LREG_NODE_CB_OP_READ_VAL)
+        return;
+
+    struct raft_bulk_lane *rbl = &ri->ri_bulk_lane;
+    const struct raft_net_lane_stats *rnls = &ri->ri_lane_stats[lane];
+
+    // Control lane stats are only modified by the main thread
+    const bool locked = lane == RAFT_NET_LANE_BULK && rbl->rbl_running;
+    if (locked)
+        niova_mutex_lock(&rbl->rbl_mutex);
+
+    switch (lv->lrv_value_idx_in)
+    {
+    case RAFT_LANE_STATS_NAME:
+        lreg_value_fill_string(lv, "lane",
+                               lane == RAFT_NET_LANE_CTL ? "control" : "bulk");
+        break;
+    case RAFT_LANE_STATS_NMSGS:
+        lreg_value_fill_unsigned(lv, "msgs-sent", rnls->rnls_nmsgs);
+        break;
+    case RAFT_LANE_STATS_NERRS:
+        lreg_value_fill_unsigned(lv, "send-errors", rnls->rnls_nerrs);
+        break;
+    case RAFT_LANE_STATS_QUEUE_DEPTH:
+        lreg_value_fill_unsigned(lv, "queue-depth", rnls->rnls_depth);
+        break;
+    case RAFT_LANE_STATS_QUEUE_DEPTH_MAX:
+        lreg_value_fill_unsigned(lv, "queue-depth-max",
+                                 rnls->rnls_depth_max);
+        break;
+    case RAFT_LANE_STATS_LAT_USEC_AVG:
+        lreg_value_fill_unsigned(lv, "lat-usec-avg",
+                                 (rnls->rnls_nlat ?
+                                  (rnls->rnls_lat_usec_total /
+                                   rnls->rnls_nlat) : 0));
+        break;
+    case RAFT_LANE_STATS_LAT_USEC_MAX:
+        lreg_value_fill_unsigned(lv, "lat-usec-max", rnls->rnls_lat_usec_max);
+        break;
+    default:
+        break;
+    }
+
+    if (locked)
+        niova_mutex_unlock(&rbl->rbl_mutex);
+}
+
+static util_thread_ctx_reg_int_t
+raft_instance_lreg_lane_vstats_cb(enum lreg_node_cb_ops op,
+                                  struct lreg_node *lrn,
+                                  struct lreg_value *lv)
+{
+    struct raft_instance *ri = lrn->lrn_cb_arg;
+    if (!ri)
+        return -EINVAL;
+
+    NIOVA_ASSERT(lrn->lrn_vnode_child);
+
+    if (lv)
+        lv->get.lrv_num_keys_out = RAFT_LANE_STATS_MAX;
+
+    switch (op)
+    {
+    case LREG_NODE_CB_OP_GET_NAME:
+        if (!lv)
+            return -EINVAL;
+        strncpy(lv->lrv_key_string, "lane-stats", LREG_VALUE_STRING_MAX);
+        strncpy(LREG_VALUE_TO_OUT_STR(lv), ri->ri_raft_uuid_str,
+                LREG_VALUE_STRING_MAX);
+        break;
+
+    case LREG_NODE_CB_OP_READ_VAL:
+    case LREG_NODE_CB_OP_WRITE_VAL: //fall through
+        if (!lv)
+            return -EINVAL;
+
+        if (lrn->lrn_lvd.lvd_index >= RAFT_NET_LANE_MAX)
+            return -ERANGE;
+
+        raft_instance_lreg_lane_stats_multi_facet_handler(
+            op, ri, lrn->lrn_lvd.lvd_index, lv);
+        break;
+
+    case LREG_NODE_CB_OP_INSTALL_NODE: // fall through
+    case LREG_NODE_CB_OP_DESTROY_NODE: // fall through
+    case LREG_NODE_CB_OP_INSTALL_QUEUED_NODE:
+        break;
+
+    default:
+        return -ENOENT;
+    }
+
+    return 0;
+}
+
+static util_thread_ctx_reg_int_t
+raft_instance_lreg_cb(enum lreg_node_cb_ops op, struct lreg_node *lrn,
+                      struct lreg_value *lv)
+{
+    struct raft_instance *ri = lrn->lrn_cb_arg;
+    if (!ri)
+        return -EINVAL;
+
+    int rc = 0;
+
+    switch (op)
+    {
+    case LREG_NODE_CB_OP_GET_NAME:
+        if (!lv)
+            return -EINVAL;
+
+        lv->get.lrv_num_keys_out = (raft_instance_is_leader(ri) ?
+                                    RAFT_LREG_MAX : RAFT_LREG_MAX_FOLLOWER);
+
+        strncpy(lv->lrv_key_string, "raft_instance", LREG_VALUE_STRING_MAX);
+        strncpy(LREG_VALUE_TO_OUT_STR(lv), ri->ri_raft_uuid_str,
+                LREG_VALUE_STRING_MAX);
+        break;
+
+    case LREG_NODE_CB_OP_READ_VAL:
+    case LREG_NODE_CB_OP_WRITE_VAL: //fall through
+        rc = lv ? raft_instance_lreg_multi_facet_cb(op, ri, lv) : -EINVAL;
+        break;
+
+    case LREG_NODE_CB_OP_INSTALL_QUEUED_NODE:
+        break;
+
+    case LREG_NODE_CB_OP_INSTALL_NODE:
+        if (ri->ri_lreg_registered)
+            return -EALREADY;
         ri->ri_lreg_registered = true;
         break;
 
@@ -654,6 +1365,29 @@ raft_server_entry_calc_crc(const struct raft_entry *re)
     return crc;
 }
 
+/**
+ * raft_server_entry_view_calc_crc - calculates the same crc as
+ *    raft_server_entry_calc_crc() for an entry whose data does not directly
+ *    follow its header in memory.
+ */
+static crc32_t
+raft_server_entry_view_calc_crc(const struct raft_entry_header *rh,
+                                const char *data)
+{
+    NIOVA_ASSERT(rh && (data || !rh->reh_data_size));
+
+    const size_t offset =
+        offsetof(struct raft_entry_header, reh_data_size);
+
+    crc32_t crc = niova_crc((const unsigned char *)rh + offset,
+                            sizeof(struct raft_entry) - offset, 0);
+
+    if (rh->reh_data_size)
+        crc = niova_crc((const unsigned char *)data, rh->reh_data_size, crc);
+
+    return crc;
+}
+
 /**
  * raft_server_entry_check_crc - call raft_server_entry_calc_crc() and compare
  *    the result with that in the provided raft_entry.
@@ -683,43 +1417,73 @@ raft_server_wr_entries_get_total_size(const uint32_t *entry_sizes,
 }
 
 /**
- * raft_server_entry_init - initialize a raft_entry in preparation for writing
- *    it into the raft log file.
- * @re:  raft_entry to be intialized
- * @re_idx:  the raft-entry index at which the block will be stored
- * @current_term:  the term to which this pending write operation belongs
- * @self_uuid:  UUID is this node instance, written into the entry for safety
- * @raft_uuid:  UUID of the raft instance, also written for safety
- * @data:  application data which is being stored in the block.
- * @len:  length of the application data
+ * raft_server_entry_num_sub_entries - returns the number of sub-entries in
+ *    the entry.  'data' is only consulted for v2 entries, whose table must
+ *    have been checked.
  */
-void
-raft_server_entry_init(const struct raft_instance *ri,
-                       struct raft_entry *re, const raft_entry_idx_t re_idx,
-                       const uint64_t current_term,
-                       const char *data, const uint32_t *entry_sizes,
-                       const uint32_t nentries,
-                       enum raft_write_entry_opts opts)
+static uint32_t
+raft_server_entry_num_sub_entries(const struct raft_entry_header *reh,
+                                  const char *data)
 {
-    NIOVA_ASSERT(re);
-    NIOVA_ASSERT(opts == RAFT_WR_ENTRY_OPT_LEADER_CHANGE_MARKER ||
-                 (data && entry_sizes && nentries));
+    return reh->reh_version == RAFT_ENTRY_HEADER_V2 ?
+        raft_server_entry_sub_table_word(data, 0) : reh->reh_num_entries;
+}
+
+static uint32_t
+raft_server_entry_sub_entry_size(const struct raft_entry_header *reh,
+                                 const char *data, const uint32_t pos)
+{
+    return reh->reh_version == RAFT_ENTRY_HEADER_V2 ?
+        raft_server_entry_sub_table_word(data, pos + 1) :
+        reh->reh_entry_sz[pos];
+}
+
+// Offset of the first sub-entry within the entry data
+static size_t
+raft_server_entry_sub_entries_offset(const struct raft_entry_header *reh,
+                                     const uint32_t nentries)
+{
+    return reh->reh_version == RAFT_ENTRY_HEADER_V2 ?
+        raft_entry_sub_table_size(nentries) : 0;
+}
+
+/**
+ * raft_server_entry_header_init - fills in the raft entry header for a
+ *    pending write.  The crc is left as 0 since it depends on the data which
+ *    the caller may hold in any layout.  Entries with more than
+ *    RAFT_ENTRY_NUM_ENTRIES sub-entries receive a v2 header, their data must
+ *    lead with the sub-entry table and 'entry_sizes' is not used.
+ * @data_size:  size of the entry data, including any v2 sub-entry table
+ */
+static void
+raft_server_entry_header_init(const struct raft_instance *ri,
+                              struct raft_entry_header *reh,
+                              const raft_entry_idx_t re_idx,
+                              const uint64_t current_term,
+                              const uint32_t data_size,
+                              const uint32_t *entry_sizes,
+                              const uint32_t nentries,
+                              enum raft_write_entry_opts opts)
+{
+    NIOVA_ASSERT(reh);
 
     if (opts == RAFT_WR_ENTRY_OPT_LOG_HEADER)
         NIOVA_ASSERT(re_idx < 0);
     else
         NIOVA_ASSERT(re_idx >= 0);
 
-    uint32_t total_size = raft_server_wr_entries_get_total_size(entry_sizes,
-                                                                nentries);
-    // Should have been checked already
-    NIOVA_ASSERT(total_size <= RAFT_ENTRY_MAX_DATA_SIZE(ri));
+    const bool v2 = nentries > RAFT_ENTRY_NUM_ENTRIES ? true : false;
 
-    struct raft_entry_header *reh = &re->re_header;
+    // Should have been checked already
+    NIOVA_ASSERT(data_size <= RAFT_ENTRY_MAX_DATA_SIZE(ri));
+    NIOVA_ASSERT(v2 || data_size ==
+                 raft_server_wr_entries_get_total_size(entry_sizes,
+                                                       nentries));
 
     reh->reh_magic = RAFT_ENTRY_MAGIC;
-    reh->reh_data_size = total_size;
-    reh->reh_num_entries = nentries;
+    reh->reh_data_size = data_size;
+    reh->reh_num_entries = v2 ? 0 : nentries;
+    reh->reh_version = v2 ? RAFT_ENTRY_HEADER_V2 : RAFT_ENTRY_HEADER_V1;
     reh->reh_index = re_idx;
     reh->reh_term = current_term;
     reh->reh_leader_change_marker =
@@ -736,11 +1500,44 @@ raft_server_entry_init(const struct raft_instance *ri,
     memset(reh->reh_pad, 0, RAFT_ENTRY_PAD_SIZE);
     memset(reh->reh_entry_sz, 0, sizeof(uint32_t) * RAFT_ENTRY_NUM_ENTRIES);
 
-    if (total_size)
-    {
+    if (data_size && !v2)
         memcpy(reh->reh_entry_sz, entry_sizes, sizeof(uint32_t) * nentries);
-        memcpy(re->re_data, data, total_size);
-    }
+}
+
+/**
+ * raft_server_entry_init - initialize a raft_entry in preparation for writing
+ *    it into the raft log file.
+ * @re:  raft_entry to be intialized
+ * @re_idx:  the raft-entry index at which the block will be stored
+ * @current_term:  the term to which this pending write operation belongs
+ * @self_uuid:  UUID is this node instance, written into the entry for safety
+ * @raft_uuid:  UUID of the raft instance, also written for safety
+ * @data:  application data which is being stored in the block.
+ * @len:  length of the application data
+ */
+void
+raft_server_entry_init(const struct raft_instance *ri,
+                       struct raft_entry *re, const raft_entry_idx_t re_idx,
+                       const uint64_t current_term,
+                       const char *data, const uint32_t *entry_sizes,
+                       const uint32_t nentries,
+                       enum raft_write_entry_opts opts)
+{
+    NIOVA_ASSERT(re);
+    NIOVA_ASSERT(opts == RAFT_WR_ENTRY_OPT_LEADER_CHANGE_MARKER ||
+                 (data && entry_sizes && nentries));
+
+    NIOVA_ASSERT(nentries <= RAFT_ENTRY_NUM_ENTRIES);
+
+    struct raft_entry_header *reh = &re->re_header;
+
+    raft_server_entry_header_init(
+        ri, reh, re_idx, current_term,
+        raft_server_wr_entries_get_total_size(entry_sizes, nentries),
+        entry_sizes, nentries, opts);
+
+    if (reh->reh_data_size)
+        memcpy(re->re_data, data, reh->reh_data_size);
 
     // Checksum the entire entry - including the 'data' section
     reh->reh_crc = raft_server_entry_calc_crc(re);
@@ -796,6 +1593,47 @@ raft_instance_update_newest_entry_hdr(
     DBG_RAFT_INSTANCE(LL_DEBUG, ri, "");
 }
 
+static void
+raft_server_host_workers_signal(struct raft_host_workers *rhw,
+                                pthread_cond_t *cond)
+{
+    niova_mutex_lock(&rhw->rhw_mutex);
+    pthread_cond_signal(cond);
+    niova_mutex_unlock(&rhw->rhw_mutex);
+}
+
+/**
+ * raft_server_sync_group_post - called by log writers after an entry has
+ *    been handed to the backend.  The sync thread is woken when it may be
+ *    idle (first posted entry) or when the batch has reached its max size.
+ *    A hosted group wakes one of the host's sync threads instead.
+ */
+static void
+raft_server_sync_group_post(struct raft_instance *ri)
+{
+    NIOVA_ASSERT(ri);
+
+    struct raft_sync_group *rsg = &ri->ri_sync_group;
+
+    niova_mutex_lock(&rsg->rsg_mutex);
+
+    rsg->rsg_pending++;
+    if (rsg->rsg_pending == 1)
+        niova_unstable_clock(&rsg->rsg_first_post_ts);
+
+    const bool wake = (rsg->rsg_pending == 1 ||
+                       rsg->rsg_pending >= rsg->rsg_max_batch_size);
+
+    if (wake && !ri->ri_host_workers)
+        pthread_cond_signal(&rsg->rsg_cond);
+
+    niova_mutex_unlock(&rsg->rsg_mutex);
+
+    if (wake && ri->ri_host_workers)
+        raft_server_host_workers_signal(ri->ri_host_workers,
+                                        &ri->ri_host_workers->rhw_sync_cond);
+}
+
 static bool
 raft_server_has_unsynced_entries(struct raft_instance *ri)
 {
@@ -831,85 +1669,368 @@ raft_server_type_2_hist(struct raft_instance *ri,
 
 static void
 raft_server_entry_write_by_store(
-    struct raft_instance *ri, const struct raft_entry *re,
+    struct raft_instance *ri, const struct raft_entry_header *reh,
+    const struct iovec *iov, const size_t niov,
     const struct raft_net_sm_write_supplements *ws)
 {
     NIOVA_TIMER_START(x);
 
-    ri->ri_backend->rib_entry_write(ri, re, ws);
+    ri->ri_backend->rib_entry_write(ri, reh, iov, niov, ws);
 
     NIOVA_TIMER_STOP_and_HIST_ADD(
         x, raft_server_type_2_hist(ri, RAFT_INSTANCE_HIST_DEV_WRITE_LAT_USEC));
 }
 
-/**
- * raft_server_entry_write - safely store an entry into the raft log at the
- *    specified index.  This function writes and syncs the data to the
- *    underlying device and handles partial writes.  NOTE:  it's critical that
- *    the ri_log_hdr is up-to-date with the correct term prior to calling
- *    this function.
- * @ri:  raft instance
- * @re_idx:  the raft_entry index at which the block will be written
- * @data:  the application data buffer
- * @entry_sizes: Pointer to entry size array.
- * @nentries: Number of entries to be written.
- * @opts: write entry option.
- * @ws: pointer to write supplement for all the nentries.
- */
-static int
-raft_server_entry_write(struct raft_instance *ri,
-                        const raft_entry_idx_t re_idx,
-                        const int64_t term, const char *data,
-                        const uint32_t *entry_sizes,
-                        const uint32_t nentries,
-                        enum raft_write_entry_opts opts,
-                        const struct raft_net_sm_write_supplements *ws)
+static void
+raft_server_entry_cache_remove_lowest_locked(struct raft_entry_cache *rec)
 {
-    if (!ri || !ri->ri_csn_this_peer || !ri->ri_csn_raft ||
-        (opts != RAFT_WR_ENTRY_OPT_LEADER_CHANGE_MARKER &&
-        (!data || !entry_sizes)))
-        return -EINVAL;
+    NIOVA_ASSERT(rec && rec->rec_lowest_idx >= 0 &&
+                 rec->rec_lowest_idx <= rec->rec_highest_idx);
 
+    const size_t slot = rec->rec_lowest_idx % RAFT_ENTRY_CACHE_NENTRIES;
+    struct raft_entry *re = rec->rec_ring[slot];
 
-    uint32_t entry_size = raft_server_wr_entries_get_total_size(entry_sizes,
-                                                                nentries);
+    NIOVA_ASSERT(re && re->re_header.reh_index == rec->rec_lowest_idx);
 
-    if (entry_size > RAFT_ENTRY_MAX_DATA_SIZE(ri))
-        return -E2BIG;
+    rec->rec_ring[slot] = NULL;
+    rec->rec_nbytes -= raft_server_entry_to_total_size(re);
 
-    const size_t total_entry_size = sizeof(struct raft_entry) + entry_size;
+    if (rec->rec_lowest_idx == rec->rec_highest_idx)
+        rec->rec_lowest_idx = rec->rec_highest_idx = RAFT_ENTRY_IDX_ANY;
+    else
+        rec->rec_lowest_idx++;
 
-    struct raft_entry *re = niova_malloc(total_entry_size);
-    if (!re)
-        return -ENOMEM;
+    niova_free(re);
+}
 
-    raft_server_entry_init(ri, re, re_idx, term, data, entry_sizes, nentries,
-                           opts);
+static void
+raft_server_entry_cache_flush(struct raft_instance *ri)
+{
+    NIOVA_ASSERT(ri);
 
-    DBG_RAFT_ENTRY(LL_NOTIFY, &re->re_header, "");
+    struct raft_entry_cache *rec = &ri->ri_entry_cache;
 
-    /* Failues of the next set of operations will be fatal:
-     * - Ensuring that the index increases by one and term is not decreasing
-     * - The entire block was written without error
-     * - The block log fd was sync'd without error.
-     */
-    DBG_RAFT_INSTANCE_FATAL_IF(
-        (!raft_server_entry_next_entry_is_valid(ri, &re->re_header)), ri,
-        "raft_server_entry_next_entry_is_valid() failed");
+    niova_mutex_lock(&rec->rec_mutex);
 
-    raft_server_entry_write_by_store(ri, re, ws);
+    while (rec->rec_lowest_idx != RAFT_ENTRY_IDX_ANY)
+        raft_server_entry_cache_remove_lowest_locked(rec);
 
-    /* Following the successful writing and sync of the entry, copy the
-     * header contents into the raft instance.   Note, this is a noop if the
-     * entry is for a log header.
-     */
-    enum raft_instance_newest_entry_hdr_types type =
-        raft_server_does_synchronous_writes(ri) ?
+    NIOVA_ASSERT(!rec->rec_nbytes);
+
+    niova_mutex_unlock(&rec->rec_mutex);
+}
+
+/**
+ * raft_server_entry_cache_release - drop cached entries at and below the
+ *    provided index.  Called once the entries have been applied since neither
+ *    the apply path nor most followers will request them again.
+ */
+static void
+raft_server_entry_cache_release(struct raft_instance *ri,
+                                const raft_entry_idx_t idx)
+{
+    NIOVA_ASSERT(ri);
+
+    struct raft_entry_cache *rec = &ri->ri_entry_cache;
+
+    niova_mutex_lock(&rec->rec_mutex);
+
+    while (rec->rec_lowest_idx != RAFT_ENTRY_IDX_ANY &&
+           rec->rec_lowest_idx <= idx)
+        raft_server_entry_cache_remove_lowest_locked(rec);
+
+    niova_mutex_unlock(&rec->rec_mutex);
+}
+
+/**
+ * raft_server_entry_cache_insert - place a newly written entry into the
+ *    leader's entry cache.  The cache takes ownership of 're' and the caller
+ *    must not access it after this call.  Entries which do not immediately
+ *    follow the newest cached entry cause the cache to be reset.
+ */
+static void
+raft_server_entry_cache_insert(struct raft_instance *ri, struct raft_entry *re)
+{
+    NIOVA_ASSERT(ri && re && re->re_header.reh_index >= 0);
+
+    struct raft_entry_cache *rec = &ri->ri_entry_cache;
+    const size_t re_size = raft_server_entry_to_total_size(re);
+    const raft_entry_idx_t idx = re->re_header.reh_index;
+
+    niova_mutex_lock(&rec->rec_mutex);
+
+    if (re_size > rec->rec_max_bytes)
+    {
+        niova_mutex_unlock(&rec->rec_mutex);
+        niova_free(re);
+        return;
+    }
+
+    if (rec->rec_highest_idx != RAFT_ENTRY_IDX_ANY &&
+        rec->rec_highest_idx + 1 != idx)
+    {
+        while (rec->rec_lowest_idx != RAFT_ENTRY_IDX_ANY)
+            raft_server_entry_cache_remove_lowest_locked(rec);
+    }
+
+    while (rec->rec_lowest_idx != RAFT_ENTRY_IDX_ANY &&
+           (rec->rec_nbytes + re_size > rec->rec_max_bytes ||
+            (idx - rec->rec_lowest_idx) >= RAFT_ENTRY_CACHE_NENTRIES))
+    {
+        raft_server_entry_cache_remove_lowest_locked(rec);
+        rec->rec_evictions++;
+    }
+
+    NIOVA_ASSERT(!rec->rec_ring[idx % RAFT_ENTRY_CACHE_NENTRIES]);
+
+    rec->rec_ring[idx % RAFT_ENTRY_CACHE_NENTRIES] = re;
+    rec->rec_nbytes += re_size;
+    rec->rec_highest_idx = idx;
+    if (rec->rec_lowest_idx == RAFT_ENTRY_IDX_ANY)
+        rec->rec_lowest_idx = idx;
+
+    niova_mutex_unlock(&rec->rec_mutex);
+}
+
+/**
+ * raft_server_entry_cache_lookup - copy the header and, optionally, the data
+ *    of a cached entry into the caller's buffers.  Returns true on a cache
+ *    hit.
+ * @ri:  raft instance pointer
+ * @idx:  raft entry index
+ * @reh:  optional destination for the entry header
+ * @data:  optional destination for the entry data
+ * @len:  number of data bytes to copy, must not exceed the entry's data size
+ */
+static bool
+raft_server_entry_cache_lookup(struct raft_instance *ri,
+                               const raft_entry_idx_t idx,
+                               struct raft_entry_header *reh,
+                               char *data, const size_t len)
+{
+    NIOVA_ASSERT(ri && idx >= 0);
+
+    if (!raft_instance_is_leader(ri))
+        return false;
+
+    struct raft_entry_cache *rec = &ri->ri_entry_cache;
+    bool hit = false;
+
+    niova_mutex_lock(&rec->rec_mutex);
+
+    if (rec->rec_lowest_idx != RAFT_ENTRY_IDX_ANY &&
+        idx >= rec->rec_lowest_idx && idx <= rec->rec_highest_idx)
+    {
+        const struct raft_entry *re =
+            rec->rec_ring[idx % RAFT_ENTRY_CACHE_NENTRIES];
+
+        NIOVA_ASSERT(re && re->re_header.reh_index == idx);
+
+        if (!data || len <= re->re_header.reh_data_size)
+        {
+            if (reh)
+                *reh = re->re_header;
+
+            if (data && len)
+                memcpy(data, re->re_data, len);
+
+            hit = true;
+        }
+    }
+
+    if (hit)
+        rec->rec_hits++;
+    else
+        rec->rec_misses++;
+
+    niova_mutex_unlock(&rec->rec_mutex);
+
+    return hit;
+}
+
+/**
+ * raft_server_entry_cache_ngroups - the hosted groups divide the entry cache
+ *    limits between them so that the host's caches are bounded to the same
+ *    total as those of a single instance.
+ */
+static size_t
+raft_server_entry_cache_ngroups(const struct raft_instance *ri)
+{
+    return (ri->ri_host_workers && ri->ri_host_workers->rhw_ngroups) ?
+        ri->ri_host_workers->rhw_ngroups : 1;
+}
+
+static void
+raft_server_entry_cache_set_max_bytes(struct raft_instance *ri,
+                                      const struct lreg_value *lv)
+{
+    if (!ri || !lv || LREG_VALUE_TO_REQ_TYPE_IN(lv) != LREG_VAL_TYPE_STRING)
+        return;
+
+    const size_t ngroups = raft_server_entry_cache_ngroups(ri);
+
+    unsigned long long max_bytes = RAFT_ENTRY_CACHE_MAX_BYTES / ngroups;
+    if (strncmp(LREG_VALUE_TO_IN_STR(lv), "default", 7))
+    {
+        int rc = niova_string_to_unsigned_long_long(LREG_VALUE_TO_IN_STR(lv),
+                                                    &max_bytes);
+        if (rc)
+            return;
+    }
+
+    // A value of '0' disables the cache
+    if (max_bytes > RAFT_ENTRY_CACHE_MAX_BYTES_MAX / ngroups)
+        max_bytes = RAFT_ENTRY_CACHE_MAX_BYTES_MAX / ngroups;
+
+    struct raft_entry_cache *rec = &ri->ri_entry_cache;
+
+    niova_mutex_lock(&rec->rec_mutex);
+
+    rec->rec_max_bytes = max_bytes;
+
+    while (rec->rec_lowest_idx != RAFT_ENTRY_IDX_ANY &&
+           rec->rec_nbytes > rec->rec_max_bytes)
+    {
+        raft_server_entry_cache_remove_lowest_locked(rec);
+        rec->rec_evictions++;
+    }
+
+    niova_mutex_unlock(&rec->rec_mutex);
+}
+
+static void
+raft_server_entry_cache_init(struct raft_instance *ri)
+{
+    NIOVA_ASSERT(ri);
+
+    struct raft_entry_cache *rec = &ri->ri_entry_cache;
+
+    rec->rec_lowest_idx = RAFT_ENTRY_IDX_ANY;
+    rec->rec_highest_idx = RAFT_ENTRY_IDX_ANY;
+    rec->rec_max_bytes =
+        RAFT_ENTRY_CACHE_MAX_BYTES / raft_server_entry_cache_ngroups(ri);
+}
+
+static int
+raft_server_entry_cache_destroy(struct raft_instance *ri)
+{
+    NIOVA_ASSERT(ri);
+
+    raft_server_entry_cache_flush(ri);
+
+    return pthread_mutex_destroy(&ri->ri_entry_cache.rec_mutex);
+}
+
+/**
+ * raft_server_entry_write - safely store an entry into the raft log at the
+ *    specified index.  This function writes and syncs the data to the
+ *    underlying device and handles partial writes.  NOTE:  it's critical that
+ *    the ri_log_hdr is up-to-date with the correct term prior to calling
+ *    this function.
+ * @ri:  raft instance
+ * @re_idx:  the raft_entry index at which the block will be written
+ * @iov:  the entry data fragments.  For a v2 entry the fragments begin with
+ *    the sub-entry table.
+ * @niov:  number of data fragments
+ * @entry_sizes: Pointer to entry size array, only used for v1 entries.
+ * @nentries: Number of entries to be written.
+ * @opts: write entry option.
+ * @ws: pointer to write supplement for all the nentries.
+ */
+static int
+raft_server_entry_write(struct raft_instance *ri,
+                        const raft_entry_idx_t re_idx,
+                        const int64_t term, const struct iovec *iov,
+                        const size_t niov,
+                        const uint32_t *entry_sizes,
+                        const uint32_t nentries,
+                        enum raft_write_entry_opts opts,
+                        const struct raft_net_sm_write_supplements *ws)
+{
+    const bool v2 = nentries > RAFT_ENTRY_NUM_ENTRIES ? true : false;
+
+    if (!ri || !ri->ri_csn_this_peer || !ri->ri_csn_raft ||
+        (!iov && niov) || niov > RAFT_ENTRY_WRITE_NIOV_MAX ||
+        nentries > RAFT_ENTRY_V2_NUM_ENTRIES_MAX ||
+        (opts != RAFT_WR_ENTRY_OPT_LEADER_CHANGE_MARKER &&
+         (!niov || (!v2 && !entry_sizes))))
+        return -EINVAL;
+
+    size_t entry_size = 0;
+    for (size_t i = 0; i < niov; i++)
+        entry_size += iov[i].iov_len;
+
+    if (entry_size > RAFT_ENTRY_MAX_DATA_SIZE(ri))
+        return -E2BIG;
+
+    if (!v2 && entry_size !=
+        raft_server_wr_entries_get_total_size(entry_sizes, nentries))
+        return -EINVAL;
+
+    /* The entry is handed to the backend as its header plus the caller's
+     * data fragments so that no staging copy of the entry is made for the
+     * write.
+     */
+    struct raft_entry_header reh = {0};
+
+    raft_server_entry_header_init(ri, &reh, re_idx, term, entry_size,
+                                  entry_sizes, nentries, opts);
+
+    // Checksum the entire entry - including the 'data' section
+    reh.reh_crc = raft_server_entry_iov_calc_crc(&reh, iov, niov);
+
+    DBG_RAFT_ENTRY(LL_NOTIFY, &reh, "");
+
+    /* Failues of the next set of operations will be fatal:
+     * - Ensuring that the index increases by one and term is not decreasing
+     * - The entire block was written without error
+     * - The block log fd was sync'd without error.
+     */
+    DBG_RAFT_INSTANCE_FATAL_IF(
+        (!raft_server_entry_next_entry_is_valid(ri, &reh)), ri,
+        "raft_server_entry_next_entry_is_valid() failed");
+
+    raft_server_entry_write_by_store(ri, &reh, iov, niov, ws);
+
+    /* Following the successful writing and sync of the entry, copy the
+     * header contents into the raft instance.   Note, this is a noop if the
+     * entry is for a log header.
+     */
+    enum raft_instance_newest_entry_hdr_types type =
+        raft_server_does_synchronous_writes(ri) ?
         RI_NEHDR_ALL : RI_NEHDR_UNSYNC;
 
-    raft_instance_update_newest_entry_hdr(ri, &re->re_header, type, false);
+    raft_instance_update_newest_entry_hdr(ri, &reh, type, false);
 
-    niova_free(re);
+    if (!raft_server_does_synchronous_writes(ri) && re_idx >= 0)
+        raft_server_sync_group_post(ri);
+
+    /* The leader retains the entry for AE senders and its own SM apply.  A
+     * failed allocation only costs a cache miss since the entry is already
+     * in the log.  The entry is copied rather than the cache taking over the
+     * source buffer:  the coalesce buffer is sized for the largest entry and
+     * reused for the next batch, and the client buffers of a direct write are
+     * released once the request is queued, so an allocation of the entry's
+     * actual size is the cheaper owner.
+     */
+    if (raft_instance_is_leader(ri) && re_idx >= 0)
+    {
+        struct raft_entry *re =
+            niova_malloc_can_fail(sizeof(struct raft_entry) + entry_size);
+
+        if (re)
+        {
+            re->re_header = reh;
+
+            for (size_t i = 0, off = 0; i < niov; i++)
+            {
+                memcpy(&re->re_data[off], iov[i].iov_base, iov[i].iov_len);
+                off += iov[i].iov_len;
+            }
+
+            raft_server_entry_cache_insert(ri, re);
+        }
+    }
 
     if (raft_server_does_synchronous_writes(ri))
         DBG_RAFT_INSTANCE_FATAL_IF((raft_server_has_unsynced_entries(ri)), ri,
@@ -933,6 +2054,66 @@ raft_server_entry_init_for_log_header(const struct raft_instance *ri,
                                   RAFT_WR_ENTRY_OPT_LOG_HEADER);
 }
 
+/**
+ * raft_server_entry_pwritev - writes the entry header followed by its data
+ *    fragments at the provided offset using pwritev(), resubmitting the
+ *    remainder after a short write.  Returns the number of bytes written or
+ *    a negative errno.
+ */
+ssize_t
+raft_server_entry_pwritev(const int fd, const struct raft_entry_header *reh,
+                          const struct iovec *iov, const size_t niov,
+                          const off_t offset)
+{
+    if (fd < 0 || !reh || (!iov && niov) || niov > RAFT_ENTRY_WRITE_NIOV_MAX)
+        return -EINVAL;
+
+    struct iovec wr_iov[RAFT_ENTRY_WRITE_NIOV_MAX + 1];
+    struct iovec *cur = wr_iov;
+    int ncur = (int)niov + 1;
+
+    wr_iov[0].iov_base = (void *)reh;
+    wr_iov[0].iov_len = sizeof(struct raft_entry);
+
+    for (size_t i = 0; i < niov; i++)
+        wr_iov[i + 1] = iov[i];
+
+    ssize_t total = 0;
+
+    while (ncur > 0)
+    {
+        ssize_t rc = pwritev(fd, cur, ncur, offset + total);
+        if (rc < 0)
+        {
+            if (errno == EINTR)
+                continue;
+
+            return -errno;
+        }
+        else if (rc == 0)
+        {
+            break;
+        }
+
+        total += rc;
+
+        while (ncur > 0 && (size_t)rc >= cur->iov_len)
+        {
+            rc -= cur->iov_len;
+            cur++;
+            ncur--;
+        }
+
+        if (ncur > 0)
+        {
+            cur->iov_base = (char *)cur->iov_base + rc;
+            cur->iov_len -= rc;
+        }
+    }
+
+    return total;
+}
+
 /**
  * read_server_entry_validate - checks the entry header contents against
  *    expected values.  This check preceeds the entry's CRC check and is meant
@@ -946,8 +2127,10 @@ read_server_entry_validate(const struct raft_instance *ri,
 {
     NIOVA_ASSERT(ri && rh && ri->ri_csn_this_peer && ri->ri_csn_raft);
 
-    // Validate magic and data size.
+    // Validate magic, header version, and data size.
     if (rh->reh_magic != RAFT_ENTRY_MAGIC ||
+        (rh->reh_version != RAFT_ENTRY_HEADER_V1 &&
+         rh->reh_version != RAFT_ENTRY_HEADER_V2) ||
         rh->reh_data_size > RAFT_ENTRY_MAX_DATA_SIZE(ri))
         return -EINVAL;
 
@@ -1002,49 +2185,129 @@ raft_server_entry_range_check(struct raft_instance *ri,
     return 0;
 }
 
+/**
+ * raft_server_read_pin_claim - claims a free ri_read_pins slot for
+ *    'entry_idx' and returns its index.  The number of concurrent readers is
+ *    bounded, so a free slot is normally found on the first pass.  Otherwise,
+ *    the caller backs off with sleeps rather than spinning on the slots.
+ */
+static int
+raft_server_read_pin_claim(struct raft_instance *ri,
+                           const raft_entry_idx_t entry_idx)
+{
+    useconds_t sleep_us = 1;
+    unsigned long long waited_us = 0;
+
+    for (int pass = 0;; pass++)
+    {
+        for (int i = 0; i < RAFT_READ_PIN_SLOTS; i++)
+        {
+            if (niova_atomic_cas(&ri->ri_read_pins[i], RAFT_ENTRY_IDX_ANY,
+                                 entry_idx))
+                return i;
+        }
+
+        if (pass < RAFT_SERVER_READ_PIN_SPIN_PASSES)
+            continue;
+
+        DBG_RAFT_INSTANCE_FATAL_IF(
+            (waited_us >= RAFT_SERVER_READ_PIN_TIMEOUT_US), ri,
+            "no read pin slot after %lluus (entry=%ld)", waited_us,
+            entry_idx);
+
+        usleep(sleep_us);
+        waited_us += sleep_us;
+        sleep_us = MIN(sleep_us * 2, RAFT_SERVER_READ_PIN_SLEEP_MAX_US);
+    }
+}
+
+/**
+ * raft_server_read_entry_register_idx - pins 'entry_idx' so that it may not
+ *    be removed by compaction while the read is in progress.  Each reader
+ *    claims one of the ri_read_pins slots with a CAS and then rechecks the
+ *    lowest index, so the common case takes no lock.  A reader only falls
+ *    back to the compaction mutex when a compaction covering its index is
+ *    in progress, see raft_server_compaction_try_increase_lowest_idx().
+ *    On success, the claimed slot is returned via 'ret_slot'.
+ */
 static int
 raft_server_read_entry_register_idx(struct raft_instance *ri,
-                                    const raft_entry_idx_t entry_idx)
+                                    const raft_entry_idx_t entry_idx,
+                                    int *ret_slot)
 {
-    NIOVA_ASSERT(ri && entry_idx >= 0);
+    NIOVA_ASSERT(ri && entry_idx >= 0 && ret_slot);
 
     int rc = raft_server_entry_range_check(ri, entry_idx, NULL);
     if (rc)
         return rc;
 
-    niova_mutex_lock(&ri->ri_compaction_mutex);
-    // only one read at a time
-    NIOVA_ASSERT(ri->ri_pending_read_idx == RAFT_ENTRY_IDX_ANY);
+    const int slot = raft_server_read_pin_claim(ri, entry_idx);
 
-    rc = raft_server_entry_has_been_compacted(ri, entry_idx, NULL);
-    if (!rc)
-        ri->ri_pending_read_idx = entry_idx;
+    // Order the pin store before the loads of the lowest idx values
+    __sync_synchronize();
 
-    niova_mutex_unlock(&ri->ri_compaction_mutex);
+    /* The pending idx must be loaded before the lowest idx.  The compactor
+     * stores the new lowest idx before clearing the pending idx, so a reader
+     * which finds no pending compaction here is guaranteed to observe the
+     * result of any compaction which had missed its pin.
+     */
+    const raft_entry_idx_t pending_idx =
+        niova_atomic_read(&ri->ri_pending_lowest_idx);
+
+    __sync_synchronize();
+
+    bool compacted = raft_server_entry_has_been_compacted(ri, entry_idx,
+                                                          NULL);
+
+    if (!compacted && pending_idx != RAFT_ENTRY_IDX_ANY &&
+        entry_idx < pending_idx)
+    {
+        /* A compaction which covers this idx is underway.  Once the mutex is
+         * acquired, the compaction has either completed or backed off due to
+         * this pin.
+         */
+        niova_mutex_lock(&ri->ri_compaction_mutex);
+        compacted = raft_server_entry_has_been_compacted(ri, entry_idx, NULL);
+        niova_mutex_unlock(&ri->ri_compaction_mutex);
+    }
+
+    if (compacted)
+    {
+        niova_atomic_init(&ri->ri_read_pins[slot], RAFT_ENTRY_IDX_ANY);
+        rc = -ERANGE;
 
-    if (rc)
         DBG_RAFT_INSTANCE(
             LL_WARN, ri,
             "raft_server_entry_has_been_compacted(entry=%ld): %s",
             entry_idx, strerror(-rc));
+    }
+    else
+    {
+        *ret_slot = slot;
+    }
 
     return rc;
 }
 
 static void
 raft_server_read_entry_unregister_idx(struct raft_instance *ri,
-                                      const raft_entry_idx_t entry_idx)
+                                      const raft_entry_idx_t entry_idx,
+                                      const int slot)
 {
-    NIOVA_ASSERT(ri);
-
-    niova_mutex_lock(&ri->ri_compaction_mutex);
+    NIOVA_ASSERT(ri && slot >= 0 && slot < RAFT_READ_PIN_SLOTS);
 
-    NIOVA_ASSERT(ri->ri_pending_read_idx == entry_idx);
-    ri->ri_pending_read_idx = RAFT_ENTRY_IDX_ANY;
-
-    niova_mutex_unlock(&ri->ri_compaction_mutex);
+    bool released = niova_atomic_cas(&ri->ri_read_pins[slot], entry_idx,
+                                     RAFT_ENTRY_IDX_ANY);
+    NIOVA_ASSERT(released);
 }
 
+/**
+ * raft_server_compaction_try_increase_lowest_idx - raises ri_lowest_idx
+ *    unless a reader holds a pin below 'new_lowest_idx'.  The pending value
+ *    is published before the pins are scanned so that a reader which pins
+ *    concurrently either is seen here or sees the pending value and
+ *    serializes with this function through the compaction mutex.
+ */
 static raft_server_chkpt_thread_ctx_int_t
 raft_server_compaction_try_increase_lowest_idx(
     struct raft_instance *ri, const raft_entry_idx_t new_lowest_idx)
@@ -1056,13 +2319,29 @@ raft_server_compaction_try_increase_lowest_idx(
     niova_mutex_lock(&ri->ri_compaction_mutex);
     NIOVA_ASSERT(new_lowest_idx > niova_atomic_read(&ri->ri_lowest_idx));
 
+    niova_atomic_init(&ri->ri_pending_lowest_idx, new_lowest_idx);
+
+    // Order the pending store before the loads of the pins
+    __sync_synchronize();
+
     // A read is currently operating in the compaction region
-    if (ri->ri_pending_read_idx != RAFT_ENTRY_IDX_ANY &&
-        ri->ri_pending_read_idx < new_lowest_idx)
-        rc = -EAGAIN;
-    else
+    for (int i = 0; i < RAFT_READ_PIN_SLOTS && !rc; i++)
+    {
+        const raft_entry_idx_t pin_idx =
+            niova_atomic_read(&ri->ri_read_pins[i]);
+
+        if (pin_idx != RAFT_ENTRY_IDX_ANY && pin_idx < new_lowest_idx)
+            rc = -EAGAIN;
+    }
+
+    if (!rc)
         niova_atomic_init(&ri->ri_lowest_idx, new_lowest_idx);
 
+    // Readers rely on the lowest idx being visible before pending is cleared
+    __sync_synchronize();
+
+    niova_atomic_init(&ri->ri_pending_lowest_idx, RAFT_ENTRY_IDX_ANY);
+
     niova_mutex_unlock(&ri->ri_compaction_mutex);
 
     return rc;
@@ -1085,7 +2364,8 @@ raft_server_entry_read_by_store_common(struct raft_instance *ri,
     const raft_entry_idx_t idx = reh->reh_index;
 
     // Test that the idx is within range and prevent compaction removing it
-    int rc = raft_server_read_entry_register_idx(ri, idx);
+    int pin_slot = -1;
+    int rc = raft_server_read_entry_register_idx(ri, idx, &pin_slot);
     if (rc)
     {
         NIOVA_ASSERT(rc == -ERANGE);
@@ -1099,7 +2379,7 @@ raft_server_entry_read_by_store_common(struct raft_instance *ri,
         : ri->ri_backend->rib_entry_read(ri, re);
 
     // unregister after the read operation
-    raft_server_read_entry_unregister_idx(ri, idx);
+    raft_server_read_entry_unregister_idx(ri, idx, pin_slot);
 
     NIOVA_TIMER_STOP_and_HIST_ADD(
         x, raft_server_type_2_hist(ri, RAFT_INSTANCE_HIST_DEV_READ_LAT_USEC));
@@ -1139,21 +2419,164 @@ raft_server_entry_read_by_store(struct raft_instance *ri,
     return raft_server_entry_read_by_store_common(ri, re, false);
 }
 
-/**
- * raft_server_entry_read - request a read of a raft log entry.
- * @ri:  raft instance pointer
- * @re_idx: raft entry index
- * @data:  sink buffer
- * @len:  size of the sink buffer
+static void
+raft_server_entry_view_release(struct raft_instance *ri,
+                               struct raft_entry_view *rev)
+{
+    NIOVA_ASSERT(ri && rev);
+
+    if (rev->rev_handle)
+        ri->ri_backend->rib_entry_view_release(ri, rev);
+
+    if (rev->rev_pin_slot >= 0)
+        raft_server_read_entry_unregister_idx(ri, rev->rev_idx,
+                                              rev->rev_pin_slot);
+
+    rev->rev_data = NULL;
+    rev->rev_size = 0;
+    rev->rev_handle = NULL;
+    rev->rev_pin_slot = -1;
+}
+
+/**
+ * raft_server_entry_read_view - obtain a read-only view of an entry's data
+ *    without copying it out of the backend.  The entry remains pinned against
+ *    compaction until raft_server_entry_view_release() is called.
+ * @ri:  raft instance pointer
+ * @reh:  header of the entry, previously read and validated by the caller
+ * @rev:  the view to be filled in
+ * Returns -EOPNOTSUPP if the backend does not support views.
+ */
+static int
+raft_server_entry_read_view(struct raft_instance *ri,
+                            const struct raft_entry_header *reh,
+                            struct raft_entry_view *rev)
+{
+    NIOVA_ASSERT(ri && reh && rev && reh->reh_index >= 0);
+
+    rev->rev_data = NULL;
+    rev->rev_size = 0;
+    rev->rev_handle = NULL;
+    rev->rev_idx = reh->reh_index;
+    rev->rev_pin_slot = -1;
+
+    if (!ri->ri_backend->rib_entry_read_view ||
+        !ri->ri_backend->rib_entry_view_release)
+        return -EOPNOTSUPP;
+
+    int rc = raft_server_read_entry_register_idx(ri, reh->reh_index,
+                                                 &rev->rev_pin_slot);
+    if (rc)
+        return rc;
+
+    NIOVA_TIMER_START(x);
+
+    rc = ri->ri_backend->rib_entry_read_view(ri, reh, rev);
+
+    NIOVA_TIMER_STOP_and_HIST_ADD(
+        x, raft_server_type_2_hist(ri, RAFT_INSTANCE_HIST_DEV_READ_LAT_USEC));
+
+    if (!rc && rev->rev_size != reh->reh_data_size)
+        rc = -EMSGSIZE;
+
+    else if (!rc &&
+             raft_server_entry_view_calc_crc(reh, rev->rev_data) !=
+             reh->reh_crc)
+        rc = -EBADMSG;
+
+    if (rc)
+    {
+        DBG_RAFT_ENTRY(LL_ERROR, reh, "view-sz=%zu: %s", rev->rev_size,
+                       strerror(-rc));
+
+        raft_server_entry_view_release(ri, rev);
+    }
+
+    return rc;
+}
+
+static int
+raft_server_entry_header_read_by_store(struct raft_instance *ri,
+                                       struct raft_entry_header *reh,
+                                       raft_entry_idx_t reh_index);
+
+/**
+ * raft_server_entry_read_from_view - copies an entry's data into the sink
+ *    buffer through a backend view.  This bypasses the staging raft_entry
+ *    allocation and its copy.  The header is only read from the backend if
+ *    the caller did not supply it.
+ */
+static int
+raft_server_entry_read_from_view(struct raft_instance *ri,
+                                 const raft_entry_idx_t re_idx,
+                                 const struct raft_entry_header *known_reh,
+                                 char *data, const size_t len,
+                                 size_t *rc_len)
+{
+    NIOVA_ASSERT(ri && data && (!known_reh || known_reh->reh_index == re_idx));
+
+    struct raft_entry_header reh = {0};
+
+    if (known_reh)
+    {
+        reh = *known_reh;
+    }
+    else
+    {
+        int rc = raft_server_entry_header_read_by_store(ri, &reh, re_idx);
+        if (rc)
+            return rc;
+    }
+
+    if (rc_len)
+        *rc_len = reh.reh_data_size;
+
+    if (reh.reh_data_size < len)
+        return -ENOSPC;
+
+    struct raft_entry_view rev;
+
+    int rc = raft_server_entry_read_view(ri, &reh, &rev);
+    if (rc)
+        return rc;
+
+    memcpy(data, rev.rev_data, len);
+
+    raft_server_entry_view_release(ri, &rev);
+
+    return 0;
+}
+
+/**
+ * raft_server_entry_read - request a read of a raft log entry.
+ * @ri:  raft instance pointer
+ * @re_idx: raft entry index
+ * @reh:  the entry's header when already read by the caller, may be NULL
+ * @data:  sink buffer
+ * @len:  size of the sink buffer
  * @rc_len:  the data size of this entry
  */
 static int
 raft_server_entry_read(struct raft_instance *ri, const raft_entry_idx_t re_idx,
-                       char *data, const size_t len, size_t *rc_len)
+                       const struct raft_entry_header *reh, char *data,
+                       const size_t len, size_t *rc_len)
 {
     if (!ri || !data || len > ri->ri_max_entry_size)
         return -EINVAL;
 
+    struct raft_entry_header cached_reh;
+    if (raft_server_entry_cache_lookup(ri, re_idx, &cached_reh, data, len))
+    {
+        if (rc_len)
+            *rc_len = cached_reh.reh_data_size;
+
+        return 0;
+    }
+
+    if (ri->ri_backend->rib_entry_read_view)
+        return raft_server_entry_read_from_view(ri, re_idx, reh, data, len,
+                                                rc_len);
+
     const size_t total_entry_size = sizeof(struct raft_entry) + len;
 
     struct raft_entry *re = niova_malloc(total_entry_size);
@@ -1219,6 +2642,27 @@ raft_server_entry_header_read_by_store(struct raft_instance *ri,
     return rc ? rc : read_server_entry_validate(ri, reh, reh_index);
 }
 
+/**
+ * raft_server_entry_header_read - read a raft log entry's header, preferring
+ *    the leader's entry cache over the backend.
+ * @ri:  raft instance pointer
+ * @reh:  the destination entry header buffer
+ * @reh_index:  logical raft entry to read
+ */
+static int
+raft_server_entry_header_read(struct raft_instance *ri,
+                              struct raft_entry_header *reh,
+                              raft_entry_idx_t reh_index)
+{
+    if (!ri || !reh || reh_index < 0)
+        return -EINVAL;
+
+    if (raft_server_entry_cache_lookup(ri, reh_index, reh, NULL, 0))
+        return 0;
+
+    return raft_server_entry_header_read_by_store(ri, reh, reh_index);
+}
+
 static int
 raft_server_header_load(struct raft_instance *ri)
 {
@@ -1266,9 +2710,9 @@ raft_server_backend_sync(struct raft_instance *ri, const char *caller)
         NIOVA_ASSERT(ri->ri_backend->rib_backend_sync);
     }
 
-    static pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
-    // Serialize this function
-    NIOVA_ASSERT(!pthread_mutex_lock(&mutex));
+    // Serialize this function, per instance so that hosted groups don't wait
+    pthread_mutex_t *mutex = &ri->ri_sync_group.rsg_sync_mutex;
+    NIOVA_ASSERT(!pthread_mutex_lock(mutex));
 
     // copy last_applied_idx since it be incremented outside this thread
     const int64_t my_last_applied_idx = ri->ri_last_applied.rla_idx;
@@ -1282,9 +2726,11 @@ raft_server_backend_sync(struct raft_instance *ri, const char *caller)
 
     NIOVA_ASSERT(sync_idx <= unsync_reh.reh_index);
 
-    binary_hist_incorporate_val(
-        raft_server_type_2_hist(ri, RAFT_INSTANCE_HIST_NENTRIES_SYNC),
-        unsync_reh.reh_index - sync_idx);
+    // Record the effective group-commit size, log header syncs carry none
+    if (unsync_reh.reh_index > sync_idx)
+        binary_hist_incorporate_val(
+            raft_server_type_2_hist(ri, RAFT_INSTANCE_HIST_NENTRIES_SYNC),
+            unsync_reh.reh_index - sync_idx);
 
     DBG_RAFT_INSTANCE(LL_DEBUG, ri, "caller=%s nentries-this-sync=%ld",
                       caller, unsync_reh.reh_index - sync_idx);
@@ -1311,7 +2757,7 @@ raft_server_backend_sync(struct raft_instance *ri, const char *caller)
     if (ri->ri_last_applied.rla_synced_idx < my_last_applied_idx)
         ri->ri_last_applied.rla_synced_idx = my_last_applied_idx;
 
-    NIOVA_ASSERT(!pthread_mutex_unlock(&mutex));
+    NIOVA_ASSERT(!pthread_mutex_unlock(mutex));
 
     return rc;
 }
@@ -1379,6 +2825,10 @@ raft_server_backend_setup(struct raft_instance *ri)
         raft_server_backend_use_posix(ri);
         break;
 
+    case RAFT_INSTANCE_STORE_POSIX_SEGMENTED:
+        raft_server_backend_use_segment(ri);
+        break;
+
     case RAFT_INSTANCE_STORE_ROCKSDB: // fall through
     case RAFT_INSTANCE_STORE_ROCKSDB_PERSISTENT_APP:
         raft_server_backend_use_rocksdb(ri);
@@ -1478,157 +2928,548 @@ raft_server_entry_next_entry_is_valid(struct raft_instance *ri,
     return true;
 }
 
-static int
-raft_server_entries_scan_internal(struct raft_instance *ri,
-                                  const raft_entry_idx_t start,
-                                  const raft_entry_idx_t max)
+/* The startup scan copies entries into the buffer of one CRC worker at a
+ * time.  Once that buffer is full it is handed to its worker and the scan
+ * moves on to the next worker's buffer, waiting only if that worker has not
+ * finished its previous batch.
+ */
+struct raft_scan_crc_worker
+{
+    struct thread_ctl      rscw_thread_ctl;
+    struct raft_scan_crc  *rscw_rsc;
+    char                  *rscw_buf;
+    size_t                 rscw_used;
+    bool                   rscw_busy; // protected by rsc_mutex
+    bool                   rscw_running;
+};
+
+struct raft_scan_crc
 {
-    int rc = 0;
+    pthread_mutex_t             rsc_mutex;
+    pthread_cond_t              rsc_cond;
+    size_t                      rsc_nworkers;
+    size_t                      rsc_cur; // worker whose buffer is filling
+    size_t                      rsc_buf_sz;
+    size_t                      rsc_nverified;
+    raft_entry_idx_t            rsc_bad_idx; // lowest idx failing its crc
+    struct raft_scan_crc_worker rsc_workers[RAFT_STARTUP_SCAN_CRC_THREADS_MAX];
+};
 
-    struct raft_entry_header reh;
+struct raft_server_scan_ctx
+{
+    struct raft_instance *rssc_ri;
+    struct raft_scan_crc *rssc_crc; // NULL if entry crcs are not verified
+    raft_entry_idx_t      rssc_start;
+    raft_entry_idx_t      rssc_next; // index of the next expected entry
+};
+
+static void
+raft_server_timedwait_deadline(struct timespec *, const unsigned long long);
+
+static size_t
+raft_server_scan_crc_rec_size(const struct raft_entry_header *reh)
+{
+    return (sizeof(struct raft_entry) + reh->reh_data_size + 7UL) & ~7UL;
+}
+
+static raft_server_scan_crc_thread_t
+raft_server_scan_crc_thread(void *arg)
+{
+    struct thread_ctl *tc = arg;
+    struct raft_scan_crc_worker *rscw =
+        (struct raft_scan_crc_worker *)thread_ctl_get_arg(tc);
+
+    NIOVA_ASSERT(rscw && rscw->rscw_rsc && rscw->rscw_buf);
+
+    struct raft_scan_crc *rsc = rscw->rscw_rsc;
 
-    for (raft_entry_idx_t i = start; i < max; i++)
+    THREAD_LOOP_WITH_CTL(tc)
     {
-        rc = raft_server_entry_header_read_by_store(ri, &reh, i);
+        struct timespec ts;
 
-        DBG_RAFT_ENTRY(LL_DEBUG, &reh, "i=%lx rc=%d", i, rc);
-        if (rc)
+        niova_mutex_lock(&rsc->rsc_mutex);
+
+        if (!rscw->rscw_busy)
         {
-            DBG_RAFT_ENTRY(LL_DEBUG, &reh,
-                           "raft_server_entry_header_read_by_store():  %s",
-                           strerror(-rc));
-            break;
+            raft_server_timedwait_deadline(&ts, RAFT_SERVER_SCAN_CRC_WAIT_US);
+            pthread_cond_timedwait(&rsc->rsc_cond, &rsc->rsc_mutex, &ts);
         }
 
-        /* Skip the validity check on the first iteration when starting_entry
-         * is set.
-         */
-        else if (start && i > start)
+        const bool busy = rscw->rscw_busy;
+
+        niova_mutex_unlock(&rsc->rsc_mutex);
+
+        if (!busy)
+            continue;
+
+        raft_entry_idx_t bad_idx = -1;
+        size_t nverified = 0;
+
+        // Entries are in index order so the first failure is the lowest
+        for (size_t off = 0; off < rscw->rscw_used; nverified++)
         {
-            if (!raft_server_entry_next_entry_is_valid(ri, &reh))
+            const struct raft_entry *re =
+                (const struct raft_entry *)&rscw->rscw_buf[off];
+
+            if (raft_server_entry_check_crc(re))
             {
-                rc = -EINVAL;
-                DBG_RAFT_ENTRY(
-                    LL_WARN, &reh,
-                    "raft_server_entry_next_entry_is_valid() false");
+                bad_idx = re->re_header.reh_index;
                 break;
             }
+
+            off += raft_server_scan_crc_rec_size(&re->re_header);
         }
 
-        /* During startup, sync and unsynced should be equivalent since all
-         * found entries are considered to be synced and 'synced' status for
-         * a raft instance occurs when the unsynced-idx == synced-idx.
-         */
-        raft_instance_update_newest_entry_hdr(ri, &reh, RI_NEHDR_ALL, false);
+        niova_mutex_lock(&rsc->rsc_mutex);
+
+        if (bad_idx >= 0 &&
+            (rsc->rsc_bad_idx < 0 || bad_idx < rsc->rsc_bad_idx))
+            rsc->rsc_bad_idx = bad_idx;
+
+        rsc->rsc_nverified += nverified;
+        rscw->rscw_used = 0;
+        rscw->rscw_busy = false;
+
+        pthread_cond_broadcast(&rsc->rsc_cond);
+        niova_mutex_unlock(&rsc->rsc_mutex);
     }
 
-    return rc;
+    return (void *)0;
+}
+
+static void
+raft_server_scan_crc_worker_dispatch(struct raft_scan_crc *rsc,
+                                     struct raft_scan_crc_worker *rscw)
+{
+    if (!rscw->rscw_used)
+        return;
+
+    niova_mutex_lock(&rsc->rsc_mutex);
+
+    rscw->rscw_busy = true;
+    pthread_cond_broadcast(&rsc->rsc_cond);
+
+    niova_mutex_unlock(&rsc->rsc_mutex);
+}
+
+static void
+raft_server_scan_crc_worker_wait(struct raft_scan_crc *rsc,
+                                 struct raft_scan_crc_worker *rscw)
+{
+    niova_mutex_lock(&rsc->rsc_mutex);
+
+    while (rscw->rscw_busy)
+        pthread_cond_wait(&rsc->rsc_cond, &rsc->rsc_mutex);
+
+    niova_mutex_unlock(&rsc->rsc_mutex);
 }
 
 /**
- * raft_server_entries_scan - reads through the non-header log entries to the
- *    log's end with the purpose of finding the latest valid entry and
- *    performing a cursory verification of the header entries.  Note that this
- *    scan may be "fast-forwarded" if the store type is of
- *    RAFT_INSTANCE_STORE_ROCKSDB_PERSISTENT_APP.  In this case, the scan will
- *    still check the initial set of header entries.
+ * raft_server_scan_crc_enqueue - copies the entry into the buffer being
+ *    filled, handing that buffer to its worker once the entry does not fit.
+ *    The header must have been validated so that its data size is bounded.
+ */
+static void
+raft_server_scan_crc_enqueue(struct raft_scan_crc *rsc,
+                             const struct raft_entry_header *reh,
+                             const char *data)
+{
+    NIOVA_ASSERT(rsc && reh && (data || !reh->reh_data_size));
+
+    const size_t rec_sz = raft_server_scan_crc_rec_size(reh);
+    NIOVA_ASSERT(rec_sz <= rsc->rsc_buf_sz);
+
+    struct raft_scan_crc_worker *rscw = &rsc->rsc_workers[rsc->rsc_cur];
+
+    if (rscw->rscw_used + rec_sz > rsc->rsc_buf_sz)
+    {
+        raft_server_scan_crc_worker_dispatch(rsc, rscw);
+
+        rsc->rsc_cur = (rsc->rsc_cur + 1) % rsc->rsc_nworkers;
+        rscw = &rsc->rsc_workers[rsc->rsc_cur];
+
+        raft_server_scan_crc_worker_wait(rsc, rscw);
+    }
+
+    struct raft_entry *re =
+        (struct raft_entry *)&rscw->rscw_buf[rscw->rscw_used];
+
+    re->re_header = *reh;
+    if (reh->reh_data_size)
+        memcpy(re->re_data, data, reh->reh_data_size);
+
+    rscw->rscw_used += rec_sz;
+}
+
+static void
+raft_server_scan_crc_destroy(struct raft_scan_crc *rsc)
+{
+    if (!rsc)
+        return;
+
+    for (size_t i = 0; i < rsc->rsc_nworkers; i++)
+    {
+        struct raft_scan_crc_worker *rscw = &rsc->rsc_workers[i];
+
+        if (rscw->rscw_running)
+        {
+            int rc = thread_halt_and_destroy(&rscw->rscw_thread_ctl);
+
+            LOG_MSG((rc ? LL_WARN : LL_DEBUG),
+                    "thread_halt_and_destroy(): %s", strerror(-rc));
+        }
+
+        niova_free(rscw->rscw_buf);
+    }
+
+    pthread_cond_destroy(&rsc->rsc_cond);
+    pthread_mutex_destroy(&rsc->rsc_mutex);
+
+    niova_free(rsc);
+}
+
+/**
+ * raft_server_scan_crc_start - starts ri_startup_scan_crc_threads workers
+ *    for verifying entry crcs during the startup scan.  *ret_rsc is left
+ *    NULL if no workers are configured.
  */
 static int
-raft_server_entries_scan(struct raft_instance *ri)
+raft_server_scan_crc_start(struct raft_instance *ri,
+                           struct raft_scan_crc **ret_rsc)
 {
-    NIOVA_ASSERT(ri);
+    NIOVA_ASSERT(ri && ret_rsc);
 
-    const raft_entry_idx_t entry_max_idx = ri->ri_entries_detected_at_startup;
-    if (!entry_max_idx)
+    *ret_rsc = NULL;
+
+    const size_t nworkers = MIN(ri->ri_startup_scan_crc_threads,
+                                RAFT_STARTUP_SCAN_CRC_THREADS_MAX);
+    if (!nworkers)
         return 0;
 
-    else if (entry_max_idx < 0)
-        return (int)entry_max_idx;
+    struct raft_scan_crc *rsc = niova_calloc(1UL, sizeof(*rsc));
+    if (!rsc)
+        return -ENOMEM;
 
-    const raft_entry_idx_t lowest_idx = niova_atomic_read(&ri->ri_lowest_idx);
+    FATAL_IF((pthread_mutex_init(&rsc->rsc_mutex, NULL)),
+             "pthread_mutex_init(): %s", strerror(errno));
 
-    raft_entry_idx_t starting_entry = MAX(0, lowest_idx);
+    FATAL_IF((pthread_cond_init(&rsc->rsc_cond, NULL)),
+             "pthread_cond_init(): %s", strerror(errno));
 
-    // Try to raise the starting_entry if conditions allow
-    if (ri->ri_store_type == RAFT_INSTANCE_STORE_ROCKSDB_PERSISTENT_APP &&
-        ri->ri_max_scan_entries > 0 &&
-        entry_max_idx > ri->ri_max_scan_entries)
-        starting_entry = MAX(lowest_idx,
-                             entry_max_idx - ri->ri_max_scan_entries);
+    // A buffer must be able to hold the largest entry
+    rsc->rsc_buf_sz = MAX(RAFT_SERVER_SCAN_CRC_BUF_SZ,
+                          sizeof(struct raft_entry) + ri->ri_max_entry_size +
+                          8UL);
+    rsc->rsc_bad_idx = -1;
+    rsc->rsc_nworkers = nworkers;
 
-    /* Ensure the start of the key space is intact since it may not be
-     * otherwise checked due to ri_max_scan_entries.
-     */
-    if (starting_entry > 0)
+    for (size_t i = 0; i < nworkers; i++)
     {
-#define LOG_INITIAL_SCAN_SZ 1000L
-        int rc = raft_server_entries_scan_internal(
-            ri, lowest_idx,
-            MIN((lowest_idx + LOG_INITIAL_SCAN_SZ), entry_max_idx));
+        struct raft_scan_crc_worker *rscw = &rsc->rsc_workers[i];
+
+        rscw->rscw_rsc = rsc;
+        rscw->rscw_buf = niova_malloc(rsc->rsc_buf_sz);
+        if (!rscw->rscw_buf)
+        {
+            raft_server_scan_crc_destroy(rsc);
+            return -ENOMEM;
+        }
+
+        int rc = thread_create_watched(raft_server_scan_crc_thread,
+                                       &rscw->rscw_thread_ctl, "scan_crc",
+                                       (void *)rscw, NULL);
         if (rc)
+        {
+            raft_server_scan_crc_destroy(rsc);
             return rc;
+        }
 
-        // Reinit
-        raft_instance_initialize_newest_entry_hdr(ri);
+        thread_ctl_run(&rscw->rscw_thread_ctl);
+        rscw->rscw_running = true;
     }
 
-    return raft_server_entries_scan_internal(ri, starting_entry,
-                                             entry_max_idx);
+    *ret_rsc = rsc;
+
+    return 0;
 }
 
 /**
- * raft_server_log_truncate - prune the log to the point after which the last
- *    "valid" entry has been found.  The contents of ri_newest_entry_hdr
- *    determine index of the last valid entry.  Note that this function will
- *    abort if there is an I/O error.
+ * raft_server_scan_crc_finish - hands off the partially filled buffer, waits
+ *    for every worker to complete, and stops the workers.  Returns -EBADMSG
+ *    if any entry failed its crc check.
  */
-static void //raft_server_udp_cb_ctx_int_t
-raft_server_log_truncate(struct raft_instance *ri)
+static int
+raft_server_scan_crc_finish(struct raft_instance *ri,
+                            struct raft_scan_crc *rsc)
 {
-    NIOVA_ASSERT(ri);
+    NIOVA_ASSERT(ri && rsc);
 
-    const raft_entry_idx_t trunc_entry_idx =
-        raft_server_get_current_raft_entry_index(ri, RI_NEHDR_SYNC) + 1;
+    raft_server_scan_crc_worker_dispatch(rsc, &rsc->rsc_workers[rsc->rsc_cur]);
 
-    NIOVA_ASSERT(trunc_entry_idx >= 0);
+    for (size_t i = 0; i < rsc->rsc_nworkers; i++)
+        raft_server_scan_crc_worker_wait(rsc, &rsc->rsc_workers[i]);
 
-    ri->ri_backend->rib_log_truncate(ri, trunc_entry_idx);
+    const raft_entry_idx_t bad_idx = rsc->rsc_bad_idx;
 
-    DBG_RAFT_INSTANCE_TAG(LL_NOTIFY, "log-rollback", ri, "new-max-raft-idx=%ld",
-                          trunc_entry_idx);
+    DBG_RAFT_INSTANCE((bad_idx >= 0 ? LL_ERROR : LL_NOTIFY), ri,
+                      "scan-crc workers=%zu verified=%zu bad-idx=%ld",
+                      rsc->rsc_nworkers, rsc->rsc_nverified, bad_idx);
+
+    raft_server_scan_crc_destroy(rsc);
+
+    return bad_idx >= 0 ? -EBADMSG : 0;
 }
 
 /**
- * raft_server_log_load - read in the header blocks and scan the entry blocks
- *    to find the latest entry, checking for validity along the way.  After
- *    scanning the log entries, one by one, raft_server_log_load() will
- *    truncate any log space which may exist beyond highest validated log
- *    block.  raft_server_log_load() ensures that ri->ri_newest_entry_hdr
- *    contains the last written, valid block header.
+ * raft_server_entries_scan_entry - validates one header produced by the
+ *    startup scan and advances the newest entry header.  Entries arrive in
+ *    index order.  'data' is only present when entry crcs are verified.
  */
 static int
-raft_server_log_load(struct raft_instance *ri)
+raft_server_entries_scan_entry(void *arg, const struct raft_entry_header *reh,
+                               const char *data)
 {
-    NIOVA_ASSERT(ri);
+    struct raft_server_scan_ctx *rssc = arg;
+    NIOVA_ASSERT(rssc && rssc->rssc_ri && reh);
 
-    /* Check the log header
-     */
-    int rc = raft_server_header_load(ri);
+    struct raft_instance *ri = rssc->rssc_ri;
+    const raft_entry_idx_t i = rssc->rssc_next;
+
+    int rc = read_server_entry_validate(ri, reh, i);
+
+    DBG_RAFT_ENTRY(LL_DEBUG, reh, "i=%lx rc=%d", i, rc);
     if (rc)
     {
-        DBG_RAFT_INSTANCE(LL_ERROR, ri, "raft_server_header_load():  %s",
-                          strerror(-rc));
+        DBG_RAFT_ENTRY(LL_WARN, reh, "read_server_entry_validate():  %s",
+                       strerror(-rc));
         return rc;
     }
 
-    rc = raft_server_entries_scan(ri);
+    /* Skip the validity check on the first iteration when starting_entry
+     * is set.
+     */
+    else if (rssc->rssc_start && i > rssc->rssc_start &&
+             !raft_server_entry_next_entry_is_valid(ri, reh))
+    {
+        DBG_RAFT_ENTRY(LL_WARN, reh,
+                       "raft_server_entry_next_entry_is_valid() false");
+        return -EINVAL;
+    }
+
+    if (rssc->rssc_crc)
+        raft_server_scan_crc_enqueue(rssc->rssc_crc, reh, data);
+
+    /* During startup, sync and unsynced should be equivalent since all
+     * found entries are considered to be synced and 'synced' status for
+     * a raft instance occurs when the unsynced-idx == synced-idx.
+     */
+    raft_instance_update_newest_entry_hdr(ri, reh, RI_NEHDR_ALL, false);
+
+    rssc->rssc_next++;
+
+    return 0;
+}
+
+/**
+ * raft_server_entries_scan_by_index - scan for backends which do not provide
+ *    rib_entry_scan().  Each header is obtained with its own read.
+ */
+static int
+raft_server_entries_scan_by_index(struct raft_instance *ri,
+                                  struct raft_server_scan_ctx *rssc,
+                                  const raft_entry_idx_t max)
+{
+    NIOVA_ASSERT(ri && rssc && !rssc->rssc_crc);
+
+    struct raft_entry_header reh;
+
+    for (raft_entry_idx_t i = rssc->rssc_start; i < max; i++)
+    {
+        int rc = raft_server_entry_header_read_by_store(ri, &reh, i);
+        if (rc)
+        {
+            DBG_RAFT_ENTRY(LL_DEBUG, &reh,
+                           "raft_server_entry_header_read_by_store():  %s",
+                           strerror(-rc));
+            return rc;
+        }
+
+        rc = raft_server_entries_scan_entry(rssc, &reh, NULL);
+        if (rc)
+            return rc;
+    }
+
+    return 0;
+}
+
+static int
+raft_server_entries_scan_internal(struct raft_instance *ri,
+                                  const raft_entry_idx_t start,
+                                  const raft_entry_idx_t max)
+{
+    struct raft_server_scan_ctx rssc = {
+        .rssc_ri = ri,
+        .rssc_start = start,
+        .rssc_next = start,
+    };
+
+    if (!ri->ri_backend->rib_entry_scan)
+    {
+        if (ri->ri_startup_scan_crc_threads)
+            DBG_RAFT_INSTANCE(LL_WARN, ri,
+                              "backend cannot scan, entry crcs not verified");
+
+        return raft_server_entries_scan_by_index(ri, &rssc, max);
+    }
+
+    int rc = raft_server_scan_crc_start(ri, &rssc.rssc_crc);
+    if (rc)
+    {
+        DBG_RAFT_INSTANCE(LL_ERROR, ri, "raft_server_scan_crc_start(): %s",
+                          strerror(-rc));
+        return rc;
+    }
+
+    rc = ri->ri_backend->rib_entry_scan(ri, start, max,
+                                        rssc.rssc_crc ? true : false,
+                                        raft_server_entries_scan_entry,
+                                        &rssc);
+    if (rc)
+    {
+        DBG_RAFT_INSTANCE(LL_ERROR, ri, "rib_entry_scan(%ld, %ld): %s",
+                          start, max, strerror(-rc));
+    }
+    else if (rssc.rssc_next != max)
+    {
+        DBG_RAFT_INSTANCE(LL_ERROR, ri,
+                          "rib_entry_scan(%ld, %ld) ended at idx=%ld",
+                          start, max, rssc.rssc_next);
+        rc = -ENOENT;
+    }
+
+    if (rssc.rssc_crc)
+    {
+        int crc_rc = raft_server_scan_crc_finish(ri, rssc.rssc_crc);
+        if (!rc)
+            rc = crc_rc;
+    }
+
+    return rc;
+}
+
+/**
+ * raft_server_entries_scan - reads through the non-header log entries to the
+ *    log's end with the purpose of finding the latest valid entry and
+ *    performing a cursory verification of the header entries.  Note that this
+ *    scan may be "fast-forwarded" if the store type is of
+ *    RAFT_INSTANCE_STORE_ROCKSDB_PERSISTENT_APP.  In this case, the scan will
+ *    still check the initial set of header entries.
+ */
+static int
+raft_server_entries_scan(struct raft_instance *ri)
+{
+    NIOVA_ASSERT(ri);
+
+    const raft_entry_idx_t entry_max_idx = ri->ri_entries_detected_at_startup;
+    if (!entry_max_idx)
+        return 0;
+
+    else if (entry_max_idx < 0)
+        return (int)entry_max_idx;
+
+    const raft_entry_idx_t lowest_idx = niova_atomic_read(&ri->ri_lowest_idx);
+
+    raft_entry_idx_t starting_entry = MAX(0, lowest_idx);
+
+    // Try to raise the starting_entry if conditions allow
+    if (ri->ri_store_type == RAFT_INSTANCE_STORE_ROCKSDB_PERSISTENT_APP &&
+        ri->ri_max_scan_entries > 0 &&
+        entry_max_idx > ri->ri_max_scan_entries)
+        starting_entry = MAX(lowest_idx,
+                             entry_max_idx - ri->ri_max_scan_entries);
+
+    /* Ensure the start of the key space is intact since it may not be
+     * otherwise checked due to ri_max_scan_entries.
+     */
+    if (starting_entry > 0)
+    {
+#define LOG_INITIAL_SCAN_SZ 1000L
+        int rc = raft_server_entries_scan_internal(
+            ri, lowest_idx,
+            MIN((lowest_idx + LOG_INITIAL_SCAN_SZ), entry_max_idx));
+        if (rc)
+            return rc;
+
+        // Reinit
+        raft_instance_initialize_newest_entry_hdr(ri);
+    }
+
+    return raft_server_entries_scan_internal(ri, starting_entry,
+                                             entry_max_idx);
+}
+
+/**
+ * raft_server_log_truncate - prune the log to the point after which the last
+ *    "valid" entry has been found.  The contents of ri_newest_entry_hdr
+ *    determine index of the last valid entry.  Note that this function will
+ *    abort if there is an I/O error.
+ */
+static void //raft_server_udp_cb_ctx_int_t
+raft_server_log_truncate(struct raft_instance *ri)
+{
+    NIOVA_ASSERT(ri);
+
+    const raft_entry_idx_t trunc_entry_idx =
+        raft_server_get_current_raft_entry_index(ri, RI_NEHDR_SYNC) + 1;
+
+    NIOVA_ASSERT(trunc_entry_idx >= 0);
+
+    ri->ri_backend->rib_log_truncate(ri, trunc_entry_idx);
+
+    DBG_RAFT_INSTANCE_TAG(LL_NOTIFY, "log-rollback", ri, "new-max-raft-idx=%ld",
+                          trunc_entry_idx);
+}
+
+/**
+ * raft_server_log_load - read in the header blocks and scan the entry blocks
+ *    to find the latest entry, checking for validity along the way.  After
+ *    scanning the log entries, one by one, raft_server_log_load() will
+ *    truncate any log space which may exist beyond highest validated log
+ *    block.  raft_server_log_load() ensures that ri->ri_newest_entry_hdr
+ *    contains the last written, valid block header.
+ */
+static int
+raft_server_log_load(struct raft_instance *ri)
+{
+    NIOVA_ASSERT(ri);
+
+    /* Check the log header
+     */
+    int rc = raft_server_header_load(ri);
     if (rc)
     {
-        DBG_RAFT_INSTANCE(LL_ERROR, ri, "raft_server_entries_scan():  %s",
+        DBG_RAFT_INSTANCE(LL_ERROR, ri, "raft_server_header_load():  %s",
                           strerror(-rc));
         return rc;
     }
 
+    struct timespec ts[2];
+    clock_gettime(CLOCK_MONOTONIC, &ts[0]);
+
+    rc = raft_server_entries_scan(ri);
+
+    clock_gettime(CLOCK_MONOTONIC, &ts[1]);
+    timespecsub(&ts[1], &ts[0], &ts[1]);
+
+    ri->ri_startup_scan_usec =
+        (ts[1].tv_sec * 1000000ULL) + (ts[1].tv_nsec / 1000);
+
+    DBG_RAFT_INSTANCE((rc ? LL_ERROR : LL_WARN), ri,
+                      "raft_server_entries_scan():  %s (usec=%llu)",
+                      strerror(-rc), ri->ri_startup_scan_usec);
+    if (rc)
+        return rc;
+
     raft_server_log_truncate(ri);
 
     return 0;
@@ -1660,12 +3501,6 @@ raft_election_timeout_set(const struct raft_instance *ri, struct timespec *ts)
     msec_2_timespec(ts, msec);
 }
 
-static unsigned long long
-raft_leader_wakeup_freq_msec(void)
-{
-    return RAFT_LEADER_WAKEUP_MS;
-}
-
 static unsigned long long
 raft_heartbeat_timeout_msec(const struct raft_instance *ri)
 {
@@ -1687,4288 +3522,7771 @@ raft_heartbeat_timeout_set(const struct raft_instance *ri, struct timespec *ts)
 }
 #endif
 
+static unsigned long long
+raft_leader_timer_period_msec(const enum raft_leader_timer_type type)
+{
+    switch (type)
+    {
+    case RAFT_LEADER_TIMER_HEARTBEAT:
+        return RAFT_SERVER_HEARTBEAT_ISSUE_FACTOR * RAFT_LEADER_WAKEUP_MS;
+    case RAFT_LEADER_TIMER_QUORUM:
+        return RAFT_SERVER_QUORUM_CHECK_FACTOR * RAFT_LEADER_WAKEUP_MS;
+    default:
+        break;
+    }
+
+    return 0; // not periodic
+}
+
+static bool
+raft_leader_timer_before(const struct raft_leader_state *rls,
+                         const unsigned int a, const unsigned int b)
+{
+    return timespeccmp(&rls->rls_timers[a].rlt_deadline,
+                       &rls->rls_timers[b].rlt_deadline, <) ? true : false;
+}
+
 static void
-raft_leader_timeout_set(struct timespec *ts)
+raft_leader_timer_swap(struct raft_leader_state *rls, const unsigned int a,
+                       const unsigned int b)
 {
-    msec_2_timespec(ts, raft_leader_wakeup_freq_msec());
+    struct raft_leader_timer tmp = rls->rls_timers[a];
+
+    rls->rls_timers[a] = rls->rls_timers[b];
+    rls->rls_timers[b] = tmp;
 }
 
 /**
- * raft_server_timerfd_settime - set the timerfd based on the state of the
- *    raft instance.
+ * raft_leader_timer_sift - restore the heap order after the deadline at
+ *    'pos' was added or changed.
  */
 static void
-raft_server_timerfd_settime(struct raft_instance *ri)
+raft_leader_timer_sift(struct raft_leader_state *rls, unsigned int pos)
 {
-    struct itimerspec its = {0};
+    NIOVA_ASSERT(pos < rls->rls_ntimers);
 
-    if (ri->ri_state == RAFT_STATE_LEADER)
-    {
-        raft_leader_timeout_set(&its.it_value);
-        its.it_interval = its.it_value;
-    }
-    else
+    for (; pos && raft_leader_timer_before(rls, pos, (pos - 1) / 2);
+         pos = (pos - 1) / 2)
+        raft_leader_timer_swap(rls, pos, (pos - 1) / 2);
+
+    for (;;)
     {
-        raft_election_timeout_set(ri, &its.it_value);
-    }
+        unsigned int min = pos;
+        const unsigned int child = pos * 2 + 1;
 
-    DBG_RAFT_INSTANCE(LL_DEBUG, ri, "msec=%llu",
-                      timespec_2_msec(&its.it_value));
+        for (unsigned int i = child; i <= child + 1; i++)
+            if (i < rls->rls_ntimers && raft_leader_timer_before(rls, i, min))
+                min = i;
 
-    int rc = timerfd_settime(ri->ri_timer_fd, 0, &its, NULL);
-    if (rc)
-    {
-        rc = -errno;
-        DBG_RAFT_INSTANCE(LL_FATAL, ri, "timerfd_settime(): %s",
-                          strerror(-rc));
+        if (min == pos)
+            break;
+
+        raft_leader_timer_swap(rls, pos, min);
+        pos = min;
     }
 }
 
+/**
+ * raft_leader_timer_find - returns the heap position of the 'type' deadline
+ *    or -ENOENT.  The heap holds at most one deadline of each type so it is
+ *    simply scanned.
+ */
 static int
-raft_server_send_msg_to_client(struct raft_instance *ri,
-                               struct raft_net_client_request_handle *rncr,
-                               struct ctl_svc_node *csn)
+raft_leader_timer_find(const struct raft_leader_state *rls,
+                       const enum raft_leader_timer_type type)
 {
-    NIOVA_ASSERT(ri && rncr);
+    for (unsigned int i = 0; i < rls->rls_ntimers; i++)
+        if (rls->rls_timers[i].rlt_type == type)
+            return i;
 
-    if (!ri || !rncr || !rncr->rncr_reply.rncr_reply_ptr)
-        return -EINVAL;
+    return -ENOENT;
+}
 
-    struct raft_client_rpc_msg *reply = rncr->rncr_reply.rncr_reply_ptr;
-    const ssize_t msg_size = (sizeof(struct raft_client_rpc_msg) +
-                              reply->rcrm_data_size);
-    struct iovec iov[1] = {
-        [0].iov_len = msg_size,
-        [0].iov_base = reply,
-    };
+static void
+raft_leader_timer_cancel(struct raft_instance *ri,
+                         const enum raft_leader_timer_type type)
+{
+    struct raft_leader_state *rls = &ri->ri_leader;
 
-    if (csn)
-        return raft_net_send_msg(ri, csn, iov, 1, RAFT_UDP_LISTEN_CLIENT);
-    else
-        return raft_net_send_msg_to_uuid(ri, rncr->rncr_client_uuid, iov, 1,
-                                         RAFT_UDP_LISTEN_CLIENT);
+    const int pos = raft_leader_timer_find(rls, type);
+    if (pos < 0)
+        return;
+
+    rls->rls_timers[pos] = rls->rls_timers[--rls->rls_ntimers];
+
+    if (pos < rls->rls_ntimers)
+        raft_leader_timer_sift(rls, pos);
 }
 
-static int
-raft_server_send_msg(struct raft_instance *ri,
-                     const enum raft_udp_listen_sockets sock_src,
-                     struct ctl_svc_node *rp, const struct raft_rpc_msg *rrm)
+/**
+ * raft_leader_timer_pop_expired - removes the nearest deadline if it has
+ *    passed as of 'now'.
+ */
+static bool
+raft_leader_timer_pop_expired(struct raft_instance *ri,
+                              const struct timespec *now,
+                              enum raft_leader_timer_type *ret_type)
 {
-    DBG_RAFT_MSG(LL_NOTIFY, rrm, "");
-
-    if (rp->csn_type == CTL_SVC_NODE_TYPE_RAFT_PEER)
-        NIOVA_ASSERT(sock_src == RAFT_UDP_LISTEN_SERVER);
-    else
-        NIOVA_ASSERT(sock_src == RAFT_UDP_LISTEN_CLIENT);
+    struct raft_leader_state *rls = &ri->ri_leader;
 
-    size_t msg_size = sizeof(struct raft_rpc_msg);
-    if (rrm->rrm_type == RAFT_RPC_MSG_TYPE_APPEND_ENTRIES_REQUEST)
-        msg_size += rrm->rrm_append_entries_request.raerqm_entries_sz;
+    if (!rls->rls_ntimers ||
+        timespeccmp(&rls->rls_timers[0].rlt_deadline, now, >))
+        return false;
 
-    struct iovec iov = {
-        .iov_len = msg_size,
-        .iov_base = (void *)rrm
-    };
+    *ret_type = rls->rls_timers[0].rlt_type;
+    raft_leader_timer_cancel(ri, *ret_type);
 
-    return raft_net_send_msg(ri, rp, &iov, 1, sock_src);
+    return true;
 }
 
+/**
+ * raft_server_leader_timerfd_settime - arm the timerfd for the nearest of
+ *    the leader's deadlines.  Unless 'force' is set, the timerfd is only
+ *    rearmed when the nearest deadline precedes the one already armed.  An
+ *    early wakeup finds nothing expired and rearms.
+ */
 static void
-raft_server_broadcast_msg(struct raft_instance *ri,
-                          const struct raft_rpc_msg *rrm)
+raft_server_leader_timerfd_settime(struct raft_instance *ri, const bool force)
 {
-    const raft_peer_t num_peers = raft_num_members_validate_and_get(ri);
+    struct raft_leader_state *rls = &ri->ri_leader;
 
-    for (int i = 0; i < num_peers; i++)
-    {
-        struct ctl_svc_node *rp = ri->ri_csn_raft_peers[i];
+    NIOVA_ASSERT(rls->rls_ntimers);
 
-        if (rp == ri->ri_csn_this_peer)
-            continue;
+    const struct timespec *deadline = &rls->rls_timers[0].rlt_deadline;
 
-        int rc = raft_server_send_msg(ri, RAFT_UDP_LISTEN_SERVER, rp, rrm);
-        SIMPLE_LOG_MSG((rc ? LL_NOTIFY : LL_TRACE),
-                       "raft_server_send_msg(): %d", rc);
-    }
-}
+    if (!force && timespec_has_value(&rls->rls_timerfd_deadline) &&
+        timespeccmp(&rls->rls_timerfd_deadline, deadline, <=))
+        return;
 
-static raft_peer_t
-raft_server_candidate_count_votes(struct raft_instance *ri,
-                                  enum raft_vote_result result)
-{
-    NIOVA_ASSERT(ri && ri->ri_csn_raft);
-    raft_peer_t cnt = 0;
+    struct itimerspec its = {0};
+    struct timespec now;
+    niova_unstable_clock(&now);
 
-    const raft_peer_t npeers = raft_num_members_validate_and_get(ri);
+    if (timespeccmp(deadline, &now, >))
+        timespecsub(deadline, &now, &its.it_value);
+    else
+        its.it_value.tv_nsec = 1; // a zero value would disarm the timerfd
 
-    for (raft_peer_t i = 0; i < npeers; i++)
-        if (ri->ri_candidate.rcs_results[i] == result)
-            cnt++;
+    rls->rls_timerfd_deadline = *deadline;
 
-    return cnt;
+    DBG_RAFT_INSTANCE(LL_DEBUG, ri, "type=%d usec=%llu",
+                      rls->rls_timers[0].rlt_type,
+                      timespec_2_nsec(&its.it_value) / 1000);
+
+    int rc = timerfd_settime(ri->ri_timer_fd, 0, &its, NULL);
+    if (rc)
+    {
+        rc = -errno;
+        DBG_RAFT_INSTANCE(LL_FATAL, ri, "timerfd_settime(): %s",
+                          strerror(-rc));
+    }
 }
 
 /**
- * raft_server_init_candidate_state - initialize the raft instance for
- *    either candidate state (prevote or real vote).
+ * raft_leader_timer_arm - set the 'type' deadline, replacing any which is
+ *    already pending.  The caller rearms the timerfd.
  */
-static raft_net_timerfd_cb_ctx_t
-raft_server_init_candidate_state(struct raft_instance *ri, bool prevote)
+static void
+raft_leader_timer_arm(struct raft_instance *ri,
+                      const enum raft_leader_timer_type type,
+                      const struct timespec *deadline)
 {
-    NIOVA_ASSERT(ri);
+    NIOVA_ASSERT(type < RAFT_LEADER_TIMER_MAX);
 
-    ri->ri_state = prevote ?
-        RAFT_STATE_CANDIDATE_PREVOTE : RAFT_STATE_CANDIDATE;
+    struct raft_leader_state *rls = &ri->ri_leader;
 
-    struct raft_candidate_state *rcs = &ri->ri_candidate;
+    int pos = raft_leader_timer_find(rls, type);
+    if (pos < 0)
+    {
+        NIOVA_ASSERT(rls->rls_ntimers < RAFT_LEADER_TIMER_MAX);
 
-    rcs->rcs_prevote = prevote;
-    rcs->rcs_term = ri->ri_log_hdr.rlh_term + 1;
+        pos = rls->rls_ntimers++;
+        rls->rls_timers[pos].rlt_type = type;
+    }
 
-    for (raft_peer_t i = 0; i < CTL_SVC_MAX_RAFT_PEERS; i++)
-        rcs->rcs_results[i] = RAFT_VOTE_RESULT_UNKNOWN;
+    rls->rls_timers[pos].rlt_deadline = *deadline;
+    raft_leader_timer_sift(rls, pos);
 }
 
-static bool
-raft_server_candidate_is_viable(struct raft_instance *ri)
+/**
+ * raft_leader_timer_arm_periodic - arm a periodic deadline one period past
+ *    'now'.  Unless 'reset' is set, a deadline already pending is kept.
+ */
+static void
+raft_leader_timer_arm_periodic(struct raft_instance *ri,
+                               const enum raft_leader_timer_type type,
+                               const struct timespec *now, const bool reset)
 {
-    if (ri)
+    const unsigned long long msec = raft_leader_timer_period_msec(type);
+    NIOVA_ASSERT(msec);
+
+    if (!reset && raft_leader_timer_find(&ri->ri_leader, type) >= 0)
+        return;
+
+    struct timespec deadline;
+    msec_2_timespec(&deadline, msec);
+    timespecadd(&deadline, now, &deadline);
+
+    /* Hosted groups place their heartbeats on a common grid so that the
+     * host may send those bound for the same peer in one datagram.
+     */
+    if (ri->ri_hosted && type == RAFT_LEADER_TIMER_HEARTBEAT)
     {
-        if ((raft_instance_is_candidate(ri) &&
-             ri->ri_candidate.rcs_term == ri->ri_log_hdr.rlh_term) ||
-            (raft_instance_is_candidate_prevote(ri) &&
-             ri->ri_candidate.rcs_term == (ri->ri_log_hdr.rlh_term + 1)))
-            return true;
+        const unsigned long long ms = timespec_2_msec(&deadline);
 
-        DBG_RAFT_INSTANCE(LL_ERROR, ri,
-                          "!candidate OR candidate-term (%ld) != ht",
-                          ri->ri_candidate.rcs_term);
+        msec_2_timespec(&deadline, ms - (ms % msec));
     }
-    return false;
+
+    raft_leader_timer_arm(ri, type, &deadline);
 }
 
-static bool
-raft_server_candidate_can_become_leader(struct raft_instance *ri)
+/**
+ * raft_server_timerfd_settime - set the timerfd based on the state of the
+ *    raft instance.  The leader arms its periodic deadlines if they are not
+ *    already pending.
+ */
+static void
+raft_server_timerfd_settime(struct raft_instance *ri)
 {
-    NIOVA_ASSERT(ri);
+    if (ri->ri_state == RAFT_STATE_LEADER)
+    {
+        struct timespec now;
+        niova_unstable_clock(&now);
 
-    // Perform some sanity checks prior to counting the 'yes' votes.
-    if (!raft_server_candidate_is_viable(ri))
-        return false;
+        raft_leader_timer_arm_periodic(ri, RAFT_LEADER_TIMER_HEARTBEAT, &now,
+                                       false);
+        raft_leader_timer_arm_periodic(ri, RAFT_LEADER_TIMER_QUORUM, &now,
+                                       false);
 
-    const raft_peer_t num_yes_votes =
-        raft_server_candidate_count_votes(ri, RAFT_VOTE_RESULT_YES);
+        return raft_server_leader_timerfd_settime(ri, true);
+    }
 
-    const raft_peer_t npeers_majority =
-        (ctl_svc_node_raft_2_num_members(ri->ri_csn_raft) / 2) + 1;
+    struct itimerspec its = {0};
 
-    return num_yes_votes >= npeers_majority ? true : false;
+    raft_election_timeout_set(ri, &its.it_value);
+
+    DBG_RAFT_INSTANCE(LL_DEBUG, ri, "msec=%llu",
+                      timespec_2_msec(&its.it_value));
+
+    int rc = timerfd_settime(ri->ri_timer_fd, 0, &its, NULL);
+    if (rc)
+    {
+        rc = -errno;
+        DBG_RAFT_INSTANCE(LL_FATAL, ri, "timerfd_settime(): %s",
+                          strerror(-rc));
+    }
 }
 
-static bool
-raft_server_prevote_candidate_can_become_candidate(struct raft_instance *ri)
+static int
+raft_server_send_msg_to_client(struct raft_instance *ri,
+                               struct raft_net_client_request_handle *rncr,
+                               struct ctl_svc_node *csn)
 {
-    NIOVA_ASSERT(ri);
+    NIOVA_ASSERT(ri && rncr);
 
-    // Perform some sanity checks prior to counting the 'yes' votes.
-    if (!raft_server_candidate_is_viable(ri))
-        return false;
+    if (!ri || !rncr || !rncr->rncr_reply.rncr_reply_ptr)
+        return -EINVAL;
 
-    const raft_peer_t num_yes_votes =
-        raft_server_candidate_count_votes(ri, RAFT_PRE_VOTE_RESULT_YES);
+    struct raft_client_rpc_msg *reply = rncr->rncr_reply.rncr_reply_ptr;
+    const ssize_t msg_size = (sizeof(struct raft_client_rpc_msg) +
+                              reply->rcrm_data_size);
+    struct iovec iov[1] = {
+        [0].iov_len = msg_size,
+        [0].iov_base = reply,
+    };
 
-    const raft_peer_t npeers_majority =
-        (ctl_svc_node_raft_2_num_members(ri->ri_csn_raft) / 2) + 1;
+    if (csn)
+        return raft_net_send_msg(ri, csn, iov, 1, RAFT_UDP_LISTEN_CLIENT);
+    else
+        return raft_net_send_msg_to_uuid(ri, rncr->rncr_client_uuid, iov, 1,
+                                         RAFT_UDP_LISTEN_CLIENT);
+}
 
-    return num_yes_votes >= npeers_majority ? true : false;
+static size_t
+raft_server_rpc_msg_size(const struct raft_rpc_msg *rrm)
+{
+    size_t msg_size = sizeof(struct raft_rpc_msg);
+    if (rrm->rrm_type == RAFT_RPC_MSG_TYPE_APPEND_ENTRIES_REQUEST)
+        msg_size += rrm->rrm_append_entries_request.raerqm_entries_sz;
+
+    return msg_size;
 }
 
 /**
- * raft_server_candidate_reg_vote_result - called when this raft instance is a
- *     candidate and a vote reply needs to be registered in the local table.
+ * raft_server_rpc_msg_iovs_get - fills 'iov' with either the version 0 form
+ *    of 'rrm' or, if the peer has advertised support for it, with the
+ *    compact form encoded into 'wire' followed by any AE payload.  The
+ *    compact form is only used for msgs which would otherwise fit into a
+ *    single UDP datagram since msgs sent over TCP must remain version 0.
+ *    Returns the number of iovs used.
  */
-static int
-raft_server_candidate_reg_vote_result(struct raft_instance *ri,
-                                      uuid_t voter,
-                                      enum raft_vote_result result)
+static size_t
+raft_server_rpc_msg_iovs_get(const struct raft_instance *ri,
+                             const struct ctl_svc_node *rp,
+                             const struct raft_rpc_msg *rrm, char *wire,
+                             struct iovec iov[2])
 {
-    if (!ri || result == RAFT_VOTE_RESULT_UNKNOWN)
-        return -EINVAL;
-
-    else if (!(raft_instance_is_candidate_prevote(ri) ||
-               raft_instance_is_candidate(ri)))
-        return -EPERM;
+    const size_t msg_size = raft_server_rpc_msg_size(rrm);
 
-    const bool prevote = raft_instance_is_candidate_prevote(ri);
-    if ((prevote && (result != RAFT_PRE_VOTE_RESULT_YES &&
-                     result != RAFT_PRE_VOTE_RESULT_NO)) ||
-        (!prevote && (result != RAFT_VOTE_RESULT_YES &&
-                      result != RAFT_VOTE_RESULT_NO)))
-        return -EINVAL;
+    iov[0].iov_base = (void *)rrm;
+    iov[0].iov_len = msg_size;
 
-    raft_peer_t peer_idx = raft_peer_2_idx(ri, voter);
+    if (!wire || rp->csn_type != CTL_SVC_NODE_TYPE_RAFT_PEER ||
+        ri->ri_rpc_msg_version_max < RAFT_RPC_MSG_VERSION_COMPACT ||
+        msg_size > udp_get_max_size())
+        return 1;
 
-    if (peer_idx >= ctl_svc_node_raft_2_num_members(ri->ri_csn_raft))
-        return -ERANGE;
+    const raft_peer_t idx = raft_peer_2_idx(ri, rp->csn_uuid);
+    if (idx >= CTL_SVC_MAX_RAFT_PEERS ||
+        ri->ri_peer_msg_version[idx] < RAFT_RPC_MSG_VERSION_COMPACT)
+        return 1;
 
-    struct raft_candidate_state *rcs = &ri->ri_candidate;
+    ssize_t hdr_size =
+        raft_net_rpc_msg_compact_encode(rrm, wire,
+                                        RAFT_RPC_MSG_COMPACT_HDR_MAX);
+    if (hdr_size < 0)
+    {
+        DBG_RAFT_MSG(LL_NOTIFY, rrm, "raft_net_rpc_msg_compact_encode(): %s",
+                     strerror(-hdr_size));
+        return 1;
+    }
 
-    // Prevote mode does not increment rlh_term
-    int64_t expected_term = ri->ri_log_hdr.rlh_term + (prevote ? 1 : 0);
+    iov[0].iov_base = wire;
+    iov[0].iov_len = hdr_size;
 
-    // Internal instance sanity check
-    DBG_RAFT_INSTANCE_FATAL_IF((rcs->rcs_term != expected_term), ri,
-                               "rcs->rcs_term (%ld) != expected-term (%ld)",
-                               rcs->rcs_term, expected_term);
+    if (msg_size == sizeof(struct raft_rpc_msg))
+        return 1;
 
-    rcs->rcs_results[peer_idx] = result;
+    iov[1].iov_base =
+        (void *)rrm->rrm_append_entries_request.raerqm_entries;
+    iov[1].iov_len = msg_size - sizeof(struct raft_rpc_msg);
 
-    DBG_RAFT_INSTANCE(LL_NOTIFY, ri, "peer-idx=%hhu voted=%s (prevote=%s)",
-                      peer_idx,
-                      (result == RAFT_VOTE_RESULT_YES ||
-                       result == RAFT_PRE_VOTE_RESULT_YES) ? "yes" : "no",
-                      prevote ? "yes" : "no");
+    return 2;
+}
 
-    return 0;
+static enum raft_net_lane
+raft_server_rpc_msg_lane(const struct raft_rpc_msg *rrm)
+{
+    return (rrm->rrm_type == RAFT_RPC_MSG_TYPE_APPEND_ENTRIES_REQUEST &&
+            rrm->rrm_append_entries_request.raerqm_entries_sz) ?
+        RAFT_NET_LANE_BULK : RAFT_NET_LANE_CTL;
 }
 
-static raft_server_timerfd_cb_ctx_int_t
-raft_server_vote_for_self(struct raft_instance *ri)
+static unsigned long long
+raft_server_usec_since(const struct timespec *start)
 {
-    if (!ri)
-        return -EINVAL;
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    timespecsub(&ts, start, &ts);
 
-    else if (!(raft_instance_is_candidate_prevote(ri) ||
-               raft_instance_is_candidate(ri)))
-        return -EPERM;
+    return (ts.tv_sec * 1000000ULL) + (ts.tv_nsec / 1000);
+}
 
-    enum raft_vote_result yes_vote = RAFT_PRE_VOTE_RESULT_YES;
+/**
+ * raft_server_lane_stats_update - records the result of a send on 'lane'.
+ *    Latency is only sampled when 'start' is provided.  The bulk lane's
+ *    stats are shared with the send queue threads and must be modified under
+ *    rbl_mutex, the caller takes it as needed.
+ */
+static void
+raft_server_lane_stats_update(struct raft_instance *ri,
+                              const enum raft_net_lane lane, const int rc,
+                              const struct timespec *start)
+{
+    struct raft_net_lane_stats *rnls = &ri->ri_lane_stats[lane];
 
-    if (raft_instance_is_candidate(ri))
+    if (rc)
     {
-        // Full-fledged candidate persists its term change
-        int rc =
-            raft_server_log_header_write(ri, RAFT_INSTANCE_2_SELF_UUID(ri),
-                                         ri->ri_log_hdr.rlh_term + 1);
-        if (rc)
-            return rc;
-
-        yes_vote = RAFT_VOTE_RESULT_YES;
+        rnls->rnls_nerrs++;
+        return;
     }
 
-    int rc = raft_server_candidate_reg_vote_result(ri,
-                                                 RAFT_INSTANCE_2_SELF_UUID(ri),
-                                                 yes_vote);
-    if (FAULT_INJECT(raft_pvc_becomes_candidate))
+    rnls->rnls_nmsgs++;
+
+    if (start)
     {
-        /* Force the prevote candidate to go into candidate state */
-        raft_server_become_candidate(ri, false);
-        return 0;
+        const unsigned long long lat_usec = raft_server_usec_since(start);
+
+        rnls->rnls_nlat++;
+        rnls->rnls_lat_usec_total += lat_usec;
+        if (lat_usec > rnls->rnls_lat_usec_max)
+            rnls->rnls_lat_usec_max = lat_usec;
     }
-    return rc;
 }
 
-static void
-raft_server_set_uuids_in_rpc_msg(const struct raft_instance *ri,
-                                 struct raft_rpc_msg *rrm)
+/**
+ * raft_server_peer_sendq_msg_depth - the number of msgs on the follower's
+ *    send queue, less the chkpt xfer requests which do not hold up AEs.  The
+ *    caller holds rpsq_mutex.
+ */
+static size_t
+raft_server_peer_sendq_msg_depth(const struct raft_peer_send_queue *rpsq)
 {
-    if (ri && rrm)
-    {
-        uuid_copy(rrm->rrm_sender_id, RAFT_INSTANCE_2_SELF_UUID(ri));
-        uuid_copy(rrm->rrm_raft_id, RAFT_INSTANCE_2_RAFT_UUID(ri));
-        uuid_copy(rrm->rrm_db_id, ri->ri_db_uuid);
-    }
+    return rpsq->rpsq_depth - rpsq->rpsq_nchkpt_xfer;
+}
+
+static struct raft_peer_send_queue *
+raft_server_peer_sendq_get(struct raft_instance *ri, const raft_peer_t peer)
+{
+    struct raft_bulk_lane *rbl = &ri->ri_bulk_lane;
+
+    if (!rbl->rbl_running || peer >= CTL_SVC_MAX_RAFT_PEERS ||
+        !rbl->rbl_peer_sendq[peer].rpsq_running)
+        return NULL;
+
+    return &rbl->rbl_peer_sendq[peer];
 }
 
 /**
- * raft_server_become_candidate - called when the raft instance is either in
- *    follower or candidate mode and the leader has not provided a heartbeat
- *    within the timeout threshold.
+ * raft_server_peer_sendq_is_full - backpressure signal for the AE sender.
+ *    Returns true, and counts the skip, when the follower's send queue cannot
+ *    take another msg.
  */
-static raft_net_timerfd_cb_ctx_t // or raft_server_net_cb_ctx_t (!prevote)
-raft_server_become_candidate(struct raft_instance *ri, bool prevote)
+static bool
+raft_server_peer_sendq_is_full(struct raft_instance *ri,
+                               const raft_peer_t peer)
 {
-    NIOVA_ASSERT(ri && ri->ri_csn_this_peer);
+    struct raft_peer_send_queue *rpsq = raft_server_peer_sendq_get(ri, peer);
+    if (!rpsq)
+        return false;
 
-    ri->ri_csn_leader = NULL;
+    niova_mutex_lock(&rpsq->rpsq_mutex);
 
-    // Promotion to full-fledged candidate may only come from pre-vote state
-    if (!prevote)
-        NIOVA_ASSERT(raft_instance_is_candidate_prevote(ri));
+    const bool full =
+        raft_server_peer_sendq_msg_depth(rpsq) >= ri->ri_bulk_lane_depth;
+    if (full)
+        rpsq->rpsq_nfull++;
 
-    if (FAULT_INJECT(raft_candidate_state_disabled))
-        return;
+    niova_mutex_unlock(&rpsq->rpsq_mutex);
 
-    // Reset vote counters and mark self as in 'preVote' state
-    raft_server_init_candidate_state(ri, prevote);
+    return full;
+}
 
-    const int64_t proposed_term = ri->ri_log_hdr.rlh_term + 1;
+/**
+ * raft_server_ae_compress_type - selects the codec for a TCP bound AE
+ *    request.  The follower must advertise the compress version and, if its
+ *    TCP handshake announced its codecs, the configured codec.
+ */
+static enum raft_ae_compress_type
+raft_server_ae_compress_type(const struct raft_instance *ri,
+                             const raft_peer_t peer,
+                             const struct raft_rpc_msg *rrm)
+{
+    const enum raft_ae_compress_type type = ri->ri_ae_compress_type;
 
-    // sync's new term if !preVote state
-    int rc = raft_server_vote_for_self(ri);
+    if (type == RAFT_AE_COMPRESS_NONE ||
+        ri->ri_rpc_msg_version_max < RAFT_RPC_MSG_VERSION_COMPRESS ||
+        ri->ri_peer_msg_version[peer] < RAFT_RPC_MSG_VERSION_COMPRESS ||
+        (rrm->rrm_append_entries_request.raerqm_entries_sz <
+         ri->ri_ae_compress_min_size))
+        return RAFT_AE_COMPRESS_NONE;
 
-    if (rc) // Failed to sync our own log header!
-        DBG_RAFT_INSTANCE(LL_FATAL, ri, "raft_server_log_header_write(): %s",
-                          strerror(-rc));
+    const uint32_t codecs = ri->ri_peer_codecs[peer];
 
-    // Get the latest entry header following the self-vote
-    struct raft_entry_header sync_hdr = {0};
-    raft_instance_get_newest_header(ri, &sync_hdr, RI_NEHDR_SYNC);
-
-    const enum raft_rpc_msg_type type =
-        prevote ?
-        RAFT_RPC_MSG_TYPE_PRE_VOTE_REQUEST : RAFT_RPC_MSG_TYPE_VOTE_REQUEST;
-
-    struct raft_rpc_msg rrm = {
-        //.rrm_rrm_sender_id = ri->ri_csn_this_peer.csn_uuid,
-        .rrm_type = type,
-        .rrm_version = 0,
-        .rrm_vote_request.rvrqm_proposed_term = proposed_term,
-        .rrm_vote_request.rvrqm_last_log_term = sync_hdr.reh_term,
-        .rrm_vote_request.rvrqm_last_log_index = sync_hdr.reh_index,
-    };
+    return (!codecs || (codecs & RAFT_AE_COMPRESS_MASK(type))) ?
+        type : RAFT_AE_COMPRESS_NONE;
+}
 
-    raft_server_set_uuids_in_rpc_msg(ri, &rrm);
+/**
+ * raft_server_peer_sendq_enqueue - copies a TCP bound msg, or a chkpt xfer
+ *    request to be served by the sender thread, onto the follower's send
+ *    queue.  Compression, if any, is applied by the sender thread.  The
+ *    peer's last send time is recorded here since the sender thread does not
+ *    update it.  Returns -ENOBUFS when the queue is full, raft will resend
+ *    the AE later.
+ */
+static int
+raft_server_peer_sendq_enqueue(struct raft_instance *ri,
+                               struct raft_peer_send_queue *rpsq,
+                               struct ctl_svc_node *rp,
+                               const struct iovec *iov,
+                               const enum raft_bulk_send_type type,
+                               const enum raft_ae_compress_type compress_type)
+{
+    struct raft_bulk_lane *rbl = &ri->ri_bulk_lane;
+    struct raft_net_lane_stats *rnls = &ri->ri_lane_stats[RAFT_NET_LANE_BULK];
 
-    DBG_RAFT_INSTANCE(LL_WARN, ri, "");
+    struct raft_bulk_send *rbs =
+        niova_malloc_can_fail(sizeof(struct raft_bulk_send) + iov->iov_len);
 
-    if (!prevote) // allow more time to recv votes
-        raft_server_timerfd_settime(ri);
+    // The copy is made outside of the lock which the sender thread shares
+    if (rbs)
+    {
+        memcpy(rbs->rbs_buf, iov->iov_base, iov->iov_len);
+        rbs->rbs_len = iov->iov_len;
+        rbs->rbs_type = type;
+        rbs->rbs_compress_type = compress_type;
+        rbs->rbs_csn = rp;
+        clock_gettime(CLOCK_MONOTONIC, &rbs->rbs_enqueue_time);
+    }
 
-    raft_server_broadcast_msg(ri, &rrm);
+    niova_mutex_lock(&rpsq->rpsq_mutex);
 
-    // If leader is demoted to candidate, allow applications to
-    // cleanup the leader specific state/data.
-    if (prevote && ri->ri_init_cb)
-        ri->ri_init_cb(RAFT_INIT_BECOMING_CANDIDATE_STATE);
-}
+    /* Chkpt xfer requests are bounded by the requester's window and are not
+     * resent, so they are not refused.
+     */
+    const bool full = type != RAFT_BULK_SEND_CHKPT_XFER &&
+        raft_server_peer_sendq_msg_depth(rpsq) >= ri->ri_bulk_lane_depth;
 
-static void
-raft_server_update_log_header(struct raft_instance *ri, int64_t new_term,
-                              const uuid_t peer_with_newer_term)
-{
-    NIOVA_ASSERT(new_term > ri->ri_log_hdr.rlh_term);
+    if (rbs && !full)
+    {
+        ctl_svc_node_get(rp);
 
-    int rc = raft_server_log_header_write(ri, peer_with_newer_term, new_term);
+        STAILQ_INSERT_TAIL(&rpsq->rpsq_queue, rbs, rbs_lentry);
 
-    DBG_RAFT_INSTANCE_FATAL_IF((rc), ri,
-                               "raft_server_log_header_write() %s",
-                               strerror(-rc));
-}
+        if (type == RAFT_BULK_SEND_CHKPT_XFER)
+            rpsq->rpsq_nchkpt_xfer++;
 
-static void
-raft_server_try_update_log_header_null_voted_for_peer(struct raft_instance *ri,
-                                                      int64_t new_term)
-{
-    if (ri->ri_log_hdr.rlh_term < new_term)
+        rpsq->rpsq_depth++;
+        if (rpsq->rpsq_depth > rpsq->rpsq_depth_max)
+            rpsq->rpsq_depth_max = rpsq->rpsq_depth;
+    }
+    else if (full)
     {
-        const uuid_t null_uuid = {0};
-
-        raft_server_update_log_header(ri, new_term, null_uuid);
+        rpsq->rpsq_nfull++;
     }
-}
 
-static void
-raft_server_set_leader_csn(struct raft_instance *ri,
-                           struct ctl_svc_node *leader_csn)
-{
-    NIOVA_ASSERT(ri && leader_csn);
+    niova_mutex_unlock(&rpsq->rpsq_mutex);
 
-    if (ri->ri_csn_leader != leader_csn)
+    if (rbs && !full)
     {
-        ri->ri_csn_leader = leader_csn;
-        DBG_RAFT_INSTANCE(LL_NOTIFY, ri, "csn=%p", leader_csn);
-    }
-}
-
-/**
- * raft_server_becomes_follower - handle the transition from a
- *    a follower either from candidate or leader state.  This function sets
- *    the new term and sync's it to the header.  The peer-uuid is not set
- *    in the log header unless the caller specifies it so.  This is generally
- *    only done when the caller is raft_server_process_vote_reply().
- *    Otherwise, this function is typically called when the term changes
- *    elsewhere in the cluster and this node becomes a stale leader or
- *    candidate.
- * @ri:  raft instance
- * @new_term:  the term provided by a peer
- * @peer_with_newer_term:  peer uuid which provided the higher term
- * @reason:  the reason why this instance becomes a follower
- */
-static void
-raft_server_becomes_follower(struct raft_instance *ri,
-                             int64_t new_term,
-                             const uuid_t peer_with_newer_term,
-                             enum raft_follower_reasons reason)
-{
-    NIOVA_ASSERT(ri);
+        struct raft_bulk_sender *rbsr = rpsq->rpsq_sender;
 
-    struct ctl_svc_node *suggested_leader =
-        raft_peer_uuid_to_csn(ri, peer_with_newer_term);
+        niova_mutex_lock(&rbsr->rbsr_mutex);
 
-    if (!suggested_leader || suggested_leader == ri->ri_csn_this_peer)
-        return;
+        rbsr->rbsr_nqueued++;
+        pthread_cond_signal(&rbsr->rbsr_cond);
 
-    ri->ri_state = RAFT_STATE_FOLLOWER;
-    ri->ri_follower_reason = reason;
+        niova_mutex_unlock(&rbsr->rbsr_mutex);
+    }
 
-    /* If this node demoted from leader to follower, but has some
-     * coalesced writes buffered in ri_coalesced_wr, destroy the write
-     * supplement for them.
-     */
-    if (ri->ri_coalesced_wr)
-        raft_net_sm_write_supplement_destroy(&ri->ri_coalesced_wr->rcwi_ws);
+    niova_mutex_lock(&rbl->rbl_mutex);
 
-    /* Generally, in raft we become a follower when a higher term is observed.
-     * However when 2 or more peers become candidates for the same term, the
-     * losing peer may only be notified of a successful election completion
-     * when it recv's a AE RPC.
-     *
-     * In PreVote mode, the instance will not increment its
-     * rlh_term and the 'new_term', provided by the responding peer, may be
-     * == to the rlh_term.  However, it should not be < rlh_term since this
-     * would imply that the cluster is ignoring a higher term value which has
-     * been persisted by this peer.
-     */
-    if (reason == RAFT_BFRSN_STALE_TERM_WHILE_CANDIDATE)
-        NIOVA_ASSERT(new_term >= ri->ri_log_hdr.rlh_term);
+    if (rbs && !full)
+    {
+        rnls->rnls_depth++;
+        if (rnls->rnls_depth > rnls->rnls_depth_max)
+            rnls->rnls_depth_max = rnls->rnls_depth;
+    }
     else
-        NIOVA_ASSERT(new_term > ri->ri_log_hdr.rlh_term);
-
-    // Set the leader csn pointer
-    raft_server_set_leader_csn(ri, suggested_leader);
+    {
+        rnls->rnls_nerrs++;
+    }
 
-    DECLARE_AND_INIT_UUID_STR(peer_uuid_str, peer_with_newer_term);
+    niova_mutex_unlock(&rbl->rbl_mutex);
 
-    DBG_RAFT_INSTANCE(LL_WARN, ri, "sender-uuid=%s term=%ld rsn=%s",
-                      peer_uuid_str, new_term,
-                      raft_follower_reason_2_str(reason));
+    if (!rbs || full)
+    {
+        if (rbs)
+            niova_free(rbs);
 
-    // No need to sync the new term.
-    if (new_term == ri->ri_log_hdr.rlh_term)
-        return;
+        return rbs ? -ENOBUFS : -ENOMEM;
+    }
 
-    /* Use a null uuid since we didn't actually vote for this leader.
-     * Had we voted for this leader, the ri_log_hdr term would have been
-     * in sync already.
-     */
-    const uuid_t null_uuid = {0};
-    const bool sync_uuid =
-        (reason == RAFT_BFRSN_VOTED_FOR_PEER) ? true : false;
+    raft_net_update_last_comm_time(ri, rp->csn_uuid, true);
 
-    raft_server_update_log_header(ri, new_term,
-                                  (sync_uuid ?
-                                   peer_with_newer_term : null_uuid));
+    return 0;
 }
 
-static bool
-raft_leader_has_applied_txn_in_my_term(struct raft_instance *ri)
+/**
+ * raft_server_peer_sendq_select - returns the follower's send queue if 'rrm'
+ *    must be sent through it.  Msgs which do not fit into a datagram are
+ *    always queued so that the sender thread is the only sender on the
+ *    follower's TCP connection.  Bulk lane msgs are also queued while the
+ *    queue holds unsent msgs, otherwise a small AE request sent over UDP
+ *    would overtake the larger ones ahead of it.
+ */
+static struct raft_peer_send_queue *
+raft_server_peer_sendq_select(struct raft_instance *ri,
+                              const struct ctl_svc_node *rp,
+                              const struct raft_rpc_msg *rrm,
+                              const enum raft_net_lane lane)
 {
-    NIOVA_ASSERT(ri);
+    if (!ri->ri_bulk_lane.rbl_running ||
+        rp->csn_type != CTL_SVC_NODE_TYPE_RAFT_PEER)
+        return NULL;
 
-    if (raft_instance_is_leader(ri))
-    {
-        const struct raft_leader_state *rls = &ri->ri_leader;
+    struct raft_peer_send_queue *rpsq =
+        raft_server_peer_sendq_get(ri, raft_peer_2_idx(ri, rp->csn_uuid));
+    if (!rpsq)
+        return NULL;
 
-        DBG_RAFT_INSTANCE_FATAL_IF((rls->rls_leader_term !=
-                                    ri->ri_log_hdr.rlh_term), ri,
-                                   "leader-term=%ld != log-hdr-term",
-                                   rls->rls_leader_term);
+    if (raft_server_rpc_msg_size(rrm) > udp_get_max_size())
+        return rpsq;
 
-        return ri->ri_last_applied.rla_idx > rls->rls_initial_term_idx ?
-            true : false;
-    }
+    else if (lane != RAFT_NET_LANE_BULK)
+        return NULL;
 
-    DBG_RAFT_INSTANCE(LL_WARN, ri, "not-leader");
+    niova_mutex_lock(&rpsq->rpsq_mutex);
+    const bool busy = raft_server_peer_sendq_msg_depth(rpsq) ? true : false;
+    niova_mutex_unlock(&rpsq->rpsq_mutex);
 
-    return false;
+    return busy ? rpsq : NULL;
 }
 
-static void
-raft_server_update_follower_last_ack(struct raft_follower_info *rfi)
+static int
+raft_server_send_msg(struct raft_instance *ri,
+                     const enum raft_udp_listen_sockets sock_src,
+                     struct ctl_svc_node *rp, const struct raft_rpc_msg *rrm)
 {
-    NIOVA_ASSERT(rfi);
-
-    niova_realtime_coarse_clock(&rfi->rfi_last_ack);
-}
+    DBG_RAFT_MSG(LL_NOTIFY, rrm, "");
 
-/**
- * raft_server_leader_init_state - setup the raft instance for leader duties.
- */
-static raft_server_net_cb_ctx_t
-raft_server_leader_init_state(struct raft_instance *ri)
-{
-    NIOVA_ASSERT(ri);
+    if (rp->csn_type == CTL_SVC_NODE_TYPE_RAFT_PEER)
+        NIOVA_ASSERT(sock_src == RAFT_UDP_LISTEN_SERVER);
+    else
+        NIOVA_ASSERT(sock_src == RAFT_UDP_LISTEN_CLIENT);
 
-    // Grab the current sync header
-    struct raft_entry_header sync_hdr = {0};
-    raft_instance_get_newest_header(ri, &sync_hdr, RI_NEHDR_SYNC);
+    const enum raft_net_lane lane = raft_server_rpc_msg_lane(rrm);
+    struct raft_bulk_lane *rbl = &ri->ri_bulk_lane;
 
-    // The server should have synced its state prior and not accepted new AE
-    DBG_RAFT_INSTANCE_FATAL_IF((raft_server_has_unsynced_entries(ri)), ri,
-                               "raft_server_has_unsynced_entries() is true");
+    struct raft_peer_send_queue *rpsq =
+        raft_server_peer_sendq_select(ri, rp, rrm, lane);
 
-    ri->ri_state = RAFT_STATE_LEADER;
+    // Queued msgs are sent over TCP and so they remain version 0
+    if (rpsq)
+    {
+        struct iovec iov = {
+            .iov_base = (void *)rrm,
+            .iov_len = raft_server_rpc_msg_size(rrm),
+        };
 
-    struct raft_leader_state *rls = &ri->ri_leader;
-    memset(rls, 0, sizeof(*rls));
+        return raft_server_peer_sendq_enqueue(
+            ri, rpsq, rp, &iov, RAFT_BULK_SEND_MSG,
+            lane == RAFT_NET_LANE_BULK ?
+            raft_server_ae_compress_type(ri, rpsq->rpsq_peer, rrm) :
+            RAFT_AE_COMPRESS_NONE);
+    }
 
-    rls->rls_leader_term = ri->ri_log_hdr.rlh_term;
-    niova_unstable_coarse_clock(&rls->rls_leader_start);
+    char wire[RAFT_RPC_MSG_COMPACT_HDR_MAX];
+    struct iovec iov[2];
 
-    const raft_peer_t num_raft_peers = raft_num_members_validate_and_get(ri);
+    const size_t niovs = raft_server_rpc_msg_iovs_get(ri, rp, rrm, wire, iov);
 
-    const struct raft_candidate_state *rcs = &ri->ri_candidate;
-    for (raft_peer_t i = 0; i < num_raft_peers; i++)
-    {
-        // Update last-ack so that quorum checks won't immediately fail
-        if (rcs->rcs_results[i] == RAFT_VOTE_RESULT_YES ||
-            rcs->rcs_results[i] == RAFT_VOTE_RESULT_NO)
-            raft_server_update_follower_last_ack(
-                raft_server_get_follower_info(ri, i));
-    }
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
 
-    /* Stash the current raft-entry index.  In general, this leader should
-     * place the block @(current-raft-entry-idx + 1).  When this next index
-     * has been committed and APPLIED by this leader, or in other words, when
-     * ri_commit_idx >= rls_initial_term_idx, then this leader can reply to
-     * clients.
-     */
-    rls->rls_initial_term_idx = sync_hdr.reh_index;
+    int rc = raft_net_send_msg(ri, rp, iov, niovs, sock_src);
 
-    for (raft_peer_t i = 0; i < num_raft_peers; i++)
+    if (rp->csn_type == CTL_SVC_NODE_TYPE_RAFT_PEER)
     {
-        struct raft_follower_info *rfi = raft_server_get_follower_info(ri, i);
+        const bool locked = lane == RAFT_NET_LANE_BULK && rbl->rbl_running;
+        if (locked)
+            niova_mutex_lock(&rbl->rbl_mutex);
 
-        rfi->rfi_next_idx = sync_hdr.reh_index + 1;
-        rfi->rfi_prev_idx_term = sync_hdr.reh_term;
-        rfi->rfi_prev_idx_crc = sync_hdr.reh_crc;
-        rfi->rfi_current_idx_term = -1ULL;
-        rfi->rfi_current_idx_crc = 0;
-        rfi->rfi_synced_idx = RAFT_MIN_APPEND_ENTRY_IDX;
-        rfi->rfi_ackd_idx = RAFT_MIN_APPEND_ENTRY_IDX;
+        raft_server_lane_stats_update(ri, lane, rc, &ts);
+
+        if (locked)
+            niova_mutex_unlock(&rbl->rbl_mutex);
     }
+
+    return rc;
 }
 
 /**
- * raft_server_write_next_entry - called from leader and follower context.
- *    Leader writes differ from follower writes in that they always are current
- *    and they may provide a write-supplement set.
- * @ri:  raft-instance pointer
- * @term:  term in which the entry was originally written - which may not be
- *    the current term.
- * @data:  raft-entry data
- * @wr_entry_size: Pointer to array of write entry sizes.
- * @nentries: Total number of entries to be written.
- * @opts:  options flags
- * @ws:  write supplements - currently, only used on the leader in entry_write
- *    context, however, both leaders and followers may make use of write-supp
- *    when performing SM applies.
+ * raft_server_send_msg_batched - queues a peer msg for a batched UDP send.
+ *    'rrm' must not be modified or released until the batch is flushed.
  */
-static raft_net_cb_ctx_t
-raft_server_write_next_entry(struct raft_instance *ri, const int64_t term,
-                             const char *data, const uint32_t *wr_entry_sizes,
-                             const uint32_t nentries,
-                             enum raft_write_entry_opts opts,
-                             const struct raft_net_sm_write_supplements *ws)
+static int
+raft_server_send_msg_batched(struct raft_instance *ri,
+                             struct raft_net_udp_send_batch *rnusb,
+                             struct ctl_svc_node *rp,
+                             const struct raft_rpc_msg *rrm)
 {
-    struct raft_entry_header unsync_hdr = {0};
-    raft_instance_get_newest_header(ri, &unsync_hdr, RI_NEHDR_UNSYNC);
+    DBG_RAFT_MSG(LL_NOTIFY, rrm, "");
 
-    NIOVA_ASSERT(term >= unsync_hdr.reh_term);
+    NIOVA_ASSERT(rp->csn_type == CTL_SVC_NODE_TYPE_RAFT_PEER &&
+                 rnusb->rnusb_sock_src == RAFT_UDP_LISTEN_SERVER);
 
-    const raft_entry_idx_t next_entry_idx = unsync_hdr.reh_index + 1;
+    // Only control msgs are batched
+    NIOVA_ASSERT(raft_server_rpc_msg_lane(rrm) == RAFT_NET_LANE_CTL);
 
-    DBG_RAFT_INSTANCE(LL_NOTIFY, ri,
-                      "next-entry-idx=%ld term=%ld nentries=%u opts=%d",
-                      next_entry_idx, term, nentries, opts);
+    COMPILE_TIME_ASSERT(RAFT_RPC_MSG_COMPACT_HDR_MAX <=
+                        RAFT_NET_UDP_MMSG_SCRATCH_SZ);
 
-    DBG_RAFT_INSTANCE_FATAL_IF((next_entry_idx < 0), ri,
-                               "negative next-entry-idx=%ld", next_entry_idx);
+    struct iovec iov[2];
 
-    int rc = raft_server_entry_write(ri, next_entry_idx, term, data,
-                                     wr_entry_sizes, nentries, opts, ws);
+    const size_t niovs =
+        raft_server_rpc_msg_iovs_get(ri, rp, rrm,
+                                     raft_net_udp_send_batch_scratch(rnusb),
+                                     iov);
 
-    DBG_RAFT_INSTANCE_FATAL_IF((rc), ri, "raft_server_entry_write(): %s",
-                               strerror(-rc));
+    // Batched msgs occupy a single iov, send others immediately
+    if (niovs > 1)
+        return raft_net_send_msg(ri, rp, iov, niovs, rnusb->rnusb_sock_src);
+
+    int rc = raft_net_send_msg_batched(ri, rnusb, rp, iov);
+
+    // The latency of batched msgs is not sampled
+    raft_server_lane_stats_update(ri, RAFT_NET_LANE_CTL, rc, NULL);
+
+    return rc;
 }
 
-static raft_net_cb_ctx_t
-raft_server_leader_write_new_entry(
-    struct raft_instance *ri, const char *data, uint32_t *wr_entry_sizes,
-    const uint32_t nentries, enum raft_write_entry_opts opts,
-    const struct raft_net_sm_write_supplements *ws)
+static void
+raft_server_broadcast_msg(struct raft_instance *ri,
+                          const struct raft_rpc_msg *rrm)
 {
-#if 1
-    NIOVA_ASSERT(raft_instance_is_leader(ri));
-#else
-    if (!raft_instance_is_leader(ri))
-        return;
-#endif
+    const raft_peer_t num_peers = raft_num_members_validate_and_get(ri);
 
-    // Leader change marker may not use a coalesce buffer
-    if (opts & RAFT_WR_ENTRY_OPT_LEADER_CHANGE_MARKER)
-        NIOVA_ASSERT(nentries == 1);
+    struct raft_net_udp_send_batch rnusb;
+    raft_net_udp_send_batch_init(&rnusb, RAFT_UDP_LISTEN_SERVER);
 
-    /* The leader always appends to the end of its log so
-     * ri->ri_log_hdr.rlh_term must be used.  This contrasts with recovering
-     * followers which may not always be able to use the current term when
-     * rebuilding their log.
-     */
-    raft_server_write_next_entry(ri, ri->ri_log_hdr.rlh_term, data,
-                                 wr_entry_sizes, nentries, opts, ws);
+    for (int i = 0; i < num_peers; i++)
+    {
+        struct ctl_svc_node *rp = ri->ri_csn_raft_peers[i];
 
-    // Schedule ourselves to send this entry to the other members
-    RAFT_NET_EVP_NOTIFY_NO_FAIL(ri, RAFT_EVP_REMOTE_SEND);
-}
+        if (rp == ri->ri_csn_this_peer)
+            continue;
 
-static raft_server_net_cb_leader_t
-raft_server_write_leader_change_marker(struct raft_instance *ri)
-{
-    NIOVA_ASSERT(ri && raft_instance_is_leader(ri));
+        int rc = raft_server_send_msg_batched(ri, &rnusb, rp, rrm);
+        SIMPLE_LOG_MSG((rc ? LL_NOTIFY : LL_TRACE),
+                       "raft_server_send_msg_batched(): %d", rc);
+    }
 
-    uint32_t len = 0;
-    raft_server_leader_write_new_entry(ri, NULL, &len, 1,
-                                       RAFT_WR_ENTRY_OPT_LEADER_CHANGE_MARKER,
-                                       NULL);
+    int rc = raft_net_udp_send_batch_flush(ri, &rnusb);
+    SIMPLE_LOG_MSG((rc ? LL_NOTIFY : LL_TRACE),
+                   "raft_net_udp_send_batch_flush(): %d", rc);
 }
 
-static void
-raft_server_set_leader_csn(struct raft_instance *ri,
-                           struct ctl_svc_node *leader_csn);
-
-static raft_server_net_cb_ctx_t
-raft_server_candidate_becomes_leader(struct raft_instance *ri)
+static raft_peer_t
+raft_server_candidate_count_votes(struct raft_instance *ri,
+                                  enum raft_vote_result result)
 {
-    DBG_RAFT_INSTANCE_FATAL_IF((!raft_server_candidate_is_viable(ri)), ri,
-                               "!raft_server_candidate_is_viable()");
+    NIOVA_ASSERT(ri && ri->ri_csn_raft);
+    raft_peer_t cnt = 0;
 
-    raft_server_leader_init_state(ri);
+    const raft_peer_t npeers = raft_num_members_validate_and_get(ri);
 
-    // Modify timer_fd timeout for the leader role.
-    raft_server_timerfd_settime(ri);
+    for (raft_peer_t i = 0; i < npeers; i++)
+        if (ri->ri_candidate.rcs_results[i] == result)
+            cnt++;
 
-    /* Deliver a "dummy" commit to the followers - we cannot respond to client
-     * until this commit has been applied. -- what should the dummy app handler
-     * look like and what should the entry and request msg look like?
-     */
-    raft_server_write_leader_change_marker(ri);
+    return cnt;
+}
 
-    raft_server_set_leader_csn(ri, ri->ri_csn_this_peer);
+/**
+ * raft_server_init_candidate_state - initialize the raft instance for
+ *    either candidate state (prevote or real vote).
+ */
+static raft_net_timerfd_cb_ctx_t
+raft_server_init_candidate_state(struct raft_instance *ri, bool prevote)
+{
+    NIOVA_ASSERT(ri);
 
-    // cleanup any stale cowr sub app entries in the tree
-    if (ri->ri_init_cb)
-        ri->ri_init_cb(RAFT_INIT_BECOMING_LEADER_STATE);
+    ri->ri_state = prevote ?
+        RAFT_STATE_CANDIDATE_PREVOTE : RAFT_STATE_CANDIDATE;
 
-    DBG_RAFT_INSTANCE(LL_WARN, ri, "");
+    struct raft_candidate_state *rcs = &ri->ri_candidate;
+
+    rcs->rcs_prevote = prevote;
+    rcs->rcs_term = ri->ri_log_hdr.rlh_term + 1;
+
+    for (raft_peer_t i = 0; i < CTL_SVC_MAX_RAFT_PEERS; i++)
+        rcs->rcs_results[i] = RAFT_VOTE_RESULT_UNKNOWN;
 }
 
-static raft_server_net_cb_ctx_t
-raft_server_process_vote_reply_common(struct raft_instance *ri,
-                                      struct ctl_svc_node *sender_csn,
-                                      const struct raft_rpc_msg *rrm)
+static bool
+raft_server_candidate_is_viable(struct raft_instance *ri)
 {
-    NIOVA_ASSERT(ri && sender_csn && rrm);
-    // The caller *should* have already checked these
-    NIOVA_ASSERT(!ctl_svc_node_compare_uuid(sender_csn, rrm->rrm_sender_id));
-
-    NIOVA_ASSERT(rrm->rrm_type == RAFT_RPC_MSG_TYPE_PRE_VOTE_REPLY ||
-                 rrm->rrm_type == RAFT_RPC_MSG_TYPE_VOTE_REPLY);
+    if (ri)
+    {
+        if ((raft_instance_is_candidate(ri) &&
+             ri->ri_candidate.rcs_term == ri->ri_log_hdr.rlh_term) ||
+            (raft_instance_is_candidate_prevote(ri) &&
+             ri->ri_candidate.rcs_term == (ri->ri_log_hdr.rlh_term + 1)))
+            return true;
 
-    const bool prevote = rrm->rrm_type == RAFT_RPC_MSG_TYPE_PRE_VOTE_REPLY ?
-        true : false;
+        DBG_RAFT_INSTANCE(LL_ERROR, ri,
+                          "!candidate OR candidate-term (%ld) != ht",
+                          ri->ri_candidate.rcs_term);
+    }
+    return false;
+}
 
-    if (prevote  != raft_instance_is_candidate_prevote(ri) &&
-        !prevote != raft_instance_is_candidate(ri))
-        return;  // the reply is no longer relevant to the instance's state
+static bool
+raft_server_candidate_can_become_leader(struct raft_instance *ri)
+{
+    NIOVA_ASSERT(ri);
 
-    const struct raft_vote_reply_msg *vreply = &rrm->rrm_vote_reply;
+    // Perform some sanity checks prior to counting the 'yes' votes.
+    if (!raft_server_candidate_is_viable(ri))
+        return false;
 
-    const enum raft_vote_result result = vreply->rvrpm_voted_granted ?
-        (prevote ? RAFT_PRE_VOTE_RESULT_YES : RAFT_VOTE_RESULT_YES) :
-        (prevote ? RAFT_PRE_VOTE_RESULT_NO : RAFT_VOTE_RESULT_NO);
+    const raft_peer_t num_yes_votes =
+        raft_server_candidate_count_votes(ri, RAFT_VOTE_RESULT_YES);
 
-    int rc = raft_server_candidate_reg_vote_result(ri, sender_csn->csn_uuid,
-                                                   result);
-    if (rc)
-    {
-        DBG_RAFT_MSG(LL_ERROR, rrm,
-                     "raft_server_candidate_reg_vote_result() %s",
-                     strerror(-rc));
-        DBG_RAFT_INSTANCE(LL_ERROR, ri, "");
+    const raft_peer_t npeers_majority =
+        (ctl_svc_node_raft_2_num_members(ri->ri_csn_raft) / 2) + 1;
 
-        return;
-    }
+    return num_yes_votes >= npeers_majority ? true : false;
+}
 
-    switch (result)
-    {
-    case RAFT_PRE_VOTE_RESULT_YES:
-        // Enough votes to enter full candidate mode?
-        if (raft_server_prevote_candidate_can_become_candidate(ri))
-            raft_server_become_candidate(ri, false);
-        break;
+static bool
+raft_server_prevote_candidate_can_become_candidate(struct raft_instance *ri)
+{
+    NIOVA_ASSERT(ri);
 
-    case RAFT_PRE_VOTE_RESULT_NO:
-        // Peer reports a viable leader but we remain a skeptical candidate
-        break;
+    // Perform some sanity checks prior to counting the 'yes' votes.
+    if (!raft_server_candidate_is_viable(ri))
+        return false;
 
-    case RAFT_VOTE_RESULT_YES:
-        // Enough votes in this term to become leader?
-        if (raft_server_candidate_can_become_leader(ri))
-            raft_server_candidate_becomes_leader(ri);
-        break;
+    const raft_peer_t num_yes_votes =
+        raft_server_candidate_count_votes(ri, RAFT_PRE_VOTE_RESULT_YES);
 
-    case RAFT_VOTE_RESULT_NO:
-        if (ri->ri_log_hdr.rlh_term < vreply->rvrpm_term)
-            // The peer has replied that our term is stale
-            raft_server_becomes_follower(
-                ri, vreply->rvrpm_term, vreply->rvrpm_current_leader,
-                RAFT_BFRSN_STALE_TERM_WHILE_CANDIDATE);
-        break;
+    const raft_peer_t npeers_majority =
+        (ctl_svc_node_raft_2_num_members(ri->ri_csn_raft) / 2) + 1;
 
-    default:
-        NIOVA_ASSERT(0);
-    }
+    return num_yes_votes >= npeers_majority ? true : false;
 }
 
 /**
- * raft_server_refresh_follower_prev_log_term - called while in leader mode,
- *     this function performs the role of reading and storing the term value
- *     for a given log index.  The index is determined by the follower's
- *     'next-idx' value.  The prev_log_term value for the next-index - 1 is
- *     stored in the raft leader structure.  This is so that retries for the
- *     same append entry do not incur extra I/O.
- * @ri:  raft instance
- * @follower:  the numeric position of the follower peer
+ * raft_server_candidate_reg_vote_result - called when this raft instance is a
+ *     candidate and a vote reply needs to be registered in the local table.
  */
-static raft_server_leader_mode_int_t
-raft_server_refresh_follower_prev_log_term(struct raft_instance *ri,
-                                           const raft_peer_t follower)
+static int
+raft_server_candidate_reg_vote_result(struct raft_instance *ri,
+                                      uuid_t voter,
+                                      enum raft_vote_result result)
 {
-    NIOVA_ASSERT(ri && ri->ri_csn_raft &&
-                 raft_member_idx_is_valid(ri, follower));
+    if (!ri || result == RAFT_VOTE_RESULT_UNKNOWN)
+        return -EINVAL;
 
-    NIOVA_ASSERT(raft_instance_is_leader(ri));
+    else if (!(raft_instance_is_candidate_prevote(ri) ||
+               raft_instance_is_candidate(ri)))
+        return -EPERM;
 
-    struct raft_follower_info *rfi =
-        raft_server_get_follower_info(ri, follower);
+    const bool prevote = raft_instance_is_candidate_prevote(ri);
+    if ((prevote && (result != RAFT_PRE_VOTE_RESULT_YES &&
+                     result != RAFT_PRE_VOTE_RESULT_NO)) ||
+        (!prevote && (result != RAFT_VOTE_RESULT_YES &&
+                      result != RAFT_VOTE_RESULT_NO)))
+        return -EINVAL;
 
-    NIOVA_ASSERT(rfi->rfi_next_idx >= 0);
+    raft_peer_t peer_idx = raft_peer_2_idx(ri, voter);
 
-//    const raft_entry_idx_t lowest_idx = niova_atomic_read(&ri->ri_lowest_idx);
+    if (peer_idx >= ctl_svc_node_raft_2_num_members(ri->ri_csn_raft))
+        return -ERANGE;
 
-    const raft_entry_idx_t my_raft_idx =
-        raft_server_get_current_raft_entry_index(ri, RI_NEHDR_UNSYNC);
+    struct raft_candidate_state *rcs = &ri->ri_candidate;
 
-    // next_idx of '0' means no blocks have ever been written.
-    if (rfi->rfi_next_idx == 0)
-    {
-        rfi->rfi_prev_idx_term = 0;
-        rfi->rfi_current_idx_term = -1;
-    }
+    // Prevote mode does not increment rlh_term
+    int64_t expected_term = ri->ri_log_hdr.rlh_term + (prevote ? 1 : 0);
 
-    const bool refresh_prev = rfi->rfi_prev_idx_term < 0 ? true : false;
-#if 0
-    const bool refresh_current =
-        (my_raft_idx >= rfi->rfi_next_idx &&
-         (refresh_prev || rfi->rfi_current_idx_term < 0)) ? true : false;
-#else
-    const bool refresh_current = my_raft_idx >=
-        rfi->rfi_next_idx ? true : false;
-#endif
+    // Internal instance sanity check
+    DBG_RAFT_INSTANCE_FATAL_IF((rcs->rcs_term != expected_term), ri,
+                               "rcs->rcs_term (%ld) != expected-term (%ld)",
+                               rcs->rcs_term, expected_term);
 
-    struct raft_entry_header reh = {0};
+    rcs->rcs_results[peer_idx] = result;
 
-    if (refresh_prev)
-    {
-        const int64_t follower_prev_entry_idx = rfi->rfi_next_idx - 1;
+    DBG_RAFT_INSTANCE(LL_NOTIFY, ri, "peer-idx=%hhu voted=%s (prevote=%s)",
+                      peer_idx,
+                      (result == RAFT_VOTE_RESULT_YES ||
+                       result == RAFT_PRE_VOTE_RESULT_YES) ? "yes" : "no",
+                      prevote ? "yes" : "no");
 
-        NIOVA_ASSERT(follower_prev_entry_idx >= -1);
+    return 0;
+}
 
-        // Test that the follower's prev-idx is not ahead of this leader's idx
-        NIOVA_ASSERT(follower_prev_entry_idx <= my_raft_idx);
+static raft_server_timerfd_cb_ctx_int_t
+raft_server_vote_for_self(struct raft_instance *ri)
+{
+    if (!ri)
+        return -EINVAL;
+
+    else if (!(raft_instance_is_candidate_prevote(ri) ||
+               raft_instance_is_candidate(ri)))
+        return -EPERM;
+
+    enum raft_vote_result yes_vote = RAFT_PRE_VOTE_RESULT_YES;
 
+    if (raft_instance_is_candidate(ri))
+    {
+        // Full-fledged candidate persists its term change
         int rc =
-            raft_server_entry_header_read_by_store(ri, &reh,
-                                                   follower_prev_entry_idx);
-        if (rc < 0)
-        {
-            rfi->rfi_prev_idx_term = 0;
-            rfi->rfi_prev_idx_crc = 0;
+            raft_server_log_header_write(ri, RAFT_INSTANCE_2_SELF_UUID(ri),
+                                         ri->ri_log_hdr.rlh_term + 1);
+        if (rc)
             return rc;
-        }
 
-        DBG_RAFT_ENTRY_FATAL_IF((reh.reh_term < 0), &reh,
-                                "invalid reh.reh_term=%ld", reh.reh_term);
-
-        rfi->rfi_prev_idx_term = reh.reh_term;
-        rfi->rfi_prev_idx_crc = reh.reh_crc;
+        yes_vote = RAFT_VOTE_RESULT_YES;
     }
 
-    if (refresh_current)
+    int rc = raft_server_candidate_reg_vote_result(ri,
+                                                 RAFT_INSTANCE_2_SELF_UUID(ri),
+                                                 yes_vote);
+    if (FAULT_INJECT(raft_pvc_becomes_candidate))
     {
-        NIOVA_ASSERT(my_raft_idx >= rfi->rfi_next_idx);
-
-        int rc = raft_server_entry_header_read_by_store(ri, &reh,
-                                                        rfi->rfi_next_idx);
-        if (rc < 0)
-        {
-            rfi->rfi_current_idx_term = -1;
-            rfi->rfi_current_idx_crc = 0;
-            return rc;
-        }
-        else
-        {
-            rfi->rfi_current_idx_term = reh.reh_term;
-            rfi->rfi_current_idx_crc = reh.reh_crc;
-        }
+        /* Force the prevote candidate to go into candidate state */
+        raft_server_become_candidate(ri, false);
+        return 0;
     }
-
-    DBG_RAFT_INSTANCE(
-        ((refresh_prev || refresh_current) ? LL_DEBUG : LL_TRACE), ri,
-        "peer=%hhx refresh=%d:%d pti=%ld:%ld si=%ld ct=%ld ccrc=%lu",
-        follower, refresh_prev, refresh_current, rfi->rfi_prev_idx_term,
-        rfi->rfi_next_idx, rfi->rfi_synced_idx, rfi->rfi_current_idx_term,
-        rfi->rfi_current_idx_crc);
-
-    return 0;
+    return rc;
 }
 
-static raft_server_leader_mode_int64_t
-raft_server_leader_get_current_term(const struct raft_instance *ri)
+static void
+raft_server_set_uuids_in_rpc_msg(const struct raft_instance *ri,
+                                 struct raft_rpc_msg *rrm)
 {
-    NIOVA_ASSERT(ri && raft_instance_is_leader(ri));
-    NIOVA_ASSERT(ri->ri_leader.rls_leader_term == ri->ri_log_hdr.rlh_term);
+    if (ri && rrm)
+    {
+        uuid_copy(rrm->rrm_sender_id, RAFT_INSTANCE_2_SELF_UUID(ri));
+        uuid_copy(rrm->rrm_raft_id, RAFT_INSTANCE_2_RAFT_UUID(ri));
+        uuid_copy(rrm->rrm_db_id, ri->ri_db_uuid);
 
-    return ri->ri_log_hdr.rlh_term;
+        // Every server msg advertises the versions this peer can decode
+        rrm->rrm_version_max = ri->ri_rpc_msg_version_max;
+    }
 }
 
-static raft_server_leader_mode_int_t
-raft_server_leader_init_append_entry_msg(struct raft_instance *ri,
-                                         struct raft_rpc_msg *rrm,
-                                         const raft_peer_t follower,
-                                         bool heartbeat)
+/**
+ * raft_server_become_candidate - called when the raft instance is either in
+ *    follower or candidate mode and the leader has not provided a heartbeat
+ *    within the timeout threshold.
+ */
+static raft_net_timerfd_cb_ctx_t // or raft_server_net_cb_ctx_t (!prevote)
+raft_server_become_candidate(struct raft_instance *ri, bool prevote)
 {
-    NIOVA_ASSERT(ri && ri->ri_csn_raft && rrm &&
-                 raft_member_idx_is_valid(ri, follower));
-
-    memset(rrm, 0, sizeof(*rrm));
+    NIOVA_ASSERT(ri && ri->ri_csn_this_peer);
 
-    const struct raft_follower_info *rfi =
-        raft_server_get_follower_info(ri, follower);
+    ri->ri_csn_leader = NULL;
 
-    rrm->rrm_type = RAFT_RPC_MSG_TYPE_APPEND_ENTRIES_REQUEST;
-    rrm->rrm_version = 0;
+    // Promotion to full-fledged candidate may only come from pre-vote state
+    if (!prevote)
+        NIOVA_ASSERT(raft_instance_is_candidate_prevote(ri));
 
-    raft_server_set_uuids_in_rpc_msg(ri, rrm);
+    if (FAULT_INJECT(raft_candidate_state_disabled))
+        return;
 
-    struct raft_append_entries_request_msg *raerq =
-        &rrm->rrm_append_entries_request;
+    // Reset vote counters and mark self as in 'preVote' state
+    raft_server_init_candidate_state(ri, prevote);
 
-    int rc = raft_server_refresh_follower_prev_log_term(ri, follower);
-    if (rc == -ERANGE)
-    {
-        // Convert this into heartbeat
-        heartbeat = true;
-    }
-    else if (rc) // Accept only ERANGE
-    {
-        DBG_RAFT_INSTANCE(LL_FATAL, ri,
-                          "raft_server_refresh_follower_prev_log_term(): %s",
-                          strerror(-rc));
-    }
+    const int64_t proposed_term = ri->ri_log_hdr.rlh_term + 1;
 
-    raerq->raerqm_heartbeat_msg = heartbeat ? 1 : 0;
-    raerq->raerqm_entry_out_of_range = (rc == -ERANGE) ? 1 : 0;
+    // sync's new term if !preVote state
+    int rc = raft_server_vote_for_self(ri);
 
-    raerq->raerqm_leader_term = raft_server_leader_get_current_term(ri);
-    raerq->raerqm_commit_index = ri->ri_commit_idx;
-    raerq->raerqm_entries_sz = 0;
-    raerq->raerqm_num_entries = 0;
-    raerq->raerqm_leader_change_marker = 0;
-    raerq->raerqm_lowest_index = niova_atomic_read(&ri->ri_lowest_idx);
-    raerq->raerqm_chkpt_index = ri->ri_checkpoint_last_idx;
-    memset(raerq->raerqm_size_arr, 0,
-           (sizeof(uint32_t) * RAFT_ENTRY_NUM_ENTRIES));
+    if (rc) // Failed to sync our own log header!
+        DBG_RAFT_INSTANCE(LL_FATAL, ri, "raft_server_log_header_write(): %s",
+                          strerror(-rc));
 
-    // There are only 2 possible error codes at this point
-    NIOVA_ASSERT(!rc || rc == -ERANGE);
+    // Get the latest entry header following the self-vote
+    struct raft_entry_header sync_hdr = {0};
+    raft_instance_get_newest_header(ri, &sync_hdr, RI_NEHDR_SYNC);
 
-    if (!rc)
-    {
-        raerq->raerqm_log_term = rfi->rfi_current_idx_term;
-        raerq->raerqm_this_idx_crc = rfi->rfi_current_idx_crc;
-        raerq->raerqm_prev_idx_crc = rfi->rfi_prev_idx_crc;
-    }
+    const enum raft_rpc_msg_type type =
+        prevote ?
+        RAFT_RPC_MSG_TYPE_PRE_VOTE_REQUEST : RAFT_RPC_MSG_TYPE_VOTE_REQUEST;
 
-    // Previous log index is the address of the follower's last write.
-    raerq->raerqm_prev_log_index = rfi->rfi_next_idx - 1;
+    struct raft_rpc_msg rrm = {
+        //.rrm_rrm_sender_id = ri->ri_csn_this_peer.csn_uuid,
+        .rrm_type = type,
+        .rrm_version = 0,
+        .rrm_vote_request.rvrqm_proposed_term = proposed_term,
+        .rrm_vote_request.rvrqm_last_log_term = sync_hdr.reh_term,
+        .rrm_vote_request.rvrqm_last_log_index = sync_hdr.reh_index,
+    };
 
-    // Copy the rls_prev_idx_term[] if it was refreshed above.
-    raerq->raerqm_prev_log_term = rc ? -1LL : rfi->rfi_prev_idx_term;
+    raft_server_set_uuids_in_rpc_msg(ri, &rrm);
 
-    // If error, return -ESTALE to signify that the peer needs bulk recovery
-    return rc ? -ESTALE : 0;
-}
+    DBG_RAFT_INSTANCE(LL_WARN, ri, "");
 
-static raft_server_epoll_remote_sender_t
-raft_server_append_entry_sender(struct raft_instance *ri, bool heartbeat);
+    if (!prevote) // allow more time to recv votes
+        raft_server_timerfd_settime(ri);
 
-static raft_net_timerfd_cb_ctx_t
-raft_server_issue_heartbeat(struct raft_instance *ri)
-{
-    NIOVA_ASSERT(ri && ri->ri_csn_this_peer);
-    NIOVA_ASSERT(raft_instance_is_leader(ri));
+    raft_server_broadcast_msg(ri, &rrm);
 
-    raft_server_append_entry_sender(ri, true);
+    // If leader is demoted to candidate, allow applications to
+    // cleanup the leader specific state/data.
+    if (prevote && ri->ri_init_cb)
+        ri->ri_init_cb(RAFT_INIT_BECOMING_CANDIDATE_STATE);
 }
 
-/*
- * Write all the coalesced write entries.
- */
 static void
-raft_server_write_coalesced_entries(struct raft_instance *ri,
-                                    const char *caller_fn)
-{
-    DBG_RAFT_INSTANCE(LL_DEBUG, ri, "%s: nent=%u tsz=%zu",
-                      caller_fn, ri->ri_coalesced_wr->rcwi_nentries,
-                      ri->ri_coalesced_wr->rcwi_total_size);
-
-    if (!ri->ri_coalesced_wr->rcwi_nentries)
-        return;
-
-    raft_server_leader_write_new_entry(
-        ri, ri->ri_coalesced_wr->rcwi_buffer,
-        ri->ri_coalesced_wr->rcwi_entry_sizes,
-        ri->ri_coalesced_wr->rcwi_nentries, RAFT_WR_ENTRY_OPT_NONE,
-        &ri->ri_coalesced_wr->rcwi_ws);
-
-    raft_net_sm_write_supplement_destroy(&ri->ri_coalesced_wr->rcwi_ws);
-
-    memset(ri->ri_coalesced_wr, 0, sizeof(struct raft_instance_co_wr));
-}
-
-static raft_net_timerfd_cb_ctx_bool_t
-raft_leader_check_quorum(struct raft_instance *ri);
-
-static raft_net_timerfd_cb_ctx_t
-raft_server_increment_leader_time(struct raft_instance *ri)
+raft_server_update_log_header(struct raft_instance *ri, int64_t new_term,
+                              const uuid_t peer_with_newer_term)
 {
-    if (ri == NULL || !raft_instance_is_leader(ri))
-        return;
-
-    struct raft_leader_state *rls = &ri->ri_leader;
-
-    struct timespec now;
-    niova_unstable_coarse_clock(&now);
+    NIOVA_ASSERT(new_term > ri->ri_log_hdr.rlh_term);
 
-    NIOVA_ASSERT(timespeccmp(&now, &rls->rls_leader_start, >=));
+    int rc = raft_server_log_header_write(ri, peer_with_newer_term, new_term);
 
-    timespecsub(&now, &rls->rls_leader_start, &rls->rls_leader_accumulated);
+    DBG_RAFT_INSTANCE_FATAL_IF((rc), ri,
+                               "raft_server_log_header_write() %s",
+                               strerror(-rc));
 }
 
-static raft_net_timerfd_cb_ctx_t
-raft_server_timerfd_leader_cb(struct raft_instance *ri)
+static void
+raft_server_try_update_log_header_null_voted_for_peer(struct raft_instance *ri,
+                                                      int64_t new_term)
 {
-    static size_t cnt;
-    cnt++;
-
-    if (!raft_leader_check_quorum(ri)) // bail if quorum loss is detected
-        return raft_server_become_candidate(ri, true);
-
-    if ((cnt % RAFT_SERVER_COALESCE_TIMEOUT_FACTOR) == 0)
-        raft_server_leader_co_wr_timer_expired(ri);
-
-    if ((cnt % RAFT_SERVER_HEARTBEAT_ISSUE_FACTOR) == 0)
-        raft_server_issue_heartbeat(ri);
+    if (ri->ri_log_hdr.rlh_term < new_term)
+    {
+        const uuid_t null_uuid = {0};
 
-    raft_server_increment_leader_time(ri);
+        raft_server_update_log_header(ri, new_term, null_uuid);
+    }
 }
 
-static raft_net_timerfd_cb_ctx_t
-raft_server_timerfd_cb(struct raft_instance *ri)
+static void
+raft_server_set_leader_csn(struct raft_instance *ri,
+                           struct ctl_svc_node *leader_csn)
 {
-    FUNC_ENTRY(LL_TRACE);
+    NIOVA_ASSERT(ri && leader_csn);
 
-    switch (ri->ri_state)
+    if (ri->ri_csn_leader != leader_csn)
     {
-    case RAFT_STATE_FOLLOWER: // fall through
-    case RAFT_STATE_CANDIDATE_PREVOTE: // fall through
-    case RAFT_STATE_CANDIDATE:
-        raft_server_become_candidate(ri, true);
-        break;
-
-    case RAFT_STATE_LEADER:
-        raft_server_timerfd_leader_cb(ri);
-        break;
-
-    default:
-        break;
+        ri->ri_csn_leader = leader_csn;
+        DBG_RAFT_INSTANCE(LL_NOTIFY, ri, "csn=%p", leader_csn);
     }
-
-    raft_server_timerfd_settime(ri);
 }
 
 /**
- * raft_server_process_vote_request_decide - determine if this peer should
- *    vote for the candidate.
+ * raft_server_becomes_follower - handle the transition from a
+ *    a follower either from candidate or leader state.  This function sets
+ *    the new term and sync's it to the header.  The peer-uuid is not set
+ *    in the log header unless the caller specifies it so.  This is generally
+ *    only done when the caller is raft_server_process_vote_reply().
+ *    Otherwise, this function is typically called when the term changes
+ *    elsewhere in the cluster and this node becomes a stale leader or
+ *    candidate.
+ * @ri:  raft instance
+ * @new_term:  the term provided by a peer
+ * @peer_with_newer_term:  peer uuid which provided the higher term
+ * @reason:  the reason why this instance becomes a follower
  */
-static bool
-raft_server_process_vote_request_decide(
-    const struct raft_instance *ri, const struct raft_vote_request_msg *vreq,
-    const struct raft_entry_header *cmp_hdr)
+static void
+raft_server_becomes_follower(struct raft_instance *ri,
+                             int64_t new_term,
+                             const uuid_t peer_with_newer_term,
+                             enum raft_follower_reasons reason)
 {
-    NIOVA_ASSERT(ri && vreq && cmp_hdr);
+    NIOVA_ASSERT(ri);
 
-    // "allow at most one winner per term"
-    return (vreq->rvrqm_proposed_term <= ri->ri_log_hdr.rlh_term ||
-            vreq->rvrqm_last_log_term < cmp_hdr->reh_term ||
-            vreq->rvrqm_last_log_index < cmp_hdr->reh_index) ? false : true;
-}
+    struct ctl_svc_node *suggested_leader =
+        raft_peer_uuid_to_csn(ri, peer_with_newer_term);
 
-static bool
-raft_server_process_pre_vote_request_decide(
-    const struct raft_instance *ri, const struct raft_vote_request_msg *vreq,
-    const struct raft_entry_header *cmp_hdr)
-{
-    NIOVA_ASSERT(ri && vreq && cmp_hdr);
+    if (!suggested_leader || suggested_leader == ri->ri_csn_this_peer)
+        return;
 
-    /* First, check the typical vote conditions - these are prerequisites for
-     * continuing...
-     * If the proposed term value is > (current-term + 1) then we must allow
-     * the PreVote to proceed so that the cluster can negotiate a higher term
-     * value, which the preVote candidate has already applied.  Otherwise,
-     * leaders and followers always vote 'no'.  Leader's assume they are alive
-     * (XXX CheckQuorum is needed, however) and followers will remain so until
-     * their own AE timeouts expire.
+    ri->ri_state = RAFT_STATE_FOLLOWER;
+    ri->ri_follower_reason = reason;
+
+    /* If this node demoted from leader to follower, but has some
+     * coalesced writes buffered in ri_coalesced_wr, destroy the write
+     * supplement for them.
      */
-    if (raft_server_process_vote_request_decide(ri, vreq, cmp_hdr) &&
-        (
-            // 1. prevote candidate already persisted a higher term, vote yes
-            (vreq->rvrqm_proposed_term > (ri->ri_log_hdr.rlh_term + 1)) ||
+    if (ri->ri_coalesced_wr)
+        raft_net_sm_write_supplement_destroy(&ri->ri_coalesced_wr->rcwi_ws);
 
-            // 2. cluster leadership is in question, indicated by our own state
-            (!ri->ri_csn_leader ||
-             raft_instance_is_candidate(ri) ||
-             raft_instance_is_candidate_prevote(ri)))
-        )
-        return true;
+    // Cached entries are only consulted while leader
+    raft_server_entry_cache_flush(ri);
 
-    return false;
-}
+    /* Generally, in raft we become a follower when a higher term is observed.
+     * However when 2 or more peers become candidates for the same term, the
+     * losing peer may only be notified of a successful election completion
+     * when it recv's a AE RPC.
+     *
+     * In PreVote mode, the instance will not increment its
+     * rlh_term and the 'new_term', provided by the responding peer, may be
+     * == to the rlh_term.  However, it should not be < rlh_term since this
+     * would imply that the cluster is ignoring a higher term value which has
+     * been persisted by this peer.
+     */
+    if (reason == RAFT_BFRSN_STALE_TERM_WHILE_CANDIDATE)
+        NIOVA_ASSERT(new_term >= ri->ri_log_hdr.rlh_term);
+    else
+        NIOVA_ASSERT(new_term > ri->ri_log_hdr.rlh_term);
 
-static raft_server_net_cb_ctx_t
-raft_server_process_vote_request_common(struct raft_instance *ri,
-                                        struct ctl_svc_node *sender_csn,
-                                        const struct raft_rpc_msg *rrm)
-{
-    NIOVA_ASSERT(ri && sender_csn && rrm);
-    NIOVA_ASSERT(rrm->rrm_type == RAFT_RPC_MSG_TYPE_PRE_VOTE_REQUEST ||
-                 rrm->rrm_type == RAFT_RPC_MSG_TYPE_VOTE_REQUEST);
+    // Set the leader csn pointer
+    raft_server_set_leader_csn(ri, suggested_leader);
 
-    // The caller *should* have already checked this.
-    NIOVA_ASSERT(!ctl_svc_node_compare_uuid(sender_csn, rrm->rrm_sender_id));
+    DECLARE_AND_INIT_UUID_STR(peer_uuid_str, peer_with_newer_term);
 
-    const struct raft_vote_request_msg *vreq = &rrm->rrm_vote_request;
-    const bool prevote = rrm->rrm_type == RAFT_RPC_MSG_TYPE_PRE_VOTE_REQUEST ?
-        true : false;
+    DBG_RAFT_INSTANCE(LL_WARN, ri, "sender-uuid=%s term=%ld rsn=%s",
+                      peer_uuid_str, new_term,
+                      raft_follower_reason_2_str(reason));
 
-    struct raft_rpc_msg rreply_msg = {0};
+    // No need to sync the new term.
+    if (new_term == ri->ri_log_hdr.rlh_term)
+        return;
 
-    // Make a decision based on the synced status of the log
-    raft_server_backend_sync_pending(ri, __func__);
+    /* Use a null uuid since we didn't actually vote for this leader.
+     * Had we voted for this leader, the ri_log_hdr term would have been
+     * in sync already.
+     */
+    const uuid_t null_uuid = {0};
+    const bool sync_uuid =
+        (reason == RAFT_BFRSN_VOTED_FOR_PEER) ? true : false;
 
-    struct raft_entry_header sync_hdr = {0};
-    raft_instance_get_newest_header(ri, &sync_hdr, RI_NEHDR_SYNC);
+    raft_server_update_log_header(ri, new_term,
+                                  (sync_uuid ?
+                                   peer_with_newer_term : null_uuid));
+}
 
-    // Do some initialization on the reply message.
-    raft_server_set_uuids_in_rpc_msg(ri, &rreply_msg);
+static bool
+raft_leader_has_applied_txn_in_my_term(struct raft_instance *ri)
+{
+    NIOVA_ASSERT(ri);
 
-    rreply_msg.rrm_type = prevote ?
-        RAFT_RPC_MSG_TYPE_PRE_VOTE_REPLY : RAFT_RPC_MSG_TYPE_VOTE_REPLY;
+    if (raft_instance_is_leader(ri))
+    {
+        const struct raft_leader_state *rls = &ri->ri_leader;
 
-    rreply_msg.rrm_vote_reply.rvrpm_term = ri->ri_log_hdr.rlh_term;
+        DBG_RAFT_INSTANCE_FATAL_IF((rls->rls_leader_term !=
+                                    ri->ri_log_hdr.rlh_term), ri,
+                                   "leader-term=%ld != log-hdr-term",
+                                   rls->rls_leader_term);
 
-    // Obtain the vote or prevote result
-    const bool result = prevote ?
-        raft_server_process_pre_vote_request_decide(ri, vreq, &sync_hdr) :
-        raft_server_process_vote_request_decide(ri, vreq, &sync_hdr);
+        return ri->ri_last_applied.rla_idx > rls->rls_initial_term_idx ?
+            true : false;
+    }
 
-    // Set the vote result
-    rreply_msg.rrm_vote_reply.rvrpm_voted_granted = !!result;
+    DBG_RAFT_INSTANCE(LL_WARN, ri, "not-leader");
 
-    // Tell the candidate of our current leader if voting 'no'
-    if (!result && ri->ri_csn_leader)
-        uuid_copy(rreply_msg.rrm_vote_reply.rvrpm_current_leader,
-                  ri->ri_csn_leader->csn_uuid);
+    return false;
+}
 
-    enum log_level level = prevote ? LL_NOTIFY : LL_WARN;
-    DBG_RAFT_MSG(level, rrm, "vote=%s my term=%ld last=%ld:%ld",
-                 rreply_msg.rrm_vote_reply.rvrpm_voted_granted ? "yes" : "no",
-                 ri->ri_log_hdr.rlh_term, sync_hdr.reh_term,
-                 sync_hdr.reh_index);
-    DBG_RAFT_INSTANCE(level, ri, "");
+static void
+raft_server_update_follower_last_ack(struct raft_follower_info *rfi)
+{
+    NIOVA_ASSERT(rfi);
 
-    // Sync our log header only if this is a real election and we vote 'yes'
-    if (!prevote && result)
-        raft_server_becomes_follower(ri, vreq->rvrqm_proposed_term,
-                                     rrm->rrm_sender_id,
-                                     RAFT_BFRSN_VOTED_FOR_PEER);
+    niova_realtime_coarse_clock(&rfi->rfi_last_ack);
+}
 
-    // Reply to the candidate
-    int rc = raft_server_send_msg(ri, RAFT_UDP_LISTEN_SERVER, sender_csn,
-                                  &rreply_msg);
-    if (rc)
-        DBG_RAFT_INSTANCE(LL_NOTIFY, ri, "raft_server_send_msg(): %s",
-                          strerror(-rc));
+/**
+ * raft_server_follower_ae_window_reset - forget the AE requests which are in
+ *    flight to this follower so that the next send restarts from rfi_next_idx.
+ */
+static void
+raft_server_follower_ae_window_reset(struct raft_follower_info *rfi)
+{
+    NIOVA_ASSERT(rfi);
+
+    rfi->rfi_inflight_idx = RAFT_ENTRY_IDX_ANY;
+    rfi->rfi_inflight_term = -1;
+    rfi->rfi_inflight_crc = 0;
+    rfi->rfi_inflight_cnt = 0;
 }
 
 /**
- * raft_server_append_entry_check_already_stored - this function takes an
- *    AE request msg and reads the log to determine if the entry had been
- *    stored at an earlier time.  This function is called when the follower
- *    detects that its log index is > than the index value in the AE request.
- *    AFAICT, this situation can occur in two instances:  first, when the
- *    follower was either a deposed leader or follower of a deposed leader and
- *    it accepted entries which the new leader does not possess (rollback);
- *    or secondly, an old / retried / stale AE request arrives at this follower
- *    for an index which had already been written.
+ * raft_server_leader_init_state - setup the raft instance for leader duties.
  */
-static raft_server_net_cb_follower_ctx_bool_t
-raft_server_append_entry_check_already_stored(
-    struct raft_instance *ri,
-    const struct raft_append_entries_request_msg *raerq)
+static raft_server_net_cb_ctx_t
+raft_server_leader_init_state(struct raft_instance *ri)
 {
-    NIOVA_ASSERT(ri && raerq);
-    NIOVA_ASSERT(raft_instance_is_follower(ri));
+    NIOVA_ASSERT(ri);
 
-    if (raerq->raerqm_entry_out_of_range)
-        return false;
+    // Grab the current sync header
+    struct raft_entry_header sync_hdr = {0};
+    raft_instance_get_newest_header(ri, &sync_hdr, RI_NEHDR_SYNC);
 
-    // raerqm_prev_log_index can be -1 if no writes have ever been done.
-    NIOVA_ASSERT(raerq->raerqm_prev_log_index >= RAFT_MIN_APPEND_ENTRY_IDX);
+    // The server should have synced its state prior and not accepted new AE
+    DBG_RAFT_INSTANCE_FATAL_IF((raft_server_has_unsynced_entries(ri)), ri,
+                               "raft_server_has_unsynced_entries() is true");
 
-    const raft_entry_idx_t raft_current_idx =
-        raft_server_get_current_raft_entry_index(ri, RI_NEHDR_UNSYNC);
+    ri->ri_state = RAFT_STATE_LEADER;
 
-    const raft_entry_idx_t leaders_next_idx_for_me =
-        raerq->raerqm_prev_log_index + 1;
+    // Start the new term with an empty entry cache
+    raft_server_entry_cache_flush(ri);
 
-    // The condition for entering this function should have been checked prior.
-    NIOVA_ASSERT(raft_current_idx >= leaders_next_idx_for_me);
+    struct raft_leader_state *rls = &ri->ri_leader;
+    memset(rls, 0, sizeof(*rls));
 
-    struct raft_entry_header reh = {0};
+    rls->rls_leader_term = ri->ri_log_hdr.rlh_term;
+    niova_unstable_coarse_clock(&rls->rls_leader_start);
 
-    /* In a corner-case, the leader's msg may be stale and contain contents
-     * from a period where this peer and the leader were caught up.  As a
-     * result, the current log_term would not exist and we should not read
-     * this block.
-     */
-    if (raerq->raerqm_log_term > 0)
+    const raft_peer_t num_raft_peers = raft_num_members_validate_and_get(ri);
+
+    const struct raft_candidate_state *rcs = &ri->ri_candidate;
+    for (raft_peer_t i = 0; i < num_raft_peers; i++)
     {
-        int rc = raft_server_entry_header_read_by_store(
-            ri, &reh, leaders_next_idx_for_me);
+        // Update last-ack so that quorum checks won't immediately fail
+        if (rcs->rcs_results[i] == RAFT_VOTE_RESULT_YES ||
+            rcs->rcs_results[i] == RAFT_VOTE_RESULT_NO)
+            raft_server_update_follower_last_ack(
+                raft_server_get_follower_info(ri, i));
+    }
 
-        FATAL_IF((rc), "raft_server_header_entry_read(): %s", strerror(-rc));
+    /* Stash the current raft-entry index.  In general, this leader should
+     * place the block @(current-raft-entry-idx + 1).  When this next index
+     * has been committed and APPLIED by this leader, or in other words, when
+     * ri_commit_idx >= rls_initial_term_idx, then this leader can reply to
+     * clients.
+     */
+    rls->rls_initial_term_idx = sync_hdr.reh_index;
 
-        if (reh.reh_term != raerq->raerqm_log_term)
-            return false;
+    for (raft_peer_t i = 0; i < num_raft_peers; i++)
+    {
+        struct raft_follower_info *rfi = raft_server_get_follower_info(ri, i);
 
-        FATAL_IF((!raerq->raerqm_entry_out_of_range &&
-                  raerq->raerqm_this_idx_crc != reh.reh_crc &&
+        rfi->rfi_next_idx = sync_hdr.reh_index + 1;
+        rfi->rfi_prev_idx_term = sync_hdr.reh_term;
+        rfi->rfi_prev_idx_crc = sync_hdr.reh_crc;
+        rfi->rfi_current_idx_term = -1ULL;
+        rfi->rfi_current_idx_crc = 0;
+        rfi->rfi_synced_idx = RAFT_MIN_APPEND_ENTRY_IDX;
+        rfi->rfi_ackd_idx = RAFT_MIN_APPEND_ENTRY_IDX;
+
+        raft_server_follower_ae_window_reset(rfi);
+    }
+}
+
+/**
+ * raft_server_write_next_entry - called from leader and follower context.
+ *    Leader writes differ from follower writes in that they always are current
+ *    and they may provide a write-supplement set.
+ * @ri:  raft-instance pointer
+ * @term:  term in which the entry was originally written - which may not be
+ *    the current term.
+ * @iov:  raft-entry data fragments, see raft_server_entry_write()
+ * @niov:  number of data fragments
+ * @wr_entry_size: Pointer to array of write entry sizes.
+ * @nentries: Total number of entries to be written.
+ * @opts:  options flags
+ * @ws:  write supplements - currently, only used on the leader in entry_write
+ *    context, however, both leaders and followers may make use of write-supp
+ *    when performing SM applies.
+ */
+static raft_net_cb_ctx_t
+raft_server_write_next_entry(struct raft_instance *ri, const int64_t term,
+                             const struct iovec *iov, const size_t niov,
+                             const uint32_t *wr_entry_sizes,
+                             const uint32_t nentries,
+                             enum raft_write_entry_opts opts,
+                             const struct raft_net_sm_write_supplements *ws)
+{
+    struct raft_entry_header unsync_hdr = {0};
+    raft_instance_get_newest_header(ri, &unsync_hdr, RI_NEHDR_UNSYNC);
+
+    NIOVA_ASSERT(term >= unsync_hdr.reh_term);
+
+    const raft_entry_idx_t next_entry_idx = unsync_hdr.reh_index + 1;
+
+    DBG_RAFT_INSTANCE(LL_NOTIFY, ri,
+                      "next-entry-idx=%ld term=%ld nentries=%u opts=%d",
+                      next_entry_idx, term, nentries, opts);
+
+    DBG_RAFT_INSTANCE_FATAL_IF((next_entry_idx < 0), ri,
+                               "negative next-entry-idx=%ld", next_entry_idx);
+
+    int rc = raft_server_entry_write(ri, next_entry_idx, term, iov, niov,
+                                     wr_entry_sizes, nentries, opts, ws);
+
+    DBG_RAFT_INSTANCE_FATAL_IF((rc), ri, "raft_server_entry_write(): %s",
+                               strerror(-rc));
+}
+
+static raft_net_cb_ctx_t
+raft_server_leader_write_new_entry(
+    struct raft_instance *ri, const struct iovec *iov, const size_t niov,
+    uint32_t *wr_entry_sizes, const uint32_t nentries,
+    enum raft_write_entry_opts opts,
+    const struct raft_net_sm_write_supplements *ws)
+{
+#if 1
+    NIOVA_ASSERT(raft_instance_is_leader(ri));
+#else
+    if (!raft_instance_is_leader(ri))
+        return;
+#endif
+
+    // Leader change marker may not use a coalesce buffer
+    if (opts & RAFT_WR_ENTRY_OPT_LEADER_CHANGE_MARKER)
+        NIOVA_ASSERT(nentries == 1);
+
+    /* The leader always appends to the end of its log so
+     * ri->ri_log_hdr.rlh_term must be used.  This contrasts with recovering
+     * followers which may not always be able to use the current term when
+     * rebuilding their log.
+     */
+    raft_server_write_next_entry(ri, ri->ri_log_hdr.rlh_term, iov, niov,
+                                 wr_entry_sizes, nentries, opts, ws);
+
+    // Schedule ourselves to send this entry to the other members
+    RAFT_NET_EVP_NOTIFY_NO_FAIL(ri, RAFT_EVP_REMOTE_SEND);
+}
+
+static raft_server_net_cb_leader_t
+raft_server_write_leader_change_marker(struct raft_instance *ri)
+{
+    NIOVA_ASSERT(ri && raft_instance_is_leader(ri));
+
+    uint32_t len = 0;
+    raft_server_leader_write_new_entry(ri, NULL, 0, &len, 1,
+                                       RAFT_WR_ENTRY_OPT_LEADER_CHANGE_MARKER,
+                                       NULL);
+}
+
+static void
+raft_server_set_leader_csn(struct raft_instance *ri,
+                           struct ctl_svc_node *leader_csn);
+
+static raft_server_net_cb_ctx_t
+raft_server_candidate_becomes_leader(struct raft_instance *ri)
+{
+    DBG_RAFT_INSTANCE_FATAL_IF((!raft_server_candidate_is_viable(ri)), ri,
+                               "!raft_server_candidate_is_viable()");
+
+    raft_server_leader_init_state(ri);
+
+    // Modify timer_fd timeout for the leader role.
+    raft_server_timerfd_settime(ri);
+
+    /* Deliver a "dummy" commit to the followers - we cannot respond to client
+     * until this commit has been applied. -- what should the dummy app handler
+     * look like and what should the entry and request msg look like?
+     */
+    raft_server_write_leader_change_marker(ri);
+
+    raft_server_set_leader_csn(ri, ri->ri_csn_this_peer);
+
+    // cleanup any stale cowr sub app entries in the tree
+    if (ri->ri_init_cb)
+        ri->ri_init_cb(RAFT_INIT_BECOMING_LEADER_STATE);
+
+    DBG_RAFT_INSTANCE(LL_WARN, ri, "");
+}
+
+static raft_server_net_cb_ctx_t
+raft_server_process_vote_reply_common(struct raft_instance *ri,
+                                      struct ctl_svc_node *sender_csn,
+                                      const struct raft_rpc_msg *rrm)
+{
+    NIOVA_ASSERT(ri && sender_csn && rrm);
+    // The caller *should* have already checked these
+    NIOVA_ASSERT(!ctl_svc_node_compare_uuid(sender_csn, rrm->rrm_sender_id));
+
+    NIOVA_ASSERT(rrm->rrm_type == RAFT_RPC_MSG_TYPE_PRE_VOTE_REPLY ||
+                 rrm->rrm_type == RAFT_RPC_MSG_TYPE_VOTE_REPLY);
+
+    const bool prevote = rrm->rrm_type == RAFT_RPC_MSG_TYPE_PRE_VOTE_REPLY ?
+        true : false;
+
+    if (prevote  != raft_instance_is_candidate_prevote(ri) &&
+        !prevote != raft_instance_is_candidate(ri))
+        return;  // the reply is no longer relevant to the instance's state
+
+    const struct raft_vote_reply_msg *vreply = &rrm->rrm_vote_reply;
+
+    const enum raft_vote_result result = vreply->rvrpm_voted_granted ?
+        (prevote ? RAFT_PRE_VOTE_RESULT_YES : RAFT_VOTE_RESULT_YES) :
+        (prevote ? RAFT_PRE_VOTE_RESULT_NO : RAFT_VOTE_RESULT_NO);
+
+    int rc = raft_server_candidate_reg_vote_result(ri, sender_csn->csn_uuid,
+                                                   result);
+    if (rc)
+    {
+        DBG_RAFT_MSG(LL_ERROR, rrm,
+                     "raft_server_candidate_reg_vote_result() %s",
+                     strerror(-rc));
+        DBG_RAFT_INSTANCE(LL_ERROR, ri, "");
+
+        return;
+    }
+
+    switch (result)
+    {
+    case RAFT_PRE_VOTE_RESULT_YES:
+        // Enough votes to enter full candidate mode?
+        if (raft_server_prevote_candidate_can_become_candidate(ri))
+            raft_server_become_candidate(ri, false);
+        break;
+
+    case RAFT_PRE_VOTE_RESULT_NO:
+        // Peer reports a viable leader but we remain a skeptical candidate
+        break;
+
+    case RAFT_VOTE_RESULT_YES:
+        // Enough votes in this term to become leader?
+        if (raft_server_candidate_can_become_leader(ri))
+            raft_server_candidate_becomes_leader(ri);
+        break;
+
+    case RAFT_VOTE_RESULT_NO:
+        if (ri->ri_log_hdr.rlh_term < vreply->rvrpm_term)
+            // The peer has replied that our term is stale
+            raft_server_becomes_follower(
+                ri, vreply->rvrpm_term, vreply->rvrpm_current_leader,
+                RAFT_BFRSN_STALE_TERM_WHILE_CANDIDATE);
+        break;
+
+    default:
+        NIOVA_ASSERT(0);
+    }
+}
+
+/**
+ * raft_server_refresh_follower_prev_log_term - called while in leader mode,
+ *     this function performs the role of reading and storing the term value
+ *     for a given log index.  The index is determined by the follower's
+ *     'next-idx' value.  The prev_log_term value for the next-index - 1 is
+ *     stored in the raft leader structure.  This is so that retries for the
+ *     same append entry do not incur extra I/O.
+ * @ri:  raft instance
+ * @follower:  the numeric position of the follower peer
+ */
+static raft_server_leader_mode_int_t
+raft_server_refresh_follower_prev_log_term(struct raft_instance *ri,
+                                           const raft_peer_t follower)
+{
+    NIOVA_ASSERT(ri && ri->ri_csn_raft &&
+                 raft_member_idx_is_valid(ri, follower));
+
+    NIOVA_ASSERT(raft_instance_is_leader(ri));
+
+    struct raft_follower_info *rfi =
+        raft_server_get_follower_info(ri, follower);
+
+    NIOVA_ASSERT(rfi->rfi_next_idx >= 0);
+
+//    const raft_entry_idx_t lowest_idx = niova_atomic_read(&ri->ri_lowest_idx);
+
+    const raft_entry_idx_t my_raft_idx =
+        raft_server_get_current_raft_entry_index(ri, RI_NEHDR_UNSYNC);
+
+    // next_idx of '0' means no blocks have ever been written.
+    if (rfi->rfi_next_idx == 0)
+    {
+        rfi->rfi_prev_idx_term = 0;
+        rfi->rfi_current_idx_term = -1;
+    }
+
+    const bool refresh_prev = rfi->rfi_prev_idx_term < 0 ? true : false;
+#if 0
+    const bool refresh_current =
+        (my_raft_idx >= rfi->rfi_next_idx &&
+         (refresh_prev || rfi->rfi_current_idx_term < 0)) ? true : false;
+#else
+    const bool refresh_current = my_raft_idx >=
+        rfi->rfi_next_idx ? true : false;
+#endif
+
+    struct raft_entry_header reh = {0};
+
+    if (refresh_prev)
+    {
+        const int64_t follower_prev_entry_idx = rfi->rfi_next_idx - 1;
+
+        NIOVA_ASSERT(follower_prev_entry_idx >= -1);
+
+        // Test that the follower's prev-idx is not ahead of this leader's idx
+        NIOVA_ASSERT(follower_prev_entry_idx <= my_raft_idx);
+
+        int rc = raft_server_entry_header_read(ri, &reh,
+                                               follower_prev_entry_idx);
+        if (rc < 0)
+        {
+            rfi->rfi_prev_idx_term = 0;
+            rfi->rfi_prev_idx_crc = 0;
+            return rc;
+        }
+
+        DBG_RAFT_ENTRY_FATAL_IF((reh.reh_term < 0), &reh,
+                                "invalid reh.reh_term=%ld", reh.reh_term);
+
+        rfi->rfi_prev_idx_term = reh.reh_term;
+        rfi->rfi_prev_idx_crc = reh.reh_crc;
+    }
+
+    if (refresh_current)
+    {
+        NIOVA_ASSERT(my_raft_idx >= rfi->rfi_next_idx);
+
+        int rc = raft_server_entry_header_read(ri, &reh, rfi->rfi_next_idx);
+        if (rc < 0)
+        {
+            rfi->rfi_current_idx_term = -1;
+            rfi->rfi_current_idx_crc = 0;
+            return rc;
+        }
+        else
+        {
+            rfi->rfi_current_idx_term = reh.reh_term;
+            rfi->rfi_current_idx_crc = reh.reh_crc;
+        }
+    }
+
+    DBG_RAFT_INSTANCE(
+        ((refresh_prev || refresh_current) ? LL_DEBUG : LL_TRACE), ri,
+        "peer=%hhx refresh=%d:%d pti=%ld:%ld si=%ld ct=%ld ccrc=%lu",
+        follower, refresh_prev, refresh_current, rfi->rfi_prev_idx_term,
+        rfi->rfi_next_idx, rfi->rfi_synced_idx, rfi->rfi_current_idx_term,
+        rfi->rfi_current_idx_crc);
+
+    return 0;
+}
+
+static raft_server_leader_mode_int64_t
+raft_server_leader_get_current_term(const struct raft_instance *ri)
+{
+    NIOVA_ASSERT(ri && raft_instance_is_leader(ri));
+    NIOVA_ASSERT(ri->ri_leader.rls_leader_term == ri->ri_log_hdr.rlh_term);
+
+    return ri->ri_log_hdr.rlh_term;
+}
+
+static raft_server_leader_mode_int_t
+raft_server_leader_init_append_entry_msg(struct raft_instance *ri,
+                                         struct raft_rpc_msg *rrm,
+                                         const raft_peer_t follower,
+                                         bool heartbeat)
+{
+    NIOVA_ASSERT(ri && ri->ri_csn_raft && rrm &&
+                 raft_member_idx_is_valid(ri, follower));
+
+    memset(rrm, 0, sizeof(*rrm));
+
+    const struct raft_follower_info *rfi =
+        raft_server_get_follower_info(ri, follower);
+
+    rrm->rrm_type = RAFT_RPC_MSG_TYPE_APPEND_ENTRIES_REQUEST;
+    rrm->rrm_version = 0;
+
+    raft_server_set_uuids_in_rpc_msg(ri, rrm);
+
+    struct raft_append_entries_request_msg *raerq =
+        &rrm->rrm_append_entries_request;
+
+    int rc = raft_server_refresh_follower_prev_log_term(ri, follower);
+    if (rc == -ERANGE)
+    {
+        // Convert this into heartbeat
+        heartbeat = true;
+    }
+    else if (rc) // Accept only ERANGE
+    {
+        DBG_RAFT_INSTANCE(LL_FATAL, ri,
+                          "raft_server_refresh_follower_prev_log_term(): %s",
+                          strerror(-rc));
+    }
+
+    raerq->raerqm_heartbeat_msg = heartbeat ? 1 : 0;
+    raerq->raerqm_entry_out_of_range = (rc == -ERANGE) ? 1 : 0;
+
+    raerq->raerqm_leader_term = raft_server_leader_get_current_term(ri);
+    raerq->raerqm_commit_index = ri->ri_commit_idx;
+    raerq->raerqm_entries_sz = 0;
+    raerq->raerqm_num_entries = 0;
+    raerq->raerqm_leader_change_marker = 0;
+    raerq->raerqm_lowest_index = niova_atomic_read(&ri->ri_lowest_idx);
+    raerq->raerqm_chkpt_index = ri->ri_checkpoint_last_idx;
+    memset(raerq->raerqm_size_arr, 0,
+           (sizeof(uint32_t) * RAFT_ENTRY_NUM_ENTRIES));
+
+    // There are only 2 possible error codes at this point
+    NIOVA_ASSERT(!rc || rc == -ERANGE);
+
+    if (!rc)
+    {
+        raerq->raerqm_log_term = rfi->rfi_current_idx_term;
+        raerq->raerqm_this_idx_crc = rfi->rfi_current_idx_crc;
+        raerq->raerqm_prev_idx_crc = rfi->rfi_prev_idx_crc;
+    }
+
+    // Previous log index is the address of the follower's last write.
+    raerq->raerqm_prev_log_index = rfi->rfi_next_idx - 1;
+
+    // Copy the rls_prev_idx_term[] if it was refreshed above.
+    raerq->raerqm_prev_log_term = rc ? -1LL : rfi->rfi_prev_idx_term;
+
+    // If error, return -ESTALE to signify that the peer needs bulk recovery
+    return rc ? -ESTALE : 0;
+}
+
+static raft_server_epoll_remote_sender_t
+raft_server_append_entry_sender(struct raft_instance *ri, bool heartbeat);
+
+static raft_net_timerfd_cb_ctx_t
+raft_server_issue_heartbeat(struct raft_instance *ri)
+{
+    NIOVA_ASSERT(ri && ri->ri_csn_this_peer);
+    NIOVA_ASSERT(raft_instance_is_leader(ri));
+
+    raft_server_append_entry_sender(ri, true);
+}
+
+static void
+raft_server_co_wr_reset(struct raft_instance_co_wr *co_wr)
+{
+    raft_net_sm_write_supplement_destroy(&co_wr->rcwi_ws);
+
+    // The size array lives behind the buffer and is kept
+    uint32_t *entry_sizes = co_wr->rcwi_entry_sizes;
+    memset(co_wr, 0, sizeof(struct raft_instance_co_wr));
+    co_wr->rcwi_entry_sizes = entry_sizes;
+}
+
+/*
+ * Write all the coalesced write entries.  'reason' is accounted in the
+ * flush counters unless it's RAFT_CO_WR_FLUSH_NONE.
+ */
+static void
+raft_server_write_coalesced_entries(struct raft_instance *ri,
+                                    const char *caller_fn,
+                                    enum raft_co_wr_flush_reason reason)
+{
+    DBG_RAFT_INSTANCE(LL_DEBUG, ri, "%s: nent=%u tsz=%zu reason=%d",
+                      caller_fn, ri->ri_coalesced_wr->rcwi_nentries,
+                      ri->ri_coalesced_wr->rcwi_total_size, reason);
+
+    if (!ri->ri_coalesced_wr->rcwi_nentries)
+        return;
+
+    if (reason < RAFT_CO_WR_FLUSH_MAX)
+        ri->ri_co_wr_flush_cnt[reason]++;
+
+    // Nothing will be pending, a stale deadline would only cause a wakeup
+    raft_leader_timer_cancel(ri, RAFT_LEADER_TIMER_CO_WR);
+
+    struct raft_instance_co_wr *co_wr = ri->ri_coalesced_wr;
+
+    /* Batches which exceed the v1 header table are written as v2 entries
+     * whose sub-entry table leads the data.  The table is gathered from the
+     * size array by the backend write.
+     */
+    const struct raft_entry_sub_table rest = {
+        .rest_num_entries = co_wr->rcwi_nentries,
+    };
+    struct iovec iov[3];
+    size_t niov = 0;
+
+    if (co_wr->rcwi_nentries > RAFT_ENTRY_NUM_ENTRIES)
+    {
+        iov[niov].iov_base = (void *)&rest;
+        iov[niov++].iov_len = sizeof(rest);
+        iov[niov].iov_base = co_wr->rcwi_entry_sizes;
+        iov[niov++].iov_len = sizeof(uint32_t) * co_wr->rcwi_nentries;
+    }
+
+    iov[niov].iov_base = co_wr->rcwi_buffer;
+    iov[niov++].iov_len = co_wr->rcwi_total_size;
+
+    raft_server_leader_write_new_entry(ri, iov, niov, co_wr->rcwi_entry_sizes,
+                                       co_wr->rcwi_nentries,
+                                       RAFT_WR_ENTRY_OPT_NONE,
+                                       &co_wr->rcwi_ws);
+
+    raft_server_co_wr_reset(co_wr);
+}
+
+static raft_net_timerfd_cb_ctx_bool_t
+raft_leader_check_quorum(struct raft_instance *ri);
+
+static raft_net_timerfd_cb_ctx_t
+raft_server_increment_leader_time(struct raft_instance *ri)
+{
+    if (ri == NULL || !raft_instance_is_leader(ri))
+        return;
+
+    struct raft_leader_state *rls = &ri->ri_leader;
+
+    struct timespec now;
+    niova_unstable_coarse_clock(&now);
+
+    NIOVA_ASSERT(timespeccmp(&now, &rls->rls_leader_start, >=));
+
+    timespecsub(&now, &rls->rls_leader_start, &rls->rls_leader_accumulated);
+}
+
+/**
+ * raft_server_timerfd_leader_cb - runs the leader's work whose deadlines have
+ *    passed.  The periodic deadlines are rearmed relative to this wakeup,
+ *    the timerfd itself is rearmed by raft_server_timerfd_settime().
+ */
+static raft_net_timerfd_cb_ctx_t
+raft_server_timerfd_leader_cb(struct raft_instance *ri)
+{
+    struct timespec now;
+    niova_unstable_clock(&now);
+
+    enum raft_leader_timer_type type;
+    bool co_wr_expired = false;
+
+    while (raft_leader_timer_pop_expired(ri, &now, &type))
+    {
+        switch (type)
+        {
+        case RAFT_LEADER_TIMER_QUORUM:
+            if (!raft_leader_check_quorum(ri)) // bail on quorum loss
+                return raft_server_become_candidate(ri, true);
+
+            raft_leader_timer_arm_periodic(ri, type, &now, true);
+            break;
+
+        case RAFT_LEADER_TIMER_HEARTBEAT:
+            raft_server_issue_heartbeat(ri);
+            raft_leader_timer_arm_periodic(ri, type, &now, true);
+            break;
+
+        case RAFT_LEADER_TIMER_CO_WR:
+            raft_server_leader_co_wr_timer_expired(ri);
+            co_wr_expired = true;
+            break;
+
+        default:
+            break;
+        }
+    }
+
+    /* Writes which could not be issued, such as while this leader is not yet
+     * fresh, are retried after RAFT_LEADER_WAKEUP_MS.
+     */
+    if (co_wr_expired && ri->ri_coalesced_wr &&
+        ri->ri_coalesced_wr->rcwi_nentries)
+    {
+        struct timespec retry;
+        msec_2_timespec(&retry, RAFT_LEADER_WAKEUP_MS);
+        timespecadd(&retry, &now, &retry);
+
+        raft_leader_timer_arm(ri, RAFT_LEADER_TIMER_CO_WR, &retry);
+    }
+
+    raft_server_increment_leader_time(ri);
+}
+
+static raft_net_timerfd_cb_ctx_t
+raft_server_timerfd_cb(struct raft_instance *ri)
+{
+    FUNC_ENTRY(LL_TRACE);
+
+    switch (ri->ri_state)
+    {
+    case RAFT_STATE_FOLLOWER: // fall through
+    case RAFT_STATE_CANDIDATE_PREVOTE: // fall through
+    case RAFT_STATE_CANDIDATE:
+        raft_server_become_candidate(ri, true);
+        break;
+
+    case RAFT_STATE_LEADER:
+        raft_server_timerfd_leader_cb(ri);
+        break;
+
+    default:
+        break;
+    }
+
+    raft_server_timerfd_settime(ri);
+}
+
+/**
+ * raft_server_process_vote_request_decide - determine if this peer should
+ *    vote for the candidate.
+ */
+static bool
+raft_server_process_vote_request_decide(
+    const struct raft_instance *ri, const struct raft_vote_request_msg *vreq,
+    const struct raft_entry_header *cmp_hdr)
+{
+    NIOVA_ASSERT(ri && vreq && cmp_hdr);
+
+    // "allow at most one winner per term"
+    return (vreq->rvrqm_proposed_term <= ri->ri_log_hdr.rlh_term ||
+            vreq->rvrqm_last_log_term < cmp_hdr->reh_term ||
+            vreq->rvrqm_last_log_index < cmp_hdr->reh_index) ? false : true;
+}
+
+static bool
+raft_server_process_pre_vote_request_decide(
+    const struct raft_instance *ri, const struct raft_vote_request_msg *vreq,
+    const struct raft_entry_header *cmp_hdr)
+{
+    NIOVA_ASSERT(ri && vreq && cmp_hdr);
+
+    /* First, check the typical vote conditions - these are prerequisites for
+     * continuing...
+     * If the proposed term value is > (current-term + 1) then we must allow
+     * the PreVote to proceed so that the cluster can negotiate a higher term
+     * value, which the preVote candidate has already applied.  Otherwise,
+     * leaders and followers always vote 'no'.  Leader's assume they are alive
+     * (XXX CheckQuorum is needed, however) and followers will remain so until
+     * their own AE timeouts expire.
+     */
+    if (raft_server_process_vote_request_decide(ri, vreq, cmp_hdr) &&
+        (
+            // 1. prevote candidate already persisted a higher term, vote yes
+            (vreq->rvrqm_proposed_term > (ri->ri_log_hdr.rlh_term + 1)) ||
+
+            // 2. cluster leadership is in question, indicated by our own state
+            (!ri->ri_csn_leader ||
+             raft_instance_is_candidate(ri) ||
+             raft_instance_is_candidate_prevote(ri)))
+        )
+        return true;
+
+    return false;
+}
+
+static raft_server_net_cb_ctx_t
+raft_server_process_vote_request_common(struct raft_instance *ri,
+                                        struct ctl_svc_node *sender_csn,
+                                        const struct raft_rpc_msg *rrm)
+{
+    NIOVA_ASSERT(ri && sender_csn && rrm);
+    NIOVA_ASSERT(rrm->rrm_type == RAFT_RPC_MSG_TYPE_PRE_VOTE_REQUEST ||
+                 rrm->rrm_type == RAFT_RPC_MSG_TYPE_VOTE_REQUEST);
+
+    // The caller *should* have already checked this.
+    NIOVA_ASSERT(!ctl_svc_node_compare_uuid(sender_csn, rrm->rrm_sender_id));
+
+    const struct raft_vote_request_msg *vreq = &rrm->rrm_vote_request;
+    const bool prevote = rrm->rrm_type == RAFT_RPC_MSG_TYPE_PRE_VOTE_REQUEST ?
+        true : false;
+
+    struct raft_rpc_msg rreply_msg = {0};
+
+    // Make a decision based on the synced status of the log
+    raft_server_backend_sync_pending(ri, __func__);
+
+    struct raft_entry_header sync_hdr = {0};
+    raft_instance_get_newest_header(ri, &sync_hdr, RI_NEHDR_SYNC);
+
+    // Do some initialization on the reply message.
+    raft_server_set_uuids_in_rpc_msg(ri, &rreply_msg);
+
+    rreply_msg.rrm_type = prevote ?
+        RAFT_RPC_MSG_TYPE_PRE_VOTE_REPLY : RAFT_RPC_MSG_TYPE_VOTE_REPLY;
+
+    rreply_msg.rrm_vote_reply.rvrpm_term = ri->ri_log_hdr.rlh_term;
+
+    // Obtain the vote or prevote result
+    const bool result = prevote ?
+        raft_server_process_pre_vote_request_decide(ri, vreq, &sync_hdr) :
+        raft_server_process_vote_request_decide(ri, vreq, &sync_hdr);
+
+    // Set the vote result
+    rreply_msg.rrm_vote_reply.rvrpm_voted_granted = !!result;
+
+    // Tell the candidate of our current leader if voting 'no'
+    if (!result && ri->ri_csn_leader)
+        uuid_copy(rreply_msg.rrm_vote_reply.rvrpm_current_leader,
+                  ri->ri_csn_leader->csn_uuid);
+
+    enum log_level level = prevote ? LL_NOTIFY : LL_WARN;
+    DBG_RAFT_MSG(level, rrm, "vote=%s my term=%ld last=%ld:%ld",
+                 rreply_msg.rrm_vote_reply.rvrpm_voted_granted ? "yes" : "no",
+                 ri->ri_log_hdr.rlh_term, sync_hdr.reh_term,
+                 sync_hdr.reh_index);
+    DBG_RAFT_INSTANCE(level, ri, "");
+
+    // Sync our log header only if this is a real election and we vote 'yes'
+    if (!prevote && result)
+        raft_server_becomes_follower(ri, vreq->rvrqm_proposed_term,
+                                     rrm->rrm_sender_id,
+                                     RAFT_BFRSN_VOTED_FOR_PEER);
+
+    // Reply to the candidate
+    int rc = raft_server_send_msg(ri, RAFT_UDP_LISTEN_SERVER, sender_csn,
+                                  &rreply_msg);
+    if (rc)
+        DBG_RAFT_INSTANCE(LL_NOTIFY, ri, "raft_server_send_msg(): %s",
+                          strerror(-rc));
+}
+
+/**
+ * raft_server_append_entry_check_already_stored - this function takes an
+ *    AE request msg and reads the log to determine if the entry had been
+ *    stored at an earlier time.  This function is called when the follower
+ *    detects that its log index is > than the index value in the AE request.
+ *    AFAICT, this situation can occur in two instances:  first, when the
+ *    follower was either a deposed leader or follower of a deposed leader and
+ *    it accepted entries which the new leader does not possess (rollback);
+ *    or secondly, an old / retried / stale AE request arrives at this follower
+ *    for an index which had already been written.
+ */
+static raft_server_net_cb_follower_ctx_bool_t
+raft_server_append_entry_check_already_stored(
+    struct raft_instance *ri,
+    const struct raft_append_entries_request_msg *raerq)
+{
+    NIOVA_ASSERT(ri && raerq);
+    NIOVA_ASSERT(raft_instance_is_follower(ri));
+
+    if (raerq->raerqm_entry_out_of_range)
+        return false;
+
+    // raerqm_prev_log_index can be -1 if no writes have ever been done.
+    NIOVA_ASSERT(raerq->raerqm_prev_log_index >= RAFT_MIN_APPEND_ENTRY_IDX);
+
+    const raft_entry_idx_t raft_current_idx =
+        raft_server_get_current_raft_entry_index(ri, RI_NEHDR_UNSYNC);
+
+    const raft_entry_idx_t leaders_next_idx_for_me =
+        raerq->raerqm_prev_log_index + 1;
+
+    // The condition for entering this function should have been checked prior.
+    NIOVA_ASSERT(raft_current_idx >= leaders_next_idx_for_me);
+
+    struct raft_entry_header reh = {0};
+
+    /* In a corner-case, the leader's msg may be stale and contain contents
+     * from a period where this peer and the leader were caught up.  As a
+     * result, the current log_term would not exist and we should not read
+     * this block.
+     */
+    if (raerq->raerqm_log_term > 0)
+    {
+        int rc = raft_server_entry_header_read_by_store(
+            ri, &reh, leaders_next_idx_for_me);
+
+        FATAL_IF((rc), "raft_server_header_entry_read(): %s", strerror(-rc));
+
+        if (reh.reh_term != raerq->raerqm_log_term)
+            return false;
+
+        FATAL_IF((!raerq->raerqm_entry_out_of_range &&
+                  raerq->raerqm_this_idx_crc != reh.reh_crc &&
                   !raerq->raerqm_heartbeat_msg),
                  "crc (%u) does not match leader (%u) for idx=%ld,"
                  " is_heartbeat=%d",
                  reh.reh_crc, raerq->raerqm_this_idx_crc,
-                 leaders_next_idx_for_me,
-                 raerq->raerqm_heartbeat_msg);
+                 leaders_next_idx_for_me,
+                 raerq->raerqm_heartbeat_msg);
+    }
+    else
+    {
+        DBG_RAFT_INSTANCE(
+            LL_WARN, ri,
+            "negative log-term %ld rci=%ld leader-prev-[idx:term]=%ld:%ld",
+            raerq->raerqm_log_term, raft_current_idx,
+            raerq->raerqm_prev_log_index, raerq->raerqm_prev_log_term);
+    }
+    /* Check raerq->raerqm_prev_log_term - this is more of a sanity check to
+     * ensure that the verified idx, leaders_next_idx_for_me, proceeds a valid
+     * term of the prev-idx.
+     */
+    if (raerq->raerqm_prev_log_index >= 0)
+    {
+        int rc = raft_server_entry_header_read_by_store(
+            ri, &reh, raerq->raerqm_prev_log_index);
+
+        FATAL_IF((rc), "raft_server_entry_read(): %s", strerror(-rc));
+        FATAL_IF((reh.reh_term != raerq->raerqm_prev_log_term),
+                 "raerq->raerqm_prev_log_term=%ld != reh.reh_term=%ld",
+                 raerq->raerqm_prev_log_term, reh.reh_term);
+        FATAL_IF((raerq->raerqm_prev_idx_crc != reh.reh_crc),
+                 "crc (%u) does not match leader (%u) for idx=%ld",
+                 reh.reh_crc, raerq->raerqm_this_idx_crc,
+                 raerq->raerqm_prev_log_index);
+    }
+
+    DBG_RAFT_INSTANCE(
+        LL_DEBUG, ri,
+        "already-stored=yes rci=%ld leader-prev-[idx:term]=%ld:%ld",
+        raft_current_idx, raerq->raerqm_prev_log_index,
+        raerq->raerqm_prev_log_term);
+
+    return true;
+}
+
+/**
+ * raft_server_append_entry_log_prune_if_needed - the local raft instance's
+ *    log may need to be pruned if it extends beyond the prev_log_index
+ *    presented by our leader.  Follower-ctx is assert here.
+ */
+static raft_server_net_cb_follower_ctx_t
+raft_server_append_entry_log_prune_if_needed(
+    struct raft_instance *ri,
+    const struct raft_append_entries_request_msg *raerq)
+{
+    NIOVA_ASSERT(ri && raerq);
+    NIOVA_ASSERT(raft_instance_is_follower(ri));
+    // This value must have already been checked by the caller.
+    NIOVA_ASSERT(raerq->raerqm_prev_log_index >= RAFT_MIN_APPEND_ENTRY_IDX);
+
+    const int64_t raft_entry_idx_prune = raerq->raerqm_prev_log_index + 1;
+
+    /* Forcing a sync here will prevent the sync-thread from persisting new
+     * log entries which may be beyond raerqm_prev_log_index (which is where
+     * we're truncating to..).
+     */
+    int rc = raft_server_backend_sync(ri, __func__);
+    DBG_RAFT_INSTANCE_FATAL_IF((rc), ri, "raft_server_backend_sync(): %s",
+                               strerror(-rc));
+
+    DBG_RAFT_INSTANCE(LL_WARN, ri,
+                      "raerqm_prev_log_term=%ld raerqm_prev_log_index=%ld",
+                      raerq->raerqm_prev_log_term,
+                      raerq->raerqm_prev_log_index);
+
+    // We must not prune already committed transactions.
+    DBG_RAFT_INSTANCE_FATAL_IF(
+        (ri->ri_commit_idx >= raft_entry_idx_prune ||
+         ri->ri_last_applied.rla_idx >= raft_entry_idx_prune),
+        ri, "cannot prune committed entry raerq-nli=%ld",
+        raft_entry_idx_prune);
+
+    if (raerq->raerqm_prev_log_index >= 0)
+    {
+        struct raft_entry_header reh;
+
+        /* Read the block at the leader's index and apply it to our header.
+         * We don't call raft_server_entry_next_entry_is_valid() since the log
+         * sequence had been verified already at startup.
+         */
+        int rc = raft_server_entry_header_read_by_store(
+            ri, &reh, raerq->raerqm_prev_log_index);
+
+        FATAL_IF((rc), "raft_server_entry_header_read_by_store(): %s",
+                 strerror(-rc));
+
+        raft_instance_update_newest_entry_hdr(ri, &reh, RI_NEHDR_ALL, true);
+    }
+
+    // truncate the log.
+    raft_server_log_truncate(ri);
+}
+
+static raft_server_net_cb_follower_ctx_int_t
+raft_server_follower_index_ahead_of_leader(
+    struct raft_instance *ri,
+    const struct raft_append_entries_request_msg *raerq,
+    struct raft_entry_header *reh)
+{
+    NIOVA_ASSERT(ri && raerq && reh);
+
+    int rc = 0;
+
+    /* If this follower's index is ahead of the leader's then we must check
+     * for a retried AE which has already been stored in our log.
+     * Note that this AE may have been delayed in the network or may have
+     * retried due to a dropped reply.  It's important that we try to ACK
+     * this request and not proceed with modifying our log.
+     */
+    if (raft_server_append_entry_check_already_stored(ri, raerq))
+    {
+        rc = -EALREADY;
+    }
+    else // Otherwise, the log needs to be pruned.
+    {
+        raft_server_append_entry_log_prune_if_needed(ri, raerq);
+        NIOVA_ASSERT(!raft_server_has_unsynced_entries(ri));
+    }
+    /* The log may have been synced and/or pruned - re-obtain the
+     * current_idx.
+     * Note:  if a sync occurred then the synced idx will be equivalent to
+     *        the unsynced idx.
+     */
+    raft_instance_get_newest_header(ri, reh, RI_NEHDR_SYNC);
+
+    return rc;
+}
+
+/**
+ * raft_server_append_entry_request_bounds_check - helper function used to
+ *    detect the case where a follower has undergone bulk recovery but the leader
+ *    still contains prev-log-index info from the follower's pre-recovery
+ *    state.  This function prevents the follower from executing log reads
+ *    which will fail since the requested entry does not exist on the follower.
+ */
+static raft_server_net_cb_follower_ctx_int_t
+raft_server_append_entry_request_bounds_check(
+    struct raft_instance *ri,
+    const struct raft_append_entries_request_msg *raerq)
+{
+    NIOVA_ASSERT(ri && raerq);
+
+    const struct raft_rpc_msg *rrm =
+        OFFSET_CAST(raft_rpc_msg, rrm_append_entries_request, raerq);
+
+    /* Sanity check the leader's request.  If the leader's lowest index is
+     * higher than the pli then don't proceed with this msg.
+     */
+    if (raerq->raerqm_prev_log_index != RAFT_ENTRY_IDX_ANY &&
+        raerq->raerqm_prev_log_index < raerq->raerqm_lowest_index)
+    {
+        DBG_RAFT_MSG(LL_WARN, rrm, "pli < leader-lowest-idx");
+        return -EBADR;
+    }
+    // Don't proceed if we will be unable to read the requested index
+    else if (raerq->raerqm_prev_log_index <
+             niova_atomic_read(&ri->ri_lowest_idx))
+    {
+        DBG_RAFT_MSG(LL_WARN, rrm, "pli < my-lowest-idx (%lld)",
+                     niova_atomic_read(&ri->ri_lowest_idx));
+        return -EBADR;
+    }
+    else if (raerq->raerqm_entry_out_of_range)
+    {
+        DBG_RAFT_MSG(LL_WARN, rrm, "leader read failed with -ERANGE");
+        return -EBADR;
+    }
+
+    return 0;
+}
+
+/**
+ * raft_server_append_entry_log_prepare_and_check - determine if the current
+ *    append entry command can proceed to this follower's log.  This function
+ *    returns two errors to the caller but in both cases the caller will
+ *    reply to the leader with the "general" error 'non_matching_prev_term'.
+ *    causing the leader to decrement its prev_log_index value for this
+ *    follower and retry.  NOTE:  this function will truncate / prune the log
+ *    according to the index value presented in the raerq.
+ */
+static raft_server_net_cb_follower_ctx_int_t
+raft_server_append_entry_log_prepare_and_check(
+    struct raft_instance *ri,
+    const struct raft_append_entries_request_msg *raerq)
+{
+    NIOVA_ASSERT(ri && raerq);
+
+    int rc = raft_server_append_entry_request_bounds_check(ri, raerq);
+    if (rc)
+        return rc;
+
+    struct raft_entry_header reh = {0};
+    raft_instance_get_newest_header(ri, &reh, RI_NEHDR_UNSYNC);
+
+    // raft_server_follower_index_ahead_of_leader() may update reh
+    rc = (reh.reh_index > raerq->raerqm_prev_log_index) ?
+        raft_server_follower_index_ahead_of_leader(ri, raerq, &reh) : 0;
+
+    if (rc)
+        return rc;
+
+    // At this point, current_idx should not exceed the one from the leader.
+    NIOVA_ASSERT(reh.reh_index <= raerq->raerqm_prev_log_index);
+
+    /* In this case, the leader's and follower's indexes have yet to converge
+     * which implies a "non_matching_prev_term" since the term isn't testable
+     * until the indexes match.
+     */
+    if (reh.reh_index < raerq->raerqm_prev_log_index)
+        rc = -ERANGE;
+
+    /* Equivalent log indexes but the terms do not match.  Note that this cond
+     * will likely lead to more pruning as the leader continues to decrement
+     * its raerqm_prev_log_index value for this follower.
+     */
+    else if (reh.reh_term != raerq->raerqm_prev_log_term)
+        rc = -EEXIST;
+
+    DBG_RAFT_INSTANCE((raerq->raerqm_heartbeat_msg ? LL_DEBUG : LL_NOTIFY), ri,
+                      "rci=%ld leader-prev-[idx:term]=%ld:%ld (erange=%hhu) rc=%d",
+                      reh.reh_index, raerq->raerqm_prev_log_index,
+                      raerq->raerqm_prev_log_term,
+                      raerq->raerqm_entry_out_of_range, rc);
+
+    return rc;
+}
+
+/**
+ * raft_server_process_append_entries_term_check_ops - this function handles
+ *    important details for the AE request.  It will return -ESTALE if the
+ *    sender is not a valid leader (per term check).  Once the term has been
+ *    validated, this function will take care of self-demotion (if this
+ *    instance is a candidate) and will sync the term number to the log header
+ *    if the provided term had not yet been seen.  Lastly, it will apply the
+ *    csn pointer to the raft-instance if the leader is newly minted.
+ * @ri:  raft instance
+ * @sender_csn:  the ctl-svc-node for sender of the AE request.
+ * @raerq:  contents of the AE message.
+ */
+static raft_server_net_cb_ctx_int_t
+raft_server_process_append_entries_term_check_ops(
+    struct raft_instance *ri,
+    struct ctl_svc_node *sender_csn,
+    const struct raft_append_entries_request_msg *raerq)
+{
+    NIOVA_ASSERT(ri && sender_csn && raerq);
+
+    // My term is newer which means this sender is a stale leader.
+    if (ri->ri_log_hdr.rlh_term > raerq->raerqm_leader_term)
+        return -ESTALE;
+
+    const int64_t leader_term = raerq->raerqm_leader_term;
+
+    // -- Sender's term is greater than or equal to my own --
+
+    // Demote myself if candidate
+    if (ri->ri_log_hdr.rlh_term <= leader_term &&
+        (raft_instance_is_candidate(ri) ||
+         raft_instance_is_candidate_prevote(ri)))
+        raft_server_becomes_follower(ri, leader_term, sender_csn->csn_uuid,
+                                     RAFT_BFRSN_STALE_TERM_WHILE_CANDIDATE);
+
+    // Demote myself if stale leader
+    else if (ri->ri_log_hdr.rlh_term < leader_term &&
+             raft_instance_is_leader(ri))
+        raft_server_becomes_follower(ri, leader_term, sender_csn->csn_uuid,
+                                     RAFT_BFRSN_STALE_TERM_WHILE_LEADER);
+
+    // Follower detects leader with a higher term
+    else if (ri->ri_log_hdr.rlh_term < leader_term &&
+             raft_instance_is_follower(ri))
+        raft_server_try_update_log_header_null_voted_for_peer(ri, leader_term);
+
+    // Apply leader csn pointer
+    raft_server_set_leader_csn(ri, sender_csn);
+
+    return 0;
+}
+
+/**
+ * raft_server_write_packed_entries_from_leader - writes the indexes which
+ *    follow (prev_log_index + 1) in a packed AE request.  Each packed index
+ *    must directly follow the one before it and may not regress in term.
+ *    Processing stops at the first index which fails these checks, the
+ *    leader will resend from there.  Returns the number of indexes written.
+ */
+static raft_server_net_cb_follower_ctx_int_t
+raft_server_write_packed_entries_from_leader(
+    struct raft_instance *ri,
+    const struct raft_append_entries_request_msg *raerq)
+{
+    NIOVA_ASSERT(ri && raerq);
+
+    int nwritten = 0;
+    size_t off = raerq->raerqm_first_idx_sz;
+
+    for (uint8_t i = 1; i < raerq->raerqm_num_idx; i++)
+    {
+        struct raft_entry_header reh;
+        struct raft_entry_header unsync_hdr = {0};
+
+        if ((off + sizeof(reh)) > raerq->raerqm_entries_sz)
+            break;
+
+        // The packed header may not be aligned within the payload
+        memcpy(&reh, &raerq->raerqm_entries[off], sizeof(reh));
+        off += sizeof(reh);
+
+        raft_instance_get_newest_header(ri, &unsync_hdr, RI_NEHDR_UNSYNC);
+
+        const struct iovec iov = {
+            .iov_base = (void *)&raerq->raerqm_entries[off],
+            .iov_len = reh.reh_data_size,
+        };
+        uint32_t nentries = reh.reh_num_entries;
+
+        if (reh.reh_index != (unsync_hdr.reh_index + 1) ||
+            reh.reh_term < unsync_hdr.reh_term ||
+            reh.reh_term > raerq->raerqm_leader_term ||
+            reh.reh_data_size > RAFT_ENTRY_MAX_DATA_SIZE(ri) ||
+            (off + reh.reh_data_size) > raerq->raerqm_entries_sz ||
+            (reh.reh_version == RAFT_ENTRY_HEADER_V2 ?
+             (reh.reh_num_entries || reh.reh_leader_change_marker ||
+              raft_server_entry_sub_table_check(iov.iov_base,
+                                                reh.reh_data_size,
+                                                &nentries)) :
+             (reh.reh_version != RAFT_ENTRY_HEADER_V1 ||
+              reh.reh_num_entries > RAFT_ENTRY_NUM_ENTRIES ||
+              reh.reh_data_size !=
+              raft_server_wr_entries_get_total_size(reh.reh_entry_sz,
+                                                    reh.reh_num_entries) ||
+              (reh.reh_leader_change_marker && reh.reh_num_entries != 1))))
+        {
+            DBG_RAFT_ENTRY(LL_WARN, &reh,
+                           "invalid packed entry (pos=%hhu unsync-idx=%ld)",
+                           i, unsync_hdr.reh_index);
+            break;
+        }
+
+        enum raft_write_entry_opts opts = reh.reh_leader_change_marker ?
+            RAFT_WR_ENTRY_OPT_LEADER_CHANGE_MARKER : RAFT_WR_ENTRY_OPT_NONE;
+
+        raft_server_write_next_entry(ri, reh.reh_term, &iov, 1,
+                                     reh.reh_entry_sz, nentries, opts, NULL);
+
+        off += reh.reh_data_size;
+        nwritten++;
+    }
+
+    return nwritten;
+}
+
+/**
+ * raft_server_write_new_entry_from_leader - the log write portion of the
+ *    AE operation.  The log index is derived from the raft-instance which
+ *    must match the index provided by the leader in raerq.  Returns the
+ *    number of raft indexes written, which may exceed '1' if the leader
+ *    packed several indexes into this request.
+ */
+static raft_server_net_cb_follower_ctx_int_t
+raft_server_write_new_entry_from_leader(
+    struct raft_instance *ri,
+    const struct raft_append_entries_request_msg *raerq)
+{
+    NIOVA_ASSERT(ri && raerq);
+    NIOVA_ASSERT(raft_instance_is_follower(ri));
+
+    if (raerq->raerqm_heartbeat_msg) // heartbeats don't enter the log
+        return 0;
+
+    struct raft_entry_header unsync_hdr = {0};
+    raft_instance_get_newest_header(ri, &unsync_hdr, RI_NEHDR_UNSYNC);
+
+    NIOVA_ASSERT(raerq->raerqm_log_term > 0);
+    NIOVA_ASSERT(raerq->raerqm_log_term >= raerq->raerqm_prev_log_term);
+    NIOVA_ASSERT(raerq->raerqm_log_term >= unsync_hdr.reh_term);
+
+    const size_t entry_size = raerq->raerqm_num_idx > 1 ?
+        raerq->raerqm_first_idx_sz : raerq->raerqm_entries_sz;
+    uint32_t num_entries = raerq->raerqm_num_entries;
+
+    // Msg size of '0' is OK.
+    NIOVA_ASSERT(entry_size <= RAFT_ENTRY_MAX_DATA_SIZE(ri));
+
+    // Sanity check on the 'next' idx to be written.
+    NIOVA_ASSERT(unsync_hdr.reh_index == raerq->raerqm_prev_log_index);
+
+    enum raft_write_entry_opts opts = raerq->raerqm_leader_change_marker ?
+        RAFT_WR_ENTRY_OPT_LEADER_CHANGE_MARKER : RAFT_WR_ENTRY_OPT_NONE;
+
+    if (opts & RAFT_WR_ENTRY_OPT_LEADER_CHANGE_MARKER)
+        NIOVA_ASSERT(num_entries == 1);
+
+    // A v2 entry carries its sub-entry table in place of the size array
+    if (!num_entries && entry_size)
+    {
+        int rc = raft_server_entry_sub_table_check(raerq->raerqm_entries,
+                                                   entry_size, &num_entries);
+        NIOVA_ASSERT(!rc); // checked with the rest of the AE request
+    }
+
+    const struct iovec iov = {
+        .iov_base = (void *)raerq->raerqm_entries,
+        .iov_len = entry_size,
+    };
+
+    raft_server_write_next_entry(ri, raerq->raerqm_log_term, &iov, 1,
+                                 raerq->raerqm_size_arr, num_entries, opts,
+                                 NULL);
+
+    return 1 + (raerq->raerqm_num_idx > 1 ?
+                raft_server_write_packed_entries_from_leader(ri, raerq) : 0);
+}
+
+/**
+ * raft_server_process_append_entries_request_prep_reply - helper function for
+ *    raft_server_process_append_entries_request() which does some general
+ *    AE reply setup.
+ */
+static raft_server_net_cb_ctx_t
+raft_server_process_append_entries_request_prep_reply(
+    struct raft_instance *ri, struct raft_rpc_msg *reply,
+    const struct raft_append_entries_request_msg *raerq,
+    bool stale_term, bool non_matching_prev_term, bool update_sli,
+    const int rc, const uint8_t num_idx)
+{
+    reply->rrm_type = RAFT_RPC_MSG_TYPE_APPEND_ENTRIES_REPLY;
+
+    reply->rrm_append_entries_reply.raerpm_leader_term =
+        ri->ri_log_hdr.rlh_term;
+
+    reply->rrm_append_entries_reply.raerpm_prev_log_index =
+        raerq->raerqm_prev_log_index;
+
+    reply->rrm_append_entries_reply.raerpm_heartbeat_msg =
+        raerq->raerqm_heartbeat_msg;
+
+    reply->rrm_append_entries_reply.raerpm_num_idx = num_idx;
+
+    const raft_entry_idx_t current_idx =
+        raft_server_get_current_raft_entry_index(ri, RI_NEHDR_SYNC);
+
+    struct raft_append_entries_reply_msg *rae_reply =
+        &reply->rrm_append_entries_reply;
+
+    /* Issue #27 - explicitly tell the leader if we're newly initialized
+     * to remove any ambiguity about the use of the raerpm_synced_log_index
+     * value.  `raerpm_newly_initialized_peer == 0` will allow the leader to
+     * set our next-idx to '0'.
+     */
+    rae_reply->raerpm_newly_initialized_peer =
+        current_idx == RAFT_ENTRY_IDX_ANY ? 1 : 0;
+
+    // Issue #27 - send synced-log-index in non_matching_prev_term case too
+    rae_reply->raerpm_synced_log_index =
+        (!rc || non_matching_prev_term) ? current_idx : RAFT_ENTRY_IDX_ANY;
+
+    raft_server_set_uuids_in_rpc_msg(ri, reply);
+
+    // update_sli takes priority over raerpm_err_non_matching_prev_term
+    rae_reply->raerpm_update_sli = update_sli;
+    rae_reply->raerpm_err_stale_term = stale_term;
+    rae_reply->raerpm_err_non_matching_prev_term = non_matching_prev_term;
+}
+
+static raft_server_net_cb_ctx_int_t
+raft_server_process_append_entries_request_validity_check(
+    const struct raft_instance *ri,
+    const struct raft_append_entries_request_msg *raerq)
+{
+    NIOVA_ASSERT(raerq);
+
+    // Do some basic verification of the AE msg contents.
+    if (raerq->raerqm_prev_log_index < RAFT_MIN_APPEND_ENTRY_IDX ||
+        raerq->raerqm_entries_sz > RAFT_ENTRY_MAX_DATA_SIZE(ri))
+        return -EINVAL;
+
+    // Packed requests must carry a valid (prev_log_index + 1) entry
+    if (raerq->raerqm_num_idx > 1 &&
+        (raerq->raerqm_num_idx > RAFT_SERVER_AE_PACKED_IDX_MAX ||
+         raerq->raerqm_first_idx_sz > raerq->raerqm_entries_sz))
+        return -EINVAL;
+
+    const uint32_t idx_sz = raerq->raerqm_num_idx > 1 ?
+        raerq->raerqm_first_idx_sz : raerq->raerqm_entries_sz;
+
+    if (raerq->raerqm_num_entries > RAFT_ENTRY_NUM_ENTRIES ||
+        (raerq->raerqm_num_entries &&
+         idx_sz != raft_server_wr_entries_get_total_size(
+             raerq->raerqm_size_arr, raerq->raerqm_num_entries)))
+        return -EINVAL;
+
+    /* Data without a size array is a v2 entry, (prev_log_index + 1) must
+     * then lead with an intact sub-entry table.
+     */
+    if (!raerq->raerqm_heartbeat_msg && !raerq->raerqm_num_entries &&
+        idx_sz && (raerq->raerqm_leader_change_marker ||
+                   raft_server_entry_sub_table_check(raerq->raerqm_entries,
+                                                     idx_sz, NULL)))
+        return -EINVAL;
+
+    return 0;
+}
+
+static raft_server_net_cb_ctx_t
+raft_server_advance_commit_idx(struct raft_instance *ri,
+                               const int64_t new_commit_idx)
+{
+    NIOVA_ASSERT(ri);
+
+    /* This peer may be behind, don't advance the commit index past our
+     * current raft index.
+     */
+    if (ri->ri_commit_idx < new_commit_idx &&
+        (raft_server_get_current_raft_entry_index(ri, RI_NEHDR_SYNC) >=
+         new_commit_idx))
+    {
+        DBG_RAFT_INSTANCE(LL_NOTIFY, ri, "new_commit_idx=%ld", new_commit_idx);
+
+        ri->ri_commit_idx = new_commit_idx;
+
+        RAFT_NET_EVP_NOTIFY_NO_FAIL(ri, RAFT_EVP_SM_APPLY);
+    }
+}
+
+static raft_server_net_cb_ctx_t
+raft_server_append_entry_reply_send(
+    struct raft_instance *ri,
+    const struct raft_append_entries_request_msg *raerq,
+    struct ctl_svc_node *sender_csn, bool stale_term,
+    bool non_matching_prev_term, bool update_sli, const int ae_rc,
+    const uint8_t num_idx)
+{
+    struct raft_rpc_msg rreply_msg = {0};
+
+    raft_server_process_append_entries_request_prep_reply(
+        ri, &rreply_msg, raerq, stale_term, non_matching_prev_term,
+        update_sli, ae_rc, num_idx);
+
+    int rc = raft_server_send_msg(ri, RAFT_UDP_LISTEN_SERVER, sender_csn,
+                                  &rreply_msg);
+
+    DBG_RAFT_INSTANCE_FATAL_IF((rc), ri, "raft_server_send_msg(): %s",
+                               strerror(rc));
+}
+
+int
+raft_server_init_recovery_handle_from_marker(struct raft_instance *ri,
+                                             const char *db_uuid_str,
+                                             const char *peer_uuid_str)
+{
+    if (!ri || !peer_uuid_str || !db_uuid_str)
+        return -EINVAL;
+
+    uuid_t peer_uuid, db_uuid;
+
+    if (uuid_parse(peer_uuid_str, peer_uuid) ||
+        uuid_parse(db_uuid_str, db_uuid) ||
+        uuid_is_null(peer_uuid) || uuid_is_null(db_uuid))
+        return -EINVAL;
+
+    struct raft_recovery_handle *rrh = raft_instance_2_recovery_handle(ri);
+
+    uuid_copy(rrh->rrh_peer_uuid, peer_uuid);
+    uuid_copy(rrh->rrh_peer_db_uuid, db_uuid);
+
+    rrh->rrh_peer_chkpt_idx = -1UL;
+    rrh->rrh_chkpt_size = -1UL;
+    rrh->rrh_remaining = -1UL;
+    rrh->rrh_from_recovery_marker = true;
+
+    niova_realtime_coarse_clock(&rrh->rrh_start);
+
+    return 0;
+}
+
+static void
+raft_server_init_recovery_handle(
+    struct raft_instance *ri,
+    const struct raft_append_entries_request_msg *raerq)
+{
+    NIOVA_ASSERT(ri && raerq);
+
+    const struct raft_rpc_msg *rrm =
+        OFFSET_CAST(raft_rpc_msg, rrm_append_entries_request, raerq);
+
+    struct raft_recovery_handle *rrh = &ri->ri_recovery_handle;
+
+    uuid_copy(rrh->rrh_peer_uuid, rrm->rrm_sender_id);
+    uuid_copy(rrh->rrh_peer_db_uuid, rrm->rrm_db_id);
+
+    rrh->rrh_peer_chkpt_idx = raerq->raerqm_chkpt_index;
+    rrh->rrh_chkpt_size = -1UL;
+    rrh->rrh_remaining = -1UL;
+    rrh->rrh_from_recovery_marker = false;
+
+    niova_realtime_coarse_clock(&rrh->rrh_start);
+}
+
+/**
+ * raft_server_process_bulk_recovery_check - this function compares the
+ *    current instance's newest entry idx with the leader's lowest available
+ *    index.
+ */
+static raft_server_net_cb_ctx_int_t
+raft_server_process_bulk_recovery_check(
+    struct raft_instance *ri,
+    const struct raft_append_entries_request_msg *raerq)
+{
+    NIOVA_ASSERT(ri && raerq);
+
+    int rc = 0;
+
+    const raft_entry_idx_t my_current_idx =
+        raft_server_get_current_raft_entry_index(ri, RI_NEHDR_UNSYNC);
+
+    if (raerq->raerqm_entry_out_of_range ||
+        FAULT_INJECT(raft_force_bulk_recovery))
+    {
+        if (my_current_idx >= raerq->raerqm_lowest_index)
+        {
+            DBG_RAFT_INSTANCE(
+                LL_WARN, ri,
+                "leader claims ERANGE but leader-lowest-idx=%ld < ei=%ld ldrpli=%ld",
+                raerq->raerqm_lowest_index, my_current_idx,
+                raerq->raerqm_prev_log_index);
+
+            // Try to notify the leader of our actual current idx
+            return -EAGAIN;
+        }
+
+        ri->ri_needs_bulk_recovery = true;
+        raft_server_init_recovery_handle(ri, raerq);
+
+        DBG_RAFT_INSTANCE(LL_WARN, ri,
+                          "needs bulk recovery (leader-lowest-idx=%ld)",
+                          raerq->raerqm_lowest_index);
+
+        rc = -ERANGE;
+    }
+
+    return rc;
+}
+
+static raft_server_net_cb_ctx_t
+raft_server_process_append_entries_request(struct raft_instance *ri,
+                                           struct ctl_svc_node *sender_csn,
+                                           const struct raft_rpc_msg *rrm)
+{
+    NIOVA_ASSERT(ri && sender_csn && rrm);
+    NIOVA_ASSERT(!ctl_svc_node_compare_uuid(sender_csn, rrm->rrm_sender_id));
+
+    DBG_RAFT_MSG(LL_DEBUG, rrm, "");
+
+    const struct raft_append_entries_request_msg *raerq =
+        &rrm->rrm_append_entries_request;
+
+    if (raft_server_process_append_entries_request_validity_check(ri, raerq))
+    {
+        DBG_RAFT_MSG(
+            LL_WARN, rrm,
+            "raft_server_process_append_entries_request_validity_check() err");
+        return;
+    }
+
+    // Determine if bulk recovery is needed AFTER validating the AE request
+    int rc = raft_server_process_bulk_recovery_check(ri, raerq);
+    if (rc && rc != -EAGAIN)
+        return;
+
+    bool update_sli = (rc == -EAGAIN) ? true : false;
+
+    // Candidate timer - reset if this operation is valid.
+    bool reset_timerfd = true;
+    bool fault_inject_ignore_ae = false;
+    bool stale_term = false;
+    bool non_matching_prev_term = false;
+    uint8_t num_idx = 0;
+
+    // Check if leader or candidate should step down OR sync new term value
+    rc = raft_server_process_append_entries_term_check_ops(ri, sender_csn,
+                                                           raerq);
+    if (rc)
+    {
+        NIOVA_ASSERT(rc == -ESTALE);
+        reset_timerfd = false;
+        stale_term = true;
+    }
+    /* sli updates inform the leader that its next-idx for this peer is
+     * outdated due to bulk recovery on this follower.  Before we attempt
+     * to do any further processing of this msg, send a reply back to the
+     * leader asking for it to update it's sli for this peer.
+     */
+    else if (!update_sli)
+    {
+        bool advance_commit_idx = false;
+        raft_entry_idx_t new_commit_idx = raerq->raerqm_commit_index;
+
+        rc = raft_server_append_entry_log_prepare_and_check(ri, raerq);
+        switch (rc)
+        {
+        case 0:
+            advance_commit_idx = true;
+            if (!raerq->raerqm_heartbeat_msg &&
+                !(fault_inject_ignore_ae =
+                      FAULT_INJECT(raft_follower_ignores_AE)))
+                num_idx = raft_server_write_new_entry_from_leader(ri, raerq);
+            break;
+
+        case -EBADR:
+            break; // simply reply to the server with our current info
+
+        case -EALREADY:
+            // Issue #28 - advance the index of recently restarted server
+            advance_commit_idx = true;
+
+            //Limit the commit-idx range entries currently stored here.
+            new_commit_idx =
+                MIN(new_commit_idx,
+                    raft_server_get_current_raft_entry_index(ri, RI_NEHDR_SYNC));
+            break;
+
+        default:
+            // -EEXIST and -ERANGE cases do not advance advance commit-idx
+            non_matching_prev_term = true;
+            break;
+        }
+
+        /* Update our commit-idx based on the value sent from the leader.
+         * NOTE:  if synchronous mode is set then this will account for the
+         * the write performed above, otherwise, only the sync'd writes to
+         * this point are considered.
+         */
+        if (advance_commit_idx)
+            raft_server_advance_commit_idx(ri, new_commit_idx);
+    }
+
+    // Issue reply
+    if (!fault_inject_ignore_ae)
+        raft_server_append_entry_reply_send(ri, raerq, sender_csn, stale_term,
+                                            non_matching_prev_term, update_sli,
+                                            rc, num_idx);
+
+    /* Ensure that the raft leader (valid or otherwise) does not reset its timer
+     * since this may cause a leader timeout due to delayed pings.
+     * Additionally, for users of the heartbeat as a clock source it's important
+     * that the leader wakes up consistently.
+     */
+    if (reset_timerfd && !raft_instance_is_leader(ri))
+        raft_server_timerfd_settime(ri);
+}
+
+static raft_server_net_cb_leader_ctx_t
+raft_server_leader_setup_self_follower_info(struct raft_instance *ri)
+{
+    NIOVA_ASSERT(ri && ri->ri_csn_raft);
+    NIOVA_ASSERT(raft_instance_is_leader(ri));
+
+    raft_peer_t this_peer_num = raft_server_instance_self_idx(ri);
+    NIOVA_ASSERT(raft_member_idx_is_valid(ri, this_peer_num));
+
+    /* The leader doesn't update its own rfi_next_idx slot so do that here
+     */
+    struct raft_follower_info *self =
+        raft_server_get_follower_info(ri, this_peer_num);
+
+    struct raft_entry_header sync_hdr = {0};
+    raft_instance_get_newest_header(ri, &sync_hdr, RI_NEHDR_SYNC);
+
+    self->rfi_next_idx = sync_hdr.reh_index + 1;
+    self->rfi_synced_idx = sync_hdr.reh_index;
+    self->rfi_ackd_idx = sync_hdr.reh_index;
+    self->rfi_prev_idx_term = sync_hdr.reh_term;
+}
+
+static raft_server_net_cb_leader_ctx_int64_t
+raft_server_leader_calculate_committed_idx(struct raft_instance *ri,
+                                           const bool sync_thread)
+{
+    NIOVA_ASSERT(ri && ri->ri_csn_raft);
+    NIOVA_ASSERT(raft_instance_is_leader(ri));
+
+    raft_server_leader_setup_self_follower_info(ri);
+
+    const size_t num_raft_members =
+        ctl_svc_node_raft_2_num_members(ri->ri_csn_raft);
+
+    NIOVA_ASSERT(num_raft_members <= CTL_SVC_MAX_RAFT_PEERS);
+
+    raft_entry_idx_t sync_indexes[CTL_SVC_MAX_RAFT_PEERS] =
+        { RAFT_MIN_APPEND_ENTRY_IDX };
+
+    for (size_t i = 0; i < num_raft_members; i++)
+    {
+        struct raft_follower_info *rfi = raft_server_get_follower_info(ri, i);
+
+        // Don't consider a sync-idx which is > ackd-idx
+        sync_indexes[i] = MIN(rfi->rfi_ackd_idx, rfi->rfi_synced_idx);
+    }
+
+    raft_entry_idx_t committed_raft_idx = -1;
+    int rc = raft_server_get_majority_entry_idx(sync_indexes, num_raft_members,
+                                                &committed_raft_idx);
+    FATAL_IF(rc, "raft_server_get_majority_entry_idx(): %s", strerror(-rc));
+
+    DBG_RAFT_INSTANCE(LL_NOTIFY, ri, "committed_raft_idx=%ld",
+                      committed_raft_idx);
+
+    /* The leader still has not obtained the sync_idx values from a majority
+     * of its followers.  Also, ensure the ri_commit_idx is not moving
+     * backwards but exempt the sync thread since it may have a stale view.
+     */
+    if (committed_raft_idx && !sync_thread &&
+        (committed_raft_idx < ri->ri_commit_idx))
+    {
+        DBG_RAFT_INSTANCE(LL_WARN, ri,
+                          "committed_raft_idx (%ld) < ri_commit_idx",
+                          committed_raft_idx);
+        for (raft_peer_t i = 0; i < num_raft_members; i++)
+        {
+            struct raft_follower_info *rfi =
+                raft_server_get_follower_info(ri, i);
+            LOG_MSG(LL_WARN, "idx=%hhu sorted-idx=%ld, peer-sync-idx=%ld",
+                    i, sync_indexes[i], rfi->rfi_synced_idx);
+        }
+    }
+
+    return committed_raft_idx;
+}
+
+static int64_t
+raft_server_leader_can_advance_commit_idx(struct raft_instance *ri,
+                                          const bool sync_thread)
+{
+    NIOVA_ASSERT(ri);
+    if (!raft_instance_is_leader(ri))
+        return ID_ANY_64bit;
+
+    const struct raft_leader_state *rls = &ri->ri_leader;
+
+    const int64_t committed_raft_idx =
+        raft_server_leader_calculate_committed_idx(ri, sync_thread);
+
+    DBG_RAFT_INSTANCE_FATAL_IF( // Note:  sync_thread view may be stale
+        (!sync_thread && committed_raft_idx < ri->ri_commit_idx &&
+         committed_raft_idx >= rls->rls_initial_term_idx), ri,
+        "commit_calc_idx (%ld) < ri_commit_idx after initial term idx (%ld)",
+        committed_raft_idx, rls->rls_initial_term_idx);
+
+    /* Only increase the commit index if the majority has ACKd this leader's
+     * "leader_change_marker" AE.
+     */
+    return (committed_raft_idx >= rls->rls_initial_term_idx &&
+            committed_raft_idx > ri->ri_commit_idx) ?
+        committed_raft_idx : RAFT_ENTRY_IDX_ANY;
+}
+
+/**
+ * raft_server_leader_try_advance_commit_idx -
+ *     After receiving a successful AE reply,
+ *     one where the follower was able to append the entry to its log, the
+ *     leader now checks to see if can commit any older entries.  The
+ *     determination for 'committed' relies on a majority of peers ACK'ing the
+ *     AE in this leader's term - the leader may only tally ACKs for AEs sent
+ *     in its term!
+ *     raft_leader_has_applied_txn_in_my_term() cannot be used here since the
+ *     data used by it must first be updated through a commit + apply
+ *     operation.
+ */
+static raft_server_net_cb_leader_ctx_t // or raft_server_epoll_t
+raft_server_leader_try_advance_commit_idx(struct raft_instance *ri)
+{
+    NIOVA_ASSERT(ri);
+    NIOVA_ASSERT(raft_instance_is_leader(ri));
+
+    const int64_t committed_raft_idx =
+        raft_server_leader_can_advance_commit_idx(ri, false);
+
+    if (committed_raft_idx != RAFT_ENTRY_IDX_ANY)
+        raft_server_advance_commit_idx(ri, committed_raft_idx);
+}
+
+static raft_server_sync_thread_ctx_t
+raft_server_leader_try_advance_commit_idx_from_sync_thread(
+    struct raft_instance *ri)
+{
+    if (ri && (raft_server_leader_can_advance_commit_idx(ri, true) !=
+               RAFT_ENTRY_IDX_ANY))
+        RAFT_NET_EVP_NOTIFY_NO_FAIL(ri, RAFT_EVP_ASYNC_COMMIT_IDX_ADV);
+}
+
+static raft_server_net_cb_leader_ctx_t
+raft_server_try_update_follower_sync_idx(
+    struct raft_instance *ri, struct raft_follower_info *rfi,
+    const struct raft_rpc_msg *rrm, enum raft_rpc_msg_type type)
+{
+    NIOVA_ASSERT(ri && rfi && rrm &&
+                 (type == RAFT_RPC_MSG_TYPE_APPEND_ENTRIES_REPLY ||
+                  type == RAFT_RPC_MSG_TYPE_SYNC_IDX_UPDATE));
+
+    struct raft_entry_header reh = {0};
+    raft_instance_get_newest_header(ri, &reh, RI_NEHDR_SYNC);
+
+    int64_t term = (type == RAFT_RPC_MSG_TYPE_SYNC_IDX_UPDATE ?
+                    rrm->rrm_sync_index_update.rsium_term :
+                    rrm->rrm_append_entries_reply.raerpm_leader_term);
+
+    if (term != reh.reh_term) // Do not accept non-matching terms!
+        return;
+
+    if (rfi->rfi_synced_idx > rfi->rfi_next_idx)
+    {
+        DBG_RAFT_MSG(LL_DEBUG, rrm,
+                     "next-idx=%ld > syncd-idx=%ld (ackd-idx=%ld)",
+                     rfi->rfi_next_idx, rfi->rfi_synced_idx,
+                     rfi->rfi_ackd_idx);
+    }
+    else
+    {
+        int64_t sli = (type == RAFT_RPC_MSG_TYPE_SYNC_IDX_UPDATE ?
+                       rrm->rrm_sync_index_update.rsium_synced_log_index :
+                       rrm->rrm_append_entries_reply.raerpm_synced_log_index);
+
+        bool ackd_or_syncd_advanced = false;
+        /* Adjust the ack'd index - we now know that the follower's log
+         * contains this entry and at the proper term.
+         */
+        if (rfi->rfi_ackd_idx < (rfi->rfi_next_idx - 1))
+        {
+            rfi->rfi_ackd_idx = rfi->rfi_next_idx - 1;
+            ackd_or_syncd_advanced = true;
+        }
+
+        if (rfi->rfi_synced_idx < sli)
+        {
+            rfi->rfi_synced_idx = sli;
+
+            DBG_RAFT_MSG(LL_DEBUG, rrm, "new-sync-idx=%ld how=%d",
+                         rfi->rfi_synced_idx, type);
+
+            // if this request increases the remote's rfi_synced_idx..
+            ackd_or_syncd_advanced = true;
+        }
+
+        if (ackd_or_syncd_advanced)
+            raft_server_leader_try_advance_commit_idx(ri);
+    }
+}
+
+/**
+ * raft_server_follower_ae_reply_is_inflight - determines if an AE reply,
+ *    whose prev-log-index does not match the follower's rfi_next_idx, belongs
+ *    to a pipelined request which is still in flight.  Successful replies from
+ *    the current term may be applied out of order since the follower has
+ *    verified the prev-log-term of the request.  A failed in-flight request
+ *    invalidates those sent after it so the window is rewound to
+ *    rfi_next_idx.
+ */
+static raft_server_net_cb_leader_ctx_bool_t
+raft_server_follower_ae_reply_is_inflight(
+    struct raft_instance *ri, struct raft_follower_info *rfi,
+    const struct raft_append_entries_reply_msg *raerp)
+{
+    NIOVA_ASSERT(ri && rfi && raerp);
+
+    const raft_entry_idx_t reply_next_idx = raerp->raerpm_prev_log_index + 1;
+
+    if (raerp->raerpm_heartbeat_msg ||
+        reply_next_idx <= rfi->rfi_next_idx ||
+        reply_next_idx > rfi->rfi_inflight_idx)
+        return false;
+
+    if (raerp->raerpm_update_sli || raerp->raerpm_err_non_matching_prev_term ||
+        raerp->raerpm_leader_term != ri->ri_log_hdr.rlh_term)
+    {
+        raft_server_follower_ae_window_reset(rfi);
+
+        RAFT_NET_EVP_NOTIFY_NO_FAIL(ri, RAFT_EVP_REMOTE_SEND);
+
+        return false;
+    }
+
+    return true;
+}
+
+static raft_server_net_cb_leader_ctx_t
+raft_server_apply_append_entries_reply_result(
+    struct raft_instance *ri,
+    const uuid_t follower_uuid,
+    const struct raft_append_entries_reply_msg *raerp)
+{
+    NIOVA_ASSERT(ri && raerp);
+    NIOVA_ASSERT(raft_instance_is_leader(ri));
+    NIOVA_ASSERT(!raerp->raerpm_err_stale_term);
+
+    const raft_peer_t follower_idx = raft_peer_2_idx(ri, follower_uuid);
+    NIOVA_ASSERT(follower_idx != RAFT_PEER_ANY);
+
+    struct raft_follower_info *rfi =
+        raft_server_get_follower_info(ri, follower_idx);
+
+    struct timespec la = rfi->rfi_last_ack;
+
+    // Update the last ack value for this follower.
+    raft_server_update_follower_last_ack(rfi);
+
+    DBG_RAFT_INSTANCE(
+        (raerp->raerpm_heartbeat_msg ? LL_DEBUG : LL_NOTIFY), ri,
+        "flwr=%x next-idx=%ld si=%ld err=%hhx rp-pli=%ld rp-si=%ld la-ms=%lld",
+        follower_idx, rfi->rfi_next_idx, rfi->rfi_synced_idx,
+        raerp->raerpm_err_non_matching_prev_term,
+        raerp->raerpm_prev_log_index, raerp->raerpm_synced_log_index,
+        (timespec_2_msec(&rfi->rfi_last_ack) - timespec_2_msec(&la)));
+
+    /* Do not modify the rls->rls_next_idx[follower_idx] value unless the
+     * reply corresponds to it.  This is to handle cases where replies get
+     * delayed by the network.  If the follower still needs to have its
+     * rls_next_idx decreased, it's ok, subsequent AE requests will eventually
+     * cause it happen.  Note, this situation is common due to heartbeat msgs
+     * running concurrently with pending AE's.  Heartbeat replies may meet the
+     * criteria for advancing next-idx which will cause the non-hb AE reply
+     * to appear stale.
+     */
+    if (raerp->raerpm_prev_log_index + 1 != rfi->rfi_next_idx &&
+        !raft_server_follower_ae_reply_is_inflight(ri, rfi, raerp))
+    {
+        DBG_RAFT_INSTANCE(
+            LL_DEBUG, ri,
+            "follower=%x hb=%d reply-ni=%ld my-ni-for-follower=%ld",
+            follower_idx, raerp->raerpm_heartbeat_msg,
+            raerp->raerpm_prev_log_index, rfi->rfi_next_idx);
+
+        return;
+    }
+
+    const raft_entry_idx_t reply_next_idx =
+        raerp->raerpm_prev_log_index + 1 +
+        (raerp->raerpm_num_idx ? raerp->raerpm_num_idx : 1);
+
+    // The follower may not claim indexes which this leader has yet to send
+    if (!raerp->raerpm_heartbeat_msg &&
+        (reply_next_idx - 1) >
+        raft_server_get_current_raft_entry_index(ri, RI_NEHDR_UNSYNC))
+    {
+        DBG_RAFT_INSTANCE(LL_WARN, ri,
+                          "follower=%x reply-pli=%ld num-idx=%hhu exceeds ldr",
+                          follower_idx, raerp->raerpm_prev_log_index,
+                          raerp->raerpm_num_idx);
+        return;
+    }
+
+    /* raerpm_update_sli is prioritized over
+     * raerpm_err_non_matching_prev_term
+     */
+    if (raerp->raerpm_update_sli)
+    {
+        DBG_RAFT_INSTANCE(LL_WARN, ri,
+                          "follower=%x requests sli update to %ld from %ld",
+                          follower_idx, raerp->raerpm_synced_log_index,
+                          rfi->rfi_next_idx);
+        if (raerp->raerpm_synced_log_index > rfi->rfi_next_idx)
+        {
+            rfi->rfi_next_idx = raerp->raerpm_synced_log_index + 1;
+            rfi->rfi_ackd_idx = raerp->raerpm_synced_log_index;
+            rfi->rfi_synced_idx = raerp->raerpm_synced_log_index;
+            rfi->rfi_prev_idx_term = -1;
+        }
+
+        raft_server_follower_ae_window_reset(rfi);
+    }
+    else if (raerp->raerpm_err_non_matching_prev_term)
+    {
+        if (rfi->rfi_next_idx > 0)
+        {
+            if (raerp->raerpm_newly_initialized_peer)
+            {
+                rfi->rfi_next_idx = 0;
+            }
+            else
+            {
+                /* Fast-forwarding rfi_next_idx to raerpm_synced_log_index
+                 * prevents the leader from iterating over index values which
+                 * the follower has disclosed that it does hold.
+                 */
+                rfi->rfi_next_idx =
+                    (raerp->raerpm_synced_log_index >= 0 &&
+                     raerp->raerpm_synced_log_index < rfi->rfi_next_idx)
+                    ? raerp->raerpm_synced_log_index
+                    : rfi->rfi_next_idx - 1;
+            }
+
+            rfi->rfi_prev_idx_term = -1; //Xxx this needs to go into a function
+        }
+
+        // Requests sent beyond the mismatch are of no use to the follower
+        raft_server_follower_ae_window_reset(rfi);
+    }
+    else
+    {
+        if (!raerp->raerpm_heartbeat_msg)
+        {
+            rfi->rfi_prev_idx_term = -1;
+            rfi->rfi_next_idx = reply_next_idx;
+
+            // Release this request's slot in the in-flight window
+            if (rfi->rfi_inflight_cnt)
+                rfi->rfi_inflight_cnt--;
+
+            if (rfi->rfi_next_idx > rfi->rfi_inflight_idx)
+                raft_server_follower_ae_window_reset(rfi);
+
+            DBG_RAFT_INSTANCE(LL_NOTIFY, ri,
+                              "follower=%x new-next-idx=%ld inflight=%ld:%u",
+                              follower_idx, rfi->rfi_next_idx,
+                              rfi->rfi_inflight_idx, rfi->rfi_inflight_cnt);
+        }
+
+        const struct raft_rpc_msg *rrm =
+            OFFSET_CAST(raft_rpc_msg, rrm_append_entries_reply, raerp);
+
+        raft_server_try_update_follower_sync_idx(
+            ri, rfi, rrm, RAFT_RPC_MSG_TYPE_APPEND_ENTRIES_REPLY);
+    }
+
+    if ((rfi->rfi_next_idx - 1) <
+        raft_server_get_current_raft_entry_index(ri, RI_NEHDR_UNSYNC))
+    {
+        DBG_RAFT_INSTANCE(LL_NOTIFY, ri, "follower=%x still lags next-idx=%ld",
+                          follower_idx, rfi->rfi_next_idx);
+
+        RAFT_NET_EVP_NOTIFY_NO_FAIL(ri, RAFT_EVP_REMOTE_SEND);
+    }
+}
+
+static raft_server_net_cb_ctx_t
+raft_server_process_append_entries_reply(struct raft_instance *ri,
+                                         struct ctl_svc_node *sender_csn,
+                                         const struct raft_rpc_msg *rrm)
+{
+    NIOVA_ASSERT(ri && sender_csn && rrm);
+    NIOVA_ASSERT(!ctl_svc_node_compare_uuid(sender_csn, rrm->rrm_sender_id));
+
+    const struct raft_append_entries_reply_msg *raerp =
+        &rrm->rrm_append_entries_reply;
+
+    DBG_RAFT_MSG((raerp->raerpm_heartbeat_msg ? LL_DEBUG : LL_NOTIFY),
+                 rrm, "");
+
+    if (!raft_instance_is_leader(ri))
+        return;
+
+    if (raerp->raerpm_err_stale_term)
+    {
+        /* raerpm_err_stale_term should only be considered if it's more recent
+         * than our own term, otherwise it's stale.
+         */
+        if (raerp->raerpm_leader_term > ri->ri_log_hdr.rlh_term)
+            raft_server_becomes_follower(ri, raerp->raerpm_leader_term,
+                                         sender_csn->csn_uuid,
+                                         RAFT_BFRSN_STALE_TERM_WHILE_LEADER);
+    }
+    else
+    {
+        raft_server_apply_append_entries_reply_result(ri, sender_csn->csn_uuid,
+                                                      raerp);
+    }
+}
+
+static raft_server_net_cb_ctx_t
+raft_server_process_sync_idx_update(struct raft_instance *ri,
+                                    struct ctl_svc_node *sender_csn,
+                                    const struct raft_rpc_msg *rrm)
+{
+    NIOVA_ASSERT(ri && sender_csn && rrm);
+    NIOVA_ASSERT(!ctl_svc_node_compare_uuid(sender_csn, rrm->rrm_sender_id));
+
+    if (!raft_instance_is_leader(ri))
+        return;
+
+    /* Ignore the message if the term does not match.  Note that this term is
+     * not for the sync'd index - it's the remote's current term value which
+     * should match this leader's term.
+     */
+    else if (rrm->rrm_sync_index_update.rsium_term != ri->ri_log_hdr.rlh_term)
+        return;
+
+    raft_peer_t follower_idx = raft_peer_2_idx(ri, sender_csn->csn_uuid);
+    if (follower_idx == RAFT_PEER_ANY)
+        return;
+
+    struct raft_follower_info *rfi =
+        raft_server_get_follower_info(ri, follower_idx);
+
+    raft_server_try_update_follower_sync_idx(
+        ri, rfi, rrm, RAFT_RPC_MSG_TYPE_SYNC_IDX_UPDATE);
+}
+
+/**
+ * raft_server_chkpt_xfer_reply_init - prepares the reply header for the chkpt
+ *    xfer request 'rrm'.  The request's db uuid was verified against this
+ *    peer's when the request was received.
+ */
+static void
+raft_server_chkpt_xfer_reply_init(const struct raft_instance *ri,
+                                  const struct raft_rpc_msg *rrm,
+                                  struct raft_rpc_msg *reply)
+{
+    const struct raft_chkpt_xfer_request_msg *rcxrq =
+        &rrm->rrm_chkpt_xfer_request;
+    struct raft_chkpt_xfer_reply_msg *rcxrp = &reply->rrm_chkpt_xfer_reply;
+
+    memset(reply, 0, sizeof(struct raft_rpc_msg));
+
+    reply->rrm_type = RAFT_RPC_MSG_TYPE_CHKPT_XFER_REPLY;
+    uuid_copy(reply->rrm_sender_id, RAFT_INSTANCE_2_SELF_UUID(ri));
+    uuid_copy(reply->rrm_raft_id, RAFT_INSTANCE_2_RAFT_UUID(ri));
+    uuid_copy(reply->rrm_db_id, rrm->rrm_db_id);
+
+    rcxrp->rcxrpm_chkpt_idx = rcxrq->rcxrqm_chkpt_idx;
+    rcxrp->rcxrpm_offset = rcxrq->rcxrqm_offset;
+    rcxrp->rcxrpm_tag = rcxrq->rcxrqm_tag;
+}
+
+static void
+raft_server_chkpt_xfer_reply_set_error(struct raft_rpc_msg *reply,
+                                       const int err)
+{
+    struct raft_chkpt_xfer_reply_msg *rcxrp = &reply->rrm_chkpt_xfer_reply;
+
+    rcxrp->rcxrpm_err = err;
+    rcxrp->rcxrpm_len = 0;
+    rcxrp->rcxrpm_data_sz = 0;
+}
+
+/**
+ * raft_server_chkpt_xfer_reply_read - reads the requested checkpoint data
+ *    into the payload which follows 'reply' in its buffer of 'buf_size'
+ *    bytes.
+ */
+static void
+raft_server_chkpt_xfer_reply_read(struct raft_instance *ri,
+                                  const struct raft_rpc_msg *rrm,
+                                  struct raft_rpc_msg *reply,
+                                  const size_t buf_size)
+{
+    const size_t max_payload =
+        MIN(buf_size, raft_net_max_rpc_size(ri->ri_store_type)) -
+        sizeof(struct raft_rpc_msg);
+
+    int rc = ri->ri_backend->rib_chkpt_xfer_read(
+        ri, &rrm->rrm_chkpt_xfer_request, &reply->rrm_chkpt_xfer_reply,
+        (char *)reply + sizeof(struct raft_rpc_msg), max_payload);
+
+    if (rc)
+        raft_server_chkpt_xfer_reply_set_error(reply, rc);
+}
+
+/**
+ * raft_server_process_chkpt_xfer_request - serves a chunk of one of this
+ *    peer's checkpoints, or the checkpoint's file list, to a peer in bulk
+ *    recovery.  Errors are returned to the requester in the reply.  When the
+ *    bulk lane is running, the request is placed onto the requester's send
+ *    queue and the read is done by the sender thread, otherwise the request
+ *    is served inline.  The reply is sent over the requester's TCP
+ *    connection.
+ */
+static raft_server_net_cb_ctx_t
+raft_server_process_chkpt_xfer_request(struct raft_instance *ri,
+                                       struct ctl_svc_node *sender_csn,
+                                       const struct raft_rpc_msg *rrm)
+{
+    NIOVA_ASSERT(ri && sender_csn && rrm);
+
+    const raft_peer_t peer = raft_peer_2_idx(ri, sender_csn->csn_uuid);
+    if (peer == RAFT_PEER_ANY)
+        return;
+
+    int rc = 0;
+    if (uuid_compare(rrm->rrm_db_id, ri->ri_db_uuid))
+        rc = -ESTALE;
+
+    else if (!ri->ri_backend || !ri->ri_backend->rib_chkpt_xfer_read)
+        rc = -EOPNOTSUPP;
+
+    struct raft_peer_send_queue *rpsq = raft_server_peer_sendq_get(ri, peer);
+
+    if (!rc && rpsq)
+    {
+        struct iovec iov = {
+            .iov_base = (void *)rrm,
+            .iov_len = sizeof(struct raft_rpc_msg),
+        };
+
+        rc = raft_server_peer_sendq_enqueue(ri, rpsq, sender_csn, &iov,
+                                            RAFT_BULK_SEND_CHKPT_XFER,
+                                            RAFT_AE_COMPRESS_NONE);
+        if (rc)
+            DBG_CTL_SVC_NODE(LL_NOTIFY, sender_csn, "chkpt-xfer request: %s",
+                             strerror(-rc));
+        return;
+    }
+
+    struct raft_rpc_msg err_reply;
+    struct raft_rpc_msg *reply = &err_reply;
+    struct buffer_item *bi = NULL;
+
+    if (!rc)
+    {
+        bi = buffer_set_allocate_item(
+            raft_instance_buf_set(ri, RAFT_BUF_SET_LARGE));
+        if (bi)
+            reply = (struct raft_rpc_msg *)bi->bi_iov.iov_base;
+        else
+            rc = -ENOMEM;
+    }
+
+    raft_server_chkpt_xfer_reply_init(ri, rrm, reply);
+
+    if (rc)
+        raft_server_chkpt_xfer_reply_set_error(reply, rc);
+    else
+        raft_server_chkpt_xfer_reply_read(ri, rrm, reply, bi->bi_iov.iov_len);
+
+    DBG_RAFT_MSG((reply->rrm_chkpt_xfer_reply.rcxrpm_err ?
+                  LL_NOTIFY : LL_DEBUG), reply, "");
+
+    struct iovec iov = {
+        .iov_base = reply,
+        .iov_len = sizeof(struct raft_rpc_msg) +
+            reply->rrm_chkpt_xfer_reply.rcxrpm_data_sz,
+    };
+
+    rc = rpsq ?
+        raft_server_peer_sendq_enqueue(ri, rpsq, sender_csn, &iov,
+                                       RAFT_BULK_SEND_MSG,
+                                       RAFT_AE_COMPRESS_NONE) :
+        raft_net_send_bulk_msg(ri, sender_csn, &iov, 1);
+
+    if (rc)
+        DBG_CTL_SVC_NODE(LL_NOTIFY, sender_csn, "chkpt-xfer reply: %s",
+                         strerror(-rc));
+
+    if (bi)
+        buffer_set_release_item(bi);
+}
+
+/**
+ * raft_server_process_received_server_msg - called following the arrival of
+ *    a udp message on the server <-> server socket.  After verifying
+ *    that the sender's UUID and its raft UUID are known, this function will
+ *    call the appropriate function handler based on the msg type.
+ */
+static raft_net_cb_ctx_t
+raft_server_process_received_server_msg(struct raft_instance *ri,
+                                        const struct raft_rpc_msg *rrm,
+                                        struct ctl_svc_node *sender_csn)
+{
+    NIOVA_ASSERT(ri && rrm && sender_csn);
+
+    /* General timestamp acquisition.  Note that this does not record AE
+     * [n]ack statuses of the leader's followers.  Those are updated in
+     * raft_server_process_append_entries_reply().
+     */
+    raft_net_update_last_comm_time(ri, sender_csn->csn_uuid, false);
+
+    switch (rrm->rrm_type)
+    {
+    case RAFT_RPC_MSG_TYPE_PRE_VOTE_REQUEST: // fall through
+    case RAFT_RPC_MSG_TYPE_VOTE_REQUEST:
+        return raft_server_process_vote_request_common(ri, sender_csn, rrm);
+
+    case RAFT_RPC_MSG_TYPE_PRE_VOTE_REPLY: // fall through
+    case RAFT_RPC_MSG_TYPE_VOTE_REPLY:
+        return raft_server_process_vote_reply_common(ri, sender_csn, rrm);
+
+    case RAFT_RPC_MSG_TYPE_SYNC_IDX_UPDATE:
+        return raft_server_process_sync_idx_update(ri, sender_csn, rrm);
+
+    case RAFT_RPC_MSG_TYPE_APPEND_ENTRIES_REQUEST:
+        return raft_server_process_append_entries_request(ri, sender_csn, rrm);
+
+    case RAFT_RPC_MSG_TYPE_APPEND_ENTRIES_REPLY:
+        return raft_server_process_append_entries_reply(ri, sender_csn, rrm);
+
+    case RAFT_RPC_MSG_TYPE_CHKPT_XFER_REQUEST:
+        return raft_server_process_chkpt_xfer_request(ri, sender_csn, rrm);
+
+    default:
+        DBG_RAFT_MSG(LL_NOTIFY, rrm, "unhandled msg type %d", rrm->rrm_type);
+        break;
+    }
+}
+
+/**
+ * raft_server_ae_decompress_buf_get - allocates, on first use, the buffer
+ *    into which compressed AE requests are restored.  Server msgs are
+ *    received by the main epoll thread so one buffer per instance suffices.
+ */
+static int
+raft_server_ae_decompress_buf_get(struct raft_instance *ri)
+{
+    if (ri->ri_ae_decompress_buf)
+        return 0;
+
+    const size_t size = sizeof(struct raft_rpc_msg) +
+        raft_net_max_rpc_size(ri->ri_store_type);
+
+    ri->ri_ae_decompress_buf = niova_malloc_can_fail(size);
+    if (!ri->ri_ae_decompress_buf)
+        return -ENOMEM;
+
+    ri->ri_ae_decompress_buf_size = size;
+
+    return 0;
+}
+
+static raft_net_cb_ctx_t
+raft_server_peer_recv_handler(struct raft_instance *ri,
+                              const char *recv_buffer,
+                              ssize_t recv_bytes,
+                              const struct sockaddr_in *from)
+{
+    SIMPLE_FUNC_ENTRY(LL_TRACE);
+    NIOVA_ASSERT(ri && from);
+
+    if (!recv_buffer || !recv_bytes)
+        return;
+
+    const struct raft_rpc_msg *rrm = (const struct raft_rpc_msg *)recv_buffer;
+
+    if (recv_bytes >= (ssize_t)RAFT_RPC_MSG_COMPACT_PREFIX_SZ &&
+        rrm->rrm_version == RAFT_RPC_MSG_VERSION_COMPACT)
+    {
+        /* Server msgs are received by the main epoll thread, a single
+         * decode buffer suffices.
+         */
+        static union
+        {
+            struct raft_rpc_msg rrm;
+            char buf[sizeof(struct raft_rpc_msg) + NIOVA_MAX_UDP_SIZE];
+        } decoded;
+
+        ssize_t rc = raft_net_rpc_msg_compact_decode(recv_buffer, recv_bytes,
+                                                     &decoded.rrm,
+                                                     sizeof(decoded));
+        if (rc < 0)
+        {
+            DBG_RAFT_INSTANCE(
+                LL_NOTIFY, ri,
+                "raft_net_rpc_msg_compact_decode(): %s from peer %s:%d",
+                strerror(-rc), inet_ntoa(from->sin_addr),
+                ntohs(from->sin_port));
+
+            return;
+        }
+
+        rrm = &decoded.rrm;
+        recv_bytes = rc;
+    }
+    else if (recv_bytes >= (ssize_t)sizeof(struct raft_rpc_msg) &&
+             rrm->rrm_version == RAFT_RPC_MSG_VERSION_COMPRESS)
+    {
+        /* The entries are restored before any other processing so that
+         * their CRCs are verified as usual.
+         */
+        ssize_t rc = raft_server_ae_decompress_buf_get(ri);
+        if (!rc)
+            rc = raft_net_ae_entries_decompress(
+                recv_buffer, recv_bytes,
+                (struct raft_rpc_msg *)ri->ri_ae_decompress_buf,
+                ri->ri_ae_decompress_buf_size);
+
+        if (rc < 0)
+        {
+            DBG_RAFT_INSTANCE(
+                LL_NOTIFY, ri,
+                "raft_net_ae_entries_decompress(): %s from peer %s:%d",
+                strerror(-rc), inet_ntoa(from->sin_addr),
+                ntohs(from->sin_port));
+
+            return;
+        }
+
+        rrm = (const struct raft_rpc_msg *)ri->ri_ae_decompress_buf;
+        recv_bytes = rc;
+    }
+
+    ssize_t expected_msg_size = sizeof(struct raft_rpc_msg);
+
+    if (rrm->rrm_type == RAFT_RPC_MSG_TYPE_APPEND_ENTRIES_REQUEST)
+        expected_msg_size += rrm->rrm_append_entries_request.raerqm_entries_sz;
+
+    DBG_RAFT_MSG(LL_DEBUG, rrm, "expected_msg_size: %lu", expected_msg_size);
+    /* Server <-> server messages do not have additional payloads.
+     */
+    if (recv_bytes != expected_msg_size)
+    {
+        DBG_RAFT_INSTANCE(
+            LL_NOTIFY, ri,
+            "Invalid msg size %zd (expected %zu) from peer %s:%d",
+            recv_bytes, expected_msg_size, inet_ntoa(from->sin_addr),
+            ntohs(from->sin_port));
+
+        return;
+    }
+
+    DBG_RAFT_MSG(LL_DEBUG, rrm, "msg-size=(%zd) peer %s:%d",
+                 recv_bytes, inet_ntoa(from->sin_addr),
+                 ntohs(from->sin_port));
+
+    /* Verify the sender's id before proceeding.
+     */
+    struct ctl_svc_node *sender_csn =
+        raft_net_verify_sender_server_msg(ri, rrm->rrm_sender_id,
+                                          rrm->rrm_raft_id, from);
+    if (!sender_csn)
+        return;
+
+    /* Track the wire version advertised by the sender.  A peer which
+     * restarts with an older version reverts to version 0 on its first msg.
+     */
+    const raft_peer_t idx = raft_peer_2_idx(ri, sender_csn->csn_uuid);
+    if (idx < CTL_SVC_MAX_RAFT_PEERS)
+        ri->ri_peer_msg_version[idx] = rrm->rrm_version_max;
+
+    raft_server_process_received_server_msg(ri, rrm, sender_csn);
+}
+
+static bool
+raft_leader_majority_followers_comm_window(const struct raft_instance *ri,
+                                           const unsigned int comm_window_ms)
+{
+    if (!raft_instance_is_leader(ri) ||
+        FAULT_INJECT(raft_leader_may_be_deposed))
+        return false;
+
+    struct timespec now;
+    niova_realtime_coarse_clock(&now);
+
+    size_t num_acked_within_window = 1; // count "self"
+
+    const raft_peer_t num_raft_peers = raft_num_members_validate_and_get(ri);
+
+    for (raft_peer_t i = 0; i < num_raft_peers; i++)
+    {
+        if (i == raft_server_instance_self_idx(ri))
+            continue;
+
+        const struct raft_follower_info *rfi =
+            raft_server_get_follower_info((struct raft_instance *)ri, i);
+
+        // Ignore if time has moved backwards
+        if (timespeccmp(&now, &rfi->rfi_last_ack, <))
+            continue;
+
+        struct timespec diff;
+
+        timespecsub(&now, &rfi->rfi_last_ack, &diff);
+
+        if (timespec_2_msec(&diff) <= comm_window_ms)
+            num_acked_within_window++;
+    }
+
+    SIMPLE_LOG_MSG(LL_DEBUG,
+                   "num_acked_within_window: %lu required: %d (%d peers)",
+                   num_acked_within_window, num_raft_peers / 2 + 1,
+                   num_raft_peers);
+
+    return (num_acked_within_window >= (size_t)((num_raft_peers / 2 + 1))) ?
+        true : false;
+}
+
+static raft_server_net_cb_ctx_bool_t
+raft_leader_instance_is_fresh(const struct raft_instance *ri)
+{
+    return raft_leader_majority_followers_comm_window(
+        ri, raft_election_timeout_lower_bound(ri));
+}
+
+/* raft_leader_check_quorum - reads follower ack state and determines if a
+ *   quorum exists (IOW that enough followers have ack'd this leader w/in the
+ *   time window).
+ *   NOTE:  rls_quorum_ok_cnt - this value is incremented each time this call
+ *     is entered, without respect to the current time.  It is assumed that this
+ *     called is made periodically from the leader's timefd expiration. Calling
+ *     this function outside of raft_net_timerfd_cb_ctx can have a negative
+ *     effect on users of this value which are using it as a clock value.
+ *     The call is driven by the RAFT_LEADER_TIMER_QUORUM deadline rather than
+ *     every leader wakeup, so the count advances once per
+ *     RAFT_SERVER_QUORUM_CHECK_FACTOR * RAFT_LEADER_WAKEUP_MS (20ms) and a
+ *     quorum loss may be noticed up to that long after it occurs.
+ */
+static raft_net_timerfd_cb_ctx_bool_t
+raft_leader_check_quorum(struct raft_instance *ri)
+{
+    NIOVA_ASSERT(ri->ri_state == RAFT_STATE_LEADER);
+
+    bool quorum_intact =
+        raft_leader_majority_followers_comm_window(
+            ri, (raft_election_timeout_lower_bound(ri) *
+                 ri->ri_check_quorum_timeout_factor));
+
+    if (quorum_intact)
+    {
+        ri->ri_leader.rls_quorum_ok_cnt++;
+        DBG_RAFT_INSTANCE(LL_DEBUG, ri, "quorum OK (cnt=%ld)",
+                          ri->ri_leader.rls_quorum_ok_cnt);
+    }
+    else
+    {
+        DBG_RAFT_INSTANCE(LL_WARN, ri, "quorum loss detected");
+    }
+
+    return quorum_intact;
+}
+
+/**
+ * raft_server_may_process_client_request - this function checks the state of
+ *    this raft instance to determine if it's qualified to accept a client
+ *    request.
+ */
+static raft_net_cb_ctx_int_t
+raft_server_may_accept_client_request(struct raft_instance *ri)
+{
+    NIOVA_ASSERT(ri);
+
+    /* Not the leader, then cause a redirect reply to be done.
+     */
+    if (raft_instance_is_booting(ri))
+        return -EINPROGRESS;
+
+    else if (raft_instance_is_candidate(ri) ||
+             raft_instance_is_candidate_prevote(ri))
+        return -ENOENT;
+
+    // 1. am I the raft leader?
+    else if (!raft_instance_is_leader(ri))
+        return -ENOSYS;
+
+    // 2. am I a fresh raft leader?
+    else if (!raft_leader_instance_is_fresh(ri))
+        return -EAGAIN;
+
+    // 3. have I applied all of the lastApplied entries that I need -
+    //    including a fake AE command (which is written to the logs)?
+    else if (!raft_leader_has_applied_txn_in_my_term(ri))
+        return -EBUSY;
+
+    return 0;
+}
+
+/**
+ * raft_server_co_wr_pipeline_is_idle - the leader has no written entries
+ *    which are awaiting commit.
+ */
+static bool
+raft_server_co_wr_pipeline_is_idle(const struct raft_instance *ri)
+{
+    return raft_server_get_current_raft_entry_index(ri, RI_NEHDR_UNSYNC) <=
+        ri->ri_commit_idx ? true : false;
+}
+
+/**
+ * raft_server_co_wr_data_size - returns the entry data size produced by the
+ *    pending writes plus 'nadd' more writes totaling 'add_size' bytes.  Once
+ *    the v1 header table is exceeded, this includes the v2 sub-entry table.
+ */
+static size_t
+raft_server_co_wr_data_size(const struct raft_instance_co_wr *co_wr,
+                            const uint32_t nadd, const size_t add_size)
+{
+    const uint32_t nentries = co_wr->rcwi_nentries + nadd;
+
+    return co_wr->rcwi_total_size + add_size +
+        (nentries > RAFT_ENTRY_NUM_ENTRIES ?
+         raft_entry_sub_table_size(nentries) : 0);
+}
+
+/**
+ * raft_server_co_wr_flush_reason - decide if the pending coalesced writes
+ *    should be issued now.  Waiting only pays off while earlier entries are
+ *    in flight, so an idle pipeline flushes at once.  Otherwise the pending
+ *    writes are held until the entry fills or the oldest has waited for
+ *    ri_co_wr_latency_budget_us.  'arrival' is set when called as a new
+ *    write is added, and distinguishes an idle pipeline from one which has
+ *    just drained.
+ */
+/**
+ * raft_server_co_wr_max_entries - the coalesce-max-entries tunable, bounded
+ *    to the v1 header table until every peer has advertised that it accepts
+ *    v2 entry headers.  Peers which have not been heard from count as old.
+ */
+static size_t
+raft_server_co_wr_max_entries(const struct raft_instance *ri)
+{
+    if (ri->ri_co_wr_max_entries <= RAFT_ENTRY_NUM_ENTRIES)
+        return ri->ri_co_wr_max_entries;
+
+    else if (ri->ri_rpc_msg_version_max < RAFT_RPC_MSG_VERSION_SUB_TABLE)
+        return RAFT_ENTRY_NUM_ENTRIES;
+
+    const raft_peer_t npeers = raft_num_members_validate_and_get(ri);
+
+    for (raft_peer_t i = 0; i < npeers; i++)
+    {
+        if (ri->ri_csn_raft_peers[i] != ri->ri_csn_this_peer &&
+            ri->ri_peer_msg_version[i] < RAFT_RPC_MSG_VERSION_SUB_TABLE)
+            return RAFT_ENTRY_NUM_ENTRIES;
+    }
+
+    return ri->ri_co_wr_max_entries;
+}
+
+static enum raft_co_wr_flush_reason
+raft_server_co_wr_flush_reason(const struct raft_instance *ri,
+                               const bool arrival)
+{
+    const struct raft_instance_co_wr *co_wr = ri->ri_coalesced_wr;
+
+    if (!co_wr->rcwi_nentries)
+        return RAFT_CO_WR_FLUSH_NONE;
+
+    if (co_wr->rcwi_nentries >= raft_server_co_wr_max_entries(ri) ||
+        raft_server_co_wr_data_size(co_wr, 0, 0) >=
+        RAFT_ENTRY_MAX_DATA_SIZE(ri))
+        return RAFT_CO_WR_FLUSH_FULL;
+
+    if (raft_server_co_wr_pipeline_is_idle(ri))
+        return arrival ? RAFT_CO_WR_FLUSH_IDLE : RAFT_CO_WR_FLUSH_DRAINED;
+
+    struct timespec ts;
+    niova_unstable_clock(&ts);
+    timespecsub(&ts, &co_wr->rcwi_first_ts, &ts);
+
+    return (timespec_2_nsec(&ts) / 1000) >= ri->ri_co_wr_latency_budget_us ?
+        RAFT_CO_WR_FLUSH_BUDGET : RAFT_CO_WR_FLUSH_NONE;
+}
+
+/**
+ * raft_server_leader_co_wr_timer_arm - set the leader's deadline for the
+ *    pending coalesced writes to the end of the oldest write's latency
+ *    budget.  Writes pending behind a drained pipeline are issued from the
+ *    apply path rather than by the timer.
+ */
+static void
+raft_server_leader_co_wr_timer_arm(struct raft_instance *ri)
+{
+    const struct raft_instance_co_wr *co_wr = ri->ri_coalesced_wr;
+
+    if (!raft_instance_is_leader(ri) || !co_wr || !co_wr->rcwi_nentries)
+        return;
+
+    const unsigned long long usec = ri->ri_co_wr_latency_budget_us;
+    struct timespec deadline = {
+        .tv_sec = usec / 1000000ULL,
+        .tv_nsec = (usec % 1000000ULL) * 1000ULL,
+    };
+
+    timespecadd(&deadline, &co_wr->rcwi_first_ts, &deadline);
+
+    raft_leader_timer_arm(ri, RAFT_LEADER_TIMER_CO_WR, &deadline);
+    raft_server_leader_timerfd_settime(ri, false);
+}
+
+/*
+ * Write the coalesced writes if the pipeline has drained or the latency
+ * budget of the oldest pending write has expired.
+ */
+static raft_net_timerfd_cb_ctx_t
+raft_server_leader_co_wr_timer_expired(struct raft_instance *ri)
+{
+    // Only the valid leader holding pending entries should proceed.
+    int rc = raft_server_may_accept_client_request(ri);
+    if (rc)
+        return;
+
+    niova_mutex_lock(&ri->ri_write_mutex);
+    if (ri->ri_coalesced_wr->rcwi_nentries && !FAULT_INJECT(coalesced_writes))
+    {
+        enum raft_co_wr_flush_reason reason =
+            raft_server_co_wr_flush_reason(ri, false);
+
+        // Issue the pending write
+        if (reason != RAFT_CO_WR_FLUSH_NONE)
+            raft_server_write_coalesced_entries(ri, __func__, reason);
+    }
+    niova_mutex_unlock(&ri->ri_write_mutex);
+}
+
+
+static const char *
+raft_server_may_accept_client_request_reason(struct raft_instance *ri)
+{
+    int rc = raft_server_may_accept_client_request(ri);
+
+    return raft_net_client_rpc_sys_error_2_string(rc);
+}
+
+static raft_net_cb_ctx_t
+raft_server_reply_to_client(struct raft_instance *ri,
+                            struct raft_net_client_request_handle *rncr,
+                            struct ctl_svc_node *csn)
+{
+    if (!ri || !ri->ri_csn_this_peer || !ri->ri_csn_raft || !rncr ||
+        !raft_net_client_request_handle_has_reply_info(rncr) ||
+        rncr->rncr_is_direct_req)
+        return;
+
+    /* Copy the reply info from the provided rncr pointer.  This reply info
+     * fields have been written by the state_machine callback.
+     */
+    const struct raft_client_rpc_msg *reply = rncr->rncr_reply.rncr_reply_ptr;
+
+    if (rncr->rncr_request)
+        DBG_RAFT_CLIENT_RPC(LL_DEBUG, rncr->rncr_request, "original request");
+    DBG_RAFT_CLIENT_RPC(LL_DEBUG, reply, "reply");
+
+    int rc = raft_server_send_msg_to_client(ri, rncr, csn);
+    if (rc)
+        DBG_RAFT_CLIENT_RPC(LL_ERROR, reply,
+                            "raft_server_send_msg(): %s", strerror(rc));
+}
+
+static raft_net_cb_ctx_t
+raft_server_deny_client_request(struct raft_instance *ri,
+                                    struct raft_net_client_request_handle *rncr,
+                                    struct ctl_svc_node *csn,
+                                    const int rc)
+{
+    NIOVA_ASSERT(ri && rncr && rncr->rncr_request && rncr->rncr_reply.rncr_reply_ptr);
+
+    struct raft_client_rpc_msg *reply = rncr->rncr_reply.rncr_reply_ptr;
+
+    reply->rcrm_sys_error = rc;
+
+    if (rc == -ENOSYS && ri->ri_csn_leader)
+    {
+        reply->rcrm_type = RAFT_CLIENT_RPC_MSG_TYPE_REDIRECT;
+        uuid_copy(reply->rcrm_redirect_id, ri->ri_csn_leader->csn_uuid);
+    }
+
+    return raft_server_reply_to_client(ri, rncr, csn);
+}
+
+/**
+ * raft_server_client_reply_init - prepares a reply RPC by copying the
+ *    relevant items from the original request.
+ */
+static raft_net_cb_ctx_t
+raft_server_client_reply_init(const struct raft_instance *ri,
+                              struct raft_net_client_request_handle *rncr,
+                              enum raft_client_rpc_msg_type msg_type)
+{
+    NIOVA_ASSERT(
+        ri && rncr &&
+        (rncr->rncr_is_direct_req ||
+         (rncr->rncr_reply.rncr_reply_ptr &&
+          (msg_type == RAFT_CLIENT_RPC_MSG_TYPE_PING_REPLY ||
+           msg_type == RAFT_CLIENT_RPC_MSG_TYPE_REPLY) &&
+          raft_net_client_request_handle_has_reply_info(rncr) &&
+          rncr->rncr_reply.rncr_reply_data_size <
+          rncr->rncr_reply.rncr_reply_data_max_size)));
+
+    struct raft_client_rpc_msg *reply = rncr->rncr_reply.rncr_reply_ptr;
+    memset(reply, 0, sizeof(struct raft_client_rpc_msg));
+
+    uuid_copy(reply->rcrm_raft_id, ri->ri_csn_raft->csn_uuid);
+    uuid_copy(reply->rcrm_sender_id, ri->ri_csn_this_peer->csn_uuid);
+    uuid_copy(reply->rcrm_dest_id, rncr->rncr_client_uuid);
+
+    reply->rcrm_type = msg_type;
+    reply->rcrm_msg_id = rncr->rncr_msg_id;
+    reply->rcrm_data_size = rncr->rncr_reply.rncr_reply_data_size;
+}
+
+static raft_net_cb_ctx_bool_t
+raft_server_client_recv_ignore_request(
+    struct raft_instance *ri, const struct raft_client_rpc_msg *rcm,
+    const struct sockaddr_in *from, struct ctl_svc_node **csn_out)
+{
+    NIOVA_ASSERT(rcm && from);
+
+    bool ignore_request = false;
+    const char *cause = NULL;
+
+    // Ensure this client's raft instance is consistent with ours.
+    int rc = raft_net_verify_sender_client_msg(ri, rcm->rcrm_raft_id);
+    if (rc)
+    {
+        cause = "raft_net_verify_sender_client_msg()";
+        ignore_request = true;
+    }
+    else
+    {
+        /* Lookup the client in the ctl-svc-node tree - existence is not
+         * mandatory.
+         */
+        struct ctl_svc_node *client_csn = NULL;
+        rc = ctl_svc_node_lookup(rcm->rcrm_sender_id, &client_csn);
+        if (rc)
+        {
+            DECLARE_AND_INIT_UUID_STR(sender_uuid,
+                                      rcm->rcrm_sender_id);
+            SIMPLE_LOG_MSG(LL_WARN, "ctl_svc_node_lookup(): %d uuid %s",
+                           rc, sender_uuid);
+            struct ctl_svc_node csn = {0};
+
+            rc = ctl_svc_node_init(&csn, rcm->rcrm_raft_id, rcm->rcrm_sender_id,
+                                   CTL_SVC_NODE_TYPE_RAFT_CLIENT);
+            if (!rc)
+                rc = ctl_svc_node_add(&csn, &client_csn);
+            //fallthrough. ignore_request will be set to true.
+        }
+
+        if (!rc && client_csn)
+        {
+            if (client_csn->csn_type == CTL_SVC_NODE_TYPE_RAFT_CLIENT)
+            {
+                if (!net_ctl_can_recv(&client_csn->csn_peer.csnp_net_ctl))
+                {
+                    cause = "recv from this UUID is disabled";
+                    ignore_request = true;
+                }
+            }
+            else
+            {
+                cause = "UUID does not belong to a client";
+                ignore_request = true;
+
+                DBG_CTL_SVC_NODE(
+                    LL_NOTIFY, client_csn,
+                    "recv'd RPC request from this non-client UUID");
+            }
+
+            if (ignore_request)
+                ctl_svc_node_put(client_csn);
+            else
+                *csn_out = client_csn;
+        }
+        else
+        {
+            cause = "CSN required";
+            ignore_request = true;
+        }
     }
+
+    if (ignore_request)
+        DBG_RAFT_CLIENT_RPC_SOCK(LL_NOTIFY, rcm, from, "%s (rc=%d)", cause, rc);
+
+    return ignore_request;
+}
+
+static void // raft_net_cb_ctx_t or raft_server_epoll_sm_apply_bool_t
+raft_server_net_client_request_init(
+    const struct raft_instance *ri,
+    struct raft_net_client_request_handle *rncr,
+    enum raft_net_client_request_type type,
+    const struct raft_client_rpc_msg *rpc_request,  const char *commit_data,
+    const size_t commit_data_size, const struct sockaddr_in *from,
+    char *reply_buf, const size_t reply_buf_size, bool is_direct_req)
+{
+    NIOVA_ASSERT(ri && rncr &&
+                 (is_direct_req ||
+                  (reply_buf &&
+                   reply_buf_size >= sizeof(struct raft_client_rpc_msg))));
+
+    (void)from;
+
+    if (type == RAFT_NET_CLIENT_REQ_TYPE_NONE)
+        FATAL_IF((!rpc_request || commit_data),
+                 "invalid argument:  rpc_request may only be specified");
+    else if (type == RAFT_NET_CLIENT_REQ_TYPE_COMMIT)
+        FATAL_IF((rpc_request || !commit_data),
+                 "invalid argument:  commit_data may only be specified");
     else
+        FATAL_MSG("invalid request type (%d)", type);
+
+    memset(rncr, 0, sizeof(struct raft_net_client_request_handle));
+
+    rncr->rncr_write_raft_entry = false;
+    rncr->rncr_type = type;
+
+    rncr->rncr_is_leader = raft_instance_is_leader(ri) ? true : false;
+    rncr->rncr_entry_term = ri->ri_log_hdr.rlh_term;
+    rncr->rncr_current_term = ri->ri_log_hdr.rlh_term;
+    rncr->rncr_is_direct_req = is_direct_req;
+
+    //direct request will not have reply buffer
+    if (reply_buf)
     {
-        DBG_RAFT_INSTANCE(
-            LL_WARN, ri,
-            "negative log-term %ld rci=%ld leader-prev-[idx:term]=%ld:%ld",
-            raerq->raerqm_log_term, raft_current_idx,
-            raerq->raerqm_prev_log_index, raerq->raerqm_prev_log_term);
+        //memset the reply_buf to make sure garbage values are not used from it.
+        memset(reply_buf, 0, reply_buf_size);
+
+        rncr->rncr_reply.rncr_reply_ptr =
+            (struct raft_client_rpc_msg  *)reply_buf;
     }
-    /* Check raerq->raerqm_prev_log_term - this is more of a sanity check to
-     * ensure that the verified idx, leaders_next_idx_for_me, proceeds a valid
-     * term of the prev-idx.
+
+    CONST_OVERRIDE(size_t, rncr->rncr_reply.rncr_reply_data_max_size,
+                   (reply_buf_size - sizeof(struct raft_client_rpc_msg)));
+
+
+    if (rpc_request)
+    {
+        rncr->rncr_request = rpc_request;
+        rncr->rncr_request_or_commit_data = rpc_request->rcrm_data;
+
+        CONST_OVERRIDE(size_t, rncr->rncr_request_or_commit_data_size,
+                       rpc_request->rcrm_data_size);
+
+        /* These are reply specific items which are only provided when this
+         * function is called from raft_net_udp_cb_ctx_t context.
+         */
+        raft_net_client_request_handle_set_reply_info(
+            rncr, rpc_request->rcrm_sender_id, rpc_request->rcrm_msg_id);
+
+        NIOVA_ASSERT(is_direct_req ||
+                     raft_net_client_request_handle_has_reply_info(rncr));
+    }
+    else
+    {
+        /* raft_net_client_request_handle_set_reply_info() must be called from
+         * SM context if a post-commit reply is to be made.
+         */
+        rncr->rncr_request_or_commit_data = commit_data;
+
+        CONST_OVERRIDE(size_t, rncr->rncr_request_or_commit_data_size,
+                       commit_data_size);
+
+        // Sanity check of raft_net_client_request_handle_has_reply_info()
+        NIOVA_ASSERT(!raft_net_client_request_handle_has_reply_info(rncr));
+    }
+}
+
+static raft_net_cb_ctx_t
+raft_server_net_client_request_init_client_rpc(
+    struct raft_instance *ri, struct raft_net_client_request_handle *rncr,
+    const struct raft_client_rpc_msg *rpc_request,
+    const struct sockaddr_in *from, char *reply_buf,
+    const size_t reply_buf_size, bool is_direct_req)
+{
+    NIOVA_ASSERT(ri && rncr && rpc_request);
+
+    raft_server_net_client_request_init(ri, rncr,
+                                        RAFT_NET_CLIENT_REQ_TYPE_NONE,
+                                        rpc_request, NULL, 0, from, reply_buf,
+                                        reply_buf_size, is_direct_req);
+
+    // Reply is not sent for direct request enqueued from leader.
+    if (!is_direct_req)
+        raft_server_client_reply_init(
+           ri, rncr, (rpc_request->rcrm_type == RAFT_CLIENT_RPC_MSG_TYPE_PING ?
+                   RAFT_CLIENT_RPC_MSG_TYPE_PING_REPLY :
+                   RAFT_CLIENT_RPC_MSG_TYPE_REPLY));
+}
+
+/**
+ * raft_server_write_coalesce_entry -
+ * Keep collecting the incoming writes in re_coalesce_write raft_entry.
+ */
+static void
+raft_server_write_coalesce_entry(struct raft_instance *ri, void *data, size_t len,
+                                void *app_data, size_t app_data_len,
+                                 enum raft_write_entry_opts opts)
+{
+    NIOVA_ASSERT(
+        ri && data && ri->ri_coalesced_wr &&
+        ri->ri_coalesced_wr->rcwi_nentries < RAFT_ENTRY_V2_NUM_ENTRIES_MAX &&
+        ri->ri_coalesced_wr->rcwi_total_size < RAFT_ENTRY_MAX_DATA_SIZE(ri));
+
+    (void)opts;
+
+    // Buffer should have space to accomodate this request.
+    FATAL_IF(raft_server_co_wr_data_size(ri->ri_coalesced_wr, 1,
+                                         len + app_data_len) >
+             RAFT_ENTRY_MAX_DATA_SIZE(ri),
+             "Coalesced buffer shouldn't be full here!. rcwi_total_size: %ld,"
+             " len: %ld",
+             ri->ri_coalesced_wr->rcwi_total_size, len + app_data_len);
+
+    struct raft_instance_co_wr *co_wr = ri->ri_coalesced_wr;
+
+    /* A write which would be issued by itself, since coalescing is disabled
+     * or the pipeline is idle, is not staged in the coalesce buffer.  Its
+     * data and app data are gathered by the backend straight from the
+     * client's buffers.
      */
-    if (raerq->raerqm_prev_log_index >= 0)
+    if (!co_wr->rcwi_nentries &&
+        (!ri->ri_coalesced_writes || raft_server_co_wr_pipeline_is_idle(ri)))
     {
-        int rc = raft_server_entry_header_read_by_store(
-            ri, &reh, raerq->raerqm_prev_log_index);
+        uint32_t entry_size = len + app_data_len;
+        struct iovec iov[2] = {
+            {.iov_base = data, .iov_len = len},
+            {.iov_base = app_data, .iov_len = app_data_len},
+        };
 
-        FATAL_IF((rc), "raft_server_entry_read(): %s", strerror(-rc));
-        FATAL_IF((reh.reh_term != raerq->raerqm_prev_log_term),
-                 "raerq->raerqm_prev_log_term=%ld != reh.reh_term=%ld",
-                 raerq->raerqm_prev_log_term, reh.reh_term);
-        FATAL_IF((raerq->raerqm_prev_idx_crc != reh.reh_crc),
-                 "crc (%u) does not match leader (%u) for idx=%ld",
-                 reh.reh_crc, raerq->raerqm_this_idx_crc,
-                 raerq->raerqm_prev_log_index);
+        if (ri->ri_coalesced_writes)
+            ri->ri_co_wr_flush_cnt[RAFT_CO_WR_FLUSH_IDLE]++;
+
+        raft_server_leader_write_new_entry(ri, iov,
+                                           (app_data && app_data_len) ? 2 : 1,
+                                           &entry_size, 1,
+                                           RAFT_WR_ENTRY_OPT_NONE,
+                                           &co_wr->rcwi_ws);
+
+        raft_server_co_wr_reset(co_wr);
+        return;
     }
 
-    DBG_RAFT_INSTANCE(
-        LL_DEBUG, ri,
-        "already-stored=yes rci=%ld leader-prev-[idx:term]=%ld:%ld",
-        raft_current_idx, raerq->raerqm_prev_log_index,
-        raerq->raerqm_prev_log_term);
+    /* Store the new write entry at the free slot at ri->ri_coalesced_wr.
+     * NOTE: that raft_server_write_coalesced_entries() will have reset
+     *    nentries so be sure to take the tmp variable AFTER calling it.
+     */
+
+
+    // The latency budget runs from the arrival of the oldest pending write
+    if (!ri->ri_coalesced_wr->rcwi_nentries)
+        niova_unstable_clock(&ri->ri_coalesced_wr->rcwi_first_ts);
+
+    //Copy the write request(*data) to the coalesced buffer
+    memcpy((ri->ri_coalesced_wr->rcwi_buffer +
+            ri->ri_coalesced_wr->rcwi_total_size), data, len);
+    uint32_t nentries = ri->ri_coalesced_wr->rcwi_nentries;
+    ri->ri_coalesced_wr->rcwi_entry_sizes[nentries] = len;
+    ri->ri_coalesced_wr->rcwi_total_size += len;
+
+    /* If the app_data is provided, copy it to the coalesced buffer.
+     * Note that app_data_len can be 0
+     */
+    if (app_data && app_data_len)
+    {
+        memcpy((ri->ri_coalesced_wr->rcwi_buffer +
+                ri->ri_coalesced_wr->rcwi_total_size), app_data, app_data_len);
+        ri->ri_coalesced_wr->rcwi_entry_sizes[nentries] += app_data_len;
+        ri->ri_coalesced_wr->rcwi_total_size += app_data_len;
+    }
+
+    ri->ri_coalesced_wr->rcwi_nentries++;
+
+    // Retest and push if the limits have been met or waiting gains nothing.
+    if (!ri->ri_coalesced_writes)
+    {
+        raft_server_write_coalesced_entries(ri, __func__,
+                                            RAFT_CO_WR_FLUSH_NONE);
+        return;
+    }
+
+    enum raft_co_wr_flush_reason reason =
+        raft_server_co_wr_flush_reason(ri, true);
+
+    if (reason != RAFT_CO_WR_FLUSH_NONE)
+        raft_server_write_coalesced_entries(ri, __func__, reason);
+    else
+        raft_server_leader_co_wr_timer_arm(ri);
+}
+
+static int
+raft_server_client_rncr_prepare(struct raft_instance *ri,
+                                const struct raft_client_rpc_msg *rcm,
+                                const struct sockaddr_in *from,
+                                struct raft_net_client_request_handle *rncr,
+                                enum raft_buf_set_type buf_type)
+{
+    NIOVA_ASSERT(ri && rcm && from && rncr && buf_type < RAFT_BUF_SET_MAX);
+
+    struct ctl_svc_node *csn = NULL;
+
+    // First set of request checks which are configuration based.
+    if (raft_server_client_recv_ignore_request(ri, rcm, from, &csn))
+    {
+        //XXX destroy the connection by setting tmc::tmc_user_error
+        SIMPLE_LOG_MSG(LL_NOTIFY, "cannot verify client message");
 
-    return true;
-}
+        if (csn != NULL)
+            ctl_svc_node_put(csn);
 
-/**
- * raft_server_append_entry_log_prune_if_needed - the local raft instance's
- *    log may need to be pruned if it extends beyond the prev_log_index
- *    presented by our leader.  Follower-ctx is assert here.
- */
-static raft_server_net_cb_follower_ctx_t
-raft_server_append_entry_log_prune_if_needed(
-    struct raft_instance *ri,
-    const struct raft_append_entries_request_msg *raerq)
-{
-    NIOVA_ASSERT(ri && raerq);
-    NIOVA_ASSERT(raft_instance_is_follower(ri));
-    // This value must have already been checked by the caller.
-    NIOVA_ASSERT(raerq->raerqm_prev_log_index >= RAFT_MIN_APPEND_ENTRY_IDX);
+        return -EXDEV;
+    }
 
-    const int64_t raft_entry_idx_prune = raerq->raerqm_prev_log_index + 1;
+    struct buffer_item *bi =
+        buffer_set_allocate_item(raft_instance_buf_set(ri, buf_type));
 
-    /* Forcing a sync here will prevent the sync-thread from persisting new
-     * log entries which may be beyond raerqm_prev_log_index (which is where
-     * we're truncating to..).
-     */
-    int rc = raft_server_backend_sync(ri, __func__);
-    DBG_RAFT_INSTANCE_FATAL_IF((rc), ri, "raft_server_backend_sync(): %s",
-                               strerror(-rc));
+    NIOVA_ASSERT(bi);
 
-    DBG_RAFT_INSTANCE(LL_WARN, ri,
-                      "raerqm_prev_log_term=%ld raerqm_prev_log_index=%ld",
-                      raerq->raerqm_prev_log_term,
-                      raerq->raerqm_prev_log_index);
+    raft_server_net_client_request_init_client_rpc(ri, rncr, rcm, from,
+                                                   (char *)bi->bi_iov.iov_base,
+                                                   bi->bi_bs->bs_item_size,
+                                                   false);
 
-    // We must not prune already committed transactions.
-    DBG_RAFT_INSTANCE_FATAL_IF(
-        (ri->ri_commit_idx >= raft_entry_idx_prune ||
-         ri->ri_last_applied.rla_idx >= raft_entry_idx_prune),
-        ri, "cannot prune committed entry raerq-nli=%ld",
-        raft_entry_idx_prune);
+    // raft_server_net_client_request_init_client_rpc() clears out the rncr
+    rncr->rncr_bi = bi;
+    rncr->rncr_csn = csn;
 
-    if (raerq->raerqm_prev_log_index >= 0)
+    // Perform this check before handing back the rncr.
+    int rc = raft_server_may_accept_client_request(ri);
+    if (rc)
     {
-        struct raft_entry_header reh;
+        SIMPLE_LOG_MSG(LL_NOTIFY,
+                       "cannot accept client message, rc=%d: msg-type=%u",
+                       rc, rcm->rcrm_type);
 
-        /* Read the block at the leader's index and apply it to our header.
-         * We don't call raft_server_entry_next_entry_is_valid() since the log
-         * sequence had been verified already at startup.
-         */
-        int rc = raft_server_entry_header_read_by_store(
-            ri, &reh, raerq->raerqm_prev_log_index);
+        raft_server_deny_client_request(ri, rncr, csn, rc);
 
-        FATAL_IF((rc), "raft_server_entry_header_read_by_store(): %s",
-                 strerror(-rc));
+        if (rncr->rncr_csn)
+        {
+            ctl_svc_node_put(rncr->rncr_csn);
+            rncr->rncr_csn = NULL;
+        }
 
-        raft_instance_update_newest_entry_hdr(ri, &reh, RI_NEHDR_ALL, true);
+        if (rncr->rncr_bi)
+        {
+            buffer_set_release_item(rncr->rncr_bi);
+            rncr->rncr_bi = NULL;
+        }
     }
 
-    // truncate the log.
-    raft_server_log_truncate(ri);
+    return rc;
 }
 
-static raft_server_net_cb_follower_ctx_int_t
-raft_server_follower_index_ahead_of_leader(
-    struct raft_instance *ri,
-    const struct raft_append_entries_request_msg *raerq,
-    struct raft_entry_header *reh)
+static void
+raft_server_client_rncr_write_raft_entry(
+    struct raft_instance *ri, struct raft_net_client_request_handle *rncr)
 {
-    NIOVA_ASSERT(ri && raerq && reh);
+    // Xxx Also check that this is the 'main' thread
+    NIOVA_ASSERT(ri && rncr && rncr->rncr_write_raft_entry &&
+                 rncr->rncr_request);
 
-    int rc = 0;
+    const struct raft_client_rpc_msg *rcm = rncr->rncr_request;
 
-    /* If this follower's index is ahead of the leader's then we must check
-     * for a retried AE which has already been stored in our log.
-     * Note that this AE may have been delayed in the network or may have
-     * retried due to a dropped reply.  It's important that we try to ACK
-     * this request and not proceed with modifying our log.
+    /* For write operation, check if the coalesced buffer is sufficient for
+     * accomodating this request. Otherwise first flush the entries in
+     * coalesced buffer.  The entry count and the merged write supplements
+     * are bounded as well.
      */
-    if (raft_server_append_entry_check_already_stored(ri, raerq))
-    {
-        rc = -EALREADY;
-    }
-    else // Otherwise, the log needs to be pruned.
+    const struct raft_instance_co_wr *co_wr = ri->ri_coalesced_wr;
+
+    if (raft_server_co_wr_data_size(
+            co_wr, 1, (rcm->rcrm_data_size +
+                       rncr->rncr_app_data.rncr_app_data_size)) >
+        RAFT_ENTRY_MAX_DATA_SIZE(ri) ||
+        co_wr->rcwi_nentries >= raft_server_co_wr_max_entries(ri) ||
+        (co_wr->rcwi_ws.rnsws_nitems +
+         rncr->rncr_sm_write_supp.rnsws_nitems) > RAFT_NET_WR_SUPP_MAX)
     {
-        raft_server_append_entry_log_prune_if_needed(ri, raerq);
-        NIOVA_ASSERT(!raft_server_has_unsynced_entries(ri));
+        raft_server_write_coalesced_entries(ri, __func__,
+                                            RAFT_CO_WR_FLUSH_FULL);
     }
-    /* The log may have been synced and/or pruned - re-obtain the
-     * current_idx.
-     * Note:  if a sync occurred then the synced idx will be equivalent to
-     *        the unsynced idx.
+
+    /* Store the request as an entry in the Raft log.  Do not reply to
+     * the client until the write is committed and applied!
+     *
+     * NOTE: that raft_server_write_coalesce_entry() is called regardless
+     *       of whether coalescing is enabling.  If disabled,
+     *       raft_server_write_coalesce_entry() will go directly to
+     *       raft_server_leader_write_new_entry()
+     * Merge the rncr write supplement into coalesced write supplement.
+     * rncr_sm_write_supp will be destroyed once it is merged into
+     * ri_coalesced_wr->rcwi_ws.
      */
-    raft_instance_get_newest_header(ri, reh, RI_NEHDR_SYNC);
+    raft_net_sm_write_supplements_merge(&ri->ri_coalesced_wr->rcwi_ws,
+                                        &rncr->rncr_sm_write_supp);
 
-    return rc;
+    raft_server_write_coalesce_entry(
+        ri, (void *)rcm->rcrm_data, rcm->rcrm_data_size,
+        (void *)rncr->rncr_app_data.rncr_app_data_ptr,
+        rncr->rncr_app_data.rncr_app_data_size, RAFT_WR_ENTRY_OPT_NONE);
 }
 
-/**
- * raft_server_append_entry_request_bounds_check - helper function used to
- *    detect the case where a follower has undergone bulk recovery but the leader
- *    still contains prev-log-index info from the follower's pre-recovery
- *    state.  This function prevents the follower from executing log reads
- *    which will fail since the requested entry does not exist on the follower.
- */
-static raft_server_net_cb_follower_ctx_int_t
-raft_server_append_entry_request_bounds_check(
-    struct raft_instance *ri,
-    const struct raft_append_entries_request_msg *raerq)
+static void
+raft_server_client_rncr_release(struct raft_net_client_request_handle *rncr)
 {
-    NIOVA_ASSERT(ri && raerq);
+    if (rncr->rncr_csn)
+        ctl_svc_node_put(rncr->rncr_csn);
 
-    const struct raft_rpc_msg *rrm =
-        OFFSET_CAST(raft_rpc_msg, rrm_append_entries_request, raerq);
+    if (rncr->rncr_bi)
+        buffer_set_release_item(rncr->rncr_bi);
+}
 
-    /* Sanity check the leader's request.  If the leader's lowest index is
-     * higher than the pli then don't proceed with this msg.
-     */
-    if (raerq->raerqm_prev_log_index != RAFT_ENTRY_IDX_ANY &&
-        raerq->raerqm_prev_log_index < raerq->raerqm_lowest_index)
-    {
-        DBG_RAFT_MSG(LL_WARN, rrm, "pli < leader-lowest-idx");
-        return -EBADR;
-    }
-    // Don't proceed if we will be unable to read the requested index
-    else if (raerq->raerqm_prev_log_index <
-             niova_atomic_read(&ri->ri_lowest_idx))
+static void
+raft_server_client_rncr_complete(struct raft_instance *ri,
+                                 struct raft_net_client_request_handle *rncr,
+                                 int sm_cb_rc)
+{
+    NIOVA_ASSERT(ri && rncr && rncr->rncr_request);
+
+    const struct raft_client_rpc_msg *rcm = rncr->rncr_request;
+
+    // Check leadership state before replying
+    int rc = raft_server_may_accept_client_request(ri);
+    if (rc || sm_cb_rc)
     {
-        DBG_RAFT_MSG(LL_WARN, rrm, "pli < my-lowest-idx (%lld)",
-                     niova_atomic_read(&ri->ri_lowest_idx));
-        return -EBADR;
+        SIMPLE_LOG_MSG(LL_NOTIFY,
+                       "cannot accept client message, rc=(%d, %d): msg-type=%u",
+                       rc, sm_cb_rc, rcm->rcrm_type);
+
+        rc = rc ? rc : sm_cb_rc;
+
+        raft_server_deny_client_request(ri, rncr, rncr->rncr_csn, rc);
     }
-    else if (raerq->raerqm_entry_out_of_range)
+    else
     {
-        DBG_RAFT_MSG(LL_WARN, rrm, "leader read failed with -ERANGE");
-        return -EBADR;
+        if (rncr->rncr_write_raft_entry)
+            raft_server_client_rncr_write_raft_entry(ri, rncr);
+        else
+            raft_server_reply_to_client(ri, rncr, rncr->rncr_csn);
     }
 
-    return 0;
+    raft_server_client_rncr_release(rncr);
 }
 
-/**
- * raft_server_append_entry_log_prepare_and_check - determine if the current
- *    append entry command can proceed to this follower's log.  This function
- *    returns two errors to the caller but in both cases the caller will
- *    reply to the leader with the "general" error 'non_matching_prev_term'.
- *    causing the leader to decrement its prev_log_index value for this
- *    follower and retry.  NOTE:  this function will truncate / prune the log
- *    according to the index value presented in the raerq.
- */
-static raft_server_net_cb_follower_ctx_int_t
-raft_server_append_entry_log_prepare_and_check(
-    struct raft_instance *ri,
-    const struct raft_append_entries_request_msg *raerq)
+static raft_net_cb_ctx_t
+raft_server_client_recv_handler_ping(struct raft_instance *ri,
+                                     const struct raft_client_rpc_msg *rcm,
+                                     const struct sockaddr_in *from)
 {
-    NIOVA_ASSERT(ri && raerq);
-
-    int rc = raft_server_append_entry_request_bounds_check(ri, raerq);
-    if (rc)
-        return rc;
-
-    struct raft_entry_header reh = {0};
-    raft_instance_get_newest_header(ri, &reh, RI_NEHDR_UNSYNC);
-
-    // raft_server_follower_index_ahead_of_leader() may update reh
-    rc = (reh.reh_index > raerq->raerqm_prev_log_index) ?
-        raft_server_follower_index_ahead_of_leader(ri, raerq, &reh) : 0;
-
-    if (rc)
-        return rc;
-
-    // At this point, current_idx should not exceed the one from the leader.
-    NIOVA_ASSERT(reh.reh_index <= raerq->raerqm_prev_log_index);
+    NIOVA_ASSERT(ri && rcm && rcm->rcrm_type == RAFT_CLIENT_RPC_MSG_TYPE_PING);
 
-    /* In this case, the leader's and follower's indexes have yet to converge
-     * which implies a "non_matching_prev_term" since the term isn't testable
-     * until the indexes match.
-     */
-    if (reh.reh_index < raerq->raerqm_prev_log_index)
-        rc = -ERANGE;
+    struct raft_net_client_request_handle rncr = {0};
 
-    /* Equivalent log indexes but the terms do not match.  Note that this cond
-     * will likely lead to more pruning as the leader continues to decrement
-     * its raerqm_prev_log_index value for this follower.
-     */
-    else if (reh.reh_term != raerq->raerqm_prev_log_term)
-        rc = -EEXIST;
+    int rc = raft_server_client_rncr_prepare(ri, rcm, from, &rncr,
+                                             RAFT_BUF_SET_SMALL);
+    if (rc == -EXDEV)
+        return;
 
-    DBG_RAFT_INSTANCE((raerq->raerqm_heartbeat_msg ? LL_DEBUG : LL_NOTIFY), ri,
-                      "rci=%ld leader-prev-[idx:term]=%ld:%ld (erange=%hhu) rc=%d",
-                      reh.reh_index, raerq->raerqm_prev_log_index,
-                      raerq->raerqm_prev_log_term,
-                      raerq->raerqm_entry_out_of_range, rc);
+    SIMPLE_LOG_MSG(LL_NOTIFY, "ping reply");
 
-    return rc;
+    raft_server_client_rncr_complete(ri, &rncr, rc);
 }
 
 /**
- * raft_server_process_append_entries_term_check_ops - this function handles
- *    important details for the AE request.  It will return -ESTALE if the
- *    sender is not a valid leader (per term check).  Once the term has been
- *    validated, this function will take care of self-demotion (if this
- *    instance is a candidate) and will sync the term number to the log header
- *    if the provided term had not yet been seen.  Lastly, it will apply the
- *    csn pointer to the raft-instance if the leader is newly minted.
- * @ri:  raft instance
- * @sender_csn:  the ctl-svc-node for sender of the AE request.
- * @raerq:  contents of the AE message.
+ * raft_server_read_worker_reply - hands a read which has been serviced by a
+ *    worker to the main raft thread and waits for the reply to be sent.  The
+ *    leadership check, reply, and request handle release all occur in
+ *    raft_server_read_reply_evp_cb() so that the worker never touches the
+ *    raft or net state.  Waiting here keeps the worker's reply buffer and the
+ *    request copy stable until the main thread is done with them.
  */
-static raft_server_net_cb_ctx_int_t
-raft_server_process_append_entries_term_check_ops(
-    struct raft_instance *ri,
-    struct ctl_svc_node *sender_csn,
-    const struct raft_append_entries_request_msg *raerq)
+static void
+raft_server_read_worker_reply(struct raft_instance *ri,
+                              struct raft_read_work *rrw,
+                              struct raft_net_client_request_handle *rncr,
+                              int sm_cb_rc)
 {
-    NIOVA_ASSERT(ri && sender_csn && raerq);
+    NIOVA_ASSERT(ri && rrw && rncr);
 
-    // My term is newer which means this sender is a stale leader.
-    if (ri->ri_log_hdr.rlh_term > raerq->raerqm_leader_term)
-        return -ESTALE;
+    struct raft_work_queue *rwq = &ri->ri_read_reply_queue;
 
-    const int64_t leader_term = raerq->raerqm_leader_term;
+    niova_mutex_lock(&rwq->rsw_mutex);
 
-    // -- Sender's term is greater than or equal to my own --
+    // The main thread is no longer servicing replies, drop the request
+    if (!ri->ri_read_reply_queue_open)
+    {
+        niova_mutex_unlock(&rwq->rsw_mutex);
+        raft_server_client_rncr_release(rncr);
+        return;
+    }
 
-    // Demote myself if candidate
-    if (ri->ri_log_hdr.rlh_term <= leader_term &&
-        (raft_instance_is_candidate(ri) ||
-         raft_instance_is_candidate_prevote(ri)))
-        raft_server_becomes_follower(ri, leader_term, sender_csn->csn_uuid,
-                                     RAFT_BFRSN_STALE_TERM_WHILE_CANDIDATE);
+    rrw->rrw_rncr = rncr;
+    rrw->rrw_sm_rc = sm_cb_rc;
+    rrw->rrw_replied = false;
 
-    // Demote myself if stale leader
-    else if (ri->ri_log_hdr.rlh_term < leader_term &&
-             raft_instance_is_leader(ri))
-        raft_server_becomes_follower(ri, leader_term, sender_csn->csn_uuid,
-                                     RAFT_BFRSN_STALE_TERM_WHILE_LEADER);
+    STAILQ_INSERT_TAIL(&rwq->rsw_queue, rrw, rrw_lentry);
+    rwq->rsw_depth++;
 
-    // Follower detects leader with a higher term
-    else if (ri->ri_log_hdr.rlh_term < leader_term &&
-             raft_instance_is_follower(ri))
-        raft_server_try_update_log_header_null_voted_for_peer(ri, leader_term);
+    niova_mutex_unlock(&rwq->rsw_mutex);
 
-    // Apply leader csn pointer
-    raft_server_set_leader_csn(ri, sender_csn);
+    RAFT_NET_EVP_NOTIFY_NO_FAIL(ri, RAFT_EVP_READ_REPLY);
 
-    return 0;
+    niova_mutex_lock(&rwq->rsw_mutex);
+
+    while (!rrw->rrw_replied)
+        pthread_cond_wait(&rwq->rsw_cond, &rwq->rsw_mutex);
+
+    niova_mutex_unlock(&rwq->rsw_mutex);
 }
 
 /**
- * raft_server_write_new_entry_from_leader - the log write portion of the
- *    AE operation.  The log index is derived from the raft-instance which
- *    must match the index provided by the leader in raerq,
+ * raft_server_client_read_process - services a client read request.  When
+ *    called from a read worker, the request has already been verified and
+ *    accepted by the main thread.  The worker's reply buffer is used and the
+ *    reply is sent by the main thread.  Otherwise, the request is verified
+ *    here, the reply buffer is taken from the large buffer_set and the reply
+ *    is sent inline.
  */
-static raft_server_net_cb_follower_ctx_t
-raft_server_write_new_entry_from_leader(
-    struct raft_instance *ri,
-    const struct raft_append_entries_request_msg *raerq)
+static void
+raft_server_client_read_process(struct raft_instance *ri,
+                                const struct raft_client_rpc_msg *rcm,
+                                const struct sockaddr_in *from,
+                                struct raft_rw_worker_thread *rrwt)
 {
-    NIOVA_ASSERT(ri && raerq);
-    NIOVA_ASSERT(raft_instance_is_follower(ri));
-
-    if (raerq->raerqm_heartbeat_msg) // heartbeats don't enter the log
-        return;
-
-    struct raft_entry_header unsync_hdr = {0};
-    raft_instance_get_newest_header(ri, &unsync_hdr, RI_NEHDR_UNSYNC);
-
-    NIOVA_ASSERT(raerq->raerqm_log_term > 0);
-    NIOVA_ASSERT(raerq->raerqm_log_term >= raerq->raerqm_prev_log_term);
-    NIOVA_ASSERT(raerq->raerqm_log_term >= unsync_hdr.reh_term);
-
-    const size_t entry_size = raerq->raerqm_entries_sz;
-    const uint8_t num_entries = raerq->raerqm_num_entries;
+    NIOVA_ASSERT(rcm && rcm->rcrm_type == RAFT_CLIENT_RPC_MSG_TYPE_READ);
 
-    // Msg size of '0' is OK.
-    NIOVA_ASSERT(entry_size <= RAFT_ENTRY_MAX_DATA_SIZE(ri));
+    struct raft_net_client_request_handle rncr = {0};
 
-    // Sanity check on the 'next' idx to be written.
-    NIOVA_ASSERT(unsync_hdr.reh_index == raerq->raerqm_prev_log_index);
+    if (rrwt)
+    {
+        raft_server_net_client_request_init_client_rpc(ri, &rncr, rcm, from,
+                                                       rrwt->rrwt_reply_buff,
+                                                       RAFT_BS_LARGE_SZ,
+                                                       false);
 
-    enum raft_write_entry_opts opts = raerq->raerqm_leader_change_marker ?
-        RAFT_WR_ENTRY_OPT_LEADER_CHANGE_MARKER : RAFT_WR_ENTRY_OPT_NONE;
+        // The csn ref taken by the main thread passes to the rncr
+        rncr.rncr_csn = rrwt->rrwt_work->rrw_csn;
+        rrwt->rrwt_work->rrw_csn = NULL;
+    }
+    else if (raft_server_client_rncr_prepare(ri, rcm, from, &rncr,
+                                             RAFT_BUF_SET_LARGE))
+    {
+        return;
+    }
 
-    if (opts & RAFT_WR_ENTRY_OPT_LEADER_CHANGE_MARKER)
-        NIOVA_ASSERT(num_entries == 1);
+    /* Call into the application state machine logic to retrieve the requested
+     * data.
+     */
+    int rc = ri->ri_server_sm_request_cb(&rncr);
 
-    raft_server_write_next_entry(ri, raerq->raerqm_log_term,
-                                 raerq->raerqm_entries, raerq->raerqm_size_arr,
-                                 num_entries, opts, NULL);
+    if (rrwt)
+        raft_server_read_worker_reply(ri, rrwt->rrwt_work, &rncr, rc);
+    else
+        raft_server_client_rncr_complete(ri, &rncr, rc);
 }
 
 /**
- * raft_server_process_append_entries_request_prep_reply - helper function for
- *    raft_server_process_append_entries_request() which does some general
- *    AE reply setup.
+ * raft_server_read_worker_enqueue - copies the read request into a work item
+ *    and places it onto the least loaded read worker's queue.  Returns an
+ *    error if the pool is not running, if all queues have reached
+ *    RAFT_SERVER_READ_QUEUE_MAX_DEPTH, or if the item could not be allocated.
+ *    In these cases, the caller processes the request inline.  On success,
+ *    the item takes the caller's 'csn' reference.
  */
-static raft_server_net_cb_ctx_t
-raft_server_process_append_entries_request_prep_reply(
-    struct raft_instance *ri, struct raft_rpc_msg *reply,
-    const struct raft_append_entries_request_msg *raerq,
-    bool stale_term, bool non_matching_prev_term, bool update_sli,
-    const int rc)
+static int
+raft_server_read_worker_enqueue(struct raft_instance *ri,
+                                const struct raft_client_rpc_msg *rcm,
+                                const ssize_t recv_bytes,
+                                const struct sockaddr_in *from,
+                                struct ctl_svc_node *csn)
 {
-    reply->rrm_type = RAFT_RPC_MSG_TYPE_APPEND_ENTRIES_REPLY;
+    NIOVA_ASSERT(ri && rcm && from && recv_bytes > 0);
 
-    reply->rrm_append_entries_reply.raerpm_leader_term =
-        ri->ri_log_hdr.rlh_term;
+    if (!ri->ri_num_read_workers)
+        return -ENOENT;
 
-    reply->rrm_append_entries_reply.raerpm_prev_log_index =
-        raerq->raerqm_prev_log_index;
+    struct raft_rw_worker_thread *rrwt = NULL;
+    size_t min_depth = SIZE_MAX;
 
-    reply->rrm_append_entries_reply.raerpm_heartbeat_msg =
-        raerq->raerqm_heartbeat_msg;
+    // Unlocked reads of the depth are sufficient for selecting a worker
+    for (size_t i = 0; i < ri->ri_num_read_workers; i++)
+    {
+        struct raft_rw_worker_thread *tmp = &ri->ri_reader_thread_ctl[i];
+        if (tmp->rrwt_queue.rsw_depth < min_depth)
+        {
+            min_depth = tmp->rrwt_queue.rsw_depth;
+            rrwt = tmp;
+        }
+    }
 
-    const raft_entry_idx_t current_idx =
-        raft_server_get_current_raft_entry_index(ri, RI_NEHDR_SYNC);
+    if (!rrwt || min_depth >= RAFT_SERVER_READ_QUEUE_MAX_DEPTH)
+        return -EAGAIN;
 
-    struct raft_append_entries_reply_msg *rae_reply =
-        &reply->rrm_append_entries_reply;
+    struct raft_read_work *rrw =
+        niova_malloc_can_fail(sizeof(struct raft_read_work) + recv_bytes);
+    if (!rrw)
+        return -ENOMEM;
 
-    /* Issue #27 - explicitly tell the leader if we're newly initialized
-     * to remove any ambiguity about the use of the raerpm_synced_log_index
-     * value.  `raerpm_newly_initialized_peer == 0` will allow the leader to
-     * set our next-idx to '0'.
-     */
-    rae_reply->raerpm_newly_initialized_peer =
-        current_idx == RAFT_ENTRY_IDX_ANY ? 1 : 0;
+    rrw->rrw_from = *from;
+    rrw->rrw_csn = csn;
+    rrw->rrw_len = recv_bytes;
+    memcpy(rrw->rrw_buf, rcm, recv_bytes);
+    clock_gettime(CLOCK_MONOTONIC, &rrw->rrw_enqueue_time);
 
-    // Issue #27 - send synced-log-index in non_matching_prev_term case too
-    rae_reply->raerpm_synced_log_index =
-        (!rc || non_matching_prev_term) ? current_idx : RAFT_ENTRY_IDX_ANY;
+    struct raft_work_queue *rwq = &rrwt->rrwt_queue;
 
-    raft_server_set_uuids_in_rpc_msg(ri, reply);
+    niova_mutex_lock(&rwq->rsw_mutex);
 
-    // update_sli takes priority over raerpm_err_non_matching_prev_term
-    rae_reply->raerpm_update_sli = update_sli;
-    rae_reply->raerpm_err_stale_term = stale_term;
-    rae_reply->raerpm_err_non_matching_prev_term = non_matching_prev_term;
-}
+    STAILQ_INSERT_TAIL(&rwq->rsw_queue, rrw, rrw_lentry);
+    rwq->rsw_depth++;
 
-static raft_server_net_cb_ctx_int_t
-raft_server_process_append_entries_request_validity_check(
-    const struct raft_instance *ri,
-    const struct raft_append_entries_request_msg *raerq)
-{
-    NIOVA_ASSERT(raerq);
+    if (rwq->rsw_depth > rrwt->rrwt_max_depth)
+        rrwt->rrwt_max_depth = rwq->rsw_depth;
 
-    // Do some basic verification of the AE msg contents.
-    if (raerq->raerqm_prev_log_index < RAFT_MIN_APPEND_ENTRY_IDX ||
-        raerq->raerqm_entries_sz > RAFT_ENTRY_MAX_DATA_SIZE(ri))
-        return -EINVAL;
+    pthread_cond_signal(&rwq->rsw_cond);
+
+    niova_mutex_unlock(&rwq->rsw_mutex);
 
     return 0;
 }
 
-static raft_server_net_cb_ctx_t
-raft_server_advance_commit_idx(struct raft_instance *ri,
-                               const int64_t new_commit_idx)
+static raft_net_cb_ctx_t
+raft_server_client_recv_handler_read(struct raft_instance *ri,
+                                     const struct raft_client_rpc_msg *rcm,
+                                     const ssize_t recv_bytes,
+                                     const struct sockaddr_in *from)
 {
-    NIOVA_ASSERT(ri);
+    NIOVA_ASSERT(rcm && rcm->rcrm_type == RAFT_CLIENT_RPC_MSG_TYPE_READ);
 
-    /* This peer may be behind, don't advance the commit index past our
-     * current raft index.
+    if (!ri->ri_num_read_workers)
+        return raft_server_client_read_process(ri, rcm, from, NULL);
+
+    /* The request checks, and any deny or redirect reply, are done here in
+     * the main raft thread so that the read workers only run the SM callback.
      */
-    if (ri->ri_commit_idx < new_commit_idx &&
-        (raft_server_get_current_raft_entry_index(ri, RI_NEHDR_SYNC) >=
-         new_commit_idx))
+    struct ctl_svc_node *csn = NULL;
+
+    if (raft_server_client_recv_ignore_request(ri, rcm, from, &csn))
     {
-        DBG_RAFT_INSTANCE(LL_NOTIFY, ri, "new_commit_idx=%ld", new_commit_idx);
+        SIMPLE_LOG_MSG(LL_NOTIFY, "cannot verify client message");
 
-        ri->ri_commit_idx = new_commit_idx;
+        if (csn != NULL)
+            ctl_svc_node_put(csn);
 
-        RAFT_NET_EVP_NOTIFY_NO_FAIL(ri, RAFT_EVP_SM_APPLY);
+        return;
     }
+
+    if (!raft_server_may_accept_client_request(ri) &&
+        !raft_server_read_worker_enqueue(ri, rcm, recv_bytes, from, csn))
+        return;
+
+    if (csn != NULL)
+        ctl_svc_node_put(csn);
+
+    // The checks are repeated on the inline path which also sends the deny
+    raft_server_client_read_process(ri, rcm, from, NULL);
 }
 
-static raft_server_net_cb_ctx_t
-raft_server_append_entry_reply_send(
-    struct raft_instance *ri,
-    const struct raft_append_entries_request_msg *raerq,
-    struct ctl_svc_node *sender_csn, bool stale_term,
-    bool non_matching_prev_term, bool update_sli, const int ae_rc)
+static void // must be the main raft thread
+raft_server_do_client_write(struct raft_instance *ri,
+                            struct raft_net_client_request_handle *rncr)
 {
-    struct raft_rpc_msg rreply_msg = {0};
+    // Need to ensure this is NOT tcp_mgr_thread_ctx()!
+    NIOVA_ASSERT(
+        ri && rncr->rncr_request &&
+        rncr->rncr_request->rcrm_type == RAFT_CLIENT_RPC_MSG_TYPE_WRITE);
 
-    raft_server_process_append_entries_request_prep_reply(
-        ri, &rreply_msg, raerq, stale_term, non_matching_prev_term,
-        update_sli, ae_rc);
+    NIOVA_ASSERT(rncr->rncr_bi != NULL);
+
+    const struct raft_client_rpc_msg *rcm = rncr->rncr_request;
+
+    /* Call into the application state machine logic.  There are several
+     * outcomes here:
+     * 1. SM detects a new write, here it may store sender info for reply
+     *    post-commit.
+     * 2. SM detects a write which had already been committed, here we reply
+     *    to the client notifying it of the completion.
+     * 3. SM detects a write which is still in progress, here no reply is sent.
+     */
+    niova_mutex_lock(&ri->ri_write_mutex);
+
+    int rc = ri->ri_server_sm_request_cb(rncr);
+
+    enum log_level log_level = rc ? LL_WARN : LL_DEBUG;
+
+    DBG_RAFT_CLIENT_RPC(log_level, rcm, "write-2-raft=%s op_error=%s, rc=%s",
+                        rncr->rncr_write_raft_entry ? "yes" : "no",
+                        strerror(-rncr->rncr_op_error), strerror(-rc));
+
+    raft_server_client_rncr_complete(ri, rncr, rc);
+
+    niova_mutex_unlock(&ri->ri_write_mutex);
+}
+
+static void
+raft_server_client_recv_handler_write(struct raft_instance *ri,
+                                      const struct raft_client_rpc_msg *rcm,
+                                      const struct sockaddr_in *from)
+{
+    NIOVA_ASSERT(rcm && rcm->rcrm_type == RAFT_CLIENT_RPC_MSG_TYPE_WRITE);
+
+    struct raft_net_client_request_handle rncr = {0};
+
+    int rc = raft_server_client_rncr_prepare(ri, rcm, from, &rncr,
+                                             RAFT_BUF_SET_LARGE);
+    if (rc)
+        return;
+
+    return raft_server_do_client_write(ri, &rncr);
+}
+
+static raft_net_cb_ctx_t
+raft_server_client_recv_handler(struct raft_instance *ri,
+                                const char *recv_buffer, ssize_t recv_bytes,
+                                const struct sockaddr_in *from)
+{
+    SIMPLE_FUNC_ENTRY(LL_TRACE);
+    NIOVA_ASSERT(ri && from);
+
+    if (!recv_buffer || !recv_bytes || !ri->ri_server_sm_request_cb ||
+        recv_bytes < (ssize_t)sizeof(struct raft_client_rpc_msg))
+    {
+        LOG_MSG(LL_NOTIFY, "sanity check fail, buf %p bytes %ld cb %p",
+                recv_buffer, recv_bytes, ri->ri_server_sm_request_cb);
+        return;
+    }
+
+    const struct raft_client_rpc_msg *rcm =
+        (const struct raft_client_rpc_msg *)recv_buffer;
+
+    switch (rcm->rcrm_type)
+    {
+    case RAFT_CLIENT_RPC_MSG_TYPE_READ:
+        return raft_server_client_recv_handler_read(ri, rcm, recv_bytes,
+                                                    from);
+
+    case RAFT_CLIENT_RPC_MSG_TYPE_WRITE:
+        return raft_server_client_recv_handler_write(ri, rcm, from);
 
-    int rc = raft_server_send_msg(ri, RAFT_UDP_LISTEN_SERVER, sender_csn,
-                                  &rreply_msg);
+    case RAFT_CLIENT_RPC_MSG_TYPE_PING:
+        return raft_server_client_recv_handler_ping(ri, rcm, from);
 
-    DBG_RAFT_INSTANCE_FATAL_IF((rc), ri, "raft_server_send_msg(): %s",
-                               strerror(rc));
+    default:
+        //Xxx end the connection
+        break;
+    };
 }
 
-int
-raft_server_init_recovery_handle_from_marker(struct raft_instance *ri,
-                                             const char *db_uuid_str,
-                                             const char *peer_uuid_str)
+/**
+ * raft_server_append_entry_should_send_to_follower - helper function which
+ *    manages the rfi_ae_sends_wait_until value for the given peer_idx.
+ *    It returns a true when either the peer is not detected as unresponsive
+ *    or after the waiting period has passed.
+ */
+static bool
+raft_server_append_entry_should_send_to_follower(
+    struct raft_instance *ri,
+    const raft_peer_t raft_peer_idx)
 {
-    if (!ri || !peer_uuid_str || !db_uuid_str)
-        return -EINVAL;
+    NIOVA_ASSERT(ri && ri->ri_csn_raft &&
+                 raft_member_idx_is_valid(ri, raft_peer_idx));
 
-    uuid_t peer_uuid, db_uuid;
+    struct raft_follower_info *rfi =
+        raft_server_get_follower_info(ri, raft_peer_idx);
 
-    if (uuid_parse(peer_uuid_str, peer_uuid) ||
-        uuid_parse(db_uuid_str, db_uuid) ||
-        uuid_is_null(peer_uuid) || uuid_is_null(db_uuid))
-        return -EINVAL;
+    unsigned long long now_msec = niova_unstable_coarse_clock_get_msec();
+    unsigned long long since_last_unacked = 0;
 
-    struct raft_recovery_handle *rrh = raft_instance_2_recovery_handle(ri);
+    int rc = raft_net_comm_recency(ri, raft_peer_idx,
+                                   RAFT_COMM_RECENCY_UNACKED_SEND,
+                                   &since_last_unacked);
+    if (rc == -EALREADY)
+        return false;
+    NIOVA_ASSERT(!rc);
 
-    uuid_copy(rrh->rrh_peer_uuid, peer_uuid);
-    uuid_copy(rrh->rrh_peer_db_uuid, db_uuid);
+    bool send_msg = true;
 
-    rrh->rrh_peer_chkpt_idx = -1UL;
-    rrh->rrh_chkpt_size = -1UL;
-    rrh->rrh_remaining = -1UL;
-    rrh->rrh_from_recovery_marker = true;
+    if (since_last_unacked > 0) // No recv'd msgs since last send.
+    {
+        if (now_msec > rfi->rfi_ae_sends_wait_until)
+            rfi->rfi_ae_sends_wait_until =
+                (now_msec +
+                 MIN(RAFT_NET_MAX_RETRY_MS,
+                     (rfi->rfi_ae_sends_wait_until * 2 + 1)));
+        else
+            send_msg = false;
+    }
+    else
+    {
+        rfi->rfi_ae_sends_wait_until = 0;
+    }
 
-    niova_realtime_coarse_clock(&rrh->rrh_start);
+    const raft_entry_idx_t unsync_idx =
+        raft_server_get_current_raft_entry_index(ri, RI_NEHDR_UNSYNC);
 
-    return 0;
+    // This is not a recency check and should be in a separate function Xxx
+    if (rfi->rfi_next_idx > unsync_idx)
+    {
+        // May only be ahead by '1'
+        NIOVA_ASSERT(rfi->rfi_next_idx == unsync_idx + 1);
+        send_msg = false;
+    }
+
+    return send_msg;
 }
 
-static void
-raft_server_init_recovery_handle(
-    struct raft_instance *ri,
-    const struct raft_append_entries_request_msg *raerq)
+/**
+ * raft_server_follower_ae_window_is_open - returns true when another
+ *    pipelined AE request may be sent to the follower without waiting on the
+ *    replies to those already in flight.
+ */
+static bool
+raft_server_follower_ae_window_is_open(const struct raft_instance *ri,
+                                       const struct raft_follower_info *rfi,
+                                       const raft_entry_idx_t my_raft_idx)
 {
-    NIOVA_ASSERT(ri && raerq);
-
-    const struct raft_rpc_msg *rrm =
-        OFFSET_CAST(raft_rpc_msg, rrm_append_entries_request, raerq);
-
-    struct raft_recovery_handle *rrh = &ri->ri_recovery_handle;
-
-    uuid_copy(rrh->rrh_peer_uuid, rrm->rrm_sender_id);
-    uuid_copy(rrh->rrh_peer_db_uuid, rrm->rrm_db_id);
+    NIOVA_ASSERT(ri && rfi);
 
-    rrh->rrh_peer_chkpt_idx = raerq->raerqm_chkpt_index;
-    rrh->rrh_chkpt_size = -1UL;
-    rrh->rrh_remaining = -1UL;
-    rrh->rrh_from_recovery_marker = false;
+    return (rfi->rfi_inflight_cnt > 0 &&
+            rfi->rfi_inflight_cnt < ri->ri_ae_window &&
+            rfi->rfi_inflight_idx < my_raft_idx) ? true : false;
+}
 
-    niova_realtime_coarse_clock(&rrh->rrh_start);
+/**
+ * raft_server_follower_decodes_packed_ae - packed AE requests are only sent to
+ *    followers which have advertised support for them.  An older follower
+ *    would take the packed payload for the data of the first index.
+ */
+static bool
+raft_server_follower_decodes_packed_ae(const struct raft_instance *ri,
+                                       const raft_peer_t follower)
+{
+    return (ri->ri_ae_max_packed_idx > 1 &&
+            ri->ri_rpc_msg_version_max >= RAFT_RPC_MSG_VERSION_PACKED &&
+            ri->ri_peer_msg_version[follower] >= RAFT_RPC_MSG_VERSION_PACKED) ?
+        true : false;
 }
 
 /**
- * raft_server_process_bulk_recovery_check - this function compares the
- *    current instance's newest entry idx with the leader's lowest available
- *    index.
+ * raft_server_append_entry_pack - appends the raft indexes which follow
+ *    reh->reh_index to the AE request, each as an entry header followed by
+ *    its data.  Packing stops once ri_ae_max_packed_idx is reached or when
+ *    the payload would exceed the max entry data size.  On return, reh holds
+ *    the header of the last index placed into the request.
  */
-static raft_server_net_cb_ctx_int_t
-raft_server_process_bulk_recovery_check(
-    struct raft_instance *ri,
-    const struct raft_append_entries_request_msg *raerq)
+static raft_server_epoll_remote_sender_t
+raft_server_append_entry_pack(struct raft_instance *ri,
+                              struct raft_append_entries_request_msg *raerq,
+                              struct raft_entry_header *reh,
+                              const raft_entry_idx_t my_raft_idx)
 {
-    NIOVA_ASSERT(ri && raerq);
+    NIOVA_ASSERT(ri && raerq && reh);
 
-    int rc = 0;
+    while (raerq->raerqm_num_idx < ri->ri_ae_max_packed_idx &&
+           reh->reh_index < my_raft_idx)
+    {
+        struct raft_entry_header next_reh = {0};
 
-    const raft_entry_idx_t my_current_idx =
-        raft_server_get_current_raft_entry_index(ri, RI_NEHDR_UNSYNC);
+        int rc = raft_server_entry_header_read(ri, &next_reh,
+                                               reh->reh_index + 1);
+        if (rc)
+            break;
 
-    if (raerq->raerqm_entry_out_of_range ||
-        FAULT_INJECT(raft_force_bulk_recovery))
-    {
-        if (my_current_idx >= raerq->raerqm_lowest_index)
-        {
-            DBG_RAFT_INSTANCE(
-                LL_WARN, ri,
-                "leader claims ERANGE but leader-lowest-idx=%ld < ei=%ld ldrpli=%ld",
-                raerq->raerqm_lowest_index, my_current_idx,
-                raerq->raerqm_prev_log_index);
+        const size_t off = raerq->raerqm_entries_sz;
 
-            // Try to notify the leader of our actual current idx
-            return -EAGAIN;
+        if ((off + sizeof(next_reh) + next_reh.reh_data_size) >
+            RAFT_ENTRY_MAX_DATA_SIZE(ri))
+            break;
+
+        if (next_reh.reh_data_size)
+        {
+            rc = raft_server_entry_read(
+                ri, next_reh.reh_index, &next_reh,
+                &raerq->raerqm_entries[off + sizeof(next_reh)],
+                next_reh.reh_data_size, NULL);
+            if (rc)
+                break;
         }
 
-        ri->ri_needs_bulk_recovery = true;
-        raft_server_init_recovery_handle(ri, raerq);
+        memcpy(&raerq->raerqm_entries[off], &next_reh, sizeof(next_reh));
 
-        DBG_RAFT_INSTANCE(LL_WARN, ri,
-                          "needs bulk recovery (leader-lowest-idx=%ld)",
-                          raerq->raerqm_lowest_index);
+        raerq->raerqm_entries_sz += sizeof(next_reh) + next_reh.reh_data_size;
+        raerq->raerqm_num_idx++;
 
-        rc = -ERANGE;
+        *reh = next_reh;
     }
-
-    return rc;
 }
 
-static raft_server_net_cb_ctx_t
-raft_server_process_append_entries_request(struct raft_instance *ri,
-                                           struct ctl_svc_node *sender_csn,
-                                           const struct raft_rpc_msg *rrm)
+/**
+ * raft_server_append_entry_send_one - builds and sends a single AE request to
+ *    the follower.  Non-heartbeat requests begin after the follower's last
+ *    in-flight index and are recorded in its in-flight window.  When 'rnusb'
+ *    is provided, the request is queued onto the batch rather than sent.
+ *    Returns -ERANGE if the entry needed by the follower is no longer
+ *    available.
+ */
+static raft_server_epoll_remote_sender_int_t
+raft_server_append_entry_send_one(struct raft_instance *ri,
+                                  struct raft_rpc_msg *rrm,
+                                  const raft_peer_t follower, bool heartbeat,
+                                  const raft_entry_idx_t my_raft_idx,
+                                  struct raft_net_udp_send_batch *rnusb)
 {
-    NIOVA_ASSERT(ri && sender_csn && rrm);
-    NIOVA_ASSERT(!ctl_svc_node_compare_uuid(sender_csn, rrm->rrm_sender_id));
+    NIOVA_ASSERT(ri && rrm && raft_member_idx_is_valid(ri, follower));
 
-    DBG_RAFT_MSG(LL_DEBUG, rrm, "");
+    struct ctl_svc_node *rp = ri->ri_csn_raft_peers[follower];
+    struct raft_follower_info *rfi =
+        raft_server_get_follower_info(ri, follower);
 
-    const struct raft_append_entries_request_msg *raerq =
+    int rc = raft_server_leader_init_append_entry_msg(ri, rrm, follower,
+                                                      heartbeat);
+    NIOVA_ASSERT(!rc || rc == -ESTALE); // sanity check
+    if (rc == -ESTALE)
+    {
+        /* raft_server_leader_init_append_entry_msg() detected that the
+         * entry needed by the follower has been compacted.  Still send
+         * a msg so that the follower knows to enter bulk recovery.
+         */
+        heartbeat = true; // force this to be a heartbeat msg
+        NIOVA_ASSERT(rrm->rrm_append_entries_request.raerqm_heartbeat_msg);
+    }
+
+    struct raft_append_entries_request_msg *raerq =
         &rrm->rrm_append_entries_request;
 
-    if (raft_server_process_append_entries_request_validity_check(ri, raerq))
+    // Pipelined requests pick up where the previous in-flight request ended
+    if (!heartbeat && rfi->rfi_inflight_idx >= rfi->rfi_next_idx)
     {
-        DBG_RAFT_MSG(
-            LL_WARN, rrm,
-            "raft_server_process_append_entries_request_validity_check() err");
-        return;
+        raerq->raerqm_prev_log_index = rfi->rfi_inflight_idx;
+        raerq->raerqm_prev_log_term = rfi->rfi_inflight_term;
+        raerq->raerqm_prev_idx_crc = rfi->rfi_inflight_crc;
     }
 
-    // Determine if bulk recovery is needed AFTER validating the AE request
-    int rc = raft_server_process_bulk_recovery_check(ri, raerq);
-    if (rc && rc != -EAGAIN)
-        return;
-
-    bool update_sli = (rc == -EAGAIN) ? true : false;
+    const int64_t peer_next_raft_idx = raerq->raerqm_prev_log_index + 1;
 
-    // Candidate timer - reset if this operation is valid.
-    bool reset_timerfd = true;
-    bool fault_inject_ignore_ae = false;
-    bool stale_term = false;
-    bool non_matching_prev_term = false;
+    DBG_RAFT_INSTANCE_FATAL_IF((peer_next_raft_idx - 1 > my_raft_idx), ri,
+                               "follower's idx > leader's (%ld > %ld)",
+                               peer_next_raft_idx, my_raft_idx);
 
-    // Check if leader or candidate should step down OR sync new term value
-    rc = raft_server_process_append_entries_term_check_ops(ri, sender_csn,
-                                                           raerq);
-    if (rc)
-    {
-        NIOVA_ASSERT(rc == -ESTALE);
-        reset_timerfd = false;
-        stale_term = true;
-    }
-    /* sli updates inform the leader that its next-idx for this peer is
-     * outdated due to bulk recovery on this follower.  Before we attempt
-     * to do any further processing of this msg, send a reply back to the
-     * leader asking for it to update it's sli for this peer.
-     */
-    else if (!update_sli)
+    if (!heartbeat && peer_next_raft_idx <= my_raft_idx)
     {
-        bool advance_commit_idx = false;
-        raft_entry_idx_t new_commit_idx = raerq->raerqm_commit_index;
+        struct raft_entry_header reh = {0};
 
-        rc = raft_server_append_entry_log_prepare_and_check(ri, raerq);
-        switch (rc)
-        {
-        case 0:
-            advance_commit_idx = true;
-            if (!raerq->raerqm_heartbeat_msg &&
-                !(fault_inject_ignore_ae =
-                      FAULT_INJECT(raft_follower_ignores_AE)))
-                raft_server_write_new_entry_from_leader(ri, raerq);
-            break;
+        // raft_server_entry_header_read() verifies reh contents
+        rc = raft_server_entry_header_read(ri, &reh, peer_next_raft_idx);
 
-        case -EBADR:
-            break; // simply reply to the server with our current info
+        if (rc == -ERANGE) // allow -ERANGE
+            return rc;
 
-        case -EALREADY:
-            // Issue #28 - advance the index of recently restarted server
-            advance_commit_idx = true;
+        DBG_RAFT_INSTANCE_FATAL_IF(
+            (rc), ri, "raft_server_entry_header_read(%ld): %s",
+            peer_next_raft_idx, strerror(-rc));
 
-            //Limit the commit-idx range entries currently stored here.
-            new_commit_idx =
-                MIN(new_commit_idx,
-                    raft_server_get_current_raft_entry_index(ri, RI_NEHDR_SYNC));
-            break;
+        raerq->raerqm_log_term = reh.reh_term;
+        raerq->raerqm_this_idx_crc = reh.reh_crc;
+        raerq->raerqm_entries_sz = reh.reh_data_size;
+        raerq->raerqm_first_idx_sz = reh.reh_data_size;
+        raerq->raerqm_num_idx = 1;
 
-        default:
-            // -EEXIST and -ERANGE cases do not advance advance commit-idx
-            non_matching_prev_term = true;
-            break;
+        raerq->raerqm_leader_change_marker = reh.reh_leader_change_marker;
+
+        // v2 entries send no size array, their table is in the entry data
+        raerq->raerqm_num_entries = reh.reh_num_entries;
+        memcpy(&raerq->raerqm_size_arr[0], &reh.reh_entry_sz[0],
+               sizeof(uint32_t) * RAFT_ENTRY_NUM_ENTRIES);
+
+        NIOVA_ASSERT(reh.reh_index == peer_next_raft_idx);
+
+        if (raerq->raerqm_entries_sz)
+        {
+            rc = raft_server_entry_read(ri, peer_next_raft_idx, &reh,
+                                        raerq->raerqm_entries,
+                                        raerq->raerqm_entries_sz, NULL);
+            if (rc == -ERANGE)
+                return rc;
+
+            DBG_RAFT_INSTANCE_FATAL_IF((rc), ri,
+                                       "raft_server_entry_read(): %s",
+                                       strerror(-rc));
         }
 
-        /* Update our commit-idx based on the value sent from the leader.
-         * NOTE:  if synchronous mode is set then this will account for the
-         * the write performed above, otherwise, only the sync'd writes to
-         * this point are considered.
-         */
-        if (advance_commit_idx)
-            raft_server_advance_commit_idx(ri, new_commit_idx);
+        if (raft_server_follower_decodes_packed_ae(ri, follower))
+            raft_server_append_entry_pack(ri, raerq, &reh, my_raft_idx);
+
+        rfi->rfi_inflight_idx = reh.reh_index;
+        rfi->rfi_inflight_term = reh.reh_term;
+        rfi->rfi_inflight_crc = reh.reh_crc;
+        rfi->rfi_inflight_cnt++;
+    }
+    else
+    {
+        raerq->raerqm_entries_sz = 0;
+        raerq->raerqm_first_idx_sz = 0;
+        raerq->raerqm_num_idx = 0;
+        raerq->raerqm_num_entries = 0;
+        memset(&raerq->raerqm_size_arr, 0,
+               sizeof(uint32_t) * RAFT_ENTRY_NUM_ENTRIES);
+        raerq->raerqm_leader_change_marker = 0;
+        raerq->raerqm_heartbeat_msg = 1;
     }
 
-    // Issue reply
-    if (!fault_inject_ignore_ae)
-        raft_server_append_entry_reply_send(ri, raerq, sender_csn, stale_term,
-                                            non_matching_prev_term, update_sli,
-                                            rc);
+    DBG_SIMPLE_CTL_SVC_NODE(
+        (heartbeat ? LL_DEBUG : LL_NOTIFY), rp,
+        "idx=%hhx pli=%ld lt=%ld nidx=%hhu inflight=%u", follower,
+        raerq->raerqm_prev_log_index, raerq->raerqm_log_term,
+        raerq->raerqm_num_idx, rfi->rfi_inflight_cnt);
 
-    /* Ensure that the raft leader (valid or otherwise) does not reset its timer
-     * since this may cause a leader timeout due to delayed pings.
-     * Additionally, for users of the heartbeat as a clock source it's important
-     * that the leader wakes up consistently.
+    rc = rnusb ? raft_server_send_msg_batched(ri, rnusb, rp, rrm) :
+        raft_server_send_msg(ri, RAFT_UDP_LISTEN_SERVER, rp, rrm);
+
+    // log errors, but raft will retry if needed
+    DBG_RAFT_INSTANCE((rc ? LL_NOTIFY : LL_TRACE), ri,
+                      "raft_server_send_msg(): %d", rc);
+
+    /* The follower's send queue is full.  Stop pipelining to it and resume
+     * from this entry on the next pass.
      */
-    if (reset_timerfd && !raft_instance_is_leader(ri))
-        raft_server_timerfd_settime(ri);
+    if (rc == -ENOBUFS && !raerq->raerqm_heartbeat_msg)
+    {
+        rfi->rfi_inflight_idx = raerq->raerqm_prev_log_index;
+        rfi->rfi_inflight_term = raerq->raerqm_prev_log_term;
+        rfi->rfi_inflight_crc = raerq->raerqm_prev_idx_crc;
+        rfi->rfi_inflight_cnt--;
+
+        return rc;
+    }
+
+    if (!rc && !raerq->raerqm_heartbeat_msg)
+        niova_realtime_coarse_clock(&rfi->rfi_last_ae_send);
+
+    return 0;
 }
 
-static raft_server_net_cb_leader_ctx_t
-raft_server_leader_setup_self_follower_info(struct raft_instance *ri)
+/**
+ * raft_server_heartbeat_is_redundant - a heartbeat is skipped for a follower
+ *    which has been sent an AE carrying entries within the heartbeat period
+ *    and has replied since.  Heartbeats themselves do not count, otherwise an
+ *    idle follower would only be sent every other heartbeat.  A follower with
+ *    an unacked send keeps receiving heartbeats.
+ */
+static bool
+raft_server_heartbeat_is_redundant(const struct raft_instance *ri,
+                                   const raft_peer_t raft_peer_idx)
 {
-    NIOVA_ASSERT(ri && ri->ri_csn_raft);
-    NIOVA_ASSERT(raft_instance_is_leader(ri));
+    const struct raft_follower_info *rfi =
+        raft_server_get_follower_info((struct raft_instance *)ri,
+                                      raft_peer_idx);
 
-    raft_peer_t this_peer_num = raft_server_instance_self_idx(ri);
-    NIOVA_ASSERT(raft_member_idx_is_valid(ri, this_peer_num));
+    const unsigned long long last_ae_send =
+        timespec_2_msec(&rfi->rfi_last_ae_send);
+    if (!last_ae_send)
+        return false;
 
-    /* The leader doesn't update its own rfi_next_idx slot so do that here
-     */
-    struct raft_follower_info *self =
-        raft_server_get_follower_info(ri, this_peer_num);
+    unsigned long long since_last_unacked = 0;
 
-    struct raft_entry_header sync_hdr = {0};
-    raft_instance_get_newest_header(ri, &sync_hdr, RI_NEHDR_SYNC);
+    if (raft_net_comm_recency(ri, raft_peer_idx,
+                              RAFT_COMM_RECENCY_UNACKED_SEND,
+                              &since_last_unacked) || since_last_unacked)
+        return false;
 
-    self->rfi_next_idx = sync_hdr.reh_index + 1;
-    self->rfi_synced_idx = sync_hdr.reh_index;
-    self->rfi_ackd_idx = sync_hdr.reh_index;
-    self->rfi_prev_idx_term = sync_hdr.reh_term;
+    const unsigned long long now = niova_realtime_coarse_clock_get_msec();
+
+    return (now >= last_ae_send &&
+            (now - last_ae_send) <
+            raft_leader_timer_period_msec(RAFT_LEADER_TIMER_HEARTBEAT)) ?
+        true : false;
 }
 
-static raft_server_net_cb_leader_ctx_int64_t
-raft_server_leader_calculate_committed_idx(struct raft_instance *ri,
-                                           const bool sync_thread)
+static raft_server_epoll_remote_sender_t
+raft_server_append_entry_sender(struct raft_instance *ri, bool heartbeat)
 {
-    NIOVA_ASSERT(ri && ri->ri_csn_raft);
-    NIOVA_ASSERT(raft_instance_is_leader(ri));
+    NIOVA_ASSERT(ri);
 
-    raft_server_leader_setup_self_follower_info(ri);
+    const int64_t my_raft_idx =
+        raft_server_get_current_raft_entry_index(ri, RI_NEHDR_UNSYNC);
 
-    const size_t num_raft_members =
-        ctl_svc_node_raft_2_num_members(ri->ri_csn_raft);
+    if (!raft_instance_is_leader(ri) || my_raft_idx < 0)
+        return;
 
-    NIOVA_ASSERT(num_raft_members <= CTL_SVC_MAX_RAFT_PEERS);
+    struct buffer_item *src_bi =
+        buffer_set_allocate_item(raft_instance_buf_set(ri, RAFT_BUF_SET_LARGE));
 
-    raft_entry_idx_t sync_indexes[CTL_SVC_MAX_RAFT_PEERS] =
-        { RAFT_MIN_APPEND_ENTRY_IDX };
+    NIOVA_ASSERT(src_bi);
 
-    for (size_t i = 0; i < num_raft_members; i++)
+    struct raft_rpc_msg *rrm =
+        (struct raft_rpc_msg *)((char *)src_bi->bi_iov.iov_base);
+
+    const raft_peer_t num_raft_members = raft_num_members_validate_and_get(ri);
+
+    /* Heartbeats carry no entries, so each follower's msg is built in its own
+     * slot and the round is sent with a single batched send.
+     */
+    struct raft_rpc_msg hb_rrm[CTL_SVC_MAX_RAFT_PEERS];
+    struct raft_net_udp_send_batch rnusb;
+    raft_net_udp_send_batch_init(&rnusb, RAFT_UDP_LISTEN_SERVER);
+    rnusb.rnusb_host_coalesce = true;
+
+    for (raft_peer_t i = 0; i < num_raft_members; i++)
     {
+        struct ctl_svc_node *rp = ri->ri_csn_raft_peers[i];
+
+        if (rp == ri->ri_csn_this_peer)
+            continue;
+
         struct raft_follower_info *rfi = raft_server_get_follower_info(ri, i);
 
-        // Don't consider a sync-idx which is > ackd-idx
-        sync_indexes[i] = MIN(rfi->rfi_ackd_idx, rfi->rfi_synced_idx);
-    }
+        if (heartbeat && raft_server_heartbeat_is_redundant(ri, i))
+            continue;
 
-    raft_entry_idx_t committed_raft_idx = -1;
-    int rc = raft_server_get_majority_entry_idx(sync_indexes, num_raft_members,
-                                                &committed_raft_idx);
-    FATAL_IF(rc, "raft_server_get_majority_entry_idx(): %s", strerror(-rc));
+        /* An open window allows further requests to be pipelined behind
+         * those in flight, otherwise the unacked-send backoff applies.
+         */
+        const bool window_open =
+            raft_server_follower_ae_window_is_open(ri, rfi, my_raft_idx);
 
-    DBG_RAFT_INSTANCE(LL_NOTIFY, ri, "committed_raft_idx=%ld",
-                      committed_raft_idx);
+        if (!window_open &&
+            !raft_server_append_entry_should_send_to_follower(ri, i) &&
+            !heartbeat)
+            continue;
 
-    /* The leader still has not obtained the sync_idx values from a majority
-     * of its followers.  Also, ensure the ri_commit_idx is not moving
-     * backwards but exempt the sync thread since it may have a stale view.
-     */
-    if (committed_raft_idx && !sync_thread &&
-        (committed_raft_idx < ri->ri_commit_idx))
-    {
-        DBG_RAFT_INSTANCE(LL_WARN, ri,
-                          "committed_raft_idx (%ld) < ri_commit_idx",
-                          committed_raft_idx);
-        for (raft_peer_t i = 0; i < num_raft_members; i++)
+        /* Backpressure - entries are not built for a follower whose send
+         * queue is full.  Heartbeats are sent inline and are unaffected.
+         */
+        if (!heartbeat && raft_server_peer_sendq_is_full(ri, i))
+            continue;
+
+        /* The window is full, or all entries are in flight, and the backoff
+         * allows a retry.  Resend from next-idx.
+         */
+        if (!heartbeat && !window_open && rfi->rfi_inflight_cnt)
+            raft_server_follower_ae_window_reset(rfi);
+
+        /* Pipeline while the window stays open.  A msg which did not add to
+         * the window, such as the heartbeat forced when the follower's next
+         * entry has been compacted, ends the loop.
+         */
+        for (;;)
         {
-            struct raft_follower_info *rfi =
-                raft_server_get_follower_info(ri, i);
-            LOG_MSG(LL_WARN, "idx=%hhu sorted-idx=%ld, peer-sync-idx=%ld",
-                    i, sync_indexes[i], rfi->rfi_synced_idx);
+            const unsigned int inflight_cnt = rfi->rfi_inflight_cnt;
+
+            int rc = raft_server_append_entry_send_one(
+                ri, (heartbeat ? &hb_rrm[i] : rrm), i, heartbeat, my_raft_idx,
+                (heartbeat ? &rnusb : NULL));
+
+            if (rc || heartbeat || rfi->rfi_inflight_cnt <= inflight_cnt ||
+                !raft_server_follower_ae_window_is_open(ri, rfi, my_raft_idx))
+                break;
         }
     }
 
-    return committed_raft_idx;
+    int rc = raft_net_udp_send_batch_flush(ri, &rnusb);
+    DBG_RAFT_INSTANCE((rc ? LL_NOTIFY : LL_TRACE), ri,
+                      "raft_net_udp_send_batch_flush(): %d", rc);
+
+    // release buffer
+    buffer_set_release_item(src_bi);
 }
 
-static int64_t
-raft_server_leader_can_advance_commit_idx(struct raft_instance *ri,
-                                          const bool sync_thread)
+static raft_server_epoll_sm_apply_t
+raft_server_sm_apply_opt(struct raft_instance *ri,
+                         struct raft_net_sm_write_supplements *ws)
 {
     NIOVA_ASSERT(ri);
-    if (!raft_instance_is_leader(ri))
-        return ID_ANY_64bit;
-
-    const struct raft_leader_state *rls = &ri->ri_leader;
 
-    const int64_t committed_raft_idx =
-        raft_server_leader_calculate_committed_idx(ri, sync_thread);
+    if (ri->ri_backend->rib_sm_apply_opt)
+        ri->ri_backend->rib_sm_apply_opt(ri, ws);
+}
 
-    DBG_RAFT_INSTANCE_FATAL_IF( // Note:  sync_thread view may be stale
-        (!sync_thread && committed_raft_idx < ri->ri_commit_idx &&
-         committed_raft_idx >= rls->rls_initial_term_idx), ri,
-        "commit_calc_idx (%ld) < ri_commit_idx after initial term idx (%ld)",
-        committed_raft_idx, rls->rls_initial_term_idx);
+static raft_server_epoll_sm_apply_bool_t
+raft_server_net_client_request_init_sm_apply(
+    struct raft_instance *ri, struct raft_net_client_request_handle *rncr,
+    const char *commit_data, const size_t commit_data_size, char *reply_buf,
+    const size_t reply_buf_size)
+{
+    NIOVA_ASSERT(ri && rncr && commit_data);
 
-    /* Only increase the commit index if the majority has ACKd this leader's
-     * "leader_change_marker" AE.
-     */
-    return (committed_raft_idx >= rls->rls_initial_term_idx &&
-            committed_raft_idx > ri->ri_commit_idx) ?
-        committed_raft_idx : RAFT_ENTRY_IDX_ANY;
+    raft_server_net_client_request_init(ri, rncr,
+                                        RAFT_NET_CLIENT_REQ_TYPE_COMMIT,
+                                        NULL, commit_data, commit_data_size,
+                                        NULL, reply_buf, reply_buf_size,
+                                        false);
 }
 
 /**
- * raft_server_leader_try_advance_commit_idx -
- *     After receiving a successful AE reply,
- *     one where the follower was able to append the entry to its log, the
- *     leader now checks to see if can commit any older entries.  The
- *     determination for 'committed' relies on a majority of peers ACK'ing the
- *     AE in this leader's term - the leader may only tally ACKs for AEs sent
- *     in its term!
- *     raft_leader_has_applied_txn_in_my_term() cannot be used here since the
- *     data used by it must first be updated through a commit + apply
- *     operation.
+ * raft_server_backend_setup_last_applied - called in setup context to provide
+ *    the last-applied info from a stateful backend, such as RocksDB.
  */
-static raft_server_net_cb_leader_ctx_t // or raft_server_epoll_t
-raft_server_leader_try_advance_commit_idx(struct raft_instance *ri)
+void
+raft_server_backend_setup_last_applied(struct raft_instance *ri,
+                                       struct raft_last_applied *rla)
 {
-    NIOVA_ASSERT(ri);
-    NIOVA_ASSERT(raft_instance_is_leader(ri));
-
-    const int64_t committed_raft_idx =
-        raft_server_leader_can_advance_commit_idx(ri, false);
+    NIOVA_ASSERT(ri && (raft_instance_is_booting(ri) ||
+                        raft_instance_is_recovering(ri)));
 
-    if (committed_raft_idx != RAFT_ENTRY_IDX_ANY)
-        raft_server_advance_commit_idx(ri, committed_raft_idx);
+    ri->ri_last_applied = *rla;
 }
 
-static raft_server_sync_thread_ctx_t
-raft_server_leader_try_advance_commit_idx_from_sync_thread(
-    struct raft_instance *ri)
+static raft_server_epoll_sm_apply_t
+raft_server_set_last_applied(struct raft_instance *ri,
+                             struct raft_last_applied *nai)
 {
-    if (ri && (raft_server_leader_can_advance_commit_idx(ri, true) !=
-               RAFT_ENTRY_IDX_ANY))
-        RAFT_NET_EVP_NOTIFY_NO_FAIL(ri, RAFT_EVP_ASYNC_COMMIT_IDX_ADV);
+    NIOVA_ASSERT(ri && nai &&
+                 (nai->rla_idx >= ri->ri_last_applied.rla_idx &&
+                  nai->rla_sub_idx <= nai->rla_sub_idx_max));
+
+    ri->ri_last_applied.rla_idx = nai->rla_idx;
+    ri->ri_last_applied.rla_sub_idx = nai->rla_sub_idx;
+    ri->ri_last_applied.rla_sub_idx_max = nai->rla_sub_idx_max;
+
+    /* The cumulative crc is supposed to updated for each sub entry apply
+     * However, for now the cumulative crc will be updated once all sub entries
+     * are applied.
+     */
+    if (nai->rla_sub_idx == nai->rla_sub_idx_max)
+    {
+        ri->ri_last_applied.rla_cumulative_crc = nai->rla_cumulative_crc;
+        ri->ri_last_applied.rla_kv_cumulative_crc = nai->rla_kv_cumulative_crc;
+    }
+    else
+        nai->rla_sub_idx++;
 }
 
-static raft_server_net_cb_leader_ctx_t
-raft_server_try_update_follower_sync_idx(
-    struct raft_instance *ri, struct raft_follower_info *rfi,
-    const struct raft_rpc_msg *rrm, enum raft_rpc_msg_type type)
+static bool
+raft_server_needs_apply(const struct raft_instance *ri)
 {
-    NIOVA_ASSERT(ri && rfi && rrm &&
-                 (type == RAFT_RPC_MSG_TYPE_APPEND_ENTRIES_REPLY ||
-                  type == RAFT_RPC_MSG_TYPE_SYNC_IDX_UPDATE));
+    NIOVA_ASSERT(ri);
+    NIOVA_ASSERT(ri->ri_last_applied.rla_idx <= ri->ri_commit_idx);
 
-    struct raft_entry_header reh = {0};
-    raft_instance_get_newest_header(ri, &reh, RI_NEHDR_SYNC);
+    return (ri->ri_last_applied.rla_idx < ri->ri_commit_idx ||
+            (ri->ri_last_applied.rla_idx == ri->ri_commit_idx &&
+             ri->ri_last_applied.rla_sub_idx <
+             ri->ri_last_applied.rla_sub_idx_max));
+}
 
-    int64_t term = (type == RAFT_RPC_MSG_TYPE_SYNC_IDX_UPDATE ?
-                    rrm->rrm_sync_index_update.rsium_term :
-                    rrm->rrm_append_entries_reply.raerpm_leader_term);
+static void
+raft_server_next_apply_idx(const struct raft_instance *ri,
+                           struct raft_last_applied *nai)
+{
+    NIOVA_ASSERT(ri && nai);
+    NIOVA_ASSERT(ri->ri_last_applied.rla_sub_idx <=
+                 ri->ri_last_applied.rla_sub_idx_max);
 
-    if (term != reh.reh_term) // Do not accept non-matching terms!
-        return;
+    *nai = ri->ri_last_applied;
 
-    if (rfi->rfi_synced_idx > rfi->rfi_next_idx)
+    if (nai->rla_sub_idx == nai->rla_sub_idx_max)
     {
-        DBG_RAFT_MSG(LL_DEBUG, rrm,
-                     "next-idx=%ld > syncd-idx=%ld (ackd-idx=%ld)",
-                     rfi->rfi_next_idx, rfi->rfi_synced_idx,
-                     rfi->rfi_ackd_idx);
+        nai->rla_sub_idx = 0;
+        nai->rla_sub_idx_max = 0;
+        nai->rla_idx++;
     }
     else
     {
-        int64_t sli = (type == RAFT_RPC_MSG_TYPE_SYNC_IDX_UPDATE ?
-                       rrm->rrm_sync_index_update.rsium_synced_log_index :
-                       rrm->rrm_append_entries_reply.raerpm_synced_log_index);
+        nai->rla_sub_idx++;
+    }
+}
 
-        bool ackd_or_syncd_advanced = false;
-        /* Adjust the ack'd index - we now know that the follower's log
-         * contains this entry and at the proper term.
-         */
-        if (rfi->rfi_ackd_idx < (rfi->rfi_next_idx - 1))
-        {
-            rfi->rfi_ackd_idx = rfi->rfi_next_idx - 1;
-            ackd_or_syncd_advanced = true;
-        }
+/**
+ * raft_server_apply_prefetch_advance - publishes the commit idx to the
+ *    prefetch thread.  The read-ahead position is moved up to the next apply
+ *    idx if the apply has passed it.
+ */
+static void
+raft_server_apply_prefetch_advance(struct raft_instance *ri)
+{
+    NIOVA_ASSERT(ri);
 
-        if (rfi->rfi_synced_idx < sli)
-        {
-            rfi->rfi_synced_idx = sli;
+    struct raft_apply_prefetch *rap = &ri->ri_apply_prefetch;
+    if (!rap->rap_depth)
+        return;
+
+    struct raft_last_applied nai;
+    raft_server_next_apply_idx(ri, &nai);
 
-            DBG_RAFT_MSG(LL_DEBUG, rrm, "new-sync-idx=%ld how=%d",
-                         rfi->rfi_synced_idx, type);
+    niova_mutex_lock(&rap->rap_mutex);
 
-            // if this request increases the remote's rfi_synced_idx..
-            ackd_or_syncd_advanced = true;
-        }
+    if (rap->rap_next_idx < nai.rla_idx)
+        rap->rap_next_idx = nai.rla_idx;
 
-        if (ackd_or_syncd_advanced)
-            raft_server_leader_try_advance_commit_idx(ri);
+    if (rap->rap_limit_idx != ri->ri_commit_idx)
+    {
+        rap->rap_limit_idx = ri->ri_commit_idx;
+        pthread_cond_broadcast(&rap->rap_cond);
     }
+
+    niova_mutex_unlock(&rap->rap_mutex);
 }
 
-static raft_server_net_cb_leader_ctx_t
-raft_server_apply_append_entries_reply_result(
-    struct raft_instance *ri,
-    const uuid_t follower_uuid,
-    const struct raft_append_entries_reply_msg *raerp)
+/**
+ * raft_server_apply_prefetch_get - returns the slot holding the prefetched
+ *    contents of 'idx', or NULL if the caller must read the entry itself.  A
+ *    read of 'idx' which is already in progress is waited upon.  On a miss,
+ *    'idx' is claimed so that the prefetch thread will not read it again.
+ *    A returned slot must be passed to raft_server_apply_prefetch_release().
+ */
+static struct raft_apply_prefetch_slot *
+raft_server_apply_prefetch_get(struct raft_instance *ri,
+                               const raft_entry_idx_t idx)
 {
-    NIOVA_ASSERT(ri && raerp);
-    NIOVA_ASSERT(raft_instance_is_leader(ri));
-    NIOVA_ASSERT(!raerp->raerpm_err_stale_term);
-
-    const raft_peer_t follower_idx = raft_peer_2_idx(ri, follower_uuid);
-    NIOVA_ASSERT(follower_idx != RAFT_PEER_ANY);
+    NIOVA_ASSERT(ri && idx >= 0);
 
-    struct raft_follower_info *rfi =
-        raft_server_get_follower_info(ri, follower_idx);
+    struct raft_apply_prefetch *rap = &ri->ri_apply_prefetch;
+    if (!rap->rap_depth)
+        return NULL;
 
-    struct timespec la = rfi->rfi_last_ack;
+    struct raft_apply_prefetch_slot *raps =
+        &rap->rap_slots[idx % rap->rap_depth];
 
-    // Update the last ack value for this follower.
-    raft_server_update_follower_last_ack(rfi);
+    niova_mutex_lock(&rap->rap_mutex);
 
-    DBG_RAFT_INSTANCE(
-        (raerp->raerpm_heartbeat_msg ? LL_DEBUG : LL_NOTIFY), ri,
-        "flwr=%x next-idx=%ld si=%ld err=%hhx rp-pli=%ld rp-si=%ld la-ms=%lld",
-        follower_idx, rfi->rfi_next_idx, rfi->rfi_synced_idx,
-        raerp->raerpm_err_non_matching_prev_term,
-        raerp->raerpm_prev_log_index, raerp->raerpm_synced_log_index,
-        (timespec_2_msec(&rfi->rfi_last_ack) - timespec_2_msec(&la)));
+    while (raps->raps_idx == idx &&
+           raps->raps_state == RAFT_APPLY_PREFETCH_SLOT_PENDING)
+        pthread_cond_wait(&rap->rap_cond, &rap->rap_mutex);
 
-    /* Do not modify the rls->rls_next_idx[follower_idx] value unless the
-     * reply corresponds to it.  This is to handle cases where replies get
-     * delayed by the network.  If the follower still needs to have its
-     * rls_next_idx decreased, it's ok, subsequent AE requests will eventually
-     * cause it happen.  Note, this situation is common due to heartbeat msgs
-     * running concurrently with pending AE's.  Heartbeat replies may meet the
-     * criteria for advancing next-idx which will cause the non-hb AE reply
-     * to appear stale.
+    /* Stale contents are dropped.  Failed reads are retried by the caller
+     * which treats read errors as fatal.
      */
-    if (raerp->raerpm_prev_log_index + 1 != rfi->rfi_next_idx)
+    if (raps->raps_state == RAFT_APPLY_PREFETCH_SLOT_READY &&
+        (raps->raps_idx < idx || (raps->raps_idx == idx && raps->raps_rc)))
     {
-        DBG_RAFT_INSTANCE(
-            LL_DEBUG, ri,
-            "follower=%x hb=%d reply-ni=%ld my-ni-for-follower=%ld",
-            follower_idx, raerp->raerpm_heartbeat_msg,
-            raerp->raerpm_prev_log_index, rfi->rfi_next_idx);
-
-        return;
+        raps->raps_state = RAFT_APPLY_PREFETCH_SLOT_EMPTY;
+        pthread_cond_broadcast(&rap->rap_cond);
     }
 
-    /* raerpm_update_sli is prioritized over
-     * raerpm_err_non_matching_prev_term
-     */
-    if (raerp->raerpm_update_sli)
+    const bool hit = (raps->raps_idx == idx &&
+                      raps->raps_state == RAFT_APPLY_PREFETCH_SLOT_READY);
+    if (hit)
     {
-        DBG_RAFT_INSTANCE(LL_WARN, ri,
-                          "follower=%x requests sli update to %ld from %ld",
-                          follower_idx, raerp->raerpm_synced_log_index,
-                          rfi->rfi_next_idx);
-        if (raerp->raerpm_synced_log_index > rfi->rfi_next_idx)
-        {
-            rfi->rfi_next_idx = raerp->raerpm_synced_log_index + 1;
-            rfi->rfi_ackd_idx = raerp->raerpm_synced_log_index;
-            rfi->rfi_synced_idx = raerp->raerpm_synced_log_index;
-            rfi->rfi_prev_idx_term = -1;
-        }
+        rap->rap_hits++;
     }
-    else if (raerp->raerpm_err_non_matching_prev_term)
+    else
     {
-        if (rfi->rfi_next_idx > 0)
-        {
-            if (raerp->raerpm_newly_initialized_peer)
-            {
-                rfi->rfi_next_idx = 0;
-            }
-            else
-            {
-                /* Fast-forwarding rfi_next_idx to raerpm_synced_log_index
-                 * prevents the leader from iterating over index values which
-                 * the follower has disclosed that it does hold.
-                 */
-                rfi->rfi_next_idx =
-                    (raerp->raerpm_synced_log_index >= 0 &&
-                     raerp->raerpm_synced_log_index < rfi->rfi_next_idx)
-                    ? raerp->raerpm_synced_log_index
-                    : rfi->rfi_next_idx - 1;
-            }
+        rap->rap_misses++;
 
-            rfi->rfi_prev_idx_term = -1; //Xxx this needs to go into a function
-        }
+        if (rap->rap_next_idx <= idx)
+            rap->rap_next_idx = idx + 1;
     }
-    else
-    {
-        if (!raerp->raerpm_heartbeat_msg)
-        {
-            rfi->rfi_prev_idx_term = -1;
-            rfi->rfi_next_idx++;
 
-            DBG_RAFT_INSTANCE(LL_NOTIFY, ri, "follower=%x new-next-idx=%ld",
-                              follower_idx, rfi->rfi_next_idx);
-        }
+    niova_mutex_unlock(&rap->rap_mutex);
 
-        const struct raft_rpc_msg *rrm =
-            OFFSET_CAST(raft_rpc_msg, rrm_append_entries_reply, raerp);
+    return hit ? raps : NULL;
+}
 
-        raft_server_try_update_follower_sync_idx(
-            ri, rfi, rrm, RAFT_RPC_MSG_TYPE_APPEND_ENTRIES_REPLY);
-    }
+static void
+raft_server_apply_prefetch_release(struct raft_instance *ri,
+                                   struct raft_apply_prefetch_slot *raps)
+{
+    NIOVA_ASSERT(ri);
 
-    if ((rfi->rfi_next_idx - 1) <
-        raft_server_get_current_raft_entry_index(ri, RI_NEHDR_UNSYNC))
-    {
-        DBG_RAFT_INSTANCE(LL_NOTIFY, ri, "follower=%x still lags next-idx=%ld",
-                          follower_idx, rfi->rfi_next_idx);
+    if (!raps)
+        return;
 
-        RAFT_NET_EVP_NOTIFY_NO_FAIL(ri, RAFT_EVP_REMOTE_SEND);
-    }
+    struct raft_apply_prefetch *rap = &ri->ri_apply_prefetch;
+
+    niova_mutex_lock(&rap->rap_mutex);
+
+    NIOVA_ASSERT(raps->raps_state == RAFT_APPLY_PREFETCH_SLOT_READY);
+
+    raps->raps_state = RAFT_APPLY_PREFETCH_SLOT_EMPTY;
+    pthread_cond_broadcast(&rap->rap_cond);
+
+    niova_mutex_unlock(&rap->rap_mutex);
 }
 
-static raft_server_net_cb_ctx_t
-raft_server_process_append_entries_reply(struct raft_instance *ri,
-                                         struct ctl_svc_node *sender_csn,
-                                         const struct raft_rpc_msg *rrm)
+static void
+raft_server_apply_sub_idx_max_set(const struct raft_instance *ri,
+                                  struct raft_last_applied *nai,
+                                  const uint32_t nentries)
 {
-    NIOVA_ASSERT(ri && sender_csn && rrm);
-    NIOVA_ASSERT(!ctl_svc_node_compare_uuid(sender_csn, rrm->rrm_sender_id));
-
-    const struct raft_append_entries_reply_msg *raerp =
-        &rrm->rrm_append_entries_reply;
+    /* Sanity checks in case of recovery after partial apply failure the maximum
+     * of sub idx should be equal to the number of entries - 1
+     */
+    if (ri->ri_last_applied.rla_sub_idx != ri->ri_last_applied.rla_sub_idx_max)
+        NIOVA_ASSERT(nentries == ri->ri_last_applied.rla_sub_idx_max + 1);
 
-    DBG_RAFT_MSG((raerp->raerpm_heartbeat_msg ? LL_DEBUG : LL_NOTIFY),
-                 rrm, "");
+    // Update max entries in the next apply idx
+    nai->rla_sub_idx_max = nentries - 1;
+}
 
-    if (!raft_instance_is_leader(ri))
-        return;
+static void
+raft_server_get_raft_header_to_apply(struct raft_instance *ri,
+                                     struct raft_last_applied *nai,
+                                     struct raft_entry_header *reh,
+                                     struct raft_apply_prefetch_slot **raps)
+{
+    NIOVA_ASSERT(ri && nai && reh && raps);
+    raft_server_next_apply_idx(ri, nai);
 
-    if (raerp->raerpm_err_stale_term)
+    // The prefetch thread reads the header along with the entry data
+    *raps = raft_server_apply_prefetch_get(ri, nai->rla_idx);
+    if (*raps)
     {
-        /* raerpm_err_stale_term should only be considered if it's more recent
-         * than our own term, otherwise it's stale.
-         */
-        if (raerp->raerpm_leader_term > ri->ri_log_hdr.rlh_term)
-            raft_server_becomes_follower(ri, raerp->raerpm_leader_term,
-                                         sender_csn->csn_uuid,
-                                         RAFT_BFRSN_STALE_TERM_WHILE_LEADER);
+        *reh = (*raps)->raps_reh;
     }
     else
     {
-        raft_server_apply_append_entries_reply_result(ri, sender_csn->csn_uuid,
-                                                      raerp);
+        int rc = raft_server_entry_header_read(ri, reh, nai->rla_idx);
+        DBG_RAFT_INSTANCE_FATAL_IF((rc), ri,
+                                   "raft_server_entry_header_read(): %s",
+                                   strerror(-rc));
     }
-}
 
-static raft_server_net_cb_ctx_t
-raft_server_process_sync_idx_update(struct raft_instance *ri,
-                                    struct ctl_svc_node *sender_csn,
-                                    const struct raft_rpc_msg *rrm)
-{
-    NIOVA_ASSERT(ri && sender_csn && rrm);
-    NIOVA_ASSERT(!ctl_svc_node_compare_uuid(sender_csn, rrm->rrm_sender_id));
+    // The sub-entry count of a v2 entry is known once its data is read
+    if (reh->reh_version != RAFT_ENTRY_HEADER_V2)
+        raft_server_apply_sub_idx_max_set(ri, nai, reh->reh_num_entries);
 
-    if (!raft_instance_is_leader(ri))
-        return;
+    nai->rla_cumulative_crc = ri->ri_last_applied.rla_cumulative_crc ^ reh->reh_crc;
+}
 
-    /* Ignore the message if the term does not match.  Note that this term is
-     * not for the sync'd index - it's the remote's current term value which
-     * should match this leader's term.
+static void
+raft_server_init_send_reply(struct raft_instance *ri,
+                            struct raft_net_client_request_handle rncr)
+{
+    NIOVA_ASSERT(ri);
+    /* Perform basic initialization on the reply buffer if the SM has provided
+     * the necessary info for completing the reply.  The SM would have called
+     * raft_net_client_request_handle_set_reply_info() if the necessary info was
+     * provided.  Note that the SM may not check for leader status, so the reply
+     * info may be provided even when this node is a follower.  Therefore, udp
+     * init should be bypassed if this node is not the leader.
      */
-    else if (rrm->rrm_sync_index_update.rsium_term != ri->ri_log_hdr.rlh_term)
-        return;
+    if (raft_instance_is_leader(ri) &&
+        raft_net_client_request_handle_has_reply_info(&rncr) &&
+        uuid_compare(rncr.rncr_client_uuid,
+                     ri->ri_csn_this_peer->csn_uuid))
+    {
+        /* rncr and rcrm_data_size gets populated in ri_server_sm_request_cb().
+         * raft_server_client_reply_init() memset's rncr_reply which will
+         * overwrite the rcrm_data_size as well. So store the rcrm_data_size
+         * value in temporary variable first and restore it again.
+         */
+        struct raft_client_rpc_msg *reply = rncr.rncr_reply.rncr_reply_ptr;
+        uint32_t orig_rcrm_data_size = reply->rcrm_data_size;
 
-    raft_peer_t follower_idx = raft_peer_2_idx(ri, sender_csn->csn_uuid);
-    if (follower_idx == RAFT_PEER_ANY)
-        return;
+        raft_server_client_reply_init(ri, &rncr,
+                                      RAFT_CLIENT_RPC_MSG_TYPE_REPLY);
 
-    struct raft_follower_info *rfi =
-        raft_server_get_follower_info(ri, follower_idx);
+        reply->rcrm_data_size = orig_rcrm_data_size;
 
-    raft_server_try_update_follower_sync_idx(
-        ri, rfi, rrm, RAFT_RPC_MSG_TYPE_SYNC_IDX_UPDATE);
+        raft_server_reply_to_client(ri, &rncr, NULL);
+    }
 }
 
 /**
- * raft_server_process_received_server_msg - called following the arrival of
- *    a udp message on the server <-> server socket.  After verifying
- *    that the sender's UUID and its raft UUID are known, this function will
- *    call the appropriate function handler based on the msg type.
+ * raft_server_state_machine_apply_entry - applies the remaining sub-entries
+ *    of the next raft index.  The reply buffer is allocated on first use and
+ *    is shared by every entry in the apply batch.
  */
-static raft_net_cb_ctx_t
-raft_server_process_received_server_msg(struct raft_instance *ri,
-                                        const struct raft_rpc_msg *rrm,
-                                        struct ctl_svc_node *sender_csn)
+static void
+raft_server_state_machine_apply_entry(struct raft_instance *ri,
+                                      struct buffer_item **reply_bi)
 {
-    NIOVA_ASSERT(ri && rrm && sender_csn);
+    NIOVA_ASSERT(ri && reply_bi);
 
-    /* General timestamp acquisition.  Note that this does not record AE
-     * [n]ack statuses of the leader's followers.  Those are updated in
-     * raft_server_process_append_entries_reply().
-     */
-    raft_net_update_last_comm_time(ri, sender_csn->csn_uuid, false);
+    // Read the raft entry header for the next apply index
+    struct raft_last_applied nai = {0};
+    struct raft_entry_header reh = {0};
+    struct raft_apply_prefetch_slot *raps = NULL;
+    raft_server_get_raft_header_to_apply(ri, &nai, &reh, &raps);
 
-    switch (rrm->rrm_type)
+    /* If its the leader marker only update the last_applied index and return,
+     * persisting the last applied index will be done later along with apply
+     * from the application.
+     */
+    if (reh.reh_leader_change_marker || !reh.reh_data_size)
     {
-    case RAFT_RPC_MSG_TYPE_PRE_VOTE_REQUEST: // fall through
-    case RAFT_RPC_MSG_TYPE_VOTE_REQUEST:
-        return raft_server_process_vote_request_common(ri, sender_csn, rrm);
-
-    case RAFT_RPC_MSG_TYPE_PRE_VOTE_REPLY: // fall through
-    case RAFT_RPC_MSG_TYPE_VOTE_REPLY:
-        return raft_server_process_vote_reply_common(ri, sender_csn, rrm);
-
-    case RAFT_RPC_MSG_TYPE_SYNC_IDX_UPDATE:
-        return raft_server_process_sync_idx_update(ri, sender_csn, rrm);
-
-    case RAFT_RPC_MSG_TYPE_APPEND_ENTRIES_REQUEST:
-        return raft_server_process_append_entries_request(ri, sender_csn, rrm);
-
-    case RAFT_RPC_MSG_TYPE_APPEND_ENTRIES_REPLY:
-        return raft_server_process_append_entries_reply(ri, sender_csn, rrm);
-
-    default:
-        DBG_RAFT_MSG(LL_NOTIFY, rrm, "unhandled msg type %d", rrm->rrm_type);
-        break;
-    }
-}
-
-static raft_net_cb_ctx_t
-raft_server_peer_recv_handler(struct raft_instance *ri,
-                              const char *recv_buffer,
-                              ssize_t recv_bytes,
-                              const struct sockaddr_in *from)
-{
-    SIMPLE_FUNC_ENTRY(LL_TRACE);
-    NIOVA_ASSERT(ri && from);
+        raft_server_set_last_applied(ri, &nai);
+        raft_server_sm_apply_opt(ri, NULL);
+        raft_server_entry_cache_release(ri, nai.rla_idx);
+        raft_server_apply_prefetch_release(ri, raps);
 
-    if (!recv_buffer || !recv_bytes)
         return;
+    }
 
-    const struct raft_rpc_msg *rrm = (const struct raft_rpc_msg *)recv_buffer;
-
-    ssize_t expected_msg_size = sizeof(struct raft_rpc_msg);
-
-    if (rrm->rrm_type == RAFT_RPC_MSG_TYPE_APPEND_ENTRIES_REQUEST)
-        expected_msg_size += rrm->rrm_append_entries_request.raerqm_entries_sz;
+    struct raft_entry_view rev;
+    struct buffer_item *sink_bi = NULL;
+    const char *sink_buf = NULL;
 
-    DBG_RAFT_MSG(LL_DEBUG, rrm, "expected_msg_size: %lu", expected_msg_size);
-    /* Server <-> server messages do not have additional payloads.
+    /* A prefetched entry has already been copied out of the backend.
+     * Otherwise, the leader's entry cache normally holds this entry or,
+     * failing that, apply directly from a backend view when one is available.
+     * The SM does not modify the commit data.
      */
-    if (recv_bytes != expected_msg_size)
+    int rc = raps ? 0 : raft_instance_is_leader(ri) ? -EOPNOTSUPP :
+        raft_server_entry_read_view(ri, &reh, &rev);
+
+    if (raps)
     {
-        DBG_RAFT_INSTANCE(
-            LL_NOTIFY, ri,
-            "Invalid msg size %zd (expected %zu) from peer %s:%d",
-            recv_bytes, expected_msg_size, inet_ntoa(from->sin_addr),
-            ntohs(from->sin_port));
+        sink_buf = raps->raps_buf;
+    }
+    else if (!rc)
+    {
+        sink_buf = rev.rev_data;
+    }
+    else
+    {
+        DBG_RAFT_INSTANCE_FATAL_IF((rc != -EOPNOTSUPP), ri,
+                                   "raft_server_entry_read_view(): %s",
+                                   strerror(-rc));
+        // Allocate the buffer
+        sink_bi = buffer_set_allocate_item(
+            raft_instance_buf_set(ri, RAFT_BUF_SET_APPLY));
+        NIOVA_ASSERT(sink_bi);
+
+        // Read the raft entry data
+        rc = raft_server_entry_read(ri, nai.rla_idx, &reh,
+                                    (char *)sink_bi->bi_iov.iov_base,
+                                    reh.reh_data_size, NULL);
 
-        return;
+        sink_buf = (const char *)sink_bi->bi_iov.iov_base;
+
+        DBG_RAFT_INSTANCE_FATAL_IF((rc), ri, "raft_server_entry_read(): %s",
+                                   strerror(-rc));
     }
 
-    DBG_RAFT_MSG(LL_DEBUG, rrm, "msg-size=(%zd) peer %s:%d",
-                 recv_bytes, inet_ntoa(from->sin_addr),
-                 ntohs(from->sin_port));
+    // Allocate reply buffer
+    const size_t reply_buf_sz = RAFT_BS_APPLY_SZ;
 
-    /* Verify the sender's id before proceeding.
-     */
-    struct ctl_svc_node *sender_csn =
-        raft_net_verify_sender_server_msg(ri, rrm->rrm_sender_id,
-                                          rrm->rrm_raft_id, from);
-    if (!sender_csn)
-        return;
+    if (!*reply_bi)
+    {
+        *reply_bi = buffer_set_allocate_item(
+            raft_instance_buf_set(ri, RAFT_BUF_SET_APPLY));
+        NIOVA_ASSERT(*reply_bi);
+    }
 
-    raft_server_process_received_server_msg(ri, rrm, sender_csn);
-}
+    char *reply_buf = (char *)(*reply_bi)->bi_iov.iov_base;
 
-static bool
-raft_leader_majority_followers_comm_window(const struct raft_instance *ri,
-                                           const unsigned int comm_window_ms)
-{
-    if (!raft_instance_is_leader(ri) ||
-        FAULT_INJECT(raft_leader_may_be_deposed))
-        return false;
+    if (reh.reh_version == RAFT_ENTRY_HEADER_V2)
+    {
+        uint32_t nentries = 0;
 
-    struct timespec now;
-    niova_realtime_coarse_clock(&now);
+        rc = raft_server_entry_sub_table_check(sink_buf, reh.reh_data_size,
+                                               &nentries);
+        DBG_RAFT_ENTRY_FATAL_IF((rc), &reh,
+                                "raft_server_entry_sub_table_check(): %s",
+                                strerror(-rc));
 
-    size_t num_acked_within_window = 1; // count "self"
+        raft_server_apply_sub_idx_max_set(ri, &nai, nentries);
+    }
 
-    const raft_peer_t num_raft_peers = raft_num_members_validate_and_get(ri);
+    const uint32_t nentries =
+        raft_server_entry_num_sub_entries(&reh, sink_buf);
 
-    for (raft_peer_t i = 0; i < num_raft_peers; i++)
+    // Iterate over the entries apply and reply if needed
+    bool failed = false;
+    size_t offset = raft_server_entry_sub_entries_offset(&reh, nentries);
+
+    for (uint32_t i = 0; i < nentries;
+         offset += raft_server_entry_sub_entry_size(&reh, sink_buf, i), i++)
     {
-        if (i == raft_server_instance_self_idx(ri))
+        // Move the offset to next entry
+        if(i < nai.rla_sub_idx)
             continue;
 
-        const struct raft_follower_info *rfi =
-            raft_server_get_follower_info((struct raft_instance *)ri, i);
+        struct raft_net_client_request_handle rncr;
+        raft_server_net_client_request_init_sm_apply(
+            ri, &rncr, sink_buf + offset,
+            raft_server_entry_sub_entry_size(&reh, sink_buf, i), reply_buf,
+            reply_buf_sz);
+        raft_net_sm_write_supplement_enable_kv_crc(
+            &rncr.rncr_sm_write_supp, nai.rla_kv_cumulative_crc);
+        rncr.rncr_apply_handler_version = reh.reh_apply_handler_version;
 
-        // Ignore if time has moved backwards
-        if (timespeccmp(&now, &rfi->rfi_last_ack, <))
-            continue;
+        rc = ri->ri_server_sm_request_cb(&rncr);
+        if (rc)
+            failed = true;
 
-        struct timespec diff;
+        // Increment the sub applied idx and persist it
+        nai.rla_kv_cumulative_crc =
+            raft_net_sm_write_supplement_get_kv_crc(&rncr.rncr_sm_write_supp);
+        raft_server_set_last_applied(ri, &nai);
+        raft_server_sm_apply_opt(ri, &rncr.rncr_sm_write_supp);
+        raft_net_sm_write_supplement_destroy(&rncr.rncr_sm_write_supp);
 
-        timespecsub(&now, &rfi->rfi_last_ack, &diff);
+        if (!rc)
+            raft_server_init_send_reply(ri, rncr);
 
-        if (timespec_2_msec(&diff) <= comm_window_ms)
-            num_acked_within_window++;
+        if (FAULT_INJECT(raft_server_fail_partial_apply))
+            SIMPLE_LOG_MSG(LL_FATAL, "Failing after apply at index:%ld sub:%d",
+                           nai.rla_idx, nai.rla_sub_idx - 1);
     }
 
-    SIMPLE_LOG_MSG(LL_DEBUG,
-                   "num_acked_within_window: %lu required: %d (%d peers)",
-                   num_acked_within_window, num_raft_peers / 2 + 1,
-                   num_raft_peers);
+    NIOVA_ASSERT(ri->ri_last_applied.rla_sub_idx ==
+                 ri->ri_last_applied.rla_sub_idx_max);
 
-    return (num_acked_within_window >= (size_t)((num_raft_peers / 2 + 1))) ?
-        true : false;
-}
+    raft_server_entry_cache_release(ri, nai.rla_idx);
 
-static raft_server_net_cb_ctx_bool_t
-raft_leader_instance_is_fresh(const struct raft_instance *ri)
-{
-    return raft_leader_majority_followers_comm_window(
-        ri, raft_election_timeout_lower_bound(ri));
-}
+    // Update the commit latency metric
+    if (!failed && raft_instance_is_leader(ri))
+    {
+        if (reh.reh_term == ri->ri_log_hdr.rlh_term)
+        {
+            struct timespec ts;
+            niova_realtime_coarse_clock(&ts);
 
-/* raft_leader_check_quorum - reads follower ack state and determines if a
- *   quorum exists (IOW that enough followers have ack'd this leader w/in the
- *   time window).
- *   NOTE:  rls_quorum_ok_cnt - this value is incremented each time this call
- *     is entered, without respect to the current time.  It is assumed that this
- *     called is made periodically from the leader's timefd expiration. Calling
- *     this function outside of raft_net_timerfd_cb_ctx can have a negative
- *     effect on users of this value which are using it as a clock value.
- */
-static raft_net_timerfd_cb_ctx_bool_t
-raft_leader_check_quorum(struct raft_instance *ri)
-{
-    NIOVA_ASSERT(ri->ri_state == RAFT_STATE_LEADER);
+            timespecsub(&ts, &reh.reh_store_time, &ts);
 
-    bool quorum_intact =
-        raft_leader_majority_followers_comm_window(
-            ri, (raft_election_timeout_lower_bound(ri) *
-                 ri->ri_check_quorum_timeout_factor));
+            struct binary_hist *bh =
+                    raft_server_type_2_hist(
+                        ri, RAFT_INSTANCE_HIST_COMMIT_LAT_MSEC);
 
-    if (quorum_intact)
-    {
-        ri->ri_leader.rls_quorum_ok_cnt++;
-        DBG_RAFT_INSTANCE(LL_DEBUG, ri, "quorum OK (cnt=%ld)",
-                          ri->ri_leader.rls_quorum_ok_cnt);
-    }
-    else
-    {
-        DBG_RAFT_INSTANCE(LL_WARN, ri, "quorum loss detected");
+            if (timespec_2_msec(&ts) > 0)
+                binary_hist_incorporate_val(bh, timespec_2_msec(&ts));
+        }
+        binary_hist_incorporate_val(
+            raft_server_type_2_hist(ri, RAFT_INSTANCE_HIST_COALESCED_WR_CNT),
+            nentries);
     }
 
-    return quorum_intact;
+
+    DBG_RAFT_INSTANCE(LL_NOTIFY, ri, "ri_last_applied was incremented");
+    DBG_RAFT_ENTRY(LL_NOTIFY, &reh, "");
+
+    // Release buffers
+    if (raps)
+        raft_server_apply_prefetch_release(ri, raps);
+    else if (sink_bi)
+        buffer_set_release_item(sink_bi);
+    else
+        raft_server_entry_view_release(ri, &rev);
 }
 
 /**
- * raft_server_may_process_client_request - this function checks the state of
- *    this raft instance to determine if it's qualified to accept a client
- *    request.
+ * raft_server_state_machine_apply - applies up to ri_sm_apply_batch raft
+ *    indexes so that the evp wakeup, the write mutex, and the reply buffer
+ *    are paid for once per batch rather than once per index.  The evp is
+ *    rearmed if committed entries remain once the batch is complete.
  */
-static raft_net_cb_ctx_int_t
-raft_server_may_accept_client_request(struct raft_instance *ri)
+static raft_server_epoll_sm_apply_bool_t
+raft_server_state_machine_apply(struct raft_instance *ri)
 {
     NIOVA_ASSERT(ri);
 
-    /* Not the leader, then cause a redirect reply to be done.
-     */
-    if (raft_instance_is_booting(ri))
-        return -EINPROGRESS;
+    DBG_RAFT_INSTANCE(LL_NOTIFY, ri, "");
 
-    else if (raft_instance_is_candidate(ri) ||
-             raft_instance_is_candidate_prevote(ri))
-        return -ENOENT;
+    if (!raft_server_needs_apply(ri))
+        return;
 
-    // 1. am I the raft leader?
-    else if (!raft_instance_is_leader(ri))
-        return -ENOSYS;
+    if (FAULT_INJECT(raft_server_bypass_sm_apply))
+        return;
 
-    // 2. am I a fresh raft leader?
-    else if (!raft_leader_instance_is_fresh(ri))
-        return -EAGAIN;
+    // Allow the prefetch thread to read ahead of this batch
+    raft_server_apply_prefetch_advance(ri);
 
-    // 3. have I applied all of the lastApplied entries that I need -
-    //    including a fake AE command (which is written to the logs)?
-    else if (!raft_leader_has_applied_txn_in_my_term(ri))
-        return -EBUSY;
+    struct buffer_item *reply_bi = NULL;
+    const size_t batch = MAX(ri->ri_sm_apply_batch, 1);
 
-    return 0;
+    for (size_t i = 0; i < batch && raft_server_needs_apply(ri); i++)
+        raft_server_state_machine_apply_entry(ri, &reply_bi);
+
+    if (reply_bi)
+        buffer_set_release_item(reply_bi);
+
+    if (raft_server_needs_apply(ri))
+        RAFT_NET_EVP_NOTIFY_NO_FAIL(ri, RAFT_EVP_SM_APPLY);
 }
 
-/*
- * Write the coalesced writes if timer expired for it.
- */
-static raft_net_timerfd_cb_ctx_t
-raft_server_leader_co_wr_timer_expired(struct raft_instance *ri)
+static raft_server_epoll_remote_sender_t
+raft_server_follower_send_sync_idx(struct raft_instance *ri)
 {
-    // Only the valid leader holding pending entries should proceed.
-    int rc = raft_server_may_accept_client_request(ri);
-    if (rc)
+    if (!ri || !raft_instance_is_follower(ri) ||
+        raft_server_does_synchronous_writes(ri))
         return;
 
-    niova_mutex_lock(&ri->ri_write_mutex);
-    if (ri->ri_coalesced_wr->rcwi_nentries && !FAULT_INJECT(coalesced_writes))
-    {
-        // Issue the pending write
-        raft_server_write_coalesced_entries(ri, __func__);
-    }
-    niova_mutex_unlock(&ri->ri_write_mutex);
+    // Extra check to ensure we don't send to ourselves
+    struct ctl_svc_node *leader = ri->ri_csn_leader;
+    if (leader == ri->ri_csn_this_peer)
+        return;
+
+    struct raft_entry_header reh = {0};
+    raft_instance_get_newest_header(ri, &reh, RI_NEHDR_SYNC);
+
+    struct raft_rpc_msg rrm = {
+        .rrm_type = RAFT_RPC_MSG_TYPE_SYNC_IDX_UPDATE,
+        .rrm_version = 0,
+        .rrm_sync_index_update.rsium_synced_log_index = reh.reh_index,
+        .rrm_sync_index_update.rsium_term = reh.reh_term,
+    };
+
+    raft_server_set_uuids_in_rpc_msg(ri, &rrm);
+
+    int rc = raft_server_send_msg(ri, RAFT_UDP_LISTEN_SERVER, leader, &rrm);
+
+    DBG_RAFT_INSTANCE((rc ? LL_NOTIFY : LL_DEBUG), ri,
+                      "raft_server_send_msg(): %s", strerror(-rc));
+}
+
+static raft_server_epoll_remote_sender_t
+raft_server_remote_send_evp_cb(const struct epoll_handle *eph, uint32_t events)
+{
+    NIOVA_ASSERT(eph);
+    (void)events;
+
+    FUNC_ENTRY(LL_DEBUG);
+
+    struct raft_instance *ri = eph->eph_arg;
+    struct ev_pipe *evp = raft_net_evp_get(ri, RAFT_EVP_REMOTE_SEND);
+
+    NIOVA_ASSERT(eph && eph->eph_fd == evp_read_fd_get(evp));
+
+    EV_PIPE_RESET(evp); // reset prior to dequeuing work
+
+    if (raft_instance_is_leader(ri))
+        raft_server_append_entry_sender(ri, false);
+
+    else if (raft_instance_is_follower(ri))
+        raft_server_follower_send_sync_idx(ri);
 }
 
+static raft_server_epoll_sm_apply_t
+raft_server_sm_apply_evp_cb(const struct epoll_handle *eph, uint32_t events)
+{
+    NIOVA_ASSERT(eph);
+    (void)events;
+
+    FUNC_ENTRY(LL_DEBUG);
+
+    struct raft_instance *ri = eph->eph_arg;
+    struct ev_pipe *evp = raft_net_evp_get(ri, RAFT_EVP_SM_APPLY);
+
+    NIOVA_ASSERT(eph && eph->eph_fd == evp_read_fd_get(evp));
 
-static const char *
-raft_server_may_accept_client_request_reason(struct raft_instance *ri)
-{
-    int rc = raft_server_may_accept_client_request(ri);
+    EV_PIPE_RESET(evp);
 
-    return raft_net_client_rpc_sys_error_2_string(rc);
-}
+    niova_mutex_lock(&ri->ri_write_mutex);
 
-static raft_net_cb_ctx_t
-raft_server_reply_to_client(struct raft_instance *ri,
-                            struct raft_net_client_request_handle *rncr,
-                            struct ctl_svc_node *csn)
-{
-    if (!ri || !ri->ri_csn_this_peer || !ri->ri_csn_raft || !rncr ||
-        !raft_net_client_request_handle_has_reply_info(rncr) ||
-        rncr->rncr_is_direct_req)
-        return;
+    raft_server_state_machine_apply(ri);
 
-    /* Copy the reply info from the provided rncr pointer.  This reply info
-     * fields have been written by the state_machine callback.
+    /* Writes held back while the previous entries were in flight may be
+     * issued now rather than waiting out the rest of their latency budget.
      */
-    const struct raft_client_rpc_msg *reply = rncr->rncr_reply.rncr_reply_ptr;
+    if (ri->ri_coalesced_writes && ri->ri_coalesced_wr &&
+        !raft_server_may_accept_client_request(ri) &&
+        !FAULT_INJECT(coalesced_writes))
+    {
+        enum raft_co_wr_flush_reason reason =
+            raft_server_co_wr_flush_reason(ri, false);
 
-    if (rncr->rncr_request)
-        DBG_RAFT_CLIENT_RPC(LL_DEBUG, rncr->rncr_request, "original request");
-    DBG_RAFT_CLIENT_RPC(LL_DEBUG, reply, "reply");
+        if (reason != RAFT_CO_WR_FLUSH_NONE)
+            raft_server_write_coalesced_entries(ri, __func__, reason);
+    }
 
-    int rc = raft_server_send_msg_to_client(ri, rncr, csn);
-    if (rc)
-        DBG_RAFT_CLIENT_RPC(LL_ERROR, reply,
-                            "raft_server_send_msg(): %s", strerror(rc));
+    niova_mutex_unlock(&ri->ri_write_mutex);
 }
 
-static raft_net_cb_ctx_t
-raft_server_deny_client_request(struct raft_instance *ri,
-                                    struct raft_net_client_request_handle *rncr,
-                                    struct ctl_svc_node *csn,
-                                    const int rc)
+static raft_server_epoll_t
+raft_server_commit_idx_adv_evp_cb(const struct epoll_handle *eph,
+                                  uint32_t events)
 {
-    NIOVA_ASSERT(ri && rncr && rncr->rncr_request && rncr->rncr_reply.rncr_reply_ptr);
+    NIOVA_ASSERT(eph);
+    FUNC_ENTRY(LL_DEBUG);
+    (void)events;
 
-    struct raft_client_rpc_msg *reply = rncr->rncr_reply.rncr_reply_ptr;
+    struct raft_instance *ri = eph->eph_arg;
+    struct ev_pipe *evp = raft_net_evp_get(ri, RAFT_EVP_ASYNC_COMMIT_IDX_ADV);
 
-    reply->rcrm_sys_error = rc;
+    NIOVA_ASSERT(eph->eph_fd == evp_read_fd_get(evp));
 
-    if (rc == -ENOSYS && ri->ri_csn_leader)
-    {
-        reply->rcrm_type = RAFT_CLIENT_RPC_MSG_TYPE_REDIRECT;
-        uuid_copy(reply->rcrm_redirect_id, ri->ri_csn_leader->csn_uuid);
-    }
+    EV_PIPE_RESET(evp);
 
-    return raft_server_reply_to_client(ri, rncr, csn);
+    if (raft_instance_is_leader(ri))
+        raft_server_leader_try_advance_commit_idx(ri);
 }
 
 /**
- * raft_server_client_reply_init - prepares a reply RPC by copying the
- *    relevant items from the original request.
+ * raft_server_read_reply_evp_cb - completes the reads serviced by the read
+ *    workers.  The leadership check and the reply are done here, in the main
+ *    raft thread, before the waiting workers are released.
  */
-static raft_net_cb_ctx_t
-raft_server_client_reply_init(const struct raft_instance *ri,
-                              struct raft_net_client_request_handle *rncr,
-                              enum raft_client_rpc_msg_type msg_type)
+static raft_server_epoll_t
+raft_server_read_reply_evp_cb(const struct epoll_handle *eph, uint32_t events)
 {
-    NIOVA_ASSERT(
-        ri && rncr &&
-        (rncr->rncr_is_direct_req ||
-         (rncr->rncr_reply.rncr_reply_ptr &&
-          (msg_type == RAFT_CLIENT_RPC_MSG_TYPE_PING_REPLY ||
-           msg_type == RAFT_CLIENT_RPC_MSG_TYPE_REPLY) &&
-          raft_net_client_request_handle_has_reply_info(rncr) &&
-          rncr->rncr_reply.rncr_reply_data_size <
-          rncr->rncr_reply.rncr_reply_data_max_size)));
-
-    struct raft_client_rpc_msg *reply = rncr->rncr_reply.rncr_reply_ptr;
-    memset(reply, 0, sizeof(struct raft_client_rpc_msg));
+    NIOVA_ASSERT(eph);
+    FUNC_ENTRY(LL_DEBUG);
+    (void)events;
 
-    uuid_copy(reply->rcrm_raft_id, ri->ri_csn_raft->csn_uuid);
-    uuid_copy(reply->rcrm_sender_id, ri->ri_csn_this_peer->csn_uuid);
-    uuid_copy(reply->rcrm_dest_id, rncr->rncr_client_uuid);
+    struct raft_instance *ri = eph->eph_arg;
+    struct ev_pipe *evp = raft_net_evp_get(ri, RAFT_EVP_READ_REPLY);
+    struct raft_work_queue *rwq = &ri->ri_read_reply_queue;
 
-    reply->rcrm_type = msg_type;
-    reply->rcrm_msg_id = rncr->rncr_msg_id;
-    reply->rcrm_data_size = rncr->rncr_reply.rncr_reply_data_size;
-}
+    NIOVA_ASSERT(eph->eph_fd == evp_read_fd_get(evp));
 
-static raft_net_cb_ctx_bool_t
-raft_server_client_recv_ignore_request(
-    struct raft_instance *ri, const struct raft_client_rpc_msg *rcm,
-    const struct sockaddr_in *from, struct ctl_svc_node **csn_out)
-{
-    NIOVA_ASSERT(rcm && from);
+    EV_PIPE_RESET(evp);
 
-    bool ignore_request = false;
-    const char *cause = NULL;
+    struct raft_srv_work replies;
+    STAILQ_INIT(&replies);
 
-    // Ensure this client's raft instance is consistent with ours.
-    int rc = raft_net_verify_sender_client_msg(ri, rcm->rcrm_raft_id);
-    if (rc)
-    {
-        cause = "raft_net_verify_sender_client_msg()";
-        ignore_request = true;
-    }
-    else
-    {
-        /* Lookup the client in the ctl-svc-node tree - existence is not
-         * mandatory.
-         */
-        struct ctl_svc_node *client_csn = NULL;
-        rc = ctl_svc_node_lookup(rcm->rcrm_sender_id, &client_csn);
-        if (rc)
-        {
-            DECLARE_AND_INIT_UUID_STR(sender_uuid,
-                                      rcm->rcrm_sender_id);
-            SIMPLE_LOG_MSG(LL_WARN, "ctl_svc_node_lookup(): %d uuid %s",
-                           rc, sender_uuid);
-            struct ctl_svc_node csn = {0};
+    niova_mutex_lock(&rwq->rsw_mutex);
+    STAILQ_CONCAT(&replies, &rwq->rsw_queue);
+    rwq->rsw_depth = 0;
+    niova_mutex_unlock(&rwq->rsw_mutex);
 
-            rc = ctl_svc_node_init(&csn, rcm->rcrm_raft_id, rcm->rcrm_sender_id,
-                                   CTL_SVC_NODE_TYPE_RAFT_CLIENT);
-            if (!rc)
-                rc = ctl_svc_node_add(&csn, &client_csn);
-            //fallthrough. ignore_request will be set to true.
-        }
+    if (STAILQ_EMPTY(&replies))
+        return;
 
-        if (!rc && client_csn)
-        {
-            if (client_csn->csn_type == CTL_SVC_NODE_TYPE_RAFT_CLIENT)
-            {
-                if (!net_ctl_can_recv(&client_csn->csn_peer.csnp_net_ctl))
-                {
-                    cause = "recv from this UUID is disabled";
-                    ignore_request = true;
-                }
-            }
-            else
-            {
-                cause = "UUID does not belong to a client";
-                ignore_request = true;
+    struct raft_read_work *rrw;
+    STAILQ_FOREACH(rrw, &replies, rrw_lentry)
+        raft_server_client_rncr_complete(ri, rrw->rrw_rncr, rrw->rrw_sm_rc);
 
-                DBG_CTL_SVC_NODE(
-                    LL_NOTIFY, client_csn,
-                    "recv'd RPC request from this non-client UUID");
-            }
+    // The workers may free their items once rrw_replied is set
+    niova_mutex_lock(&rwq->rsw_mutex);
 
-            if (ignore_request)
-                ctl_svc_node_put(client_csn);
-            else
-                *csn_out = client_csn;
-        }
-        else
-        {
-            cause = "CSN required";
-            ignore_request = true;
-        }
+    while ((rrw = STAILQ_FIRST(&replies)))
+    {
+        STAILQ_REMOVE_HEAD(&replies, rrw_lentry);
+        rrw->rrw_replied = true;
     }
 
-    if (ignore_request)
-        DBG_RAFT_CLIENT_RPC_SOCK(LL_NOTIFY, rcm, from, "%s (rc=%d)", cause, rc);
+    pthread_cond_broadcast(&rwq->rsw_cond);
 
-    return ignore_request;
+    niova_mutex_unlock(&rwq->rsw_mutex);
 }
 
-static void // raft_net_cb_ctx_t or raft_server_epoll_sm_apply_bool_t
-raft_server_net_client_request_init(
-    const struct raft_instance *ri,
-    struct raft_net_client_request_handle *rncr,
-    enum raft_net_client_request_type type,
-    const struct raft_client_rpc_msg *rpc_request,  const char *commit_data,
-    const size_t commit_data_size, const struct sockaddr_in *from,
-    char *reply_buf, const size_t reply_buf_size, bool is_direct_req)
+static epoll_mgr_cb_t
+raft_server_evp_2_cb_fn(enum raft_event_pipe_types evps)
 {
-    NIOVA_ASSERT(ri && rncr &&
-                 (is_direct_req ||
-                  (reply_buf &&
-                   reply_buf_size >= sizeof(struct raft_client_rpc_msg))));
+    switch (evps)
+    {
+    case RAFT_EVP_REMOTE_SEND:
+        return raft_server_remote_send_evp_cb;
+    case RAFT_EVP_SM_APPLY:
+        return raft_server_sm_apply_evp_cb;
+    case RAFT_EVP_ASYNC_COMMIT_IDX_ADV:
+        return raft_server_commit_idx_adv_evp_cb;
+    case RAFT_EVP_READ_REPLY:
+        return raft_server_read_reply_evp_cb;
+    default:
+        break;
+    }
+    return NULL;
+}
 
-    (void)from;
+static int
+raft_server_evp_setup(struct raft_instance *ri)
+{
+    if (!ri || raft_instance_is_client(ri))
+        return -EINVAL;
 
-    if (type == RAFT_NET_CLIENT_REQ_TYPE_NONE)
-        FATAL_IF((!rpc_request || commit_data),
-                 "invalid argument:  rpc_request may only be specified");
-    else if (type == RAFT_NET_CLIENT_REQ_TYPE_COMMIT)
-        FATAL_IF((rpc_request || !commit_data),
-                 "invalid argument:  commit_data may only be specified");
-    else
-        FATAL_MSG("invalid request type (%d)", type);
+    for (enum raft_event_pipe_types i = RAFT_EVP_SERVER__START;
+         i <= RAFT_EVP_SERVER__END; i++)
+    {
+        int rc = raft_net_evp_add(ri, raft_server_evp_2_cb_fn(i), i);
+        if (rc)
+        {
+            SIMPLE_LOG_MSG(LL_ERROR, "raft_net_evp_add(%d): %s",
+                           i, strerror(-rc));
+            return rc;
+        }
+    }
 
-    memset(rncr, 0, sizeof(struct raft_net_client_request_handle));
+    return 0;
+}
 
-    rncr->rncr_write_raft_entry = false;
-    rncr->rncr_type = type;
+static int
+raft_server_evp_cleanup(struct raft_instance *ri)
+{
+    if (!ri || raft_instance_is_client(ri))
+        return -EINVAL;
 
-    rncr->rncr_is_leader = raft_instance_is_leader(ri) ? true : false;
-    rncr->rncr_entry_term = ri->ri_log_hdr.rlh_term;
-    rncr->rncr_current_term = ri->ri_log_hdr.rlh_term;
-    rncr->rncr_is_direct_req = is_direct_req;
+    int rc = 0;
 
-    //direct request will not have reply buffer
-    if (reply_buf)
+    for (enum raft_event_pipe_types i = RAFT_EVP_SERVER__START;
+         i <= RAFT_EVP_SERVER__END; i++)
     {
-        //memset the reply_buf to make sure garbage values are not used from it.
-        memset(reply_buf, 0, reply_buf_size);
-
-        rncr->rncr_reply.rncr_reply_ptr =
-            (struct raft_client_rpc_msg  *)reply_buf;
+        int tmp_rc = raft_net_evp_remove(ri, i);
+        if (tmp_rc && !rc)
+            rc = tmp_rc;
     }
 
-    CONST_OVERRIDE(size_t, rncr->rncr_reply.rncr_reply_data_max_size,
-                   (reply_buf_size - sizeof(struct raft_client_rpc_msg)));
+    return rc;
+}
 
+static int
+raft_server_instance_startup(struct raft_instance *ri);
 
-    if (rpc_request)
-    {
-        rncr->rncr_request = rpc_request;
-        rncr->rncr_request_or_commit_data = rpc_request->rcrm_data;
+static int
+raft_server_instance_shutdown(struct raft_instance *ri);
 
-        CONST_OVERRIDE(size_t, rncr->rncr_request_or_commit_data_size,
-                       rpc_request->rcrm_data_size);
+static void
+raft_server_set_max_scan_entries(struct raft_instance *ri,
+                                 ssize_t max_scan_entries)
+{
+    NIOVA_ASSERT(ri);
 
-        /* These are reply specific items which are only provided when this
-         * function is called from raft_net_udp_cb_ctx_t context.
-         */
-        raft_net_client_request_handle_set_reply_info(
-            rncr, rpc_request->rcrm_sender_id, rpc_request->rcrm_msg_id);
+    if (max_scan_entries < 0)
+        ri->ri_max_scan_entries = (ssize_t)-1;
 
-        NIOVA_ASSERT(is_direct_req ||
-                     raft_net_client_request_handle_has_reply_info(rncr));
-    }
     else
-    {
-        /* raft_net_client_request_handle_set_reply_info() must be called from
-         * SM context if a post-commit reply is to be made.
-         */
-        rncr->rncr_request_or_commit_data = commit_data;
-
-        CONST_OVERRIDE(size_t, rncr->rncr_request_or_commit_data_size,
-                       commit_data_size);
+        ri->ri_max_scan_entries =
+            MAX(max_scan_entries,
+                RAFT_INSTANCE_PERSISTENT_APP_MIN_SCAN_ENTRIES);
 
-        // Sanity check of raft_net_client_request_handle_has_reply_info()
-        NIOVA_ASSERT(!raft_net_client_request_handle_has_reply_info(rncr));
-    }
+    SIMPLE_LOG_MSG(LL_WARN, "max_scan_entries=%zd", ri->ri_max_scan_entries);
 }
 
-static raft_net_cb_ctx_t
-raft_server_net_client_request_init_client_rpc(
-    struct raft_instance *ri, struct raft_net_client_request_handle *rncr,
-    const struct raft_client_rpc_msg *rpc_request,
-    const struct sockaddr_in *from, char *reply_buf,
-    const size_t reply_buf_size, bool is_direct_req)
+static void
+raft_server_set_log_reap_factor(struct raft_instance *ri,
+                                size_t log_reap_factor)
 {
-    NIOVA_ASSERT(ri && rncr && rpc_request);
+    NIOVA_ASSERT(ri);
 
-    raft_server_net_client_request_init(ri, rncr,
-                                        RAFT_NET_CLIENT_REQ_TYPE_NONE,
-                                        rpc_request, NULL, 0, from, reply_buf,
-                                        reply_buf_size, is_direct_req);
+    ri->ri_log_reap_factor = MIN(log_reap_factor,
+                                 RAFT_INSTANCE_PERSISTENT_APP_REAP_FACTOR_MAX);
 
-    // Reply is not sent for direct request enqueued from leader.
-    if (!is_direct_req)
-        raft_server_client_reply_init(
-           ri, rncr, (rpc_request->rcrm_type == RAFT_CLIENT_RPC_MSG_TYPE_PING ?
-                   RAFT_CLIENT_RPC_MSG_TYPE_PING_REPLY :
-                   RAFT_CLIENT_RPC_MSG_TYPE_REPLY));
+    SIMPLE_LOG_MSG(LL_WARN, "log_reap_factor=%zu", ri->ri_log_reap_factor);
 }
 
-/**
- * raft_server_write_coalesce_entry -
- * Keep collecting the incoming writes in re_coalesce_write raft_entry.
- */
 static void
-raft_server_write_coalesce_entry(struct raft_instance *ri, void *data, size_t len,
-                                void *app_data, size_t app_data_len,
-                                 enum raft_write_entry_opts opts)
+raft_server_set_num_checkpoints(struct raft_instance *ri, size_t num_ckpts)
 {
-    NIOVA_ASSERT(
-        ri && data && ri->ri_coalesced_wr &&
-        ri->ri_coalesced_wr->rcwi_nentries < RAFT_ENTRY_NUM_ENTRIES &&
-        ri->ri_coalesced_wr->rcwi_total_size < RAFT_ENTRY_MAX_DATA_SIZE(ri));
-
-    (void)opts;
+    NIOVA_ASSERT(ri);
 
-    // Buffer should have space to accomodate this request.
-    FATAL_IF((len + app_data_len + ri->ri_coalesced_wr->rcwi_total_size) >
-             RAFT_ENTRY_MAX_DATA_SIZE(ri),
-             "Coalesced buffer shouldn't be full here!. rcwi_total_size: %ld,"
-             " len: %ld",
-             ri->ri_coalesced_wr->rcwi_total_size, len + app_data_len);
+    num_ckpts = MAX(RAFT_INSTANCE_PERSISTENT_APP_CHKPT_MIN, num_ckpts);
 
-    /* Store the new write entry at the free slot at ri->ri_coalesced_wr.
-     * NOTE: that raft_server_write_coalesced_entries() will have reset
-     *    nentries so be sure to take the tmp variable AFTER calling it.
-     */
+    ri->ri_num_checkpoints = MIN(num_ckpts,
+                                 RAFT_INSTANCE_PERSISTENT_APP_CHKPT_MAX);
 
+    SIMPLE_LOG_MSG(LL_WARN, "num_checkpoints=%zu", ri->ri_num_checkpoints);
+}
 
-    //Copy the write request(*data) to the coalesced buffer
-    memcpy((ri->ri_coalesced_wr->rcwi_buffer +
-            ri->ri_coalesced_wr->rcwi_total_size), data, len);
-    uint32_t nentries = ri->ri_coalesced_wr->rcwi_nentries;
-    ri->ri_coalesced_wr->rcwi_entry_sizes[nentries] = len;
-    ri->ri_coalesced_wr->rcwi_total_size += len;
+static void
+raft_server_instance_init_rocksdb_persistent_app(struct raft_instance *ri)
+{
+    NIOVA_ASSERT(ri && raft_instance_is_booting(ri));
 
-    /* If the app_data is provided, copy it to the coalesced buffer.
-     * Note that app_data_len can be 0
-     */
-    if (app_data && app_data_len)
+    if (ri->ri_store_type == RAFT_INSTANCE_STORE_ROCKSDB_PERSISTENT_APP)
     {
-        memcpy((ri->ri_coalesced_wr->rcwi_buffer +
-                ri->ri_coalesced_wr->rcwi_total_size), app_data, app_data_len);
-        ri->ri_coalesced_wr->rcwi_entry_sizes[nentries] += app_data_len;
-        ri->ri_coalesced_wr->rcwi_total_size += app_data_len;
+        if (!ri->ri_max_scan_entries)
+            raft_server_set_max_scan_entries(
+                ri, RAFT_INSTANCE_PERSISTENT_APP_SCAN_ENTRIES);
+
+        if (!ri->ri_log_reap_factor)
+            raft_server_set_log_reap_factor(
+                ri, RAFT_INSTANCE_PERSISTENT_APP_REAP_FACTOR_DEFAULT);
+
+        if (!ri->ri_num_checkpoints)
+            raft_server_set_num_checkpoints(
+                ri, RAFT_INSTANCE_PERSISTENT_APP_CHKPT_DEFAULT);
     }
+}
 
-    ri->ri_coalesced_wr->rcwi_nentries++;
+static void
+raft_server_instance_init_tunables(struct raft_instance *ri)
+{
+    NIOVA_ASSERT(ri && raft_instance_is_booting(ri));
 
-    // Retest and push if the limits have been met.
-    if (!ri->ri_coalesced_writes ||
-        ri->ri_coalesced_wr->rcwi_nentries == RAFT_ENTRY_NUM_ENTRIES ||
-        ri->ri_coalesced_wr->rcwi_total_size == RAFT_ENTRY_MAX_DATA_SIZE(ri))
-        raft_server_write_coalesced_entries(ri, __func__);
+    if (ri->ri_store_type == RAFT_INSTANCE_STORE_ROCKSDB_PERSISTENT_APP)
+        raft_server_instance_init_rocksdb_persistent_app(ri);
 }
 
-static int
-raft_server_client_rncr_prepare(struct raft_instance *ri,
-                                const struct raft_client_rpc_msg *rcm,
-                                const struct sockaddr_in *from,
-                                struct raft_net_client_request_handle *rncr,
-                                enum raft_buf_set_type buf_type)
+static void
+raft_server_instance_restore_init_values(struct raft_instance *ri,
+                                         const struct raft_instance *save)
 {
-    NIOVA_ASSERT(ri && rcm && from && rncr && buf_type < RAFT_BUF_SET_MAX);
+    if (!ri || !save)
+        return;
 
-    struct ctl_svc_node *csn = NULL;
+    // Restore the recovery handle if this instance was bulk-recovered
+    ri->ri_successful_recovery = save->ri_successful_recovery;
 
-    // First set of request checks which are configuration based.
-    if (raft_server_client_recv_ignore_request(ri, rcm, from, &csn))
-    {
-        //XXX destroy the connection by setting tmc::tmc_user_error
-        SIMPLE_LOG_MSG(LL_NOTIFY, "cannot verify client message");
+    // ignore_timerfd may have been set at startup
+    ri->ri_ignore_timerfd = save->ri_ignore_timerfd;
 
-        if (csn != NULL)
-            ctl_svc_node_put(csn);
+    // Hosted instances remain attached to the host across restarts
+    ri->ri_hosted = save->ri_hosted;
+    ri->ri_host_buf_pool = save->ri_host_buf_pool;
+    ri->ri_host_workers = save->ri_host_workers;
 
-        return -EXDEV;
-    }
+    // bulk recovery items
+    ri->ri_max_scan_entries = save->ri_max_scan_entries;
+    ri->ri_log_reap_factor = save->ri_log_reap_factor;
+    ri->ri_num_checkpoints = save->ri_num_checkpoints;
 
-    struct buffer_item *bi =
-        buffer_set_allocate_item(&ri->ri_buf_set[buf_type]);
+    ri->ri_num_read_threads = save->ri_num_read_threads;
+    ri->ri_startup_scan_crc_threads = save->ri_startup_scan_crc_threads;
+    ri->ri_sm_apply_prefetch_depth = save->ri_sm_apply_prefetch_depth;
+    ri->ri_sm_apply_batch = save->ri_sm_apply_batch;
+    ri->ri_co_wr_latency_budget_us = save->ri_co_wr_latency_budget_us;
+    ri->ri_co_wr_max_entries = save->ri_co_wr_max_entries;
+    ri->ri_bulk_lane_depth = save->ri_bulk_lane_depth;
+    ri->ri_udp_mmsg_batch = save->ri_udp_mmsg_batch;
+    ri->ri_rpc_msg_version_max = save->ri_rpc_msg_version_max;
+    ri->ri_ae_compress_type = save->ri_ae_compress_type;
+    ri->ri_ae_compress_min_size = save->ri_ae_compress_min_size;
+    ri->ri_bulk_recovery_bw_limit = save->ri_bulk_recovery_bw_limit;
+
+    ri->ri_ae_window = save->ri_ae_window;
+    ri->ri_ae_max_packed_idx = save->ri_ae_max_packed_idx;
+
+    ri->ri_sync_group.rsg_max_batch_delay_us =
+        save->ri_sync_group.rsg_max_batch_delay_us;
+    ri->ri_sync_group.rsg_max_batch_size =
+        save->ri_sync_group.rsg_max_batch_size;
 
-    NIOVA_ASSERT(bi);
+    ri->ri_election_timeout_max_ms = save->ri_election_timeout_max_ms;
+    ri->ri_heartbeat_freq_per_election_min =
+        save->ri_heartbeat_freq_per_election_min;
 
-    raft_server_net_client_request_init_client_rpc(ri, rncr, rcm, from,
-                                                   (char *)bi->bi_iov.iov_base,
-                                                   bi->bi_bs->bs_item_size,
-                                                   false);
+    ri->ri_apply_handler_version = raft_net_get_apply_handler_version();
+}
 
-    // raft_server_net_client_request_init_client_rpc() clears out the rncr
-    rncr->rncr_bi = bi;
-    rncr->rncr_csn = csn;
+static void
+raft_server_instance_init(struct raft_instance *ri,
+                          enum raft_instance_store_type type,
+                          const char *raft_uuid_str,
+                          const char *this_peer_uuid_str,
+                          raft_sm_request_handler_t sm_request_handler,
+                          raft_init_cb_t init_peer_handler,
+                          enum raft_instance_options opts, void *arg)
+{
+    NIOVA_ASSERT(ri && raft_instance_is_booting(ri));
 
-    // Perform this check before handing back the rncr.
-    int rc = raft_server_may_accept_client_request(ri);
-    if (rc)
-    {
-        SIMPLE_LOG_MSG(LL_NOTIFY,
-                       "cannot accept client message, rc=%d: msg-type=%u",
-                       rc, rcm->rcrm_type);
+    /* Sanity check for the recovery to ensure that the lreg node had been
+     * uninstalled from the registry before reusing the object.
+     */
+    NIOVA_ASSERT(!lreg_node_is_installed(&ri->ri_lreg) &&
+                 !ri->ri_lreg_registered);
 
-        raft_server_deny_client_request(ri, rncr, csn, rc);
+    const struct raft_instance ri_save = *ri;
 
-        if (rncr->rncr_csn)
-        {
-            ctl_svc_node_put(rncr->rncr_csn);
-            rncr->rncr_csn = NULL;
-        }
+    // Wipe the instance and restore 'booting' state
+    memset(ri, 0, sizeof(*ri));
+    ri->ri_proc_state = RAFT_PROC_STATE_BOOTING;
 
-        if (rncr->rncr_bi)
-        {
-            buffer_set_release_item(rncr->rncr_bi);
-            rncr->rncr_bi = NULL;
-        }
-    }
+    raft_server_instance_restore_init_values(ri, &ri_save);
 
-    return rc;
-}
+    raft_instance_backend_type_specify(ri, type);
 
-static void
-raft_server_client_rncr_write_raft_entry(
-    struct raft_instance *ri, struct raft_net_client_request_handle *rncr)
-{
-    // Xxx Also check that this is the 'main' thread
-    NIOVA_ASSERT(ri && rncr && rncr->rncr_write_raft_entry &&
-                 rncr->rncr_request);
+    // Conditionally initialized values may have been by raft_net.c
+    if (!ri->ri_election_timeout_max_ms)
+        ri->ri_election_timeout_max_ms = RAFT_ELECTION_UPPER_TIME_MS;
 
-    const struct raft_client_rpc_msg *rcm = rncr->rncr_request;
+    if (!ri->ri_heartbeat_freq_per_election_min)
+        ri->ri_heartbeat_freq_per_election_min =
+            RAFT_HEARTBEAT_FREQ_PER_ELECTION;
 
-    /* For write operation, check if the coalesced buffer is sufficient for
-     * accomodating this request. Otherwise first flush the entries in
-     * coalesced buffer.
-     */
-    if ((rcm->rcrm_data_size + rncr->rncr_app_data.rncr_app_data_size +
-         ri->ri_coalesced_wr->rcwi_total_size) >
-        RAFT_ENTRY_MAX_DATA_SIZE(ri))
-    {
-        raft_server_write_coalesced_entries(ri, __func__);
-    }
+    ri->ri_check_quorum_timeout_factor = RAFT_ELECTION_CHECK_QUORUM_FACTOR;
+    ri->ri_raft_uuid_str = raft_uuid_str;
+    ri->ri_this_peer_uuid_str = this_peer_uuid_str;
+    ri->ri_server_sm_request_cb = sm_request_handler;
+    ri->ri_init_cb = init_peer_handler;
+    ri->ri_backend_init_arg = arg;
+    ri->ri_apply_handler_version = raft_net_get_apply_handler_version();
+    ri->ri_synchronous_writes =
+        opts & RAFT_INSTANCE_OPTIONS_SYNC_WRITES ? true : false;
+    ri->ri_coalesced_writes =
+        opts & RAFT_INSTANCE_OPTIONS_COALESCED_WRITES ? true : false;
+    ri->ri_posix_io_uring =
+        opts & RAFT_INSTANCE_OPTIONS_POSIX_IO_URING ? true : false;
+    ri->ri_posix_o_direct =
+        opts & RAFT_INSTANCE_OPTIONS_POSIX_O_DIRECT ? true : false;
+    ri->ri_rocksdb_single_kv =
+        opts & RAFT_INSTANCE_OPTIONS_ROCKSDB_SINGLE_KV ? true : false;
 
-    /* Store the request as an entry in the Raft log.  Do not reply to
-     * the client until the write is committed and applied!
-     *
-     * NOTE: that raft_server_write_coalesce_entry() is called regardless
-     *       of whether coalescing is enabling.  If disabled,
-     *       raft_server_write_coalesce_entry() will go directly to
-     *       raft_server_leader_write_new_entry()
-     * Merge the rncr write supplement into coalesced write supplement.
-     * rncr_sm_write_supp will be destroyed once it is merged into
-     * ri_coalesced_wr->rcwi_ws.
-     */
-    raft_net_sm_write_supplements_merge(&ri->ri_coalesced_wr->rcwi_ws,
-                                        &rncr->rncr_sm_write_supp);
+    ri->ri_auto_checkpoints_enabled =
+        opts & RAFT_INSTANCE_OPTIONS_AUTO_CHECKPOINT ? true : false;
+
+    ri->ri_commit_idx = -1;
+    ri->ri_last_applied = (struct raft_last_applied) {
+        .rla_idx = -1,
+        .rla_sub_idx = 0,
+        .rla_sub_idx_max = 0,
+        .rla_synced_idx = -1
+    };
+    ri->ri_checkpoint_last_idx = -1;
+    niova_atomic_init(&ri->ri_lowest_idx, -1);
+    niova_atomic_init(&ri->ri_pending_lowest_idx, RAFT_ENTRY_IDX_ANY);
 
-    raft_server_write_coalesce_entry(
-        ri, (void *)rcm->rcrm_data, rcm->rcrm_data_size,
-        (void *)rncr->rncr_app_data.rncr_app_data_ptr,
-        rncr->rncr_app_data.rncr_app_data_size, RAFT_WR_ENTRY_OPT_NONE);
-}
+    for (int i = 0; i < RAFT_READ_PIN_SLOTS; i++)
+        niova_atomic_init(&ri->ri_read_pins[i], RAFT_ENTRY_IDX_ANY);
 
-static void
-raft_server_client_rncr_complete(struct raft_instance *ri,
-                                 struct raft_net_client_request_handle *rncr,
-                                 int sm_cb_rc)
-{
-    NIOVA_ASSERT(ri && rncr && rncr->rncr_request);
+    raft_server_entry_cache_init(ri);
 
-    const struct raft_client_rpc_msg *rcm = rncr->rncr_request;
+    // AE tunables may have been preserved across a bulk recovery
+    if (!ri->ri_ae_window)
+        ri->ri_ae_window = RAFT_SERVER_AE_WINDOW_DEFAULT;
 
-    // Check leadership state before replying
-    int rc = raft_server_may_accept_client_request(ri);
-    if (rc || sm_cb_rc)
-    {
-        SIMPLE_LOG_MSG(LL_NOTIFY,
-                       "cannot accept client message, rc=(%d, %d): msg-type=%u",
-                       rc, sm_cb_rc, rcm->rcrm_type);
+    if (!ri->ri_ae_max_packed_idx)
+        ri->ri_ae_max_packed_idx = RAFT_SERVER_AE_PACKED_IDX_DEFAULT;
 
-        rc = rc ? rc : sm_cb_rc;
+    if (!ri->ri_sync_group.rsg_max_batch_size)
+        ri->ri_sync_group.rsg_max_batch_size = RAFT_SERVER_SYNC_MAX_BATCH_SIZE;
 
-        raft_server_deny_client_request(ri, rncr, rncr->rncr_csn, rc);
-    }
-    else
-    {
-        if (rncr->rncr_write_raft_entry)
-            raft_server_client_rncr_write_raft_entry(ri, rncr);
-        else
-            raft_server_reply_to_client(ri, rncr, rncr->rncr_csn);
-    }
+    if (!ri->ri_sm_apply_batch)
+        ri->ri_sm_apply_batch = RAFT_SERVER_SM_APPLY_BATCH_DEFAULT;
 
-    if (rncr->rncr_csn)
-        ctl_svc_node_put(rncr->rncr_csn);
+    if (!ri->ri_co_wr_latency_budget_us)
+        ri->ri_co_wr_latency_budget_us =
+            RAFT_SERVER_COALESCE_LATENCY_BUDGET_US_DEFAULT;
 
-    if (rncr->rncr_bi)
-        buffer_set_release_item(rncr->rncr_bi);
+    if (!ri->ri_co_wr_max_entries)
+        ri->ri_co_wr_max_entries = RAFT_SERVER_COALESCE_MAX_ENTRIES_DEFAULT;
+
+    if (!ri->ri_bulk_lane_depth)
+        ri->ri_bulk_lane_depth = RAFT_SERVER_BULK_LANE_DEPTH_DEFAULT;
+
+    raft_server_instance_init_tunables(ri);
+
+    ri->ri_startup_pre_net_bind_cb = raft_server_instance_startup;
+    ri->ri_shutdown_cb = raft_server_instance_shutdown;
+
+    /* Assign the timer_fd and udp_recv callbacks.
+     */
+    raft_net_instance_apply_callbacks(ri, raft_server_timerfd_cb,
+                                      raft_server_client_recv_handler,
+                                      raft_server_peer_recv_handler);
 }
 
-static raft_net_cb_ctx_t
-raft_server_client_recv_handler_ping(struct raft_instance *ri,
-                                     const struct raft_client_rpc_msg *rcm,
-                                     const struct sockaddr_in *from)
+static util_thread_ctx_reg_t
+raft_server_instance_hist_lreg_multi_facet_handler(
+    enum lreg_node_cb_ops op,
+    struct raft_instance_hist_stats *rihs,
+    struct lreg_value *lv)
 {
-    NIOVA_ASSERT(ri && rcm && rcm->rcrm_type == RAFT_CLIENT_RPC_MSG_TYPE_PING);
-
-    struct raft_net_client_request_handle rncr = {0};
+    if (!lv || !rihs || op != LREG_NODE_CB_OP_READ_VAL)
+        return;
 
-    int rc = raft_server_client_rncr_prepare(ri, rcm, from, &rncr,
-                                             RAFT_BUF_SET_SMALL);
-    if (rc == -EXDEV)
+    int hsz = binary_hist_size(&rihs->rihs_bh);
+    if (hsz < 0 || lv->lrv_value_idx_in >= (unsigned int)hsz)
         return;
 
-    SIMPLE_LOG_MSG(LL_NOTIFY, "ping reply");
+    snprintf(lv->lrv_key_string, LREG_VALUE_STRING_MAX, "%lld",
+             binary_hist_lower_bucket_range(&rihs->rihs_bh,
+                                            lv->lrv_value_idx_in));
 
-    raft_server_client_rncr_complete(ri, &rncr, rc);
+    LREG_VALUE_TO_OUT_SIGNED_INT(lv) =
+        binary_hist_get_cnt(&rihs->rihs_bh, lv->lrv_value_idx_in);
+
+    lv->get.lrv_value_type_out = LREG_VAL_TYPE_UNSIGNED_VAL;
 }
 
-static raft_net_cb_ctx_t
-raft_server_client_recv_handler_read(struct raft_instance *ri,
-                                     const struct raft_client_rpc_msg *rcm,
-                                     const struct sockaddr_in *from)
+static util_thread_ctx_reg_int_t
+raft_server_instance_hist_lreg_cb(enum lreg_node_cb_ops op,
+                                  struct lreg_node *lrn,
+                                  struct lreg_value *lv)
 {
-    NIOVA_ASSERT(rcm && rcm->rcrm_type == RAFT_CLIENT_RPC_MSG_TYPE_READ);
+    struct raft_instance_hist_stats *rihs = lrn->lrn_cb_arg;
 
-    struct raft_net_client_request_handle rncr = {0};
+    if (lv)
+        lv->get.lrv_num_keys_out = binary_hist_size(&rihs->rihs_bh);
 
-    int rc = raft_server_client_rncr_prepare(ri, rcm, from, &rncr,
-                                             RAFT_BUF_SET_LARGE);
-    if (rc)
-        return;
+    switch (op)
+    {
+    case LREG_NODE_CB_OP_GET_NAME:
+        if (!lv)
+            return -EINVAL;
 
-    /* Call into the application state machine logic to retrieve the requested
-     * data.
-     */
-    rc = ri->ri_server_sm_request_cb(&rncr);
+        lreg_value_fill_key_and_type(
+            lv, raft_instance_hist_stat_2_name(rihs->rihs_type),
+            LREG_VAL_TYPE_OBJECT);
+        break;
 
-    raft_server_client_rncr_complete(ri, &rncr, rc);
+    case LREG_NODE_CB_OP_READ_VAL:
+    case LREG_NODE_CB_OP_WRITE_VAL: //fall through
+        if (!lv)
+            return -EINVAL;
+
+        raft_server_instance_hist_lreg_multi_facet_handler(op, rihs, lv);
+        break;
+
+    case LREG_NODE_CB_OP_INSTALL_NODE:
+    case LREG_NODE_CB_OP_DESTROY_NODE:
+        break;
+
+    default:
+        return -ENOENT;
+    }
+
+    return 0;
 }
 
-static void // must be the main raft thread
-raft_server_do_client_write(struct raft_instance *ri,
-                            struct raft_net_client_request_handle *rncr)
+static int
+raft_server_instance_lreg_init(struct raft_instance *ri)
 {
-    // Need to ensure this is NOT tcp_mgr_thread_ctx()!
-    NIOVA_ASSERT(
-        ri && rncr->rncr_request &&
-        rncr->rncr_request->rcrm_type == RAFT_CLIENT_RPC_MSG_TYPE_WRITE);
+    // Root entry may already be install but the ri_lreg must not be
+    LREG_ROOT_ENTRY_INSTALL_ALREADY_OK(raft_root_entry);
 
-    NIOVA_ASSERT(rncr->rncr_bi != NULL);
+    // Check for a correctly resumed raft process
+    NIOVA_ASSERT(!lreg_node_is_installed(&ri->ri_lreg));
 
-    const struct raft_client_rpc_msg *rcm = rncr->rncr_request;
+    // First, init the parent
+    lreg_node_init(&ri->ri_lreg, LREG_USER_TYPE_RAFT, raft_instance_lreg_cb,
+                   ri, LREG_INIT_OPT_INLINED_CHILDREN);
 
-    /* Call into the application state machine logic.  There are several
-     * outcomes here:
-     * 1. SM detects a new write, here it may store sender info for reply
-     *    post-commit.
-     * 2. SM detects a write which had already been committed, here we reply
-     *    to the client notifying it of the completion.
-     * 3. SM detects a write which is still in progress, here no reply is sent.
-     */
-    niova_mutex_lock(&ri->ri_write_mutex);
+    NIOVA_ASSERT(
+        (LREG_USER_TYPE_HISTOGRAM__MAX - LREG_USER_TYPE_HISTOGRAM__MIN) >=
+        RAFT_INSTANCE_HIST_MAX);
 
-    int rc = ri->ri_server_sm_request_cb(rncr);
+    // Install the inlined objects into the parent
+    for (enum raft_instance_hist_types i = RAFT_INSTANCE_HIST_MIN;
+         i < RAFT_INSTANCE_HIST_MAX; i++)
+    {
+        enum lreg_user_types x = (enum lreg_user_types)i;
+        lreg_node_init(&ri->ri_rihs[i].rihs_lrn, x,
+                       raft_server_instance_hist_lreg_cb,
+                       (void *)&ri->ri_rihs[i],
+                       (LREG_INIT_OPT_IGNORE_NUM_VAL_ZERO |
+                        LREG_INIT_OPT_INLINED_MEMBER));
 
-    enum log_level log_level = rc ? LL_WARN : LL_DEBUG;
+        int rc =
+            lreg_node_install(&ri->ri_rihs[i].rihs_lrn, &ri->ri_lreg);
 
-    DBG_RAFT_CLIENT_RPC(log_level, rcm, "write-2-raft=%s op_error=%s, rc=%s",
-                        rncr->rncr_write_raft_entry ? "yes" : "no",
-                        strerror(-rncr->rncr_op_error), strerror(-rc));
+        if (rc)
+            return rc;
+    }
 
-    raft_server_client_rncr_complete(ri, rncr, rc);
+    /* The raft_net root objects serve the default instance.  The others
+     * carry their raft_net objects inlined.
+     */
+    if (ri != raft_net_get_instance())
+    {
+        int rc = raft_net_instance_lreg_install(ri, &ri->ri_lreg);
+        if (rc)
+            return rc;
+    }
 
-    niova_mutex_unlock(&ri->ri_write_mutex);
+    // Last, install the parent w/ it's child objects already in place
+    return lreg_node_install(&ri->ri_lreg,
+                             LREG_ROOT_ENTRY_PTR(raft_root_entry));
 }
 
-static void
-raft_server_client_recv_handler_write(struct raft_instance *ri,
-                                      const struct raft_client_rpc_msg *rcm,
-                                      const struct sockaddr_in *from)
+#if 0
+static int
+raft_server_instance_lreg_remove(struct raft_instance *ri)
 {
-    NIOVA_ASSERT(rcm && rcm->rcrm_type == RAFT_CLIENT_RPC_MSG_TYPE_WRITE);
+    if (!ri)
+        return -EINVAL;
 
-    struct raft_net_client_request_handle rncr = {0};
+    else if (!lreg_node_is_installed(&ri->ri_lreg))
+        return -EALREADY;
 
-    int rc = raft_server_client_rncr_prepare(ri, rcm, from, &rncr,
-                                             RAFT_BUF_SET_LARGE);
-    if (rc)
-        return;
 
-    return raft_server_do_client_write(ri, &rncr);
+    return 0;
 }
+#endif
 
-static raft_net_cb_ctx_t
-raft_server_client_recv_handler(struct raft_instance *ri,
-                                const char *recv_buffer, ssize_t recv_bytes,
-                                const struct sockaddr_in *from)
+static void
+raft_server_timedwait_deadline(struct timespec *ts,
+                               const unsigned long long usec)
 {
-    SIMPLE_FUNC_ENTRY(LL_TRACE);
-    NIOVA_ASSERT(ri && from);
+    NIOVA_ASSERT(ts);
 
-    if (!recv_buffer || !recv_bytes || !ri->ri_server_sm_request_cb ||
-        recv_bytes < (ssize_t)sizeof(struct raft_client_rpc_msg))
-    {
-        LOG_MSG(LL_NOTIFY, "sanity check fail, buf %p bytes %ld cb %p",
-                recv_buffer, recv_bytes, ri->ri_server_sm_request_cb);
-        return;
-    }
+    clock_gettime(CLOCK_REALTIME, ts);
 
-    const struct raft_client_rpc_msg *rcm =
-        (const struct raft_client_rpc_msg *)recv_buffer;
+    ts->tv_sec += usec / 1000000;
+    ts->tv_nsec += (usec % 1000000) * 1000;
 
-    switch (rcm->rcrm_type)
+    if (ts->tv_nsec >= 1000000000)
     {
-    case RAFT_CLIENT_RPC_MSG_TYPE_READ:
-        return raft_server_client_recv_handler_read(ri, rcm, from);
-
-    case RAFT_CLIENT_RPC_MSG_TYPE_WRITE:
-        return raft_server_client_recv_handler_write(ri, rcm, from);
-
-    case RAFT_CLIENT_RPC_MSG_TYPE_PING:
-        return raft_server_client_recv_handler_ping(ri, rcm, from);
-
-    default:
-        //Xxx end the connection
-        break;
-    };
+        ts->tv_sec++;
+        ts->tv_nsec -= 1000000000;
+    }
 }
 
 /**
- * raft_server_append_entry_should_send_to_follower - helper function which
- *    manages the rfi_ae_sends_wait_until value for the given peer_idx.
- *    It returns a true when either the peer is not detected as unresponsive
- *    or after the waiting period has passed.
+ * raft_server_sync_group_wait - blocks the sync thread until a writer posts
+ *    an entry or until ri_sync_freq_us has passed.  Once an entry has been
+ *    posted, the batch stays open for up to rsg_max_batch_delay_us or until
+ *    rsg_max_batch_size entries are present.  Returns the number of entries
+ *    posted into this batch.
  */
-static bool
-raft_server_append_entry_should_send_to_follower(
-    struct raft_instance *ri,
-    const raft_peer_t raft_peer_idx)
+static raft_server_sync_thread_ctx_size_t
+raft_server_sync_group_wait(struct raft_instance *ri)
 {
-    NIOVA_ASSERT(ri && ri->ri_csn_raft &&
-                 raft_member_idx_is_valid(ri, raft_peer_idx));
-
-    struct raft_follower_info *rfi =
-        raft_server_get_follower_info(ri, raft_peer_idx);
-
-    unsigned long long now_msec = niova_unstable_coarse_clock_get_msec();
-    unsigned long long since_last_unacked = 0;
+    NIOVA_ASSERT(ri);
 
-    int rc = raft_net_comm_recency(ri, raft_peer_idx,
-                                   RAFT_COMM_RECENCY_UNACKED_SEND,
-                                   &since_last_unacked);
-    if (rc == -EALREADY)
-        return false;
-    NIOVA_ASSERT(!rc);
+    struct raft_sync_group *rsg = &ri->ri_sync_group;
+    struct timespec deadline;
 
-    bool send_msg = true;
+    niova_mutex_lock(&rsg->rsg_mutex);
 
-    if (since_last_unacked > 0) // No recv'd msgs since last send.
+    // The timed wait bounds the thread's response to a halt request
+    if (!rsg->rsg_pending)
     {
-        if (now_msec > rfi->rfi_ae_sends_wait_until)
-            rfi->rfi_ae_sends_wait_until =
-                (now_msec +
-                 MIN(RAFT_NET_MAX_RETRY_MS,
-                     (rfi->rfi_ae_sends_wait_until * 2 + 1)));
-        else
-            send_msg = false;
+        raft_server_timedwait_deadline(&deadline, ri->ri_sync_freq_us);
+        pthread_cond_timedwait(&rsg->rsg_cond, &rsg->rsg_mutex, &deadline);
     }
-    else
+
+    if (rsg->rsg_pending && rsg->rsg_max_batch_delay_us)
     {
-        rfi->rfi_ae_sends_wait_until = 0;
+        raft_server_timedwait_deadline(&deadline,
+                                       rsg->rsg_max_batch_delay_us);
+
+        while (rsg->rsg_pending < rsg->rsg_max_batch_size)
+            if (pthread_cond_timedwait(&rsg->rsg_cond, &rsg->rsg_mutex,
+                                       &deadline) == ETIMEDOUT)
+                break;
     }
 
-    const raft_entry_idx_t unsync_idx =
-        raft_server_get_current_raft_entry_index(ri, RI_NEHDR_UNSYNC);
+    const size_t batch_size = rsg->rsg_pending;
+    rsg->rsg_pending = 0;
 
-    // This is not a recency check and should be in a separate function Xxx
-    if (rfi->rfi_next_idx > unsync_idx)
+    niova_mutex_unlock(&rsg->rsg_mutex);
+
+    return batch_size;
+}
+
+/**
+ * raft_server_sync_pass - syncs the entries written since the last pass, if
+ *    any.  Run by the instance's sync thread or by one of the host's.
+ */
+static raft_server_sync_thread_ctx_t
+raft_server_sync_pass(struct raft_instance *ri, const size_t batch_size)
+{
+    const bool has_unsynced_entries = raft_server_has_unsynced_entries(ri);
+
+    DBG_RAFT_INSTANCE((has_unsynced_entries ? LL_DEBUG : LL_TRACE), ri,
+                      "raft_server_has_unsynced_entries(): %d (posted=%zu)",
+                      has_unsynced_entries, batch_size);
+
+    if (has_unsynced_entries)
     {
-        // May only be ahead by '1'
-        NIOVA_ASSERT(rfi->rfi_next_idx == unsync_idx + 1);
-        send_msg = false;
-    }
+        raft_server_backend_sync_pending(ri, __func__);
+        ri->ri_sync_cnt++;
 
-    return send_msg;
+        raft_server_leader_try_advance_commit_idx_from_sync_thread(ri);
+    }
 }
 
-static raft_server_epoll_remote_sender_t
-raft_server_append_entry_sender(struct raft_instance *ri, bool heartbeat)
+static raft_server_sync_thread_t
+raft_server_sync_thread(void *arg)
 {
+    struct thread_ctl *tc = arg;
+    struct raft_instance *ri = (struct raft_instance *)thread_ctl_get_arg(tc);
+
+    if (!ri->ri_sync_freq_us)
+        ri->ri_sync_freq_us = RAFT_SERVER_SYNC_FREQ_US;
+
     NIOVA_ASSERT(ri);
 
-    const int64_t my_raft_idx =
-        raft_server_get_current_raft_entry_index(ri, RI_NEHDR_UNSYNC);
+    THREAD_LOOP_WITH_CTL(tc)
+    {
+        const size_t batch_size = raft_server_sync_group_wait(ri);
 
-    if (!raft_instance_is_leader(ri) || my_raft_idx < 0)
-        return;
+        DBG_THREAD_CTL(LL_TRACE, tc, "here");
+        raft_server_sync_pass(ri, batch_size);
+    }
 
-    struct buffer_item *src_bi =
-        buffer_set_allocate_item(&ri->ri_buf_set[RAFT_BUF_SET_LARGE]);
+    return (void *)0;
+}
 
-    NIOVA_ASSERT(src_bi);
+static int
+raft_server_sync_group_destroy(struct raft_instance *ri)
+{
+    NIOVA_ASSERT(ri);
 
-    struct raft_rpc_msg *rrm =
-        (struct raft_rpc_msg *)((char *)src_bi->bi_iov.iov_base);
+    int rc = pthread_cond_destroy(&ri->ri_sync_group.rsg_cond);
+    int mutex_rc = pthread_mutex_destroy(&ri->ri_sync_group.rsg_mutex);
+    int sync_mutex_rc =
+        pthread_mutex_destroy(&ri->ri_sync_group.rsg_sync_mutex);
 
-    const raft_peer_t num_raft_members = raft_num_members_validate_and_get(ri);
+    return rc ? rc : mutex_rc ? mutex_rc : sync_mutex_rc;
+}
 
-    ///Xxx this is a big mess of code which needs to be made into some
-    //     subroutines.
-    for (raft_peer_t i = 0; i < num_raft_members; i++)
-    {
-        struct ctl_svc_node *rp = ri->ri_csn_raft_peers[i];
+static int
+raft_server_sync_thread_start(struct raft_instance *ri)
+{
+    NIOVA_ASSERT(ri && raft_instance_is_booting(ri));
 
-        if (rp == ri->ri_csn_this_peer ||
-            (!raft_server_append_entry_should_send_to_follower(ri, i) &&
-             !heartbeat))
-            continue;
+    if (raft_server_does_synchronous_writes(ri))
+        return 0;
 
-        int rc = raft_server_leader_init_append_entry_msg(ri, rrm, i,
-                                                          heartbeat);
-        NIOVA_ASSERT(!rc || rc == -ESTALE); // sanity check
-        if (rc == -ESTALE)
-        {
-            /* raft_server_leader_init_append_entry_msg() detected that the
-             * entry needed by the follower has been compacted.  Still send
-             * a msg so that the follower knows to enter bulk recovery.
-             */
-            heartbeat = true; // force this to be a heartbeat msg
-            NIOVA_ASSERT(rrm->rrm_append_entries_request.raerqm_heartbeat_msg);
-        }
+    int rc = thread_create_watched(raft_server_sync_thread,
+                                   &ri->ri_sync_thread_ctl,
+                                   "sync_thread", (void *)ri, NULL);
+     if (rc)
+	return rc;
+
+    thread_ctl_run(&ri->ri_sync_thread_ctl);
 
-        struct raft_append_entries_request_msg *raerq =
-            &rrm->rrm_append_entries_request;
+    return 0;
+}
 
-        const int64_t peer_next_raft_idx = raerq->raerqm_prev_log_index + 1;
+static int
+raft_server_sync_thread_join(struct raft_instance *ri)
+{
+    NIOVA_ASSERT(ri && raft_instance_is_shutdown(ri));
 
-        DBG_RAFT_INSTANCE_FATAL_IF((peer_next_raft_idx - 1 > my_raft_idx), ri,
-                                   "follower's idx > leader's (%ld > %ld)",
-                                   peer_next_raft_idx, my_raft_idx);
+    if (raft_server_does_synchronous_writes(ri))
+        return 0;
 
-        if (!heartbeat && peer_next_raft_idx <= my_raft_idx)
-        {
-            struct raft_entry_header reh = {0};
+    int rc = thread_halt_and_destroy(&ri->ri_sync_thread_ctl);
 
-            // raft_server_entry_header_read_by_store() verifies reh contents
-            int rc = raft_server_entry_header_read_by_store(
-                ri, &reh, peer_next_raft_idx);
+    LOG_MSG(((rc && !ri->ri_startup_error) ? LL_WARN : LL_NOTIFY),
+            "thread_halt_and_destroy(): %s", strerror(-rc));
 
-            if (rc == -ERANGE) // allow -ERANGE
-                continue;
+    return rc;
+}
 
-            DBG_RAFT_INSTANCE_FATAL_IF(
-                (rc), ri, "raft_server_entry_header_read_by_store(%ld): %s",
-                peer_next_raft_idx, strerror(-rc));
+/**
+ * raft_server_read_worker_thread - services the client read requests placed
+ *    onto this worker's queue by raft_server_read_worker_enqueue().
+ */
+static raft_server_rw_thread_t
+raft_server_read_worker_thread(void *arg)
+{
+    struct thread_ctl *tc = arg;
+    struct raft_rw_worker_thread *rrwt =
+        (struct raft_rw_worker_thread *)thread_ctl_get_arg(tc);
 
-            raerq->raerqm_entries_sz = reh.reh_data_size;
+    NIOVA_ASSERT(rrwt && rrwt->rrwt_arg && rrwt->rrwt_reply_buff);
 
-            raerq->raerqm_leader_change_marker = reh.reh_leader_change_marker;
-            raerq->raerqm_num_entries = reh.reh_num_entries;
-            memcpy(&raerq->raerqm_size_arr[0], &reh.reh_entry_sz[0],
-                   sizeof(uint32_t) * RAFT_ENTRY_NUM_ENTRIES);
+    struct raft_instance *ri = rrwt->rrwt_arg;
+    struct raft_work_queue *rwq = &rrwt->rrwt_queue;
 
-            NIOVA_ASSERT(reh.reh_index == peer_next_raft_idx);
+    THREAD_LOOP_WITH_CTL(tc)
+    {
+        struct timespec ts;
 
-            if (raerq->raerqm_entries_sz)
-            {
-                rc = raft_server_entry_read(ri, peer_next_raft_idx,
-                                            raerq->raerqm_entries,
-                                            raerq->raerqm_entries_sz, NULL);
-                if (rc == -ERANGE)
-                    continue;
-
-                DBG_RAFT_INSTANCE_FATAL_IF((rc), ri,
-                                           "raft_server_entry_read(): %s",
-                                           strerror(-rc));
-            }
+        niova_mutex_lock(&rwq->rsw_mutex);
+
+        // The timed wait bounds the thread's response to a halt request
+        if (STAILQ_EMPTY(&rwq->rsw_queue))
+        {
+            raft_server_timedwait_deadline(&ts,
+                                           RAFT_SERVER_READ_WORKER_WAIT_US);
+            pthread_cond_timedwait(&rwq->rsw_cond, &rwq->rsw_mutex, &ts);
         }
-        else
+
+        struct raft_read_work *rrw = STAILQ_FIRST(&rwq->rsw_queue);
+        if (rrw)
         {
-            raerq->raerqm_entries_sz = 0;
-            raerq->raerqm_num_entries = 0;
-            memset(&raerq->raerqm_size_arr, 0,
-                   sizeof(uint32_t) * RAFT_ENTRY_NUM_ENTRIES);
-            raerq->raerqm_leader_change_marker = 0;
-            raerq->raerqm_heartbeat_msg = 1;
+            STAILQ_REMOVE_HEAD(&rwq->rsw_queue, rrw_lentry);
+            rwq->rsw_depth--;
         }
 
-        DBG_SIMPLE_CTL_SVC_NODE(
-            (heartbeat ? LL_DEBUG : LL_NOTIFY), rp,
-            "idx=%hhx pli=%ld lt=%ld", i,
-            rrm->rrm_append_entries_request.raerqm_prev_log_index,
-            rrm->rrm_append_entries_request.raerqm_log_term);
+        niova_mutex_unlock(&rwq->rsw_mutex);
+
+        DBG_THREAD_CTL(LL_TRACE, tc, "here");
+        if (!rrw)
+            continue;
+
+        rrwt->rrwt_work = rrw;
 
-        rc = raft_server_send_msg(ri, RAFT_UDP_LISTEN_SERVER, rp, rrm);
+        raft_server_client_read_process(
+            ri, (const struct raft_client_rpc_msg *)rrw->rrw_buf,
+            &rrw->rrw_from, rrwt);
 
-        // log errors, but raft will retry if needed
-        DBG_RAFT_INSTANCE((rc ? LL_NOTIFY : LL_TRACE), ri,
-                          "raft_server_send_msg(): %d", rc);
+        rrwt->rrwt_work = NULL;
+
+        // Latency includes the time spent in the queue
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        timespecsub(&ts, &rrw->rrw_enqueue_time, &ts);
+
+        const unsigned long long lat_usec =
+            (ts.tv_sec * 1000000ULL) + (ts.tv_nsec / 1000);
+
+        niova_mutex_lock(&rwq->rsw_mutex);
+
+        rrwt->rrwt_nreqs++;
+        rrwt->rrwt_lat_usec_total += lat_usec;
+        if (lat_usec > rrwt->rrwt_lat_usec_max)
+            rrwt->rrwt_lat_usec_max = lat_usec;
+
+        niova_mutex_unlock(&rwq->rsw_mutex);
+
+        niova_free(rrw);
     }
 
-    // release buffer
-    buffer_set_release_item(src_bi);
+    return (void *)0;
 }
 
-static raft_server_epoll_sm_apply_t
-raft_server_sm_apply_opt(struct raft_instance *ri,
-                         struct raft_net_sm_write_supplements *ws)
+static int
+raft_server_read_worker_start(struct raft_instance *ri,
+                              struct raft_rw_worker_thread *rrwt)
 {
-    NIOVA_ASSERT(ri);
+    NIOVA_ASSERT(ri && rrwt);
 
-    if (ri->ri_backend->rib_sm_apply_opt)
-        ri->ri_backend->rib_sm_apply_opt(ri, ws);
-}
+    struct raft_work_queue *rwq = &rrwt->rrwt_queue;
 
-static raft_server_epoll_sm_apply_bool_t
-raft_server_net_client_request_init_sm_apply(
-    struct raft_instance *ri, struct raft_net_client_request_handle *rncr,
-    char *commit_data, const size_t commit_data_size, char *reply_buf,
-    const size_t reply_buf_size)
-{
-    NIOVA_ASSERT(ri && rncr && commit_data);
+    rrwt->rrwt_reply_buff = niova_posix_memalign(RAFT_BS_LARGE_SZ,
+                                                 BUFFER_SECTOR_SIZE);
+    if (!rrwt->rrwt_reply_buff)
+        return -ENOMEM;
 
-    raft_server_net_client_request_init(ri, rncr,
-                                        RAFT_NET_CLIENT_REQ_TYPE_COMMIT,
-                                        NULL, commit_data, commit_data_size,
-                                        NULL, reply_buf, reply_buf_size,
-                                        false);
+    FATAL_IF((pthread_mutex_init(&rwq->rsw_mutex, NULL)),
+             "pthread_mutex_init(): %s", strerror(errno));
+
+    FATAL_IF((pthread_cond_init(&rwq->rsw_cond, NULL)),
+             "pthread_cond_init(): %s", strerror(errno));
+
+    STAILQ_INIT(&rwq->rsw_queue);
+    rwq->rsw_depth = 0;
+    rrwt->rrwt_arg = ri;
+
+    int rc = thread_create_watched(raft_server_read_worker_thread,
+                                   &rrwt->rrwt_thread_ctl, "read_worker",
+                                   (void *)rrwt, NULL);
+    if (rc)
+    {
+        pthread_cond_destroy(&rwq->rsw_cond);
+        pthread_mutex_destroy(&rwq->rsw_mutex);
+        niova_free(rrwt->rrwt_reply_buff);
+        rrwt->rrwt_reply_buff = NULL;
+
+        return rc;
+    }
+
+    thread_ctl_run(&rrwt->rrwt_thread_ctl);
+
+    return 0;
 }
 
 /**
- * raft_server_backend_setup_last_applied - called in setup context to provide
- *    the last-applied info from a stateful backend, such as RocksDB.
+ * raft_server_read_workers_start - starts ri_num_read_threads client read
+ *    workers.  ri_num_read_workers is only advanced once a worker is
+ *    running so that it may be used by the join function after a failure.
  */
-void
-raft_server_backend_setup_last_applied(struct raft_instance *ri,
-                                       struct raft_last_applied *rla)
+static int
+raft_server_read_workers_start(struct raft_instance *ri)
 {
-    NIOVA_ASSERT(ri && (raft_instance_is_booting(ri) ||
-                        raft_instance_is_recovering(ri)));
+    NIOVA_ASSERT(ri && raft_instance_is_booting(ri) &&
+                 !ri->ri_num_read_workers);
 
-    ri->ri_last_applied = *rla;
-}
+    const size_t nworkers = MIN(ri->ri_num_read_threads,
+                                RAFT_NUM_READ_THREADS);
+    if (!nworkers)
+        return 0;
 
-static raft_server_epoll_sm_apply_t
-raft_server_set_last_applied(struct raft_instance *ri,
-                             struct raft_last_applied *nai)
-{
-    NIOVA_ASSERT(ri && nai &&
-                 (nai->rla_idx >= ri->ri_last_applied.rla_idx &&
-                  nai->rla_sub_idx <= nai->rla_sub_idx_max));
+    struct raft_work_queue *reply_rwq = &ri->ri_read_reply_queue;
 
-    ri->ri_last_applied.rla_idx = nai->rla_idx;
-    ri->ri_last_applied.rla_sub_idx = nai->rla_sub_idx;
-    ri->ri_last_applied.rla_sub_idx_max = nai->rla_sub_idx_max;
+    FATAL_IF((pthread_mutex_init(&reply_rwq->rsw_mutex, NULL)),
+             "pthread_mutex_init(): %s", strerror(errno));
 
-    /* The cumulative crc is supposed to updated for each sub entry apply
-     * However, for now the cumulative crc will be updated once all sub entries
-     * are applied.
-     */
-    if (nai->rla_sub_idx == nai->rla_sub_idx_max)
+    FATAL_IF((pthread_cond_init(&reply_rwq->rsw_cond, NULL)),
+             "pthread_cond_init(): %s", strerror(errno));
+
+    STAILQ_INIT(&reply_rwq->rsw_queue);
+    reply_rwq->rsw_depth = 0;
+    ri->ri_read_reply_queue_open = true;
+
+    for (size_t i = 0; i < nworkers; i++)
     {
-        ri->ri_last_applied.rla_cumulative_crc = nai->rla_cumulative_crc;
-        ri->ri_last_applied.rla_kv_cumulative_crc = nai->rla_kv_cumulative_crc;
+        int rc =
+            raft_server_read_worker_start(ri, &ri->ri_reader_thread_ctl[i]);
+        if (rc)
+            return rc;
+
+        ri->ri_num_read_workers++;
     }
-    else
-        nai->rla_sub_idx++;
-}
 
-static bool
-raft_server_needs_apply(const struct raft_instance *ri)
-{
-    NIOVA_ASSERT(ri);
-    NIOVA_ASSERT(ri->ri_last_applied.rla_idx <= ri->ri_commit_idx);
+    SIMPLE_LOG_MSG(LL_NOTIFY, "read workers started: %zu",
+                   ri->ri_num_read_workers);
 
-    return (ri->ri_last_applied.rla_idx < ri->ri_commit_idx ||
-            (ri->ri_last_applied.rla_idx == ri->ri_commit_idx &&
-             ri->ri_last_applied.rla_sub_idx <
-             ri->ri_last_applied.rla_sub_idx_max));
+    return 0;
 }
 
-static void
-raft_server_next_apply_idx(const struct raft_instance *ri,
-                           struct raft_last_applied *nai)
+static int
+raft_server_read_workers_join(struct raft_instance *ri)
 {
-    NIOVA_ASSERT(ri && nai);
-    NIOVA_ASSERT(ri->ri_last_applied.rla_sub_idx <=
-                 ri->ri_last_applied.rla_sub_idx_max);
+    NIOVA_ASSERT(ri && raft_instance_is_shutdown(ri));
 
-    *nai = ri->ri_last_applied;
+    const size_t nworkers = ri->ri_num_read_workers;
+    const bool reply_queue_open = ri->ri_read_reply_queue_open;
+    struct raft_work_queue *reply_rwq = &ri->ri_read_reply_queue;
+    int rc = 0;
 
-    if (nai->rla_sub_idx == nai->rla_sub_idx_max)
+    // Stop new requests from being enqueued
+    ri->ri_num_read_workers = 0;
+
+    /* The main loop has exited so replies may no longer be sent.  Release the
+     * workers waiting on a reply so that they may be halted.
+     */
+    if (reply_queue_open)
     {
-        nai->rla_sub_idx = 0;
-        nai->rla_sub_idx_max = 0;
-        nai->rla_idx++;
+        niova_mutex_lock(&reply_rwq->rsw_mutex);
+
+        ri->ri_read_reply_queue_open = false;
+
+        struct raft_read_work *rrw;
+        while ((rrw = STAILQ_FIRST(&reply_rwq->rsw_queue)))
+        {
+            STAILQ_REMOVE_HEAD(&reply_rwq->rsw_queue, rrw_lentry);
+            raft_server_client_rncr_release(rrw->rrw_rncr);
+            rrw->rrw_replied = true;
+        }
+        reply_rwq->rsw_depth = 0;
+
+        pthread_cond_broadcast(&reply_rwq->rsw_cond);
+
+        niova_mutex_unlock(&reply_rwq->rsw_mutex);
     }
-    else
+
+    for (size_t i = 0; i < nworkers; i++)
     {
-        nai->rla_sub_idx++;
+        struct raft_rw_worker_thread *rrwt = &ri->ri_reader_thread_ctl[i];
+        struct raft_work_queue *rwq = &rrwt->rrwt_queue;
+
+        int halt_rc = thread_halt_and_destroy(&rrwt->rrwt_thread_ctl);
+
+        LOG_MSG(((halt_rc && !ri->ri_startup_error) ? LL_WARN : LL_NOTIFY),
+                "thread_halt_and_destroy(): %s", strerror(-halt_rc));
+
+        if (halt_rc && !rc)
+            rc = halt_rc;
+
+        // Unserviced requests are dropped, the clients will retry them
+        struct raft_read_work *rrw;
+        while ((rrw = STAILQ_FIRST(&rwq->rsw_queue)))
+        {
+            STAILQ_REMOVE_HEAD(&rwq->rsw_queue, rrw_lentry);
+
+            if (rrw->rrw_csn)
+                ctl_svc_node_put(rrw->rrw_csn);
+
+            niova_free(rrw);
+        }
+        rwq->rsw_depth = 0;
+
+        pthread_cond_destroy(&rwq->rsw_cond);
+        pthread_mutex_destroy(&rwq->rsw_mutex);
+
+        niova_free(rrwt->rrwt_reply_buff);
+        rrwt->rrwt_reply_buff = NULL;
+    }
+
+    if (reply_queue_open)
+    {
+        pthread_cond_destroy(&reply_rwq->rsw_cond);
+        pthread_mutex_destroy(&reply_rwq->rsw_mutex);
     }
+
+    return rc;
 }
 
-static void
-raft_server_get_raft_header_to_apply(struct raft_instance *ri,
-                                     struct raft_last_applied *nai,
-                                     struct raft_entry_header *reh)
+/**
+ * raft_server_apply_prefetch_read - reads the header and data of the entry
+ *    assigned to 'raps'.  The data is copied into the slot's buffer rather
+ *    than held through a backend view since a view occupies one of the
+ *    ri_read_pins slots for as long as it is held.
+ */
+static int
+raft_server_apply_prefetch_read(struct raft_instance *ri,
+                                struct raft_apply_prefetch_slot *raps)
 {
-    NIOVA_ASSERT(ri && nai && reh);
-    raft_server_next_apply_idx(ri, nai);
+    NIOVA_ASSERT(ri && raps && raps->raps_idx >= 0);
 
-    int rc = raft_server_entry_header_read_by_store(ri, reh, nai->rla_idx);
-    DBG_RAFT_INSTANCE_FATAL_IF((rc), ri,
-                               "raft_server_entry_header_read_by_store(): %s",
-                               strerror(-rc));
+    struct raft_entry_header *reh = &raps->raps_reh;
+
+    int rc = raft_server_entry_header_read(ri, reh, raps->raps_idx);
+    if (rc || reh->reh_leader_change_marker || !reh->reh_data_size)
+        return rc;
+
+    if (raps->raps_buf_size < reh->reh_data_size)
+    {
+        if (raps->raps_buf)
+            niova_free(raps->raps_buf);
+
+        raps->raps_buf_size = 0;
+        raps->raps_buf = niova_malloc_can_fail(reh->reh_data_size);
+        if (!raps->raps_buf)
+            return -ENOMEM;
 
-    /* Sanity checks in case of recovery after partial apply failure the maximum
-     * of sub idx should be equal to the number of entries - 1
-     */
-    if (ri->ri_last_applied.rla_sub_idx != ri->ri_last_applied.rla_sub_idx_max)
-        NIOVA_ASSERT(reh->reh_num_entries ==
-                     ri->ri_last_applied.rla_sub_idx_max + 1);
+        raps->raps_buf_size = reh->reh_data_size;
+    }
 
-    // Update max entries and crc in the next apply idx
-    nai->rla_sub_idx_max = reh->reh_num_entries - 1;
-    nai->rla_cumulative_crc = ri->ri_last_applied.rla_cumulative_crc ^ reh->reh_crc;
+    return raft_server_entry_read(ri, raps->raps_idx, reh, raps->raps_buf,
+                                  reh->reh_data_size, NULL);
 }
 
-static void
-raft_server_init_send_reply(struct raft_instance *ri,
-                            struct raft_net_client_request_handle rncr)
+/**
+ * raft_server_apply_prefetch_thread - reads committed entries ahead of the
+ *    state machine apply.  Only entries in (last-applied, commit-idx] are
+ *    read and these may be neither truncated nor compacted.
+ */
+static raft_server_apply_prefetch_thread_t
+raft_server_apply_prefetch_thread(void *arg)
 {
-    NIOVA_ASSERT(ri);
-    /* Perform basic initialization on the reply buffer if the SM has provided
-     * the necessary info for completing the reply.  The SM would have called
-     * raft_net_client_request_handle_set_reply_info() if the necessary info was
-     * provided.  Note that the SM may not check for leader status, so the reply
-     * info may be provided even when this node is a follower.  Therefore, udp
-     * init should be bypassed if this node is not the leader.
-     */
-    if (raft_instance_is_leader(ri) &&
-        raft_net_client_request_handle_has_reply_info(&rncr) &&
-        uuid_compare(rncr.rncr_client_uuid,
-                     ri->ri_csn_this_peer->csn_uuid))
+    struct thread_ctl *tc = arg;
+    struct raft_instance *ri = (struct raft_instance *)thread_ctl_get_arg(tc);
+
+    NIOVA_ASSERT(ri && ri->ri_apply_prefetch.rap_depth);
+
+    struct raft_apply_prefetch *rap = &ri->ri_apply_prefetch;
+
+    THREAD_LOOP_WITH_CTL(tc)
     {
-        /* rncr and rcrm_data_size gets populated in ri_server_sm_request_cb().
-         * raft_server_client_reply_init() memset's rncr_reply which will
-         * overwrite the rcrm_data_size as well. So store the rcrm_data_size
-         * value in temporary variable first and restore it again.
-         */
-        struct raft_client_rpc_msg *reply = rncr.rncr_reply.rncr_reply_ptr;
-        uint32_t orig_rcrm_data_size = reply->rcrm_data_size;
+        struct raft_apply_prefetch_slot *raps = NULL;
 
-        raft_server_client_reply_init(ri, &rncr,
-                                      RAFT_CLIENT_RPC_MSG_TYPE_REPLY);
+        niova_mutex_lock(&rap->rap_mutex);
 
-        reply->rcrm_data_size = orig_rcrm_data_size;
+        const raft_entry_idx_t idx = rap->rap_next_idx;
 
-        raft_server_reply_to_client(ri, &rncr, NULL);
-    }
-}
+        if (idx >= 0 && idx <= rap->rap_limit_idx)
+        {
+            raps = &rap->rap_slots[idx % rap->rap_depth];
 
-static raft_server_epoll_sm_apply_bool_t
-raft_server_state_machine_apply(struct raft_instance *ri)
-{
-    NIOVA_ASSERT(ri);
+            // The slot is still held by the apply for (idx - rap_depth)
+            if (raps->raps_state != RAFT_APPLY_PREFETCH_SLOT_EMPTY)
+            {
+                raps = NULL;
+            }
+            else
+            {
+                raps->raps_state = RAFT_APPLY_PREFETCH_SLOT_PENDING;
+                raps->raps_idx = idx;
+                rap->rap_next_idx++;
+            }
+        }
 
-    DBG_RAFT_INSTANCE(LL_NOTIFY, ri, "");
+        // The timed wait bounds the thread's response to a halt request
+        if (!raps)
+        {
+            struct timespec ts;
+            raft_server_timedwait_deadline(&ts,
+                                           RAFT_SERVER_APPLY_PREFETCH_WAIT_US);
+            pthread_cond_timedwait(&rap->rap_cond, &rap->rap_mutex, &ts);
+        }
 
-    if (!raft_server_needs_apply(ri))
-        return;
+        niova_mutex_unlock(&rap->rap_mutex);
 
-    if (FAULT_INJECT(raft_server_bypass_sm_apply))
-        return;
+        DBG_THREAD_CTL(LL_TRACE, tc, "here");
+        if (!raps)
+            continue;
 
-    // Read the raft entry header for the next apply index
-    struct raft_last_applied nai = {0};
-    struct raft_entry_header reh = {0};
-    raft_server_get_raft_header_to_apply(ri, &nai, &reh);
+        int rc = raft_server_apply_prefetch_read(ri, raps);
 
-    /* If its the leader marker only update the last_applied index and return,
-     * persisting the last applied index will be done later along with apply
-     * from the application.
-     */
-    if (reh.reh_leader_change_marker || !reh.reh_data_size)
-    {
-        raft_server_set_last_applied(ri, &nai);
-        raft_server_sm_apply_opt(ri, NULL);
+        niova_mutex_lock(&rap->rap_mutex);
 
-        if (raft_server_needs_apply(ri))
-            RAFT_NET_EVP_NOTIFY_NO_FAIL(ri, RAFT_EVP_SM_APPLY);
+        raps->raps_rc = rc;
+        raps->raps_state = RAFT_APPLY_PREFETCH_SLOT_READY;
+        pthread_cond_broadcast(&rap->rap_cond);
 
-        return;
+        niova_mutex_unlock(&rap->rap_mutex);
+
+        DBG_RAFT_ENTRY((rc ? LL_WARN : LL_DEBUG), &raps->raps_reh,
+                       "prefetch: %s", strerror(-rc));
     }
 
-    // Allocate the buffer
-    struct buffer_item *sink_bi;
-    sink_bi = buffer_set_allocate_item(&ri->ri_buf_set[RAFT_BUF_SET_APPLY]);
-    NIOVA_ASSERT(sink_bi);
-    char *sink_buf = (char *)sink_bi->bi_iov.iov_base;
+    return (void *)0;
+}
 
-    // Read the raft entry data
-    int rc = raft_server_entry_read(ri, nai.rla_idx, sink_buf,
-                                    reh.reh_data_size, NULL);
+/**
+ * raft_server_apply_prefetch_start - starts the apply prefetch thread when
+ *    ri_sm_apply_prefetch_depth is non-zero.  rap_depth is only set once the
+ *    thread is running so that it may be used by the join function.
+ */
+static int
+raft_server_apply_prefetch_start(struct raft_instance *ri)
+{
+    NIOVA_ASSERT(ri && raft_instance_is_booting(ri));
 
-    DBG_RAFT_INSTANCE_FATAL_IF((rc), ri, "raft_server_entry_read(): %s",
-                                strerror(-rc));
+    struct raft_apply_prefetch *rap = &ri->ri_apply_prefetch;
 
-    // Allocate reply buffer
-    struct buffer_item *reply_bi;
-    const size_t reply_buf_sz = RAFT_BS_APPLY_SZ;
+    const size_t depth = MIN(ri->ri_sm_apply_prefetch_depth,
+                             RAFT_SM_APPLY_PREFETCH_MAX);
 
-    reply_bi = buffer_set_allocate_item(&ri->ri_buf_set[RAFT_BUF_SET_APPLY]);
-    NIOVA_ASSERT(reply_bi);
+    memset(rap, 0, sizeof(*rap));
 
-    char *reply_buf = (char *)reply_bi->bi_iov.iov_base;
+    if (!depth)
+        return 0;
 
-    // Iterate over the entries apply and reply if needed
-    bool failed = false;
-    uint32_t offset = 0;
+    FATAL_IF((pthread_mutex_init(&rap->rap_mutex, NULL)),
+             "pthread_mutex_init(): %s", strerror(errno));
 
-    for (uint32_t i = 0; i < reh.reh_num_entries;
-         offset += reh.reh_entry_sz[i], i++)
-    {
-        // Move the offset to next entry
-        if(i < nai.rla_sub_idx)
-            continue;
+    FATAL_IF((pthread_cond_init(&rap->rap_cond, NULL)),
+             "pthread_cond_init(): %s", strerror(errno));
 
-        struct raft_net_client_request_handle rncr;
-        raft_server_net_client_request_init_sm_apply(ri, &rncr,
-                                                    sink_buf + offset,
-                                                    reh.reh_entry_sz[i],
-                                                    reply_buf,
-                                                    reply_buf_sz);
-        raft_net_sm_write_supplement_enable_kv_crc(
-            &rncr.rncr_sm_write_supp, nai.rla_kv_cumulative_crc);
-        rncr.rncr_apply_handler_version = reh.reh_apply_handler_version;
+    rap->rap_next_idx = RAFT_ENTRY_IDX_ANY;
+    rap->rap_limit_idx = RAFT_ENTRY_IDX_ANY;
 
-        rc = ri->ri_server_sm_request_cb(&rncr);
-        if (rc)
-            failed = true;
+    for (size_t i = 0; i < RAFT_SM_APPLY_PREFETCH_MAX; i++)
+        rap->rap_slots[i].raps_idx = RAFT_ENTRY_IDX_ANY;
 
-        // Increment the sub applied idx and persist it
-        nai.rla_kv_cumulative_crc =
-            raft_net_sm_write_supplement_get_kv_crc(&rncr.rncr_sm_write_supp);
-        raft_server_set_last_applied(ri, &nai);
-        raft_server_sm_apply_opt(ri, &rncr.rncr_sm_write_supp);
-        raft_net_sm_write_supplement_destroy(&rncr.rncr_sm_write_supp);
+    rap->rap_depth = depth;
 
-        if (!rc)
-            raft_server_init_send_reply(ri, rncr);
+    int rc = thread_create_watched(raft_server_apply_prefetch_thread,
+                                   &ri->ri_apply_prefetch_thread_ctl,
+                                   "apply_prefetch", (void *)ri, NULL);
+    if (rc)
+    {
+        rap->rap_depth = 0;
+        pthread_cond_destroy(&rap->rap_cond);
+        pthread_mutex_destroy(&rap->rap_mutex);
 
-        if (FAULT_INJECT(raft_server_fail_partial_apply))
-            SIMPLE_LOG_MSG(LL_FATAL, "Failing after apply at index:%ld sub:%d",
-                           nai.rla_idx, nai.rla_sub_idx - 1);
+        return rc;
     }
 
-    NIOVA_ASSERT(ri->ri_last_applied.rla_sub_idx ==
-                 ri->ri_last_applied.rla_sub_idx_max);
+    thread_ctl_run(&ri->ri_apply_prefetch_thread_ctl);
 
-    // Update the commit latency metric
-    if (!failed && raft_instance_is_leader(ri))
-    {
-        if (reh.reh_term == ri->ri_log_hdr.rlh_term)
-        {
-            struct timespec ts;
-            niova_realtime_coarse_clock(&ts);
+    SIMPLE_LOG_MSG(LL_NOTIFY, "apply prefetch started: depth=%zu", depth);
 
-            timespecsub(&ts, &reh.reh_store_time, &ts);
+    return 0;
+}
 
-            struct binary_hist *bh =
-                    raft_server_type_2_hist(
-                        ri, RAFT_INSTANCE_HIST_COMMIT_LAT_MSEC);
+static int
+raft_server_apply_prefetch_join(struct raft_instance *ri)
+{
+    NIOVA_ASSERT(ri && raft_instance_is_shutdown(ri));
 
-            if (timespec_2_msec(&ts) > 0)
-                binary_hist_incorporate_val(bh, timespec_2_msec(&ts));
-        }
-        binary_hist_incorporate_val(
-            raft_server_type_2_hist(ri, RAFT_INSTANCE_HIST_COALESCED_WR_CNT),
-            reh.reh_num_entries);
+    struct raft_apply_prefetch *rap = &ri->ri_apply_prefetch;
+    if (!rap->rap_depth)
+        return 0;
+
+    int rc = thread_halt_and_destroy(&ri->ri_apply_prefetch_thread_ctl);
+
+    LOG_MSG(((rc && !ri->ri_startup_error) ? LL_WARN : LL_NOTIFY),
+            "thread_halt_and_destroy(): %s", strerror(-rc));
+
+    rap->rap_depth = 0;
+
+    for (size_t i = 0; i < RAFT_SM_APPLY_PREFETCH_MAX; i++)
+    {
+        struct raft_apply_prefetch_slot *raps = &rap->rap_slots[i];
+
+        if (raps->raps_buf)
+            niova_free(raps->raps_buf);
+
+        raps->raps_buf = NULL;
+        raps->raps_buf_size = 0;
+        raps->raps_state = RAFT_APPLY_PREFETCH_SLOT_EMPTY;
     }
 
+    pthread_cond_destroy(&rap->rap_cond);
+    pthread_mutex_destroy(&rap->rap_mutex);
 
-    DBG_RAFT_INSTANCE(LL_NOTIFY, ri, "ri_last_applied was incremented");
-    DBG_RAFT_ENTRY(LL_NOTIFY, &reh, "");
+    return rc;
+}
 
-    if (raft_server_needs_apply(ri))
-        RAFT_NET_EVP_NOTIFY_NO_FAIL(ri, RAFT_EVP_SM_APPLY);
+/**
+ * raft_server_bulk_sender_buf_get - returns the sender's scratch buffer,
+ *    which holds compressed AE requests and chkpt xfer replies.  The buffer
+ *    is allocated on first use.
+ */
+static char *
+raft_server_bulk_sender_buf_get(struct raft_bulk_sender *rbsr,
+                                const struct raft_instance *ri)
+{
+    if (!rbsr->rbsr_buf)
+    {
+        const size_t size = sizeof(struct raft_rpc_msg) +
+            raft_net_max_rpc_size(ri->ri_store_type);
 
-    // Release buffers
-    buffer_set_release_item(reply_bi);
-    buffer_set_release_item(sink_bi);
+        rbsr->rbsr_buf = niova_malloc_can_fail(size);
+        if (!rbsr->rbsr_buf)
+            return NULL;
+
+        rbsr->rbsr_buf_size = size;
+    }
+
+    return rbsr->rbsr_buf;
 }
 
-static raft_server_epoll_remote_sender_t
-raft_server_follower_send_sync_idx(struct raft_instance *ri)
+/**
+ * raft_server_peer_sendq_compress - points 'iov' at a copy of the queued AE
+ *    request with its entries compressed.  The request is sent as-is if it
+ *    does not compress or the buffer cannot be allocated.
+ */
+static void
+raft_server_peer_sendq_compress(struct raft_bulk_sender *rbsr,
+                                const struct raft_instance *ri,
+                                const struct raft_bulk_send *rbs,
+                                struct iovec *iov)
 {
-    if (!ri || !raft_instance_is_follower(ri) ||
-        raft_server_does_synchronous_writes(ri))
+    char *buf = raft_server_bulk_sender_buf_get(rbsr, ri);
+    if (!buf)
         return;
 
-    // Extra check to ensure we don't send to ourselves
-    struct ctl_svc_node *leader = ri->ri_csn_leader;
-    if (leader == ri->ri_csn_this_peer)
+    ssize_t rc =
+        raft_net_ae_entries_compress((const struct raft_rpc_msg *)rbs->rbs_buf,
+                                     rbs->rbs_compress_type, buf,
+                                     rbsr->rbsr_buf_size);
+    if (rc < 0)
+    {
+        DBG_CTL_SVC_NODE((rc == -E2BIG ? LL_DEBUG : LL_NOTIFY), rbs->rbs_csn,
+                         "raft_net_ae_entries_compress(): %s",
+                         strerror(-rc));
         return;
+    }
 
-    struct raft_entry_header reh = {0};
-    raft_instance_get_newest_header(ri, &reh, RI_NEHDR_SYNC);
+    iov->iov_base = buf;
+    iov->iov_len = rc;
+}
 
-    struct raft_rpc_msg rrm = {
-        .rrm_type = RAFT_RPC_MSG_TYPE_SYNC_IDX_UPDATE,
-        .rrm_version = 0,
-        .rrm_sync_index_update.rsium_synced_log_index = reh.reh_index,
-        .rrm_sync_index_update.rsium_term = reh.reh_term,
-    };
+/**
+ * raft_server_peer_sendq_chkpt_xfer - serves the queued chkpt xfer request
+ *    and points 'iov' at the reply.  The backend read runs here, in the
+ *    sender thread, so that the file IO and CRC do not stall the main raft
+ *    thread.  'err_reply' is used if the scratch buffer cannot be allocated.
+ */
+static void
+raft_server_peer_sendq_chkpt_xfer(struct raft_bulk_sender *rbsr,
+                                  struct raft_instance *ri,
+                                  const struct raft_bulk_send *rbs,
+                                  struct raft_rpc_msg *err_reply,
+                                  struct iovec *iov)
+{
+    const struct raft_rpc_msg *rrm = (const struct raft_rpc_msg *)rbs->rbs_buf;
 
-    raft_server_set_uuids_in_rpc_msg(ri, &rrm);
+    struct raft_rpc_msg *reply =
+        (struct raft_rpc_msg *)raft_server_bulk_sender_buf_get(rbsr, ri);
 
-    int rc = raft_server_send_msg(ri, RAFT_UDP_LISTEN_SERVER, leader, &rrm);
+    if (reply)
+    {
+        raft_server_chkpt_xfer_reply_init(ri, rrm, reply);
+        raft_server_chkpt_xfer_reply_read(ri, rrm, reply, rbsr->rbsr_buf_size);
+    }
+    else
+    {
+        reply = err_reply;
+        raft_server_chkpt_xfer_reply_init(ri, rrm, reply);
+        raft_server_chkpt_xfer_reply_set_error(reply, -ENOMEM);
+    }
 
-    DBG_RAFT_INSTANCE((rc ? LL_NOTIFY : LL_DEBUG), ri,
-                      "raft_server_send_msg(): %s", strerror(-rc));
+    DBG_RAFT_MSG((reply->rrm_chkpt_xfer_reply.rcxrpm_err ?
+                  LL_NOTIFY : LL_DEBUG), reply, "");
+
+    iov->iov_base = reply;
+    iov->iov_len = sizeof(struct raft_rpc_msg) +
+        reply->rrm_chkpt_xfer_reply.rcxrpm_data_sz;
 }
 
-static raft_server_epoll_remote_sender_t
-raft_server_remote_send_evp_cb(const struct epoll_handle *eph, uint32_t events)
+/**
+ * raft_server_peer_sendq_next - removes the next item to be sent from the
+ *    follower's send queue.  Msgs go ahead of the queued chkpt xfer requests,
+ *    whose chunks are read by the sender thread, so that a chkpt transfer
+ *    only runs while no AE request is waiting.  The order of the msgs is
+ *    kept.  The caller holds rpsq_mutex.
+ */
+static struct raft_bulk_send *
+raft_server_peer_sendq_next(struct raft_peer_send_queue *rpsq)
 {
-    NIOVA_ASSERT(eph);
-    (void)events;
-
-    FUNC_ENTRY(LL_DEBUG);
-
-    struct raft_instance *ri = eph->eph_arg;
-    struct ev_pipe *evp = raft_net_evp_get(ri, RAFT_EVP_REMOTE_SEND);
+    struct raft_bulk_send *rbs;
 
-    NIOVA_ASSERT(eph && eph->eph_fd == evp_read_fd_get(evp));
+    STAILQ_FOREACH(rbs, &rpsq->rpsq_queue, rbs_lentry)
+        if (rbs->rbs_type == RAFT_BULK_SEND_MSG)
+            break;
 
-    EV_PIPE_RESET(evp); // reset prior to dequeuing work
+    if (!rbs)
+        rbs = STAILQ_FIRST(&rpsq->rpsq_queue);
 
-    if (raft_instance_is_leader(ri))
-        raft_server_append_entry_sender(ri, false);
+    if (rbs)
+        STAILQ_REMOVE(&rpsq->rpsq_queue, rbs, raft_bulk_send, rbs_lentry);
 
-    else if (raft_instance_is_follower(ri))
-        raft_server_follower_send_sync_idx(ri);
+    return rbs;
 }
 
-static raft_server_epoll_sm_apply_t
-raft_server_sm_apply_evp_cb(const struct epoll_handle *eph, uint32_t events)
+/**
+ * raft_server_peer_sendq_send_one - sends the next msg on the follower's
+ *    send queue, if any, over its TCP connection.  At most one chkpt chunk is
+ *    read and sent per call.
+ */
+static void
+raft_server_peer_sendq_send_one(struct raft_bulk_sender *rbsr,
+                                struct raft_peer_send_queue *rpsq)
 {
-    NIOVA_ASSERT(eph);
-    (void)events;
+    struct raft_instance *ri = rpsq->rpsq_ri;
+    struct raft_bulk_lane *rbl = &ri->ri_bulk_lane;
+    struct raft_net_lane_stats *rnls = &ri->ri_lane_stats[RAFT_NET_LANE_BULK];
 
-    FUNC_ENTRY(LL_DEBUG);
+    niova_mutex_lock(&rpsq->rpsq_mutex);
 
-    struct raft_instance *ri = eph->eph_arg;
-    struct ev_pipe *evp = raft_net_evp_get(ri, RAFT_EVP_SM_APPLY);
+    struct raft_bulk_send *rbs = raft_server_peer_sendq_next(rpsq);
 
-    NIOVA_ASSERT(eph && eph->eph_fd == evp_read_fd_get(evp));
+    niova_mutex_unlock(&rpsq->rpsq_mutex);
 
-    EV_PIPE_RESET(evp);
+    if (!rbs)
+        return;
 
-    niova_mutex_lock(&ri->ri_write_mutex);
+    niova_mutex_lock(&rbsr->rbsr_mutex);
+    rbsr->rbsr_nqueued--;
+    niova_mutex_unlock(&rbsr->rbsr_mutex);
 
-    raft_server_state_machine_apply(ri);
+    struct iovec iov = {
+        .iov_base = rbs->rbs_buf,
+        .iov_len = rbs->rbs_len,
+    };
 
-    niova_mutex_unlock(&ri->ri_write_mutex);
-}
+    // Checkpoint transfers also use the queue
+    const bool ae_request = rbs->rbs_type == RAFT_BULK_SEND_MSG &&
+        ((const struct raft_rpc_msg *)rbs->rbs_buf)->rrm_type ==
+        RAFT_RPC_MSG_TYPE_APPEND_ENTRIES_REQUEST;
 
-static raft_server_epoll_t
-raft_server_commit_idx_adv_evp_cb(const struct epoll_handle *eph,
-                                  uint32_t events)
-{
-    NIOVA_ASSERT(eph);
-    FUNC_ENTRY(LL_DEBUG);
-    (void)events;
+    const size_t entries_sz = rbs->rbs_len - sizeof(struct raft_rpc_msg);
+
+    struct raft_rpc_msg err_reply;
+
+    if (rbs->rbs_type == RAFT_BULK_SEND_CHKPT_XFER)
+        raft_server_peer_sendq_chkpt_xfer(rbsr, ri, rbs, &err_reply, &iov);
+
+    else if (rbs->rbs_compress_type != RAFT_AE_COMPRESS_NONE)
+        raft_server_peer_sendq_compress(rbsr, ri, rbs, &iov);
+
+    int rc = raft_net_send_bulk_msg(ri, rbs->rbs_csn, &iov, 1);
+
+    DBG_CTL_SVC_NODE((rc ? LL_NOTIFY : LL_DEBUG), rbs->rbs_csn,
+                     "raft_net_send_bulk_msg(): len=%zu %s",
+                     rbs->rbs_len, strerror(-rc));
+
+    ctl_svc_node_put(rbs->rbs_csn);
+
+    /* The msg occupies its queue slot until it has been sent so that the AE
+     * sender sees a stalled follower's queue as full and so that later AE
+     * requests to the follower are queued behind it.
+     */
+    niova_mutex_lock(&rpsq->rpsq_mutex);
+
+    rpsq->rpsq_depth--;
+    if (rbs->rbs_type == RAFT_BULK_SEND_CHKPT_XFER)
+        rpsq->rpsq_nchkpt_xfer--;
+
+    if (!rc && ae_request)
+    {
+        rpsq->rpsq_entry_bytes += entries_sz;
+        rpsq->rpsq_entry_wire_bytes +=
+            iov.iov_len - sizeof(struct raft_rpc_msg);
+    }
+
+    niova_mutex_unlock(&rpsq->rpsq_mutex);
 
-    struct raft_instance *ri = eph->eph_arg;
-    struct ev_pipe *evp = raft_net_evp_get(ri, RAFT_EVP_ASYNC_COMMIT_IDX_ADV);
+    // Latency includes the time spent in the queue
+    niova_mutex_lock(&rbl->rbl_mutex);
 
-    NIOVA_ASSERT(eph->eph_fd == evp_read_fd_get(evp));
+    rnls->rnls_depth--;
+    raft_server_lane_stats_update(ri, RAFT_NET_LANE_BULK, rc,
+                                  &rbs->rbs_enqueue_time);
 
-    EV_PIPE_RESET(evp);
+    niova_mutex_unlock(&rbl->rbl_mutex);
 
-    if (raft_instance_is_leader(ri))
-        raft_server_leader_try_advance_commit_idx(ri);
+    niova_free(rbs);
 }
 
-static epoll_mgr_cb_t
-raft_server_evp_2_cb_fn(enum raft_event_pipe_types evps)
+/**
+ * raft_server_bulk_sender_thread - sends the msgs placed onto its follower's
+ *    queue by raft_server_peer_sendq_enqueue().
+ */
+static raft_server_bulk_lane_thread_t
+raft_server_bulk_sender_thread(void *arg)
 {
-    switch (evps)
-    {
-    case RAFT_EVP_REMOTE_SEND:
-        return raft_server_remote_send_evp_cb;
-    case RAFT_EVP_SM_APPLY:
-        return raft_server_sm_apply_evp_cb;
-    case RAFT_EVP_ASYNC_COMMIT_IDX_ADV:
-        return raft_server_commit_idx_adv_evp_cb;
-    default:
-        break;
-    }
-    return NULL;
-}
+    struct thread_ctl *tc = arg;
+    struct raft_bulk_sender *rbsr =
+        (struct raft_bulk_sender *)thread_ctl_get_arg(tc);
 
-static int
-raft_server_evp_setup(struct raft_instance *ri)
-{
-    if (!ri || raft_instance_is_client(ri))
-        return -EINVAL;
+    NIOVA_ASSERT(rbsr && rbsr->rbsr_queue);
 
-    for (enum raft_event_pipe_types i = RAFT_EVP_SERVER__START;
-         i <= RAFT_EVP_SERVER__END; i++)
+    THREAD_LOOP_WITH_CTL(tc)
     {
-        int rc = raft_net_evp_add(ri, raft_server_evp_2_cb_fn(i), i);
-        if (rc)
+        niova_mutex_lock(&rbsr->rbsr_mutex);
+
+        // The timed wait bounds the thread's response to a halt request
+        if (!rbsr->rbsr_nqueued)
         {
-            SIMPLE_LOG_MSG(LL_ERROR, "raft_net_evp_add(%d): %s",
-                           i, strerror(-rc));
-            return rc;
+            struct timespec ts;
+            raft_server_timedwait_deadline(&ts, RAFT_SERVER_BULK_LANE_WAIT_US);
+            pthread_cond_timedwait(&rbsr->rbsr_cond, &rbsr->rbsr_mutex, &ts);
         }
-    }
 
-    return 0;
-}
+        const bool pending = rbsr->rbsr_nqueued ? true : false;
 
-static int
-raft_server_evp_cleanup(struct raft_instance *ri)
-{
-    if (!ri || raft_instance_is_client(ri))
-        return -EINVAL;
+        niova_mutex_unlock(&rbsr->rbsr_mutex);
 
-    int rc = 0;
+        DBG_THREAD_CTL(LL_TRACE, tc, "here");
+        if (!pending)
+            continue;
 
-    for (enum raft_event_pipe_types i = RAFT_EVP_SERVER__START;
-         i <= RAFT_EVP_SERVER__END; i++)
-    {
-        int tmp_rc = raft_net_evp_remove(ri, i);
-        if (tmp_rc && !rc)
-            rc = tmp_rc;
+        raft_server_peer_sendq_send_one(rbsr, rbsr->rbsr_queue);
     }
 
-    return rc;
+    return (void *)0;
 }
 
-static int
-raft_server_instance_startup(struct raft_instance *ri);
-
-static int
-raft_server_instance_shutdown(struct raft_instance *ri);
-
 static void
-raft_server_set_max_scan_entries(struct raft_instance *ri,
-                                 ssize_t max_scan_entries)
+raft_server_peer_sendq_destroy(struct raft_peer_send_queue *rpsq)
 {
-    NIOVA_ASSERT(ri);
+    // Drop the msgs which were not sent, raft resends as needed
+    struct raft_bulk_send *rbs;
+    while ((rbs = STAILQ_FIRST(&rpsq->rpsq_queue)))
+    {
+        STAILQ_REMOVE_HEAD(&rpsq->rpsq_queue, rbs_lentry);
 
-    if (max_scan_entries < 0)
-        ri->ri_max_scan_entries = (ssize_t)-1;
+        ctl_svc_node_put(rbs->rbs_csn);
+        niova_free(rbs);
+    }
 
-    else
-        ri->ri_max_scan_entries =
-            MAX(max_scan_entries,
-                RAFT_INSTANCE_PERSISTENT_APP_MIN_SCAN_ENTRIES);
+    rpsq->rpsq_depth = 0;
+    rpsq->rpsq_nchkpt_xfer = 0;
+    rpsq->rpsq_running = false;
+    rpsq->rpsq_sender = NULL;
 
-    SIMPLE_LOG_MSG(LL_WARN, "max_scan_entries=%zd", ri->ri_max_scan_entries);
+    pthread_mutex_destroy(&rpsq->rpsq_mutex);
 }
 
 static void
-raft_server_set_log_reap_factor(struct raft_instance *ri,
-                                size_t log_reap_factor)
+raft_server_peer_sendq_init(struct raft_instance *ri,
+                            struct raft_peer_send_queue *rpsq,
+                            const raft_peer_t peer,
+                            struct raft_bulk_sender *rbsr)
 {
-    NIOVA_ASSERT(ri);
+    FATAL_IF((pthread_mutex_init(&rpsq->rpsq_mutex, NULL)),
+             "pthread_mutex_init(): %s", strerror(errno));
 
-    ri->ri_log_reap_factor = MIN(log_reap_factor,
-                                 RAFT_INSTANCE_PERSISTENT_APP_REAP_FACTOR_MAX);
+    STAILQ_INIT(&rpsq->rpsq_queue);
+    rpsq->rpsq_ri = ri;
+    rpsq->rpsq_peer = peer;
+    rpsq->rpsq_sender = rbsr;
 
-    SIMPLE_LOG_MSG(LL_WARN, "log_reap_factor=%zu", ri->ri_log_reap_factor);
+    NIOVA_ASSERT(!rbsr->rbsr_queue);
+    rbsr->rbsr_queue = rpsq;
 }
 
 static void
-raft_server_set_num_checkpoints(struct raft_instance *ri, size_t num_ckpts)
+raft_server_bulk_sender_init(struct raft_bulk_sender *rbsr)
 {
-    NIOVA_ASSERT(ri);
+    FATAL_IF((pthread_mutex_init(&rbsr->rbsr_mutex, NULL)),
+             "pthread_mutex_init(): %s", strerror(errno));
 
-    num_ckpts = MAX(RAFT_INSTANCE_PERSISTENT_APP_CHKPT_MIN, num_ckpts);
+    FATAL_IF((pthread_cond_init(&rbsr->rbsr_cond, NULL)),
+             "pthread_cond_init(): %s", strerror(errno));
+}
 
-    ri->ri_num_checkpoints = MIN(num_ckpts,
-                                 RAFT_INSTANCE_PERSISTENT_APP_CHKPT_MAX);
+static void
+raft_server_bulk_sender_destroy(struct raft_bulk_sender *rbsr)
+{
+    niova_free(rbsr->rbsr_buf);
+    rbsr->rbsr_buf = NULL;
+    rbsr->rbsr_buf_size = 0;
+    rbsr->rbsr_queue = NULL;
+    rbsr->rbsr_nqueued = 0;
 
-    SIMPLE_LOG_MSG(LL_WARN, "num_checkpoints=%zu", ri->ri_num_checkpoints);
+    pthread_cond_destroy(&rbsr->rbsr_cond);
+    pthread_mutex_destroy(&rbsr->rbsr_mutex);
 }
 
-static void
-raft_server_instance_init_rocksdb_persistent_app(struct raft_instance *ri)
+/**
+ * raft_server_bulk_lane_start - creates a send queue and a sender thread for
+ *    each follower.  A queue is only used once rpsq_running is set, until
+ *    then bulk msgs to the follower are sent inline.
+ */
+static int
+raft_server_bulk_lane_start(struct raft_instance *ri)
 {
     NIOVA_ASSERT(ri && raft_instance_is_booting(ri));
 
-    if (ri->ri_store_type == RAFT_INSTANCE_STORE_ROCKSDB_PERSISTENT_APP)
+    struct raft_bulk_lane *rbl = &ri->ri_bulk_lane;
+
+    memset(rbl, 0, sizeof(*rbl));
+    memset(ri->ri_lane_stats, 0, sizeof(ri->ri_lane_stats));
+
+    FATAL_IF((pthread_mutex_init(&rbl->rbl_mutex, NULL)),
+             "pthread_mutex_init(): %s", strerror(errno));
+
+    rbl->rbl_running = true;
+
+    const raft_peer_t npeers = raft_num_members_validate_and_get(ri);
+
+    // The queues are attached before the sender threads are started
+    for (raft_peer_t i = 0; i < npeers; i++)
     {
-        if (!ri->ri_max_scan_entries)
-            raft_server_set_max_scan_entries(
-                ri, RAFT_INSTANCE_PERSISTENT_APP_SCAN_ENTRIES);
+        if (ri->ri_csn_raft_peers[i] == ri->ri_csn_this_peer)
+            continue;
 
-        if (!ri->ri_log_reap_factor)
-            raft_server_set_log_reap_factor(
-                ri, RAFT_INSTANCE_PERSISTENT_APP_REAP_FACTOR_DEFAULT);
+        struct raft_bulk_sender *rbsr =
+            &rbl->rbl_senders[rbl->rbl_nsenders++];
 
-        if (!ri->ri_num_checkpoints)
-            raft_server_set_num_checkpoints(
-                ri, RAFT_INSTANCE_PERSISTENT_APP_CHKPT_DEFAULT);
+        raft_server_bulk_sender_init(rbsr);
+        raft_server_peer_sendq_init(ri, &rbl->rbl_peer_sendq[i], i, rbsr);
     }
-}
 
-static void
-raft_server_instance_init_tunables(struct raft_instance *ri)
-{
-    NIOVA_ASSERT(ri && raft_instance_is_booting(ri));
+    for (size_t i = 0; i < rbl->rbl_nsenders; i++)
+    {
+        struct raft_bulk_sender *rbsr = &rbl->rbl_senders[i];
 
-    if (ri->ri_store_type == RAFT_INSTANCE_STORE_ROCKSDB_PERSISTENT_APP)
-        raft_server_instance_init_rocksdb_persistent_app(ri);
+        int rc = thread_create_watched(raft_server_bulk_sender_thread,
+                                       &rbsr->rbsr_thread_ctl, "bulk_sender",
+                                       (void *)rbsr, NULL);
+        if (rc)
+            return rc;
+
+        rbsr->rbsr_running = true;
+        thread_ctl_run(&rbsr->rbsr_thread_ctl);
+
+        rbsr->rbsr_queue->rpsq_running = true;
+    }
+
+    SIMPLE_LOG_MSG(LL_NOTIFY,
+                   "peer send queues started: depth=%zu senders=%zu",
+                   ri->ri_bulk_lane_depth, rbl->rbl_nsenders);
+
+    return 0;
 }
 
-static void
-raft_server_instance_restore_init_values(struct raft_instance *ri,
-                                         const struct raft_instance *save)
+static int
+raft_server_bulk_lane_join(struct raft_instance *ri)
 {
-    if (!ri || !save)
-        return;
+    NIOVA_ASSERT(ri && raft_instance_is_shutdown(ri));
 
-    // Restore the recovery handle if this instance was bulk-recovered
-    ri->ri_successful_recovery = save->ri_successful_recovery;
+    struct raft_bulk_lane *rbl = &ri->ri_bulk_lane;
+    if (!rbl->rbl_running)
+        return 0;
 
-    // ignore_timerfd may have been set at startup
-    ri->ri_ignore_timerfd = save->ri_ignore_timerfd;
+    int rc = 0;
 
-    // bulk recovery items
-    ri->ri_max_scan_entries = save->ri_max_scan_entries;
-    ri->ri_log_reap_factor = save->ri_log_reap_factor;
-    ri->ri_num_checkpoints = save->ri_num_checkpoints;
+    for (size_t i = 0; i < rbl->rbl_nsenders; i++)
+    {
+        struct raft_bulk_sender *rbsr = &rbl->rbl_senders[i];
+        if (!rbsr->rbsr_running)
+            continue;
 
-    ri->ri_election_timeout_max_ms = save->ri_election_timeout_max_ms;
-    ri->ri_heartbeat_freq_per_election_min =
-        save->ri_heartbeat_freq_per_election_min;
+        int halt_rc = thread_halt_and_destroy(&rbsr->rbsr_thread_ctl);
 
-    ri->ri_apply_handler_version = raft_net_get_apply_handler_version();
+        LOG_MSG(((halt_rc && !ri->ri_startup_error) ? LL_WARN : LL_NOTIFY),
+                "thread_halt_and_destroy(sender=%zu): %s", i,
+                strerror(-halt_rc));
+
+        if (!rc)
+            rc = halt_rc;
+
+        rbsr->rbsr_running = false;
+    }
+
+    for (raft_peer_t i = 0; i < CTL_SVC_MAX_RAFT_PEERS; i++)
+    {
+        struct raft_peer_send_queue *rpsq = &rbl->rbl_peer_sendq[i];
+        if (rpsq->rpsq_sender)
+            raft_server_peer_sendq_destroy(rpsq);
+    }
+
+    for (size_t i = 0; i < rbl->rbl_nsenders; i++)
+        raft_server_bulk_sender_destroy(&rbl->rbl_senders[i]);
+
+    rbl->rbl_nsenders = 0;
+    rbl->rbl_running = false;
+    ri->ri_lane_stats[RAFT_NET_LANE_BULK].rnls_depth = 0;
+
+    pthread_mutex_destroy(&rbl->rbl_mutex);
+
+    return rc;
 }
 
-static void
-raft_server_instance_init(struct raft_instance *ri,
-                          enum raft_instance_store_type type,
-                          const char *raft_uuid_str,
-                          const char *this_peer_uuid_str,
-                          raft_sm_request_handler_t sm_request_handler,
-                          raft_init_cb_t init_peer_handler,
-                          enum raft_instance_options opts, void *arg)
+/**
+ * raft_server_set_checkpoint_last_idx - helper function for setting the
+ *    raft instance checkpoint index.
+ * @ri: raft instance
+ * @chkpt_ret_idx:  the index value returned by rib_backend_checkpoint()
+ */
+static raft_server_chkpt_thread_ctx_t
+raft_server_set_checkpoint_last_idx(struct raft_instance *ri,
+                                    int64_t chkpt_ret_idx)
 {
-    NIOVA_ASSERT(ri && raft_instance_is_booting(ri));
+    FATAL_IF(!ri || chkpt_ret_idx < 0 ||
+             chkpt_ret_idx < niova_atomic_read(&ri->ri_checkpoint_last_idx),
+             "invalid checkpoint-idx=%ld (chkpt_last_idx=%lld)",
+             chkpt_ret_idx, ri->ri_checkpoint_last_idx);
 
-    /* Sanity check for the recovery to ensure that the lreg node had been
-     * uninstalled from the registry before reusing the object.
-     */
-    NIOVA_ASSERT(!lreg_node_is_installed(&ri->ri_lreg) &&
-                 !ri->ri_lreg_registered);
+    // Atomic here since this runs in a separate thread context.
+    niova_atomic_init(&ri->ri_checkpoint_last_idx, chkpt_ret_idx);
+}
 
-    const struct raft_instance ri_save = *ri;
+/**
+ * raft_server_host_group_get - returns the host's slot for 'ri', or NULL if
+ *    the group is not attached.  The caller holds rhw_mutex.
+ */
+static struct raft_host_group *
+raft_server_host_group_get(struct raft_host_workers *rhw,
+                           const struct raft_instance *ri)
+{
+    for (size_t i = 0; i < rhw->rhw_ngroups; i++)
+        if (rhw->rhw_groups[i].rhg_ri == ri)
+            return &rhw->rhw_groups[i];
 
-    // Wipe the instance and restore 'booting' state
-    memset(ri, 0, sizeof(*ri));
-    ri->ri_proc_state = RAFT_PROC_STATE_BOOTING;
+    return NULL;
+}
 
-    raft_server_instance_restore_init_values(ri, &ri_save);
+/**
+ * raft_server_host_chkpt_kick - the hosted analog of signaling the chkpt
+ *    thread, wakes the host's chkpt threads so that a requested checkpoint
+ *    is taken without waiting for the group's next pass.
+ */
+static int
+raft_server_host_chkpt_kick(struct raft_instance *ri)
+{
+    struct raft_host_workers *rhw = ri->ri_host_workers;
 
-    raft_instance_backend_type_specify(ri, type);
+    niova_mutex_lock(&rhw->rhw_mutex);
 
-    // Conditionally initialized values may have been by raft_net.c
-    if (!ri->ri_election_timeout_max_ms)
-        ri->ri_election_timeout_max_ms = RAFT_ELECTION_UPPER_TIME_MS;
+    struct raft_host_group *rhg = raft_server_host_group_get(rhw, ri);
+    if (rhg)
+        pthread_cond_signal(&rhw->rhw_chkpt_cond);
 
-    if (!ri->ri_heartbeat_freq_per_election_min)
-        ri->ri_heartbeat_freq_per_election_min =
-            RAFT_HEARTBEAT_FREQ_PER_ELECTION;
+    niova_mutex_unlock(&rhw->rhw_mutex);
 
-    ri->ri_check_quorum_timeout_factor = RAFT_ELECTION_CHECK_QUORUM_FACTOR;
-    ri->ri_raft_uuid_str = raft_uuid_str;
-    ri->ri_this_peer_uuid_str = this_peer_uuid_str;
-    ri->ri_server_sm_request_cb = sm_request_handler;
-    ri->ri_init_cb = init_peer_handler;
-    ri->ri_backend_init_arg = arg;
-    ri->ri_apply_handler_version = raft_net_get_apply_handler_version();
-    ri->ri_synchronous_writes =
-        opts & RAFT_INSTANCE_OPTIONS_SYNC_WRITES ? true : false;
-    ri->ri_coalesced_writes =
-        opts & RAFT_INSTANCE_OPTIONS_COALESCED_WRITES ? true : false;
+    return rhg ? 0 : -EINVAL;
+}
+
+static int
+raft_server_chkpt_prior_to_recovery(struct raft_instance *ri)
+{
+    if (!ri || !ri->ri_backend->rib_backend_checkpoint ||
+        (!ri->ri_host_workers &&
+         !thread_ctl_thread_is_running(&ri->ri_chkpt_thread_ctl)))
+        return -EINVAL;
+
+    if (!raftServerDoesChkptBeforeRecovery)
+    {
+        LOG_MSG(LL_WARN,
+                "bypassing checkpoint operation due to configuration");
+        return 0;
+    }
+    else if (raft_server_get_current_raft_entry_index(ri, RI_NEHDR_SYNC) < 0)
+    {
+        return 0;
+    }
+
+
+    raft_entry_idx_t last_idx = ri->ri_checkpoint_last_idx;
+
+    // Reset error
+    ri->ri_last_chkpt_err = 0;
+
+    // Schedule the checkpoint
+    ri->ri_user_requested_checkpoint = true;
 
-    ri->ri_auto_checkpoints_enabled =
-        opts & RAFT_INSTANCE_OPTIONS_AUTO_CHECKPOINT ? true : false;
+    int rc = ri->ri_host_workers ? raft_server_host_chkpt_kick(ri) :
+        thread_issue_sig_alarm_to_thread(ri->ri_chkpt_thread_ctl.tc_thread_id);
 
-    ri->ri_commit_idx = -1;
-    ri->ri_last_applied = (struct raft_last_applied) {
-        .rla_idx = -1,
-        .rla_sub_idx = 0,
-        .rla_sub_idx_max = 0,
-        .rla_synced_idx = -1
-    };
-    ri->ri_checkpoint_last_idx = -1;
-    ri->ri_pending_read_idx = -1;
-    niova_atomic_init(&ri->ri_lowest_idx, -1);
+    if (rc)
+        return rc;
 
-    raft_server_instance_init_tunables(ri);
+    bool done = false;
+    int sleep_secs = raftServerChkptTimeoutSec;
+    while (sleep_secs--)
+    {
+        if ((niova_atomic_read(&ri->ri_checkpoint_last_idx) > last_idx) ||
+            ri->ri_last_chkpt_err)
+        {
+            done = true;
+            break;
+        }
+        sleep(1); // Wait for the recovery thread to finish up
+    }
 
-    ri->ri_startup_pre_net_bind_cb = raft_server_instance_startup;
-    ri->ri_shutdown_cb = raft_server_instance_shutdown;
+    if (!done && !ri->ri_last_chkpt_err) // Set ETIMEDOUT here
+        ri->ri_last_chkpt_err = -ETIMEDOUT;
 
-    /* Assign the timer_fd and udp_recv callbacks.
-     */
-    raft_net_instance_apply_callbacks(ri, raft_server_timerfd_cb,
-                                      raft_server_client_recv_handler,
-                                      raft_server_peer_recv_handler);
+    rc = ri->ri_last_chkpt_err;
+    DBG_RAFT_INSTANCE(LL_WARN, ri, "ri->ri_last_chkpt_err=%d", rc);
+
+    return ((rc == -ENODATA) ? 0 :
+            (rc == -EALREADY) ? 0 : rc);
 }
 
-static util_thread_ctx_reg_t
-raft_server_instance_hist_lreg_multi_facet_handler(
-    enum lreg_node_cb_ops op,
-    struct raft_instance_hist_stats *rihs,
-    struct lreg_value *lv)
+/**
+ * raft_server_chkpt_thread_needed - the checkpoint thread also drives log
+ *    reaping so it runs for backends which can reap but not checkpoint.
+ */
+static bool
+raft_server_chkpt_thread_needed(const struct raft_instance *ri)
 {
-    if (!lv || !rihs || op != LREG_NODE_CB_OP_READ_VAL)
-        return;
+    return (ri->ri_backend->rib_backend_checkpoint ||
+            ri->ri_backend->rib_log_reap) ? true : false;
+}
 
-    int hsz = binary_hist_size(&rihs->rihs_bh);
-    if (hsz < 0 || lv->lrv_value_idx_in >= (unsigned int)hsz)
+static raft_server_chkpt_thread_ctx_t
+raft_server_take_chkpt(struct raft_instance *ri)
+{
+    if (raft_server_instance_chkpt_compact_max_idx(ri) < 0)
+    {
+        ri->ri_last_chkpt_err = -ENODATA;
         return;
+    }
 
-    snprintf(lv->lrv_key_string, LREG_VALUE_STRING_MAX, "%lld",
-             binary_hist_lower_bucket_range(&rihs->rihs_bh,
-                                            lv->lrv_value_idx_in));
+    NIOVA_TIMER_START(x);
 
-    LREG_VALUE_TO_OUT_SIGNED_INT(lv) =
-        binary_hist_get_cnt(&rihs->rihs_bh, lv->lrv_value_idx_in);
+    /* rib_backend_checkpoint() returns the idx used for the checkpoint which
+     * must be >= to the one read here.
+     */
+    raft_entry_idx_t rc = ri->ri_backend->rib_backend_checkpoint(ri);
 
-    lv->get.lrv_value_type_out = LREG_VAL_TYPE_UNSIGNED_VAL;
+    NIOVA_TIMER_STOP_and_HIST_ADD(
+        x, raft_server_type_2_hist(ri, RAFT_INSTANCE_HIST_CHKPT_LAT_USEC));
+
+    if (rc >= 0)
+        raft_server_set_checkpoint_last_idx(ri, rc);
+
+    if (rc <= 0)
+        ri->ri_last_chkpt_err = rc;
+
+    DBG_RAFT_INSTANCE((rc < 0 ? LL_ERROR : LL_NOTIFY), ri,
+                      "rib_backend_checkpoint(%zd): %s",
+                      rc, rc < 0 ? strerror(-rc) : "Success");
 }
 
-static util_thread_ctx_reg_int_t
-raft_server_instance_hist_lreg_cb(enum lreg_node_cb_ops op,
-                                  struct lreg_node *lrn,
-                                  struct lreg_value *lv)
+static raft_server_chkpt_thread_ctx_t
+raft_server_reap_log(struct raft_instance *ri, ssize_t num_keep_entries)
 {
-    struct raft_instance_hist_stats *rihs = lrn->lrn_cb_arg;
+    if (!ri || // Maintain a min number of entries
+        num_keep_entries < RAFT_INSTANCE_PERSISTENT_APP_MIN_SCAN_ENTRIES)
+        return;
 
-    if (lv)
-        lv->get.lrv_num_keys_out = binary_hist_size(&rihs->rihs_bh);
+    const raft_entry_idx_t max_idx =
+        raft_server_instance_chkpt_compact_max_idx(ri);
 
-    switch (op)
-    {
-    case LREG_NODE_CB_OP_GET_NAME:
-        if (!lv)
-            return -EINVAL;
+    if (max_idx < 0)
+        return;
 
-        lreg_value_fill_key_and_type(
-            lv, raft_instance_hist_stat_2_name(rihs->rihs_type),
-            LREG_VAL_TYPE_OBJECT);
-        break;
+    const raft_entry_idx_t lowest_idx =
+        MAX(0, niova_atomic_read(&ri->ri_lowest_idx));
 
-    case LREG_NODE_CB_OP_READ_VAL:
-    case LREG_NODE_CB_OP_WRITE_VAL: //fall through
-        if (!lv)
-            return -EINVAL;
+    NIOVA_ASSERT(max_idx >= lowest_idx);
 
-        raft_server_instance_hist_lreg_multi_facet_handler(op, rihs, lv);
-        break;
+    const raft_entry_idx_t new_lowest_idx = max_idx - num_keep_entries;
 
-    case LREG_NODE_CB_OP_INSTALL_NODE:
-    case LREG_NODE_CB_OP_DESTROY_NODE:
-        break;
+    bool reaped = false;
 
-    default:
-        return -ENOENT;
+    if (new_lowest_idx > (lowest_idx + num_keep_entries) &&
+        !raft_server_compaction_try_increase_lowest_idx(ri, new_lowest_idx))
+    {
+        ri->ri_backend->rib_log_reap(ri, new_lowest_idx);
+        reaped = true;
     }
 
-    return 0;
+    DBG_RAFT_INSTANCE((reaped ? LL_NOTIFY : LL_DEBUG), ri,
+                      "num-keep-entries=%zd reap-idx=%ld reap=%s",
+                      num_keep_entries,
+                      new_lowest_idx > lowest_idx ? new_lowest_idx : -1L,
+                      reaped ? "true" : "false");
 }
 
-static int
-raft_server_instance_lreg_init(struct raft_instance *ri)
+/**
+ * raft_server_chkpt_pass - takes a checkpoint and reaps the log as needed.
+ *    Run about once per second by the instance's chkpt thread or by one of
+ *    the host's.
+ */
+static raft_server_chkpt_thread_ctx_t
+raft_server_chkpt_pass(struct raft_instance *ri)
 {
-    // Root entry may already be install but the ri_lreg must not be
-    LREG_ROOT_ENTRY_INSTALL_ALREADY_OK(raft_root_entry);
-
-    // Check for a correctly resumed raft process
-    NIOVA_ASSERT(!lreg_node_is_installed(&ri->ri_lreg));
+    const bool user_requested_chkpt = ri->ri_user_requested_checkpoint;
+    if (user_requested_chkpt)
+        ri->ri_user_requested_checkpoint = false;
 
-    // First, init the parent
-    lreg_node_init(&ri->ri_lreg, LREG_USER_TYPE_RAFT, raft_instance_lreg_cb,
-                   ri, LREG_INIT_OPT_INLINED_CHILDREN);
+    const bool user_requested_reap = ri->ri_user_requested_reap;
+    if (user_requested_reap)
+        ri->ri_user_requested_reap = false;
 
-    NIOVA_ASSERT(
-        (LREG_USER_TYPE_HISTOGRAM__MAX - LREG_USER_TYPE_HISTOGRAM__MIN) >=
-        RAFT_INSTANCE_HIST_MAX);
+    const raft_entry_idx_t max_idx =
+        raft_server_instance_chkpt_compact_max_idx(ri);
 
-    // Install the inlined objects into the parent
-    for (enum raft_instance_hist_types i = RAFT_INSTANCE_HIST_MIN;
-         i < RAFT_INSTANCE_HIST_MAX; i++)
-    {
-        enum lreg_user_types x = (enum lreg_user_types)i;
-        lreg_node_init(&ri->ri_rihs[i].rihs_lrn, x,
-                       raft_server_instance_hist_lreg_cb,
-                       (void *)&ri->ri_rihs[i],
-                       (LREG_INIT_OPT_IGNORE_NUM_VAL_ZERO |
-                        LREG_INIT_OPT_INLINED_MEMBER));
+    if (max_idx < 0)
+        return;
 
-        int rc =
-            lreg_node_install(&ri->ri_rihs[i].rihs_lrn, &ri->ri_lreg);
+    const raft_entry_idx_t num_entries_since_last_chkpt =
+        max_idx - ri->ri_checkpoint_last_idx;
 
-        if (rc)
-            return rc;
-    }
+    DBG_RAFT_INSTANCE_FATAL_IF(num_entries_since_last_chkpt < 0, ri,
+                               "max-idx=%lu ri_checkpoint_last_idx=%llu",
+                               max_idx, ri->ri_checkpoint_last_idx);
 
-    // Last, install the parent w/ it's child objects already in place
-    return lreg_node_install(&ri->ri_lreg,
-                             LREG_ROOT_ENTRY_PTR(raft_root_entry));
-}
+    DBG_RAFT_INSTANCE((num_entries_since_last_chkpt ? LL_DEBUG : LL_TRACE),
+                      ri, "entries_since_last_chkpt=%zd user-req=%s",
+                      num_entries_since_last_chkpt,
+                      user_requested_chkpt ? "yes" : "no");
 
-#if 0
-static int
-raft_server_instance_lreg_remove(struct raft_instance *ri)
-{
-    if (!ri)
-        return -EINVAL;
+    if (ri->ri_backend->rib_backend_checkpoint &&
+        (user_requested_chkpt ||
+         (ri->ri_auto_checkpoints_enabled &&
+          (num_entries_since_last_chkpt >= ri->ri_max_scan_entries))))
+        raft_server_take_chkpt(ri);
 
-    else if (!lreg_node_is_installed(&ri->ri_lreg))
-        return -EALREADY;
+    // Test for reaping
+    if (user_requested_reap ||
+        (ri->ri_auto_checkpoints_enabled && ri->ri_log_reap_factor))
+    {
+        NIOVA_ASSERT(ri->ri_log_reap_factor > 0); // sanity
 
+        ssize_t num_keep_entries =
+            ri->ri_log_reap_factor * ri->ri_max_scan_entries;
 
-    return 0;
+        raft_server_reap_log(ri, num_keep_entries);
+    }
 }
-#endif
 
-static raft_server_sync_thread_t
-raft_server_sync_thread(void *arg)
+static raft_server_chkpt_thread_t
+raft_server_chkpt_thread(void *arg)
 {
     struct thread_ctl *tc = arg;
     struct raft_instance *ri = (struct raft_instance *)thread_ctl_get_arg(tc);
 
-    if (!ri->ri_sync_freq_us)
-        ri->ri_sync_freq_us = RAFT_SERVER_SYNC_FREQ_US;
-
     NIOVA_ASSERT(ri);
 
     THREAD_LOOP_WITH_CTL(tc)
     {
-        usleep(ri->ri_sync_freq_us);
+        sleep(1);
         DBG_THREAD_CTL(LL_TRACE, tc, "here");
-        const bool has_unsynced_entries =
-            raft_server_has_unsynced_entries(ri);
-
-        DBG_RAFT_INSTANCE((has_unsynced_entries ? LL_DEBUG : LL_TRACE), ri,
-                          "raft_server_has_unsynced_entries(): %d",
-                          has_unsynced_entries);
-
-        if (has_unsynced_entries)
-        {
-            raft_server_backend_sync_pending(ri, __func__);
-            ri->ri_sync_cnt++;
+        if (raft_instance_is_shutdown(ri))
+            break;
 
-            raft_server_leader_try_advance_commit_idx_from_sync_thread(ri);
-        }
+        raft_server_chkpt_pass(ri);
     }
 
     return (void *)0;
 }
 
 static int
-raft_server_sync_thread_start(struct raft_instance *ri)
+raft_server_chkpt_thread_start(struct raft_instance *ri)
 {
     NIOVA_ASSERT(ri && raft_instance_is_booting(ri));
-
-    if (raft_server_does_synchronous_writes(ri))
+    if (!raft_server_chkpt_thread_needed(ri))
         return 0;
 
-    int rc = thread_create_watched(raft_server_sync_thread,
-                                   &ri->ri_sync_thread_ctl,
-                                   "sync_thread", (void *)ri, NULL);
+    int rc = thread_create_watched(raft_server_chkpt_thread,
+                                   &ri->ri_chkpt_thread_ctl,
+                                   "chkpt_thread", (void *)ri, NULL);
      if (rc)
 	return rc;
 
-    thread_ctl_run(&ri->ri_sync_thread_ctl);
+    thread_ctl_run(&ri->ri_chkpt_thread_ctl);
 
     return 0;
 }
 
 static int
-raft_server_sync_thread_join(struct raft_instance *ri)
+raft_server_chkpt_thread_join(struct raft_instance *ri)
 {
     NIOVA_ASSERT(ri && raft_instance_is_shutdown(ri));
 
-    if (raft_server_does_synchronous_writes(ri))
+    if (!raft_server_chkpt_thread_needed(ri))
         return 0;
 
-    int rc = thread_halt_and_destroy(&ri->ri_sync_thread_ctl);
+    int rc = thread_halt_and_destroy(&ri->ri_chkpt_thread_ctl);
 
     LOG_MSG(((rc && !ri->ri_startup_error) ? LL_WARN : LL_NOTIFY),
-            "thread_halt_and_destroy(): %s", strerror(-rc));
+             "thread_halt_and_destroy(): %s",
+             strerror(-rc));
 
     return rc;
 }
 
-/**
- * raft_server_set_checkpoint_last_idx - helper function for setting the
- *    raft instance checkpoint index.
- * @ri: raft instance
- * @chkpt_ret_idx:  the index value returned by rib_backend_checkpoint()
- */
-static raft_server_chkpt_thread_ctx_t
-raft_server_set_checkpoint_last_idx(struct raft_instance *ri,
-                                    int64_t chkpt_ret_idx)
+static unsigned long long
+raft_server_host_elapsed_usec(const struct timespec *since,
+                              const struct timespec *now)
 {
-    FATAL_IF(!ri || chkpt_ret_idx < 0 ||
-             chkpt_ret_idx < niova_atomic_read(&ri->ri_checkpoint_last_idx),
-             "invalid checkpoint-idx=%ld (chkpt_last_idx=%lld)",
-             chkpt_ret_idx, ri->ri_checkpoint_last_idx);
+    if (timespeccmp(now, since, <=))
+        return 0;
 
-    // Atomic here since this runs in a separate thread context.
-    niova_atomic_init(&ri->ri_checkpoint_last_idx, chkpt_ret_idx);
-}
+    struct timespec ts;
+    timespecsub(now, since, &ts);
 
-static int
-raft_server_chkpt_prior_to_recovery(struct raft_instance *ri)
-{
-    if (!ri || !ri->ri_backend->rib_backend_checkpoint ||
-        !thread_ctl_thread_is_running(&ri->ri_chkpt_thread_ctl))
-        return -EINVAL;
+    return timespec_2_nsec(&ts) / 1000;
+}
 
-    if (!raftServerDoesChkptBeforeRecovery)
-    {
-        LOG_MSG(LL_WARN,
-                "bypassing checkpoint operation due to configuration");
-        return 0;
-    }
-    else if (raft_server_get_current_raft_entry_index(ri, RI_NEHDR_SYNC) < 0)
+/**
+ * raft_server_host_sync_next - selects an attached group whose sync is due
+ *    and marks it busy.  A group is due once its batch is full or has been
+ *    held for rsg_max_batch_delay_us, or once ri_sync_freq_us has passed
+ *    since its last pass.  Otherwise, 'wait_us' is lowered to the time until
+ *    the next group is due.  The scan starts after the last selected group
+ *    so that a busy group does not starve the others.  The caller holds
+ *    rhw_mutex.
+ */
+static struct raft_host_group *
+raft_server_host_sync_next(struct raft_host_workers *rhw,
+                           unsigned long long *wait_us, size_t *batch_size)
+{
+    for (size_t n = 0; n < rhw->rhw_ngroups; n++)
     {
-        return 0;
-    }
+        const size_t i = (rhw->rhw_sync_next + n) % rhw->rhw_ngroups;
+        struct raft_host_group *rhg = &rhw->rhw_groups[i];
+        struct raft_instance *ri = rhg->rhg_ri;
 
+        if (!ri || rhg->rhg_sync_busy || raft_instance_is_shutdown(ri) ||
+            raft_server_does_synchronous_writes(ri))
+            continue;
 
-    raft_entry_idx_t last_idx = ri->ri_checkpoint_last_idx;
+        struct raft_sync_group *rsg = &ri->ri_sync_group;
+        struct timespec now;
 
-    // Reset error
-    ri->ri_last_chkpt_err = 0;
+        niova_mutex_lock(&rsg->rsg_mutex);
 
-    // Schedule the checkpoint
-    ri->ri_user_requested_checkpoint = true;
+        niova_unstable_clock(&now);
 
-    int rc =
-        thread_issue_sig_alarm_to_thread(ri->ri_chkpt_thread_ctl.tc_thread_id);
+        const unsigned long long since_sync =
+            raft_server_host_elapsed_usec(&rhg->rhg_sync_ts, &now);
 
-    if (rc)
-        return rc;
+        unsigned long long until_due = since_sync < ri->ri_sync_freq_us ?
+            ri->ri_sync_freq_us - since_sync : 0;
 
-    bool done = false;
-    int sleep_secs = raftServerChkptTimeoutSec;
-    while (sleep_secs--)
-    {
-        if ((niova_atomic_read(&ri->ri_checkpoint_last_idx) > last_idx) ||
-            ri->ri_last_chkpt_err)
+        if (rsg->rsg_pending >= rsg->rsg_max_batch_size)
         {
-            done = true;
-            break;
+            until_due = 0;
         }
-        sleep(1); // Wait for the recovery thread to finish up
-    }
+        else if (rsg->rsg_pending)
+        {
+            const unsigned long long held =
+                raft_server_host_elapsed_usec(&rsg->rsg_first_post_ts, &now);
 
-    if (!done && !ri->ri_last_chkpt_err) // Set ETIMEDOUT here
-        ri->ri_last_chkpt_err = -ETIMEDOUT;
+            if (held >= rsg->rsg_max_batch_delay_us)
+                until_due = 0;
+            else
+                until_due = MIN(until_due,
+                                rsg->rsg_max_batch_delay_us - held);
+        }
 
-    rc = ri->ri_last_chkpt_err;
-    DBG_RAFT_INSTANCE(LL_WARN, ri, "ri->ri_last_chkpt_err=%d", rc);
+        if (!until_due)
+        {
+            *batch_size = rsg->rsg_pending;
+            rsg->rsg_pending = 0;
+        }
 
-    return ((rc == -ENODATA) ? 0 :
-            (rc == -EALREADY) ? 0 : rc);
+        niova_mutex_unlock(&rsg->rsg_mutex);
+
+        if (!until_due)
+        {
+            rhg->rhg_sync_busy = true;
+            rhw->rhw_sync_next = i + 1;
+
+            return rhg;
+        }
+
+        *wait_us = MIN(*wait_us, until_due);
+    }
+
+    return NULL;
 }
 
-static raft_server_chkpt_thread_ctx_t
-raft_server_take_chkpt(struct raft_instance *ri)
+/**
+ * raft_server_host_chkpt_next - selects an attached group whose chkpt pass
+ *    is due, or for which a checkpoint or reap was requested, and marks it
+ *    busy.  The caller holds rhw_mutex.
+ */
+static struct raft_host_group *
+raft_server_host_chkpt_next(struct raft_host_workers *rhw,
+                            unsigned long long *wait_us)
 {
-    if (raft_server_instance_chkpt_compact_max_idx(ri) < 0)
+    for (size_t n = 0; n < rhw->rhw_ngroups; n++)
     {
-        ri->ri_last_chkpt_err = -ENODATA;
-        return;
-    }
+        const size_t i = (rhw->rhw_chkpt_next + n) % rhw->rhw_ngroups;
+        struct raft_host_group *rhg = &rhw->rhw_groups[i];
+        struct raft_instance *ri = rhg->rhg_ri;
 
-    NIOVA_TIMER_START(x);
+        if (!ri || rhg->rhg_chkpt_busy || raft_instance_is_shutdown(ri) ||
+            !raft_server_chkpt_thread_needed(ri))
+            continue;
 
-    /* rib_backend_checkpoint() returns the idx used for the checkpoint which
-     * must be >= to the one read here.
-     */
-    raft_entry_idx_t rc = ri->ri_backend->rib_backend_checkpoint(ri);
+        struct timespec now;
+        niova_unstable_clock(&now);
 
-    NIOVA_TIMER_STOP_and_HIST_ADD(
-        x, raft_server_type_2_hist(ri, RAFT_INSTANCE_HIST_CHKPT_LAT_USEC));
+        const unsigned long long since_chkpt =
+            raft_server_host_elapsed_usec(&rhg->rhg_chkpt_ts, &now);
 
-    if (rc >= 0)
-        raft_server_set_checkpoint_last_idx(ri, rc);
+        if (ri->ri_user_requested_checkpoint || ri->ri_user_requested_reap ||
+            since_chkpt >= RAFT_SERVER_HOST_CHKPT_FREQ_US)
+        {
+            rhg->rhg_chkpt_busy = true;
+            rhw->rhw_chkpt_next = i + 1;
 
-    if (rc <= 0)
-        ri->ri_last_chkpt_err = rc;
+            return rhg;
+        }
 
-    DBG_RAFT_INSTANCE((rc < 0 ? LL_ERROR : LL_NOTIFY), ri,
-                      "rib_backend_checkpoint(%zd): %s",
-                      rc, rc < 0 ? strerror(-rc) : "Success");
+        *wait_us = MIN(*wait_us, RAFT_SERVER_HOST_CHKPT_FREQ_US - since_chkpt);
+    }
+
+    return NULL;
 }
 
-static raft_server_chkpt_thread_ctx_t
-raft_server_reap_log(struct raft_instance *ri, ssize_t num_keep_entries)
+/**
+ * raft_server_host_sync_thread - one of the host's sync threads, which run
+ *    raft_server_sync_pass() for the attached groups.
+ */
+static raft_server_sync_thread_t
+raft_server_host_sync_thread(void *arg)
 {
-    if (!ri || // Maintain a min number of entries
-        num_keep_entries < RAFT_INSTANCE_PERSISTENT_APP_MIN_SCAN_ENTRIES)
-        return;
+    struct thread_ctl *tc = arg;
+    struct raft_host_workers *rhw =
+        (struct raft_host_workers *)thread_ctl_get_arg(tc);
 
-    const raft_entry_idx_t max_idx =
-        raft_server_instance_chkpt_compact_max_idx(ri);
+    NIOVA_ASSERT(rhw);
 
-    if (max_idx < 0)
-        return;
+    THREAD_LOOP_WITH_CTL(tc)
+    {
+        unsigned long long wait_us = RAFT_SERVER_HOST_WORKER_WAIT_US;
+        size_t batch_size = 0;
 
-    const raft_entry_idx_t lowest_idx =
-        MAX(0, niova_atomic_read(&ri->ri_lowest_idx));
+        niova_mutex_lock(&rhw->rhw_mutex);
 
-    NIOVA_ASSERT(max_idx >= lowest_idx);
+        struct raft_host_group *rhg =
+            raft_server_host_sync_next(rhw, &wait_us, &batch_size);
 
-    const raft_entry_idx_t new_lowest_idx = max_idx - num_keep_entries;
+        // The timed wait bounds the thread's response to a halt request
+        if (!rhg)
+        {
+            struct timespec ts;
+            raft_server_timedwait_deadline(&ts, wait_us);
+            pthread_cond_timedwait(&rhw->rhw_sync_cond, &rhw->rhw_mutex,
+                                   &ts);
+        }
 
-    bool reaped = false;
+        niova_mutex_unlock(&rhw->rhw_mutex);
 
-    if (new_lowest_idx > (lowest_idx + num_keep_entries) &&
-        !raft_server_compaction_try_increase_lowest_idx(ri, new_lowest_idx))
-    {
-        ri->ri_backend->rib_log_reap(ri, new_lowest_idx);
-        reaped = true;
+        DBG_THREAD_CTL(LL_TRACE, tc, "here");
+        if (!rhg)
+            continue;
+
+        raft_server_sync_pass(rhg->rhg_ri, batch_size);
+
+        niova_mutex_lock(&rhw->rhw_mutex);
+
+        niova_unstable_clock(&rhg->rhg_sync_ts);
+        rhg->rhg_sync_busy = false;
+        pthread_cond_broadcast(&rhw->rhw_idle_cond);
+
+        niova_mutex_unlock(&rhw->rhw_mutex);
     }
 
-    DBG_RAFT_INSTANCE((reaped ? LL_NOTIFY : LL_DEBUG), ri,
-                      "num-keep-entries=%zd reap-idx=%ld reap=%s",
-                      num_keep_entries,
-                      new_lowest_idx > lowest_idx ? new_lowest_idx : -1L,
-                      reaped ? "true" : "false");
+    return (void *)0;
 }
 
+/**
+ * raft_server_host_chkpt_thread - one of the host's chkpt threads, which run
+ *    raft_server_chkpt_pass() for the attached groups.
+ */
 static raft_server_chkpt_thread_t
-raft_server_chkpt_thread(void *arg)
+raft_server_host_chkpt_thread(void *arg)
 {
     struct thread_ctl *tc = arg;
-    struct raft_instance *ri = (struct raft_instance *)thread_ctl_get_arg(tc);
+    struct raft_host_workers *rhw =
+        (struct raft_host_workers *)thread_ctl_get_arg(tc);
 
-    NIOVA_ASSERT(ri);
+    NIOVA_ASSERT(rhw);
 
     THREAD_LOOP_WITH_CTL(tc)
     {
-        sleep(1);
-        DBG_THREAD_CTL(LL_TRACE, tc, "here");
-        if (raft_instance_is_shutdown(ri))
-            break;
+        unsigned long long wait_us = RAFT_SERVER_HOST_WORKER_WAIT_US;
 
-        const bool user_requested_chkpt = ri->ri_user_requested_checkpoint;
-        if (user_requested_chkpt)
-            ri->ri_user_requested_checkpoint = false;
+        niova_mutex_lock(&rhw->rhw_mutex);
 
-        const bool user_requested_reap = ri->ri_user_requested_reap;
-        if (user_requested_reap)
-            ri->ri_user_requested_reap = false;
+        struct raft_host_group *rhg = raft_server_host_chkpt_next(rhw,
+                                                                  &wait_us);
+
+        // The timed wait bounds the thread's response to a halt request
+        if (!rhg)
+        {
+            struct timespec ts;
+            raft_server_timedwait_deadline(&ts, wait_us);
+            pthread_cond_timedwait(&rhw->rhw_chkpt_cond, &rhw->rhw_mutex,
+                                   &ts);
+        }
 
-        const raft_entry_idx_t max_idx =
-            raft_server_instance_chkpt_compact_max_idx(ri);
+        niova_mutex_unlock(&rhw->rhw_mutex);
 
-        if (max_idx < 0)
+        DBG_THREAD_CTL(LL_TRACE, tc, "here");
+        if (!rhg)
             continue;
 
-        const raft_entry_idx_t num_entries_since_last_chkpt =
-            max_idx - ri->ri_checkpoint_last_idx;
+        raft_server_chkpt_pass(rhg->rhg_ri);
+
+        niova_mutex_lock(&rhw->rhw_mutex);
 
-        DBG_RAFT_INSTANCE_FATAL_IF(num_entries_since_last_chkpt < 0, ri,
-                                   "max-idx=%lu ri_checkpoint_last_idx=%llu",
-                                   max_idx, ri->ri_checkpoint_last_idx);
+        niova_unstable_clock(&rhg->rhg_chkpt_ts);
+        rhg->rhg_chkpt_busy = false;
+        pthread_cond_broadcast(&rhw->rhw_idle_cond);
 
-        DBG_RAFT_INSTANCE((num_entries_since_last_chkpt ? LL_DEBUG : LL_TRACE),
-                          ri, "entries_since_last_chkpt=%zd user-req=%s",
-                          num_entries_since_last_chkpt,
-                          user_requested_chkpt ? "yes" : "no");
+        niova_mutex_unlock(&rhw->rhw_mutex);
+    }
 
-        if (user_requested_chkpt ||
-            (ri->ri_auto_checkpoints_enabled &&
-             (num_entries_since_last_chkpt >= ri->ri_max_scan_entries)))
-            raft_server_take_chkpt(ri);
+    return (void *)0;
+}
 
-        // Test for reaping
-        if (user_requested_reap ||
-            (ri->ri_auto_checkpoints_enabled && ri->ri_log_reap_factor))
-        {
-            NIOVA_ASSERT(ri->ri_log_reap_factor > 0); // sanity
+/**
+ * raft_server_host_workers_attach - places a hosted group onto the host's
+ *    sync and chkpt threads, in place of starting its own.
+ */
+static int
+raft_server_host_workers_attach(struct raft_instance *ri)
+{
+    NIOVA_ASSERT(ri && ri->ri_host_workers && raft_instance_is_booting(ri));
 
-            ssize_t num_keep_entries =
-                ri->ri_log_reap_factor * ri->ri_max_scan_entries;
+    struct raft_host_workers *rhw = ri->ri_host_workers;
 
-            raft_server_reap_log(ri, num_keep_entries);
-        }
+    if (!ri->ri_sync_freq_us)
+        ri->ri_sync_freq_us = RAFT_SERVER_SYNC_FREQ_US;
+
+    niova_mutex_lock(&rhw->rhw_mutex);
+
+    struct raft_host_group *rhg = raft_server_host_group_get(rhw, NULL);
+    if (rhg)
+    {
+        memset(rhg, 0, sizeof(*rhg));
+        niova_unstable_clock(&rhg->rhg_sync_ts);
+        rhg->rhg_chkpt_ts = rhg->rhg_sync_ts;
+        rhg->rhg_ri = ri;
     }
 
-    return (void *)0;
+    niova_mutex_unlock(&rhw->rhw_mutex);
+
+    return rhg ? 0 : -ENOSPC;
 }
 
+/**
+ * raft_server_host_workers_detach - removes a hosted group from the host's
+ *    sync and chkpt threads once they are no longer working on it.
+ */
 static int
-raft_server_chkpt_thread_start(struct raft_instance *ri)
+raft_server_host_workers_detach(struct raft_instance *ri)
 {
-    NIOVA_ASSERT(ri && raft_instance_is_booting(ri));
-    if (!ri->ri_backend->rib_backend_checkpoint)
-        return 0;
+    NIOVA_ASSERT(ri && ri->ri_host_workers && raft_instance_is_shutdown(ri));
 
-    int rc = thread_create_watched(raft_server_chkpt_thread,
-                                   &ri->ri_chkpt_thread_ctl,
-                                   "chkpt_thread", (void *)ri, NULL);
-     if (rc)
-	return rc;
+    struct raft_host_workers *rhw = ri->ri_host_workers;
 
-    thread_ctl_run(&ri->ri_chkpt_thread_ctl);
+    niova_mutex_lock(&rhw->rhw_mutex);
+
+    struct raft_host_group *rhg = raft_server_host_group_get(rhw, ri);
+    if (rhg)
+    {
+        while (rhg->rhg_sync_busy || rhg->rhg_chkpt_busy)
+            pthread_cond_wait(&rhw->rhw_idle_cond, &rhw->rhw_mutex);
+
+        rhg->rhg_ri = NULL;
+    }
+
+    niova_mutex_unlock(&rhw->rhw_mutex);
 
     return 0;
 }
 
 static int
-raft_server_chkpt_thread_join(struct raft_instance *ri)
+raft_server_host_workers_stop(struct raft_host_workers *rhw)
 {
-    NIOVA_ASSERT(ri && raft_instance_is_shutdown(ri));
+    int rc = 0;
 
-    if (!ri->ri_backend->rib_backend_checkpoint)
-        return 0;
+    for (size_t i = 0; i < rhw->rhw_nsync_threads; i++)
+    {
+        int halt_rc = thread_halt_and_destroy(&rhw->rhw_sync_thread_ctl[i]);
+        if (halt_rc)
+        {
+            LOG_MSG(LL_WARN, "thread_halt_and_destroy(sync=%zu): %s", i,
+                    strerror(-halt_rc));
+            if (!rc)
+                rc = halt_rc;
+        }
+    }
 
-    int rc = thread_halt_and_destroy(&ri->ri_chkpt_thread_ctl);
+    for (size_t i = 0; i < rhw->rhw_nchkpt_threads; i++)
+    {
+        int halt_rc = thread_halt_and_destroy(&rhw->rhw_chkpt_thread_ctl[i]);
+        if (halt_rc)
+        {
+            LOG_MSG(LL_WARN, "thread_halt_and_destroy(chkpt=%zu): %s", i,
+                    strerror(-halt_rc));
+            if (!rc)
+                rc = halt_rc;
+        }
+    }
 
-    LOG_MSG(((rc && !ri->ri_startup_error) ? LL_WARN : LL_NOTIFY),
-             "thread_halt_and_destroy(): %s",
-             strerror(-rc));
+    rhw->rhw_nsync_threads = 0;
+    rhw->rhw_nchkpt_threads = 0;
+
+    niova_free(rhw->rhw_groups);
+    rhw->rhw_groups = NULL;
+
+    pthread_cond_destroy(&rhw->rhw_idle_cond);
+    pthread_cond_destroy(&rhw->rhw_chkpt_cond);
+    pthread_cond_destroy(&rhw->rhw_sync_cond);
+    pthread_mutex_destroy(&rhw->rhw_mutex);
 
     return rc;
 }
 
+/**
+ * raft_server_host_workers_start - starts the sync and chkpt threads shared
+ *    by 'ngroups' hosted groups, at most RAFT_HOST_SYNC_THREADS_MAX and
+ *    RAFT_HOST_CHKPT_THREADS_MAX of each.
+ */
 static int
-raft_server_instance_buffer_set_setup(struct raft_instance *ri)
+raft_server_host_workers_start(struct raft_host_workers *rhw,
+                               const size_t ngroups)
+{
+    NIOVA_ASSERT(rhw && ngroups);
+
+    memset(rhw, 0, sizeof(*rhw));
+
+    rhw->rhw_groups =
+        niova_calloc_can_fail(ngroups, sizeof(struct raft_host_group));
+    if (!rhw->rhw_groups)
+        return -ENOMEM;
+
+    rhw->rhw_ngroups = ngroups;
+
+    FATAL_IF((pthread_mutex_init(&rhw->rhw_mutex, NULL)),
+             "pthread_mutex_init(): %s", strerror(errno));
+
+    FATAL_IF((pthread_cond_init(&rhw->rhw_sync_cond, NULL)),
+             "pthread_cond_init(): %s", strerror(errno));
+
+    FATAL_IF((pthread_cond_init(&rhw->rhw_chkpt_cond, NULL)),
+             "pthread_cond_init(): %s", strerror(errno));
+
+    FATAL_IF((pthread_cond_init(&rhw->rhw_idle_cond, NULL)),
+             "pthread_cond_init(): %s", strerror(errno));
+
+    const size_t nsync = MIN(ngroups, RAFT_HOST_SYNC_THREADS_MAX);
+    const size_t nchkpt = MIN(ngroups, RAFT_HOST_CHKPT_THREADS_MAX);
+
+    int rc = 0;
+
+    for (size_t i = 0; !rc && i < nsync; i++)
+    {
+        rc = thread_create_watched(raft_server_host_sync_thread,
+                                   &rhw->rhw_sync_thread_ctl[i],
+                                   "host_sync", (void *)rhw, NULL);
+        if (!rc)
+        {
+            thread_ctl_run(&rhw->rhw_sync_thread_ctl[i]);
+            rhw->rhw_nsync_threads++;
+        }
+    }
+
+    for (size_t i = 0; !rc && i < nchkpt; i++)
+    {
+        rc = thread_create_watched(raft_server_host_chkpt_thread,
+                                   &rhw->rhw_chkpt_thread_ctl[i],
+                                   "host_chkpt", (void *)rhw, NULL);
+        if (!rc)
+        {
+            thread_ctl_run(&rhw->rhw_chkpt_thread_ctl[i]);
+            rhw->rhw_nchkpt_threads++;
+        }
+    }
+
+    if (rc)
+        raft_server_host_workers_stop(rhw);
+
+    return rc;
+}
+
+/**
+ * raft_server_buf_pool_setup - allocate the buffer sets of 'rbp' for
+ *    rbp_ngroups raft groups.  The tcp_mgr workers are process wide, so their
+ *    share of the small and large sets is not multiplied by the number of
+ *    groups.
+ */
+static int
+raft_server_buf_pool_setup(const struct raft_instance *ri,
+                           struct raft_buf_pool *rbp)
 {
-    if (!ri->ri_max_entry_size)
+    if (!ri->ri_max_entry_size || !rbp->rbp_ngroups)
         return -EINVAL;
 
     int rc;
     size_t buff_set_sizes[RAFT_BUF_SET_MAX] = {RAFT_BS_SMALL_SZ,
                                                RAFT_BS_LARGE_SZ,
-                                               RAFT_BS_APPLY_SZ};
+                                               RAFT_BS_APPLY_SZ,
+                                               RAFT_BS_IO_SZ};
+
+    const int ngroups = rbp->rbp_ngroups;
+    const bool shared = rbp != &ri->ri_buf_pool;
 
-    int small_nbuf = RAFT_ENTRY_NUM_ENTRIES + tcp_mgr_worker_cnt_get();
+    int small_nbuf = RAFT_ENTRY_NUM_ENTRIES * ngroups +
+        tcp_mgr_worker_cnt_get();
     // Note: server fails if No. of large buffer is not nthreads + 1
-    int large_nbuf = tcp_mgr_worker_cnt_get() + 1;
-    int apply_nbuf = RAFT_BS_APPLY_NBUF;
+    int large_nbuf = tcp_mgr_worker_cnt_get() + ngroups;
+    int apply_nbuf = RAFT_BS_APPLY_NBUF * ngroups;
+    /* Only the posix io_uring engine consumes io buffers.  The io_uring
+     * setting of the other groups is not known when a shared pool is made.
+     */
+    int io_nbuf = (ri->ri_store_type == RAFT_INSTANCE_STORE_POSIX_FLAT_FILE &&
+                   (ri->ri_posix_io_uring || shared)) ?
+        RAFT_BS_IO_NBUF * ngroups : 1;
 
-    SIMPLE_LOG_MSG(LL_NOTIFY, "sbuf count: %d, lbuf count: %d", small_nbuf,
-                   large_nbuf);
+    SIMPLE_LOG_MSG(LL_NOTIFY, "sbuf count: %d, lbuf count: %d, iobuf count: %d",
+                   small_nbuf, large_nbuf, io_nbuf);
 
-    size_t nbuff[RAFT_BUF_SET_MAX] = {small_nbuf, large_nbuf, apply_nbuf};
+    size_t nbuff[RAFT_BUF_SET_MAX] = {small_nbuf, large_nbuf, apply_nbuf,
+                                      io_nbuf};
 
     size_t total_buf_size = 0;
 
     for (int i = 0; i < RAFT_BUF_SET_MAX; i++)
         total_buf_size += buff_set_sizes[i] * nbuff[i];
 
-    ri->ri_buf_set_source = niova_posix_memalign(total_buf_size,
-                                                 BUFFER_SECTOR_SIZE);
+    rbp->rbp_source = niova_posix_memalign(total_buf_size,
+                                           BUFFER_SECTOR_SIZE);
     size_t off = 0;
 
     for (int p = 0; p < RAFT_BUF_SET_MAX; p++)
     {
-        char *src = &ri->ri_buf_set_source[off];
+        char *src = &rbp->rbp_source[off];
         size_t xtotal_sz = buff_set_sizes[p] * nbuff[p];
 
-        rc = buffer_set_init(&ri->ri_buf_set[p], src, xtotal_sz,
+        rc = buffer_set_init(&rbp->rbp_sets[p], src, xtotal_sz,
                              nbuff[p], buff_set_sizes[p],
                              (BUFSET_OPT_MEMALIGN | BUFSET_OPT_SERIALIZE));
         NIOVA_ASSERT(rc == 0);
@@ -5981,23 +11299,50 @@ raft_server_instance_buffer_set_setup(struct raft_instance *ri)
 }
 
 static void
-raft_server_instance_buffer_set_destroy(struct raft_instance *ri)
+raft_server_buf_pool_destroy(struct raft_buf_pool *rbp)
 {
-    if (!ri)
+    if (!rbp || !rbp->rbp_source)
         return;
 
     int rc;
     for (int p = 0; p < RAFT_BUF_SET_MAX; p++)
     {
-        rc = buffer_set_destroy(&ri->ri_buf_set[p]);
+        rc = buffer_set_destroy(&rbp->rbp_sets[p]);
         NIOVA_ASSERT(rc == 0);
     }
 
-    if (ri->ri_buf_set_source)
+    niova_free(rbp->rbp_source);
+    rbp->rbp_source = NULL;
+}
+
+/**
+ * raft_server_instance_buffer_set_setup - a hosted instance uses the host's
+ *    pool, which is set up by the first group to start.  Other instances
+ *    use their own.
+ */
+static int
+raft_server_instance_buffer_set_setup(struct raft_instance *ri)
+{
+    if (ri->ri_host_buf_pool)
+    {
+        ri->ri_bufs = ri->ri_host_buf_pool;
+    }
+    else
     {
-        niova_free(ri->ri_buf_set_source);
-        ri->ri_buf_set_source = NULL;
+        ri->ri_bufs = &ri->ri_buf_pool;
+        ri->ri_bufs->rbp_ngroups = 1;
     }
+
+    return ri->ri_bufs->rbp_source ? 0 :
+        raft_server_buf_pool_setup(ri, ri->ri_bufs);
+}
+
+static void
+raft_server_instance_buffer_set_destroy(struct raft_instance *ri)
+{
+    // The host's pool outlives the hosted instances
+    if (ri)
+        raft_server_buf_pool_destroy(&ri->ri_buf_pool);
 }
 
 static int
@@ -6014,10 +11359,25 @@ raft_server_instance_startup(struct raft_instance *ri)
     FATAL_IF((pthread_mutex_init(&ri->ri_write_mutex, NULL)),
              "pthread_mutex_init(): %s", strerror(errno));
 
+    FATAL_IF((pthread_mutex_init(&ri->ri_entry_cache.rec_mutex, NULL)),
+             "pthread_mutex_init(): %s", strerror(errno));
+
+    FATAL_IF((pthread_mutex_init(&ri->ri_sync_group.rsg_mutex, NULL)),
+             "pthread_mutex_init(): %s", strerror(errno));
+
+    FATAL_IF((pthread_cond_init(&ri->ri_sync_group.rsg_cond, NULL)),
+             "pthread_cond_init(): %s", strerror(errno));
+
+    FATAL_IF((pthread_mutex_init(&ri->ri_sync_group.rsg_sync_mutex, NULL)),
+             "pthread_mutex_init(): %s", strerror(errno));
+
     // raft_server_instance_init() should have been run
     if (!ri->ri_timer_fd_cb)
         return -EINVAL;
 
+    struct timespec ts[2];
+    clock_gettime(CLOCK_MONOTONIC, &ts[0]);
+
     // Init the in-memory sync/unsync entry headers
     raft_instance_initialize_newest_entry_hdr(ri);
 
@@ -6062,24 +11422,54 @@ raft_server_instance_startup(struct raft_instance *ri)
         goto out;
     }
 
-    if (!raft_server_does_synchronous_writes(ri))
-    {
-        rc = raft_server_sync_thread_start(ri);
-        if (rc)
-            goto out;
-    }
+    // Hosted groups share the host's sync and chkpt threads
+    if (ri->ri_host_workers)
+    {
+        rc = raft_server_host_workers_attach(ri);
+        if (rc)
+            goto out;
+    }
+    else
+    {
+        if (!raft_server_does_synchronous_writes(ri))
+        {
+            rc = raft_server_sync_thread_start(ri);
+            if (rc)
+                goto out;
+        }
+
+        if (raft_server_chkpt_thread_needed(ri))
+        {
+            rc = raft_server_chkpt_thread_start(ri);
+            if (rc)
+                goto out;
+        }
+    }
+
+    rc = raft_server_read_workers_start(ri);
+    if (rc)
+        goto out;
 
-    if (ri->ri_backend->rib_backend_checkpoint)
-    {
-        rc = raft_server_chkpt_thread_start(ri);
-        if (rc)
-            goto out;
-    }
+    rc = raft_server_apply_prefetch_start(ri);
+    if (rc)
+        goto out;
+
+    rc = raft_server_bulk_lane_start(ri);
+    if (rc)
+        goto out;
 
     // Give control to application to setup peer on startup.
     if (ri->ri_init_cb)
         ri->ri_init_cb(RAFT_INIT_BOOTUP_STATE);
 
+    clock_gettime(CLOCK_MONOTONIC, &ts[1]);
+    timespecsub(&ts[1], &ts[0], &ts[1]);
+
+    ri->ri_startup_usec = (ts[1].tv_sec * 1000000ULL) + (ts[1].tv_nsec / 1000);
+
+    DBG_RAFT_INSTANCE(LL_WARN, ri, "startup-usec=%llu scan-usec=%llu",
+                      ri->ri_startup_usec, ri->ri_startup_scan_usec);
+
 out:
     if (rc)
     {
@@ -6115,12 +11505,19 @@ raft_server_instance_shutdown(struct raft_instance *ri)
 
     int rc = 0;
 
-    int rc_chkpt = raft_server_chkpt_thread_join(ri);
-    int rc_sync = raft_server_sync_thread_join(ri);
+    int rc_read = raft_server_read_workers_join(ri);
+    int rc_prefetch = raft_server_apply_prefetch_join(ri);
+    int rc_bulk = raft_server_bulk_lane_join(ri);
+    int rc_chkpt = ri->ri_host_workers ? 0 :
+        raft_server_chkpt_thread_join(ri);
+    int rc_sync = ri->ri_host_workers ?
+        raft_server_host_workers_detach(ri) : raft_server_sync_thread_join(ri);
     int rc_backend_close = raft_server_backend_close(ri);
     int rc_evp_cleanup = raft_server_evp_cleanup(ri);
     int mutex_rc = pthread_mutex_destroy(&ri->ri_newest_entry_mutex);
     int mutex_rc2 = pthread_mutex_destroy(&ri->ri_compaction_mutex);
+    int mutex_rc3 = raft_server_entry_cache_destroy(ri);
+    int mutex_rc4 = raft_server_sync_group_destroy(ri);
 
     int lreg_remove_rc =
         lreg_node_remove(&ri->ri_lreg, LREG_ROOT_ENTRY_PTR(raft_root_entry));
@@ -6129,6 +11526,30 @@ raft_server_instance_shutdown(struct raft_instance *ri)
 
     enum log_level ll = ri->ri_startup_error ? LL_NOTIFY : LL_ERROR;
 
+    if (rc_read)
+    {
+        SIMPLE_LOG_MSG(ll, "raft_server_read_workers_join(): %s",
+                       strerror(-rc_read));
+        if (!rc)
+            rc = rc_read;
+    }
+
+    if (rc_prefetch)
+    {
+        SIMPLE_LOG_MSG(ll, "raft_server_apply_prefetch_join(): %s",
+                       strerror(-rc_prefetch));
+        if (!rc)
+            rc = rc_prefetch;
+    }
+
+    if (rc_bulk)
+    {
+        SIMPLE_LOG_MSG(ll, "raft_server_bulk_lane_join(): %s",
+                       strerror(-rc_bulk));
+        if (!rc)
+            rc = rc_bulk;
+    }
+
     if (rc_chkpt)
     {
         SIMPLE_LOG_MSG(ll, "raft_server_chkpt_thread_join(): %s",
@@ -6177,6 +11598,22 @@ raft_server_instance_shutdown(struct raft_instance *ri)
             rc = -mutex_rc2;
     }
 
+    if (mutex_rc3)
+    {
+        SIMPLE_LOG_MSG(ll, "raft_server_entry_cache_destroy(): %s",
+                       strerror(mutex_rc3));
+        if (!rc)
+            rc = -mutex_rc3;
+    }
+
+    if (mutex_rc4)
+    {
+        SIMPLE_LOG_MSG(ll, "raft_server_sync_group_destroy(): %s",
+                       strerror(mutex_rc4));
+        if (!rc)
+            rc = -mutex_rc4;
+    }
+
     if (lreg_remove_rc)
     {
         SIMPLE_LOG_MSG(ll, "lreg_node_remove(): %s",
@@ -6202,6 +11639,13 @@ raft_server_instance_shutdown(struct raft_instance *ri)
         ri->ri_coalesced_wr = NULL;
     }
 
+    if (ri->ri_ae_decompress_buf)
+    {
+        niova_free(ri->ri_ae_decompress_buf);
+        ri->ri_ae_decompress_buf = NULL;
+        ri->ri_ae_decompress_buf_size = 0;
+    }
+
     return rc;
 }
 
@@ -6213,14 +11657,20 @@ raft_server_main_loop_exit_conditions(const struct raft_instance *ri)
         ? true : false;
 }
 
-static int
-raft_server_main_loop(struct raft_instance *ri)
+static void
+raft_server_main_loop_prepare(struct raft_instance *ri)
 {
     NIOVA_ASSERT(raft_instance_is_running(ri));
     ri->ri_state = RAFT_STATE_FOLLOWER;
     ri->ri_follower_reason = RAFT_BFRSN_LEADER_ALREADY_PRESENT;
 
     raft_server_timerfd_settime(ri);
+}
+
+static int
+raft_server_main_loop(struct raft_instance *ri)
+{
+    raft_server_main_loop_prepare(ri);
 
     int rc = 0;
 
@@ -6324,6 +11774,29 @@ raft_server_bulk_recovery(struct raft_instance *ri, void *arg)
     return rc;
 }
 
+static void
+raft_server_instance_co_wr_alloc(struct raft_instance *ri)
+{
+    /* The size array follows the data buffer and is sized for the largest
+     * v2 entry.
+     */
+    const size_t buffer_size =
+        (RAFT_ENTRY_MAX_DATA_SIZE(ri) + sizeof(uint32_t) - 1) &
+        ~(sizeof(uint32_t) - 1);
+
+    size_t co_wr_info_size = sizeof(struct raft_instance_co_wr) +
+        buffer_size + sizeof(uint32_t) * RAFT_ENTRY_V2_NUM_ENTRIES_MAX;
+
+    // Allocate memory for coalesced write structure
+    ri->ri_coalesced_wr = niova_malloc(co_wr_info_size);
+    NIOVA_ASSERT(ri->ri_coalesced_wr);
+
+    memset(ri->ri_coalesced_wr, 0, sizeof(struct raft_instance_co_wr));
+
+    ri->ri_coalesced_wr->rcwi_entry_sizes =
+        (uint32_t *)&ri->ri_coalesced_wr->rcwi_buffer[buffer_size];
+}
+
 int
 raft_server_instance_run(const char *raft_uuid_str,
                          const char *this_peer_uuid_str,
@@ -6403,14 +11876,7 @@ raft_server_instance_run(const char *raft_uuid_str,
         {
             int recovery_chkpt_rc = 0;
 
-            size_t co_wr_info_size = sizeof(struct raft_instance_co_wr) +
-                                     RAFT_ENTRY_MAX_DATA_SIZE(ri);
-
-            // Allocate memory for coalesced write structure
-            ri->ri_coalesced_wr = niova_malloc(co_wr_info_size);
-            NIOVA_ASSERT(ri->ri_coalesced_wr);
-
-            memset(ri->ri_coalesced_wr, 0, sizeof(struct raft_instance_co_wr));
+            raft_server_instance_co_wr_alloc(ri);
 
             // Execute the main loop
             int main_loop_rc = raft_server_main_loop(ri);
@@ -6464,12 +11930,395 @@ raft_server_instance_run(const char *raft_uuid_str,
     return rc;
 }
 
+enum raft_server_hosted_state
+{
+    RAFT_SERVER_HOSTED_BOOTING = 0,
+    RAFT_SERVER_HOSTED_RUNNING,
+    RAFT_SERVER_HOSTED_RECOVERING,
+    RAFT_SERVER_HOSTED_DONE,
+};
+
+/* Per-group state of raft_server_multi_instance_run().  Bulk recovery of a
+ * group runs in its own thread so that the other groups continue to be
+ * serviced by the host's event loop.
+ */
+struct raft_server_hosted
+{
+    const struct raft_server_group_conf *rsh_conf;
+    struct raft_instance                *rsh_ri;
+    enum raft_server_hosted_state        rsh_state;
+    int                                  rsh_rc;
+    int                                  rsh_recovery_rc;
+    int                                  rsh_recovery_tries;
+    bool                                 rsh_recovery_running;
+    struct thread_ctl                    rsh_recovery_thread_ctl;
+    niova_atomic32_t                     rsh_recovery_done;
+    raft_sm_request_handler_t            rsh_sm_request_handler;
+    raft_init_cb_t                       rsh_init_peer_handler;
+    enum raft_instance_store_type        rsh_type;
+    enum raft_instance_options           rsh_opts;
+};
+
+static void
+raft_server_hosted_done(struct raft_server_hosted *rsh, int rc)
+{
+    SIMPLE_LOG_MSG((rc ? LL_ERROR : LL_WARN), "hosted raft %s exits: %s",
+                   rsh->rsh_conf->rsgc_raft_uuid_str, strerror(-rc));
+
+    rsh->rsh_state = RAFT_SERVER_HOSTED_DONE;
+    rsh->rsh_rc = rc;
+}
+
+static raft_server_hosted_recovery_thread_t
+raft_server_hosted_recovery_thread(void *arg)
+{
+    struct thread_ctl *tc = arg;
+    struct raft_server_hosted *rsh =
+        (struct raft_server_hosted *)thread_ctl_get_arg(tc);
+
+    NIOVA_ASSERT(rsh);
+
+    // The recovery runs once, the thread then exits and awaits the halt
+    THREAD_LOOP_WITH_CTL(tc)
+    {
+        rsh->rsh_recovery_rc =
+            raft_server_bulk_recovery(rsh->rsh_ri, rsh->rsh_conf->rsgc_arg);
+
+        niova_atomic_inc(&rsh->rsh_recovery_done);
+        break;
+    }
+
+    return (void *)0;
+}
+
+static void
+raft_server_hosted_recovery_join(struct raft_server_hosted *rsh)
+{
+    if (!rsh->rsh_recovery_running)
+        return;
+
+    int rc = thread_halt_and_destroy(&rsh->rsh_recovery_thread_ctl);
+
+    LOG_MSG((rc ? LL_WARN : LL_NOTIFY), "thread_halt_and_destroy(): %s",
+            strerror(-rc));
+
+    rsh->rsh_recovery_running = false;
+}
+
+static void
+raft_server_hosted_recovery_start(struct raft_server_hosted *rsh)
+{
+    struct raft_instance *ri = rsh->rsh_ri;
+
+    if (--rsh->rsh_recovery_tries < 0)
+    {
+        raft_server_hosted_done(rsh, rsh->rsh_recovery_rc);
+        return;
+    }
+
+    if (rsh->rsh_recovery_tries < RAFT_SERVER_RECOVERY_ATTEMPTS - 1)
+        LOG_MSG(LL_WARN, "recovery attempts remaining %d",
+                rsh->rsh_recovery_tries);
+
+    ri->ri_proc_state = RAFT_PROC_STATE_BOOTING;
+    niova_atomic_init(&rsh->rsh_recovery_done, 0);
+
+    int rc = thread_create_watched(raft_server_hosted_recovery_thread,
+                                   &rsh->rsh_recovery_thread_ctl,
+                                   "hosted_recovery", (void *)rsh, NULL);
+    if (rc)
+    {
+        raft_server_hosted_done(rsh, rc);
+        return;
+    }
+
+    thread_ctl_run(&rsh->rsh_recovery_thread_ctl);
+
+    rsh->rsh_recovery_running = true;
+    rsh->rsh_state = RAFT_SERVER_HOSTED_RECOVERING;
+}
+
+/**
+ * raft_server_hosted_start - (re)initialize a hosted group and attach it to
+ *    the host's event loop.  This is the hosted analog of one pass through
+ *    raft_server_instance_run()'s loop, up to the main loop.
+ */
+static void
+raft_server_hosted_start(struct raft_server_hosted *rsh)
+{
+    struct raft_instance *ri = rsh->rsh_ri;
+
+    ri->ri_hosted = true;
+
+    raft_server_instance_init(ri, rsh->rsh_type,
+                              rsh->rsh_conf->rsgc_raft_uuid_str,
+                              rsh->rsh_conf->rsgc_this_peer_uuid_str,
+                              rsh->rsh_sm_request_handler,
+                              rsh->rsh_init_peer_handler, rsh->rsh_opts,
+                              rsh->rsh_conf->rsgc_arg);
+
+    int rc = raft_net_instance_startup(ri, false);
+    if (rc == -EUCLEAN) // Special error code for incomplete recovery
+    {
+        ri->ri_needs_bulk_recovery = true;
+        raft_server_hosted_recovery_start(rsh);
+    }
+    else if (rc)
+    {
+        SIMPLE_LOG_MSG(LL_ERROR, "raft_net_instance_startup(%s): %s",
+                       rsh->rsh_conf->rsgc_raft_uuid_str, strerror(-rc));
+
+        raft_server_hosted_done(rsh, rc);
+    }
+    else
+    {
+        raft_server_instance_co_wr_alloc(ri);
+        raft_server_main_loop_prepare(ri);
+
+        rsh->rsh_state = RAFT_SERVER_HOSTED_RUNNING;
+    }
+}
+
+static int
+raft_server_hosted_stop(struct raft_server_hosted *rsh)
+{
+    struct raft_instance *ri = rsh->rsh_ri;
+    int rc = 0;
+
+    if (ri->ri_needs_bulk_recovery)
+    {
+        // Checkpoint the current contents while the db is open
+        rc = raft_server_chkpt_prior_to_recovery(ri);
+        if (rc)
+            LOG_MSG(LL_ERROR, "raft_server_chkpt_prior_to_recovery(): %s",
+                    strerror(-rc));
+    }
+
+    int shutdown_rc = raft_net_instance_shutdown(ri);
+    if (shutdown_rc)
+    {
+        if (!rc)
+            rc = shutdown_rc;
+
+        SIMPLE_LOG_MSG(LL_ERROR, "raft_net_instance_shutdown(): %s",
+                       strerror(-shutdown_rc));
+    }
+
+    return rc;
+}
+
+/**
+ * raft_server_hosted_poll - advance the group's state after the host's event
+ *    loop has run.  Returns true while the group remains active.
+ */
+static bool
+raft_server_hosted_poll(struct raft_server_hosted *rsh)
+{
+    struct raft_instance *ri = rsh->rsh_ri;
+
+    switch (rsh->rsh_state)
+    {
+    case RAFT_SERVER_HOSTED_RUNNING:
+        if (ri->ri_needs_bulk_recovery)
+        {
+            int rc = raft_server_hosted_stop(rsh);
+            if (rc)
+                raft_server_hosted_done(rsh, rc);
+            else
+                raft_server_hosted_recovery_start(rsh);
+        }
+        break;
+
+    case RAFT_SERVER_HOSTED_RECOVERING:
+        if (!niova_atomic_read(&rsh->rsh_recovery_done))
+            break;
+
+        raft_server_hosted_recovery_join(rsh);
+
+        SIMPLE_LOG_MSG(LL_ERROR, "raft_server_bulk_recovery(%s): %s",
+                       rsh->rsh_conf->rsgc_raft_uuid_str,
+                       strerror(-rsh->rsh_recovery_rc));
+
+        if (!rsh->rsh_recovery_rc)
+        {
+            // Success - restart in the normal (non-recovery) mode
+            ri->ri_successful_recovery = true;
+            ri->ri_needs_bulk_recovery = false;
+            rsh->rsh_recovery_tries = RAFT_SERVER_RECOVERY_ATTEMPTS;
+        }
+
+        raft_server_hosted_start(rsh);
+        break;
+
+    default:
+        break;
+    }
+
+    return rsh->rsh_state == RAFT_SERVER_HOSTED_DONE ? false : true;
+}
+
+/**
+ * raft_server_multi_instance_run - run several raft groups within this
+ *    process.  The groups share a single event loop, one pool of buffer
+ *    sets, and the udp and tcp listeners of groups whose peers have the same
+ *    address.  Msgs and connections arriving on a shared listener are routed
+ *    by their raft uuid, and the heartbeats which the groups send to the same
+ *    peer process leave in one datagram.  The groups' backend syncs and
+ *    checkpoints are run by a small pool of host threads, and the default
+ *    entry cache limit is divided between the groups.  The first group is
+ *    served by the default raft instance.  A group which must be bulk
+ *    recovered is taken off the event loop while the recovery runs.  Returns
+ *    once all groups have exited, with the first error encountered.
+ */
+int
+raft_server_multi_instance_run(const struct raft_server_group_conf *groups,
+                               size_t ngroups,
+                               raft_sm_request_handler_t sm_request_handler,
+                               raft_init_cb_t init_peer_handler,
+                               enum raft_instance_store_type type,
+                               enum raft_instance_options opts)
+{
+    FUNC_ENTRY(LL_NOTIFY);
+
+    if (!groups || !ngroups || !sm_request_handler)
+        return -EINVAL;
+
+    for (size_t i = 0; i < ngroups; i++)
+        if (!groups[i].rsgc_raft_uuid_str ||
+            !groups[i].rsgc_this_peer_uuid_str)
+            return -EINVAL;
+
+    struct raft_server_hosted *rshs =
+        niova_calloc_can_fail(ngroups, sizeof(struct raft_server_hosted));
+    if (!rshs)
+        return -ENOMEM;
+
+    int rc = raft_net_host_setup();
+    if (rc)
+    {
+        niova_free(rshs);
+        return rc;
+    }
+
+    struct raft_host_workers host_workers;
+
+    rc = raft_server_host_workers_start(&host_workers, ngroups);
+    if (rc)
+    {
+        raft_net_host_destroy();
+        niova_free(rshs);
+        return rc;
+    }
+
+    // The groups' buffer sets are allocated once, by the first to start
+    struct raft_buf_pool host_buf_pool = {.rbp_ngroups = ngroups};
+
+    for (size_t i = 0; i < ngroups; i++)
+    {
+        struct raft_server_hosted *rsh = &rshs[i];
+
+        rsh->rsh_conf = &groups[i];
+        rsh->rsh_recovery_tries = RAFT_SERVER_RECOVERY_ATTEMPTS;
+        rsh->rsh_sm_request_handler = sm_request_handler;
+        rsh->rsh_init_peer_handler = init_peer_handler;
+        rsh->rsh_type = type;
+        rsh->rsh_opts = opts;
+        rsh->rsh_ri = i ? raft_net_instance_alloc() : raft_net_get_instance();
+
+        if (!rsh->rsh_ri)
+        {
+            rc = -ENOMEM;
+            break;
+        }
+
+        rsh->rsh_ri->ri_host_buf_pool = &host_buf_pool;
+        rsh->rsh_ri->ri_host_workers = &host_workers;
+        raft_server_hosted_start(rsh);
+    }
+
+    while (!rc && !FAULT_INJECT(raft_server_main_loop_break))
+    {
+        size_t nactive = 0;
+
+        for (size_t i = 0; i < ngroups; i++)
+            if (raft_server_hosted_poll(&rshs[i]))
+                nactive++;
+
+        if (!nactive)
+            break;
+
+        int wait_rc = raft_net_host_epoll_wait(RAFT_SERVER_HOST_POLL_MSEC);
+        if (wait_rc < 0)
+        {
+            SIMPLE_LOG_MSG(LL_ERROR, "raft_net_host_epoll_wait(): %s",
+                           strerror(-wait_rc));
+            rc = wait_rc;
+        }
+    }
+
+    for (size_t i = 0; i < ngroups; i++)
+    {
+        struct raft_server_hosted *rsh = &rshs[i];
+
+        if (rsh->rsh_state == RAFT_SERVER_HOSTED_RUNNING)
+        {
+            int stop_rc = raft_server_hosted_stop(rsh);
+            if (!rsh->rsh_rc)
+                rsh->rsh_rc = stop_rc;
+        }
+        else
+        {
+            raft_server_hosted_recovery_join(rsh);
+        }
+
+        if (!rc)
+            rc = rsh->rsh_rc;
+
+        if (i && rsh->rsh_ri)
+        {
+            raft_net_instance_free(rsh->rsh_ri);
+        }
+        else if (rsh->rsh_ri)
+        {
+            // The default instance may be run again without the host
+            rsh->rsh_ri->ri_hosted = false;
+            rsh->rsh_ri->ri_host_buf_pool = NULL;
+            rsh->rsh_ri->ri_host_workers = NULL;
+        }
+    }
+
+    int workers_rc = raft_server_host_workers_stop(&host_workers);
+    if (!rc)
+        rc = workers_rc;
+
+    raft_server_buf_pool_destroy(&host_buf_pool);
+    raft_net_host_destroy();
+    niova_free(rshs);
+
+    FUNC_EXIT(LL_NOTIFY);
+
+    return rc;
+}
+
+/**
+ * raft_server_instance_by_id - returns the instance which serves 'raft_id'.
+ *    A NULL or null 'raft_id' selects the default instance, which is the only
+ *    one unless raft_server_multi_instance_run() is in use.
+ */
+static struct raft_instance *
+raft_server_instance_by_id(const uuid_t raft_id)
+{
+    return (!raft_id || uuid_is_null(raft_id)) ? raft_net_get_instance() :
+        raft_net_instance_lookup(raft_id);
+}
+
 int
-raft_server_get_leader_ts(struct raft_leader_ts *leader_ts)
+raft_server_get_leader_ts_by_id(const uuid_t raft_id,
+                                struct raft_leader_ts *leader_ts)
 {
-    struct raft_instance *ri = raft_net_get_instance();
+    struct raft_instance *ri = raft_server_instance_by_id(raft_id);
 
-    if (!raft_instance_is_leader(ri) || !leader_ts)
+    if (!ri || !raft_instance_is_leader(ri) || !leader_ts)
         return -EINVAL;
 
     leader_ts->rlts_term = ri->ri_log_hdr.rlh_term;
@@ -6478,17 +12327,31 @@ raft_server_get_leader_ts(struct raft_leader_ts *leader_ts)
     return 0;
 }
 
+int
+raft_server_get_leader_ts(struct raft_leader_ts *leader_ts)
+{
+    return raft_server_get_leader_ts_by_id(NULL, leader_ts);
+}
+
+bool
+raft_server_is_leader_by_id(const uuid_t raft_id)
+{
+    struct raft_instance *ri = raft_server_instance_by_id(raft_id);
+
+    return ri ? raft_instance_is_leader(ri) : false;
+}
+
 bool
 raft_server_is_leader(void)
 {
-    struct raft_instance *ri = raft_net_get_instance();
-    return raft_instance_is_leader(ri);
+    return raft_server_is_leader_by_id(NULL);
 }
 
 /*
  * Allow the application to enqueue the request directly on the leader.
  * Application prepares the raft_client_rpc_msg structure and enqueues the
- * request directly on the leader.
+ * request directly on the leader.  The request is routed by its
+ * rcrm_raft_id, a null raft id selects the default instance.
  */
 int
 raft_server_enq_direct_raft_req_from_leader(char *req_buf, int64_t data_size)
@@ -6500,10 +12363,12 @@ raft_server_enq_direct_raft_req_from_leader(char *req_buf, int64_t data_size)
 
     struct raft_client_rpc_msg *rcm =
          (struct raft_client_rpc_msg *)req_buf;
-    struct raft_instance *ri = raft_net_get_instance();
+    struct raft_instance *ri = raft_server_instance_by_id(rcm->rcrm_raft_id);
+    if (!ri)
+        return -ENOENT;
 
     struct buffer_item *bi =
-       buffer_set_allocate_item(&ri->ri_buf_set[RAFT_BUF_SET_LARGE]);
+       buffer_set_allocate_item(raft_instance_buf_set(ri, RAFT_BUF_SET_LARGE));
 
     NIOVA_ASSERT(bi);
 
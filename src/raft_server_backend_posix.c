@@ -4,31 +4,84 @@
  * Written by Paul Nowoczynski <pauln@niova.io> 2020
  */
 
+#include <sys/mman.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <unistd.h>
 #include <fcntl.h>
+#if defined(HAVE_LIBURING)
+#include <liburing.h>
+#endif
 
 #include "alloc.h"
+#include "buffer.h"
 #include "common.h"
 #include "io.h"
 #include "log.h"
 #include "raft.h"
 #include "registry.h"
+#include "thread.h"
 
 #define RAFT_ENTRY_SIZE_POSIX 65536
 #define NUM_RAFT_LOG_HEADERS 2
 
+#define RSBP_URING_DEPTH RAFT_BS_IO_NBUF
+#define RSBP_URING_SYNC_TAG UINT64_MAX
+#define RSBP_URING_HDR_SYNC_TAG (UINT64_MAX - 1)
+#define RSBP_URING_HDR_WRITE_TAG (UINT64_MAX - 2)
+// Bounds the completion thread's response to a halt request
+#define RSBP_URING_WAIT_US 100000
+#define RSBP_DIRECT_IO_ALIGN 4096
+
 REGISTRY_ENTRY_FILE_GENERATE;
 
+#if defined(HAVE_LIBURING)
+/* The io_uring engine submits entry writes from the raft thread and reaps
+ * their completions on a dedicated thread.  Each in-flight write occupies a
+ * buffer taken from RAFT_BUF_SET_IO, so the buffer count also bounds the
+ * number of writes in flight.  Syncs are fsyncs submitted with
+ * IOSQE_IO_DRAIN which cover every write submitted ahead of them.
+ */
+struct rsbp_uring
+{
+    struct io_uring     rsu_ring;
+    pthread_mutex_t     rsu_mutex; // serializes submission and the below
+    pthread_cond_t      rsu_cond;
+    struct thread_ctl   rsu_cq_thread_ctl;
+    struct buffer_item *rsu_bufs[RSBP_URING_DEPTH];
+    raft_entry_idx_t    rsu_buf_idx[RSBP_URING_DEPTH]; // entry in flight
+    size_t              rsu_buf_len[RSBP_URING_DEPTH];
+    bool                rsu_buf_busy[RSBP_URING_DEPTH];
+    bool                rsu_bufs_fixed; // registered with the ring
+    bool                rsu_cq_thread_running;
+    int                 rsu_fd; // entry writes, may be O_DIRECT
+    size_t              rsu_nbufs;
+    size_t              rsu_ninflight;
+    size_t              rsu_nwrites;
+    size_t              rsu_ncq_batches;
+    unsigned long long  rsu_sync_submitted;
+    unsigned long long  rsu_sync_completed;
+    int                 rsu_sync_err;
+    int                 rsu_hdr_pending;
+    int                 rsu_hdr_write_res;
+    int                 rsu_hdr_sync_res;
+};
+
+typedef void *rsbp_uring_cq_thread_t;
+#endif
+
 struct raft_instance_posix
 {
-    struct stat rip_stb;
-    int         rip_fd;
+    struct stat        rip_stb;
+    int                rip_fd;
+#if defined(HAVE_LIBURING)
+    struct rsbp_uring *rip_uring;
+#endif
 };
 
 static void
-rsbp_entry_write(struct raft_instance *, const struct raft_entry *,
+rsbp_entry_write(struct raft_instance *, const struct raft_entry_header *,
+                 const struct iovec *, size_t,
                  const struct raft_net_sm_write_supplements *);
 
 static ssize_t
@@ -55,6 +108,11 @@ rsbp_destroy(struct raft_instance *);
 static int
 rsbp_sync(struct raft_instance *);
 
+static int
+rsbp_entry_scan(struct raft_instance *, const raft_entry_idx_t,
+                const raft_entry_idx_t, const bool, raft_entry_scan_cb_t,
+                void *);
+
 static struct raft_instance_backend ribPosix = {
     .rib_entry_write       = rsbp_entry_write,
     .rib_entry_read        = rsbp_entry_read,
@@ -65,6 +123,7 @@ static struct raft_instance_backend ribPosix = {
     .rib_backend_setup     = rsbp_setup,
     .rib_backend_shutdown  = rsbp_destroy,
     .rib_backend_sync      = rsbp_sync,
+    .rib_entry_scan        = rsbp_entry_scan,
 };
 
 static inline struct raft_instance_posix *
@@ -160,26 +219,467 @@ rsbr_raft_entry_header_to_phys_offset(const struct raft_instance *ri,
         (rsbr_raft_entry_header_to_phys_idx(ri, reh) * RAFT_ENTRY_SIZE_POSIX);
 }
 
+#if defined(HAVE_LIBURING)
+static bool
+rsbp_uring_idx_in_flight(const struct rsbp_uring *rsu,
+                         const raft_entry_idx_t idx)
+{
+    for (size_t i = 0; i < rsu->rsu_nbufs; i++)
+        if (rsu->rsu_buf_busy[i] && rsu->rsu_buf_idx[i] == idx)
+            return true;
+
+    return false;
+}
+
+static struct io_uring_sqe *
+rsbp_uring_get_sqe(struct rsbp_uring *rsu, const uint64_t tag)
+{
+    // Sqes are submitted as they're prepared so the queue never fills
+    struct io_uring_sqe *sqe = io_uring_get_sqe(&rsu->rsu_ring);
+    FATAL_IF((!sqe), "io_uring_get_sqe(): submission queue is full");
+
+    io_uring_sqe_set_data(sqe, (void *)(uintptr_t)tag);
+
+    return sqe;
+}
+
+static void
+rsbp_uring_submit(struct rsbp_uring *rsu, const int nsqes)
+{
+    int rc;
+
+    do
+    {
+        rc = io_uring_submit(&rsu->rsu_ring);
+    } while (rc == -EINTR || rc == -EAGAIN);
+
+    FATAL_IF((rc != nsqes), "io_uring_submit(): %s (rc=%d nsqes=%d)",
+             rc < 0 ? strerror(-rc) : "Success", rc, nsqes);
+}
+
+// Called with rsu_mutex held
+static void
+rsbp_uring_cqe_complete(struct rsbp_uring *rsu,
+                        const struct io_uring_cqe *cqe)
+{
+    const uint64_t tag = (uintptr_t)io_uring_cqe_get_data(cqe);
+
+    switch (tag)
+    {
+    case RSBP_URING_SYNC_TAG:
+        if (cqe->res < 0)
+            rsu->rsu_sync_err = cqe->res;
+
+        rsu->rsu_sync_completed++;
+        break;
+
+    case RSBP_URING_HDR_WRITE_TAG:
+        rsu->rsu_hdr_write_res = cqe->res;
+        rsu->rsu_hdr_pending--;
+        break;
+
+    case RSBP_URING_HDR_SYNC_TAG:
+        rsu->rsu_hdr_sync_res = cqe->res;
+        rsu->rsu_hdr_pending--;
+        break;
+
+    default:
+        NIOVA_ASSERT(tag < rsu->rsu_nbufs && rsu->rsu_buf_busy[tag]);
+
+        // Entry write failures are fatal, as they are with niova_io_pwrite()
+        FATAL_IF((cqe->res != (int)rsu->rsu_buf_len[tag]),
+                 "io_uring write idx=%ld: %s (rc=%d expected-size=%zu)",
+                 rsu->rsu_buf_idx[tag],
+                 cqe->res < 0 ? strerror(-cqe->res) : "Success", cqe->res,
+                 rsu->rsu_buf_len[tag]);
+
+        rsu->rsu_buf_busy[tag] = false;
+        rsu->rsu_ninflight--;
+        break;
+    }
+}
+
+/**
+ * rsbp_uring_cq_thread - reaps completions in batches and wakes the
+ *    threads waiting on a buffer, a sync, or an entry being read.
+ */
+static rsbp_uring_cq_thread_t
+rsbp_uring_cq_thread(void *arg)
+{
+    struct thread_ctl *tc = arg;
+    struct rsbp_uring *rsu = (struct rsbp_uring *)thread_ctl_get_arg(tc);
+
+    NIOVA_ASSERT(rsu);
+
+    THREAD_LOOP_WITH_CTL(tc)
+    {
+        struct __kernel_timespec kts = {
+            .tv_sec = 0,
+            .tv_nsec = RSBP_URING_WAIT_US * 1000,
+        };
+        struct io_uring_cqe *cqe = NULL;
+
+        // IORING_FEAT_EXT_ARG ensures this does not consume an sqe
+        int rc = io_uring_wait_cqe_timeout(&rsu->rsu_ring, &cqe, &kts);
+        if (rc) // -ETIME or -EINTR
+            continue;
+
+        struct io_uring_cqe *cqes[RSBP_URING_DEPTH * 2];
+        const unsigned int ncqes =
+            io_uring_peek_batch_cqe(&rsu->rsu_ring, cqes, ARRAY_SIZE(cqes));
+
+        niova_mutex_lock(&rsu->rsu_mutex);
+
+        for (unsigned int i = 0; i < ncqes; i++)
+            rsbp_uring_cqe_complete(rsu, cqes[i]);
+
+        rsu->rsu_ncq_batches++;
+
+        niova_mutex_unlock(&rsu->rsu_mutex);
+
+        io_uring_cq_advance(&rsu->rsu_ring, ncqes);
+        pthread_cond_broadcast(&rsu->rsu_cond);
+
+        DBG_THREAD_CTL(LL_TRACE, tc, "ncqes=%u", ncqes);
+    }
+
+    return (void *)0;
+}
+
+/**
+ * rsbp_uring_bufs_get - takes the write buffers from RAFT_BUF_SET_IO and
+ *    registers them with the ring.  This is done on the first entry write
+ *    since the buffer sets are initialized after the backend.  Unregistered
+ *    buffers are used if registration fails.
+ */
+static void
+rsbp_uring_bufs_get(struct raft_instance *ri, struct rsbp_uring *rsu)
+{
+    struct iovec iovs[RSBP_URING_DEPTH];
+
+    for (size_t i = 0; i < RSBP_URING_DEPTH; i++)
+    {
+        struct buffer_item *bi = buffer_set_allocate_item(
+            raft_instance_buf_set(ri, RAFT_BUF_SET_IO));
+        if (!bi)
+            break;
+
+        iovs[i].iov_base = bi->bi_iov.iov_base;
+        iovs[i].iov_len = bi->bi_bs->bs_item_size;
+
+        rsu->rsu_bufs[i] = bi;
+        rsu->rsu_nbufs++;
+    }
+
+    FATAL_IF((!rsu->rsu_nbufs), "RAFT_BUF_SET_IO has no free buffers");
+
+    int rc = io_uring_register_buffers(&rsu->rsu_ring, iovs, rsu->rsu_nbufs);
+
+    rsu->rsu_bufs_fixed = rc ? false : true;
+
+    DBG_RAFT_INSTANCE((rc ? LL_WARN : LL_NOTIFY), ri,
+                      "io_uring_register_buffers(nbufs=%zu): %s",
+                      rsu->rsu_nbufs, strerror(-rc));
+}
+
+/**
+ * rsbp_uring_entry_write - gathers the entry header and data fragments into
+ *    a free registered buffer and submits the write.  This is the only copy
+ *    made of the entry on its way to the device.
+ */
+static void
+rsbp_uring_entry_write(struct raft_instance *ri, struct rsbp_uring *rsu,
+                       const struct raft_entry_header *reh,
+                       const struct iovec *iov, const size_t niov,
+                       const size_t size, const off_t offset)
+{
+    if (!rsu->rsu_nbufs)
+        rsbp_uring_bufs_get(ri, rsu);
+
+    NIOVA_ASSERT(size <= rsu->rsu_bufs[0]->bi_bs->bs_item_size);
+
+    niova_mutex_lock(&rsu->rsu_mutex);
+
+    while (rsu->rsu_ninflight == rsu->rsu_nbufs)
+        pthread_cond_wait(&rsu->rsu_cond, &rsu->rsu_mutex);
+
+    size_t slot = 0;
+    while (rsu->rsu_buf_busy[slot])
+        slot++;
+
+    NIOVA_ASSERT(slot < rsu->rsu_nbufs);
+
+    char *buf = rsu->rsu_bufs[slot]->bi_iov.iov_base;
+    size_t len = size;
+
+    memcpy(buf, reh, sizeof(struct raft_entry));
+
+    for (size_t i = 0, off = sizeof(struct raft_entry); i < niov; i++)
+    {
+        memcpy(buf + off, iov[i].iov_base, iov[i].iov_len);
+        off += iov[i].iov_len;
+    }
+
+    // O_DIRECT requires the length to be block aligned
+    if (rsu->rsu_fd != rsbp_ri_to_rip(ri)->rip_fd)
+    {
+        len = (size + RSBP_DIRECT_IO_ALIGN - 1) & ~(RSBP_DIRECT_IO_ALIGN - 1);
+        memset(buf + size, 0, len - size);
+    }
+
+    struct io_uring_sqe *sqe = rsbp_uring_get_sqe(rsu, slot);
+
+    if (rsu->rsu_bufs_fixed)
+        io_uring_prep_write_fixed(sqe, rsu->rsu_fd, buf, len, offset, slot);
+    else
+        io_uring_prep_write(sqe, rsu->rsu_fd, buf, len, offset);
+
+    rsu->rsu_buf_busy[slot] = true;
+    rsu->rsu_buf_idx[slot] = reh->reh_index;
+    rsu->rsu_buf_len[slot] = len;
+    rsu->rsu_ninflight++;
+    rsu->rsu_nwrites++;
+
+    rsbp_uring_submit(rsu, 1);
+
+    niova_mutex_unlock(&rsu->rsu_mutex);
+
+    DBG_RAFT_ENTRY(LL_DEBUG, reh,
+                   "io_uring write submitted (len=%zu offset=%ld slot=%zu)",
+                   len, offset, slot);
+}
+
+static int
+rsbp_uring_sync(struct rsbp_uring *rsu, const int fd)
+{
+    niova_mutex_lock(&rsu->rsu_mutex);
+
+    struct io_uring_sqe *sqe = rsbp_uring_get_sqe(rsu, RSBP_URING_SYNC_TAG);
+
+    // The drain holds the fsync until the preceding writes have completed
+    io_uring_prep_fsync(sqe, fd, 0);
+    io_uring_sqe_set_flags(sqe, IOSQE_IO_DRAIN);
+
+    const unsigned long long ticket = ++rsu->rsu_sync_submitted;
+
+    rsbp_uring_submit(rsu, 1);
+
+    while (rsu->rsu_sync_completed < ticket)
+        pthread_cond_wait(&rsu->rsu_cond, &rsu->rsu_mutex);
+
+    int rc = rsu->rsu_sync_err;
+
+    niova_mutex_unlock(&rsu->rsu_mutex);
+
+    return rc;
+}
+
+/**
+ * rsbp_uring_header_write - writes a log header block with a linked fsync and
+ *    waits for both to complete.  Returns the result of the fsync while the
+ *    result of the write is placed into 'write_sz'.
+ */
+static int
+rsbp_uring_header_write(struct rsbp_uring *rsu, const int fd,
+                        const char *buf, const size_t len, const off_t offset,
+                        ssize_t *write_sz)
+{
+    niova_mutex_lock(&rsu->rsu_mutex);
+
+    NIOVA_ASSERT(!rsu->rsu_hdr_pending);
+
+    struct io_uring_sqe *sqe =
+        rsbp_uring_get_sqe(rsu, RSBP_URING_HDR_WRITE_TAG);
+
+    io_uring_prep_write(sqe, fd, buf, len, offset);
+    io_uring_sqe_set_flags(sqe, IOSQE_IO_DRAIN | IOSQE_IO_LINK);
+
+    sqe = rsbp_uring_get_sqe(rsu, RSBP_URING_HDR_SYNC_TAG);
+    io_uring_prep_fsync(sqe, fd, 0);
+
+    rsu->rsu_hdr_pending = 2;
+
+    rsbp_uring_submit(rsu, 2);
+
+    while (rsu->rsu_hdr_pending)
+        pthread_cond_wait(&rsu->rsu_cond, &rsu->rsu_mutex);
+
+    *write_sz = rsu->rsu_hdr_write_res;
+    int rc = rsu->rsu_hdr_sync_res;
+
+    niova_mutex_unlock(&rsu->rsu_mutex);
+
+    return rc;
+}
+
+// Waits for the in-flight write of entry 'idx', if any
+static void
+rsbp_uring_read_wait(struct rsbp_uring *rsu, const raft_entry_idx_t idx)
+{
+    niova_mutex_lock(&rsu->rsu_mutex);
+
+    while (rsbp_uring_idx_in_flight(rsu, idx))
+        pthread_cond_wait(&rsu->rsu_cond, &rsu->rsu_mutex);
+
+    niova_mutex_unlock(&rsu->rsu_mutex);
+}
+
+static void
+rsbp_uring_drain(struct rsbp_uring *rsu)
+{
+    niova_mutex_lock(&rsu->rsu_mutex);
+
+    while (rsu->rsu_ninflight)
+        pthread_cond_wait(&rsu->rsu_cond, &rsu->rsu_mutex);
+
+    niova_mutex_unlock(&rsu->rsu_mutex);
+}
+
 static void
-rsbp_entry_write(struct raft_instance *ri, const struct raft_entry *re,
+rsbp_uring_destroy(struct raft_instance *ri)
+{
+    struct raft_instance_posix *rip = rsbp_ri_to_rip(ri);
+    struct rsbp_uring *rsu = rip->rip_uring;
+
+    if (!rsu)
+        return;
+
+    if (rsu->rsu_cq_thread_running)
+    {
+        rsbp_uring_drain(rsu);
+
+        int rc = thread_halt_and_destroy(&rsu->rsu_cq_thread_ctl);
+
+        LOG_MSG(((rc && !ri->ri_startup_error) ? LL_WARN : LL_NOTIFY),
+                "thread_halt_and_destroy(): %s", strerror(-rc));
+    }
+
+    DBG_RAFT_INSTANCE(LL_NOTIFY, ri, "io_uring writes=%zu cq-batches=%zu",
+                      rsu->rsu_nwrites, rsu->rsu_ncq_batches);
+
+    if (rsu->rsu_bufs_fixed)
+        io_uring_unregister_buffers(&rsu->rsu_ring);
+
+    for (size_t i = 0; i < rsu->rsu_nbufs; i++)
+        buffer_set_release_item(rsu->rsu_bufs[i]);
+
+    io_uring_queue_exit(&rsu->rsu_ring);
+
+    if (rsu->rsu_fd >= 0 && rsu->rsu_fd != rip->rip_fd)
+        close(rsu->rsu_fd);
+
+    pthread_cond_destroy(&rsu->rsu_cond);
+    pthread_mutex_destroy(&rsu->rsu_mutex);
+
+    niova_free(rsu);
+    rip->rip_uring = NULL;
+}
+
+/**
+ * rsbp_uring_setup - creates the ring, the optional O_DIRECT descriptor, and
+ *    the completion thread.  IORING_FEAT_EXT_ARG is required so that the
+ *    completion thread's timed wait does not race with submission.
+ */
+static int
+rsbp_uring_setup(struct raft_instance *ri)
+{
+    struct raft_instance_posix *rip = rsbp_ri_to_rip(ri);
+
+    struct rsbp_uring *rsu = niova_calloc(1UL, sizeof(struct rsbp_uring));
+    if (!rsu)
+        return -ENOMEM;
+
+    struct io_uring_params params = {0};
+
+    int rc = io_uring_queue_init_params(RSBP_URING_DEPTH, &rsu->rsu_ring,
+                                        &params);
+    if (rc)
+    {
+        niova_free(rsu);
+        return rc;
+    }
+    else if (!(params.features & IORING_FEAT_EXT_ARG))
+    {
+        io_uring_queue_exit(&rsu->rsu_ring);
+        niova_free(rsu);
+        return -EOPNOTSUPP;
+    }
+
+    FATAL_IF((pthread_mutex_init(&rsu->rsu_mutex, NULL)),
+             "pthread_mutex_init(): %s", strerror(errno));
+
+    FATAL_IF((pthread_cond_init(&rsu->rsu_cond, NULL)),
+             "pthread_cond_init(): %s", strerror(errno));
+
+    rip->rip_uring = rsu;
+    rsu->rsu_fd = rip->rip_fd;
+
+    if (ri->ri_posix_o_direct)
+    {
+        rsu->rsu_fd = open(ri->ri_log, O_RDWR | O_DIRECT);
+        if (rsu->rsu_fd < 0)
+        {
+            rc = -errno;
+            SIMPLE_LOG_MSG(LL_ERROR, "open(`%s', O_DIRECT): %s", ri->ri_log,
+                           strerror(-rc));
+
+            rsbp_uring_destroy(ri);
+            return rc;
+        }
+    }
+
+    rc = thread_create_watched(rsbp_uring_cq_thread, &rsu->rsu_cq_thread_ctl,
+                               "uring_cq", (void *)rsu, NULL);
+    if (rc)
+    {
+        rsbp_uring_destroy(ri);
+        return rc;
+    }
+
+    rsu->rsu_cq_thread_running = true;
+    thread_ctl_run(&rsu->rsu_cq_thread_ctl);
+
+    DBG_RAFT_INSTANCE(LL_NOTIFY, ri, "io_uring engine enabled (o_direct=%s)",
+                      rsu->rsu_fd != rip->rip_fd ? "true" : "false");
+
+    return 0;
+}
+#endif
+
+static void
+rsbp_entry_write(struct raft_instance *ri, const struct raft_entry_header *reh,
+                 const struct iovec *iov, size_t niov,
                  const struct raft_net_sm_write_supplements *unused)
 {
-    NIOVA_ASSERT(ri && re);
+    NIOVA_ASSERT(ri && reh && (iov || !niov));
+    NIOVA_ASSERT(niov <= RAFT_ENTRY_WRITE_NIOV_MAX);
 
     (void)unused; // posix-backend does not support wr-supp
 
     struct raft_instance_posix *rip = rsbp_ri_to_rip(ri);
 
-    const size_t expected_size = raft_server_entry_to_total_size(re);
-    const off_t offset = rsbr_raft_entry_to_phys_offset(ri, re);
+    const size_t expected_size =
+        sizeof(struct raft_entry) + reh->reh_data_size;
+    const off_t offset = rsbr_raft_entry_header_to_phys_offset(ri, reh);
+
+#if defined(HAVE_LIBURING)
+    // Completion, including failure, is handled by rsbp_uring_cq_thread()
+    if (rip->rip_uring)
+    {
+        rsbp_uring_entry_write(ri, rip->rip_uring, reh, iov, niov,
+                               expected_size, offset);
+        return;
+    }
+#endif
 
     const ssize_t rrc =
-        niova_io_pwrite(rip->rip_fd, (const char *)re, expected_size, offset);
+        raft_server_entry_pwritev(rip->rip_fd, reh, iov, niov, offset);
 
     const bool write_ok = (rrc == (ssize_t)expected_size) ? true : false;
 
-    DBG_RAFT_ENTRY((write_ok ? LL_DEBUG : LL_ERROR), &re->re_header,
-                   "niova_io_pwrite() %s (rrc=%zd expected-size=%zu offset=%ld)",
+    DBG_RAFT_ENTRY((write_ok ? LL_DEBUG : LL_ERROR), reh,
+                   "raft_server_entry_pwritev() %s (rrc=%zd expected-size=%zu "
+                   "offset=%ld)",
                    rrc < 0 ? strerror(-rrc) : "Success", rrc, expected_size,
                    offset);
 
@@ -209,6 +709,11 @@ rsbp_read_common(struct raft_instance *ri, struct raft_entry *re,
     LOG_MSG(LL_DEBUG, "reh=%p reh-idx=%ld reh-data-size=%u total-sz=%zd",
             reh, reh->reh_index, reh->reh_data_size, expected_sz);
 
+#if defined(HAVE_LIBURING)
+    if (rip->rip_uring)
+        rsbp_uring_read_wait(rip->rip_uring, idx);
+#endif
+
     ssize_t read_sz = niova_io_pread(rip->rip_fd, (char *)reh, expected_sz,
                                rsbr_raft_entry_header_to_phys_offset(ri, reh));
 
@@ -258,6 +763,80 @@ rsbp_entry_header_read(struct raft_instance *ri, struct raft_entry_header *reh)
     return 0;
 }
 
+/**
+ * rsbp_entry_scan - maps the entries of [start, end) for sequential access
+ *    and passes each one to the callback straight from the mapping.  The
+ *    mapping is bounded by the file size since the final entry is not
+ *    padded out to RAFT_ENTRY_SIZE_POSIX.
+ */
+static int
+rsbp_entry_scan(struct raft_instance *ri, const raft_entry_idx_t start,
+                const raft_entry_idx_t end, const bool with_data,
+                raft_entry_scan_cb_t cb, void *arg)
+{
+    if (!ri || start < 0 || end < start || !cb)
+        return -EINVAL;
+
+    else if (start == end)
+        return 0;
+
+    struct raft_instance_posix *rip = rsbp_ri_to_rip(ri);
+
+#if defined(HAVE_LIBURING)
+    if (rip->rip_uring)
+        rsbp_uring_drain(rip->rip_uring);
+#endif
+
+    struct stat stb;
+    if (fstat(rip->rip_fd, &stb))
+        return -errno;
+
+    const off_t map_off = rsbr_raft_index_to_phys_offset(ri, start);
+    if (stb.st_size <= map_off)
+        return -ENOENT;
+
+    const size_t map_len = MIN((size_t)(stb.st_size - map_off),
+                               (size_t)(end - start) * RAFT_ENTRY_SIZE_POSIX);
+
+    char *map = mmap(NULL, map_len, PROT_READ, MAP_SHARED, rip->rip_fd,
+                     map_off);
+    if (map == MAP_FAILED)
+    {
+        int rc = -errno;
+        DBG_RAFT_INSTANCE(LL_ERROR, ri, "mmap(): %s", strerror(-rc));
+        return rc;
+    }
+
+    if (madvise(map, map_len, MADV_SEQUENTIAL))
+        DBG_RAFT_INSTANCE(LL_NOTIFY, ri, "madvise(): %s", strerror(errno));
+
+    int rc = 0;
+
+    for (raft_entry_idx_t i = start; i < end && !rc; i++)
+    {
+        const size_t off = (size_t)(i - start) * RAFT_ENTRY_SIZE_POSIX;
+        const size_t data_off = off + offsetof(struct raft_entry, re_data);
+
+        const struct raft_entry_header *reh =
+            (const struct raft_entry_header *)&map[off];
+
+        if (data_off > map_len ||
+            (with_data && data_off + reh->reh_data_size > map_len))
+        {
+            DBG_RAFT_INSTANCE(LL_ERROR, ri, "idx=%ld exceeds log-sz=%ld",
+                              i, stb.st_size);
+            rc = -EIO;
+            break;
+        }
+
+        rc = cb(arg, reh, with_data ? &map[data_off] : NULL);
+    }
+
+    munmap(map, map_len);
+
+    return rc;
+}
+
 static void
 rsbp_log_truncate(struct raft_instance *ri,
                   const raft_entry_idx_t entry_idx)
@@ -270,6 +849,11 @@ rsbp_log_truncate(struct raft_instance *ri,
     DBG_RAFT_INSTANCE(LL_DEBUG, ri, "trunc-off=%ld entry-idx=%ld",
                       trunc_off, entry_idx);
 
+#if defined(HAVE_LIBURING)
+    if (rip->rip_uring)
+        rsbp_uring_drain(rip->rip_uring);
+#endif
+
     int rc = niova_io_ftruncate(rip->rip_fd, trunc_off);
     FATAL_IF((rc), "niova_io_ftruncate(): %s", strerror(-rc));
 
@@ -386,16 +970,30 @@ rsbp_header_write(struct raft_instance *ri)
                                           (const char *)&ri->ri_log_hdr,
                                           len);
 
-    const ssize_t write_sz =
-        niova_io_pwrite(rip->rip_fd, (const char *)&entry_and_header,
-                  raft_server_entry_to_total_size(re),
-                  rsbr_raft_entry_to_phys_offset(ri, re));
+    ssize_t write_sz;
+    int sync_rc;
+
+#if defined(HAVE_LIBURING)
+    if (rip->rip_uring)
+    {
+        sync_rc = rsbp_uring_header_write(
+            rip->rip_uring, rip->rip_fd, (const char *)&entry_and_header,
+            raft_server_entry_to_total_size(re),
+            rsbr_raft_entry_to_phys_offset(ri, re), &write_sz);
+    }
+    else
+#endif
+    {
+        write_sz =
+            niova_io_pwrite(rip->rip_fd, (const char *)&entry_and_header,
+                            raft_server_entry_to_total_size(re),
+                            rsbr_raft_entry_to_phys_offset(ri, re));
+        sync_rc = rsbp_sync(ri);
+    }
 
     int rc = (write_sz == (ssize_t)raft_server_entry_to_total_size(re)) ?
         0 : -EIO;
 
-    int sync_rc = rsbp_sync(ri);
-
     DBG_RAFT_ENTRY(
         ((rc || sync_rc) ? LL_ERROR : LL_DEBUG), &re->re_header,
         "niova_io_pwrite(): %s:%s (rrc=%zd expected-sz=%zu off=%ld)",
@@ -549,6 +1147,10 @@ rsbp_destroy(struct raft_instance *ri)
     if (!ri)
         return -EINVAL;
 
+#if defined(HAVE_LIBURING)
+    rsbp_uring_destroy(ri);
+#endif
+
     int rc = rsbp_log_file_close(ri);
 
     niova_free(ri->ri_backend_arg);
@@ -565,6 +1167,11 @@ rsbp_sync(struct raft_instance *ri)
 
     struct raft_instance_posix *rip = rsbp_ri_to_rip(ri);
 
+#if defined(HAVE_LIBURING)
+    if (rip->rip_uring)
+        return rsbp_uring_sync(rip->rip_uring, rip->rip_fd);
+#endif
+
     int rc = niova_io_fsync(rip->rip_fd);
     if (rc < 0)
         rc = -errno;
@@ -607,6 +1214,20 @@ rsbp_setup(struct raft_instance *ri)
         return rc;
     }
 
+    if (ri->ri_posix_io_uring && !raft_server_does_synchronous_writes(ri))
+    {
+#if defined(HAVE_LIBURING)
+        rc = rsbp_uring_setup(ri);
+        if (rc)
+            DBG_RAFT_INSTANCE(LL_WARN, ri,
+                              "rsbp_uring_setup(): %s, using blocking io",
+                              strerror(-rc));
+#else
+        DBG_RAFT_INSTANCE(LL_WARN, ri,
+                          "built without liburing, using blocking io");
+#endif
+    }
+
     rsbp_set_db_uuid(ri);
 
     return 0;
@@ -5,7 +5,9 @@
  */
 
 #include <sys/types.h>
+#include <sys/socket.h>
 #include <sys/stat.h>
+#include <sys/time.h>
 
 #include <fcntl.h> // Must precede dirent.h
 #ifndef __USE_GNU // scandirat
@@ -25,8 +27,8 @@
 #include "common.h"
 #include "ctl_svc.h"
 #include "file_util.h"
+#include "io.h"
 #include "log.h"
-#include "popen_cmd.h"
 #include "raft.h"
 #include "raft_server_backend_rocksdb.h"
 #include "regex_defines.h"
@@ -38,9 +40,8 @@
 // Can become a tunable in the future
 #define RAFT_ENTRY_SIZE_ROCKSDB (4 * 1024 * 1024)
 
-#define RAFT_LOG_HEADER_ROCKSDB "a0_hdr."
-#define RAFT_LOG_HEADER_ROCKSDB_STRLEN 7
-#define RAFT_LOG_HEADER_FMT RAFT_LOG_HEADER_ROCKSDB"%s__%s"
+// Iterator readahead used by the startup entry scan
+#define RSBR_SCAN_READAHEAD_SZ (2UL * 1024 * 1024)
 
 #define RAFT_LOG_HEADER_ROCKSDB_END "a1_hdr."
 #define RAFT_LOG_HEADER_ROCKSDB_END_STRLEN 7
@@ -60,22 +61,16 @@
 #define RAFT_LOG_HEADER_UUID_PRE_RECOVERY_STRLEN \
     (RAFT_LOG_HEADER_UUID_STRLEN + 13)
 
-#define RAFT_LOG_LASTENTRY_ROCKSDB "z0_last."
-#define RAFT_LOG_LASTENTRY_ROCKSDB_STRLEN 8
-#define RAFT_LOG_LASTENTRY_FMT RAFT_LOG_LASTENTRY_ROCKSDB"%s__%s"
-
-#define RAFT_HEADER_ENTRY_KEY_FMT "%016zuh"
-#define RAFT_ENTRY_KEY_FMT        "%016zue"
-
-#define RAFT_ENTRY_KEY_PREFIX_ROCKSDB "e0."
-#define RAFT_ENTRY_KEY_PREFIX_ROCKSDB_STRLEN 3
-#define RAFT_ENTRY_KEY_PRINTF RAFT_ENTRY_KEY_PREFIX_ROCKSDB RAFT_ENTRY_KEY_FMT
-
-#define RAFT_ENTRY_HEADER_KEY_PREFIX_ROCKSDB RAFT_ENTRY_KEY_PREFIX_ROCKSDB
-#define RAFT_ENTRY_HEADER_KEY_PREFIX_ROCKSDB_STRLEN \
-    RAFT_ENTRY_KEY_PREFIX_ROCKSDB_STRLEN
-#define RAFT_ENTRY_HEADER_KEY_PRINTF \
-    RAFT_ENTRY_KEY_PREFIX_ROCKSDB RAFT_HEADER_ENTRY_KEY_FMT
+/* Declares 'name' and 'name_len' holding the entry (or entry header) key for
+ * 'idx' in the key format of this db.
+ */
+#define RSBR_DECL_ENTRY_KEY(rir, name, idx, header)                     \
+    char name[RAFT_ROCKSDB_KEY_LEN_MAX];                                \
+    const size_t name##_len =                                           \
+        raft_rocksdb_entry_key_build(name, RAFT_ROCKSDB_KEY_LEN_MAX,    \
+                                     (idx), (header),                   \
+                                     (rir)->rir_binary_entry_keys);     \
+    NIOVA_ASSERT(name##_len)
 
 /* The recovery marker filename will appear as
  * ".recovery_marker.<peer-uuid>_<db-uuid>"
@@ -85,25 +80,9 @@
     "^"RECOVERY_MARKER_NAME"\\."UUID_REGEX_BASE"_"UUID_REGEX_BASE"$"
 #define RECOVERY_MARKER_NAME_LEN 22
 
-/* Rsync related regex's
- */
-#define RECOVERY_RSYNC_TOTAL_SIZE_REGEX \
-    "Total file size: "COMMA_DELIMITED_UNSIGNED_INTEGER_BASE" bytes"
-#define RECOVERY_RSYNC_TOTAL_XFER_SIZE_REGEX \
-    "Total transferred file size: "COMMA_DELIMITED_UNSIGNED_INTEGER_BASE" bytes"
-#define RECOVERY_RSYNC_PROGRESS_LINE_RATE_REGEX \
-    "[0-9]\\+.[0-9][0-9][KMGTkmgt]B/s"
-
-#define RECOVERY_RSYNC_PROGRESS_LINE_REGEX \
-    "[\r][ \t]*"COMMA_DELIMITED_UNSIGNED_INTEGER_BASE"[ \t]*[0-9]\\{1,3\\}%[ \t]*"RECOVERY_RSYNC_PROGRESS_LINE_RATE_REGEX
-
 enum recovery_regexes
 {
     RECOVERY_MARKER_NAME__regex,
-    RECOVERY_RSYNC_TOTAL_SIZE__regex,
-    RECOVERY_RSYNC_TOTAL_XFER_SIZE__regex,
-    RECOVERY_RSYNC_PROGRESS_LINE__regex,
-    RECOVERY_RSYNC_PROGRESS_LINE_RATE__regex,
     RECOVERY_CHKPT_DIRNAME__regex,
     RECOVERY__num_regex,
 };
@@ -116,10 +95,6 @@ struct regex_pair
 
 struct regex_pair recoveryRegexes[RECOVERY__num_regex] = {
     { .rp_regex_str = RECOVERY_MARKER_REGEX },
-    { .rp_regex_str = RECOVERY_RSYNC_TOTAL_SIZE_REGEX },
-    { .rp_regex_str = RECOVERY_RSYNC_TOTAL_XFER_SIZE_REGEX },
-    { .rp_regex_str = RECOVERY_RSYNC_PROGRESS_LINE_REGEX },
-    { .rp_regex_str = RECOVERY_RSYNC_PROGRESS_LINE_RATE_REGEX },
     { .rp_regex_str = RAFT_CHECKPOINT_DIRNAME },
 };
 
@@ -135,6 +110,8 @@ struct raft_instance_rocks_db
     rocksdb_readoptions_t               *rir_readoptions;
     rocksdb_writebatch_t                *rir_writebatch;
     struct raft_server_rocksdb_cf_table *rir_cf_table;
+    bool                                 rir_binary_entry_keys;
+    bool                                 rir_single_kv_entries;
 };
 
 void
@@ -145,7 +122,8 @@ rsbr_compile_time_asserts(void)
 }
 
 static void
-rsbr_entry_write(struct raft_instance *, const struct raft_entry *,
+rsbr_entry_write(struct raft_instance *, const struct raft_entry_header *,
+                 const struct iovec *, size_t,
                  const struct raft_net_sm_write_supplements *);
 
 static ssize_t
@@ -154,6 +132,18 @@ rsbr_entry_read(struct raft_instance *, struct raft_entry *);
 static int
 rsbr_entry_header_read(struct raft_instance *, struct raft_entry_header *);
 
+static int
+rsbr_entry_read_view(struct raft_instance *, const struct raft_entry_header *,
+                     struct raft_entry_view *);
+
+static void
+rsbr_entry_view_release(struct raft_instance *, struct raft_entry_view *);
+
+static int
+rsbr_entry_scan(struct raft_instance *, const raft_entry_idx_t,
+                const raft_entry_idx_t, const bool, raft_entry_scan_cb_t,
+                void *);
+
 static void
 rsbr_log_truncate(struct raft_instance *, const raft_entry_idx_t);
 
@@ -185,14 +175,23 @@ rsbr_checkpoint(struct raft_instance *);
 static int
 rsbr_bulk_recover(struct raft_instance *);
 
+static int
+rsbr_chkpt_xfer_read(struct raft_instance *,
+                     const struct raft_chkpt_xfer_request_msg *,
+                     struct raft_chkpt_xfer_reply_msg *, char *, size_t);
+
 static struct raft_instance_backend ribRocksDB = {
     .rib_backend_checkpoint = rsbr_checkpoint,
     .rib_backend_recover    = rsbr_bulk_recover,
     .rib_backend_setup      = rsbr_setup,
     .rib_backend_shutdown   = rsbr_destroy,
     .rib_backend_sync       = rsbr_sync,
+    .rib_chkpt_xfer_read    = rsbr_chkpt_xfer_read,
     .rib_entry_header_read  = rsbr_entry_header_read,
     .rib_entry_read         = rsbr_entry_read,
+    .rib_entry_read_view    = rsbr_entry_read_view,
+    .rib_entry_scan         = rsbr_entry_scan,
+    .rib_entry_view_release = rsbr_entry_view_release,
     .rib_entry_write        = rsbr_entry_write,
     .rib_header_load        = rsbr_header_load,
     .rib_header_write       = rsbr_header_write,
@@ -477,36 +476,40 @@ rsbr_write_supplements_put(const struct raft_net_sm_write_supplements *ws,
     if (!ws || !wb)
         return;
 
-    for (size_t i = 0; i < ws->rnsws_nitems; i++)
+    const struct raft_net_wr_supp_seg *seg;
+    RAFT_NET_SM_WRITE_SUPP_SEG_FOREACH(ws, seg)
     {
-        const struct raft_net_wr_supp *supp = &ws->rnsws_ws[i];
-
-        switch (supp->rnws_op) {
-        case RAFT_NET_WR_SUPP_OP_DELETE:
-            if (supp->rnws_handle)
-                rocksdb_writebatch_delete_cf(wb, 
-                                             (rocksdb_column_family_handle_t *)supp->rnws_handle,
-                                             (const char *)supp->rnws_key,
-                                             supp->rnws_key_size);
-            else
-                rocksdb_writebatch_delete(wb, (const char *)supp->rnws_key, supp->rnws_key_size);
-            break;
-
-        case RAFT_NET_WR_SUPP_OP_WRITE:
-            if (supp->rnws_handle)
-                rocksdb_writebatch_put_cf(wb, 
-                                          (rocksdb_column_family_handle_t *)supp->rnws_handle,
-                                          (const char *)supp->rnws_key,
-                                          supp->rnws_key_size,
-                                          (const char *)supp->rnws_value,
-                                          supp->rnws_value_size);
-            else
-                rocksdb_writebatch_put(wb, (const char *)supp->rnws_key, supp->rnws_key_size,
-                                       (const char *)supp->rnws_value, supp->rnws_value_size);
-            break;
-        default:
-            SIMPLE_LOG_MSG(LL_ERROR, "unknown rnws_op=%d", supp->rnws_op);
-            break;
+        for (size_t i = 0; i < seg->rnwss_nitems; i++)
+        {
+            const struct raft_net_wr_supp *supp = &seg->rnwss_items[i];
+
+            switch (supp->rnws_op) {
+            case RAFT_NET_WR_SUPP_OP_DELETE:
+                if (supp->rnws_handle)
+                    rocksdb_writebatch_delete_cf(wb, 
+                                                 (rocksdb_column_family_handle_t *)supp->rnws_handle,
+                                                 (const char *)supp->rnws_key,
+                                                 supp->rnws_key_size);
+                else
+                    rocksdb_writebatch_delete(wb, (const char *)supp->rnws_key, supp->rnws_key_size);
+                break;
+
+            case RAFT_NET_WR_SUPP_OP_WRITE:
+                if (supp->rnws_handle)
+                    rocksdb_writebatch_put_cf(wb, 
+                                              (rocksdb_column_family_handle_t *)supp->rnws_handle,
+                                              (const char *)supp->rnws_key,
+                                              supp->rnws_key_size,
+                                              (const char *)supp->rnws_value,
+                                              supp->rnws_value_size);
+                else
+                    rocksdb_writebatch_put(wb, (const char *)supp->rnws_key, supp->rnws_key_size,
+                                           (const char *)supp->rnws_value, supp->rnws_value_size);
+                break;
+            default:
+                SIMPLE_LOG_MSG(LL_ERROR, "unknown rnws_op=%d", supp->rnws_op);
+                break;
+            }
         }
     }
 }
@@ -612,9 +615,48 @@ rsbr_sm_apply_opt(struct raft_instance *ri,
     rocksdb_writebatch_clear(rir->rir_writebatch);
 }
 
+/**
+ * rsbr_entry_value_pin - looks up the value stored under the entry key of
+ *    'idx' without copying it out of rocksdb.  The caller must destroy the
+ *    returned slice.
+ */
+static int
+rsbr_entry_value_pin(struct raft_instance_rocks_db *rir,
+                     const raft_entry_idx_t idx,
+                     rocksdb_pinnableslice_t **ret_pslice,
+                     const char **ret_val, size_t *ret_val_len)
+{
+    if (!rir || idx < 0 || !ret_pslice || !ret_val || !ret_val_len)
+        return -EINVAL;
+
+    RSBR_DECL_ENTRY_KEY(rir, entry_key, idx, false);
+
+    char *err = NULL;
+    rocksdb_pinnableslice_t *pslice =
+        rocksdb_get_pinned(rir->rir_db, rir->rir_readoptions, entry_key,
+                           entry_key_len, &err);
+
+    if (err || !pslice)
+    {
+        LOG_MSG(LL_ERROR, "rocksdb_get_pinned(idx=%ld): %s", idx,
+                err ? err : "not found");
+
+        if (pslice)
+            rocksdb_pinnableslice_destroy(pslice);
+
+        return -ENOENT;
+    }
+
+    *ret_val = rocksdb_pinnableslice_value(pslice, ret_val_len);
+    *ret_pslice = pslice;
+
+    return 0;
+}
+
 /**
  * rsbr_entry_header_write_recovery_scrub - this function writes
  *    a header independently from its entry.  It is only used by recovery.
+ *    Single KV entries have their value rewritten with the new header.
  */
 static void
 rsbr_entry_header_write_recovery_scrub(struct raft_instance *ri,
@@ -628,15 +670,48 @@ rsbr_entry_header_write_recovery_scrub(struct raft_instance *ri,
 
     rocksdb_writebatch_clear(rir->rir_writebatch);
 
-    size_t entry_header_key_len = 0;
-    DECL_AND_FMT_STRING_RET_LEN(entry_header_key,
-                                (ssize_t)RAFT_ROCKSDB_KEY_LEN_MAX,
-                                (ssize_t *)&entry_header_key_len,
-                                RAFT_ENTRY_HEADER_KEY_PRINTF, entry_idx);
+    if (rir->rir_single_kv_entries)
+    {
+        /* The header shares its value with the entry data so the value is
+         * rewritten with the new header placed ahead of the existing data.
+         */
+        rocksdb_pinnableslice_t *pslice = NULL;
+        const char *val = NULL;
+        size_t val_len = 0;
+
+        int rc = rsbr_entry_value_pin(rir, entry_idx, &pslice, &val,
+                                      &val_len);
+
+        DBG_RAFT_INSTANCE_FATAL_IF(
+            (rc || val_len < sizeof(struct raft_entry_header)), ri,
+            "rsbr_entry_value_pin(idx=%ld): %s (val-len=%zu)",
+            entry_idx, strerror(-rc), val_len);
+
+        RSBR_DECL_ENTRY_KEY(rir, entry_key, entry_idx, false);
+
+        const char *key_list[1] = {entry_key};
+        const size_t key_sizes[1] = {entry_key_len};
+        const char *val_list[2] = {
+            (const char *)reh, val + sizeof(struct raft_entry_header)};
+        const size_t val_sizes[2] = {
+            sizeof(struct raft_entry_header),
+            val_len - sizeof(struct raft_entry_header)};
+
+        // The writebatch takes a copy so the slice may be released here
+        rocksdb_writebatch_putv(rir->rir_writebatch, 1, key_list, key_sizes,
+                                2, val_list, val_sizes);
+
+        rocksdb_pinnableslice_destroy(pslice);
+    }
+    else
+    {
+        RSBR_DECL_ENTRY_KEY(rir, entry_header_key, entry_idx, true);
+
+        rocksdb_writebatch_put(rir->rir_writebatch, entry_header_key,
+                               entry_header_key_len, (const char *)reh,
+                               sizeof(struct raft_entry_header));
+    }
 
-    rocksdb_writebatch_put(rir->rir_writebatch, entry_header_key,
-                           entry_header_key_len, (const char *)reh,
-                           sizeof(struct raft_entry_header));
     char *err = NULL;
 
     rocksdb_write(rir->rir_db, rir->rir_writeoptions_async,
@@ -648,46 +723,73 @@ rsbr_entry_header_write_recovery_scrub(struct raft_instance *ri,
 }
 
 static void
-rsbr_entry_write(struct raft_instance *ri, const struct raft_entry *re,
+rsbr_entry_write(struct raft_instance *ri, const struct raft_entry_header *reh,
+                 const struct iovec *iov, size_t niov,
                  const struct raft_net_sm_write_supplements *ws)
 {
-    NIOVA_ASSERT(ri && re && re->re_header.reh_index >= 0);
+    NIOVA_ASSERT(ri && reh && reh->reh_index >= 0 && (iov || !niov));
+    NIOVA_ASSERT(niov <= RAFT_ENTRY_WRITE_NIOV_MAX);
 
-    size_t entry_size = re->re_header.reh_data_size;
-    raft_entry_idx_t entry_idx = re->re_header.reh_index;
+    const size_t entry_size = reh->reh_data_size;
+    raft_entry_idx_t entry_idx = reh->reh_index;
 
     struct raft_instance_rocks_db *rir = rsbr_ri_to_rirdb(ri);
 
     rocksdb_writebatch_clear(rir->rir_writebatch);
 
-    /* There are 2 items to write here:
-     * 1) raft entry header KV
-     * 2) raft entry KV
+    RSBR_DECL_ENTRY_KEY(rir, entry_key, entry_idx, false);
+
+    /* The value is described as slice parts so that rocksdb gathers the
+     * header and data fragments directly into the writebatch.  Slot 0 is
+     * reserved for the header in the single KV layout.
      */
-    size_t entry_header_key_len = 0;
-    DECL_AND_FMT_STRING_RET_LEN(entry_header_key,
-                                (ssize_t)RAFT_ROCKSDB_KEY_LEN_MAX,
-                                (ssize_t *)&entry_header_key_len,
-                                RAFT_ENTRY_HEADER_KEY_PRINTF, entry_idx);
-
-    rocksdb_writebatch_put(rir->rir_writebatch, entry_header_key,
-                           entry_header_key_len, (const char *)&re->re_header,
-                           sizeof(struct raft_entry_header));
-
-    size_t entry_key_len = 0;
-    DECL_AND_FMT_STRING_RET_LEN(entry_key,
-                                (ssize_t)RAFT_ROCKSDB_KEY_LEN_MAX,
-                                (ssize_t *)&entry_key_len,
-                                RAFT_ENTRY_KEY_PRINTF, entry_idx);
-
-    // Store an entry for every header, even if the entry is empty.
-    const char x = '\0';
-    const char *entry_val = entry_size ? re->re_data : &x;
-    if (!entry_size)
-        entry_size = 1;
-
-    rocksdb_writebatch_put(rir->rir_writebatch, entry_key, entry_key_len,
-                           entry_val, entry_size);
+    const char *val_list[RAFT_ENTRY_WRITE_NIOV_MAX + 1];
+    size_t val_sizes[RAFT_ENTRY_WRITE_NIOV_MAX + 1];
+    int nvals = 1;
+
+    val_list[0] = (const char *)reh;
+    val_sizes[0] = sizeof(struct raft_entry_header);
+
+    for (size_t i = 0; i < niov; i++)
+    {
+        if (!iov[i].iov_len)
+            continue;
+
+        val_list[nvals] = (const char *)iov[i].iov_base;
+        val_sizes[nvals] = iov[i].iov_len;
+        nvals++;
+    }
+
+    const char *key_list[1] = {entry_key};
+    const size_t key_sizes[1] = {entry_key_len};
+
+    if (rir->rir_single_kv_entries)
+    {
+        rocksdb_writebatch_putv(rir->rir_writebatch, 1, key_list, key_sizes,
+                                nvals, val_list, val_sizes);
+    }
+    else
+    {
+        /* There are 2 items to write here:
+         * 1) raft entry header KV
+         * 2) raft entry KV
+         */
+        RSBR_DECL_ENTRY_KEY(rir, entry_header_key, entry_idx, true);
+
+        rocksdb_writebatch_put(rir->rir_writebatch, entry_header_key,
+                               entry_header_key_len, (const char *)reh,
+                               sizeof(struct raft_entry_header));
+
+        // Store an entry for every header, even if the entry is empty.
+        const char x = '\0';
+        if (!entry_size)
+            rocksdb_writebatch_put(rir->rir_writebatch, entry_key,
+                                   entry_key_len, &x, 1);
+        else
+            rocksdb_writebatch_putv(rir->rir_writebatch, 1, key_list,
+                                    key_sizes, nvals - 1, &val_list[1],
+                                    &val_sizes[1]);
+    }
 
     // Attach any supplemental writes to the rocksdb-writebatch
     rsbr_write_supplements_put(ws, rir->rir_writebatch);
@@ -761,6 +863,54 @@ rsbr_get_exact_val_size(struct raft_instance_rocks_db *rir,
     return 0;
 }
 
+/**
+ * rsbr_entry_single_kv_read - reads the header, and the data if 'data' is
+ *    non-NULL, of a single KV entry with one lookup.  A header-only read
+ *    copies just the prefix of the pinned value.
+ */
+static int
+rsbr_entry_single_kv_read(struct raft_instance_rocks_db *rir,
+                          struct raft_entry_header *reh, char *data)
+{
+    NIOVA_ASSERT(rir && rir->rir_single_kv_entries && reh);
+
+    rocksdb_pinnableslice_t *pslice = NULL;
+    const char *val = NULL;
+    size_t val_len = 0;
+
+    int rc = rsbr_entry_value_pin(rir, reh->reh_index, &pslice, &val,
+                                  &val_len);
+    if (rc)
+        return rc;
+
+    const raft_entry_idx_t idx = reh->reh_index;
+
+    if (val_len < sizeof(struct raft_entry_header))
+    {
+        rc = -EMSGSIZE;
+    }
+    else
+    {
+        memcpy(reh, val, sizeof(struct raft_entry_header));
+
+        const size_t data_len = val_len - sizeof(struct raft_entry_header);
+
+        if (data_len != reh->reh_data_size)
+            rc = data_len > reh->reh_data_size ? -ENOSPC : -EMSGSIZE;
+
+        else if (data)
+            memcpy(data, val + sizeof(struct raft_entry_header), data_len);
+    }
+
+    rocksdb_pinnableslice_destroy(pslice);
+
+    if (rc)
+        LOG_MSG(LL_ERROR, "idx=%ld val-len=%zu: %s", idx, val_len,
+                strerror(-rc));
+
+    return rc;
+}
+
 static int
 rsbr_entry_header_read(struct raft_instance *ri, struct raft_entry_header *reh)
 {
@@ -769,19 +919,18 @@ rsbr_entry_header_read(struct raft_instance *ri, struct raft_entry_header *reh)
 
     struct raft_instance_rocks_db *rir = rsbr_ri_to_rirdb(ri);
 
-    size_t entry_header_key_len = 0;
-    DECL_AND_FMT_STRING_RET_LEN(entry_header_key,
-                                (ssize_t)RAFT_ROCKSDB_KEY_LEN_MAX,
-                                (ssize_t *)&entry_header_key_len,
-                                RAFT_ENTRY_HEADER_KEY_PRINTF, reh->reh_index);
+    if (rir->rir_single_kv_entries)
+        return rsbr_entry_single_kv_read(rir, reh, NULL);
+
+    RSBR_DECL_ENTRY_KEY(rir, entry_header_key, reh->reh_index, true);
 
     int rc = rsbr_get_exact_val_size(rir, entry_header_key,
                                      entry_header_key_len,
                                      (void *)reh,
                                      sizeof(struct raft_entry_header));
     if (rc)
-        LOG_MSG(LL_ERROR, "rsbr_get_exact_val_size('%s'): %s",
-                entry_header_key, strerror(rc));
+        LOG_MSG(LL_ERROR, "rsbr_get_exact_val_size(hdr-idx=%ld): %s",
+                reh->reh_index, strerror(rc));
 
     return rc;
 }
@@ -792,25 +941,26 @@ rsbr_entry_read(struct raft_instance *ri, struct raft_entry *re)
     if (!ri || !re)
         return -EINVAL;
 
-    // XXx if the caller has already obtained the header then bypass this read
-    int rc = rsbr_entry_header_read(ri, &re->re_header);
+    struct raft_instance_rocks_db *rir = rsbr_ri_to_rirdb(ri);
+
+    int rc = rir->rir_single_kv_entries ?
+        rsbr_entry_single_kv_read(rir, &re->re_header, re->re_data) :
+        rsbr_entry_header_read(ri, &re->re_header);
+
     if (rc)
         return rc;
+    else if (rir->rir_single_kv_entries)
+        return (ssize_t)(re->re_header.reh_data_size +
+                         sizeof(struct raft_entry_header));
 
-    struct raft_instance_rocks_db *rir = rsbr_ri_to_rirdb(ri);
-
-    size_t entry_key_len = 0;
-    DECL_AND_FMT_STRING_RET_LEN(entry_key, (ssize_t)RAFT_ROCKSDB_KEY_LEN_MAX,
-                                (ssize_t *)&entry_key_len,
-                                RAFT_ENTRY_KEY_PRINTF,
-                                re->re_header.reh_index);
+    RSBR_DECL_ENTRY_KEY(rir, entry_key, re->re_header.reh_index, false);
 
     rc = rsbr_get_exact_val_size(rir, entry_key, entry_key_len,
                                  (void *)re->re_data,
                                  re->re_header.reh_data_size);
     if (rc)
-        LOG_MSG(LL_ERROR, "rsbr_get_exact_val_size('%s'): %s",
-                entry_key, strerror(rc));
+        LOG_MSG(LL_ERROR, "rsbr_get_exact_val_size(idx=%ld): %s",
+                re->re_header.reh_index, strerror(rc));
 
     return rc < 0 ? rc :
         (ssize_t)(re->re_header.reh_data_size +
@@ -818,6 +968,231 @@ rsbr_entry_read(struct raft_instance *ri, struct raft_entry *re)
 //Xxx this is wonky
 }
 
+/**
+ * rsbr_entry_read_view - looks up the entry's data with a pinnable slice so
+ *    that it may be consumed from rocksdb's memory without a malloc and copy.
+ *    Empty entries, which are stored as a single byte, produce an empty view.
+ *    With single KV entries the view starts just past the stored header.
+ */
+static int
+rsbr_entry_read_view(struct raft_instance *ri,
+                     const struct raft_entry_header *reh,
+                     struct raft_entry_view *rev)
+{
+    if (!ri || !reh || !rev || reh->reh_index < 0)
+        return -EINVAL;
+
+    if (!reh->reh_data_size)
+        return 0;
+
+    struct raft_instance_rocks_db *rir = rsbr_ri_to_rirdb(ri);
+
+    rocksdb_pinnableslice_t *pslice = NULL;
+    const char *val = NULL;
+    size_t val_len = 0;
+
+    int rc = rsbr_entry_value_pin(rir, reh->reh_index, &pslice, &val,
+                                  &val_len);
+    if (rc)
+        return rc;
+
+    if (rir->rir_single_kv_entries)
+    {
+        if (val_len != sizeof(struct raft_entry_header) + reh->reh_data_size)
+        {
+            LOG_MSG(LL_ERROR, "idx=%ld val-len=%zu, expected %zu",
+                    reh->reh_index, val_len,
+                    sizeof(struct raft_entry_header) + reh->reh_data_size);
+
+            rocksdb_pinnableslice_destroy(pslice);
+            return -EMSGSIZE;
+        }
+
+        val += sizeof(struct raft_entry_header);
+        val_len -= sizeof(struct raft_entry_header);
+    }
+
+    rev->rev_data = val;
+    rev->rev_size = val_len;
+    rev->rev_handle = pslice;
+
+    return 0;
+}
+
+static void
+rsbr_entry_view_release(struct raft_instance *ri, struct raft_entry_view *rev)
+{
+    if (!ri || !rev || !rev->rev_handle)
+        return;
+
+    rocksdb_pinnableslice_destroy((rocksdb_pinnableslice_t *)rev->rev_handle);
+
+    rev->rev_handle = NULL;
+}
+
+/**
+ * rsbr_log_version_apply - sets the entry key format and entry layout which
+ *    correspond to the log header version.
+ */
+static void
+rsbr_log_version_apply(struct raft_instance_rocks_db *rir,
+                       const uint64_t version)
+{
+    NIOVA_ASSERT(rir && version < RAFT_ROCKSDB_LOG_VERSION_MAX);
+
+    rir->rir_binary_entry_keys =
+        version >= RAFT_ROCKSDB_LOG_VERSION_BINARY_KEYS ? true : false;
+
+    rir->rir_single_kv_entries =
+        version == RAFT_ROCKSDB_LOG_VERSION_SINGLE_KV ? true : false;
+}
+
+/**
+ * rsbr_entry_scan - walks the entry keys of [start, end) with a readahead
+ *    iterator.  In two KV dbs an entry's data key sorts directly ahead of
+ *    its header key, so the data is copied aside until the header arrives.
+ */
+static int
+rsbr_entry_scan(struct raft_instance *ri, const raft_entry_idx_t start,
+                const raft_entry_idx_t end, const bool with_data,
+                raft_entry_scan_cb_t cb, void *arg)
+{
+    if (!ri || start < 0 || end < start || !cb)
+        return -EINVAL;
+
+    else if (start == end)
+        return 0;
+
+    struct raft_instance_rocks_db *rir = rsbr_ri_to_rirdb(ri);
+
+    RSBR_DECL_ENTRY_KEY(rir, start_key, start, false);
+    RSBR_DECL_ENTRY_KEY(rir, end_key, end, false);
+
+    const bool copy_data = (with_data && !rir->rir_single_kv_entries);
+
+    char *data = copy_data ? niova_malloc(ri->ri_max_entry_size) : NULL;
+    if (copy_data && !data)
+        return -ENOMEM;
+
+    rocksdb_readoptions_t *ropts = rocksdb_readoptions_create();
+    if (!ropts)
+    {
+        niova_free(data);
+        return -ENOMEM;
+    }
+
+    // A single pass over the log should not displace the block cache
+    rocksdb_readoptions_set_fill_cache(ropts, 0);
+    rocksdb_readoptions_set_readahead_size(ropts, RSBR_SCAN_READAHEAD_SZ);
+    rocksdb_readoptions_set_iterate_upper_bound(ropts, end_key, end_key_len);
+
+    rocksdb_iterator_t *iter = rocksdb_create_iterator(rir->rir_db, ropts);
+    if (!iter)
+    {
+        rocksdb_readoptions_destroy(ropts);
+        niova_free(data);
+        return -ENOMEM;
+    }
+
+    raft_entry_idx_t data_idx = -1;
+    size_t data_len = 0;
+    int rc = 0;
+
+    for (rocksdb_iter_seek(iter, start_key, start_key_len);
+         !rc && rocksdb_iter_valid(iter); rocksdb_iter_next(iter))
+    {
+        size_t key_len = 0;
+        size_t val_len = 0;
+        const char *key = rocksdb_iter_key(iter, &key_len);
+        const char *val = rocksdb_iter_value(iter, &val_len);
+
+        raft_entry_idx_t idx = -1;
+        bool header = false;
+
+        rc = raft_rocksdb_entry_key_parse(key, key_len,
+                                          rir->rir_binary_entry_keys, &idx,
+                                          &header);
+        if (rc)
+            break;
+
+        if (!header && !rir->rir_single_kv_entries)
+        {
+            if (copy_data)
+            {
+                if (val_len > ri->ri_max_entry_size)
+                {
+                    rc = -EMSGSIZE;
+                    break;
+                }
+
+                memcpy(data, val, val_len);
+            }
+
+            data_idx = idx;
+            data_len = val_len;
+            continue;
+        }
+
+        // The value carries no alignment guarantee
+        struct raft_entry_header reh;
+        if (val_len < sizeof(reh))
+        {
+            rc = -EMSGSIZE;
+            break;
+        }
+
+        memcpy(&reh, val, sizeof(reh));
+
+        const char *reh_data = NULL;
+
+        if (rir->rir_single_kv_entries)
+        {
+            reh_data = val + sizeof(reh);
+            data_len = val_len - sizeof(reh);
+        }
+        else if (data_idx == idx)
+        {
+            reh_data = data;
+
+            // Empty entries are stored as a single byte
+            if (!reh.reh_data_size && data_len == 1)
+                data_len = 0;
+        }
+        else
+        {
+            rc = -ENOENT;
+            break;
+        }
+
+        if (with_data && data_len != reh.reh_data_size)
+            rc = -EMSGSIZE;
+        else
+            rc = cb(arg, &reh, with_data ? reh_data : NULL);
+
+        if (rc)
+            DBG_RAFT_ENTRY(LL_NOTIFY, &reh, "idx=%ld data-len=%zu: %s", idx,
+                           data_len, strerror(-rc));
+    }
+
+    if (!rc)
+    {
+        char *err = NULL;
+        rocksdb_iter_get_error(iter, &err);
+        if (err)
+        {
+            DBG_RAFT_INSTANCE(LL_ERROR, ri, "rocksdb_iter_get_error(): %s",
+                              err);
+            rc = -EIO;
+        }
+    }
+
+    rocksdb_iter_destroy(iter);
+    rocksdb_readoptions_destroy(ropts);
+    niova_free(data);
+
+    return rc;
+}
+
 static int
 rsbr_header_load(struct raft_instance *ri)
 {
@@ -838,10 +1213,17 @@ rsbr_header_load(struct raft_instance *ri)
                                      sizeof(struct raft_log_header));
     if (!rc)
     {
-        if (ri->ri_log_hdr.rlh_magic != RAFT_HEADER_MAGIC)
+        if (ri->ri_log_hdr.rlh_magic != RAFT_HEADER_MAGIC ||
+            ri->ri_log_hdr.rlh_version >= RAFT_ROCKSDB_LOG_VERSION_MAX)
+        {
             rc = -EBADMSG;
+        }
         else
+        {
+            rsbr_log_version_apply(rir, ri->ri_log_hdr.rlh_version);
+
             DBG_RAFT_INSTANCE(LL_NOTIFY, ri, "");
+        }
     }
     return rc;
 }
@@ -898,10 +1280,19 @@ rsbr_init_header(struct raft_instance *ri)
 
         // Since we're initializing the header block this is ok
         ri->ri_log_hdr.rlh_magic = RAFT_HEADER_MAGIC;
+
+        /* New dbs always use the binary entry key format.  The entry layout
+         * is chosen here and remains fixed for the life of the db.
+         */
+        ri->ri_log_hdr.rlh_version = ri->ri_rocksdb_single_kv ?
+            RAFT_ROCKSDB_LOG_VERSION_SINGLE_KV :
+            RAFT_ROCKSDB_LOG_VERSION_BINARY_KEYS;
     }
 
     struct raft_instance_rocks_db *rir = rsbr_ri_to_rirdb(ri);
 
+    rsbr_log_version_apply(rir, ri->ri_log_hdr.rlh_version);
+
     NIOVA_ASSERT(rir->rir_writeoptions_sync && rir->rir_writebatch);
     rocksdb_writebatch_clear(rir->rir_writebatch);
 
@@ -973,6 +1364,12 @@ rsbr_lowest_entry_get(struct raft_instance *ri, raft_entry_idx_t *lowest_idx)
         return rc;
     }
 
+    const char *prefix = rir->rir_binary_entry_keys ?
+        RAFT_ENTRY_KEY_PREFIX_BIN_ROCKSDB : RAFT_ENTRY_KEY_PREFIX_ROCKSDB;
+    const size_t prefix_len = rir->rir_binary_entry_keys ?
+        RAFT_ENTRY_KEY_PREFIX_BIN_ROCKSDB_STRLEN :
+        RAFT_ENTRY_KEY_PREFIX_ROCKSDB_STRLEN;
+
     size_t iter_key_len = 0;
     for (bool found = false; !found;)
     {
@@ -991,33 +1388,26 @@ rsbr_lowest_entry_get(struct raft_instance *ri, raft_entry_idx_t *lowest_idx)
         {
             break; // no entries found in the keyspace
         }
-        else if (rsbr_string_matches_iter_key(
-                     RAFT_ENTRY_KEY_PREFIX_ROCKSDB,
-                     RAFT_ENTRY_KEY_PREFIX_ROCKSDB_STRLEN, iter, false))
+        else if (rsbr_string_matches_iter_key(prefix, prefix_len, iter,
+                                              false))
         {
             const char *key = rocksdb_iter_key(iter, &iter_key_len);
 
-            FATAL_IF(((strncmp(key, RAFT_ENTRY_KEY_PREFIX_ROCKSDB,
-                               RAFT_ENTRY_KEY_PREFIX_ROCKSDB_STRLEN) &&
-                       key[iter_key_len - 1] != 'e')),
-                     "unexpected key (`%s'), len=%zu", key, iter_key_len);
-
-            unsigned long long val = 0;
-            // The above FATAL_IF guaranteed a non-numeric trailing char
+            bool header = false;
+            rc = raft_rocksdb_entry_key_parse(key, iter_key_len,
+                                              rir->rir_binary_entry_keys,
+                                              lowest_idx, &header);
 
-            rc = niova_string_to_unsigned_long_long(
-                &key[RAFT_ENTRY_KEY_PREFIX_ROCKSDB_STRLEN], &val);
+            // Entry keys ('e') sort ahead of their headers ('h')
+            FATAL_IF((rc || header), "unexpected key (len=%zu): %s",
+                     iter_key_len, strerror(-rc));
 
-            NIOVA_ASSERT(!rc);
-
-            *lowest_idx = (raft_entry_idx_t)val;
             found = true;
         }
     }
 
-    SIMPLE_LOG_MSG(LL_NOTIFY, "key='%.*s' lowest-idx=%zd rc=%d",
-                   (int)iter_key_len, rocksdb_iter_key(iter, &iter_key_len),
-                   *lowest_idx, rc);
+    SIMPLE_LOG_MSG(LL_NOTIFY, "binary-keys=%d lowest-idx=%zd rc=%d",
+                   rir->rir_binary_entry_keys, *lowest_idx, rc);
 
     rocksdb_iter_destroy(iter);
 
@@ -1076,31 +1466,31 @@ rsbr_num_entries_calc(struct raft_instance *ri)
         rocksdb_iter_destroy(iter);
         return 0;
     }
-    else if (!rsbr_string_matches_iter_key(
-                 RAFT_ENTRY_HEADER_KEY_PREFIX_ROCKSDB,
-                 RAFT_ENTRY_HEADER_KEY_PREFIX_ROCKSDB_STRLEN, iter, false))
-    {
-        SIMPLE_LOG_MSG(LL_ERROR,
-                       "key='%.*s' does not have expected prefix: %s",
-                       (int)iter_key_len,
-                       rocksdb_iter_key(iter, &iter_key_len),
-                       RAFT_ENTRY_HEADER_KEY_PREFIX_ROCKSDB);
-
-        rocksdb_iter_destroy(iter);
-        return (ssize_t)-ENOKEY;
-    }
 
     iter_key_len = 0;
     const char *iter_key = rocksdb_iter_key(iter, &iter_key_len);
 
-    if (iter_key_len <= RAFT_ENTRY_KEY_PREFIX_ROCKSDB_STRLEN)
+    raft_entry_idx_t last_idx = -1;
+    bool header = false;
+
+    rrc = raft_rocksdb_entry_key_parse(iter_key, iter_key_len,
+                                       rir->rir_binary_entry_keys,
+                                       &last_idx, &header);
+
+    // Single KV entries have no header keys, the last key is the entry's
+    if (rrc || header == rir->rir_single_kv_entries)
     {
+        SIMPLE_LOG_MSG(LL_ERROR,
+                       "key (len=%zu) is not an entry header (binary=%d "
+                       "single-kv=%d): %s",
+                       iter_key_len, rir->rir_binary_entry_keys,
+                       rir->rir_single_kv_entries, strerror(-rrc));
+
         rocksdb_iter_destroy(iter);
-        return (ssize_t)-EBADMSG;
+        return rrc ? rrc : (ssize_t)-ENOKEY;
     }
 
-    ssize_t last_entry_idx =
-        strtoull(&iter_key[RAFT_ENTRY_KEY_PREFIX_ROCKSDB_STRLEN], NULL, 10);
+    ssize_t last_entry_idx = last_idx;
 
     rocksdb_iter_destroy(iter);
 
@@ -1121,10 +1511,7 @@ rsbr_log_truncate(struct raft_instance *ri, const raft_entry_idx_t entry_idx)
 
     rocksdb_writebatch_clear(rir->rir_writebatch);
 
-    size_t entry_header_key_len = 0;
-    DECL_AND_FMT_STRING_RET_LEN(entry_header_key, (ssize_t)RAFT_ROCKSDB_KEY_LEN_MAX,
-                                (ssize_t *)&entry_header_key_len,
-                                RAFT_ENTRY_KEY_PRINTF, entry_idx);
+    RSBR_DECL_ENTRY_KEY(rir, entry_header_key, entry_idx, false);
 
     rocksdb_writebatch_delete_range(rir->rir_writebatch,
                                     entry_header_key, entry_header_key_len,
@@ -1161,17 +1548,9 @@ rsbr_log_reap(struct raft_instance *ri, const raft_entry_idx_t entry_idx)
      * the lower key suffix ('e') for this operation.
      */
 
-    size_t start_entry_key_len = 0;
-    DECL_AND_FMT_STRING_RET_LEN(start_entry_key,
-                                (ssize_t)RAFT_ROCKSDB_KEY_LEN_MAX,
-                                (ssize_t *)&start_entry_key_len,
-                                RAFT_ENTRY_KEY_PRINTF, (raft_entry_idx_t)0);
+    RSBR_DECL_ENTRY_KEY(rir, start_entry_key, (raft_entry_idx_t)0, false);
 
-    size_t end_entry_key_len = 0;
-    DECL_AND_FMT_STRING_RET_LEN(end_entry_key,
-                                (ssize_t)RAFT_ROCKSDB_KEY_LEN_MAX,
-                                (ssize_t *)&end_entry_key_len,
-                                RAFT_ENTRY_KEY_PRINTF, entry_idx);
+    RSBR_DECL_ENTRY_KEY(rir, end_entry_key, entry_idx, false);
 
     rocksdb_writebatch_delete_range(wb, start_entry_key, start_entry_key_len,
                                     end_entry_key, end_entry_key_len);
@@ -1231,9 +1610,9 @@ rsbr_sync(struct raft_instance *ri)
 #define CHKPT_PATH_FMT_ARGS(db, peer, idx) db, peer, idx
 
 static int
-rsbr_recovery_rsync_path_build(const char *base, const uuid_t peer_id,
-                               const uuid_t db_id, char *restore_path,
-                               size_t len)
+rsbr_recovery_xfer_path_build(const char *base, const uuid_t peer_id,
+                              const uuid_t db_id, char *restore_path,
+                              size_t len)
 {
     if (!base || uuid_is_null(peer_id) || uuid_is_null(db_id) ||
         !restore_path || !len)
@@ -1292,20 +1671,142 @@ rsbr_checkpoint_path_build(const char *base, const uuid_t peer_id,
 }
 
 static int
-rsbr_self_chkpt_scan(struct raft_instance *ri, struct raft_instance_rocks_db *rir);
+rsbr_chkpt_xfer_file_list(const char *chkpt_path,
+                          struct raft_chkpt_xfer_reply_msg *rcxrp, char *buf,
+                          size_t buf_sz)
+{
+    DIR *dir = opendir(chkpt_path);
+    if (!dir)
+        return -errno;
+
+    struct raft_chkpt_xfer_file *files = (struct raft_chkpt_xfer_file *)buf;
+    const size_t max_files = buf_sz / sizeof(struct raft_chkpt_xfer_file);
+    size_t nfiles = 0;
+    struct dirent *dent;
+    int rc = 0;
 
-static void
-rsbr_checkpoint_cleanup(struct raft_instance *ri,
-                        struct raft_instance_rocks_db *rir)
-{
-    NIOVA_ASSERT(ri && rir);
+    while (!rc && (dent = readdir(dir)))
+    {
+        struct stat stb;
 
-    int chkpt_scan_rc = rsbr_self_chkpt_scan(ri, rir);
-    if (chkpt_scan_rc)
-        LOG_MSG(LL_WARN, "rsbr_self_chkpt_scan(): %s",
-                strerror(-chkpt_scan_rc));
+        if (fstatat(dirfd(dir), dent->d_name, &stb, 0))
+            rc = -errno;
 
-    int trash_rc = rsbr_remove_trash(ri);
+        else if (!S_ISREG(stb.st_mode))
+            continue;
+
+        else if (strnlen(dent->d_name, RAFT_CHKPT_XFER_NAME_MAX) ==
+                 RAFT_CHKPT_XFER_NAME_MAX)
+            rc = -ENAMETOOLONG;
+
+        else if (nfiles == max_files)
+            rc = -E2BIG;
+
+        else
+        {
+            files[nfiles].rcxf_size = stb.st_size;
+            strncpy(files[nfiles].rcxf_name, dent->d_name,
+                    RAFT_CHKPT_XFER_NAME_MAX);
+            nfiles++;
+        }
+    }
+
+    closedir(dir);
+
+    if (rc)
+    {
+        SIMPLE_LOG_MSG(LL_NOTIFY, "`%s': %s", chkpt_path, strerror(-rc));
+        return rc;
+    }
+
+    rcxrp->rcxrpm_len = nfiles * sizeof(struct raft_chkpt_xfer_file);
+    rcxrp->rcxrpm_data_sz = rcxrp->rcxrpm_len;
+    rcxrp->rcxrpm_crc =
+        niova_crc((const unsigned char *)buf, rcxrp->rcxrpm_len, 0);
+
+    return 0;
+}
+
+/**
+ * rsbr_chkpt_xfer_read - serves a recovering peer's request for one of this
+ *    peer's checkpoints.  An empty name requests the checkpoint's file list,
+ *    otherwise a chunk of the named file is read into 'buf' along with its
+ *    CRC.  Checkpoint contents are immutable so no state is kept between
+ *    requests.
+ */
+static int
+rsbr_chkpt_xfer_read(struct raft_instance *ri,
+                     const struct raft_chkpt_xfer_request_msg *rcxrq,
+                     struct raft_chkpt_xfer_reply_msg *rcxrp, char *buf,
+                     size_t buf_sz)
+{
+    if (!ri || !rcxrq || !rcxrp || !buf)
+        return -EINVAL;
+
+    char chkpt_path[PATH_MAX] = {0};
+    int rc = rsbr_checkpoint_path_build(ri->ri_log,
+                                        RAFT_INSTANCE_2_SELF_UUID(ri),
+                                        ri->ri_db_uuid,
+                                        rcxrq->rcxrqm_chkpt_idx, true, false,
+                                        chkpt_path, PATH_MAX);
+    if (rc)
+        return rc;
+
+    const char *name = rcxrq->rcxrqm_name;
+
+    if (!name[0])
+        return rsbr_chkpt_xfer_file_list(chkpt_path, rcxrp, buf, buf_sz);
+
+    // The name may not lead outside of the checkpoint directory
+    if (!memchr(name, '\0', RAFT_CHKPT_XFER_NAME_MAX) || strchr(name, '/') ||
+        name[0] == '.' || rcxrq->rcxrqm_offset < 0)
+        return -EINVAL;
+
+    else if (rcxrq->rcxrqm_len > buf_sz)
+        return -EMSGSIZE;
+
+    char path[PATH_MAX];
+    rc = snprintf(path, PATH_MAX, "%s/%s", chkpt_path, name);
+    if (rc >= PATH_MAX)
+        return -ENAMETOOLONG;
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return -errno;
+
+    ssize_t rrc = niova_io_pread(fd, buf, rcxrq->rcxrqm_len,
+                                 rcxrq->rcxrqm_offset);
+    close(fd);
+
+    if (rrc < 0)
+    {
+        SIMPLE_LOG_MSG(LL_NOTIFY, "niova_io_pread(`%s'): %s",
+                       path, strerror((int)-rrc));
+        return (int)rrc;
+    }
+
+    rcxrp->rcxrpm_len = rrc;
+    rcxrp->rcxrpm_crc = niova_crc((const unsigned char *)buf, rrc, 0);
+    rcxrp->rcxrpm_data_sz = rcxrq->rcxrqm_crc_only ? 0 : rrc;
+
+    return 0;
+}
+
+static int
+rsbr_self_chkpt_scan(struct raft_instance *ri, struct raft_instance_rocks_db *rir);
+
+static void
+rsbr_checkpoint_cleanup(struct raft_instance *ri,
+                        struct raft_instance_rocks_db *rir)
+{
+    NIOVA_ASSERT(ri && rir);
+
+    int chkpt_scan_rc = rsbr_self_chkpt_scan(ri, rir);
+    if (chkpt_scan_rc)
+        LOG_MSG(LL_WARN, "rsbr_self_chkpt_scan(): %s",
+                strerror(-chkpt_scan_rc));
+
+    int trash_rc = rsbr_remove_trash(ri);
     if (trash_rc)
         LOG_MSG(LL_WARN, "rsbr_remove_trash(): %s", strerror(-trash_rc));
 }
@@ -1646,18 +2147,121 @@ rsbr_startup_checkpoint_scan(struct raft_instance *ri)
     return 0;
 }
 
+/* Bulk recovery pulls the source peer's checkpoint over its peer TCP port.
+ * Chunk requests for any of the checkpoint's files are pipelined up to
+ * RAFT_CHKPT_XFER_WINDOW deep on the one connection and the source replies
+ * in request order.  Files are received under a '.xfer' suffix and renamed
+ * once complete, so a later attempt skips completed files and verifies the
+ * partial ones chunk by chunk against the source's CRCs before resuming.
+ */
+#define RSBR_CHKPT_XFER_PARTIAL_SUFFIX ".xfer"
+#define RSBR_CHKPT_XFER_PARTIAL_NAME_MAX \
+    (RAFT_CHKPT_XFER_NAME_MAX + sizeof(RSBR_CHKPT_XFER_PARTIAL_SUFFIX))
+#define RSBR_CHKPT_XFER_TIMEOUT_SECS 30
+#define RSBR_CHKPT_XFER_FAULT_BW_LIMIT 1024 // bytes/sec
+#define RSBR_CHKPT_XFER_FILE_LIST SIZE_MAX
+
+struct rsbr_xfer_file
+{
+    uint64_t rxf_size;
+    uint64_t rxf_next;       // offset of the next chunk request
+    uint64_t rxf_done;       // contiguous bytes held by the local file
+    uint64_t rxf_verify_end; // whole chunks found in the partial file
+    int      rxf_fd;
+    bool     rxf_complete;
+    char     rxf_name[RAFT_CHKPT_XFER_NAME_MAX];
+};
+
+struct rsbr_xfer_req
+{
+    size_t   rxr_file;
+    uint64_t rxr_offset;
+    uint64_t rxr_tag;
+    uint32_t rxr_len;
+    bool     rxr_crc_only;
+};
+
+struct rsbr_xfer
+{
+    struct raft_instance        *rx_ri;
+    struct raft_recovery_handle *rx_rrh;
+    int                          rx_sock;
+    int                          rx_dirfd;
+    uint64_t                     rx_tag;
+    size_t                       rx_nfiles;
+    struct rsbr_xfer_file       *rx_files;
+    size_t                       rx_cursor;
+    size_t                       rx_head;
+    size_t                       rx_ninflight;
+    struct rsbr_xfer_req         rx_window[RAFT_CHKPT_XFER_WINDOW];
+    char                        *rx_buf;
+    size_t                       rx_buf_size;
+    size_t                       rx_bytes; // received by this attempt
+    struct timespec              rx_start;
+};
+
+static void
+rsbr_xfer_partial_name(const struct rsbr_xfer_file *rxf, char *name)
+{
+    snprintf(name, RSBR_CHKPT_XFER_PARTIAL_NAME_MAX, "%s"
+             RSBR_CHKPT_XFER_PARTIAL_SUFFIX, rxf->rxf_name);
+}
+
 static int
-rsbr_bulk_recover_build_remote_path(const struct raft_recovery_handle *rrh,
-                                    char *remote_path, size_t len)
+rsbr_xfer_sock_io(const int sock, char *buf, size_t len, const bool send)
 {
-    if (!rrh)
-        return -EINVAL;
+    while (len)
+    {
+        ssize_t rc = send ? write(sock, buf, len) : read(sock, buf, len);
+        if (rc < 0)
+        {
+            if (errno == EINTR)
+                continue;
+
+            return (errno == EAGAIN || errno == EWOULDBLOCK) ?
+                -ETIMEDOUT : -errno;
+        }
+        else if (!rc)
+        {
+            return -ECONNRESET;
+        }
+
+        buf += rc;
+        len -= rc;
+    }
+
+    return 0;
+}
+
+static void
+rsbr_xfer_msg_init(const struct rsbr_xfer *rx, struct raft_rpc_msg *rrm,
+                   const enum raft_rpc_msg_type type)
+{
+    struct raft_instance *ri = rx->rx_ri;
+
+    memset(rrm, 0, sizeof(struct raft_rpc_msg));
+
+    rrm->rrm_type = type;
+    rrm->rrm_version = 0; // tcp is always version 0
+    rrm->rrm_version_max = ri->ri_rpc_msg_version_max;
 
-    DECLARE_AND_INIT_UUID_STR(peer_uuid_str, rrh->rrh_peer_uuid);
+    uuid_copy(rrm->rrm_sender_id, RAFT_INSTANCE_2_SELF_UUID(ri));
+    uuid_copy(rrm->rrm_raft_id, RAFT_INSTANCE_2_RAFT_UUID(ri));
+    uuid_copy(rrm->rrm_db_id, rx->rx_rrh->rrh_peer_db_uuid);
+}
+
+/**
+ * rsbr_xfer_connect - raft net is not running while the recovery is in
+ *    progress so a blocking connection is made to the source's peer TCP port
+ *    and identified with the same handshake as any other peer connection.
+ */
+static int
+rsbr_xfer_connect(struct rsbr_xfer *rx)
+{
+    DECLARE_AND_INIT_UUID_STR(peer_uuid_str, rx->rx_rrh->rrh_peer_uuid);
 
-    // Lookup the csn
     struct ctl_svc_node *csn;
-    int rc = ctl_svc_node_lookup(rrh->rrh_peer_uuid, &csn);
+    int rc = ctl_svc_node_lookup(rx->rx_rrh->rrh_peer_uuid, &csn);
     if (rc)
     {
         LOG_MSG(LL_ERROR, "ctl_svc_node_lookup(%s): %s", peer_uuid_str,
@@ -1665,269 +2269,671 @@ rsbr_bulk_recover_build_remote_path(const struct raft_recovery_handle *rrh,
         return rc;
     }
 
-    // Find the remote store db path
-    const char *remote_store = ctl_svc_node_peer_2_store(csn);
-    if (!remote_store)
+    struct sockaddr_in addr;
+    tcp_setup_sockaddr_in(ctl_svc_node_peer_2_ipaddr(csn),
+                          ctl_svc_node_peer_2_port(csn), &addr);
+
+    ctl_svc_node_put(csn); // Must 'put' the csn to avoid leaks
+
+    rx->rx_sock = socket(AF_INET, SOCK_STREAM, 0);
+    if (rx->rx_sock < 0)
+        return -errno;
+
+    // Bound each send and recv so that a lost source fails the attempt
+    const struct timeval tv = {.tv_sec = RSBR_CHKPT_XFER_TIMEOUT_SECS};
+
+    if (setsockopt(rx->rx_sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv)) ||
+        setsockopt(rx->rx_sock, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv)))
+        return -errno;
+
+    if (connect(rx->rx_sock, (struct sockaddr *)&addr, sizeof(addr)))
     {
-        LOG_MSG(LL_ERROR, "ctl_svc_node_peer_2_store(%s): NULL",
-                peer_uuid_str);
-        rc = -ENOENT;
-        goto out;
+        rc = -errno;
+        LOG_MSG(LL_ERROR, "connect(%s): %s", peer_uuid_str, strerror(-rc));
+        return rc;
     }
 
-    char remote_relative_path[PATH_MAX];
-    /* Use the path building method.  Note that 'local' is set to true since
-     * the path is "local" relative to the remote peer.  In other words, we're
-     * building the path to be used on the remote end.
-     */
-    rc = rsbr_checkpoint_path_build(remote_store, rrh->rrh_peer_uuid,
-                                    rrh->rrh_peer_db_uuid,
-                                    rrh->rrh_peer_chkpt_idx, true, false,
-                                    remote_relative_path, PATH_MAX);
-    if (rc)
+    struct raft_rpc_msg handshake;
+    rsbr_xfer_msg_init(rx, &handshake, RAFT_RPC_MSG_TYPE_ANY);
+    handshake.rrm_version_max = 0;
+
+    return rsbr_xfer_sock_io(rx->rx_sock, (char *)&handshake,
+                             sizeof(handshake), true);
+}
+
+static int
+rsbr_xfer_request_send(struct rsbr_xfer *rx, const size_t file_idx,
+                       const uint64_t offset, const uint32_t len,
+                       const bool crc_only)
+{
+    NIOVA_ASSERT(rx->rx_ninflight < RAFT_CHKPT_XFER_WINDOW);
+
+    struct rsbr_xfer_req *rxr =
+        &rx->rx_window[(rx->rx_head + rx->rx_ninflight) %
+                       RAFT_CHKPT_XFER_WINDOW];
+
+    rxr->rxr_file = file_idx;
+    rxr->rxr_offset = offset;
+    rxr->rxr_len = len;
+    rxr->rxr_crc_only = crc_only;
+    rxr->rxr_tag = rx->rx_tag++;
+
+    struct raft_rpc_msg rrm;
+    rsbr_xfer_msg_init(rx, &rrm, RAFT_RPC_MSG_TYPE_CHKPT_XFER_REQUEST);
+
+    struct raft_chkpt_xfer_request_msg *rcxrq = &rrm.rrm_chkpt_xfer_request;
+
+    rcxrq->rcxrqm_chkpt_idx = rx->rx_rrh->rrh_peer_chkpt_idx;
+    rcxrq->rcxrqm_offset = offset;
+    rcxrq->rcxrqm_tag = rxr->rxr_tag;
+    rcxrq->rcxrqm_len = len;
+    rcxrq->rcxrqm_crc_only = crc_only ? 1 : 0;
+
+    if (file_idx != RSBR_CHKPT_XFER_FILE_LIST)
+        strncpy(rcxrq->rcxrqm_name, rx->rx_files[file_idx].rxf_name,
+                RAFT_CHKPT_XFER_NAME_MAX);
+
+    int rc = rsbr_xfer_sock_io(rx->rx_sock, (char *)&rrm, sizeof(rrm), true);
+    if (!rc)
+        rx->rx_ninflight++;
+
+    return rc;
+}
+
+/**
+ * rsbr_xfer_reply_recv - receives the reply to the oldest request in the
+ *    window and checks its payload against the source's CRC.  The source
+ *    may also direct its other peer traffic onto this connection, those
+ *    msgs are drained and ignored.
+ */
+static int
+rsbr_xfer_reply_recv(struct rsbr_xfer *rx, struct rsbr_xfer_req *ret_rxr,
+                     struct raft_chkpt_xfer_reply_msg *ret_rcxrp)
+{
+    NIOVA_ASSERT(rx->rx_ninflight);
+
+    *ret_rxr = rx->rx_window[rx->rx_head];
+    rx->rx_head = (rx->rx_head + 1) % RAFT_CHKPT_XFER_WINDOW;
+    rx->rx_ninflight--;
+
+    struct raft_rpc_msg rrm;
+
+    for (;;)
     {
-        LOG_MSG(LL_ERROR, "rsbr_checkpoint_path_build(%s): %s",
-                peer_uuid_str, strerror(-rc));
-        goto out;
+        int rc = rsbr_xfer_sock_io(rx->rx_sock, (char *)&rrm, sizeof(rrm),
+                                   false);
+        if (rc)
+            return rc;
+
+        if (rrm.rrm_type == RAFT_RPC_MSG_TYPE_CHKPT_XFER_REPLY)
+            break;
+
+        // Compressed AE payloads are also sized by raerqm_entries_sz
+        const size_t skip =
+            rrm.rrm_type != RAFT_RPC_MSG_TYPE_APPEND_ENTRIES_REQUEST ? 0 :
+            rrm.rrm_append_entries_request.raerqm_entries_sz;
+
+        if (skip > rx->rx_buf_size)
+            return -EBADMSG;
+
+        rc = rsbr_xfer_sock_io(rx->rx_sock, rx->rx_buf, skip, false);
+        if (rc)
+            return rc;
     }
 
-    rc = snprintf(remote_path, len - 1, "%s:%s",
-                  ctl_svc_node_peer_2_ipaddr(csn), remote_relative_path);
-    if (rc >= (ssize_t)len)
+    const struct raft_chkpt_xfer_reply_msg *rcxrp = &rrm.rrm_chkpt_xfer_reply;
+
+    if (rcxrp->rcxrpm_tag != ret_rxr->rxr_tag ||
+        rcxrp->rcxrpm_data_sz > rx->rx_buf_size)
     {
-        LOG_MSG(LL_ERROR, "snprintf() overrun (rc=%d)", rc);
-        rc = -ENAMETOOLONG;
-        goto out;
+        DBG_RAFT_MSG(LL_ERROR, &rrm, "unexpected reply (tag=%lu)",
+                     ret_rxr->rxr_tag);
+        return -EBADMSG;
     }
-    else
+    else if (rcxrp->rcxrpm_err)
     {
-        rc = 0;
+        DBG_RAFT_MSG(LL_ERROR, &rrm, "");
+        return rcxrp->rcxrpm_err < 0 ? rcxrp->rcxrpm_err : -EBADMSG;
     }
-out:
-    ctl_svc_node_put(csn); // Must 'put' the csn to avoid leaks
-    return rc;
+
+    int rc = rsbr_xfer_sock_io(rx->rx_sock, rx->rx_buf,
+                               rcxrp->rcxrpm_data_sz, false);
+    if (rc)
+        return rc;
+
+    if (!ret_rxr->rxr_crc_only &&
+        niova_crc((const unsigned char *)rx->rx_buf, rcxrp->rcxrpm_data_sz,
+                  0) != rcxrp->rcxrpm_crc)
+    {
+        rx->rx_rrh->rrh_chunk_crc_errors++;
+        DBG_RAFT_MSG(LL_ERROR, &rrm, "payload crc mismatch");
+        return -EBADMSG;
+    }
+
+    *ret_rcxrp = *rcxrp;
+
+    return 0;
 }
 
 static int
-rsbr_bulk_recover_try_parse(struct raft_recovery_handle *rrh,
-                            const char *output, size_t len,
-                            enum recovery_regexes val_type)
+rsbr_xfer_file_open(struct rsbr_xfer *rx, struct rsbr_xfer_file *rxf,
+                    const bool truncate)
 {
-    NIOVA_ASSERT(rrh && output &&
-                 ((val_type == RECOVERY_RSYNC_TOTAL_SIZE__regex) ||
-                  (val_type == RECOVERY_RSYNC_TOTAL_XFER_SIZE__regex)));
+    char partial[RSBR_CHKPT_XFER_PARTIAL_NAME_MAX];
+    rsbr_xfer_partial_name(rxf, partial);
 
-    regex_t *regex = &recoveryRegexes[val_type].rp_regex;
+    rxf->rxf_fd = openat(rx->rx_dirfd, partial,
+                        O_CREAT | O_RDWR | (truncate ? O_TRUNC : 0), 0600);
+    if (rxf->rxf_fd < 0)
+    {
+        int rc = -errno;
+        SIMPLE_LOG_MSG(LL_ERROR, "openat(`%s'): %s", partial, strerror(-rc));
+        return rc;
+    }
 
-    int rc = regexec(regex, output, 0, NULL, 0);
-    if (rc)
-        return 0; // non-match is ok
+    return 0;
+}
+
+static int
+rsbr_xfer_file_complete(struct rsbr_xfer *rx, struct rsbr_xfer_file *rxf)
+{
+    char partial[RSBR_CHKPT_XFER_PARTIAL_NAME_MAX];
+    rsbr_xfer_partial_name(rxf, partial);
 
-    ssize_t *val = (val_type == RECOVERY_RSYNC_TOTAL_SIZE__regex) ?
-        &rrh->rrh_chkpt_size : &rrh->rrh_remaining;
+    int rc = fsync(rxf->rxf_fd) ? -errno : 0;
+
+    close(rxf->rxf_fd);
+    rxf->rxf_fd = -1;
+
+    if (!rc && renameat(rx->rx_dirfd, partial, rx->rx_dirfd, rxf->rxf_name))
+        rc = -errno;
 
-    rc = niova_parse_comma_delimited_uint_string(output, len,
-                                                 (unsigned long long *)val);
     if (rc)
-    {
-        *val = -1;
-        SIMPLE_LOG_MSG(LL_WARN,
-                       "niova_parse_comma_delimited_uint_string(): %s",
-                       strerror(-rc));
-    }
+        SIMPLE_LOG_MSG(LL_ERROR, "`%s': %s", rxf->rxf_name, strerror(-rc));
+    else
+        rxf->rxf_complete = true;
 
     return rc;
 }
 
-static popen_cmd_cb_ctx_t
-rsbr_bulk_recover_calculate_remaining_rsync_cb(const char *output, size_t len,
-                                               void *arg)
+static int
+rsbr_xfer_file_list_get(struct rsbr_xfer *rx)
 {
-    if (!output || !arg || !len)
-        return -EINVAL;
+    int rc =
+        rsbr_xfer_request_send(rx, RSBR_CHKPT_XFER_FILE_LIST, 0, 0, false);
+    if (rc)
+        return rc;
 
-    struct raft_recovery_handle *rrh = (struct raft_recovery_handle *)arg;
+    struct rsbr_xfer_req rxr;
+    struct raft_chkpt_xfer_reply_msg rcxrp;
 
-    LOG_MSG(LL_TRACE, "%zu >> %s", len, output);
+    rc = rsbr_xfer_reply_recv(rx, &rxr, &rcxrp);
+    if (rc)
+        return rc;
 
-    int rc = 0;
+    if (rcxrp.rcxrpm_data_sz % sizeof(struct raft_chkpt_xfer_file))
+        return -EBADMSG;
 
-    if (rrh->rrh_chkpt_size < 0)
-    {
-        rc = rsbr_bulk_recover_try_parse(rrh, output, len,
-                                         RECOVERY_RSYNC_TOTAL_SIZE__regex);
-        if (!rc && rrh->rrh_chkpt_size > 0)
-            SIMPLE_LOG_MSG(LL_WARN, "rrh_chkpt_size=%zd",
-                           rrh->rrh_chkpt_size);
-    }
+    rx->rx_nfiles = rcxrp.rcxrpm_data_sz / sizeof(struct raft_chkpt_xfer_file);
+    rx->rx_files = niova_calloc_can_fail(MAX(rx->rx_nfiles, 1),
+                                         sizeof(struct rsbr_xfer_file));
+    if (!rx->rx_files)
+        return -ENOMEM;
 
-    if (rrh->rrh_remaining < 0)
+    const struct raft_chkpt_xfer_file *files =
+        (const struct raft_chkpt_xfer_file *)rx->rx_buf;
+
+    for (size_t i = 0; i < rx->rx_nfiles; i++)
     {
-        rc = rsbr_bulk_recover_try_parse(
-            rrh, output, len, RECOVERY_RSYNC_TOTAL_XFER_SIZE__regex);
+        struct rsbr_xfer_file *rxf = &rx->rx_files[i];
+        const char *name = files[i].rcxf_name;
+
+        rxf->rxf_fd = -1;
+
+        if (!memchr(name, '\0', RAFT_CHKPT_XFER_NAME_MAX) || !name[0] ||
+            strchr(name, '/') || name[0] == '.')
+            return -EBADMSG;
 
-        if (!rc && rrh->rrh_remaining >= 0)
-            SIMPLE_LOG_MSG(LL_WARN, "rrh_remaining=%zd", rrh->rrh_remaining);
+        strncpy(rxf->rxf_name, name, RAFT_CHKPT_XFER_NAME_MAX);
+        rxf->rxf_size = files[i].rcxf_size;
     }
 
-    return rc;
+    return 0;
 }
 
 /**
- * rsbr_bulk_recover_calculate_remaining - this function calls popen() to
- *    launch an 'rsync' probe which will calculate the size of the remote
- *    checkpoint and the amount requiring transfer.
+ * rsbr_xfer_files_prepare - matches the source's file list against what the
+ *    previous attempts left behind.  Completed files are skipped, stale ones
+ *    are removed, and the partial files' whole chunks are queued for
+ *    verification.
  */
-static popen_cmd_t // performs a fork / exec via popen()
-rsbr_bulk_recover_calculate_remaining_rsync(struct raft_recovery_handle *rrh,
-                                            const char *remote_path,
-                                            const char *local_path)
+static int
+rsbr_xfer_files_prepare(struct rsbr_xfer *rx, const ssize_t available_cap)
 {
-    if (!rrh || !remote_path || !local_path)
-        return -EINVAL;
+    struct raft_recovery_handle *rrh = rx->rx_rrh;
 
-    char cmd[PATH_MAX + 1] = {0};
+    rrh->rrh_nfiles = rx->rx_nfiles;
+    rrh->rrh_chkpt_size = 0;
+    rrh->rrh_completed = 0;
 
-    int rc = snprintf(cmd, PATH_MAX, "rsync -an --info=stats2 %s/ %s 2>&1",
-                      remote_path, local_path);
-    if (rc > PATH_MAX)
-        return -ENAMETOOLONG;
+    for (size_t i = 0; i < rx->rx_nfiles; i++)
+    {
+        struct rsbr_xfer_file *rxf = &rx->rx_files[i];
+        char partial[RSBR_CHKPT_XFER_PARTIAL_NAME_MAX];
+        struct stat stb;
+        int rc = 0;
 
-    LOG_MSG(LL_DEBUG, "cmd=`%s'", cmd);
+        rrh->rrh_chkpt_size += rxf->rxf_size;
+        rsbr_xfer_partial_name(rxf, partial);
 
-    rc = popen_cmd_out(cmd, rsbr_bulk_recover_calculate_remaining_rsync_cb,
-                       (void *)rrh);
-    if (rc)
-        LOG_MSG(LL_ERROR, "popen_cmd_out(rsync): %s", strerror(-rc));
+        if (!fstatat(rx->rx_dirfd, rxf->rxf_name, &stb, 0))
+        {
+            if ((uint64_t)stb.st_size == rxf->rxf_size)
+            {
+                rxf->rxf_done = rxf->rxf_size;
+                rxf->rxf_complete = true;
+                rrh->rrh_completed += rxf->rxf_size;
+                continue;
+            }
+            else if (unlinkat(rx->rx_dirfd, rxf->rxf_name, 0))
+            {
+                rc = -errno;
+            }
+        }
+        else if (errno != ENOENT)
+        {
+            rc = -errno;
+        }
 
-    return rc;
+        if (!rc && !fstatat(rx->rx_dirfd, partial, &stb, 0))
+        {
+            rxf->rxf_verify_end = MIN((uint64_t)stb.st_size, rxf->rxf_size);
+            rxf->rxf_verify_end -=
+                rxf->rxf_verify_end % RAFT_CHKPT_XFER_CHUNK_SZ;
+        }
+        else if (!rc && errno != ENOENT)
+        {
+            rc = -errno;
+        }
+
+        // Empty files have no chunks to request
+        if (!rc && !rxf->rxf_size)
+        {
+            rc = rsbr_xfer_file_open(rx, rxf, true);
+            if (!rc)
+                rc = rsbr_xfer_file_complete(rx, rxf);
+        }
+
+        if (rc)
+        {
+            SIMPLE_LOG_MSG(LL_ERROR, "`%s': %s", rxf->rxf_name,
+                           strerror(-rc));
+            return rc;
+        }
+    }
+
+    rrh->rrh_remaining = rrh->rrh_chkpt_size - rrh->rrh_completed;
+
+    if (rrh->rrh_remaining > available_cap)
+    {
+        SIMPLE_LOG_MSG(LL_ERROR, "Remaining=%zd > available-capacity=%zd",
+                       rrh->rrh_remaining, available_cap);
+        return -ENOSPC;
+    }
+
+    SIMPLE_LOG_MSG(LL_WARN, "files=%zu size=%zd remaining=%zd",
+                   rx->rx_nfiles, rrh->rrh_chkpt_size, rrh->rrh_remaining);
+
+    return 0;
 }
 
 static void
-rsbr_bulk_recover_xfer_rsync_try_rate_parse(const char *output,
-                                            struct raft_recovery_handle *rrh)
+rsbr_xfer_throttle(struct rsbr_xfer *rx)
 {
-    regex_t *regex =
-        &recoveryRegexes[RECOVERY_RSYNC_PROGRESS_LINE_RATE__regex].rp_regex;
+    const size_t bw_limit = FAULT_INJECT(raft_limit_rsync_bw) ?
+        RSBR_CHKPT_XFER_FAULT_BW_LIMIT : rx->rx_ri->ri_bulk_recovery_bw_limit;
 
-    regmatch_t match = {0};
-    if (!regexec(regex, output, 1, &match, 0))
+    struct timespec now;
+    niova_unstable_clock(&now);
+    timespecsub(&now, &rx->rx_start, &now);
+
+    unsigned long long elapsed_usec = timespec_2_nsec(&now) / 1000ULL;
+
+    if (bw_limit)
     {
-        strncpy(rrh->rrh_rate_bytes_per_sec, &output[match.rm_so],
-                MIN(BW_RATE_LEN, match.rm_eo - match.rm_so));
+        const unsigned long long target_usec =
+            (unsigned long long)rx->rx_bytes * 1000000ULL / bw_limit;
 
-        SIMPLE_LOG_MSG(LL_TRACE, "%s", rrh->rrh_rate_bytes_per_sec);
+        if (target_usec > elapsed_usec)
+        {
+            usleep(target_usec - elapsed_usec);
+            elapsed_usec = target_usec;
+        }
     }
+
+    // Bytes per usec is MB/s
+    if (elapsed_usec)
+        snprintf(rx->rx_rrh->rrh_rate_bytes_per_sec, BW_RATE_LEN + 1,
+                 "%.2fMB/s", (double)rx->rx_bytes / (double)elapsed_usec);
 }
 
-static popen_cmd_cb_ctx_t
-rsbr_bulk_recover_xfer_rsync_cb(const char *output, size_t len, void *arg)
+static int
+rsbr_xfer_chunk_verify(struct rsbr_xfer *rx, const struct rsbr_xfer_req *rxr,
+                       const struct raft_chkpt_xfer_reply_msg *rcxrp)
 {
-    if (!output || !arg || !len)
-        return -EINVAL;
+    struct rsbr_xfer_file *rxf = &rx->rx_files[rxr->rxr_file];
 
-    struct raft_recovery_handle *rrh = (struct raft_recovery_handle *)arg;
+    // Chunks beyond the first mismatch will be sent again regardless
+    if (rxr->rxr_offset != rxf->rxf_done)
+        return 0;
 
-    regex_t *regex =
-        &recoveryRegexes[RECOVERY_RSYNC_PROGRESS_LINE__regex].rp_regex;
+    if (rcxrp->rcxrpm_len != rxr->rxr_len)
+        return -EBADMSG;
 
-    int rc = regexec(regex, output, 0, NULL, 0);
-    if (rc)
+    ssize_t rrc = niova_io_pread(rxf->rxf_fd, rx->rx_buf, rxr->rxr_len,
+                                 rxr->rxr_offset);
+    if (rrc != rxr->rxr_len)
+        return rrc < 0 ? (int)rrc : -EIO;
+
+    if (niova_crc((const unsigned char *)rx->rx_buf, rxr->rxr_len, 0) ==
+        rcxrp->rcxrpm_crc)
     {
-        LOG_MSG(LL_TRACE, "%zu >> %s", len, output);
+        rxf->rxf_done += rxr->rxr_len;
+        rx->rx_rrh->rrh_chunks_resumed++;
+        rx->rx_rrh->rrh_completed += rxr->rxr_len;
+        rx->rx_rrh->rrh_remaining -= rxr->rxr_len;
+    }
+
+    return 0;
+}
+
+static int
+rsbr_xfer_chunk_write(struct rsbr_xfer *rx, const struct rsbr_xfer_req *rxr,
+                      const struct raft_chkpt_xfer_reply_msg *rcxrp)
+{
+    struct rsbr_xfer_file *rxf = &rx->rx_files[rxr->rxr_file];
+    struct raft_recovery_handle *rrh = rx->rx_rrh;
+
+    // The file may not change size on the source
+    if (rcxrp->rcxrpm_len != rxr->rxr_len ||
+        rcxrp->rcxrpm_data_sz != rxr->rxr_len)
+        return -EBADMSG;
+
+    NIOVA_ASSERT(rxr->rxr_offset == rxf->rxf_done);
+
+    ssize_t rrc = niova_io_pwrite(rxf->rxf_fd, rx->rx_buf, rxr->rxr_len,
+                                  rxr->rxr_offset);
+    if (rrc != rxr->rxr_len)
+        return rrc < 0 ? (int)rrc : -EIO;
+
+    rxf->rxf_done += rxr->rxr_len;
+    rx->rx_bytes += rxr->rxr_len;
+    rrh->rrh_chunks_xferred++;
+    rrh->rrh_completed += rxr->rxr_len;
+    rrh->rrh_remaining -= rxr->rxr_len;
+
+    int rc = 0;
+    if (rxf->rxf_done == rxf->rxf_size)
+        rc = rsbr_xfer_file_complete(rx, rxf);
+
+    rsbr_xfer_throttle(rx);
+
+    return rc;
+}
+
+static bool
+rsbr_xfer_next_chunk(struct rsbr_xfer *rx, const bool verify,
+                     size_t *ret_file, uint64_t *ret_offset,
+                     uint32_t *ret_len)
+{
+    for (; rx->rx_cursor < rx->rx_nfiles; rx->rx_cursor++)
+    {
+        struct rsbr_xfer_file *rxf = &rx->rx_files[rx->rx_cursor];
+        const uint64_t end = verify ? rxf->rxf_verify_end : rxf->rxf_size;
+
+        if (rxf->rxf_complete || rxf->rxf_next >= end)
+            continue;
 
-        return 0; // non-match is ok
+        *ret_file = rx->rx_cursor;
+        *ret_offset = rxf->rxf_next;
+        *ret_len = MIN(RAFT_CHKPT_XFER_CHUNK_SZ, end - rxf->rxf_next);
+
+        rxf->rxf_next += *ret_len;
+
+        return true;
     }
-    unsigned long long val = 0;
 
-    rc = niova_parse_comma_delimited_uint_string(output, len, &val);
-    if (rc)
+    return false;
+}
+
+/**
+ * rsbr_xfer_run - keeps the request window full until each remaining chunk
+ *    has been handled.  The 'verify' pass only requests the CRCs of the
+ *    chunks already held by partial files.
+ */
+static int
+rsbr_xfer_run(struct rsbr_xfer *rx, const bool verify)
+{
+    rx->rx_cursor = 0;
+
+    for (size_t i = 0; i < rx->rx_nfiles; i++)
+        rx->rx_files[i].rxf_next = rx->rx_files[i].rxf_done;
+
+    for (;;)
     {
-        SIMPLE_LOG_MSG(LL_WARN,
-                       "niova_parse_comma_delimited_uint_string(): %s",
-                       strerror(-rc));
-        return rc;
+        size_t file_idx;
+        uint64_t offset;
+        uint32_t len;
+        int rc;
+
+        while (rx->rx_ninflight < RAFT_CHKPT_XFER_WINDOW &&
+               rsbr_xfer_next_chunk(rx, verify, &file_idx, &offset, &len))
+        {
+            struct rsbr_xfer_file *rxf = &rx->rx_files[file_idx];
+
+            // Partial files which were not verified are started over
+            rc = rxf->rxf_fd < 0 ? rsbr_xfer_file_open(rx, rxf, !verify) : 0;
+            if (!rc)
+                rc = rsbr_xfer_request_send(rx, file_idx, offset, len,
+                                            verify);
+            if (rc)
+                return rc;
+        }
+
+        if (!rx->rx_ninflight)
+            return 0;
+
+        struct rsbr_xfer_req rxr;
+        struct raft_chkpt_xfer_reply_msg rcxrp;
+
+        rc = rsbr_xfer_reply_recv(rx, &rxr, &rcxrp);
+        if (!rc)
+            rc = verify ? rsbr_xfer_chunk_verify(rx, &rxr, &rcxrp) :
+                rsbr_xfer_chunk_write(rx, &rxr, &rcxrp);
+
+        if (rc)
+            return rc;
     }
+}
+
+static int
+rsbr_xfer_resume_truncate(struct rsbr_xfer *rx)
+{
+    for (size_t i = 0; i < rx->rx_nfiles; i++)
+    {
+        struct rsbr_xfer_file *rxf = &rx->rx_files[i];
 
-    if (val > rrh->rrh_completed)
-        rrh->rrh_completed = val;
+        if (rxf->rxf_complete || rxf->rxf_fd < 0)
+            continue;
 
-    // Grab the rate from the rsync "progress2" output
-    rsbr_bulk_recover_xfer_rsync_try_rate_parse(output, rrh);
+        // Drop whatever follows the last verified chunk
+        if (ftruncate(rxf->rxf_fd, rxf->rxf_done))
+            return -errno;
 
-    SIMPLE_LOG_MSG(LL_TRACE, "val=%llu rate=%s",
-                   val, rrh->rrh_rate_bytes_per_sec);
+        if (rxf->rxf_done == rxf->rxf_size)
+        {
+            int rc = rsbr_xfer_file_complete(rx, rxf);
+            if (rc)
+                return rc;
+        }
+    }
 
     return 0;
 }
 
-static popen_cmd_t // performs a fork / exec via popen()
-rsbr_bulk_recover_xfer_rsync(struct raft_recovery_handle *rrh,
-                             const char *remote_path, const char *local_path)
+static int
+rsbr_xfer_finish(struct rsbr_xfer *rx)
+{
+    for (size_t i = 0; i < rx->rx_nfiles; i++)
+    {
+        if (!rx->rx_files[i].rxf_complete)
+        {
+            SIMPLE_LOG_MSG(LL_ERROR, "`%s' is incomplete",
+                           rx->rx_files[i].rxf_name);
+            return -EBADE;
+        }
+    }
+
+    if (rx->rx_rrh->rrh_remaining)
+    {
+        SIMPLE_LOG_MSG(LL_ERROR, "rrh_remaining(%zd) != 0",
+                       rx->rx_rrh->rrh_remaining);
+        return -EBADE;
+    }
+
+    return fsync(rx->rx_dirfd) ? -errno : 0;
+}
+
+static void
+rsbr_xfer_release(struct rsbr_xfer *rx)
+{
+    for (size_t i = 0; rx->rx_files && i < rx->rx_nfiles; i++)
+        if (rx->rx_files[i].rxf_fd >= 0)
+            close(rx->rx_files[i].rxf_fd);
+
+    if (rx->rx_sock >= 0)
+        close(rx->rx_sock);
+
+    if (rx->rx_dirfd >= 0)
+        close(rx->rx_dirfd);
+
+    niova_free(rx->rx_files);
+    niova_free(rx->rx_buf);
+}
+
+/**
+ * rsbr_chkpt_xfer - streams the source peer's checkpoint into 'local_path'.
+ *    Each call is one attempt which resumes from what the previous attempts
+ *    left in 'local_path'.
+ */
+static int
+rsbr_chkpt_xfer(struct raft_instance *ri, struct raft_recovery_handle *rrh,
+                const char *local_path, const ssize_t available_cap)
 {
-    if (!rrh || !remote_path || !local_path)
+    if (!ri || !rrh || !local_path)
         return -EINVAL;
 
-    char cmd[PATH_MAX + 1] = {0};
+    struct rsbr_xfer rx = {
+        .rx_ri = ri,
+        .rx_rrh = rrh,
+        .rx_sock = -1,
+        .rx_dirfd = -1,
+        .rx_buf_size = RAFT_NET_MAX_RPC_SIZE_ROCKSDB,
+    };
 
-    /* Ensure that a '/' is appended to the remote path so that rsync does
-     * not apply the remote's parent directory to the local path.
-     */
-    int rc;
-    if (FAULT_INJECT(raft_limit_rsync_bw))
-        rc = snprintf(cmd, PATH_MAX,
-                      "rsync -a --bwlimit=1 --info=progress2 %s/ %s 2>&1",
-                      remote_path, local_path);
-    else
-        rc = snprintf(cmd, PATH_MAX, "rsync -a --info=progress2 %s/ %s 2>&1",
-                      remote_path, local_path);
-    if (rc > PATH_MAX)
-        return -ENAMETOOLONG;
+    rrh->rrh_xfer_attempts++;
+    niova_unstable_clock(&rx.rx_start);
 
-    LOG_MSG(LL_DEBUG, "cmd=`%s'", cmd);
+    int rc = 0;
 
-    rc = popen_cmd_out(cmd, rsbr_bulk_recover_xfer_rsync_cb, (void *)rrh);
+    if (mkdir(local_path, 0700) && errno != EEXIST)
+    {
+        rc = -errno;
+        SIMPLE_LOG_MSG(LL_ERROR, "mkdir(`%s'): %s", local_path,
+                       strerror(-rc));
+        return rc;
+    }
+
+    rx.rx_dirfd = open(local_path, O_RDONLY | O_DIRECTORY);
+    if (rx.rx_dirfd < 0)
+    {
+        rc = -errno;
+        goto out;
+    }
+
+    rx.rx_buf = niova_malloc_can_fail(rx.rx_buf_size);
+    if (!rx.rx_buf)
+    {
+        rc = -ENOMEM;
+        goto out;
+    }
+
+    rc = rsbr_xfer_connect(&rx);
     if (rc)
-        LOG_MSG(LL_ERROR, "popen_cmd_out(rsync): %s", strerror(-rc));
+        goto out;
+
+    rc = rsbr_xfer_file_list_get(&rx);
+    if (rc)
+        goto out;
+
+    rc = rsbr_xfer_files_prepare(&rx, available_cap);
+    if (rc)
+        goto out;
+
+    rc = rsbr_xfer_run(&rx, true);
+    if (rc)
+        goto out;
+
+    rc = rsbr_xfer_resume_truncate(&rx);
+    if (rc)
+        goto out;
+
+    rc = rsbr_xfer_run(&rx, false);
+    if (rc)
+        goto out;
+
+    rc = rsbr_xfer_finish(&rx);
+
+out:
+    SIMPLE_LOG_MSG((rc ? LL_ERROR : LL_WARN),
+                   "attempt=%zu files=%zu xferred=%zu resumed=%zu "
+                   "crc-errors=%zu completed=%zu rate=%s: %s",
+                   rrh->rrh_xfer_attempts, rrh->rrh_nfiles,
+                   rrh->rrh_chunks_xferred, rrh->rrh_chunks_resumed,
+                   rrh->rrh_chunk_crc_errors, rrh->rrh_completed,
+                   rrh->rrh_rate_bytes_per_sec, strerror(-rc));
+
+    rsbr_xfer_release(&rx);
 
     return rc;
 }
 
+#define BULK_RECOVERY_XFER_RETRY_SECS 10
+#define BULK_RECOVERY_XFER_RETRY_MAX  4
 
-#define BULK_RECOVERY_RSYNC_RETRY_SECS 10
-#define BULK_RECOVERY_RSYNC_RETRY_MAX  4
-
-#define RSBR_BULK_RECOVER_RSYNC_CMD(func, rrh, remote_path, local_path)  \
-({                                                                  \
+#define RSBR_BULK_RECOVER_RETRY(func, ...)                              \
+({                                                                      \
     int rc = 0;                                                         \
     int nretries = 0;                                                   \
     do {                                                                \
-        rc = func(rrh, remote_path, local_path);                            \
+        rc = func(__VA_ARGS__);                                         \
         if (rc)                                                         \
         {                                                               \
-            bool retry = ++nretries >= BULK_RECOVERY_RSYNC_RETRY_MAX ?      \
+            bool retry = ++nretries >= BULK_RECOVERY_XFER_RETRY_MAX ?   \
                 false : true;                                           \
             SIMPLE_LOG_MSG(                                             \
                 LL_ERROR,                                               \
                 #func": %s, retry=%s in %u seconds",                    \
                 strerror(-rc), retry ? "yes" : "no",                    \
-                retry ? (BULK_RECOVERY_RSYNC_RETRY_SECS * nretries) : 0); \
+                retry ? (BULK_RECOVERY_XFER_RETRY_SECS * nretries) : 0); \
             if (!retry)                                                 \
                 break;                                                  \
-            niova_sleep(BULK_RECOVERY_RSYNC_RETRY_SECS * nretries);     \
+            niova_sleep(BULK_RECOVERY_XFER_RETRY_SECS * nretries);      \
         }                                                               \
     } while (rc);                                                       \
     rc;                                                                 \
 })
 
-static int
-rsbr_bulk_recover_xfer(struct raft_recovery_handle *rrh,
-                       const char *remote_path, const char *local_path)
-{
-    return RSBR_BULK_RECOVER_RSYNC_CMD(rsbr_bulk_recover_xfer_rsync, rrh,
-                                       remote_path, local_path);
-}
-
 static ssize_t
 rsbr_bulk_recover_get_fs_free_space(struct raft_instance *ri)
 {
@@ -1957,33 +2963,6 @@ rsbr_bulk_recover_get_fs_free_space(struct raft_instance *ri)
     return available_cap;
 }
 
-static int
-rsbr_bulk_recover_calculate_remaining(struct raft_recovery_handle *rrh,
-                                      const char *remote_path,
-                                      const char *local_path,
-                                      const ssize_t available_cap)
-{
-    int rc = RSBR_BULK_RECOVER_RSYNC_CMD(
-        rsbr_bulk_recover_calculate_remaining_rsync, rrh, remote_path,
-        local_path);
-
-    if (!rc)
-    {
-        if (rrh->rrh_remaining < 0 || rrh->rrh_chkpt_size < 0)
-        {
-            SIMPLE_LOG_MSG(LL_ERROR, "Unable to determine size requirements.");
-            return -ENODATA;
-        }
-        else if (rrh->rrh_remaining > available_cap)
-        {
-            SIMPLE_LOG_MSG(LL_ERROR, "Remaining=%zd > available-capacity=%zd",
-                           rrh->rrh_remaining, available_cap);
-            return -ENOSPC;
-        }
-    }
-    return rc;
-}
-
 static int
 rsbr_bulk_recovery_remove_current_db_contents(struct raft_instance *ri)
 {
@@ -2029,64 +3008,26 @@ rsbr_bulk_recovery_import_remote_db(struct raft_instance *ri,
     if (available_cap < 0)
         return (int)available_cap;
 
-    char remote_path[PATH_MAX] = {0};
-    int rc = rsbr_bulk_recover_build_remote_path(rrh, remote_path, PATH_MAX);
-    if (rc)
-        return rc;
-
     char local_path[PATH_MAX] = {0};
-    rc = rsbr_recovery_rsync_path_build(ri->ri_log, rrh->rrh_peer_uuid,
-                                 rrh->rrh_peer_db_uuid, local_path, PATH_MAX);
+    int rc = rsbr_recovery_xfer_path_build(ri->ri_log, rrh->rrh_peer_uuid,
+                                           rrh->rrh_peer_db_uuid, local_path,
+                                           PATH_MAX);
     if (rc)
     {
-        SIMPLE_LOG_MSG(LL_ERROR, "rsbr_recovery_rsync_path_build(): %s",
+        SIMPLE_LOG_MSG(LL_ERROR, "rsbr_recovery_xfer_path_build(): %s",
                        strerror(-rc));
         return rc;
     }
 
-    SIMPLE_LOG_MSG(LL_DEBUG, "rem=%s local=%s", remote_path, local_path);
+    SIMPLE_LOG_MSG(LL_DEBUG, "local=%s", local_path);
 
-    // Perform a dry-run rsync to determine the amount of data to be xfer'd
-    rc = rsbr_bulk_recover_calculate_remaining(rrh, remote_path, local_path,
-                                               available_cap);
+    // Each retry resumes from the contents of 'local_path'
+    rc = RSBR_BULK_RECOVER_RETRY(rsbr_chkpt_xfer, ri, rrh, local_path,
+                                 available_cap);
     if (rc)
-    {
-        SIMPLE_LOG_MSG(LL_ERROR,
-                       "rsbr_bulk_recover_calculate_remaining(pre): %s",
-                       strerror(-rc));
-        return rc;
-    }
+        SIMPLE_LOG_MSG(LL_ERROR, "rsbr_chkpt_xfer(): %s", strerror(-rc));
 
-    // Execute the actual rsync
-    rc = rsbr_bulk_recover_xfer(rrh, remote_path, local_path);
-    if (rc)
-    {
-        SIMPLE_LOG_MSG(LL_ERROR, "rsbr_bulk_recover_xfer(): %s",
-                       strerror(-rc));
-        return rc;
-    }
-
-    // Run another dry-run to ensure that everything is in place.
-    rrh->rrh_remaining = -1;
-    rc = rsbr_bulk_recover_calculate_remaining(rrh, remote_path, local_path,
-                                               available_cap);
-    if (rc)
-    {
-        SIMPLE_LOG_MSG(LL_ERROR,
-                       "rsbr_bulk_recover_calculate_remaining(post): %s",
-                       strerror(-rc));
-        return rc;
-    }
-    else if (rrh->rrh_remaining != 0) // Should prove the xfer is complete
-    {
-        SIMPLE_LOG_MSG(LL_ERROR,
-                       "rrh_remaining(%zd) != 0 after rsbr_bulk_recover_calculate_remaining(post)",
-                       rrh->rrh_remaining);
-
-        return -EBADE;
-    }
-
-    return 0;
+    return rc;
 }
 
 static int
@@ -2200,13 +3141,13 @@ rsbr_bulk_recovery_stage_remote_db(struct raft_instance *ri,
 {
     NIOVA_ASSERT(ri && rrh);
 
-    char rsync_path[PATH_MAX + 1] = {0};
-    int rc = rsbr_recovery_rsync_path_build(ri->ri_log, rrh->rrh_peer_uuid,
-                                            rrh->rrh_peer_db_uuid, rsync_path,
-                                            PATH_MAX);
+    char xfer_path[PATH_MAX + 1] = {0};
+    int rc = rsbr_recovery_xfer_path_build(ri->ri_log, rrh->rrh_peer_uuid,
+                                           rrh->rrh_peer_db_uuid, xfer_path,
+                                           PATH_MAX);
     if (rc)
     {
-        SIMPLE_LOG_MSG(LL_ERROR, "rsbr_recovery_rsync_path_build(): %s",
+        SIMPLE_LOG_MSG(LL_ERROR, "rsbr_recovery_xfer_path_build(): %s",
                        strerror(-rc));
         return rc;
     }
@@ -2221,12 +3162,12 @@ rsbr_bulk_recovery_stage_remote_db(struct raft_instance *ri,
         return rc;
     }
 
-    rc = rename(rsync_path, stage_path);
+    rc = rename(xfer_path, stage_path);
     if (rc)
     {
         rc = -errno;
         SIMPLE_LOG_MSG(LL_ERROR, "rename(`%s' -> `%s'): %s",
-                       rsync_path, stage_path, strerror(-rc));
+                       xfer_path, stage_path, strerror(-rc));
         return rc;
     }
 
@@ -2333,6 +3274,7 @@ rsbr_destroy(struct raft_instance *ri)
             {
                 if (cft->rsrcfe_cf_handles[i])
                 {
+                    raft_net_wr_supp_cf_unregister(cft->rsrcfe_cf_handles[i]);
                     rocksdb_column_family_handle_destroy(cft->rsrcfe_cf_handles[i]);
                     cft->rsrcfe_cf_handles[i] = NULL;
                 }
@@ -2639,6 +3581,21 @@ rsbr_db_open_internal(const struct raft_instance *ri,
 
     rc = (!rir->rir_db || err) ? -ENOENT : 0; // enoent is merely a guess
 
+    // Classify the handles now so the KV CRC path needn't look up CF names
+    if (!rc && cft)
+    {
+        for (size_t i = 0; i < cft->rsrcfe_num_cf; i++)
+        {
+            int reg_rc =
+                raft_net_wr_supp_cf_register(cft->rsrcfe_cf_handles[i],
+                                             cft->rsrcfe_cf_kv_crc[i]);
+            if (reg_rc)
+                SIMPLE_LOG_MSG(LL_WARN,
+                               "raft_net_wr_supp_cf_register(%s): %s",
+                               cft->rsrcfe_cf_names[i], strerror(-reg_rc));
+        }
+    }
+
     SIMPLE_LOG_MSG((rc ? LL_ERROR : LL_WARN), "%s(`%s'): %s (try-create=%s)",
                    (cft && cft->rsrcfe_num_cf) ?
                    "rocksdb_open_column_families" : "rocksdb_open",
@@ -2648,6 +3605,47 @@ rsbr_db_open_internal(const struct raft_instance *ri,
     return rc;
 }
 
+/**
+ * rsbr_entry_key_format_detect - selects the entry key format and entry
+ *    layout from the version stored in the log header.  Dbs created prior to
+ *    the binary key format carry version 0 and continue to use ASCII keys.
+ */
+static int
+rsbr_entry_key_format_detect(struct raft_instance *ri)
+{
+    NIOVA_ASSERT(ri && ri->ri_raft_uuid_str && ri->ri_this_peer_uuid_str);
+
+    struct raft_instance_rocks_db *rir = rsbr_ri_to_rirdb(ri);
+
+    size_t header_key_len = 0;
+    DECL_AND_FMT_STRING_RET_LEN(header_key, (ssize_t)RAFT_ROCKSDB_KEY_LEN_MAX,
+                                (ssize_t *)&header_key_len,
+                                RAFT_LOG_HEADER_FMT,
+                                ri->ri_raft_uuid_str,
+                                ri->ri_this_peer_uuid_str);
+
+    struct raft_log_header rlh = {0};
+
+    int rc = rsbr_get_exact_val_size(rir, header_key, header_key_len,
+                                     (void *)&rlh,
+                                     sizeof(struct raft_log_header));
+    if (rc)
+        return rc;
+
+    if (rlh.rlh_magic != RAFT_HEADER_MAGIC ||
+        rlh.rlh_version >= RAFT_ROCKSDB_LOG_VERSION_MAX)
+        return -EBADMSG;
+
+    rsbr_log_version_apply(rir, rlh.rlh_version);
+
+    DBG_RAFT_INSTANCE(LL_WARN, ri,
+                      "log-version=%lu binary-entry-keys=%d single-kv=%d",
+                      rlh.rlh_version, rir->rir_binary_entry_keys,
+                      rir->rir_single_kv_entries);
+
+    return 0;
+}
+
 /**
  * rsbr_prep_raft_instance_from_db - this function takes the recently opened
  *    rocksdb and scans for "metadata" K/V pairs and checkpoints to prepare
@@ -2660,7 +3658,8 @@ rsbr_prep_raft_instance_from_db(struct raft_instance *ri)
 
     rsb_sm_get_instance_uuid(ri);
 
-    int rc = 0;
+    int rc = rsbr_entry_key_format_detect(ri);
+    FATAL_IF(rc, "rsbr_entry_key_format_detect(): %s", strerror(-rc));
 
     /* Determine the number of entries which this backend instance contains
      * and write that value into the raft_instance structure.
@@ -2881,6 +3880,35 @@ raft_server_get_rocksdb_instance(struct raft_instance *ri)
     return NULL;
 }
 
+/**
+ * raft_server_rocksdb_drop_cf - drops the column family from the instance's
+ *    DB.  The handle is first removed from the write supplement CF cache so
+ *    that a handle allocated later at the same address is classified anew.
+ *    The handle itself remains owned, and is destroyed, by the caller.
+ */
+int
+raft_server_rocksdb_drop_cf(struct raft_instance *ri,
+                            rocksdb_column_family_handle_t *cf_handle)
+{
+    rocksdb_t *db = raft_server_get_rocksdb_instance(ri);
+
+    if (!db || !cf_handle)
+        return -EINVAL;
+
+    raft_net_wr_supp_cf_unregister(cf_handle);
+
+    char *err = NULL;
+    rocksdb_drop_column_family(db, cf_handle, &err);
+    if (err)
+    {
+        DBG_RAFT_INSTANCE(LL_ERROR, ri, "rocksdb_drop_column_family(): %s",
+                          err);
+        return -EIO;
+    }
+
+    return 0;
+}
+
 void
 raft_server_rocksdb_release_cf_table(struct raft_server_rocksdb_cf_table *cft)
 {
@@ -2896,6 +3924,7 @@ raft_server_rocksdb_release_cf_table(struct raft_server_rocksdb_cf_table *cft)
         }
         if (cft->rsrcfe_cf_handles[i])
         {
+            raft_net_wr_supp_cf_unregister(cft->rsrcfe_cf_handles[i]);
             rocksdb_column_family_handle_destroy(cft->rsrcfe_cf_handles[i]);
             cft->rsrcfe_cf_handles[i] = NULL;
         }
@@ -2918,6 +3947,8 @@ raft_server_rocksdb_add_cf_name(struct raft_server_rocksdb_cf_table *cft,
         if (!cft->rsrcfe_cf_names[0])
             return -ENOMEM;
 
+        cft->rsrcfe_cf_kv_crc[0] = false;
+
         cft->rsrcfe_num_cf = 1;
     }
 
@@ -2932,6 +3963,9 @@ raft_server_rocksdb_add_cf_name(struct raft_server_rocksdb_cf_table *cft,
     if (!cft->rsrcfe_cf_names[cft->rsrcfe_num_cf])
         return -ENOMEM;
 
+    cft->rsrcfe_cf_kv_crc[cft->rsrcfe_num_cf] =
+        raft_net_wr_supp_cf_name_is_kv_crc(cf_name, cf_name_len);
+
     cft->rsrcfe_num_cf++;
 
     return 0;
@@ -0,0 +1,1706 @@
+/* Copyright (C) NIOVA Systems, Inc - All Rights Reserved
+ * Unauthorized copying of this file, via any medium is strictly prohibited
+ * Proprietary and confidential
+ * Written by Paul Nowoczynski <00pauln00@gmail.com> 2020
+ */
+
+/* Segmented log backend.  Unlike the flat-file backend, which stores each
+ * entry in a fixed 64k block, entries are appended as variable length
+ * records into a series of preallocated segment files.  The store path is
+ * a directory containing:
+ *
+ *    header              - the log header blocks
+ *    index               - one rsbs_index_rec per entry idx
+ *    segment.<first-idx> - the entry records
+ *    chkpt.<idx>         - the newest checkpoint, see rsbs_checkpoint()
+ *
+ * A segment is named by the idx of its first entry.  Reaping removes whole
+ * segments and punches the matching range out of the index file.
+ */
+#include <sys/mman.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h> // Must precede dirent.h
+#include <dirent.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "alloc.h"
+#include "common.h"
+#include "io.h"
+#include "log.h"
+#include "raft.h"
+#include "registry.h"
+
+#define RAFT_ENTRY_SIZE_SEGMENT RAFT_NET_ENTRY_SIZE_SEGMENT
+
+#define RSBS_HEADER_FILE "header"
+#define RSBS_INDEX_FILE "index"
+#define RSBS_SEGMENT_PREFIX "segment."
+#define RSBS_SEGMENT_NAME_LEN (sizeof(RSBS_SEGMENT_PREFIX) + 16)
+#define RSBS_CHKPT_PREFIX "chkpt."
+#define RSBS_CHKPT_TMP_PREFIX ".in-progress_chkpt."
+#define RSBS_CHKPT_NAME_LEN (sizeof(RSBS_CHKPT_TMP_PREFIX) + 16)
+#define RSBS_CHKPT_COPY_SIZE (64UL * 1024)
+#if defined(UNIT_TEST) // allow tests to span segments with few entries
+#define RSBS_SEGMENT_SIZE (2ULL * RAFT_ENTRY_SIZE_SEGMENT)
+#else
+#define RSBS_SEGMENT_SIZE (64ULL * 1024 * 1024)
+#endif
+#define RSBS_SEGMENTS_MIN 16
+#define RSBS_NUM_LOG_HEADERS 2
+#define RSBS_HEADER_BLOCK_SIZE 4096
+#define RSBS_RECORD_ALIGN 8
+#define RSBS_INDEX_MAGIC 0x5e65a11dU
+#define RSBS_INDEX_PUNCH_ALIGN 4096
+#define RSBS_SCAN_INDEX_BATCH 1024
+
+REGISTRY_ENTRY_FILE_GENERATE;
+
+struct rsbs_index_rec
+{
+    raft_entry_idx_t rsir_segment; // first idx of the segment
+    uint64_t         rsir_offset;
+    uint32_t         rsir_size;
+    uint32_t         rsir_magic;
+};
+
+struct rsbs_segment
+{
+    raft_entry_idx_t rss_first_idx;
+    int              rss_fd;
+};
+
+struct raft_instance_segment
+{
+    pthread_rwlock_t     ris_rwlock; // protects the segment table
+    pthread_mutex_t      ris_dirty_mutex;
+    struct rsbs_segment *ris_segs;
+    size_t               ris_nsegs;
+    size_t               ris_segs_cap;
+    size_t               ris_tail; // append offset in the last segment
+    raft_entry_idx_t     ris_next_idx;
+    raft_entry_idx_t     ris_dirty_idx; // oldest segment written since sync
+    int                  ris_dir_fd;
+    int                  ris_header_fd;
+    int                  ris_index_fd;
+};
+
+static void
+rsbs_entry_write(struct raft_instance *, const struct raft_entry_header *,
+                 const struct iovec *, size_t,
+                 const struct raft_net_sm_write_supplements *);
+
+static ssize_t
+rsbs_entry_read(struct raft_instance *, struct raft_entry *);
+
+static int
+rsbs_entry_header_read(struct raft_instance *, struct raft_entry_header *);
+
+static int
+rsbs_header_write(struct raft_instance *);
+
+static void
+rsbs_log_truncate(struct raft_instance *, const raft_entry_idx_t);
+
+static void
+rsbs_log_reap(struct raft_instance *, const raft_entry_idx_t);
+
+static int
+rsbs_header_load(struct raft_instance *);
+
+static int
+rsbs_setup(struct raft_instance *);
+
+static int
+rsbs_destroy(struct raft_instance *);
+
+static int
+rsbs_sync(struct raft_instance *);
+
+static int
+rsbs_entry_scan(struct raft_instance *, const raft_entry_idx_t,
+                const raft_entry_idx_t, const bool, raft_entry_scan_cb_t,
+                void *);
+
+static int64_t
+rsbs_checkpoint(struct raft_instance *);
+
+static int
+rsbs_chkpt_xfer_read(struct raft_instance *,
+                     const struct raft_chkpt_xfer_request_msg *,
+                     struct raft_chkpt_xfer_reply_msg *, char *, size_t);
+
+static struct raft_instance_backend ribSegment = {
+    .rib_entry_write        = rsbs_entry_write,
+    .rib_entry_read         = rsbs_entry_read,
+    .rib_entry_header_read  = rsbs_entry_header_read,
+    .rib_log_truncate       = rsbs_log_truncate,
+    .rib_log_reap           = rsbs_log_reap,
+    .rib_header_write       = rsbs_header_write,
+    .rib_header_load        = rsbs_header_load,
+    .rib_backend_setup      = rsbs_setup,
+    .rib_backend_shutdown   = rsbs_destroy,
+    .rib_backend_sync       = rsbs_sync,
+    .rib_entry_scan         = rsbs_entry_scan,
+    .rib_backend_checkpoint = rsbs_checkpoint,
+    .rib_chkpt_xfer_read    = rsbs_chkpt_xfer_read,
+};
+
+static inline struct raft_instance_segment *
+rsbs_ri_to_ris(struct raft_instance *ri)
+{
+    NIOVA_ASSERT(ri && ri->ri_backend == &ribSegment && ri->ri_backend_arg);
+
+    return (struct raft_instance_segment *)ri->ri_backend_arg;
+}
+
+static inline void
+rsbs_rdlock(struct raft_instance_segment *ris)
+{
+    NIOVA_ASSERT(!pthread_rwlock_rdlock(&ris->ris_rwlock));
+}
+
+static inline void
+rsbs_wrlock(struct raft_instance_segment *ris)
+{
+    NIOVA_ASSERT(!pthread_rwlock_wrlock(&ris->ris_rwlock));
+}
+
+static inline void
+rsbs_unlock(struct raft_instance_segment *ris)
+{
+    NIOVA_ASSERT(!pthread_rwlock_unlock(&ris->ris_rwlock));
+}
+
+static inline off_t
+rsbs_index_offset(const raft_entry_idx_t idx)
+{
+    NIOVA_ASSERT(idx >= 0);
+
+    return (off_t)(idx * sizeof(struct rsbs_index_rec));
+}
+
+static inline size_t
+rsbs_record_size_aligned(const size_t size)
+{
+    return (size + RSBS_RECORD_ALIGN - 1) & ~(RSBS_RECORD_ALIGN - 1);
+}
+
+static struct rsbs_segment *
+rsbs_segment_last(struct raft_instance_segment *ris)
+{
+    return ris->ris_nsegs ? &ris->ris_segs[ris->ris_nsegs - 1] : NULL;
+}
+
+// Called with ris_rwlock held
+static struct rsbs_segment *
+rsbs_segment_lookup(struct raft_instance_segment *ris,
+                    const raft_entry_idx_t first_idx)
+{
+    size_t lo = 0;
+    size_t hi = ris->ris_nsegs;
+
+    while (lo < hi)
+    {
+        const size_t mid = lo + (hi - lo) / 2;
+        const raft_entry_idx_t x = ris->ris_segs[mid].rss_first_idx;
+
+        if (x == first_idx)
+            return &ris->ris_segs[mid];
+        else if (x < first_idx)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    return NULL;
+}
+
+static void
+rsbs_segment_name(char *name, const raft_entry_idx_t first_idx)
+{
+    snprintf(name, RSBS_SEGMENT_NAME_LEN, RSBS_SEGMENT_PREFIX"%016lx",
+             first_idx);
+}
+
+static int
+rsbs_dir_sync(struct raft_instance_segment *ris)
+{
+    int rc = niova_io_fsync(ris->ris_dir_fd);
+
+    return rc < 0 ? -errno : 0;
+}
+
+static int
+rsbs_open_flags(struct raft_instance *ri)
+{
+    return O_CREAT | O_RDWR |
+        (raft_server_does_synchronous_writes(ri) ? O_SYNC : 0);
+}
+
+// Called with ris_rwlock held for writing
+static int
+rsbs_segment_table_add(struct raft_instance_segment *ris,
+                       const raft_entry_idx_t first_idx, const int fd)
+{
+    if (ris->ris_nsegs == ris->ris_segs_cap)
+    {
+        const size_t cap = MAX(RSBS_SEGMENTS_MIN, ris->ris_segs_cap * 2);
+
+        struct rsbs_segment *segs =
+            niova_calloc(cap, sizeof(struct rsbs_segment));
+        if (!segs)
+            return -ENOMEM;
+
+        if (ris->ris_nsegs)
+            memcpy(segs, ris->ris_segs,
+                   ris->ris_nsegs * sizeof(struct rsbs_segment));
+
+        niova_free(ris->ris_segs);
+        ris->ris_segs = segs;
+        ris->ris_segs_cap = cap;
+    }
+
+    ris->ris_segs[ris->ris_nsegs].rss_first_idx = first_idx;
+    ris->ris_segs[ris->ris_nsegs].rss_fd = fd;
+    ris->ris_nsegs++;
+
+    return 0;
+}
+
+/**
+ * rsbs_segment_create - creates and preallocates the segment which will
+ *    begin with entry 'first_idx' and appends it to the segment table.
+ */
+static int
+rsbs_segment_create(struct raft_instance *ri, const raft_entry_idx_t first_idx)
+{
+    struct raft_instance_segment *ris = rsbs_ri_to_ris(ri);
+    char name[RSBS_SEGMENT_NAME_LEN];
+
+    rsbs_segment_name(name, first_idx);
+
+    int fd = openat(ris->ris_dir_fd, name, rsbs_open_flags(ri) | O_TRUNC,
+                    0600);
+    if (fd < 0)
+    {
+        int rc = -errno;
+        DBG_RAFT_INSTANCE(LL_ERROR, ri, "openat(`%s'): %s", name,
+                          strerror(-rc));
+        return rc;
+    }
+
+    // Fall back to a sparse file if the fs cannot preallocate
+    if (fallocate(fd, 0, 0, RSBS_SEGMENT_SIZE) &&
+        ftruncate(fd, RSBS_SEGMENT_SIZE))
+    {
+        int rc = -errno;
+        DBG_RAFT_INSTANCE(LL_ERROR, ri, "ftruncate(`%s'): %s", name,
+                          strerror(-rc));
+        close(fd);
+        unlinkat(ris->ris_dir_fd, name, 0);
+        return rc;
+    }
+
+    rsbs_wrlock(ris);
+
+    NIOVA_ASSERT(!ris->ris_nsegs ||
+                 rsbs_segment_last(ris)->rss_first_idx < first_idx);
+
+    int rc = rsbs_segment_table_add(ris, first_idx, fd);
+    if (!rc)
+        ris->ris_tail = 0;
+
+    rsbs_unlock(ris);
+
+    if (rc)
+    {
+        close(fd);
+        unlinkat(ris->ris_dir_fd, name, 0);
+        return rc;
+    }
+
+    rc = rsbs_dir_sync(ris);
+
+    DBG_RAFT_INSTANCE((rc ? LL_ERROR : LL_NOTIFY), ri,
+                      "new segment %s: %s", name, strerror(-rc));
+
+    return rc;
+}
+
+// Called with ris_rwlock held for writing
+static void
+rsbs_segment_remove(struct raft_instance_segment *ris, struct rsbs_segment *rss)
+{
+    char name[RSBS_SEGMENT_NAME_LEN];
+
+    rsbs_segment_name(name, rss->rss_first_idx);
+
+    close(rss->rss_fd);
+    rss->rss_fd = -1;
+
+    if (unlinkat(ris->ris_dir_fd, name, 0))
+        SIMPLE_LOG_MSG(LL_WARN, "unlinkat(`%s'): %s", name, strerror(errno));
+}
+
+static void
+rsbs_mark_dirty(struct raft_instance_segment *ris,
+                const raft_entry_idx_t segment)
+{
+    niova_mutex_lock(&ris->ris_dirty_mutex);
+
+    if (ris->ris_dirty_idx < 0 || segment < ris->ris_dirty_idx)
+        ris->ris_dirty_idx = segment;
+
+    niova_mutex_unlock(&ris->ris_dirty_mutex);
+}
+
+static void
+rsbs_entry_write(struct raft_instance *ri, const struct raft_entry_header *reh,
+                 const struct iovec *iov, size_t niov,
+                 const struct raft_net_sm_write_supplements *unused)
+{
+    NIOVA_ASSERT(ri && reh && (iov || !niov));
+
+    (void)unused; // segment-backend does not support wr-supp
+
+    struct raft_instance_segment *ris = rsbs_ri_to_ris(ri);
+    const size_t size = sizeof(struct raft_entry) + reh->reh_data_size;
+
+    // The log is append-only, raft truncates before overwriting entries
+    DBG_RAFT_ENTRY_FATAL_IF((reh->reh_index != ris->ris_next_idx), reh,
+                            "non-append write (next-idx=%ld)",
+                            ris->ris_next_idx);
+
+    if (!ris->ris_nsegs || ris->ris_tail + size > RSBS_SEGMENT_SIZE)
+    {
+        int rc = rsbs_segment_create(ri, reh->reh_index);
+        DBG_RAFT_ENTRY_FATAL_IF((rc), reh, "rsbs_segment_create(): %s",
+                                strerror(-rc));
+    }
+
+    /* Copy the last segment, the checkpoint thread may move the table while
+     * reaping though it never removes the last segment.
+     */
+    rsbs_rdlock(ris);
+    const struct rsbs_segment rss = *rsbs_segment_last(ris);
+    rsbs_unlock(ris);
+
+    const struct rsbs_index_rec rec = {
+        .rsir_segment = rss.rss_first_idx,
+        .rsir_offset = ris->ris_tail,
+        .rsir_size = size,
+        .rsir_magic = RSBS_INDEX_MAGIC,
+    };
+
+    ssize_t rrc = raft_server_entry_pwritev(rss.rss_fd, reh, iov, niov,
+                                            rec.rsir_offset);
+
+    DBG_RAFT_ENTRY((rrc == (ssize_t)size ? LL_DEBUG : LL_FATAL), reh,
+                   "raft_server_entry_pwritev() %s (rrc=%zd size=%zu seg=%lx "
+                   "off=%lu)",
+                   rrc < 0 ? strerror(-rrc) : "Success", rrc, size,
+                   rec.rsir_segment, rec.rsir_offset);
+
+    rrc = niova_io_pwrite(ris->ris_index_fd, (const char *)&rec, sizeof(rec),
+                          rsbs_index_offset(reh->reh_index));
+
+    DBG_RAFT_ENTRY_FATAL_IF((rrc != sizeof(rec)), reh,
+                            "index niova_io_pwrite(): %s (rrc=%zd)",
+                            rrc < 0 ? strerror(-rrc) : "Success", rrc);
+
+    rsbs_mark_dirty(ris, rec.rsir_segment);
+
+    ris->ris_tail += rsbs_record_size_aligned(size);
+    ris->ris_next_idx++;
+}
+
+static int
+rsbs_index_rec_read(struct raft_instance_segment *ris,
+                    const raft_entry_idx_t idx, struct rsbs_index_rec *rec)
+{
+    if (idx < 0)
+        return -EINVAL;
+
+    const ssize_t rrc = niova_io_pread(ris->ris_index_fd, (char *)rec,
+                                       sizeof(*rec), rsbs_index_offset(idx));
+    if (rrc < 0)
+        return (int)rrc;
+
+    // Holes left by reaping read back as zeros
+    else if (rrc != sizeof(*rec) || rec->rsir_magic != RSBS_INDEX_MAGIC ||
+             rec->rsir_offset + rec->rsir_size > RSBS_SEGMENT_SIZE)
+        return -ENOENT;
+
+    return 0;
+}
+
+static ssize_t
+rsbs_read_common(struct raft_instance *ri, struct raft_entry_header *reh,
+                 const size_t expected_sz)
+{
+    if (!ri || !reh)
+        return -EINVAL;
+
+    struct raft_instance_segment *ris = rsbs_ri_to_ris(ri);
+    struct rsbs_index_rec rec;
+
+    int rc = rsbs_index_rec_read(ris, reh->reh_index, &rec);
+    if (rc)
+    {
+        DBG_RAFT_ENTRY(LL_NOTIFY, reh, "rsbs_index_rec_read(): %s",
+                       strerror(-rc));
+        return rc;
+    }
+    else if (expected_sz > rec.rsir_size)
+    {
+        DBG_RAFT_ENTRY(LL_ERROR, reh, "read-sz=%zu exceeds record-sz=%u",
+                       expected_sz, rec.rsir_size);
+        return -EIO;
+    }
+
+    rsbs_rdlock(ris);
+
+    struct rsbs_segment *rss = rsbs_segment_lookup(ris, rec.rsir_segment);
+
+    const ssize_t read_sz = rss ?
+        niova_io_pread(rss->rss_fd, (char *)reh, expected_sz,
+                       rec.rsir_offset) : -ENOENT;
+
+    rsbs_unlock(ris);
+
+    DBG_RAFT_ENTRY((read_sz == (ssize_t)expected_sz ? LL_DEBUG : LL_ERROR),
+                   reh, "niova_io_pread(): %s (rrc=%zd sz=%zu seg=%lx off=%lu)",
+                   read_sz < 0 ? strerror((int)-read_sz) : "Success",
+                   read_sz, expected_sz, rec.rsir_segment, rec.rsir_offset);
+
+    return read_sz;
+}
+
+static ssize_t
+rsbs_entry_read(struct raft_instance *ri, struct raft_entry *re)
+{
+    if (!re)
+        return -EINVAL;
+
+    return rsbs_read_common(ri, &re->re_header,
+                            raft_server_entry_to_total_size(re));
+}
+
+static int
+rsbs_entry_header_read(struct raft_instance *ri, struct raft_entry_header *reh)
+{
+    if (!ri || !reh || reh->reh_index < 0)
+        return -EINVAL;
+
+    const ssize_t rrc = rsbs_read_common(ri, reh, sizeof(*reh));
+
+    if (rrc < 0)
+        return (int)rrc;
+
+    else if (rrc != sizeof(*reh))
+        return -EIO;
+
+    return 0;
+}
+
+/**
+ * rsbs_segment_map - maps the segment beginning at 'first_idx' for reading.
+ *    The mapping is bounded by the current file size rather than
+ *    RSBS_SEGMENT_SIZE since touching pages beyond EOF raises SIGBUS.
+ */
+static int
+rsbs_segment_map(struct raft_instance_segment *ris,
+                 const raft_entry_idx_t first_idx, char **ret_map,
+                 size_t *ret_map_len)
+{
+    rsbs_rdlock(ris);
+
+    struct rsbs_segment *rss = rsbs_segment_lookup(ris, first_idx);
+    struct stat stb;
+    void *map = MAP_FAILED;
+    size_t map_len = 0;
+    int rc = 0;
+
+    if (!rss)
+        rc = -ENOENT;
+
+    else if (fstat(rss->rss_fd, &stb))
+        rc = -errno;
+
+    else if (!stb.st_size)
+        rc = -ENODATA;
+
+    else
+    {
+        map_len = MIN((size_t)stb.st_size, RSBS_SEGMENT_SIZE);
+
+        map = mmap(NULL, map_len, PROT_READ, MAP_SHARED, rss->rss_fd, 0);
+        if (map == MAP_FAILED)
+            rc = -errno;
+    }
+
+    rsbs_unlock(ris);
+
+    if (rc)
+        return rc;
+
+    madvise(map, map_len, MADV_SEQUENTIAL);
+
+    *ret_map = map;
+    *ret_map_len = map_len;
+
+    return 0;
+}
+
+/**
+ * rsbs_entry_scan - reads the index records of [start, end) in batches and
+ *    passes each entry to the callback from a sequential mapping of its
+ *    segment.
+ */
+static int
+rsbs_entry_scan(struct raft_instance *ri, const raft_entry_idx_t start,
+                const raft_entry_idx_t end, const bool with_data,
+                raft_entry_scan_cb_t cb, void *arg)
+{
+    if (!ri || start < 0 || end < start || !cb)
+        return -EINVAL;
+
+    else if (start == end)
+        return 0;
+
+    struct raft_instance_segment *ris = rsbs_ri_to_ris(ri);
+
+    struct rsbs_index_rec *recs =
+        niova_malloc(RSBS_SCAN_INDEX_BATCH * sizeof(struct rsbs_index_rec));
+    if (!recs)
+        return -ENOMEM;
+
+    raft_entry_idx_t map_segment = -1;
+    char *map = NULL;
+    size_t map_len = 0;
+    int rc = 0;
+
+    for (raft_entry_idx_t i = start; i < end && !rc;)
+    {
+        const size_t nrecs = MIN(RSBS_SCAN_INDEX_BATCH, (size_t)(end - i));
+
+        const ssize_t rrc =
+            niova_io_pread(ris->ris_index_fd, (char *)recs,
+                           nrecs * sizeof(struct rsbs_index_rec),
+                           rsbs_index_offset(i));
+        if (rrc < (ssize_t)sizeof(struct rsbs_index_rec))
+        {
+            rc = rrc < 0 ? (int)rrc : -ENOENT;
+            break;
+        }
+
+        const size_t nread = rrc / sizeof(struct rsbs_index_rec);
+
+        for (size_t j = 0; j < nread && !rc; j++, i++)
+        {
+            const struct rsbs_index_rec *rec = &recs[j];
+
+            if (rec->rsir_magic != RSBS_INDEX_MAGIC ||
+                rec->rsir_size < sizeof(struct raft_entry_header) ||
+                rec->rsir_offset + rec->rsir_size > RSBS_SEGMENT_SIZE)
+            {
+                rc = -ENOENT;
+                break;
+            }
+
+            if (rec->rsir_segment != map_segment)
+            {
+                if (map)
+                    munmap(map, map_len);
+
+                map = NULL;
+                map_len = 0;
+                map_segment = -1;
+
+                rc = rsbs_segment_map(ris, rec->rsir_segment, &map,
+                                      &map_len);
+                if (rc)
+                    break;
+
+                map_segment = rec->rsir_segment;
+            }
+
+            // The record must lie within the mapped part of the file
+            if (rec->rsir_offset + rec->rsir_size > map_len)
+            {
+                rc = -EIO;
+                break;
+            }
+
+            const struct raft_entry_header *reh =
+                (const struct raft_entry_header *)&map[rec->rsir_offset];
+
+            if (with_data &&
+                sizeof(struct raft_entry) + reh->reh_data_size >
+                rec->rsir_size)
+            {
+                rc = -EIO;
+                break;
+            }
+
+            rc = cb(arg, reh, with_data ?
+                    &map[rec->rsir_offset +
+                         offsetof(struct raft_entry, re_data)] : NULL);
+        }
+
+        if (rc)
+            DBG_RAFT_INSTANCE(LL_NOTIFY, ri, "idx=%ld: %s", i,
+                              strerror(-rc));
+    }
+
+    if (map)
+        munmap(map, map_len);
+
+    niova_free(recs);
+
+    return rc;
+}
+
+/**
+ * rsbs_log_truncate - removes the entries at and beyond 'entry_idx'.  The
+ *    segments which begin at or after 'entry_idx' are removed and the tail
+ *    of the remaining last segment is set to the end of entry_idx - 1.
+ */
+static void
+rsbs_log_truncate(struct raft_instance *ri, const raft_entry_idx_t entry_idx)
+{
+    NIOVA_ASSERT(ri && entry_idx >= 0);
+
+    struct raft_instance_segment *ris = rsbs_ri_to_ris(ri);
+    struct rsbs_index_rec rec = {0};
+
+    // Locate the new tail, the prior entry may have been reaped
+    if (entry_idx > 0 && rsbs_index_rec_read(ris, entry_idx - 1, &rec))
+        rec.rsir_magic = 0;
+
+    rsbs_wrlock(ris);
+
+    size_t nremoved = 0;
+    struct rsbs_segment *rss;
+
+    while ((rss = rsbs_segment_last(ris)) &&
+           (rss->rss_first_idx >= entry_idx ||
+            (rec.rsir_magic && rss->rss_first_idx > rec.rsir_segment)))
+    {
+        rsbs_segment_remove(ris, rss);
+        ris->ris_nsegs--;
+        nremoved++;
+    }
+
+    rss = rsbs_segment_last(ris);
+
+    /* A remaining segment whose entries can no longer be located is full
+     * as far as the writer is concerned.
+     */
+    ris->ris_tail = !rss ? 0 :
+        (rec.rsir_magic && rss->rss_first_idx == rec.rsir_segment) ?
+        rec.rsir_offset + rsbs_record_size_aligned(rec.rsir_size) :
+        RSBS_SEGMENT_SIZE;
+
+    ris->ris_next_idx = entry_idx;
+
+    rsbs_unlock(ris);
+
+    DBG_RAFT_INSTANCE(LL_DEBUG, ri,
+                      "entry-idx=%ld segments-removed=%zu tail=%zu",
+                      entry_idx, nremoved, ris->ris_tail);
+
+    int rc = niova_io_ftruncate(ris->ris_index_fd,
+                                rsbs_index_offset(entry_idx));
+    FATAL_IF((rc), "niova_io_ftruncate(): %s", strerror(-rc));
+
+    rc = rsbs_sync(ri);
+    FATAL_IF((rc), "rsbs_sync(): %s", strerror(-rc));
+
+    if (nremoved)
+    {
+        rc = rsbs_dir_sync(ris);
+        FATAL_IF((rc), "rsbs_dir_sync(): %s", strerror(-rc));
+    }
+}
+
+/**
+ * rsbs_log_reap - removes the segments whose entries all precede
+ *    'entry_idx'.  The segment holding 'entry_idx' and the last segment are
+ *    always kept so the log is only ever reaped in whole segments.
+ */
+static void // runs in checkpoint thread context
+rsbs_log_reap(struct raft_instance *ri, const raft_entry_idx_t entry_idx)
+{
+    NIOVA_ASSERT(ri && entry_idx >= 0);
+
+    struct raft_instance_segment *ris = rsbs_ri_to_ris(ri);
+
+    rsbs_wrlock(ris);
+
+    size_t nreap = 0;
+    while (nreap + 1 < ris->ris_nsegs &&
+           ris->ris_segs[nreap + 1].rss_first_idx <= entry_idx)
+        rsbs_segment_remove(ris, &ris->ris_segs[nreap++]);
+
+    if (nreap)
+    {
+        ris->ris_nsegs -= nreap;
+        memmove(ris->ris_segs, &ris->ris_segs[nreap],
+                ris->ris_nsegs * sizeof(struct rsbs_segment));
+    }
+
+    const raft_entry_idx_t lowest_idx = ris->ris_segs[0].rss_first_idx;
+
+    rsbs_unlock(ris);
+
+    DBG_RAFT_INSTANCE((nreap ? LL_NOTIFY : LL_DEBUG), ri,
+                      "reap-idx=%ld segments-reaped=%zu lowest-stored=%ld",
+                      entry_idx, nreap, lowest_idx);
+
+    if (!nreap)
+        return;
+
+    int rc = rsbs_dir_sync(ris);
+    FATAL_IF((rc), "rsbs_dir_sync(): %s", strerror(-rc));
+
+    // Release the index space of the reaped entries, this is best effort
+    const off_t punch_len = rsbs_index_offset(lowest_idx) &
+        ~((off_t)RSBS_INDEX_PUNCH_ALIGN - 1);
+
+    if (punch_len &&
+        fallocate(ris->ris_index_fd, FALLOC_FL_PUNCH_HOLE |
+                  FALLOC_FL_KEEP_SIZE, 0, punch_len))
+        DBG_RAFT_INSTANCE(LL_NOTIFY, ri, "fallocate(PUNCH_HOLE): %s",
+                          strerror(errno));
+}
+
+static void
+rsbs_chkpt_name(char *name, const raft_entry_idx_t chkpt_idx, const bool tmp)
+{
+    snprintf(name, RSBS_CHKPT_NAME_LEN, "%s%016lx",
+             tmp ? RSBS_CHKPT_TMP_PREFIX : RSBS_CHKPT_PREFIX, chkpt_idx);
+}
+
+/**
+ * rsbs_chkpt_remove - removes the checkpoint directory 'name' along with
+ *    its contents.  A missing directory is not an error.
+ */
+static int
+rsbs_chkpt_remove(struct raft_instance_segment *ris, const char *name)
+{
+    int fd = openat(ris->ris_dir_fd, name, O_RDONLY | O_DIRECTORY);
+    if (fd < 0)
+        return errno == ENOENT ? 0 : -errno;
+
+    DIR *dir = fdopendir(fd);
+    if (!dir)
+    {
+        int rc = -errno;
+        close(fd);
+        return rc;
+    }
+
+    int rc = 0;
+    struct dirent *dent;
+
+    while ((dent = readdir(dir)))
+        if (dent->d_name[0] != '.' &&
+            unlinkat(dirfd(dir), dent->d_name, 0) && !rc)
+            rc = -errno;
+
+    closedir(dir);
+
+    if (!rc && unlinkat(ris->ris_dir_fd, name, AT_REMOVEDIR))
+        rc = -errno;
+
+    return rc;
+}
+
+/**
+ * rsbs_chkpt_cleanup - removes the checkpoints older than 'chkpt_idx' and
+ *    any which were left incomplete.
+ */
+static void
+rsbs_chkpt_cleanup(struct raft_instance *ri, const raft_entry_idx_t chkpt_idx)
+{
+    struct raft_instance_segment *ris = rsbs_ri_to_ris(ri);
+
+    int dup_fd = dup(ris->ris_dir_fd);
+    DIR *dir = dup_fd < 0 ? NULL : fdopendir(dup_fd);
+    if (!dir)
+    {
+        SIMPLE_LOG_MSG(LL_WARN, "fdopendir(`%s'): %s", ri->ri_log,
+                       strerror(errno));
+        if (dup_fd >= 0)
+            close(dup_fd);
+
+        return;
+    }
+
+    struct dirent *dent;
+
+    while ((dent = readdir(dir)))
+    {
+        bool remove = !strncmp(dent->d_name, RSBS_CHKPT_TMP_PREFIX,
+                               sizeof(RSBS_CHKPT_TMP_PREFIX) - 1);
+
+        if (!remove && !strncmp(dent->d_name, RSBS_CHKPT_PREFIX,
+                                sizeof(RSBS_CHKPT_PREFIX) - 1))
+            remove = strtoll(&dent->d_name[sizeof(RSBS_CHKPT_PREFIX) - 1],
+                             NULL, 16) < chkpt_idx;
+
+        int rc = remove ? rsbs_chkpt_remove(ris, dent->d_name) : 0;
+        if (rc)
+            SIMPLE_LOG_MSG(LL_WARN, "rsbs_chkpt_remove(`%s'): %s",
+                           dent->d_name, strerror(-rc));
+    }
+
+    closedir(dir);
+}
+
+/**
+ * rsbs_chkpt_copy - copies [off, end) of 'src_fd' to the same range of
+ *    'dst_fd' and syncs the copy.
+ */
+static int
+rsbs_chkpt_copy(const int src_fd, const int dst_fd, off_t off,
+                const off_t end)
+{
+    char *buf = niova_malloc(RSBS_CHKPT_COPY_SIZE);
+    if (!buf)
+        return -ENOMEM;
+
+    int rc = 0;
+
+    while (!rc && off < end)
+    {
+        const size_t len = MIN(RSBS_CHKPT_COPY_SIZE, (size_t)(end - off));
+
+        ssize_t rrc = niova_io_pread(src_fd, buf, len, off);
+        if (rrc == (ssize_t)len)
+            rrc = niova_io_pwrite(dst_fd, buf, len, off);
+
+        if (rrc != (ssize_t)len)
+            rc = rrc < 0 ? (int)rrc : -EIO;
+
+        off += len;
+    }
+
+    niova_free(buf);
+
+    if (!rc && niova_io_fsync(dst_fd) < 0)
+        rc = -errno;
+
+    return rc;
+}
+
+/**
+ * rsbs_chkpt_fill - populates the checkpoint directory 'chkpt_fd' with the
+ *    log through 'chkpt_idx'.  Runs in the checkpoint thread which is also
+ *    the only reaper, so the segments found here stay in place.
+ */
+static int
+rsbs_chkpt_fill(struct raft_instance *ri, const int chkpt_fd,
+                const raft_entry_idx_t chkpt_idx)
+{
+    struct raft_instance_segment *ris = rsbs_ri_to_ris(ri);
+    raft_entry_idx_t lowest_idx = -1;
+    int rc = 0;
+
+    rsbs_rdlock(ris);
+
+    for (size_t i = 0; i < ris->ris_nsegs && !rc; i++)
+    {
+        const raft_entry_idx_t first_idx = ris->ris_segs[i].rss_first_idx;
+        if (first_idx > chkpt_idx)
+            break;
+
+        char name[RSBS_SEGMENT_NAME_LEN];
+        rsbs_segment_name(name, first_idx);
+
+        if (linkat(ris->ris_dir_fd, name, chkpt_fd, name, 0))
+            rc = -errno;
+        else if (lowest_idx < 0)
+            lowest_idx = first_idx;
+    }
+
+    rsbs_unlock(ris);
+
+    if (rc || lowest_idx < 0)
+        return rc ? rc : -ENOENT;
+
+    struct stat stb;
+    if (fstat(ris->ris_header_fd, &stb))
+        return -errno;
+
+    const int src_fds[] = {ris->ris_header_fd, ris->ris_index_fd};
+    const char *names[] = {RSBS_HEADER_FILE, RSBS_INDEX_FILE};
+    const off_t start[] = {0, rsbs_index_offset(lowest_idx)};
+    const off_t end[] = {stb.st_size, rsbs_index_offset(chkpt_idx + 1)};
+
+    for (size_t i = 0; i < ARRAY_SIZE(src_fds) && !rc; i++)
+    {
+        int fd = openat(chkpt_fd, names[i], O_CREAT | O_TRUNC | O_WRONLY,
+                        0600);
+        if (fd < 0)
+            return -errno;
+
+        rc = rsbs_chkpt_copy(src_fds[i], fd, start[i], end[i]);
+
+        close(fd);
+    }
+
+    return rc;
+}
+
+/**
+ * rsbs_checkpoint - captures the log through the compaction idx into the
+ *    directory chkpt.<idx>.  The entries through that idx are immutable, so
+ *    their segments are hard linked rather than copied, while the header and
+ *    the matching part of the index are copied.  Reaping the log then leaves
+ *    the checkpointed entries in place.  Only the newest checkpoint is kept.
+ */
+static int64_t // checkpoint thread context
+rsbs_checkpoint(struct raft_instance *ri)
+{
+    if (!ri)
+        return -EINVAL;
+
+    struct raft_instance_segment *ris = rsbs_ri_to_ris(ri);
+
+    const raft_entry_idx_t chkpt_idx =
+        raft_server_instance_chkpt_compact_max_idx(ri);
+
+    if (chkpt_idx < 0) // Don't checkpoint if the log is empty
+        return -ENODATA;
+
+    else if (chkpt_idx == ri->ri_checkpoint_last_idx)
+        return -EALREADY;
+
+    char name[RSBS_CHKPT_NAME_LEN];
+    char tmp_name[RSBS_CHKPT_NAME_LEN];
+
+    rsbs_chkpt_name(name, chkpt_idx, false);
+    rsbs_chkpt_name(tmp_name, chkpt_idx, true);
+
+    // The rename below is atomic so an existing checkpoint is complete
+    struct stat stb;
+    if (!fstatat(ris->ris_dir_fd, name, &stb, 0))
+        return -EALREADY;
+
+    int rc = rsbs_chkpt_remove(ris, tmp_name);
+    if (!rc && mkdirat(ris->ris_dir_fd, tmp_name, 0700))
+        rc = -errno;
+
+    int chkpt_fd = rc ? -1 :
+        openat(ris->ris_dir_fd, tmp_name, O_RDONLY | O_DIRECTORY);
+
+    if (!rc && chkpt_fd < 0)
+        rc = -errno;
+
+    if (!rc)
+        rc = rsbs_chkpt_fill(ri, chkpt_fd, chkpt_idx);
+
+    if (!rc && niova_io_fsync(chkpt_fd) < 0)
+        rc = -errno;
+
+    if (chkpt_fd >= 0)
+        close(chkpt_fd);
+
+    if (!rc && renameat(ris->ris_dir_fd, tmp_name, ris->ris_dir_fd, name))
+        rc = -errno;
+
+    if (!rc)
+        rc = rsbs_dir_sync(ris);
+
+    DBG_RAFT_INSTANCE((rc ? LL_ERROR : LL_NOTIFY), ri, "checkpoint@%s: %s",
+                      name, strerror(-rc));
+
+    if (rc)
+    {
+        rsbs_chkpt_remove(ris, tmp_name);
+        return rc;
+    }
+
+    rsbs_chkpt_cleanup(ri, chkpt_idx);
+
+    return chkpt_idx;
+}
+
+static int
+rsbs_chkpt_xfer_file_list(const int chkpt_fd,
+                          struct raft_chkpt_xfer_reply_msg *rcxrp, char *buf,
+                          size_t buf_sz)
+{
+    int dup_fd = dup(chkpt_fd);
+    if (dup_fd < 0)
+        return -errno;
+
+    DIR *dir = fdopendir(dup_fd);
+    if (!dir)
+    {
+        int rc = -errno;
+        close(dup_fd);
+        return rc;
+    }
+
+    struct raft_chkpt_xfer_file *files = (struct raft_chkpt_xfer_file *)buf;
+    const size_t max_files = buf_sz / sizeof(struct raft_chkpt_xfer_file);
+    size_t nfiles = 0;
+    struct dirent *dent;
+    int rc = 0;
+
+    while (!rc && (dent = readdir(dir)))
+    {
+        struct stat stb;
+
+        if (fstatat(dirfd(dir), dent->d_name, &stb, 0))
+            rc = -errno;
+
+        else if (!S_ISREG(stb.st_mode))
+            continue;
+
+        else if (nfiles == max_files)
+            rc = -E2BIG;
+
+        else
+        {
+            files[nfiles].rcxf_size = stb.st_size;
+            strncpy(files[nfiles].rcxf_name, dent->d_name,
+                    RAFT_CHKPT_XFER_NAME_MAX);
+            nfiles++;
+        }
+    }
+
+    closedir(dir);
+
+    if (rc)
+        return rc;
+
+    rcxrp->rcxrpm_len = nfiles * sizeof(struct raft_chkpt_xfer_file);
+    rcxrp->rcxrpm_data_sz = rcxrp->rcxrpm_len;
+    rcxrp->rcxrpm_crc =
+        niova_crc((const unsigned char *)buf, rcxrp->rcxrpm_len, 0);
+
+    return 0;
+}
+
+/**
+ * rsbs_chkpt_xfer_read - serves a peer's request for this peer's checkpoint,
+ *    in the same manner as the rocksdb backend.  An empty name requests the
+ *    checkpoint's file list, otherwise a chunk of the named file is read.
+ */
+static int
+rsbs_chkpt_xfer_read(struct raft_instance *ri,
+                     const struct raft_chkpt_xfer_request_msg *rcxrq,
+                     struct raft_chkpt_xfer_reply_msg *rcxrp, char *buf,
+                     size_t buf_sz)
+{
+    if (!ri || !rcxrq || !rcxrp || !buf || rcxrq->rcxrqm_chkpt_idx < 0)
+        return -EINVAL;
+
+    const char *name = rcxrq->rcxrqm_name;
+
+    // The name may not lead outside of the checkpoint directory
+    if (name[0] &&
+        (!memchr(name, '\0', RAFT_CHKPT_XFER_NAME_MAX) || strchr(name, '/') ||
+         name[0] == '.' || rcxrq->rcxrqm_offset < 0))
+        return -EINVAL;
+
+    else if (name[0] && rcxrq->rcxrqm_len > buf_sz)
+        return -EMSGSIZE;
+
+    struct raft_instance_segment *ris = rsbs_ri_to_ris(ri);
+    char chkpt_name[RSBS_CHKPT_NAME_LEN];
+
+    rsbs_chkpt_name(chkpt_name, rcxrq->rcxrqm_chkpt_idx, false);
+
+    int chkpt_fd = openat(ris->ris_dir_fd, chkpt_name,
+                          O_RDONLY | O_DIRECTORY);
+    if (chkpt_fd < 0)
+        return -errno;
+
+    if (!name[0])
+    {
+        int rc = rsbs_chkpt_xfer_file_list(chkpt_fd, rcxrp, buf, buf_sz);
+        close(chkpt_fd);
+
+        return rc;
+    }
+
+    int fd = openat(chkpt_fd, name, O_RDONLY);
+    int rc = fd < 0 ? -errno : 0;
+
+    close(chkpt_fd);
+
+    if (rc)
+        return rc;
+
+    ssize_t rrc = niova_io_pread(fd, buf, rcxrq->rcxrqm_len,
+                                 rcxrq->rcxrqm_offset);
+    close(fd);
+
+    if (rrc < 0)
+    {
+        SIMPLE_LOG_MSG(LL_NOTIFY, "niova_io_pread(`%s/%s'): %s", chkpt_name,
+                       name, strerror((int)-rrc));
+        return (int)rrc;
+    }
+
+    rcxrp->rcxrpm_len = rrc;
+    rcxrp->rcxrpm_crc = niova_crc((const unsigned char *)buf, rrc, 0);
+    rcxrp->rcxrpm_data_sz = rcxrq->rcxrqm_crc_only ? 0 : rrc;
+
+    return 0;
+}
+
+static int
+rsbs_header_load(struct raft_instance *ri)
+{
+    if (!ri)
+        return -EINVAL;
+
+    struct raft_instance_segment *ris = rsbs_ri_to_ris(ri);
+    struct raft_log_header most_recent_rlh = {0};
+
+#if defined(__clang__)
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wgnu-variable-sized-type-not-at-end"
+#endif
+    struct
+    {
+        struct raft_entry      re;
+        struct raft_log_header rlh;
+    } entry_and_header;
+#if defined(__clang__)
+#pragma clang diagnostic pop
+#endif
+
+    for (int i = 0; i < RSBS_NUM_LOG_HEADERS; i++)
+    {
+        memset(&entry_and_header, 0, sizeof(entry_and_header));
+
+        ssize_t rrc = niova_io_pread(ris->ris_header_fd,
+                                     (char *)&entry_and_header,
+                                     sizeof(entry_and_header),
+                                     i * RSBS_HEADER_BLOCK_SIZE);
+        if (rrc != sizeof(entry_and_header))
+        {
+            DBG_RAFT_INSTANCE(LL_ERROR, ri,
+                              "header@idx-%d read returns rrc=%zd", i, rrc);
+            continue;
+        }
+
+        int rc = raft_server_entry_check_crc(&entry_and_header.re);
+        if (rc)
+        {
+            DBG_RAFT_INSTANCE(LL_ERROR, ri,
+                              "raft_server_entry_check_crc(): %s (idx-%d)",
+                              strerror(-rc), i);
+            continue;
+        }
+
+        if (most_recent_rlh.rlh_magic != RAFT_HEADER_MAGIC ||
+            entry_and_header.rlh.rlh_seqno > most_recent_rlh.rlh_seqno)
+            most_recent_rlh = entry_and_header.rlh;
+    }
+
+    if (most_recent_rlh.rlh_magic != RAFT_HEADER_MAGIC)
+        return -EBADMSG; // No valid header entries were found
+
+    ri->ri_log_hdr = most_recent_rlh;
+
+    DBG_RAFT_INSTANCE(LL_NOTIFY, ri, "");
+
+    return 0;
+}
+
+/**
+ * rsbs_header_write - store the current raft state into the log header
+ *    block selected by the header's seqno.
+ */
+static int
+rsbs_header_write(struct raft_instance *ri)
+{
+    if (!ri)
+        return -EINVAL;
+
+    struct raft_instance_segment *ris = rsbs_ri_to_ris(ri);
+
+    const raft_entry_idx_t block_num =
+        ri->ri_log_hdr.rlh_seqno % RSBS_NUM_LOG_HEADERS;
+
+#if defined(__clang__)
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wgnu-variable-sized-type-not-at-end"
+#endif
+    struct
+    {
+        struct raft_entry      re;
+        struct raft_log_header rlh;
+    } entry_and_header;
+#if defined(__clang__)
+#pragma clang diagnostic pop
+#endif
+
+    COMPILE_TIME_ASSERT(sizeof(entry_and_header) <= RSBS_HEADER_BLOCK_SIZE);
+
+    struct raft_entry *re = &entry_and_header.re;
+
+    // log block entry indexes are negative
+    raft_server_entry_init_for_log_header(ri, re,
+                                          block_num - RSBS_NUM_LOG_HEADERS,
+                                          ri->ri_log_hdr.rlh_term,
+                                          (const char *)&ri->ri_log_hdr,
+                                          sizeof(struct raft_log_header));
+
+    const ssize_t write_sz =
+        niova_io_pwrite(ris->ris_header_fd, (const char *)&entry_and_header,
+                        raft_server_entry_to_total_size(re),
+                        block_num * RSBS_HEADER_BLOCK_SIZE);
+
+    int rc = (write_sz == (ssize_t)raft_server_entry_to_total_size(re)) ?
+        0 : -EIO;
+
+    int sync_rc = niova_io_fsync(ris->ris_header_fd) < 0 ? -errno : 0;
+
+    DBG_RAFT_ENTRY(((rc || sync_rc) ? LL_ERROR : LL_DEBUG), &re->re_header,
+                   "niova_io_pwrite(): %s:%s (rrc=%zd block=%ld)",
+                   strerror(-rc), strerror(-sync_rc), write_sz, block_num);
+
+    return rc ? rc : sync_rc;
+}
+
+/**
+ * rsbs_sync - flushes the segments written since the last sync followed by
+ *    the index.  The sync thread may run this while the raft thread appends.
+ */
+static int
+rsbs_sync(struct raft_instance *ri)
+{
+    if (!ri)
+        return -EINVAL;
+
+    struct raft_instance_segment *ris = rsbs_ri_to_ris(ri);
+
+    niova_mutex_lock(&ris->ris_dirty_mutex);
+
+    const raft_entry_idx_t dirty_idx = ris->ris_dirty_idx;
+    ris->ris_dirty_idx = -1;
+
+    niova_mutex_unlock(&ris->ris_dirty_mutex);
+
+    int rc = 0;
+
+    rsbs_rdlock(ris);
+
+    // Appends only go to the dirty segment and those created after it
+    for (size_t i = 0; dirty_idx >= 0 && i < ris->ris_nsegs && !rc; i++)
+        if (ris->ris_segs[i].rss_first_idx >= dirty_idx &&
+            niova_io_fsync(ris->ris_segs[i].rss_fd) < 0)
+            rc = -errno;
+
+    rsbs_unlock(ris);
+
+    if (!rc && niova_io_fsync(ris->ris_index_fd) < 0)
+        rc = -errno;
+
+    // Retry on the next sync
+    if (rc)
+        rsbs_mark_dirty(ris, dirty_idx);
+
+    return rc;
+}
+
+static int
+rsbs_openat(struct raft_instance *ri, const char *name, const int flags)
+{
+    struct raft_instance_segment *ris = rsbs_ri_to_ris(ri);
+
+    int fd = openat(ris->ris_dir_fd, name, flags, 0600);
+    if (fd < 0)
+    {
+        fd = -errno;
+        SIMPLE_LOG_MSG(LL_ERROR, "openat(`%s/%s'): %s", ri->ri_log, name,
+                       strerror(-fd));
+    }
+
+    return fd;
+}
+
+static int
+rsbs_setup_initialize_headers(struct raft_instance *ri)
+{
+    memset(&ri->ri_log_hdr, 0, sizeof(struct raft_log_header));
+
+    // Since we're initializing the header block this is ok
+    ri->ri_log_hdr.rlh_magic = RAFT_HEADER_MAGIC;
+
+    for (int i = 0; i < RSBS_NUM_LOG_HEADERS; i++)
+    {
+        int rc = rsbs_header_write(ri);
+        if (rc)
+            return rc;
+
+        /* Force the seqno increment here.  Typically, this is done through
+         *   raft_server_log_header_write_prep().
+         */
+        ri->ri_log_hdr.rlh_seqno++;
+    }
+
+    return 0;
+}
+
+static int
+rsbs_segments_cmp(const void *a, const void *b)
+{
+    const struct rsbs_segment *x = a;
+    const struct rsbs_segment *y = b;
+
+    return x->rss_first_idx < y->rss_first_idx ? -1 :
+        x->rss_first_idx > y->rss_first_idx ? 1 : 0;
+}
+
+/**
+ * rsbs_segments_load - opens the existing segments and places them into the
+ *    segment table in idx order.
+ */
+static int
+rsbs_segments_load(struct raft_instance *ri)
+{
+    struct raft_instance_segment *ris = rsbs_ri_to_ris(ri);
+
+    int dup_fd = dup(ris->ris_dir_fd);
+    if (dup_fd < 0)
+        return -errno;
+
+    DIR *dir = fdopendir(dup_fd);
+    if (!dir)
+    {
+        int rc = -errno;
+        close(dup_fd);
+        return rc;
+    }
+
+    int rc = 0;
+    struct dirent *dent;
+
+    while (!rc && (dent = readdir(dir)))
+    {
+        if (strncmp(dent->d_name, RSBS_SEGMENT_PREFIX,
+                    sizeof(RSBS_SEGMENT_PREFIX) - 1))
+            continue;
+
+        char *end = NULL;
+        const raft_entry_idx_t first_idx =
+            strtoll(&dent->d_name[sizeof(RSBS_SEGMENT_PREFIX) - 1], &end, 16);
+
+        if (!end || *end != '\0' || first_idx < 0)
+        {
+            SIMPLE_LOG_MSG(LL_WARN, "ignoring `%s/%s'", ri->ri_log,
+                           dent->d_name);
+            continue;
+        }
+
+        int fd = rsbs_openat(ri, dent->d_name, rsbs_open_flags(ri));
+        if (fd < 0)
+        {
+            rc = fd;
+            break;
+        }
+
+        // The table is sorted once all segments have been found
+        rc = rsbs_segment_table_add(ris, first_idx, fd);
+        if (rc)
+            close(fd);
+    }
+
+    closedir(dir);
+
+    if (!rc && ris->ris_nsegs)
+        qsort(ris->ris_segs, ris->ris_nsegs, sizeof(struct rsbs_segment),
+              rsbs_segments_cmp);
+
+    return rc;
+}
+
+/**
+ * rsbs_entry_verify - reads the entry referenced by 'rec' and checks that it
+ *    is entry 'idx' and that its crc is intact.
+ */
+static int
+rsbs_entry_verify(struct raft_instance_segment *ris,
+                  const raft_entry_idx_t idx,
+                  const struct rsbs_index_rec *rec)
+{
+    const struct rsbs_segment *rss =
+        rsbs_segment_lookup(ris, rec->rsir_segment);
+
+    if (!rss)
+        return -ENOENT;
+
+    else if (rec->rsir_size < sizeof(struct raft_entry))
+        return -EBADMSG;
+
+    struct raft_entry *re = niova_malloc(rec->rsir_size);
+    if (!re)
+        return -ENOMEM;
+
+    ssize_t rrc = niova_io_pread(rss->rss_fd, (char *)re, rec->rsir_size,
+                                 rec->rsir_offset);
+
+    int rc = rrc < 0 ? (int)rrc : (rrc != rec->rsir_size ? -EIO : 0);
+
+    if (!rc && (re->re_header.reh_magic != RAFT_ENTRY_MAGIC ||
+                re->re_header.reh_index != idx ||
+                raft_server_entry_to_total_size(re) != rec->rsir_size))
+        rc = -EBADMSG;
+
+    if (!rc)
+        rc = raft_server_entry_check_crc(re);
+
+    niova_free(re);
+
+    return rc;
+}
+
+/**
+ * rsbs_entries_detect - finds the highest idx whose index record and entry
+ *    are intact and sets the append position behind it.  Entries which were
+ *    not synced before a crash may have been written in part, these are
+ *    checked from the end of the log and dropped along with any segment which
+ *    only held such entries.  A bad entry beneath the newest intact one is
+ *    left for the raft startup scan, which fails on it.
+ */
+static int
+rsbs_entries_detect(struct raft_instance *ri)
+{
+    struct raft_instance_segment *ris = rsbs_ri_to_ris(ri);
+    struct stat stb;
+
+    if (fstat(ris->ris_index_fd, &stb))
+        return -errno;
+
+    const raft_entry_idx_t nrecs = stb.st_size / sizeof(struct rsbs_index_rec);
+    const raft_entry_idx_t lowest_idx =
+        ris->ris_nsegs ? ris->ris_segs[0].rss_first_idx : 0;
+
+    raft_entry_idx_t idx = nrecs;
+    struct rsbs_index_rec rec = {0};
+
+    while (--idx >= lowest_idx)
+    {
+        int rc = rsbs_index_rec_read(ris, idx, &rec);
+        if (!rc)
+            rc = rsbs_entry_verify(ris, idx, &rec);
+
+        if (!rc)
+            break;
+
+        else if (rc == -ENOMEM)
+            return rc;
+
+        SIMPLE_LOG_MSG(LL_WARN, "dropping entry-idx=%ld: %s", idx,
+                       strerror(-rc));
+    }
+
+    if (idx >= lowest_idx)
+    {
+        size_t nremoved = 0;
+        struct rsbs_segment *last;
+
+        rsbs_wrlock(ris);
+
+        while ((last = rsbs_segment_last(ris)) &&
+               last->rss_first_idx > rec.rsir_segment)
+        {
+            rsbs_segment_remove(ris, last);
+            ris->ris_nsegs--;
+            nremoved++;
+        }
+
+        rsbs_unlock(ris);
+
+        int rc = nremoved ? rsbs_dir_sync(ris) : 0;
+
+        if (!rc && idx + 1 < nrecs)
+            rc = niova_io_ftruncate(ris->ris_index_fd,
+                                    rsbs_index_offset(idx + 1));
+        if (rc)
+            return rc;
+    }
+
+    struct rsbs_segment *rss = rsbs_segment_last(ris);
+
+    if (idx < lowest_idx || !rss)
+    {
+        idx = -1;
+        ris->ris_tail = rss ? RSBS_SEGMENT_SIZE : 0;
+    }
+    else
+    {
+        ris->ris_tail = rss->rss_first_idx == rec.rsir_segment ?
+            rec.rsir_offset + rsbs_record_size_aligned(rec.rsir_size) :
+            RSBS_SEGMENT_SIZE;
+    }
+
+    ri->ri_entries_detected_at_startup = idx + 1;
+    ris->ris_next_idx = idx + 1;
+
+    niova_atomic_init(&ri->ri_lowest_idx, idx >= 0 ? lowest_idx : -1);
+
+    SIMPLE_LOG_MSG(LL_WARN, "entry-idxs: lowest=%ld highest=%ld segments=%zu",
+                   idx >= 0 ? lowest_idx : -1, idx, ris->ris_nsegs);
+
+    return 0;
+}
+
+static int
+rsbs_log_setup(struct raft_instance *ri)
+{
+    struct raft_instance_segment *ris = rsbs_ri_to_ris(ri);
+
+    if (mkdir(ri->ri_log, 0700) && errno != EEXIST)
+    {
+        int rc = -errno;
+        SIMPLE_LOG_MSG(LL_ERROR, "mkdir(`%s'): %s", ri->ri_log, strerror(-rc));
+        return rc;
+    }
+
+    ris->ris_dir_fd = open(ri->ri_log, O_RDONLY | O_DIRECTORY);
+    if (ris->ris_dir_fd < 0)
+    {
+        int rc = -errno;
+        SIMPLE_LOG_MSG(LL_ERROR, "open(`%s'): %s", ri->ri_log, strerror(-rc));
+        return rc;
+    }
+
+    ris->ris_header_fd = rsbs_openat(ri, RSBS_HEADER_FILE, O_CREAT | O_RDWR);
+    if (ris->ris_header_fd < 0)
+        return ris->ris_header_fd;
+
+    ris->ris_index_fd = rsbs_openat(ri, RSBS_INDEX_FILE, rsbs_open_flags(ri));
+    if (ris->ris_index_fd < 0)
+        return ris->ris_index_fd;
+
+    struct stat stb;
+    if (fstat(ris->ris_header_fd, &stb))
+        return -errno;
+
+    // Initialize the log header if the store was just created
+    if (!stb.st_size)
+    {
+        int rc = rsbs_setup_initialize_headers(ri);
+        if (rc)
+        {
+            SIMPLE_LOG_MSG(LL_ERROR, "rsbs_setup_initialize_headers(): %s",
+                           strerror(-rc));
+            return rc;
+        }
+
+        rc = rsbs_dir_sync(ris);
+        if (rc)
+            return rc;
+    }
+
+    int rc = rsbs_segments_load(ri);
+    if (rc)
+    {
+        SIMPLE_LOG_MSG(LL_ERROR, "rsbs_segments_load(): %s", strerror(-rc));
+        return rc;
+    }
+
+    return rsbs_entries_detect(ri);
+}
+
+static void
+rsbs_set_db_uuid(struct raft_instance *ri)
+{
+    const struct ctl_svc_node_raft_peer *csnp =
+        &ri->ri_csn_this_peer->csn_peer.csnp_raft_info;
+
+    uuid_copy(ri->ri_db_uuid, csnp->csnrp_member.csrm_peer);
+}
+
+static int
+rsbs_destroy(struct raft_instance *ri)
+{
+    if (!ri)
+        return -EINVAL;
+
+    struct raft_instance_segment *ris = rsbs_ri_to_ris(ri);
+
+    for (size_t i = 0; i < ris->ris_nsegs; i++)
+        close(ris->ris_segs[i].rss_fd);
+
+    niova_free(ris->ris_segs);
+
+    int fds[] = {ris->ris_index_fd, ris->ris_header_fd, ris->ris_dir_fd};
+    int rc = 0;
+
+    for (size_t i = 0; i < ARRAY_SIZE(fds); i++)
+        if (fds[i] >= 0 && close(fds[i]) && !rc)
+            rc = -errno;
+
+    pthread_mutex_destroy(&ris->ris_dirty_mutex);
+    pthread_rwlock_destroy(&ris->ris_rwlock);
+
+    niova_free(ri->ri_backend_arg);
+    ri->ri_backend_arg = NULL;
+    ri->ri_backend = NULL;
+
+    return rc;
+}
+
+static int
+rsbs_setup(struct raft_instance *ri)
+{
+    if (!ri || ri->ri_backend != &ribSegment || !ri->ri_csn_this_peer)
+        return -EINVAL;
+
+    else if (ri->ri_backend_arg)
+        return -EALREADY;
+
+    CONST_OVERRIDE(size_t, ri->ri_max_entry_size, RAFT_ENTRY_SIZE_SEGMENT);
+
+    struct raft_instance_segment *ris =
+        niova_calloc(1UL, sizeof(struct raft_instance_segment));
+    if (!ris)
+        return -ENOMEM;
+
+    ris->ris_dir_fd = ris->ris_header_fd = ris->ris_index_fd = -1;
+    ris->ris_dirty_idx = -1;
+
+    FATAL_IF((pthread_rwlock_init(&ris->ris_rwlock, NULL)),
+             "pthread_rwlock_init(): %s", strerror(errno));
+
+    FATAL_IF((pthread_mutex_init(&ris->ris_dirty_mutex, NULL)),
+             "pthread_mutex_init(): %s", strerror(errno));
+
+    ri->ri_backend_arg = ris;
+
+    int rc = rsbs_log_setup(ri);
+    if (rc)
+    {
+        DBG_RAFT_INSTANCE(LL_ERROR, ri, "rsbs_log_setup(): %s",
+                          strerror(-rc));
+
+        rsbs_destroy(ri);
+        return rc;
+    }
+
+    rsbs_set_db_uuid(ri);
+
+    return 0;
+}
+
+void
+raft_server_backend_use_segment(struct raft_instance *ri)
+{
+    NIOVA_ASSERT(ri && !ri->ri_backend);
+
+    ri->ri_backend = &ribSegment;
+}
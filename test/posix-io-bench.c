@@ -0,0 +1,283 @@
+/* Copyright (C) NIOVA Systems, Inc - All Rights Reserved
+ * Unauthorized copying of this file, via any medium is strictly prohibited
+ * Proprietary and confidential
+ * Written by Paul Nowoczynski <00pauln00@gmail.com> 2020
+ */
+
+/* A fio-style comparison of the posix backend's write paths:  a blocking
+ * pwrite() per entry with an fsync() per sync batch, versus io_uring writes
+ * kept in flight up to the engine's queue depth with a drained fsync per
+ * sync batch.  Writes land on the backend's 64k entry stride.  The io_uring
+ * runs are only present when built with liburing.
+ */
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#if defined(HAVE_LIBURING)
+#include <liburing.h>
+#endif
+
+#include "niova/common.h"
+#include "niova/log.h"
+
+#include "raft.h"
+
+#define OPTS "b:dhi:p:"
+
+#define PIB_BLOCK_SIZE RAFT_BS_IO_SZ
+#define PIB_QUEUE_DEPTH RAFT_BS_IO_NBUF
+
+static size_t benchIterations = 10000;
+static size_t benchSyncBatch = 8;
+static bool benchODirect = false;
+static const char *benchPathRoot = "./posix-io-bench";
+static const size_t benchWriteSizes[] = {4096, 16384, 65536};
+
+static char *pibBufs;
+static char pibPath[PATH_MAX];
+
+static unsigned long long
+pib_elapsed_nsec(const struct timespec *start)
+{
+    struct timespec ts;
+    niova_unstable_clock(&ts);
+    timespecsub(&ts, start, &ts);
+
+    return timespec_2_nsec(&ts);
+}
+
+static void
+pib_report(const char *engine, const size_t write_sz,
+           const unsigned long long nsecs)
+{
+    fprintf(stdout, "%13.3f\t\t%s write=%zu sync-batch=%zu (MB/s=%.1f)\n",
+            (float)nsecs / (float)benchIterations, engine, write_sz,
+            benchSyncBatch,
+            (double)(write_sz * benchIterations) * 1000.0 / (double)nsecs);
+}
+
+static int
+pib_open(const bool o_direct)
+{
+    int fd = open(pibPath, O_CREAT | O_TRUNC | O_RDWR |
+                  (o_direct ? O_DIRECT : 0), 0600);
+
+    FATAL_IF((fd < 0), "open(`%s'): %s", pibPath, strerror(errno));
+
+    return fd;
+}
+
+static void
+pib_close(const int fd)
+{
+    close(fd);
+    unlink(pibPath);
+}
+
+static void
+pib_pwrite(const size_t write_sz)
+{
+    const int fd = pib_open(false);
+    struct timespec ts;
+
+    niova_unstable_clock(&ts);
+
+    for (size_t i = 0; i < benchIterations; i++)
+    {
+        const ssize_t rc =
+            pwrite(fd, pibBufs, write_sz, (off_t)(i * PIB_BLOCK_SIZE));
+        FATAL_IF((rc != (ssize_t)write_sz), "pwrite(): %s (rc=%zd)",
+                 strerror(errno), rc);
+
+        if (!((i + 1) % benchSyncBatch) || (i + 1) == benchIterations)
+            FATAL_IF((fsync(fd)), "fsync(): %s", strerror(errno));
+    }
+
+    pib_report("pwrite+fsync", write_sz, pib_elapsed_nsec(&ts));
+
+    pib_close(fd);
+}
+
+#if defined(HAVE_LIBURING)
+static size_t
+pib_uring_reap(struct io_uring *ring, const size_t min)
+{
+    size_t nreaped = 0;
+
+    while (nreaped < min)
+    {
+        struct io_uring_cqe *cqe;
+        unsigned int head;
+        unsigned int ncqes = 0;
+
+        int rc = io_uring_wait_cqe(ring, &cqe);
+        FATAL_IF((rc), "io_uring_wait_cqe(): %s", strerror(-rc));
+
+        io_uring_for_each_cqe(ring, head, cqe)
+        {
+            FATAL_IF((cqe->res < 0), "io_uring cqe: %s",
+                     strerror(-cqe->res));
+            ncqes++;
+        }
+
+        io_uring_cq_advance(ring, ncqes);
+        nreaped += ncqes;
+    }
+
+    return nreaped;
+}
+
+static void
+pib_uring(const size_t write_sz, const bool o_direct)
+{
+    struct io_uring ring;
+
+    int rc = io_uring_queue_init(PIB_QUEUE_DEPTH * 2, &ring, 0);
+    FATAL_IF((rc), "io_uring_queue_init(): %s", strerror(-rc));
+
+    const int fd = pib_open(o_direct);
+
+    struct iovec iovs[PIB_QUEUE_DEPTH];
+    for (size_t i = 0; i < PIB_QUEUE_DEPTH; i++)
+    {
+        iovs[i].iov_base = &pibBufs[i * PIB_BLOCK_SIZE];
+        iovs[i].iov_len = PIB_BLOCK_SIZE;
+    }
+
+    const bool fixed =
+        io_uring_register_buffers(&ring, iovs, PIB_QUEUE_DEPTH) ? false : true;
+
+    size_t ninflight = 0;
+    struct timespec ts;
+
+    niova_unstable_clock(&ts);
+
+    for (size_t i = 0; i < benchIterations; i++)
+    {
+        const size_t slot = i % PIB_QUEUE_DEPTH;
+        const bool sync =
+            (!((i + 1) % benchSyncBatch) || (i + 1) == benchIterations);
+
+        if (ninflight + (sync ? 2 : 1) > PIB_QUEUE_DEPTH)
+            ninflight -= pib_uring_reap(&ring, 1);
+
+        struct io_uring_sqe *sqe = io_uring_get_sqe(&ring);
+        NIOVA_ASSERT(sqe);
+
+        if (fixed)
+            io_uring_prep_write_fixed(sqe, fd, iovs[slot].iov_base, write_sz,
+                                      (off_t)(i * PIB_BLOCK_SIZE), slot);
+        else
+            io_uring_prep_write(sqe, fd, iovs[slot].iov_base, write_sz,
+                                (off_t)(i * PIB_BLOCK_SIZE));
+        ninflight++;
+
+        if (sync)
+        {
+            sqe = io_uring_get_sqe(&ring);
+            NIOVA_ASSERT(sqe);
+
+            io_uring_prep_fsync(sqe, fd, 0);
+            io_uring_sqe_set_flags(sqe, IOSQE_IO_DRAIN);
+            ninflight++;
+        }
+
+        rc = io_uring_submit(&ring);
+        FATAL_IF((rc < 0), "io_uring_submit(): %s", strerror(-rc));
+    }
+
+    if (ninflight)
+        pib_uring_reap(&ring, ninflight);
+
+    pib_report(o_direct ? "io_uring+o_direct" : "io_uring", write_sz,
+               pib_elapsed_nsec(&ts));
+
+    if (fixed)
+        io_uring_unregister_buffers(&ring);
+
+    io_uring_queue_exit(&ring);
+    pib_close(fd);
+}
+#endif
+
+static void
+pib_print_help(const int error, char **argv)
+{
+    fprintf(error ? stderr : stdout,
+            "Usage: %s [-i writes] [-b sync-batch] [-d (O_DIRECT)] [-p path] "
+            "[-h]\n", argv[0]);
+
+    exit(error);
+}
+
+static void
+pib_getopt(int argc, char **argv)
+{
+    int opt;
+
+    while ((opt = getopt(argc, argv, OPTS)) != -1)
+    {
+        switch (opt)
+        {
+        case 'b':
+            benchSyncBatch = atoll(optarg);
+            break;
+        case 'd':
+            benchODirect = true;
+            break;
+        case 'h':
+            pib_print_help(0, argv);
+            break;
+        case 'i':
+            benchIterations = atoll(optarg);
+            break;
+        case 'p':
+            benchPathRoot = optarg;
+            break;
+        default:
+            pib_print_help(EINVAL, argv);
+            break;
+        }
+    }
+
+    if (!benchIterations || !benchSyncBatch)
+        pib_print_help(EINVAL, argv);
+}
+
+int
+main(int argc, char **argv)
+{
+    pib_getopt(argc, argv);
+
+    snprintf(pibPath, PATH_MAX, "%s-%d", benchPathRoot, getpid());
+
+    // Aligned for O_DIRECT
+    FATAL_IF((posix_memalign((void **)&pibBufs, PIB_BLOCK_SIZE,
+                             PIB_QUEUE_DEPTH * PIB_BLOCK_SIZE)),
+             "posix_memalign(): %s", strerror(ENOMEM));
+
+    for (size_t i = 0; i < PIB_QUEUE_DEPTH * PIB_BLOCK_SIZE; i++)
+        pibBufs[i] = (char)i;
+
+    fprintf(stdout, "    NS/OP\t\tTest Name\n"
+                    "--------------------------------------------------\n");
+
+    for (size_t i = 0; i < ARRAY_SIZE(benchWriteSizes); i++)
+    {
+        pib_pwrite(benchWriteSizes[i]);
+#if defined(HAVE_LIBURING)
+        pib_uring(benchWriteSizes[i], false);
+
+        if (benchODirect)
+            pib_uring(benchWriteSizes[i], true);
+#endif
+    }
+
+    free(pibBufs);
+
+    return 0;
+}
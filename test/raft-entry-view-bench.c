@@ -0,0 +1,254 @@
+/* Copyright (C) NIOVA Systems, Inc - All Rights Reserved
+ * Unauthorized copying of this file, via any medium is strictly prohibited
+ * Proprietary and confidential
+ * Written by Paul Nowoczynski <00pauln00@gmail.com> 2020
+ */
+
+/* Measures the cost of reading a raft entry from rocksdb on an entry cache
+ * miss:  the staging raft_entry allocation with rocksdb_get() and its two
+ * copies versus a pinned view which is copied once into the AE request, or
+ * which is consumed in place by the follower's SM apply.
+ */
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <uuid/uuid.h>
+
+#include <rocksdb/c.h>
+
+#include "niova/common.h"
+#include "niova/crc32.h"
+#include "niova/log.h"
+
+#include "raft.h"
+
+#define OPTS "hi:p:"
+
+static size_t benchIterations = 10000;
+static const char *benchDbPathRoot = "./rocksdb__entry_view_bench";
+
+static const size_t benchEntryDataSizes[] = {
+    4096, 65536, 1024 * 1024,
+};
+
+static unsigned long long
+evb_elapsed_nsec(const struct timespec *start)
+{
+    struct timespec ts;
+    niova_unstable_clock(&ts);
+    timespecsub(&ts, start, &ts);
+
+    return timespec_2_nsec(&ts);
+}
+
+static void
+evb_report(const char *name, const size_t data_size, unsigned long long nsecs)
+{
+    fprintf(stdout, "%13.3f\t\t%s (%zu)\n",
+            (float)nsecs / (float)benchIterations, name, data_size);
+}
+
+// Same coverage as raft_server_entry_calc_crc()
+static crc32_t
+evb_entry_crc(const struct raft_entry_header *reh, const char *data)
+{
+    const size_t off = offsetof(struct raft_entry_header, reh_data_size);
+
+    crc32_t crc = niova_crc((const unsigned char *)reh + off,
+                            sizeof(struct raft_entry) - off, 0);
+
+    return niova_crc((const unsigned char *)data, reh->reh_data_size, crc);
+}
+
+static void
+evb_entry_store(rocksdb_t *db, rocksdb_writeoptions_t *wopts,
+                const size_t data_size)
+{
+    struct raft_entry *re = malloc(sizeof(struct raft_entry) + data_size);
+    NIOVA_ASSERT(re);
+
+    memset(re, 0, sizeof(struct raft_entry));
+    re->re_header.reh_magic = RAFT_ENTRY_MAGIC;
+    re->re_header.reh_data_size = data_size;
+    re->re_header.reh_num_entries = 1;
+    re->re_header.reh_entry_sz[0] = data_size;
+
+    for (size_t i = 0; i < data_size; i++)
+        re->re_data[i] = (char)i;
+
+    re->re_header.reh_crc = evb_entry_crc(&re->re_header, re->re_data);
+
+    char *err = NULL;
+    rocksdb_put(db, wopts, (const char *)&data_size, sizeof(data_size),
+                (const char *)re, sizeof(struct raft_entry) + data_size,
+                &err);
+
+    FATAL_IF((err), "rocksdb_put(): %s", err);
+
+    free(re);
+}
+
+static void
+evb_entry_read(rocksdb_t *db, rocksdb_readoptions_t *ropts,
+               const size_t data_size)
+{
+    char *sink = malloc(data_size);
+    NIOVA_ASSERT(sink);
+
+    const char *key = (const char *)&data_size;
+    struct timespec ts;
+    size_t nbad = 0;
+    char *err = NULL;
+
+    // Staging raft_entry, rocksdb_get() malloc and two copies of the data
+    niova_unstable_clock(&ts);
+
+    for (size_t i = 0; i < benchIterations; i++)
+    {
+        struct raft_entry *re =
+            malloc(sizeof(struct raft_entry) + data_size);
+        NIOVA_ASSERT(re);
+
+        size_t val_len = 0;
+        char *val = rocksdb_get(db, ropts, key, sizeof(data_size), &val_len,
+                                &err);
+        FATAL_IF((!val || err), "rocksdb_get(): %s", err ? err : "ENOENT");
+
+        memcpy(re, val, val_len);
+        rocksdb_free(val);
+
+        nbad += evb_entry_crc(&re->re_header, re->re_data) !=
+            re->re_header.reh_crc;
+
+        memcpy(sink, re->re_data, data_size);
+        free(re);
+    }
+
+    evb_report("staged entry read", data_size, evb_elapsed_nsec(&ts));
+
+    for (int copy = 1; copy >= 0; copy--)
+    {
+        niova_unstable_clock(&ts);
+
+        for (size_t i = 0; i < benchIterations; i++)
+        {
+            rocksdb_pinnableslice_t *pslice =
+                rocksdb_get_pinned(db, ropts, key, sizeof(data_size), &err);
+            FATAL_IF((!pslice || err), "rocksdb_get_pinned(): %s",
+                     err ? err : "ENOENT");
+
+            size_t val_len = 0;
+            const char *val = rocksdb_pinnableslice_value(pslice, &val_len);
+            const struct raft_entry *re = (const struct raft_entry *)val;
+
+            nbad += evb_entry_crc(&re->re_header, re->re_data) !=
+                re->re_header.reh_crc;
+
+            // The AE send copies the view into the request once
+            if (copy)
+                memcpy(sink, re->re_data, data_size);
+
+            rocksdb_pinnableslice_destroy(pslice);
+        }
+
+        evb_report(copy ? "view read, copied (AE send)" :
+                   "view read, in place (SM apply)", data_size,
+                   evb_elapsed_nsec(&ts));
+    }
+
+    FATAL_IF((nbad), "%zu entries failed their crc", nbad);
+
+    free(sink);
+}
+
+static void
+evb_print_help(const int error, char **argv)
+{
+    fprintf(error ? stderr : stdout,
+            "Usage: %s [-i iterations] [-p path] [-h]\n", argv[0]);
+
+    exit(error);
+}
+
+static void
+evb_getopt(int argc, char **argv)
+{
+    int opt;
+
+    while ((opt = getopt(argc, argv, OPTS)) != -1)
+    {
+        switch (opt)
+        {
+        case 'h':
+            evb_print_help(0, argv);
+            break;
+        case 'i':
+            benchIterations = atoll(optarg);
+            break;
+        case 'p':
+            benchDbPathRoot = optarg;
+            break;
+        default:
+            evb_print_help(EINVAL, argv);
+            break;
+        }
+    }
+
+    if (!benchIterations)
+        evb_print_help(EINVAL, argv);
+}
+
+int
+main(int argc, char **argv)
+{
+    evb_getopt(argc, argv);
+
+    char path[PATH_MAX];
+    char uuid_str[UUID_STR_LEN];
+    uuid_t uuid;
+
+    uuid_generate(uuid);
+    uuid_unparse(uuid, uuid_str);
+    snprintf(path, PATH_MAX, "%s-%s", benchDbPathRoot, uuid_str);
+
+    rocksdb_options_t *opts = rocksdb_options_create();
+    NIOVA_ASSERT(opts);
+    rocksdb_options_set_create_if_missing(opts, 1);
+
+    char *err = NULL;
+    rocksdb_t *db = rocksdb_open(opts, path, &err);
+    if (!db)
+    {
+        SIMPLE_LOG_MSG(LL_ERROR, "rocksdb_open(`%s'): %s", path, err);
+        exit(ENOTCONN);
+    }
+
+    rocksdb_writeoptions_t *wopts = rocksdb_writeoptions_create();
+    rocksdb_readoptions_t *ropts = rocksdb_readoptions_create();
+    NIOVA_ASSERT(wopts && ropts);
+
+    for (size_t i = 0; i < ARRAY_SIZE(benchEntryDataSizes); i++)
+        evb_entry_store(db, wopts, benchEntryDataSizes[i]);
+
+    // Read from the sst files as entry cache misses generally would
+    rocksdb_flushoptions_t *fopts = rocksdb_flushoptions_create();
+    rocksdb_flush(db, fopts, &err);
+    FATAL_IF((err), "rocksdb_flush(): %s", err);
+    rocksdb_flushoptions_destroy(fopts);
+
+    fprintf(stdout, "    NS/OP\t\tTest Name (entry data size)\n"
+                    "--------------------------------------------------\n");
+
+    for (size_t i = 0; i < ARRAY_SIZE(benchEntryDataSizes); i++)
+        evb_entry_read(db, ropts, benchEntryDataSizes[i]);
+
+    rocksdb_readoptions_destroy(ropts);
+    rocksdb_writeoptions_destroy(wopts);
+    rocksdb_close(db);
+    rocksdb_destroy_db(opts, path, &err);
+    rocksdb_options_destroy(opts);
+
+    return 0;
+}
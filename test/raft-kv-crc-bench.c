@@ -0,0 +1,238 @@
+/* Copyright (C) NIOVA Systems, Inc - All Rights Reserved
+ * Unauthorized copying of this file, via any medium is strictly prohibited
+ * Proprietary and confidential
+ * Written by Paul Nowoczynski <00pauln00@gmail.com> 2020
+ */
+
+/* Measures the per-KV cost of the write supplement KV CRC chain:  column
+ * family classification by name versus the cached handle lookup, and the
+ * CRC of a KV hashed as separate key and value buffers versus one pass over
+ * the contiguous arena copy.
+ */
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <uuid/uuid.h>
+
+#include <rocksdb/c.h>
+
+#include "niova/common.h"
+#include "niova/crc32.h"
+#include "niova/log.h"
+
+#include "raft_net.h"
+
+#define OPTS "hi:p:"
+
+static size_t benchIterations = 100000;
+static const char *benchDbPathRoot = "./rocksdb__kv_crc_bench";
+
+struct kv_size
+{
+    size_t ks_key;
+    size_t ks_value;
+};
+
+// Representative PumiceDB key / value sizes
+static const struct kv_size benchKvSizes[] = {
+    {16, 64}, {32, 256}, {48, 1024}, {64, 4096}, {64, 16384},
+};
+
+static unsigned long long
+kcb_elapsed_nsec(const struct timespec *start)
+{
+    struct timespec ts;
+    niova_unstable_clock(&ts);
+    timespecsub(&ts, start, &ts);
+
+    return timespec_2_nsec(&ts);
+}
+
+static void
+kcb_report(const char *name, unsigned long long nsecs)
+{
+    fprintf(stdout, "%13.3f\t\t%s\n",
+            (float)nsecs / (float)benchIterations, name);
+}
+
+static void
+kcb_cf_classify(rocksdb_column_family_handle_t *cfh)
+{
+    struct timespec ts;
+    size_t nmatch = 0;
+
+    niova_unstable_clock(&ts);
+
+    for (size_t i = 0; i < benchIterations; i++)
+    {
+        size_t cf_name_len = 0;
+        char *cf_name =
+            rocksdb_column_family_handle_get_name(cfh, &cf_name_len);
+
+        nmatch += raft_net_wr_supp_cf_name_is_kv_crc(cf_name, cf_name_len);
+
+        free(cf_name);
+    }
+
+    kcb_report("cf classify by name", kcb_elapsed_nsec(&ts));
+    NIOVA_ASSERT(nmatch == benchIterations);
+
+    /* The cached path is exercised through the supplement API with the
+     * write memory already warmed so that the classification dominates.
+     */
+    struct raft_net_sm_write_supplements ws = {0};
+
+    niova_unstable_clock(&ts);
+
+    for (size_t i = 0; i < benchIterations; i++)
+    {
+        if (!(i % RAFT_NET_WR_SUPP_SEG_MIN_ITEMS))
+        {
+            raft_net_sm_write_supplement_destroy(&ws);
+            raft_net_sm_write_supplement_enable_kv_crc(&ws, 0);
+        }
+
+        int rc = raft_net_sm_write_supplement_add(&ws,
+                                                  RAFT_NET_WR_SUPP_OP_WRITE,
+                                                  cfh, NULL, "k", 1, "v", 1);
+        NIOVA_ASSERT(!rc);
+    }
+
+    raft_net_sm_write_supplement_destroy(&ws);
+
+    kcb_report("supplement add, cached cf classify (1B KV)",
+               kcb_elapsed_nsec(&ts));
+}
+
+static void
+kcb_kv_crc(const struct kv_size *ks)
+{
+    const size_t kv_size = ks->ks_key + ks->ks_value;
+
+    // The arena stores the value directly behind the key
+    unsigned char *kv = malloc(kv_size);
+    NIOVA_ASSERT(kv);
+
+    for (size_t i = 0; i < kv_size; i++)
+        kv[i] = (unsigned char)i;
+
+    char name[128];
+    struct timespec ts;
+    crc32_t crc[2] = {0};
+
+    niova_unstable_clock(&ts);
+
+    for (size_t i = 0; i < benchIterations; i++)
+    {
+        crc[0] = niova_crc(kv, ks->ks_key, crc[0]);
+        crc[0] = niova_crc(kv + ks->ks_key, ks->ks_value, crc[0]);
+    }
+
+    snprintf(name, sizeof(name), "kv crc key+value (%zu/%zu)",
+             ks->ks_key, ks->ks_value);
+    kcb_report(name, kcb_elapsed_nsec(&ts));
+
+    niova_unstable_clock(&ts);
+
+    for (size_t i = 0; i < benchIterations; i++)
+        crc[1] = niova_crc(kv, kv_size, crc[1]);
+
+    snprintf(name, sizeof(name), "kv crc contiguous (%zu/%zu)",
+             ks->ks_key, ks->ks_value);
+    kcb_report(name, kcb_elapsed_nsec(&ts));
+
+    // Both forms of the chain must produce the same checksum
+    FATAL_IF((crc[0] != crc[1]), "crc mismatch %x != %x", crc[0], crc[1]);
+
+    free(kv);
+}
+
+static void
+kcb_print_help(const int error, char **argv)
+{
+    fprintf(error ? stderr : stdout,
+            "Usage: %s [-i iterations] [-p path] [-h]\n", argv[0]);
+
+    exit(error);
+}
+
+static void
+kcb_getopt(int argc, char **argv)
+{
+    int opt;
+
+    while ((opt = getopt(argc, argv, OPTS)) != -1)
+    {
+        switch (opt)
+        {
+        case 'h':
+            kcb_print_help(0, argv);
+            break;
+        case 'i':
+            benchIterations = atoll(optarg);
+            break;
+        case 'p':
+            benchDbPathRoot = optarg;
+            break;
+        default:
+            kcb_print_help(EINVAL, argv);
+            break;
+        }
+    }
+
+    if (!benchIterations)
+        kcb_print_help(EINVAL, argv);
+}
+
+int
+main(int argc, char **argv)
+{
+    kcb_getopt(argc, argv);
+
+    char path[PATH_MAX];
+    char uuid_str[UUID_STR_LEN];
+    uuid_t uuid;
+
+    uuid_generate(uuid);
+    uuid_unparse(uuid, uuid_str);
+    snprintf(path, PATH_MAX, "%s-%s", benchDbPathRoot, uuid_str);
+
+    rocksdb_options_t *opts = rocksdb_options_create();
+    NIOVA_ASSERT(opts);
+    rocksdb_options_set_create_if_missing(opts, 1);
+
+    char *err = NULL;
+    rocksdb_t *db = rocksdb_open(opts, path, &err);
+    if (!db)
+    {
+        SIMPLE_LOG_MSG(LL_ERROR, "rocksdb_open(`%s'): %s", path, err);
+        exit(ENOTCONN);
+    }
+
+    rocksdb_column_family_handle_t *cfh =
+        rocksdb_create_column_family(db, opts,
+                                     RAFT_NET_WR_SUPP_KV_CRC_CF_NAME, &err);
+    if (!cfh)
+    {
+        SIMPLE_LOG_MSG(LL_ERROR, "rocksdb_create_column_family(): %s", err);
+        exit(EIO);
+    }
+
+    fprintf(stdout, "    NS/OP\t\tTest Name\n"
+                    "--------------------------------------------------\n");
+
+    kcb_cf_classify(cfh);
+
+    for (size_t i = 0; i < ARRAY_SIZE(benchKvSizes); i++)
+        kcb_kv_crc(&benchKvSizes[i]);
+
+    raft_net_wr_supp_cf_unregister(cfh);
+    rocksdb_column_family_handle_destroy(cfh);
+    rocksdb_close(db);
+    rocksdb_destroy_db(opts, path, &err);
+    rocksdb_options_destroy(opts);
+
+    return 0;
+}
@@ -154,13 +154,502 @@ ws_test(void)
     rc = raft_net_sm_write_supplements_merge(&ws, &wsMerge);
     NIOVA_ASSERT(!rc);
     NIOVA_ASSERT(ws.rnsws_nitems == 2);
-    NIOVA_ASSERT(wsMerge.rnsws_nitems == 0 && wsMerge.rnsws_ws == NULL);
+    NIOVA_ASSERT(wsMerge.rnsws_nitems == 0 &&
+                 wsMerge.rnsws_seg_head == NULL &&
+                 wsMerge.rnsws_arena == NULL);
+
+    // Merged items keep their original key and value memory
+    const struct raft_net_wr_supp_seg *seg;
+    size_t nitems = 0;
+    RAFT_NET_SM_WRITE_SUPP_SEG_FOREACH(&ws, seg)
+    {
+        for (size_t i = 0; i < seg->rnwss_nitems; i++, nitems++)
+            NIOVA_ASSERT(!memcmp(seg->rnwss_items[i].rnws_key, "foo", 3) &&
+                         !memcmp(seg->rnwss_items[i].rnws_value, "bar", 3));
+    }
+    NIOVA_ASSERT(nitems == 2);
+
+    // Items are found by index across the merged segments
+    for (size_t i = 0; i < nitems; i++)
+    {
+        const struct raft_net_wr_supp *item =
+            raft_net_sm_write_supplement_get(&ws, i);
+
+        NIOVA_ASSERT(item && !memcmp(item->rnws_key, "foo", 3));
+        NIOVA_ASSERT(!((uintptr_t)item->rnws_key %
+                       RAFT_NET_WR_SUPP_ARENA_ALIGN));
+    }
+    NIOVA_ASSERT(!raft_net_sm_write_supplement_get(&ws, nitems));
 
     // Ensure that both destroy cb's are run
     raft_net_sm_write_supplement_destroy(&ws);
     NIOVA_ASSERT(handle == 2);
 }
 
+static void
+compact_msg_test_roundtrip(const struct raft_rpc_msg *rrm,
+                           const size_t expected_hdr_max)
+{
+    char wire[RAFT_RPC_MSG_COMPACT_HDR_MAX + 64];
+    static union
+    {
+        struct raft_rpc_msg rrm;
+        char buf[sizeof(struct raft_rpc_msg) + 64];
+    } decoded;
+
+    ssize_t hdr_size = raft_net_rpc_msg_compact_encode(rrm, wire,
+                                                       sizeof(wire));
+    FATAL_IF((hdr_size <= 0 || (size_t)hdr_size > expected_hdr_max),
+             "hdr_size=%zd", hdr_size);
+
+    size_t payload_sz = 0;
+    if (rrm->rrm_type == RAFT_RPC_MSG_TYPE_APPEND_ENTRIES_REQUEST)
+    {
+        payload_sz = rrm->rrm_append_entries_request.raerqm_entries_sz;
+        memcpy(&wire[hdr_size], rrm->rrm_append_entries_request.raerqm_entries,
+               payload_sz);
+    }
+
+    ssize_t rc = raft_net_rpc_msg_compact_decode(wire, hdr_size + payload_sz,
+                                                 &decoded.rrm,
+                                                 sizeof(decoded));
+    NIOVA_ASSERT(rc == (ssize_t)(sizeof(struct raft_rpc_msg) + payload_sz));
+    NIOVA_ASSERT(decoded.rrm.rrm_version == RAFT_RPC_MSG_VERSION_COMPACT);
+
+    // Other than the version, the decoded msg must be identical
+    decoded.rrm.rrm_version = rrm->rrm_version;
+    NIOVA_ASSERT(!memcmp(rrm, &decoded, rc));
+
+    // Truncated and oversized inputs are rejected
+    rc = raft_net_rpc_msg_compact_decode(wire, hdr_size + payload_sz - 1,
+                                         &decoded.rrm, sizeof(decoded));
+    NIOVA_ASSERT(rc == -EBADMSG);
+
+    rc = raft_net_rpc_msg_compact_decode(wire, hdr_size + payload_sz + 1,
+                                         &decoded.rrm, sizeof(decoded));
+    NIOVA_ASSERT(rc == -EBADMSG);
+}
+
+static void
+compact_msg_test(void)
+{
+    static union
+    {
+        struct raft_rpc_msg rrm;
+        char buf[sizeof(struct raft_rpc_msg) + 64];
+    } msg;
+
+    struct raft_rpc_msg *rrm = &msg.rrm;
+    struct raft_append_entries_request_msg *raerq =
+        &rrm->rrm_append_entries_request;
+
+    // Heartbeat from a new leader, most indexes are still -1
+    memset(&msg, 0, sizeof(msg));
+    rrm->rrm_type = RAFT_RPC_MSG_TYPE_APPEND_ENTRIES_REQUEST;
+    rrm->rrm_version_max = RAFT_RPC_MSG_VERSION_MAX;
+    uuid_generate(rrm->rrm_sender_id);
+    uuid_generate(rrm->rrm_raft_id);
+    uuid_generate(rrm->rrm_db_id);
+    raerq->raerqm_leader_term = 7;
+    raerq->raerqm_log_term = 7;
+    raerq->raerqm_commit_index = -1;
+    raerq->raerqm_lowest_index = -1;
+    raerq->raerqm_chkpt_index = -1;
+    raerq->raerqm_prev_log_term = 6;
+    raerq->raerqm_prev_log_index = 123456789;
+    raerq->raerqm_prev_idx_crc = 0xdeadbeef;
+    raerq->raerqm_heartbeat_msg = 1;
+
+    compact_msg_test_roundtrip(rrm, 128);
+
+    // AE with a payload and a partially filled size array
+    raerq->raerqm_heartbeat_msg = 0;
+    raerq->raerqm_this_idx_crc = 0xfeedface;
+    raerq->raerqm_num_idx = 0;
+    raerq->raerqm_num_entries = 3;
+    raerq->raerqm_size_arr[0] = 10;
+    raerq->raerqm_size_arr[1] = 20;
+    raerq->raerqm_size_arr[2] = 34;
+    raerq->raerqm_entries_sz = 64;
+    raerq->raerqm_first_idx_sz = 64;
+    for (int i = 0; i < 64; i++)
+        raerq->raerqm_entries[i] = (char)i;
+
+    compact_msg_test_roundtrip(rrm, 128);
+
+    // AE reply
+    memset(&msg, 0, sizeof(msg));
+    rrm->rrm_type = RAFT_RPC_MSG_TYPE_APPEND_ENTRIES_REPLY;
+    rrm->rrm_append_entries_reply.raerpm_leader_term = 7;
+    rrm->rrm_append_entries_reply.raerpm_prev_log_index = 5000000000;
+    rrm->rrm_append_entries_reply.raerpm_synced_log_index = -1;
+    rrm->rrm_append_entries_reply.raerpm_err_non_matching_prev_term = 1;
+    rrm->rrm_append_entries_reply.raerpm_num_idx = 4;
+
+    compact_msg_test_roundtrip(rrm, 64);
+
+    // Vote reply
+    memset(&msg, 0, sizeof(msg));
+    rrm->rrm_type = RAFT_RPC_MSG_TYPE_PRE_VOTE_REPLY;
+    rrm->rrm_vote_reply.rvrpm_voted_granted = 1;
+    rrm->rrm_vote_reply.rvrpm_term = 12;
+    uuid_generate(rrm->rrm_vote_reply.rvrpm_current_leader);
+
+    compact_msg_test_roundtrip(rrm, 64);
+
+    // A size array larger than the maximum is refused by the encoder
+    memset(&msg, 0, sizeof(msg));
+    rrm->rrm_type = RAFT_RPC_MSG_TYPE_APPEND_ENTRIES_REQUEST;
+    raerq->raerqm_num_entries = RAFT_ENTRY_NUM_ENTRIES + 1;
+
+    char wire[RAFT_RPC_MSG_COMPACT_HDR_MAX];
+    NIOVA_ASSERT(raft_net_rpc_msg_compact_encode(rrm, wire, sizeof(wire)) ==
+                 -EINVAL);
+}
+
+static void
+ae_compress_test(void)
+{
+    enum { PAYLOAD_SZ = 16384 };
+
+    static union
+    {
+        struct raft_rpc_msg rrm;
+        char buf[sizeof(struct raft_rpc_msg) + PAYLOAD_SZ];
+    } msg, wire, decompressed;
+
+    struct raft_rpc_msg *rrm = &msg.rrm;
+    struct raft_append_entries_request_msg *raerq =
+        &rrm->rrm_append_entries_request;
+
+    memset(&msg, 0, sizeof(msg));
+    rrm->rrm_type = RAFT_RPC_MSG_TYPE_APPEND_ENTRIES_REQUEST;
+    uuid_generate(rrm->rrm_sender_id);
+    raerq->raerqm_prev_log_index = 99;
+    raerq->raerqm_this_idx_crc = 0xfeedface;
+    raerq->raerqm_num_entries = 1;
+    raerq->raerqm_size_arr[0] = PAYLOAD_SZ;
+    raerq->raerqm_entries_sz = PAYLOAD_SZ;
+
+    // Repetitive, JSON-like payload
+    for (int i = 0; i < PAYLOAD_SZ; i++)
+        raerq->raerqm_entries[i] = "{\"key\": \"value\"}, "[i % 18];
+
+    ssize_t wire_sz = raft_net_ae_entries_compress(rrm, RAFT_AE_COMPRESS_LZ4,
+                                                   wire.buf,
+                                                   sizeof(wire));
+    NIOVA_ASSERT(wire_sz > (ssize_t)sizeof(struct raft_rpc_msg) &&
+                 wire_sz < (ssize_t)(sizeof(struct raft_rpc_msg) +
+                                     PAYLOAD_SZ));
+    NIOVA_ASSERT(wire.rrm.rrm_version == RAFT_RPC_MSG_VERSION_COMPRESS);
+
+    // The version 0 layout is kept, the entries size is the size as sent
+    NIOVA_ASSERT(wire_sz == (ssize_t)(sizeof(struct raft_rpc_msg) +
+                                      wire.rrm.rrm_append_entries_request.
+                                      raerqm_entries_sz));
+
+    struct raft_ae_compress_hdr *rach = (struct raft_ae_compress_hdr *)
+        wire.rrm.rrm_append_entries_request.raerqm_entries;
+    NIOVA_ASSERT(rach->rach_type == RAFT_AE_COMPRESS_LZ4 &&
+                 rach->rach_entries_sz == PAYLOAD_SZ);
+
+    ssize_t rc = raft_net_ae_entries_decompress(wire.buf, wire_sz,
+                                                &decompressed.rrm,
+                                                sizeof(decompressed));
+    NIOVA_ASSERT(rc == (ssize_t)(sizeof(struct raft_rpc_msg) + PAYLOAD_SZ));
+    NIOVA_ASSERT(!memcmp(&msg, &decompressed, rc));
+
+    // Truncated input is rejected
+    rc = raft_net_ae_entries_decompress(wire.buf, wire_sz - 1,
+                                        &decompressed.rrm,
+                                        sizeof(decompressed));
+    NIOVA_ASSERT(rc == -EBADMSG);
+
+    // As is a corrupt uncompressed size
+    rach->rach_entries_sz--;
+    rc = raft_net_ae_entries_decompress(wire.buf, wire_sz, &decompressed.rrm,
+                                        sizeof(decompressed));
+    NIOVA_ASSERT(rc == -EBADMSG);
+    rach->rach_entries_sz++;
+
+    // Uncompressed requests are not decompressed
+    rc = raft_net_ae_entries_decompress(msg.buf, sizeof(msg),
+                                        &decompressed.rrm,
+                                        sizeof(decompressed));
+    NIOVA_ASSERT(rc == -EINVAL);
+
+    // Compressed AE requests never use the compact format
+    char compact[RAFT_RPC_MSG_COMPACT_HDR_MAX];
+    NIOVA_ASSERT(raft_net_rpc_msg_compact_encode(&wire.rrm, compact,
+                                                 sizeof(compact)) == -EINVAL);
+
+    // Random data does not shrink and is left for an uncompressed send
+    for (int i = 0; i < PAYLOAD_SZ; i++)
+        raerq->raerqm_entries[i] = (char)random();
+
+    rc = raft_net_ae_entries_compress(rrm, RAFT_AE_COMPRESS_LZ4, wire.buf,
+                                      sizeof(wire));
+    NIOVA_ASSERT(rc == -E2BIG);
+
+    rc = raft_net_ae_entries_compress(rrm, RAFT_AE_COMPRESS_MAX, wire.buf,
+                                      sizeof(wire));
+    NIOVA_ASSERT(rc == -EOPNOTSUPP);
+}
+
+static void
+multi_instance_test(void)
+{
+    struct raft_instance *ri[2] = {raft_net_get_instance(),
+                                   raft_net_instance_alloc()};
+    NIOVA_ASSERT(ri[1] && ri[1] != ri[0]);
+
+    struct ctl_svc_node csn_raft[2] = {0};
+    struct raft_rpc_msg hb[2] = {0};
+
+    for (int i = 0; i < 2; i++)
+    {
+        uuid_generate(csn_raft[i].csn_uuid);
+        ri[i]->ri_csn_raft = &csn_raft[i];
+
+        // Each group's heartbeat carries its own raft id
+        hb[i].rrm_type = RAFT_RPC_MSG_TYPE_APPEND_ENTRIES_REQUEST;
+        hb[i].rrm_append_entries_request.raerqm_heartbeat_msg = 1;
+        hb[i].rrm_append_entries_request.raerqm_leader_term = i + 1;
+        uuid_copy(hb[i].rrm_raft_id, csn_raft[i].csn_uuid);
+
+        NIOVA_ASSERT(raft_net_instance_lookup(csn_raft[i].csn_uuid) == ri[i]);
+    }
+
+    uuid_t unknown;
+    uuid_generate(unknown);
+    NIOVA_ASSERT(!raft_net_instance_lookup(unknown));
+
+    // Both heartbeats share a datagram
+    static union
+    {
+        struct raft_rpc_msg_batch_hdr hdr;
+        char buf[1024];
+    } batch;
+
+    size_t len = 0;
+
+    for (int i = 0; i < 2; i++)
+        NIOVA_ASSERT(!raft_net_rpc_msg_batch_add(batch.buf, sizeof(batch),
+                                                 &len, &hb[i],
+                                                 sizeof(hb[i])));
+
+    NIOVA_ASSERT(batch.hdr.rrmbh_type == RAFT_RPC_MSG_TYPE_BATCH &&
+                 batch.hdr.rrmbh_nmsgs == 2);
+
+    // Each msg is routed to its group by the raft id it carries
+    size_t off = 0;
+    size_t msg_off = 0;
+
+    for (int i = 0; i < 2; i++)
+    {
+        ssize_t rc = raft_net_rpc_msg_batch_next(batch.buf, len, &off,
+                                                 &msg_off);
+        NIOVA_ASSERT(rc == (ssize_t)sizeof(struct raft_rpc_msg));
+        NIOVA_ASSERT(!(msg_off % 8));
+
+        const struct raft_rpc_msg *rrm =
+            (const struct raft_rpc_msg *)&batch.buf[msg_off];
+
+        NIOVA_ASSERT(!memcmp(rrm, &hb[i], sizeof(hb[i])));
+        NIOVA_ASSERT(raft_net_instance_lookup(rrm->rrm_raft_id) == ri[i]);
+    }
+
+    NIOVA_ASSERT(!raft_net_rpc_msg_batch_next(batch.buf, len, &off,
+                                              &msg_off));
+
+    // The second msg of a truncated batch is rejected
+    off = 0;
+    NIOVA_ASSERT(raft_net_rpc_msg_batch_next(batch.buf, len - 8, &off,
+                                             &msg_off) ==
+                 (ssize_t)sizeof(struct raft_rpc_msg));
+    NIOVA_ASSERT(raft_net_rpc_msg_batch_next(batch.buf, len - 8, &off,
+                                             &msg_off) == -EBADMSG);
+
+    // A full batch refuses further msgs
+    NIOVA_ASSERT(raft_net_rpc_msg_batch_add(batch.buf, len, &len, &hb[0],
+                                            sizeof(hb[0])) == -ENOSPC);
+
+    for (int i = 0; i < 2; i++)
+        ri[i]->ri_csn_raft = NULL;
+
+    raft_net_instance_free(ri[1]);
+
+    NIOVA_ASSERT(!raft_net_instance_lookup(csn_raft[1].csn_uuid));
+}
+
+static void
+wr_supp_cf_cache_test(void)
+{
+    // The name test is bounded by the CF name's length
+    NIOVA_ASSERT(raft_net_wr_supp_cf_name_is_kv_crc("PMDBTS_CF", 9));
+    NIOVA_ASSERT(raft_net_wr_supp_cf_name_is_kv_crc("PMDB", 4));
+    NIOVA_ASSERT(!raft_net_wr_supp_cf_name_is_kv_crc("PMDBTS_CF_X", 11));
+    NIOVA_ASSERT(!raft_net_wr_supp_cf_name_is_kv_crc("default", 7));
+    NIOVA_ASSERT(!raft_net_wr_supp_cf_name_is_kv_crc("PMDBTS_CF", 0));
+
+    // Stand-ins for CF handles, only their addresses are used
+    static uint64_t handles[RAFT_NET_WR_SUPP_CF_CACHE_SIZE + 1];
+
+    NIOVA_ASSERT(raft_net_wr_supp_cf_register((char *)&handles[0] + 1,
+                                              true) == -EINVAL);
+
+    // A full cache evicts rather than refusing new handles
+    for (size_t i = 0; i < ARRAY_SIZE(handles); i++)
+        NIOVA_ASSERT(!raft_net_wr_supp_cf_register(&handles[i], i & 1));
+
+    const size_t last = ARRAY_SIZE(handles) - 1;
+
+    NIOVA_ASSERT(raft_net_wr_supp_cf_register(&handles[last], last & 1) ==
+                 -EALREADY);
+    NIOVA_ASSERT(raft_net_wr_supp_cf_register(&handles[last],
+                                              !(last & 1)) == -EEXIST);
+
+    // The first handle was evicted and may be registered again
+    NIOVA_ASSERT(!raft_net_wr_supp_cf_register(&handles[0], true));
+
+    // An unregistered (dropped) handle may be registered as a different CF
+    raft_net_wr_supp_cf_unregister(&handles[last]);
+    NIOVA_ASSERT(!raft_net_wr_supp_cf_register(&handles[last],
+                                               !(last & 1)));
+
+    for (size_t i = 0; i < ARRAY_SIZE(handles); i++)
+        raft_net_wr_supp_cf_unregister(&handles[i]);
+}
+
+#define SUB_TABLE_TEST_NENTRIES (RAFT_ENTRY_NUM_ENTRIES + 1)
+#define SUB_TABLE_TEST_ENTRY_SZ 3
+#define SUB_TABLE_TEST_DATA_SZ                                  \
+    (raft_entry_sub_table_size(SUB_TABLE_TEST_NENTRIES) +       \
+     (SUB_TABLE_TEST_NENTRIES * SUB_TABLE_TEST_ENTRY_SZ))
+
+static void
+sub_table_test(void)
+{
+    static union
+    {
+        struct raft_entry re;
+        char buf[sizeof(struct raft_entry) + 1024];
+    } entry;
+
+    uint32_t sizes[SUB_TABLE_TEST_NENTRIES];
+    char payload[SUB_TABLE_TEST_NENTRIES * SUB_TABLE_TEST_ENTRY_SZ];
+
+    for (uint32_t i = 0; i < SUB_TABLE_TEST_NENTRIES; i++)
+        sizes[i] = SUB_TABLE_TEST_ENTRY_SZ;
+
+    for (size_t i = 0; i < sizeof(payload); i++)
+        payload[i] = (char)i;
+
+    const struct raft_entry_sub_table rest = {
+        .rest_num_entries = SUB_TABLE_TEST_NENTRIES,
+    };
+
+    // Lay out the table at an odd offset to cover unaligned reads
+    static char table_buf[SUB_TABLE_TEST_DATA_SZ + 1];
+    char *table = &table_buf[1];
+
+    memcpy(table, &rest, sizeof(rest));
+    memcpy(table + sizeof(rest), sizes,
+           sizeof(uint32_t) * SUB_TABLE_TEST_NENTRIES);
+    memcpy(table + raft_entry_sub_table_size(SUB_TABLE_TEST_NENTRIES),
+           payload, sizeof(payload));
+
+    uint32_t nentries = 0;
+    int rc = raft_server_entry_sub_table_check(table, SUB_TABLE_TEST_DATA_SZ,
+                                               &nentries);
+    NIOVA_ASSERT(!rc && nentries == SUB_TABLE_TEST_NENTRIES);
+
+    // Sub-entries which don't exactly fill the data
+    NIOVA_ASSERT(raft_server_entry_sub_table_check(
+                     table, SUB_TABLE_TEST_DATA_SZ - 1, NULL) == -EBADMSG);
+    NIOVA_ASSERT(raft_server_entry_sub_table_check(
+                     table, SUB_TABLE_TEST_DATA_SZ + 1, NULL) == -EBADMSG);
+
+    // Truncated tables
+    NIOVA_ASSERT(raft_server_entry_sub_table_check(
+                     table, raft_entry_sub_table_size(
+                         SUB_TABLE_TEST_NENTRIES) - 1, NULL) == -EBADMSG);
+    NIOVA_ASSERT(raft_server_entry_sub_table_check(
+                     table, sizeof(struct raft_entry_sub_table) - 1, NULL) ==
+                 -EBADMSG);
+    NIOVA_ASSERT(raft_server_entry_sub_table_check(NULL, 0, NULL) ==
+                 -EBADMSG);
+
+    // A table holding no more than a v1 header is not a valid v2 table
+    uint32_t word = RAFT_ENTRY_NUM_ENTRIES;
+    memcpy(table, &word, sizeof(word));
+    NIOVA_ASSERT(raft_server_entry_sub_table_check(
+                     table, raft_entry_sub_table_size(word) +
+                     (word * SUB_TABLE_TEST_ENTRY_SZ), NULL) == -EBADMSG);
+
+    word = RAFT_ENTRY_V2_NUM_ENTRIES_MAX + 1;
+    memcpy(table, &word, sizeof(word));
+    NIOVA_ASSERT(raft_server_entry_sub_table_check(
+                     table, SUB_TABLE_TEST_DATA_SZ, NULL) == -EBADMSG);
+
+    memcpy(table, &rest, sizeof(rest));
+
+    /* The leader checksums a v2 entry from the gathered table, size array
+     * and data while readers checksum the entry as stored.
+     */
+    struct raft_entry_header *reh = &entry.re.re_header;
+    const size_t crc_off = offsetof(struct raft_entry_header, reh_data_size);
+
+    memset(&entry, 0, sizeof(entry));
+    reh->reh_magic = RAFT_ENTRY_MAGIC;
+    reh->reh_version = RAFT_ENTRY_HEADER_V2;
+    reh->reh_data_size = SUB_TABLE_TEST_DATA_SZ;
+    reh->reh_index = 12;
+    reh->reh_term = 3;
+    memcpy(entry.re.re_data, table, SUB_TABLE_TEST_DATA_SZ);
+
+    const struct iovec v2_iov[3] = {
+        {.iov_base = (void *)&rest, .iov_len = sizeof(rest)},
+        {.iov_base = sizes,
+         .iov_len = sizeof(uint32_t) * SUB_TABLE_TEST_NENTRIES},
+        {.iov_base = payload, .iov_len = sizeof(payload)},
+    };
+
+    const crc32_t v2_crc = raft_server_entry_iov_calc_crc(reh, v2_iov, 3);
+
+    NIOVA_ASSERT(v2_crc ==
+                 niova_crc((const unsigned char *)&entry.re + crc_off,
+                           sizeof(struct raft_entry) +
+                           SUB_TABLE_TEST_DATA_SZ - crc_off, 0));
+
+    // The header version is covered by the crc
+    reh->reh_version = RAFT_ENTRY_HEADER_V1;
+    NIOVA_ASSERT(raft_server_entry_iov_calc_crc(reh, v2_iov, 3) != v2_crc);
+
+    // v1 entries hold their sizes in the header and the data is unchanged
+    memset(&entry, 0, sizeof(entry));
+    reh->reh_magic = RAFT_ENTRY_MAGIC;
+    reh->reh_version = RAFT_ENTRY_HEADER_V1;
+    reh->reh_num_entries = RAFT_ENTRY_NUM_ENTRIES;
+    reh->reh_data_size = RAFT_ENTRY_NUM_ENTRIES * SUB_TABLE_TEST_ENTRY_SZ;
+    reh->reh_index = 12;
+    reh->reh_term = 3;
+
+    for (uint32_t i = 0; i < RAFT_ENTRY_NUM_ENTRIES; i++)
+        reh->reh_entry_sz[i] = SUB_TABLE_TEST_ENTRY_SZ;
+
+    memcpy(entry.re.re_data, payload, reh->reh_data_size);
+
+    const struct iovec v1_iov = {
+        .iov_base = payload, .iov_len = reh->reh_data_size,
+    };
+
+    NIOVA_ASSERT(raft_server_entry_iov_calc_crc(reh, &v1_iov, 1) ==
+                 niova_crc((const unsigned char *)&entry.re + crc_off,
+                           sizeof(struct raft_entry) + reh->reh_data_size -
+                           crc_off, 0));
+}
+
 int
 main(void)
 {
@@ -168,6 +657,11 @@ main(void)
 
     vote_sort();
     ws_test();
+    compact_msg_test();
+    ae_compress_test();
+    multi_instance_test();
+    sub_table_test();
+    wr_supp_cf_cache_test();
 
     int rc = raft_net_client_user_id_parse(
         "1a636bd0-d27d-11ea-8cad-90324b2d1e89:2341523123:32452300123:1:0",
@@ -20,13 +20,17 @@
 #include "ref_tree_proto.h"
 #include "alloc.h"
 
-#define OPTS "u:r:hRa"
+#define OPTS "u:r:hRaDKSU"
 
 const char *raft_uuid_str;
 const char *my_uuid_str;
 
 bool use_rocksdb_backend = false;
+bool use_segment_backend = false;
 bool use_synchronous_writes = true;
+bool use_posix_io_uring = false;
+bool use_posix_o_direct = false;
+bool use_rocksdb_single_kv = false;
 
 REGISTRY_ENTRY_FILE_GENERATE;
 
@@ -542,7 +546,9 @@ static void
 rst_print_help(const int error, char **argv)
 {
     fprintf(error ? stderr : stdout,
-            "Usage: %s [-a (async writes)] [-R (use-rocksDB-backend)] -r <UUID> -u <UUID>\n",
+            "Usage: %s [-a (async writes)] [-R (use-rocksDB-backend)] -r <UUID> -u <UUID>\n"
+            "       [-U (posix io_uring writes, requires -a)] [-D (O_DIRECT, requires -U)]\n"
+            "       [-S (use-segmented-log-backend)] [-K (single KV entries, requires -R)]\n",
             argv[0]);
 
     exit(error);
@@ -575,6 +581,18 @@ rst_getopt(int argc, char **argv)
         case 'a':
             use_synchronous_writes = false;
             break;
+        case 'D':
+            use_posix_o_direct = true;
+            break;
+        case 'K':
+            use_rocksdb_single_kv = true;
+            break;
+        case 'S':
+            use_segment_backend = true;
+            break;
+        case 'U':
+            use_posix_io_uring = true;
+            break;
         default:
             rst_print_help(EINVAL, argv);
             break;
@@ -629,10 +647,20 @@ main(int argc, char **argv)
         ? RAFT_INSTANCE_OPTIONS_SYNC_WRITES
         : RAFT_INSTANCE_OPTIONS_NONE;
 
+    if (use_posix_io_uring)
+        opts |= RAFT_INSTANCE_OPTIONS_POSIX_IO_URING;
+
+    if (use_posix_o_direct)
+        opts |= RAFT_INSTANCE_OPTIONS_POSIX_O_DIRECT;
+
+    if (use_rocksdb_single_kv)
+        opts |= RAFT_INSTANCE_OPTIONS_ROCKSDB_SINGLE_KV;
+
     return raft_server_instance_run(
         raft_uuid_str, my_uuid_str,
         raft_server_test_rst_sm_handler,
         NULL,
         use_rocksdb_backend ? RAFT_INSTANCE_STORE_ROCKSDB :
+        use_segment_backend ? RAFT_INSTANCE_STORE_POSIX_SEGMENTED :
         RAFT_INSTANCE_STORE_POSIX_FLAT_FILE, opts, NULL);
 }
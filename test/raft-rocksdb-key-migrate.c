@@ -0,0 +1,510 @@
+/* Copyright (C) NIOVA Systems, Inc - All Rights Reserved
+ * Unauthorized copying of this file, via any medium is strictly prohibited
+ * Proprietary and confidential
+ * Written by Paul Nowoczynski <00pauln00@gmail.com> 2020
+ */
+
+/* Offline conversion of a raft rocksdb log from the legacy ASCII entry key
+ * format ("e0.<idx><e|h>") to the binary format ("e1<be64 idx><e|h>").  The
+ * raft server must not be running on the db.  Entry keys are converted first
+ * and the log header version is updated last, so an interrupted run may
+ * simply be restarted.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <rocksdb/c.h>
+
+#include "common.h"
+#include "log.h"
+#include "raft.h"
+#include "raft_server_backend_rocksdb.h"
+
+#define OPTS "b:hnp:"
+
+#define RRKM_DEFAULT_BATCH 1024
+
+static const char *rrkmDbPath;
+static size_t rrkmBatchSize = RRKM_DEFAULT_BATCH;
+static bool rrkmDryRun = false;
+
+struct rrkm_db
+{
+    rocksdb_t                       *rd_db;
+    rocksdb_options_t               *rd_options;
+    rocksdb_writeoptions_t          *rd_writeoptions;
+    rocksdb_readoptions_t           *rd_readoptions;
+    char                           **rd_cf_names;
+    size_t                           rd_num_cf;
+    rocksdb_column_family_handle_t **rd_cf_handles;
+};
+
+static void
+rrkm_db_close(struct rrkm_db *rd)
+{
+    if (!rd)
+        return;
+
+    if (rd->rd_cf_handles)
+    {
+        for (size_t i = 0; i < rd->rd_num_cf; i++)
+            if (rd->rd_cf_handles[i])
+                rocksdb_column_family_handle_destroy(rd->rd_cf_handles[i]);
+
+        free(rd->rd_cf_handles);
+        rd->rd_cf_handles = NULL;
+    }
+
+    if (rd->rd_db)
+    {
+        rocksdb_close(rd->rd_db);
+        rd->rd_db = NULL;
+    }
+
+    if (rd->rd_cf_names)
+    {
+        rocksdb_list_column_families_destroy(rd->rd_cf_names, rd->rd_num_cf);
+        rd->rd_cf_names = NULL;
+    }
+
+    if (rd->rd_writeoptions)
+        rocksdb_writeoptions_destroy(rd->rd_writeoptions);
+
+    if (rd->rd_readoptions)
+        rocksdb_readoptions_destroy(rd->rd_readoptions);
+
+    if (rd->rd_options)
+        rocksdb_options_destroy(rd->rd_options);
+
+    rd->rd_writeoptions = NULL;
+    rd->rd_readoptions = NULL;
+    rd->rd_options = NULL;
+}
+
+/**
+ * rrkm_db_open - opens the db with all of its column families since rocksdb
+ *    refuses to open a db when any existing column family is left out.
+ */
+static int
+rrkm_db_open(struct rrkm_db *rd, const char *path)
+{
+    if (!rd || !path)
+        return -EINVAL;
+
+    char *err = NULL;
+
+    rd->rd_options = rocksdb_options_create();
+    rd->rd_writeoptions = rocksdb_writeoptions_create();
+    rd->rd_readoptions = rocksdb_readoptions_create();
+    if (!rd->rd_options || !rd->rd_writeoptions || !rd->rd_readoptions)
+        return -ENOMEM;
+
+    rocksdb_writeoptions_set_sync(rd->rd_writeoptions, 1);
+
+    rd->rd_cf_names = rocksdb_list_column_families(rd->rd_options, path,
+                                                   &rd->rd_num_cf, &err);
+    if (err || !rd->rd_cf_names || !rd->rd_num_cf)
+    {
+        SIMPLE_LOG_MSG(LL_ERROR, "rocksdb_list_column_families(`%s'): %s",
+                       path, err ? err : "no column families");
+        return -ENOENT;
+    }
+
+    rd->rd_cf_handles =
+        calloc(rd->rd_num_cf, sizeof(rocksdb_column_family_handle_t *));
+    const rocksdb_options_t **cf_opts =
+        calloc(rd->rd_num_cf, sizeof(rocksdb_options_t *));
+
+    if (!rd->rd_cf_handles || !cf_opts)
+    {
+        free(cf_opts);
+        return -ENOMEM;
+    }
+
+    for (size_t i = 0; i < rd->rd_num_cf; i++)
+        cf_opts[i] = rd->rd_options;
+
+    rd->rd_db = rocksdb_open_column_families(rd->rd_options, path,
+                                             (int)rd->rd_num_cf,
+                                             (const char **)rd->rd_cf_names,
+                                             cf_opts, rd->rd_cf_handles, &err);
+    free(cf_opts);
+
+    if (err || !rd->rd_db)
+    {
+        SIMPLE_LOG_MSG(LL_ERROR, "rocksdb_open_column_families(`%s'): %s",
+                       path, err);
+        rd->rd_db = NULL;
+        return -ENOTCONN;
+    }
+
+    return 0;
+}
+
+static bool
+rrkm_key_has_prefix(const char *key, size_t key_len, const char *prefix,
+                    size_t prefix_len)
+{
+    return (key_len >= prefix_len && !memcmp(key, prefix, prefix_len)) ?
+        true : false;
+}
+
+/**
+ * rrkm_log_header_version_get - reads every log header copy (the "a0_hdr."
+ *    key and its "z0_last." mirror) and returns the version they share.
+ */
+static int
+rrkm_log_header_version_get(struct rrkm_db *rd, uint64_t *ret_version)
+{
+    rocksdb_iterator_t *iter =
+        rocksdb_create_iterator(rd->rd_db, rd->rd_readoptions);
+    if (!iter)
+        return -ENOMEM;
+
+    const char *prefixes[2] =
+        {RAFT_LOG_HEADER_ROCKSDB, RAFT_LOG_LASTENTRY_ROCKSDB};
+    const size_t prefix_lens[2] =
+        {RAFT_LOG_HEADER_ROCKSDB_STRLEN, RAFT_LOG_LASTENTRY_ROCKSDB_STRLEN};
+
+    size_t nfound = 0;
+    int rc = 0;
+
+    for (int i = 0; i < 2 && !rc; i++)
+    {
+        for (rocksdb_iter_seek(iter, prefixes[i], prefix_lens[i]);
+             rocksdb_iter_valid(iter); rocksdb_iter_next(iter))
+        {
+            size_t key_len = 0, val_len = 0;
+            const char *key = rocksdb_iter_key(iter, &key_len);
+            const char *val = rocksdb_iter_value(iter, &val_len);
+
+            if (!rrkm_key_has_prefix(key, key_len, prefixes[i],
+                                     prefix_lens[i]))
+                break;
+
+            struct raft_log_header rlh;
+            if (val_len != sizeof(rlh))
+                continue;
+
+            memcpy(&rlh, val, sizeof(rlh));
+            if (rlh.rlh_magic != RAFT_HEADER_MAGIC)
+                continue;
+
+            if (nfound++ && rlh.rlh_version != *ret_version)
+            {
+                SIMPLE_LOG_MSG(LL_ERROR, "key=%.*s has version=%lu (!=%lu)",
+                               (int)key_len, key, rlh.rlh_version,
+                               *ret_version);
+                rc = -EBADMSG;
+                break;
+            }
+
+            *ret_version = rlh.rlh_version;
+        }
+    }
+
+    rocksdb_iter_destroy(iter);
+
+    return rc ? rc : (nfound ? 0 : -ENOENT);
+}
+
+static int
+rrkm_log_header_version_set(struct rrkm_db *rd, uint64_t version)
+{
+    rocksdb_iterator_t *iter =
+        rocksdb_create_iterator(rd->rd_db, rd->rd_readoptions);
+    if (!iter)
+        return -ENOMEM;
+
+    rocksdb_writebatch_t *wb = rocksdb_writebatch_create();
+    NIOVA_ASSERT(wb);
+
+    const char *prefixes[2] =
+        {RAFT_LOG_HEADER_ROCKSDB, RAFT_LOG_LASTENTRY_ROCKSDB};
+    const size_t prefix_lens[2] =
+        {RAFT_LOG_HEADER_ROCKSDB_STRLEN, RAFT_LOG_LASTENTRY_ROCKSDB_STRLEN};
+
+    for (int i = 0; i < 2; i++)
+    {
+        for (rocksdb_iter_seek(iter, prefixes[i], prefix_lens[i]);
+             rocksdb_iter_valid(iter); rocksdb_iter_next(iter))
+        {
+            size_t key_len = 0, val_len = 0;
+            const char *key = rocksdb_iter_key(iter, &key_len);
+            const char *val = rocksdb_iter_value(iter, &val_len);
+
+            if (!rrkm_key_has_prefix(key, key_len, prefixes[i],
+                                     prefix_lens[i]))
+                break;
+
+            struct raft_log_header rlh;
+            if (val_len != sizeof(rlh))
+                continue;
+
+            memcpy(&rlh, val, sizeof(rlh));
+            if (rlh.rlh_magic != RAFT_HEADER_MAGIC)
+                continue;
+
+            rlh.rlh_version = version;
+            rocksdb_writebatch_put(wb, key, key_len, (const char *)&rlh,
+                                   sizeof(rlh));
+        }
+    }
+
+    rocksdb_iter_destroy(iter);
+
+    char *err = NULL;
+    rocksdb_write(rd->rd_db, rd->rd_writeoptions, wb, &err);
+    rocksdb_writebatch_destroy(wb);
+
+    if (err)
+    {
+        SIMPLE_LOG_MSG(LL_ERROR, "rocksdb_write(): %s", err);
+        return -EIO;
+    }
+
+    return 0;
+}
+
+static int
+rrkm_batch_flush(struct rrkm_db *rd, rocksdb_writebatch_t *wb)
+{
+    if (!rocksdb_writebatch_count(wb))
+        return 0;
+
+    char *err = NULL;
+    rocksdb_write(rd->rd_db, rd->rd_writeoptions, wb, &err);
+    rocksdb_writebatch_clear(wb);
+
+    if (err)
+    {
+        SIMPLE_LOG_MSG(LL_ERROR, "rocksdb_write(): %s", err);
+        return -EIO;
+    }
+
+    return 0;
+}
+
+/**
+ * rrkm_entry_keys_convert - rewrites each ASCII entry and entry header key
+ *    under its binary key.  Each batch removes the old keys in the same
+ *    atomic write which installs the new ones.
+ */
+static int
+rrkm_entry_keys_convert(struct rrkm_db *rd, size_t *ret_nkeys)
+{
+    rocksdb_iterator_t *iter =
+        rocksdb_create_iterator(rd->rd_db, rd->rd_readoptions);
+    if (!iter)
+        return -ENOMEM;
+
+    rocksdb_writebatch_t *wb = rocksdb_writebatch_create();
+    NIOVA_ASSERT(wb);
+
+    int rc = 0;
+    size_t nkeys = 0;
+
+    for (rocksdb_iter_seek(iter, RAFT_ENTRY_KEY_PREFIX_ROCKSDB,
+                           RAFT_ENTRY_KEY_PREFIX_ROCKSDB_STRLEN);
+         rocksdb_iter_valid(iter); rocksdb_iter_next(iter))
+    {
+        size_t key_len = 0, val_len = 0;
+        const char *key = rocksdb_iter_key(iter, &key_len);
+
+        if (!rrkm_key_has_prefix(key, key_len, RAFT_ENTRY_KEY_PREFIX_ROCKSDB,
+                                 RAFT_ENTRY_KEY_PREFIX_ROCKSDB_STRLEN))
+            break;
+
+        raft_entry_idx_t idx = -1;
+        bool header = false;
+
+        rc = raft_rocksdb_entry_key_parse(key, key_len, false, &idx, &header);
+        if (rc)
+        {
+            SIMPLE_LOG_MSG(LL_ERROR, "unexpected key=%.*s: %s",
+                           (int)key_len, key, strerror(-rc));
+            break;
+        }
+
+        char new_key[RAFT_ENTRY_KEY_BIN_LEN];
+        const size_t new_key_len =
+            raft_rocksdb_entry_key_build(new_key, sizeof(new_key), idx,
+                                         header, true);
+        NIOVA_ASSERT(new_key_len == RAFT_ENTRY_KEY_BIN_LEN);
+
+        const char *val = rocksdb_iter_value(iter, &val_len);
+
+        rocksdb_writebatch_put(wb, new_key, new_key_len, val, val_len);
+        rocksdb_writebatch_delete(wb, key, key_len);
+
+        nkeys++;
+
+        if (!(nkeys % rrkmBatchSize) && (rc = rrkm_batch_flush(rd, wb)))
+            break;
+    }
+
+    if (!rc)
+    {
+        char *err = NULL;
+        rocksdb_iter_get_error(iter, &err);
+        if (err)
+        {
+            SIMPLE_LOG_MSG(LL_ERROR, "rocksdb_iter_get_error(): %s", err);
+            rc = -EIO;
+        }
+    }
+
+    if (!rc)
+        rc = rrkm_batch_flush(rd, wb);
+
+    rocksdb_writebatch_destroy(wb);
+    rocksdb_iter_destroy(iter);
+
+    *ret_nkeys = nkeys;
+
+    return rc;
+}
+
+static size_t
+rrkm_entry_keys_count(struct rrkm_db *rd)
+{
+    rocksdb_iterator_t *iter =
+        rocksdb_create_iterator(rd->rd_db, rd->rd_readoptions);
+    if (!iter)
+        return 0;
+
+    size_t nkeys = 0;
+
+    for (rocksdb_iter_seek(iter, RAFT_ENTRY_KEY_PREFIX_ROCKSDB,
+                           RAFT_ENTRY_KEY_PREFIX_ROCKSDB_STRLEN);
+         rocksdb_iter_valid(iter); rocksdb_iter_next(iter), nkeys++)
+    {
+        size_t key_len = 0;
+        const char *key = rocksdb_iter_key(iter, &key_len);
+
+        if (!rrkm_key_has_prefix(key, key_len, RAFT_ENTRY_KEY_PREFIX_ROCKSDB,
+                                 RAFT_ENTRY_KEY_PREFIX_ROCKSDB_STRLEN))
+            break;
+    }
+
+    rocksdb_iter_destroy(iter);
+
+    return nkeys;
+}
+
+static void
+rrkm_print_help(const int error, char **argv)
+{
+    fprintf(error ? stderr : stdout,
+            "Usage: %s -p <raft-db-path> [-b batch-size] [-n (dry-run)] [-h]\n",
+            argv[0]);
+
+    exit(error);
+}
+
+static void
+rrkm_getopt(int argc, char **argv)
+{
+    int opt;
+
+    while ((opt = getopt(argc, argv, OPTS)) != -1)
+    {
+        switch (opt)
+        {
+        case 'b':
+            rrkmBatchSize = atoll(optarg);
+            if (!rrkmBatchSize)
+                rrkmBatchSize = RRKM_DEFAULT_BATCH;
+            break;
+        case 'h':
+            rrkm_print_help(0, argv);
+            break;
+        case 'n':
+            rrkmDryRun = true;
+            break;
+        case 'p':
+            rrkmDbPath = optarg;
+            break;
+        default:
+            rrkm_print_help(EINVAL, argv);
+            break;
+        }
+    }
+
+    if (!rrkmDbPath)
+        rrkm_print_help(EINVAL, argv);
+}
+
+int
+main(int argc, char **argv)
+{
+    rrkm_getopt(argc, argv);
+
+    struct rrkm_db rd = {0};
+
+    int rc = rrkm_db_open(&rd, rrkmDbPath);
+    if (rc)
+    {
+        rrkm_db_close(&rd);
+        exit(-rc);
+    }
+
+    uint64_t version = 0;
+    rc = rrkm_log_header_version_get(&rd, &version);
+    if (rc)
+    {
+        SIMPLE_LOG_MSG(LL_ERROR, "rrkm_log_header_version_get(): %s",
+                       strerror(-rc));
+        rrkm_db_close(&rd);
+        exit(-rc);
+    }
+
+    fprintf(stdout, "%s: log-version=%lu\n", rrkmDbPath, version);
+
+    if (version == RAFT_ROCKSDB_LOG_VERSION_BINARY_KEYS ||
+        version == RAFT_ROCKSDB_LOG_VERSION_SINGLE_KV)
+    {
+        fprintf(stdout, "db already uses binary entry keys\n");
+        rrkm_db_close(&rd);
+        exit(0);
+    }
+    else if (version != RAFT_ROCKSDB_LOG_VERSION_ASCII_KEYS)
+    {
+        SIMPLE_LOG_MSG(LL_ERROR, "unsupported log-version=%lu", version);
+        rrkm_db_close(&rd);
+        exit(EBADMSG);
+    }
+
+    size_t nkeys = 0;
+
+    if (rrkmDryRun)
+    {
+        nkeys = rrkm_entry_keys_count(&rd);
+        fprintf(stdout, "dry-run: %zu entry keys would be converted\n",
+                nkeys);
+        rrkm_db_close(&rd);
+        exit(0);
+    }
+
+    rc = rrkm_entry_keys_convert(&rd, &nkeys);
+    if (!rc)
+        rc = rrkm_log_header_version_set(&rd,
+                                         RAFT_ROCKSDB_LOG_VERSION_BINARY_KEYS);
+
+    if (!rc)
+    {
+        // Drop the tombstones left behind by the old keys
+        const char end = RAFT_ENTRY_KEY_PREFIX_ROCKSDB[0] + 1;
+        rocksdb_compact_range(rd.rd_db, RAFT_ENTRY_KEY_PREFIX_ROCKSDB,
+                              RAFT_ENTRY_KEY_PREFIX_ROCKSDB_STRLEN, &end, 1);
+    }
+
+    fprintf(stdout, "converted %zu entry keys: %s\n", nkeys,
+            rc ? strerror(-rc) : "OK");
+
+    rrkm_db_close(&rd);
+
+    return rc ? -rc : 0;
+}
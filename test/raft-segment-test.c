@@ -0,0 +1,272 @@
+/* Copyright (C) NIOVA Systems, Inc - All Rights Reserved
+ * Unauthorized copying of this file, via any medium is strictly prohibited
+ * Proprietary and confidential
+ * Written by Paul Nowoczynski <00pauln00@gmail.com> 2020
+ */
+#include <ftw.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "niova/niova_backtrace.h"
+
+#include "niova/common.h"
+#include "niova/log.h"
+
+#include "raft.h"
+
+#define SEGMENT_TEST_DATA_SIZE (1024 * 1024)
+#define SEGMENT_TEST_NENTRIES  40
+
+static char segmentTestDir[] = "/tmp/raft-segment-test.XXXXXX";
+
+static struct raft_entry *segmentTestEntry;
+
+struct segment_test_scan
+{
+    raft_entry_idx_t sts_next;
+};
+
+static void
+segment_test_entry_fill(struct raft_instance *ri, const raft_entry_idx_t idx,
+                        const bool bad_crc)
+{
+    struct raft_entry *re = segmentTestEntry;
+    struct raft_entry_header *reh = &re->re_header;
+
+    memset(reh, 0, sizeof(*reh));
+    reh->reh_magic = RAFT_ENTRY_MAGIC;
+    reh->reh_version = RAFT_ENTRY_HEADER_V1;
+    reh->reh_index = idx;
+    reh->reh_term = 1;
+    reh->reh_data_size = SEGMENT_TEST_DATA_SIZE;
+    reh->reh_num_entries = 1;
+    reh->reh_entry_sz[0] = SEGMENT_TEST_DATA_SIZE;
+    uuid_copy(reh->reh_self_uuid, RAFT_INSTANCE_2_SELF_UUID(ri));
+    uuid_copy(reh->reh_raft_uuid, RAFT_INSTANCE_2_RAFT_UUID(ri));
+
+    memset(re->re_data, (int)(idx & 0xff), SEGMENT_TEST_DATA_SIZE);
+
+    // Same coverage as raft_server_entry_calc_crc()
+    const size_t off = offsetof(struct raft_entry_header, reh_data_size);
+
+    reh->reh_crc = niova_crc((const unsigned char *)re + off,
+                             sizeof(struct raft_entry) +
+                             SEGMENT_TEST_DATA_SIZE - off, 0);
+    if (bad_crc)
+        reh->reh_crc++;
+}
+
+static void
+segment_test_write(struct raft_instance *ri, const raft_entry_idx_t start,
+                   const raft_entry_idx_t end)
+{
+    for (raft_entry_idx_t i = start; i < end; i++)
+    {
+        segment_test_entry_fill(ri, i, false);
+
+        struct iovec iov = {
+            .iov_base = segmentTestEntry->re_data,
+            .iov_len = SEGMENT_TEST_DATA_SIZE,
+        };
+
+        ri->ri_backend->rib_entry_write(ri, &segmentTestEntry->re_header,
+                                        &iov, 1, NULL);
+    }
+
+    NIOVA_ASSERT(!ri->ri_backend->rib_backend_sync(ri));
+}
+
+static int
+segment_test_scan_cb(void *arg, const struct raft_entry_header *reh,
+                     const char *data)
+{
+    struct segment_test_scan *sts = arg;
+
+    NIOVA_ASSERT(reh->reh_index == sts->sts_next);
+    NIOVA_ASSERT(reh->reh_data_size == SEGMENT_TEST_DATA_SIZE);
+    NIOVA_ASSERT(data && data[0] == (char)(reh->reh_index & 0xff) &&
+                 data[SEGMENT_TEST_DATA_SIZE - 1] == data[0]);
+
+    sts->sts_next++;
+
+    return 0;
+}
+
+static void
+segment_test_verify(struct raft_instance *ri, const raft_entry_idx_t lowest,
+                    const raft_entry_idx_t end)
+{
+    struct segment_test_scan sts = {.sts_next = lowest};
+
+    NIOVA_ASSERT(!ri->ri_backend->rib_entry_scan(ri, lowest, end, true,
+                                                 segment_test_scan_cb,
+                                                 &sts));
+    NIOVA_ASSERT(sts.sts_next == end);
+
+    struct raft_entry_header reh = {.reh_index = end - 1};
+    NIOVA_ASSERT(!ri->ri_backend->rib_entry_header_read(ri, &reh));
+    NIOVA_ASSERT(reh.reh_index == end - 1);
+
+    segmentTestEntry->re_header.reh_index = end - 1;
+    segmentTestEntry->re_header.reh_data_size = SEGMENT_TEST_DATA_SIZE;
+
+    NIOVA_ASSERT(ri->ri_backend->rib_entry_read(ri, segmentTestEntry) ==
+                 (ssize_t)(sizeof(struct raft_entry) +
+                           SEGMENT_TEST_DATA_SIZE));
+    NIOVA_ASSERT(!raft_server_entry_check_crc(segmentTestEntry));
+}
+
+static void
+segment_test_restart(struct raft_instance *ri, const raft_entry_idx_t lowest,
+                     const raft_entry_idx_t end)
+{
+    NIOVA_ASSERT(!ri->ri_backend->rib_backend_shutdown(ri));
+
+    raft_server_backend_use_segment(ri);
+    NIOVA_ASSERT(!ri->ri_backend->rib_backend_setup(ri));
+
+    NIOVA_ASSERT(ri->ri_entries_detected_at_startup == end);
+    NIOVA_ASSERT(lowest < 0 ||
+                 niova_atomic_read(&ri->ri_lowest_idx) == lowest);
+
+    segment_test_verify(ri, niova_atomic_read(&ri->ri_lowest_idx), end);
+}
+
+static void
+segment_test_chkpt(struct raft_instance *ri, const raft_entry_idx_t idx)
+{
+    ri->ri_last_applied.rla_synced_idx = idx;
+
+    NIOVA_ASSERT(ri->ri_backend->rib_backend_checkpoint(ri) == idx);
+    niova_atomic_init(&ri->ri_checkpoint_last_idx, idx);
+
+    NIOVA_ASSERT(ri->ri_backend->rib_backend_checkpoint(ri) == -EALREADY);
+
+    static char buf[4096];
+    struct raft_chkpt_xfer_request_msg rcxrq = {.rcxrqm_chkpt_idx = idx};
+    struct raft_chkpt_xfer_reply_msg rcxrp = {0};
+
+    NIOVA_ASSERT(!ri->ri_backend->rib_chkpt_xfer_read(ri, &rcxrq, &rcxrp,
+                                                      buf, sizeof(buf)));
+
+    const struct raft_chkpt_xfer_file *files =
+        (const struct raft_chkpt_xfer_file *)buf;
+    const size_t nfiles = rcxrp.rcxrpm_len / sizeof(*files);
+    bool index_found = false;
+    size_t nsegments = 0;
+
+    for (size_t i = 0; i < nfiles; i++)
+    {
+        if (!strcmp(files[i].rcxf_name, "index"))
+            index_found = true;
+
+        else if (!strncmp(files[i].rcxf_name, "segment.", 8))
+            nsegments++;
+    }
+
+    NIOVA_ASSERT(index_found && nsegments > 1);
+
+    // Names leading outside of the checkpoint are refused
+    strncpy(rcxrq.rcxrqm_name, "../index", RAFT_CHKPT_XFER_NAME_MAX);
+    NIOVA_ASSERT(ri->ri_backend->rib_chkpt_xfer_read(ri, &rcxrq, &rcxrp,
+                                                     buf, sizeof(buf)) ==
+                 -EINVAL);
+}
+
+static int
+segment_test_rm_cb(const char *path, const struct stat *stb, int flag,
+                   struct FTW *ftw)
+{
+    (void)stb;
+    (void)flag;
+    (void)ftw;
+
+    return remove(path);
+}
+
+int
+main(void)
+{
+    NIOVA_ASSERT(mkdtemp(segmentTestDir));
+
+    segmentTestEntry =
+        niova_malloc(sizeof(struct raft_entry) + SEGMENT_TEST_DATA_SIZE);
+    NIOVA_ASSERT(segmentTestEntry);
+
+    struct ctl_svc_node csn_self = {0};
+    struct ctl_svc_node csn_raft = {0};
+
+    uuid_generate(csn_self.csn_uuid);
+    uuid_generate(csn_raft.csn_uuid);
+
+    struct raft_instance *ri = raft_net_get_instance();
+
+    ri->ri_csn_this_peer = &csn_self;
+    ri->ri_csn_raft = &csn_raft;
+    snprintf(ri->ri_log, sizeof(ri->ri_log), "%s/log", segmentTestDir);
+
+    raft_server_backend_use_segment(ri);
+    NIOVA_ASSERT(!ri->ri_backend->rib_backend_setup(ri));
+    NIOVA_ASSERT(!ri->ri_entries_detected_at_startup);
+
+    // Write enough entries to fill several segments
+    segment_test_write(ri, 0, SEGMENT_TEST_NENTRIES);
+    segment_test_verify(ri, 0, SEGMENT_TEST_NENTRIES);
+    segment_test_restart(ri, 0, SEGMENT_TEST_NENTRIES);
+
+    // The checkpoint keeps the reaped entries
+    segment_test_chkpt(ri, SEGMENT_TEST_NENTRIES / 2);
+
+    // Reaping leaves the segment which holds the reap idx
+    const raft_entry_idx_t reap_idx = SEGMENT_TEST_NENTRIES / 2;
+
+    ri->ri_backend->rib_log_reap(ri, reap_idx);
+
+    struct raft_entry_header reh = {.reh_index = 0};
+    NIOVA_ASSERT(ri->ri_backend->rib_entry_header_read(ri, &reh) ==
+                 -ENOENT);
+
+    segment_test_restart(ri, -1, SEGMENT_TEST_NENTRIES);
+
+    const raft_entry_idx_t lowest = niova_atomic_read(&ri->ri_lowest_idx);
+    NIOVA_ASSERT(lowest > 0 && lowest <= reap_idx);
+
+    // Truncate then rewrite the tail, which starts a new segment
+    const raft_entry_idx_t trunc_idx = SEGMENT_TEST_NENTRIES - 10;
+
+    ri->ri_backend->rib_log_truncate(ri, trunc_idx);
+
+    reh.reh_index = trunc_idx;
+    NIOVA_ASSERT(ri->ri_backend->rib_entry_header_read(ri, &reh) ==
+                 -ENOENT);
+
+    segment_test_write(ri, trunc_idx, SEGMENT_TEST_NENTRIES + 5);
+    segment_test_restart(ri, lowest, SEGMENT_TEST_NENTRIES + 5);
+
+    // A torn entry at the end of the log is dropped at startup
+    segment_test_entry_fill(ri, SEGMENT_TEST_NENTRIES + 5, true);
+
+    struct iovec iov = {
+        .iov_base = segmentTestEntry->re_data,
+        .iov_len = SEGMENT_TEST_DATA_SIZE,
+    };
+
+    ri->ri_backend->rib_entry_write(ri, &segmentTestEntry->re_header, &iov, 1,
+                                    NULL);
+    NIOVA_ASSERT(!ri->ri_backend->rib_backend_sync(ri));
+
+    segment_test_restart(ri, lowest, SEGMENT_TEST_NENTRIES + 5);
+
+    // The log is appended to where the torn entry was
+    segment_test_write(ri, SEGMENT_TEST_NENTRIES + 5,
+                       SEGMENT_TEST_NENTRIES + 6);
+    segment_test_restart(ri, lowest, SEGMENT_TEST_NENTRIES + 6);
+
+    NIOVA_ASSERT(!ri->ri_backend->rib_backend_shutdown(ri));
+
+    niova_free(segmentTestEntry);
+
+    return nftw(segmentTestDir, segment_test_rm_cb, 16, FTW_DEPTH | FTW_PHYS);
+}
@@ -0,0 +1,241 @@
+/* Copyright (C) NIOVA Systems, Inc - All Rights Reserved
+ * Unauthorized copying of this file, via any medium is strictly prohibited
+ * Proprietary and confidential
+ * Written by Paul Nowoczynski <00pauln00@gmail.com> 2020
+ */
+
+/* Compares the ASCII and binary raft entry key formats:  the cost of building
+ * and parsing a key and the on-disk SST size of a log written with each.
+ */
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <uuid/uuid.h>
+
+#include <rocksdb/c.h>
+
+#include "common.h"
+#include "log.h"
+#include "raft.h"
+#include "raft_server_backend_rocksdb.h"
+
+#define OPTS "d:hi:p:"
+
+static size_t benchIterations = 1000000;
+static size_t benchEntries = 100000;
+static size_t benchDataSize = 64;
+static const char *benchDbPathRoot = "./rocksdb__key_bench";
+
+static unsigned long long
+rkb_elapsed_nsec(const struct timespec *start)
+{
+    struct timespec ts;
+    niova_unstable_clock(&ts);
+    timespecsub(&ts, start, &ts);
+
+    return timespec_2_nsec(&ts);
+}
+
+static void
+rkb_key_build_and_parse(const bool binary)
+{
+    char key[RAFT_ROCKSDB_KEY_LEN_MAX];
+    size_t key_len = 0;
+    raft_entry_idx_t idx_sum = 0;
+    struct timespec ts;
+
+    niova_unstable_clock(&ts);
+
+    for (size_t i = 0; i < benchIterations; i++)
+        key_len += raft_rocksdb_entry_key_build(key, RAFT_ROCKSDB_KEY_LEN_MAX,
+                                                i, (i & 1), binary);
+
+    unsigned long long nsecs = rkb_elapsed_nsec(&ts);
+
+    fprintf(stdout, "%13.3f\t\t%s key build (len=%zu)\n",
+            (float)nsecs / (float)benchIterations,
+            binary ? "binary" : "ascii", key_len / benchIterations);
+
+    key_len = raft_rocksdb_entry_key_build(key, RAFT_ROCKSDB_KEY_LEN_MAX,
+                                           benchIterations, false, binary);
+    niova_unstable_clock(&ts);
+
+    for (size_t i = 0; i < benchIterations; i++)
+    {
+        raft_entry_idx_t idx;
+        int rc = raft_rocksdb_entry_key_parse(key, key_len, binary, &idx,
+                                              NULL);
+        NIOVA_ASSERT(!rc);
+        idx_sum += idx;
+    }
+
+    nsecs = rkb_elapsed_nsec(&ts);
+
+    NIOVA_ASSERT(idx_sum == (raft_entry_idx_t)(benchIterations *
+                                               benchIterations));
+
+    fprintf(stdout, "%13.3f\t\t%s key parse\n",
+            (float)nsecs / (float)benchIterations,
+            binary ? "binary" : "ascii");
+}
+
+/**
+ * rkb_sst_size - writes 'benchEntries' entry/header pairs into a new db and
+ *    reports the SST footprint after flushing and compacting.
+ */
+static int
+rkb_sst_size(const bool binary)
+{
+    char path[PATH_MAX];
+    char uuid_str[UUID_STR_LEN];
+    uuid_t uuid;
+
+    uuid_generate(uuid);
+    uuid_unparse(uuid, uuid_str);
+    snprintf(path, PATH_MAX, "%s-%s-%s", benchDbPathRoot,
+             binary ? "bin" : "ascii", uuid_str);
+
+    rocksdb_options_t *opts = rocksdb_options_create();
+    rocksdb_writeoptions_t *wopts = rocksdb_writeoptions_create();
+    rocksdb_flushoptions_t *fopts = rocksdb_flushoptions_create();
+    NIOVA_ASSERT(opts && wopts && fopts);
+
+    rocksdb_options_set_create_if_missing(opts, 1);
+    rocksdb_writeoptions_disable_WAL(wopts, 1);
+    rocksdb_flushoptions_set_wait(fopts, 1);
+
+    char *err = NULL;
+    rocksdb_t *db = rocksdb_open(opts, path, &err);
+    if (!db)
+    {
+        SIMPLE_LOG_MSG(LL_ERROR, "rocksdb_open(`%s'): %s", path, err);
+        return -ENOTCONN;
+    }
+
+    char *data = calloc(1, benchDataSize);
+    NIOVA_ASSERT(data);
+
+    struct raft_entry_header reh = {0};
+    rocksdb_writebatch_t *wb = rocksdb_writebatch_create();
+    struct timespec ts;
+
+    niova_unstable_clock(&ts);
+
+    for (size_t i = 0; i < benchEntries && !err; i++)
+    {
+        char key[RAFT_ROCKSDB_KEY_LEN_MAX];
+        size_t key_len;
+
+        reh.reh_index = i;
+        memcpy(data, &i,
+               sizeof(i) < benchDataSize ? sizeof(i) : benchDataSize);
+
+        key_len = raft_rocksdb_entry_key_build(key, RAFT_ROCKSDB_KEY_LEN_MAX,
+                                               i, true, binary);
+        rocksdb_writebatch_put(wb, key, key_len, (const char *)&reh,
+                               sizeof(reh));
+
+        key_len = raft_rocksdb_entry_key_build(key, RAFT_ROCKSDB_KEY_LEN_MAX,
+                                               i, false, binary);
+        rocksdb_writebatch_put(wb, key, key_len, data, benchDataSize);
+
+        rocksdb_write(db, wopts, wb, &err);
+        rocksdb_writebatch_clear(wb);
+    }
+
+    unsigned long long nsecs = rkb_elapsed_nsec(&ts);
+
+    if (!err)
+        rocksdb_flush(db, fopts, &err);
+
+    if (!err)
+        rocksdb_compact_range(db, NULL, 0, NULL, 0);
+
+    char *sst_size =
+        err ? NULL : rocksdb_property_value(db, "rocksdb.total-sst-files-size");
+
+    fprintf(stdout, "%13.3f\t\t%s entry write (sst-bytes=%s entries=%zu)\n",
+            (float)nsecs / (float)benchEntries,
+            binary ? "binary" : "ascii", sst_size ? sst_size : "?",
+            benchEntries);
+
+    const int rc = err ? -EIO : 0;
+    if (err)
+        SIMPLE_LOG_MSG(LL_ERROR, "rocksdb error: %s", err);
+
+    err = NULL;
+
+    free(sst_size);
+    free(data);
+    rocksdb_writebatch_destroy(wb);
+    rocksdb_close(db);
+
+    rocksdb_destroy_db(opts, path, &err);
+
+    rocksdb_flushoptions_destroy(fopts);
+    rocksdb_writeoptions_destroy(wopts);
+    rocksdb_options_destroy(opts);
+
+    return rc;
+}
+
+static void
+rkb_print_help(const int error, char **argv)
+{
+    fprintf(error ? stderr : stdout,
+            "Usage: %s [-i key-iterations] [-d entries] [-p path] [-h]\n",
+            argv[0]);
+
+    exit(error);
+}
+
+static void
+rkb_getopt(int argc, char **argv)
+{
+    int opt;
+
+    while ((opt = getopt(argc, argv, OPTS)) != -1)
+    {
+        switch (opt)
+        {
+        case 'd':
+            benchEntries = atoll(optarg);
+            break;
+        case 'h':
+            rkb_print_help(0, argv);
+            break;
+        case 'i':
+            benchIterations = atoll(optarg);
+            break;
+        case 'p':
+            benchDbPathRoot = optarg;
+            break;
+        default:
+            rkb_print_help(EINVAL, argv);
+            break;
+        }
+    }
+
+    if (!benchIterations || !benchEntries)
+        rkb_print_help(EINVAL, argv);
+}
+
+int
+main(int argc, char **argv)
+{
+    rkb_getopt(argc, argv);
+
+    fprintf(stdout, "    NS/OP\t\tTest Name\n"
+                    "--------------------------------------------------\n");
+
+    rkb_key_build_and_parse(false);
+    rkb_key_build_and_parse(true);
+
+    int rc = rkb_sst_size(false);
+    if (!rc)
+        rc = rkb_sst_size(true);
+
+    return rc ? -rc : 0;
+}
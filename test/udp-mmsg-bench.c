@@ -0,0 +1,269 @@
+/* Copyright (C) NIOVA Systems, Inc - All Rights Reserved
+ * Unauthorized copying of this file, via any medium is strictly prohibited
+ * Proprietary and confidential
+ * Written by Paul Nowoczynski <00pauln00@gmail.com> 2020
+ */
+
+/* Compares one syscall per datagram against recvmmsg() / sendmmsg() for a
+ * heartbeat round over loopback:  the leader sends one msg to each follower
+ * and then receives one reply from each.  Syscalls and time per round are
+ * reported for 3, 5, and 7 member clusters.
+ */
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "niova/common.h"
+#include "niova/log.h"
+
+#include "raft.h"
+
+#define OPTS "hi:"
+
+#define UMB_MAX_PEERS 7
+
+static size_t benchIterations = 100000;
+static const int benchNumPeers[] = {3, 5, 7};
+
+struct umb_cluster
+{
+    int                umbc_npeers;
+    int                umbc_fd[UMB_MAX_PEERS]; // [0] is the leader
+    struct sockaddr_in umbc_addr[UMB_MAX_PEERS];
+};
+
+static char umbMsg[UMB_MAX_PEERS][sizeof(struct raft_rpc_msg)];
+static char umbSink[UMB_MAX_PEERS][sizeof(struct raft_rpc_msg)];
+
+static unsigned long long
+umb_elapsed_nsec(const struct timespec *start)
+{
+    struct timespec ts;
+    niova_unstable_clock(&ts);
+    timespecsub(&ts, start, &ts);
+
+    return timespec_2_nsec(&ts);
+}
+
+static void
+umb_cluster_init(struct umb_cluster *umbc, const int npeers)
+{
+    NIOVA_ASSERT(npeers <= UMB_MAX_PEERS);
+
+    umbc->umbc_npeers = npeers;
+
+    for (int i = 0; i < npeers; i++)
+    {
+        struct sockaddr_in *sin = &umbc->umbc_addr[i];
+        socklen_t len = sizeof(*sin);
+
+        memset(sin, 0, sizeof(*sin));
+        sin->sin_family = AF_INET;
+        sin->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+        umbc->umbc_fd[i] = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK, 0);
+        FATAL_IF((umbc->umbc_fd[i] < 0), "socket(): %s", strerror(errno));
+
+        FATAL_IF((bind(umbc->umbc_fd[i], (struct sockaddr *)sin, len)),
+                 "bind(): %s", strerror(errno));
+
+        FATAL_IF((getsockname(umbc->umbc_fd[i], (struct sockaddr *)sin,
+                              &len)),
+                 "getsockname(): %s", strerror(errno));
+    }
+}
+
+static void
+umb_cluster_destroy(struct umb_cluster *umbc)
+{
+    for (int i = 0; i < umbc->umbc_npeers; i++)
+        close(umbc->umbc_fd[i]);
+}
+
+static void
+umb_mmsg_init(struct mmsghdr *msgs, struct iovec *iovs,
+              struct sockaddr_in *addrs,
+              char (*bufs)[sizeof(struct raft_rpc_msg)], const int nmsgs)
+{
+    memset(msgs, 0, sizeof(struct mmsghdr) * nmsgs);
+
+    for (int i = 0; i < nmsgs; i++)
+    {
+        iovs[i].iov_base = bufs[i];
+        iovs[i].iov_len = sizeof(struct raft_rpc_msg);
+
+        msgs[i].msg_hdr.msg_name = &addrs[i];
+        msgs[i].msg_hdr.msg_namelen = sizeof(struct sockaddr_in);
+        msgs[i].msg_hdr.msg_iov = &iovs[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+    }
+}
+
+/**
+ * umb_round - the leader sends a heartbeat to each follower, each follower
+ *    replies, and the leader drains the replies.  Only the leader's syscalls
+ *    are counted.
+ */
+static size_t
+umb_round(struct umb_cluster *umbc, const bool mmsg)
+{
+    const int nfollowers = umbc->umbc_npeers - 1;
+    struct sockaddr_in *followers = &umbc->umbc_addr[1];
+    size_t nsyscalls = 0;
+
+    struct mmsghdr msgs[UMB_MAX_PEERS];
+    struct iovec iovs[UMB_MAX_PEERS];
+    struct sockaddr_in from[UMB_MAX_PEERS];
+
+    if (mmsg)
+    {
+        umb_mmsg_init(msgs, iovs, followers, umbMsg, nfollowers);
+
+        for (int n = 0; n < nfollowers; nsyscalls++)
+        {
+            int rc = sendmmsg(umbc->umbc_fd[0], &msgs[n], nfollowers - n, 0);
+            FATAL_IF((rc < 0), "sendmmsg(): %s", strerror(errno));
+            n += rc;
+        }
+    }
+    else
+    {
+        for (int i = 0; i < nfollowers; i++, nsyscalls++)
+            FATAL_IF((sendto(umbc->umbc_fd[0], umbMsg[i],
+                             sizeof(struct raft_rpc_msg), 0,
+                             (struct sockaddr *)&followers[i],
+                             sizeof(struct sockaddr_in)) < 0),
+                     "sendto(): %s", strerror(errno));
+    }
+
+    // Followers reply
+    for (int i = 1; i <= nfollowers; i++)
+    {
+        char buf[sizeof(struct raft_rpc_msg)];
+
+        while (recv(umbc->umbc_fd[i], buf, sizeof(buf), 0) < 0)
+            NIOVA_ASSERT(errno == EAGAIN);
+
+        FATAL_IF((sendto(umbc->umbc_fd[i], buf, sizeof(buf), 0,
+                         (struct sockaddr *)&umbc->umbc_addr[0],
+                         sizeof(struct sockaddr_in)) < 0),
+                 "sendto(): %s", strerror(errno));
+    }
+
+    // Leader drains the replies until the socket would block
+    int nrecv = 0;
+
+    if (mmsg)
+    {
+        umb_mmsg_init(msgs, iovs, from, umbSink, UMB_MAX_PEERS);
+
+        for (int rc = 1; rc > 0; nsyscalls++)
+        {
+            rc = recvmmsg(umbc->umbc_fd[0], msgs, UMB_MAX_PEERS, MSG_DONTWAIT,
+                          NULL);
+            if (rc > 0)
+                nrecv += rc;
+
+            else if (nrecv < nfollowers) // loopback delivery is not instant
+                rc = 1;
+        }
+    }
+    else
+    {
+        for (ssize_t rc = 1; rc > 0; nsyscalls++)
+        {
+            rc = recv(umbc->umbc_fd[0], umbSink[0], sizeof(umbSink[0]),
+                      MSG_DONTWAIT);
+            if (rc > 0)
+                nrecv++;
+
+            else if (nrecv < nfollowers)
+                rc = 1;
+        }
+    }
+
+    NIOVA_ASSERT(nrecv == nfollowers);
+
+    return nsyscalls;
+}
+
+static void
+umb_run(const int npeers, const bool mmsg)
+{
+    struct umb_cluster umbc;
+    umb_cluster_init(&umbc, npeers);
+
+    size_t nsyscalls = 0;
+    struct timespec ts;
+
+    niova_unstable_clock(&ts);
+
+    for (size_t i = 0; i < benchIterations; i++)
+        nsyscalls += umb_round(&umbc, mmsg);
+
+    const unsigned long long nsecs = umb_elapsed_nsec(&ts);
+
+    fprintf(stdout, "%13.3f\t\t%s heartbeat round, peers=%d "
+            "(syscalls/round=%.2f)\n",
+            (float)nsecs / (float)benchIterations,
+            mmsg ? "mmsg" : "per-msg", npeers,
+            (float)nsyscalls / (float)benchIterations);
+
+    umb_cluster_destroy(&umbc);
+}
+
+static void
+umb_print_help(const int error, char **argv)
+{
+    fprintf(error ? stderr : stdout,
+            "Usage: %s [-i iterations] [-h]\n", argv[0]);
+
+    exit(error);
+}
+
+static void
+umb_getopt(int argc, char **argv)
+{
+    int opt;
+
+    while ((opt = getopt(argc, argv, OPTS)) != -1)
+    {
+        switch (opt)
+        {
+        case 'h':
+            umb_print_help(0, argv);
+            break;
+        case 'i':
+            benchIterations = atoll(optarg);
+            break;
+        default:
+            umb_print_help(EINVAL, argv);
+            break;
+        }
+    }
+
+    if (!benchIterations)
+        umb_print_help(EINVAL, argv);
+}
+
+int
+main(int argc, char **argv)
+{
+    umb_getopt(argc, argv);
+
+    COMPILE_TIME_ASSERT(UMB_MAX_PEERS <= RAFT_NET_UDP_MMSG_BATCH_MAX);
+
+    fprintf(stdout, "    NS/OP\t\tTest Name\n"
+                    "--------------------------------------------------\n");
+
+    for (size_t i = 0; i < ARRAY_SIZE(benchNumPeers); i++)
+    {
+        umb_run(benchNumPeers[i], false);
+        umb_run(benchNumPeers[i], true);
+    }
+
+    return 0;
+}